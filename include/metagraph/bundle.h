@@ -0,0 +1,889 @@
+/**
+ * @file bundle.h
+ * @brief Binary bundle format and memory-mapped bundle reader
+ *
+ * A bundle is laid out as {header}{section table}{index}{nodes}{edges}
+ * {store}{metadata}{lookup}{integrity}. Every section starts on a
+ * METAGRAPH_BUNDLE_SECTION_ALIGN boundary and all integers are
+ * little-endian. Opening a bundle maps the file and validates only the
+ * header and section table; each section is validated and turned into
+ * typed pointers the first time it is accessed, and per-node offsets into
+ * the store are resolved on every read. Nothing is deserialized.
+ *
+ * The INTEGRITY section holds a BLAKE3 Merkle tree per section, so any
+ * range of a section can be verified by hashing only the leaves that cover
+ * it (see integrity.h).
+ *
+ * The LOOKUP section holds minimal perfect hash tables over node IDs and
+ * normalized node names (see path.h), so either lookup is one hash, one
+ * slot load and one compare against the mapped data.
+ *
+ * The STORE section may be compressed in independently decodable blocks
+ * behind a seek table (METAGRAPH_SECTION_FLAG_COMPRESSED). Reading a node
+ * then decodes only the blocks its payload and name live in, into a copy
+ * owned by the bundle; every other section is always stored as is so it
+ * can be probed in place.
+ *
+ * A delta bundle (METAGRAPH_BUNDLE_FLAG_DELTA) patches a base bundle that
+ * stays mapped and untouched. Its DELTA section names the base by format
+ * UUID and integrity hash and carries the node records that changed; its
+ * STORE holds only new payloads and names, addressed past the end of the
+ * base's STORE; EDGES, INDEX and LOOKUP are either carried in full or
+ * inherited from the base unchanged.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_BUNDLE_H
+#define METAGRAPH_BUNDLE_H
+
+#include "metagraph/graph.h"
+#include "metagraph/integrity.h"
+#include "metagraph/mmap.h"
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// On-disk format
+// ============================================================================
+
+/**
+ * @brief Bundle magic bytes (no terminator on disk)
+ */
+#define METAGRAPH_BUNDLE_MAGIC "METAGRPH"
+
+/**
+ * @brief Alignment of every section's file offset
+ */
+#define METAGRAPH_BUNDLE_SECTION_ALIGN 4096U
+
+/**
+ * @brief Offset value meaning "no data" (e.g. an unnamed node)
+ */
+#define METAGRAPH_BUNDLE_NO_OFFSET UINT64_MAX
+
+/**
+ * @brief Section types
+ */
+typedef enum {
+    METAGRAPH_SECTION_NODES = 0x01,    ///< Fixed-size node records
+    METAGRAPH_SECTION_EDGES = 0x02,    ///< Hyperedges and adjacency
+    METAGRAPH_SECTION_STORE = 0x03,    ///< Asset payloads and names
+    METAGRAPH_SECTION_INDEX = 0x04,    ///< Asset ID -> node index table
+    METAGRAPH_SECTION_METADATA = 0x05, ///< Bundle description
+    METAGRAPH_SECTION_INTEGRITY = 0x06, ///< Per-section Merkle trees
+    METAGRAPH_SECTION_LOOKUP = 0x07,    ///< Perfect hash ID and path tables
+    METAGRAPH_SECTION_DELTA = 0x08,     ///< Base reference and node patches
+} metagraph_section_type_t;
+
+/**
+ * @brief Number of section types a reader knows about (max type + 1)
+ */
+#define METAGRAPH_SECTION_TYPE_COUNT 9U
+
+/**
+ * @brief Bundle header (128 bytes, file offset 0)
+ */
+typedef struct {
+    char magic[8];            ///< METAGRAPH_BUNDLE_MAGIC
+    uint8_t format_uuid[16];  ///< Binary form of METAGRAPH_BUNDLE_FORMAT_UUID
+    uint32_t format_version;  ///< METAGRAPH_BUNDLE_FORMAT_VERSION
+    uint32_t api_version;     ///< (major << 16) | minor of the writer
+    uint32_t flags;           ///< metagraph_bundle_flags_t bits
+    uint32_t reserved_flags;  ///< Must be zero
+    uint64_t total_size;      ///< File size in bytes
+    uint64_t creation_time;   ///< Unix timestamp (UTC)
+    uint64_t bundle_id;       ///< Writer-assigned bundle identifier
+    uint64_t header_checksum; ///< Checksum of this header with field zeroed
+    uint64_t bundle_checksum; ///< Whole-bundle checksum (0 = not recorded)
+    uint32_t section_count;   ///< Entries in the section table
+    uint32_t delta_base_id;   ///< Low 32 bits of the base's bundle_id for
+                              ///< delta bundles (informational)
+    uint64_t section_table_offset; ///< File offset of the section table
+    uint8_t integrity_hash[32]; ///< BLAKE3 of header, table and INTEGRITY
+                                ///< section (all zero = not recorded)
+} metagraph_bundle_header_t;
+
+/**
+ * @brief Bundle-level feature flags
+ */
+typedef enum {
+    METAGRAPH_BUNDLE_FLAG_COMPRESSED = 1U << 0U,
+    METAGRAPH_BUNDLE_FLAG_ENCRYPTED = 1U << 1U,
+    METAGRAPH_BUNDLE_FLAG_SIGNED = 1U << 2U,
+    METAGRAPH_BUNDLE_FLAG_DELTA = 1U << 3U,
+} metagraph_bundle_flags_t;
+
+/**
+ * @brief Section flags
+ */
+typedef enum {
+    METAGRAPH_SECTION_FLAG_COMPRESSED = 1U << 0U, ///< Blocks behind a seek
+                                                  ///< table (STORE only)
+} metagraph_section_flags_t;
+
+/**
+ * @brief Block codecs of a compressed section
+ */
+typedef enum {
+    METAGRAPH_COMPRESSION_NONE = 0, ///< Stored as is
+    METAGRAPH_COMPRESSION_LZ = 1,   ///< Byte-oriented LZ77 favouring decode
+                                    ///< speed, in the spirit of LZ4
+} metagraph_compression_t;
+
+/**
+ * @brief Section table entry (40 bytes)
+ */
+typedef struct {
+    uint32_t type;       ///< metagraph_section_type_t
+    uint32_t flags;      ///< metagraph_section_flags_t bits
+    uint64_t offset;     ///< File offset of the section
+    uint64_t size;       ///< Section size in bytes
+    uint64_t checksum;   ///< Low 64 bits of the section's BLAKE3 hash
+                         ///< (0 = not recorded)
+    uint32_t item_count; ///< Records in the section
+    uint32_t reserved;   ///< Must be zero
+} metagraph_section_header_t;
+
+/**
+ * @brief Node record in the NODES section (64 bytes)
+ *
+ * data_offset and name_offset are relative to the start of the STORE
+ * section; names are NUL-terminated.
+ */
+typedef struct {
+    metagraph_id_t id;    ///< Node ID
+    uint64_t hash;        ///< Content hash of the payload
+    uint64_t data_offset; ///< Payload offset in STORE
+    uint64_t data_size;   ///< Payload size in bytes
+    uint64_t name_offset; ///< Name offset in STORE or METAGRAPH_BUNDLE_NO_OFFSET
+    uint32_t name_length; ///< Name length excluding the terminator
+    uint32_t type;        ///< Application-defined asset type
+    uint64_t reserved;    ///< Must be zero
+} metagraph_bundle_node_record_t;
+
+/**
+ * @brief Hyperedge record in the EDGES section (32 bytes)
+ */
+typedef struct {
+    metagraph_id_t id;     ///< Edge ID
+    uint32_t type;         ///< Application-defined edge type
+    float weight;          ///< Edge weight
+    uint32_t member_begin; ///< First entry in the member array
+    uint32_t member_count; ///< Number of members (source first)
+} metagraph_bundle_edge_record_t;
+
+/**
+ * @brief Sub-header at the start of the EDGES section (96 bytes)
+ *
+ * Offsets are relative to the section start. Adjacency is stored in
+ * compressed-sparse-row form: out_rows has node_count + 1 entries and
+ * node n's outgoing edges are out_edges[out_rows[n] .. out_rows[n+1]).
+ */
+typedef struct {
+    uint64_t node_count;      ///< Nodes covered by the row arrays
+    uint64_t edge_count;      ///< Edge records
+    uint64_t member_count;    ///< Entries in the member array
+    uint64_t out_count;       ///< Entries in out_edges
+    uint64_t in_count;        ///< Entries in in_edges
+    uint64_t records_offset;  ///< metagraph_bundle_edge_record_t[edge_count]
+    uint64_t members_offset;  ///< uint32_t[member_count]
+    uint64_t out_rows_offset; ///< uint32_t[node_count + 1]
+    uint64_t out_edges_offset; ///< uint32_t[out_count]
+    uint64_t in_rows_offset;  ///< uint32_t[node_count + 1]
+    uint64_t in_edges_offset; ///< uint32_t[in_count]
+    uint64_t reserved;        ///< Must be zero
+} metagraph_bundle_edges_header_t;
+
+/**
+ * @brief Sub-header at the start of the INDEX section (32 bytes)
+ *
+ * The index is a serialized open-addressing table: capacity + 16 control
+ * bytes followed by capacity slots of {id, node index}. It is probed in
+ * place; loading a bundle never rebuilds it.
+ */
+typedef struct {
+    uint64_t capacity;     ///< Slots (power of two, >= 16)
+    uint64_t count;        ///< Occupied slots
+    uint64_t ctrl_offset;  ///< Control bytes, relative to section start
+    uint64_t slots_offset; ///< Slot array, relative to section start
+} metagraph_bundle_index_header_t;
+
+/**
+ * @brief Sub-header at the start of the INTEGRITY section (16 bytes)
+ *
+ * Followed by entry_count metagraph_bundle_integrity_entry_t records and
+ * then the leaf arrays they point to.
+ */
+typedef struct {
+    uint32_t chunk_log2;  ///< log2 of the Merkle leaf size (>= 10)
+    uint32_t entry_count; ///< Sections covered
+    uint64_t reserved;    ///< Must be zero
+} metagraph_bundle_integrity_header_t;
+
+/**
+ * @brief Merkle tree of one section (56 bytes)
+ *
+ * Leaf i is the BLAKE3 chaining value of bytes [i << chunk_log2,
+ * (i + 1) << chunk_log2) of the section, so folding the leaves yields root,
+ * the BLAKE3 hash of the whole section.
+ */
+typedef struct {
+    uint32_t type;          ///< metagraph_section_type_t covered
+    uint32_t reserved;      ///< Must be zero
+    uint64_t leaf_count;    ///< Leaves (at least one)
+    uint64_t leaves_offset; ///< 32-byte leaves, relative to section start
+    uint8_t root[32];       ///< BLAKE3 hash of the section
+} metagraph_bundle_integrity_entry_t;
+
+/**
+ * @brief One minimal perfect hash table in the LOOKUP section (64 bytes)
+ *
+ * Keys are split into bucket_count buckets; bucket b's pilot selects the
+ * position of each of its keys in [0, table_size), and positions at or
+ * past key_count are redirected through remap. The resulting slot is in
+ * [0, key_count). Offsets are relative to the section start.
+ */
+typedef struct {
+    uint64_t seed;          ///< Hash seed
+    uint64_t key_count;     ///< Keys and slots
+    uint64_t bucket_count;  ///< Entries in the pilot array
+    uint64_t table_size;    ///< Positions before remapping
+    uint64_t pilots_offset; ///< uint32_t[bucket_count]
+    uint64_t remap_offset;  ///< uint32_t[table_size - key_count]
+    uint64_t slots_offset;  ///< Slot array
+    uint64_t reserved;      ///< Must be zero
+} metagraph_bundle_lookup_table_t;
+
+/**
+ * @brief Sub-header at the start of the LOOKUP section (128 bytes)
+ *
+ * The ID table has one {id, node index} slot per node, laid out like the
+ * INDEX slots. The path table has a metagraph_bundle_path_slot_t per
+ * distinct normalized node name; when several nodes share a name, the
+ * first one is indexed.
+ */
+typedef struct {
+    metagraph_bundle_lookup_table_t ids;   ///< Keyed by node ID
+    metagraph_bundle_lookup_table_t paths; ///< Keyed by normalized name hash
+} metagraph_bundle_lookup_header_t;
+
+/**
+ * @brief Path table slot (16 bytes)
+ *
+ * check holds the high half of the 128-bit path hash, so nearly every miss
+ * is rejected without touching the node's name.
+ */
+typedef struct {
+    uint64_t check;    ///< High 64 bits of the path hash
+    uint32_t node;     ///< Node index
+    uint32_t reserved; ///< Must be zero
+} metagraph_bundle_path_slot_t;
+
+/**
+ * @brief Sub-header at the start of a compressed section (32 bytes)
+ *
+ * The uncompressed bytes are cut into blocks of 1 << block_log2 bytes (the
+ * last one may be shorter) and each block is compressed on its own. The
+ * seek table that follows holds block_count + 1 offsets relative to the
+ * section start: block i occupies [seek[i], seek[i + 1]). A block whose
+ * compressed size equals its uncompressed size is stored as is.
+ */
+typedef struct {
+    uint32_t codec;       ///< metagraph_compression_t
+    uint32_t block_log2;  ///< log2 of the uncompressed block size
+    uint64_t raw_size;    ///< Uncompressed size of the section
+    uint64_t block_count; ///< Blocks in the section
+    uint64_t seek_offset; ///< uint64_t[block_count + 1], relative to section
+                          ///< start
+} metagraph_bundle_compression_header_t;
+
+/**
+ * @brief Sub-header at the start of the DELTA section (112 bytes)
+ *
+ * The patched bundle has node_count nodes. Node n's record is the base's
+ * record n unless n is listed in the patch array, and every node at or
+ * past base_node_count must be listed. Store offsets below base_store_size
+ * address the base's (uncompressed) STORE and the rest address this
+ * bundle's STORE, shifted down by base_store_size. Sections whose bit is
+ * set in inherited_sections are read from the base; the others come from
+ * this bundle or are absent. Offsets are relative to the section start.
+ */
+typedef struct {
+    uint8_t base_format_uuid[16];    ///< format_uuid of the base
+    uint8_t base_integrity_hash[32]; ///< integrity_hash of the base
+    uint64_t base_total_size;        ///< total_size of the base
+    uint64_t base_store_size;        ///< Uncompressed STORE size of the base
+    uint64_t base_node_count;        ///< Nodes in the base
+    uint64_t node_count;             ///< Nodes after patching
+    uint64_t patch_count;            ///< Node records replaced or appended
+    uint64_t patch_nodes_offset;     ///< uint32_t[patch_count], ascending
+    uint64_t patch_records_offset;   ///< metagraph_bundle_node_record_t
+                                     ///< [patch_count]
+    uint32_t inherited_sections;     ///< 1 << metagraph_section_type_t per
+                                     ///< section taken from the base
+    uint32_t reserved;               ///< Must be zero
+} metagraph_bundle_delta_header_t;
+
+/**
+ * @brief Bundle description stored in the METADATA section
+ */
+typedef struct {
+    uint64_t creation_time;     ///< Unix timestamp (UTC)
+    uint64_t modification_time; ///< Unix timestamp (UTC)
+    char creator[64];           ///< NUL-terminated creator string
+    char description[256];      ///< NUL-terminated description
+    uint32_t target_platform;   ///< Application-defined platform tag
+    uint32_t compression_type;  ///< metagraph_compression_t of the STORE
+} metagraph_bundle_metadata_t;
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+/**
+ * @brief Opaque handle to an open bundle
+ */
+typedef struct metagraph_bundle metagraph_bundle_t;
+
+/**
+ * @brief Bundle open flags
+ */
+typedef enum {
+    METAGRAPH_BUNDLE_OPEN_DEFAULT = 0,
+    METAGRAPH_BUNDLE_OPEN_POPULATE = 1U << 0U, ///< Prefault the whole file
+    METAGRAPH_BUNDLE_OPEN_VERIFY = 1U << 1U,   ///< Verify data on first access
+} metagraph_bundle_open_flags_t;
+
+/**
+ * @brief Bundle open options (NULL selects defaults)
+ */
+typedef struct {
+    uint32_t flags; ///< metagraph_bundle_open_flags_t bits
+} metagraph_bundle_options_t;
+
+/**
+ * @brief Map and open a bundle file
+ *
+ * With METAGRAPH_BUNDLE_OPEN_VERIFY, sections are checked against their
+ * Merkle trees as they are hydrated, and node payloads leaf by leaf as
+ * they are read, so only data actually paged in is hashed.
+ *
+ * @return METAGRAPH_SUCCESS, a file/mmap error,
+ *         METAGRAPH_ERROR_BUNDLE_VERSION_MISMATCH,
+ *         METAGRAPH_ERROR_BUNDLE_CORRUPTED or, when verification is
+ *         requested for a bundle without integrity data,
+ *         METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE
+ */
+metagraph_result_t
+metagraph_bundle_create_from_file(const char *file_path,
+                                  const metagraph_bundle_options_t *options,
+                                  metagraph_bundle_t **out_bundle);
+
+/**
+ * @brief Open a bundle that is already in memory
+ *
+ * The buffer is borrowed, must outlive the bundle and must be 8-byte
+ * aligned.
+ */
+metagraph_result_t
+metagraph_bundle_create_from_memory(const void *data, size_t data_size,
+                                    const metagraph_bundle_options_t *options,
+                                    metagraph_bundle_t **out_bundle);
+
+/**
+ * @brief Overlay an open delta bundle on the bundle it patches
+ *
+ * The base must be the exact bundle the delta was made from: its format
+ * UUID, integrity hash, size, STORE size and node count are checked
+ * against the delta's DELTA section. Nothing is rewritten; node records
+ * are patched into a private copy when they are first needed, and reads
+ * of unchanged payloads, adjacency and lookup tables go to the base's
+ * mapping. The base may itself be a patched delta.
+ *
+ * On success delta takes ownership of base: every query on delta answers
+ * for the patched bundle, and destroying delta destroys base. Apply the
+ * delta before sharing it between threads. Each bundle keeps the open
+ * flags it was opened with, so open the base with
+ * METAGRAPH_BUNDLE_OPEN_VERIFY (or verify it) to trust its contents.
+ *
+ * @param delta Delta bundle (METAGRAPH_BUNDLE_FLAG_DELTA)
+ * @param base Bundle the delta was made from
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_ARGUMENT if delta is
+ *         not a delta or already has a base,
+ *         METAGRAPH_ERROR_BUNDLE_VERSION_MISMATCH if base is not the
+ *         delta's base, METAGRAPH_ERROR_BUNDLE_CORRUPTED or
+ *         METAGRAPH_ERROR_CHECKSUM_MISMATCH
+ */
+metagraph_result_t metagraph_bundle_apply_delta(metagraph_bundle_t *delta,
+                                                metagraph_bundle_t *base);
+
+/**
+ * @brief Close a bundle and unmap it (NULL is ignored)
+ *
+ * A delta also destroys the base it was applied to.
+ */
+metagraph_result_t metagraph_bundle_destroy(metagraph_bundle_t *bundle);
+
+/**
+ * @brief Borrow the validated bundle header
+ */
+const metagraph_bundle_header_t *
+metagraph_bundle_get_header(const metagraph_bundle_t *bundle);
+
+/**
+ * @brief Borrow the mapping backing a bundle
+ */
+const metagraph_memory_map_t *
+metagraph_bundle_get_map(const metagraph_bundle_t *bundle);
+
+/**
+ * @brief Borrow a section's raw bytes
+ *
+ * For an applied delta, sections inherited from the base are the base's.
+ *
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_BUNDLE_CORRUPTED if the
+ *         section is missing
+ */
+metagraph_result_t metagraph_bundle_get_section(const metagraph_bundle_t *bundle,
+                                                metagraph_section_type_t type,
+                                                const void **out_data,
+                                                size_t *out_size);
+
+/**
+ * @brief Copy out the bundle description
+ */
+metagraph_result_t
+metagraph_bundle_get_metadata(const metagraph_bundle_t *bundle,
+                              metagraph_bundle_metadata_t *out_metadata);
+
+/**
+ * @brief Number of nodes in the bundle
+ */
+metagraph_result_t metagraph_bundle_node_count(const metagraph_bundle_t *bundle,
+                                               size_t *out_count);
+
+/**
+ * @brief Number of hyperedges in the bundle
+ */
+metagraph_result_t metagraph_bundle_edge_count(const metagraph_bundle_t *bundle,
+                                               size_t *out_count);
+
+/**
+ * @brief Resolve a node ID through the mapped index
+ *
+ * Uses the LOOKUP section's perfect hash when present and the INDEX
+ * section otherwise.
+ *
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND
+ */
+metagraph_result_t metagraph_bundle_find_node(const metagraph_bundle_t *bundle,
+                                              metagraph_id_t node_id,
+                                              metagraph_node_index_t *out_index);
+
+/**
+ * @brief Resolve a node by name, treating names as asset paths
+ *
+ * The path is normalized first (see metagraph_path_normalize()), so
+ * "textures/./wood.png" finds a node named "textures/wood.png". Paths that
+ * cannot be normalized are looked up verbatim.
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND or
+ *         METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE for a bundle without a
+ *         LOOKUP section
+ */
+metagraph_result_t
+metagraph_bundle_find_node_by_path(const metagraph_bundle_t *bundle,
+                                   const char *path,
+                                   metagraph_node_index_t *out_index);
+
+/**
+ * @brief Resolve many node IDs in one call
+ *
+ * Gives the same indices as metagraph_bundle_find_node() per ID, but works
+ * through the IDs in small groups: a whole group is hashed and the table
+ * lines it needs are prefetched before any of them is probed, so the
+ * group's cache misses overlap instead of following one another. IDs not
+ * in the bundle are not an error and resolve to METAGRAPH_INVALID_INDEX.
+ *
+ * @param node_ids IDs to resolve
+ * @param count Entries in node_ids and out_indices
+ * @param out_indices Receives each ID's node index
+ * @param out_found Receives how many IDs were found (may be NULL)
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_BUNDLE_CORRUPTED
+ */
+metagraph_result_t metagraph_bundle_find_nodes(
+    const metagraph_bundle_t *bundle, const metagraph_id_t *node_ids,
+    size_t count, metagraph_node_index_t *out_indices, size_t *out_found);
+
+/**
+ * @brief Read a node; name and data point into the mapping
+ *
+ * Pointers stay valid until the bundle is destroyed. The mapping is
+ * read-only: callers must not write through data. When the STORE is
+ * compressed, the blocks holding the node are decoded first (each block
+ * at most once per bundle) and the pointers refer to the bundle's
+ * decompressed copy.
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND,
+ *         METAGRAPH_ERROR_BUNDLE_CORRUPTED or, for a block that does not
+ *         decode, METAGRAPH_ERROR_COMPRESSION_FAILED
+ */
+metagraph_result_t
+metagraph_bundle_get_node(const metagraph_bundle_t *bundle,
+                          metagraph_node_index_t node,
+                          metagraph_node_metadata_t *out_metadata);
+
+/**
+ * @brief Decode the compressed STORE blocks holding some nodes
+ *
+ * Blocks not yet decoded are decompressed on up to thread_count threads
+ * (0 = one per CPU), so a batch of assets can be warmed before it is read.
+ * Nothing is done for a bundle whose STORE is not compressed.
+ *
+ * @param nodes Nodes to decode (NULL decodes the whole STORE)
+ * @param count Entries in nodes
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND,
+ *         METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+ *         METAGRAPH_ERROR_COMPRESSION_FAILED or a thread error
+ */
+metagraph_result_t
+metagraph_bundle_prefetch_nodes(const metagraph_bundle_t *bundle,
+                                const metagraph_node_index_t *nodes,
+                                size_t count, uint32_t thread_count);
+
+/**
+ * @brief Read whole sections into the page cache ahead of use
+ *
+ * Warms a cold bundle with batched reads (see metagraph_mmap_read_ahead())
+ * instead of one page fault at a time. Sections an applied delta inherits,
+ * and its base's STORE, are read from the base's file. Nothing is
+ * hydrated, decoded or verified, and a bundle opened from memory has
+ * nothing to read.
+ *
+ * @param types Sections to read (NULL reads every section)
+ * @param count Entries in types
+ * @param options Read-ahead options (NULL selects defaults)
+ * @param out_stats Totals over every file read (may be NULL); backend is
+ *        the one used for the last file that needed reading
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_ARGUMENT for an
+ *         unknown section type or a read-ahead error
+ */
+metagraph_result_t metagraph_bundle_prefetch_sections(
+    const metagraph_bundle_t *bundle, const metagraph_section_type_t *types,
+    size_t count, const metagraph_read_ahead_options_t *options,
+    metagraph_read_ahead_stats_t *out_stats);
+
+/**
+ * @brief Read a hyperedge (nodes is set to NULL)
+ */
+metagraph_result_t
+metagraph_bundle_get_edge(const metagraph_bundle_t *bundle,
+                          metagraph_edge_index_t edge,
+                          metagraph_edge_metadata_t *out_metadata);
+
+/**
+ * @brief Borrow an edge's member node indices from the mapping
+ */
+metagraph_result_t
+metagraph_bundle_get_edge_nodes(const metagraph_bundle_t *bundle,
+                                metagraph_edge_index_t edge,
+                                const metagraph_node_index_t **out_nodes,
+                                size_t *out_count);
+
+/**
+ * @brief Verify every section against the bundle's Merkle trees
+ *
+ * Leaves are hashed on all online CPUs. An applied delta verifies its own
+ * sections, pinned to expected_hash, and then its base's.
+ *
+ * @param expected_hash Trusted integrity hash to pin the header against
+ *        (NULL trusts the hash recorded in the header)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+ *         METAGRAPH_ERROR_BUNDLE_CORRUPTED for a malformed INTEGRITY
+ *         section or METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE when the bundle
+ *         carries no integrity data
+ */
+metagraph_result_t
+metagraph_bundle_verify_integrity(const metagraph_bundle_t *bundle,
+                                  const metagraph_blake3_hash_t *expected_hash);
+
+/**
+ * @brief Verify [offset, offset + size) of one section
+ *
+ * Only the leaves overlapping the range are hashed, and each leaf is
+ * hashed at most once per bundle. Only the bundle's own sections are
+ * covered, never those a delta inherits.
+ */
+metagraph_result_t metagraph_bundle_verify_range(const metagraph_bundle_t *bundle,
+                                                 metagraph_section_type_t type,
+                                                 uint64_t offset, uint64_t size);
+
+/**
+ * @brief Borrow the edges a node is the source of, straight from the mapping
+ */
+metagraph_result_t
+metagraph_bundle_get_outgoing_edges(const metagraph_bundle_t *bundle,
+                                    metagraph_node_index_t node,
+                                    const metagraph_edge_index_t **out_edges,
+                                    size_t *out_count);
+
+/**
+ * @brief Borrow the edges that target a node, straight from the mapping
+ */
+metagraph_result_t
+metagraph_bundle_get_incoming_edges(const metagraph_bundle_t *bundle,
+                                    metagraph_node_index_t node,
+                                    const metagraph_edge_index_t **out_edges,
+                                    size_t *out_count);
+
+/**
+ * @brief Borrow the outgoing edges of many nodes in one call
+ *
+ * Gives the same lists as metagraph_bundle_get_outgoing_edges() per node,
+ * with the row offsets of a group of nodes prefetched before any is read
+ * and the first line of every list prefetched for the caller. A node of
+ * METAGRAPH_INVALID_INDEX, as metagraph_bundle_find_nodes() reports for an
+ * unknown ID, gets an empty list.
+ *
+ * @param nodes Nodes to read
+ * @param count Entries in nodes, out_edges and out_counts
+ * @param out_edges Receives a pointer into the mapping per node
+ * @param out_counts Receives the length of each list
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND for an index
+ *         out of range (earlier entries are filled in)
+ */
+metagraph_result_t metagraph_bundle_get_outgoing_edges_batch(
+    const metagraph_bundle_t *bundle, const metagraph_node_index_t *nodes,
+    size_t count, const metagraph_edge_index_t **out_edges,
+    size_t *out_counts);
+
+/**
+ * @brief Borrow the incoming edges of many nodes in one call
+ *
+ * Same contract as metagraph_bundle_get_outgoing_edges_batch().
+ */
+metagraph_result_t metagraph_bundle_get_incoming_edges_batch(
+    const metagraph_bundle_t *bundle, const metagraph_node_index_t *nodes,
+    size_t count, const metagraph_edge_index_t **out_edges,
+    size_t *out_counts);
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+/**
+ * @brief Node renumbering applied before a graph is written
+ *
+ * Every method keeps the nodes of a connected component together and
+ * places nodes next to the nodes they share edges with, so a traversal
+ * reads fewer pages of the NODES, EDGES and STORE sections. Edges are
+ * written in the new order of their source nodes.
+ */
+typedef enum {
+    METAGRAPH_REORDER_NONE = 0, ///< Keep the graph's insertion order
+    METAGRAPH_REORDER_BFS,      ///< Breadth-first order of each component
+    METAGRAPH_REORDER_RCM,      ///< Reverse Cuthill-McKee (low bandwidth)
+    METAGRAPH_REORDER_GORDER,   ///< Greedy placement of nodes that share
+                                ///< neighbors within a small window
+} metagraph_reorder_t;
+
+/**
+ * @brief Locality of one node numbering
+ *
+ * Page touches are estimated by walking dependencies breadth-first from
+ * up to 64 evenly spaced nodes, 512 nodes per walk, and counting the
+ * distinct 4 KiB pages of node records each walk reads.
+ */
+typedef struct {
+    double average_edge_span; ///< Mean index distance, source to target
+    uint64_t max_edge_span;   ///< Largest index distance, source to target
+    double page_touches;      ///< Mean NODES pages read per walk
+} metagraph_locality_metrics_t;
+
+/**
+ * @brief Locality before and after reordering
+ */
+typedef struct {
+    metagraph_locality_metrics_t before; ///< Graph insertion order
+    metagraph_locality_metrics_t after;  ///< Order written to the bundle
+} metagraph_reorder_report_t;
+
+/**
+ * @brief Options for writing a bundle (NULL selects defaults)
+ */
+typedef struct {
+    uint64_t creation_time;  ///< Unix time to record (0 = now)
+    uint64_t bundle_id;      ///< Bundle identifier to record
+    const char *creator;     ///< Creator string (may be NULL)
+    const char *description; ///< Description string (may be NULL)
+    uint32_t target_platform; ///< Application-defined platform tag
+    size_t integrity_chunk_size; ///< Merkle leaf size, a power of two
+                                 ///< >= 1 KiB (0 = 64 KiB)
+    uint32_t compression;        ///< metagraph_compression_t of the STORE
+    size_t compression_block_size; ///< Uncompressed STORE block size, a
+                                   ///< power of two from 4 KiB to 16 MiB
+                                   ///< (0 = 64 KiB)
+    uint32_t reorder; ///< metagraph_reorder_t; metagraph_bundle_write_graph()
+                      ///< only
+    metagraph_reorder_report_t *reorder_report; ///< Receives the locality
+                                                ///< of both orders (may be
+                                                ///< NULL)
+} metagraph_bundle_write_options_t;
+
+/**
+ * @brief Serialize a graph, including node payloads, to a bundle file
+ *
+ * With compression selected, the STORE blocks are compressed on all
+ * online CPUs. With a reorder method selected, node indices in the bundle
+ * follow the new order rather than the graph's; look nodes up by ID.
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_ARGUMENT for an
+ *         unknown codec or reorder method, METAGRAPH_ERROR_INVALID_SIZE for
+ *         a bad chunk or block size, METAGRAPH_ERROR_OUT_OF_MEMORY or an
+ *         I/O error
+ */
+metagraph_result_t
+metagraph_bundle_write_graph(const metagraph_graph_t *graph,
+                             const char *file_path,
+                             const metagraph_bundle_write_options_t *options);
+
+/**
+ * @brief Write a delta bundle that turns base into target
+ *
+ * Nodes are matched by ID. A node whose payload or name is byte-identical
+ * to the base node with the same ID reuses the base's bytes; only new
+ * bytes are written to the delta's STORE, and only node records that
+ * differ from the base record at the same index are patched. EDGES, INDEX
+ * and LOOKUP are inherited when their bytes match the base's and copied
+ * from target otherwise. Nodes are compared on all online CPUs.
+ *
+ * The delta references base by its integrity hash, so base must have been
+ * written with integrity data. Applying the delta to base (see
+ * metagraph_bundle_apply_delta()) reads the same nodes, edges and lookups
+ * as target. Options apply to the delta itself; creator, description and
+ * target platform default to target's.
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE for a
+ *         base without an integrity hash or a reorder method (a delta
+ *         keeps target's numbering), an option error as for
+ *         metagraph_bundle_write_graph(), a read error from either bundle
+ *         or an I/O error
+ */
+metagraph_result_t
+metagraph_bundle_write_delta(const metagraph_bundle_t *base,
+                             const metagraph_bundle_t *target,
+                             const char *file_path,
+                             const metagraph_bundle_write_options_t *options);
+
+// ============================================================================
+// Streaming builder
+// ============================================================================
+
+/**
+ * @brief Incremental bundle writer
+ *
+ * A builder produces the same file as metagraph_bundle_write_graph() without
+ * holding the graph in memory. Node records, payloads, names, edge records
+ * and edge members are appended to spill files as they are added; only the
+ * ID index, per-node degree counters and name hashes (about 72 bytes per
+ * node) stay resident. metagraph_bundle_builder_finish() lays the sections out, copies
+ * and encodes them into the mapped output on worker threads, then hashes
+ * the image and fixes up the header and section table.
+ *
+ * Builders are not thread-safe.
+ */
+typedef struct metagraph_bundle_builder metagraph_bundle_builder_t;
+
+/**
+ * @brief Builder creation parameters
+ *
+ * Zero-initialised fields select the defaults. The creator and description
+ * strings are borrowed until metagraph_bundle_builder_finish() returns.
+ */
+typedef struct {
+    metagraph_bundle_write_options_t write; ///< Options recorded in the bundle
+    const char *temp_directory; ///< Directory for spill files
+                                ///< (NULL = anonymous tmpfile())
+    size_t max_memory_usage;    ///< Spill write buffering in bytes
+                                ///< (0 = 16 MiB)
+    uint32_t thread_count;      ///< Encoder threads (0 = one per CPU)
+} metagraph_bundle_builder_config_t;
+
+/**
+ * @brief Start a new bundle
+ * @param config Creation parameters (NULL selects defaults)
+ * @param out_builder Receives the new builder
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_SIZE for a bad
+ *         integrity chunk size, METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE for a
+ *         reorder method (nodes are spilled as they are added, so their
+ *         order is fixed), or an allocation/I/O error
+ */
+metagraph_result_t
+metagraph_bundle_builder_create(const metagraph_bundle_builder_config_t *config,
+                                metagraph_bundle_builder_t **out_builder);
+
+/**
+ * @brief Destroy a builder and delete its spill files
+ * @param builder Builder to destroy (NULL is ignored)
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t
+metagraph_bundle_builder_destroy(metagraph_bundle_builder_t *builder);
+
+/**
+ * @brief Append a node
+ *
+ * The payload and name are copied to the spill files before returning.
+ *
+ * @param builder Builder to append to
+ * @param metadata Node to add
+ * @param out_index Receives the node index (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_EXISTS,
+ *         METAGRAPH_ERROR_MAX_NODES_EXCEEDED or an allocation/I/O error
+ */
+metagraph_result_t
+metagraph_bundle_builder_add_node(metagraph_bundle_builder_t *builder,
+                                  const metagraph_node_metadata_t *metadata,
+                                  metagraph_node_index_t *out_index);
+
+/**
+ * @brief Append a hyperedge between nodes already added
+ * @param builder Builder to append to
+ * @param metadata Edge to add; properties are not serialized
+ * @param out_index Receives the edge index (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND,
+ *         METAGRAPH_ERROR_EDGE_EXISTS, METAGRAPH_ERROR_INVALID_ARGUMENT,
+ *         METAGRAPH_ERROR_MAX_EDGES_EXCEEDED or an allocation/I/O error
+ */
+metagraph_result_t
+metagraph_bundle_builder_add_edge(metagraph_bundle_builder_t *builder,
+                                  const metagraph_edge_metadata_t *metadata,
+                                  metagraph_edge_index_t *out_index);
+
+/**
+ * @brief Write the bundle to file_path
+ *
+ * Output goes to file_path + ".tmp" and is renamed into place once
+ * complete. A compressed STORE is compressed from its spill file a batch of
+ * blocks at a time before the output is sized. A builder can be finished
+ * once; destroy it afterwards.
+ *
+ * @return METAGRAPH_SUCCESS or an I/O, mapping or thread error
+ */
+metagraph_result_t
+metagraph_bundle_builder_finish(metagraph_bundle_builder_t *builder,
+                                const char *file_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_BUNDLE_H
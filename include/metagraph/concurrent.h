@@ -0,0 +1,262 @@
+/**
+ * @file concurrent.h
+ * @brief Lock-free readable ID table and concurrent node store
+ *
+ * Both structures follow a single-writer / many-reader model. Writers are
+ * serialized by an internal mutex; readers take no locks and never block,
+ * not even while a writer resizes the table.
+ *
+ * Lookups run against an atomically published open-addressing table.
+ * Inserts fill empty slots in place and publish them with a release store
+ * of the slot's control byte; removals turn a slot into a tombstone.
+ * Tombstones are never refilled in place, so a slot a reader has observed
+ * as live never changes. When the table fills up the writer builds a new
+ * one, publishes it with a single pointer store and retires the old one.
+ *
+ * Retired tables and removed nodes are released through epoch-based
+ * reclamation: memory is freed only once every reader that could still
+ * hold a pointer to it has left its read section.
+ *
+ * Reads observe each mutation atomically but a sequence of reads is not a
+ * snapshot. Callers that need one take metagraph_concurrent_graph_version()
+ * before reading and confirm it with metagraph_concurrent_graph_validate()
+ * afterwards; that is the only place METAGRAPH_ERROR_CONCURRENT_MODIFICATION
+ * is reported.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_CONCURRENT_H
+#define METAGRAPH_CONCURRENT_H
+
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Concurrent hash table
+// ============================================================================
+
+/**
+ * @brief ID -> pointer table with lock-free lookups
+ *
+ * Values are borrowed: the table never dereferences or frees them. A
+ * reader may still return a value after it has been removed, so callers
+ * that free values must defer that until their readers are done.
+ */
+typedef struct metagraph_concurrent_hashtable metagraph_concurrent_hashtable_t;
+
+/**
+ * @brief Create an empty table
+ * @param initial_capacity Entries to size for up front (0 = 64)
+ * @param out_table Receives the new table
+ * @return METAGRAPH_SUCCESS or an error code
+ */
+metagraph_result_t
+metagraph_concurrent_hashtable_create(size_t initial_capacity,
+                                      metagraph_concurrent_hashtable_t **out_table);
+
+/**
+ * @brief Destroy a table
+ *
+ * No other thread may be using the table.
+ *
+ * @param table Table to destroy (NULL is ignored)
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t
+metagraph_concurrent_hashtable_destroy(metagraph_concurrent_hashtable_t *table);
+
+/**
+ * @brief Insert a key unless it is already present
+ * @param table Target table
+ * @param key Key to insert
+ * @param value Borrowed value (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_EXISTS if the key is
+ *         present, or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_concurrent_hashtable_insert(metagraph_concurrent_hashtable_t *table,
+                                      metagraph_id_t key, void *value);
+
+/**
+ * @brief Look up a key without taking a lock
+ * @param table Table to search
+ * @param key Key to look up
+ * @param out_value Receives the value
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND
+ */
+metagraph_result_t
+metagraph_concurrent_hashtable_lookup(const metagraph_concurrent_hashtable_t *table,
+                                      metagraph_id_t key, void **out_value);
+
+/**
+ * @brief Remove a key
+ * @param table Target table
+ * @param key Key to remove
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND
+ */
+metagraph_result_t
+metagraph_concurrent_hashtable_remove(metagraph_concurrent_hashtable_t *table,
+                                      metagraph_id_t key);
+
+/**
+ * @brief Number of keys in the table
+ */
+size_t
+metagraph_concurrent_hashtable_count(const metagraph_concurrent_hashtable_t *table);
+
+// ============================================================================
+// Concurrent node store
+// ============================================================================
+
+/**
+ * @brief Node store with lock-free lookups and enumeration
+ */
+typedef struct metagraph_concurrent_graph metagraph_concurrent_graph_t;
+
+/**
+ * @brief Create an empty concurrent node store
+ *
+ * initial_node_capacity and max_nodes are honoured; edge fields are
+ * ignored.
+ *
+ * @param config Creation parameters (NULL selects defaults)
+ * @param out_graph Receives the new store
+ * @return METAGRAPH_SUCCESS or an error code
+ */
+metagraph_result_t
+metagraph_concurrent_graph_create(const metagraph_graph_config_t *config,
+                                  metagraph_concurrent_graph_t **out_graph);
+
+/**
+ * @brief Destroy a store and every node still in it
+ *
+ * No other thread may be using the store.
+ *
+ * @param graph Store to destroy (NULL is ignored)
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t
+metagraph_concurrent_graph_destroy(metagraph_concurrent_graph_t *graph);
+
+/**
+ * @brief Add a node (writer side, serialized with other writers)
+ *
+ * The name is copied; the data pointer is borrowed.
+ *
+ * @param graph Target store
+ * @param metadata Node description
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_EXISTS,
+ *         METAGRAPH_ERROR_MAX_NODES_EXCEEDED or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_concurrent_graph_add_node(metagraph_concurrent_graph_t *graph,
+                                    const metagraph_node_metadata_t *metadata);
+
+/**
+ * @brief Remove a node (writer side, serialized with other writers)
+ *
+ * The node's storage is reclaimed once no reader can reference it.
+ *
+ * @param graph Target store
+ * @param node_id ID of the node to remove
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND
+ */
+metagraph_result_t
+metagraph_concurrent_graph_remove_node(metagraph_concurrent_graph_t *graph,
+                                       metagraph_id_t node_id);
+
+/**
+ * @brief Enter a read section on the calling thread
+ *
+ * Name pointers returned by lookups inside the section stay valid until
+ * the matching metagraph_concurrent_graph_read_end(), even if the node is
+ * removed meanwhile. Sections nest. Lookups outside a section enter one
+ * for their own duration.
+ *
+ * @param graph Store to read
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_OUT_OF_MEMORY (first use of
+ *         the store on this thread only)
+ */
+metagraph_result_t
+metagraph_concurrent_graph_read_begin(const metagraph_concurrent_graph_t *graph);
+
+/**
+ * @brief Leave the innermost read section entered on the calling thread
+ */
+void metagraph_concurrent_graph_read_end(const metagraph_concurrent_graph_t *graph);
+
+/**
+ * @brief Look up a node without taking a lock
+ *
+ * The name in out_metadata points into store-owned memory. Outside a read
+ * section it is only valid until the node is removed.
+ *
+ * @param graph Store to search
+ * @param node_id ID to look up
+ * @param out_metadata Receives the node description
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND
+ */
+metagraph_result_t
+metagraph_concurrent_graph_find_node(const metagraph_concurrent_graph_t *graph,
+                                     metagraph_id_t node_id,
+                                     metagraph_node_metadata_t *out_metadata);
+
+/**
+ * @brief Number of nodes, read without taking a lock
+ */
+size_t
+metagraph_concurrent_graph_node_count(const metagraph_concurrent_graph_t *graph);
+
+/**
+ * @brief List node IDs without taking a lock
+ *
+ * IDs are reported in table order. Nodes added or removed during the call
+ * may or may not be reported. Pass node_ids == NULL to query only the
+ * count.
+ *
+ * @param graph Store to read
+ * @param node_ids Caller buffer for IDs (may be NULL)
+ * @param capacity Capacity of node_ids in elements
+ * @param out_count Receives the number of nodes seen
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_BUFFER_TOO_SMALL (out_count
+ *         still set)
+ */
+metagraph_result_t
+metagraph_concurrent_graph_enumerate_nodes(const metagraph_concurrent_graph_t *graph,
+                                           metagraph_id_t *node_ids,
+                                           size_t capacity, size_t *out_count);
+
+/**
+ * @brief Modification counter
+ *
+ * Writers make the counter odd before a mutation and even again once it is
+ * published, as in a sequence lock.
+ */
+uint64_t
+metagraph_concurrent_graph_version(const metagraph_concurrent_graph_t *graph);
+
+/**
+ * @brief Confirm that no mutation overlapped the reads since a version
+ *        was taken
+ * @param graph Store that was read
+ * @param version Value of metagraph_concurrent_graph_version() taken
+ *        before the reads
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_CONCURRENT_MODIFICATION
+ */
+metagraph_result_t
+metagraph_concurrent_graph_validate(const metagraph_concurrent_graph_t *graph,
+                                    uint64_t version);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_CONCURRENT_H
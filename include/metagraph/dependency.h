@@ -0,0 +1,184 @@
+/**
+ * @file dependency.h
+ * @brief Incremental dependency resolution
+ *
+ * A dependency context keeps a load order of every node in a graph
+ * (dependencies before dependents) and updates it as assets change,
+ * instead of re-sorting the whole graph. Replacing an asset's dependencies
+ * reorders only the nodes whose positions lie between the two ends of a
+ * newly violated dependency (Pearce-Kelly dynamic topological ordering);
+ * removing a dependency never invalidates the order. Resolving a set of
+ * changed assets walks only their downstream consumers.
+ *
+ * The context copies the graph's dependency relation when it is created
+ * and owns it from then on: updates change the context, not the graph.
+ * The graph must stay alive for the context's lifetime and is used for ID
+ * lookups and node names. Nodes added to the graph later are not tracked.
+ *
+ * Contexts are not thread-safe.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_DEPENDENCY_H
+#define METAGRAPH_DEPENDENCY_H
+
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+#include "metagraph/scheduler.h"
+#include "metagraph/traversal.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Dependency context creation parameters
+ */
+typedef struct {
+    const metagraph_graph_t *graph;       ///< Graph whose dependencies to track
+    metagraph_parallel_config_t parallel; ///< Used for the initial ordering
+} metagraph_dependency_config_t;
+
+/**
+ * @brief Assets to (re)load, in dependency order
+ */
+typedef struct {
+    metagraph_id_t *load_order;   ///< Asset IDs, dependencies first
+    metagraph_node_index_t *nodes; ///< The same assets as node indices
+    size_t load_order_count;      ///< Entries in load_order and nodes
+} metagraph_resolution_result_t;
+
+typedef struct metagraph_dependency_context metagraph_dependency_context_t;
+
+/**
+ * @brief Load one asset for metagraph_dependency_load()
+ * @param user_data Pointer given to metagraph_dependency_load()
+ * @param node The asset's node index
+ * @param asset_id The asset's ID
+ * @return METAGRAPH_SUCCESS, or an error that skips the asset's dependents
+ */
+typedef metagraph_result_t (*metagraph_asset_load_fn)(
+    void *user_data, metagraph_node_index_t node, metagraph_id_t asset_id);
+
+/**
+ * @brief Order a graph and start tracking changes to it
+ * @param config Creation parameters
+ * @param out_context Receives the new context
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_DEPENDENCY_CYCLE if the graph
+ *         cannot be ordered, or an allocation/thread error
+ */
+metagraph_result_t
+metagraph_dependency_context_create(const metagraph_dependency_config_t *config,
+                                    metagraph_dependency_context_t **out_context);
+
+/**
+ * @brief Destroy a context
+ * @param context Context to destroy (NULL is ignored)
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t
+metagraph_dependency_context_destroy(metagraph_dependency_context_t *context);
+
+/**
+ * @brief Replace the dependencies of one asset
+ *
+ * Work is proportional to the part of the order between the asset and its
+ * new dependencies, not to the graph size. The asset is remembered as
+ * changed until the next metagraph_dependency_resolve_incremental().
+ *
+ * @param context Context to update
+ * @param asset_id Asset whose dependencies change
+ * @param new_dependencies Assets it now depends on (may be NULL if count is 0)
+ * @param dependency_count Entries in new_dependencies
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND,
+ *         METAGRAPH_ERROR_OUT_OF_MEMORY, or METAGRAPH_ERROR_DEPENDENCY_CYCLE
+ *         with the cycle in the error context. On error the context is left
+ *         as it was.
+ */
+metagraph_result_t
+metagraph_dependency_update_asset(metagraph_dependency_context_t *context,
+                                  metagraph_id_t asset_id,
+                                  const metagraph_id_t *new_dependencies,
+                                  size_t dependency_count);
+
+/**
+ * @brief List the assets that must be re-resolved after a change
+ *
+ * The result holds the changed assets, every asset updated since the last
+ * call, and everything that transitively depends on them, in load order.
+ * Work is proportional to that set.
+ *
+ * @param context Context to query
+ * @param changed_assets Assets whose content changed (may be NULL if
+ *        changed_count is 0)
+ * @param changed_count Entries in changed_assets
+ * @param out_result Receives the load order; release it with
+ *        metagraph_resolution_result_destroy()
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND or
+ *         METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_dependency_resolve_incremental(
+    metagraph_dependency_context_t *context,
+    const metagraph_id_t *changed_assets, size_t changed_count,
+    metagraph_resolution_result_t *out_result);
+
+/**
+ * @brief Load a set of assets in parallel, respecting their dependencies
+ *
+ * Each asset is handed to load as soon as the assets it depends on within
+ * the set have loaded; dependencies outside the set are taken as already
+ * loaded. There are no level-wide barriers: a slow asset only delays its
+ * own dependents. load runs concurrently on the scheduler's threads and
+ * the calling thread. When it fails for an asset, everything that depends
+ * on that asset is skipped and the first failure is returned. The context
+ * must not be updated during the call.
+ *
+ * @param context Context holding the dependencies
+ * @param assets Assets to load, such as a resolution result
+ * @param load Called once per asset that is not skipped
+ * @param user_data Passed to load
+ * @param scheduler Scheduler to run on (NULL = the shared scheduler)
+ * @param out_stats Receives loaded, failed and skipped counts (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND,
+ *         METAGRAPH_ERROR_INVALID_ARGUMENT for an asset listed twice,
+ *         METAGRAPH_ERROR_OUT_OF_MEMORY, or the first error load returned
+ */
+metagraph_result_t
+metagraph_dependency_load(const metagraph_dependency_context_t *context,
+                          const metagraph_resolution_result_t *assets,
+                          metagraph_asset_load_fn load, void *user_data,
+                          metagraph_scheduler_t *scheduler,
+                          metagraph_task_graph_stats_t *out_stats);
+
+/**
+ * @brief Borrow the current load order of every node
+ *
+ * The array is valid until the next update.
+ *
+ * @param context Context to read
+ * @param out_order Receives node indices, dependencies first
+ * @param out_count Receives the number of nodes
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t
+metagraph_dependency_get_order(const metagraph_dependency_context_t *context,
+                               const metagraph_node_index_t **out_order,
+                               size_t *out_count);
+
+/**
+ * @brief Release the arrays of a resolution result
+ * @param result Result to clear (NULL is ignored)
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t
+metagraph_resolution_result_destroy(metagraph_resolution_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_DEPENDENCY_H
@@ -0,0 +1,170 @@
+/**
+ * @file frozen.h
+ * @brief Read-only compressed-sparse-row snapshot of a graph's topology
+ *
+ * Freezing turns the linked incidence lists of a mutable graph into flat
+ * arrays laid out like a bundle's EDGES section: edge records, a member
+ * array (source first), and outgoing and incoming edge lists in CSR form.
+ * On top of that it adds a node-to-node adjacency: each node's distinct
+ * dependency targets, sorted, delta-encoded and packed Stream VByte style
+ * (four 2-bit length codes per control byte, then 1 to 4 data bytes per
+ * delta). Lists are decoded four values at a time with a byte shuffle and
+ * a vector prefix sum on SSSE3 and NEON, and by a scalar loop elsewhere.
+ *
+ * A frozen graph can also be built over a mapped bundle, in which case
+ * the incidence arrays are the bundle's EDGES section itself, read in
+ * place, and only the packed adjacency is allocated.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_FROZEN_H
+#define METAGRAPH_FROZEN_H
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Opaque frozen graph
+ */
+typedef struct metagraph_frozen_graph metagraph_frozen_graph_t;
+
+/**
+ * @brief Frozen graph size and memory statistics
+ */
+typedef struct {
+    size_t node_count;     ///< Nodes covered
+    size_t edge_count;     ///< Hyperedges covered
+    size_t member_count;   ///< Entries in the member array
+    size_t neighbor_count; ///< Entries across all adjacency lists
+    size_t packed_bytes;   ///< Encoded adjacency bytes
+    size_t memory_bytes;   ///< Bytes allocated by the frozen graph itself
+    uint32_t max_degree;   ///< Longest adjacency list
+    bool simd_decode;      ///< Adjacency lists decode with a vector kernel
+} metagraph_frozen_stats_t;
+
+/**
+ * @brief Freeze a graph's topology
+ *
+ * The snapshot copies what it needs; the graph may be changed or
+ * destroyed afterwards.
+ *
+ * @param graph Graph to freeze
+ * @param out_frozen Receives the frozen graph
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_SIZE when the
+ *         adjacency outgrows 32-bit offsets, or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_frozen_graph_create(const metagraph_graph_t *graph,
+                              metagraph_frozen_graph_t **out_frozen);
+
+/**
+ * @brief Freeze a bundle's topology, reading its EDGES section in place
+ *
+ * The bundle must outlive the frozen graph.
+ *
+ * @param bundle Bundle holding (or inheriting) an EDGES section
+ * @param out_frozen Receives the frozen graph
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+ *         METAGRAPH_ERROR_INVALID_SIZE or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_frozen_graph_from_bundle(const metagraph_bundle_t *bundle,
+                                   metagraph_frozen_graph_t **out_frozen);
+
+/**
+ * @brief Release a frozen graph (NULL is ignored)
+ */
+void metagraph_frozen_graph_destroy(metagraph_frozen_graph_t *frozen);
+
+/**
+ * @brief Decode the nodes a node depends on
+ *
+ * Targets of all the node's outgoing edges, each listed once, in
+ * ascending index order. Pass out_nodes == NULL to query only the count.
+ *
+ * @param frozen Frozen graph to read
+ * @param node Node index
+ * @param out_nodes Caller buffer for node indices (may be NULL)
+ * @param capacity Capacity of out_nodes in elements
+ * @param out_count Receives the number of neighbors
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND, or
+ *         METAGRAPH_ERROR_BUFFER_TOO_SMALL (out_count still set)
+ */
+metagraph_result_t
+metagraph_frozen_graph_neighbors(const metagraph_frozen_graph_t *frozen,
+                                 metagraph_node_index_t node,
+                                 metagraph_node_index_t *out_nodes,
+                                 size_t capacity, size_t *out_count);
+
+/**
+ * @brief Borrow the edges a node is the source of
+ *
+ * The array lives as long as the frozen graph.
+ *
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND
+ */
+metagraph_result_t metagraph_frozen_graph_outgoing_edges(
+    const metagraph_frozen_graph_t *frozen, metagraph_node_index_t node,
+    const metagraph_edge_index_t **out_edges, size_t *out_count);
+
+/**
+ * @brief Borrow the edges that target a node
+ *
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND
+ */
+metagraph_result_t metagraph_frozen_graph_incoming_edges(
+    const metagraph_frozen_graph_t *frozen, metagraph_node_index_t node,
+    const metagraph_edge_index_t **out_edges, size_t *out_count);
+
+/**
+ * @brief Borrow the member node indices of a hyperedge (source first)
+ *
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_EDGE_NOT_FOUND
+ */
+metagraph_result_t metagraph_frozen_graph_edge_nodes(
+    const metagraph_frozen_graph_t *frozen, metagraph_edge_index_t edge,
+    const metagraph_node_index_t **out_nodes, size_t *out_count);
+
+/**
+ * @brief Collect size and memory statistics
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NULL_POINTER
+ */
+metagraph_result_t
+metagraph_frozen_graph_get_stats(const metagraph_frozen_graph_t *frozen,
+                                 metagraph_frozen_stats_t *out_stats);
+
+/**
+ * @brief Single-threaded breadth-first search over the packed adjacency
+ *
+ * Follows dependency direction, like metagraph_traverse_bfs(), decoding
+ * one adjacency list per expanded node.
+ *
+ * @param frozen Frozen graph to traverse
+ * @param start Node to start from
+ * @param max_depth Nodes deeper than this are not reached (0 = none)
+ * @param out_distance Receives one entry per node: levels from start, or
+ *        UINT32_MAX when unreached
+ * @param out_reached Receives the number of nodes reached (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND or
+ *         METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_frozen_traverse_bfs(const metagraph_frozen_graph_t *frozen,
+                              metagraph_node_index_t start, uint32_t max_depth,
+                              uint32_t *out_distance, size_t *out_reached);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_FROZEN_H
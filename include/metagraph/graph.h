@@ -0,0 +1,341 @@
+/**
+ * @file graph.h
+ * @brief Core metagraph data model (nodes, hyperedges, ID lookup)
+ *
+ * The graph stores nodes and hyperedges as structure-of-arrays: every node
+ * attribute lives in its own dense array indexed by a 32-bit node index, so
+ * scans over one attribute touch only the cache lines they need. Node and
+ * edge IDs are resolved to indices through a flat open-addressing table
+ * whose control bytes are probed a SIMD group at a time.
+ *
+ * A hyperedge connects two or more nodes. The first node is the edge's
+ * source and every following node is a target: the source "depends on" the
+ * targets. Outgoing edges of a node are the edges it is the source of;
+ * incoming edges are the edges that list it as a target.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_GRAPH_H
+#define METAGRAPH_GRAPH_H
+
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 128-bit unique identifier for nodes, edges and graphs
+ */
+typedef struct {
+    uint64_t high; ///< Most significant 64 bits
+    uint64_t low;  ///< Least significant 64 bits
+} metagraph_id_t;
+
+/**
+ * @brief Dense index of a node inside one graph
+ *
+ * Indices are assigned in insertion order starting at zero and stay valid
+ * for the lifetime of the graph.
+ */
+typedef uint32_t metagraph_node_index_t;
+
+/**
+ * @brief Dense index of a hyperedge inside one graph
+ */
+typedef uint32_t metagraph_edge_index_t;
+
+/**
+ * @brief Sentinel for "no node" / "no edge"
+ */
+#define METAGRAPH_INVALID_INDEX UINT32_MAX
+
+/**
+ * @brief Opaque metagraph instance
+ */
+typedef struct metagraph_graph metagraph_graph_t;
+
+/**
+ * @brief Graph creation parameters
+ *
+ * Zero-initialised fields select the defaults.
+ */
+typedef struct {
+    size_t initial_node_capacity; ///< Nodes to reserve up front (0 = 64)
+    size_t initial_edge_capacity; ///< Edges to reserve up front (0 = 64)
+    size_t max_nodes; ///< Node limit (0 = METAGRAPH_GRAPH_MAX_NODES)
+    size_t max_edges; ///< Edge limit (0 = METAGRAPH_GRAPH_MAX_EDGES)
+} metagraph_graph_config_t;
+
+/**
+ * @brief Hard upper bound on nodes per graph (index space is 32-bit)
+ */
+#define METAGRAPH_GRAPH_MAX_NODES ((size_t)UINT32_MAX - 1U)
+
+/**
+ * @brief Hard upper bound on hyperedges per graph
+ */
+#define METAGRAPH_GRAPH_MAX_EDGES ((size_t)UINT32_MAX - 1U)
+
+/**
+ * @brief Node description used when adding and reading nodes
+ *
+ * On insertion the name is copied into graph-owned storage; the data
+ * pointer is borrowed and must outlive the graph.
+ */
+typedef struct {
+    metagraph_id_t id; ///< Unique node ID
+    const char *name;  ///< Optional human-readable name (may be NULL)
+    uint32_t type;     ///< Application-defined asset type
+    size_t data_size;  ///< Size of the asset payload in bytes
+    void *data;        ///< Borrowed pointer to the asset payload
+    uint64_t hash;     ///< Content hash of the payload
+} metagraph_node_metadata_t;
+
+/**
+ * @brief Hyperedge description used when adding and reading edges
+ *
+ * nodes[0] is the source, nodes[1..node_count-1] are the targets.
+ */
+typedef struct {
+    metagraph_id_t id;            ///< Unique edge ID
+    uint32_t type;                ///< Application-defined edge type
+    float weight;                 ///< Edge weight
+    size_t node_count;            ///< Number of connected nodes (>= 2)
+    const metagraph_id_t *nodes;  ///< Connected node IDs (source first)
+    void *properties;             ///< Borrowed application properties
+} metagraph_edge_metadata_t;
+
+/**
+ * @brief Graph size and memory statistics
+ */
+typedef struct {
+    size_t node_count;       ///< Nodes in the graph
+    size_t edge_count;       ///< Hyperedges in the graph
+    size_t incidence_count;  ///< Total node memberships across all edges
+    size_t memory_bytes;     ///< Bytes allocated by the graph itself
+    size_t index_capacity;   ///< Slots in the node ID index
+} metagraph_graph_stats_t;
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+/**
+ * @brief Create an empty graph
+ * @param config Creation parameters (NULL selects defaults)
+ * @param out_graph Receives the new graph
+ * @return METAGRAPH_SUCCESS or an error code
+ */
+metagraph_result_t metagraph_graph_create(const metagraph_graph_config_t *config,
+                                          metagraph_graph_t **out_graph);
+
+/**
+ * @brief Destroy a graph and release all graph-owned memory
+ * @param graph Graph to destroy (NULL is ignored)
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t metagraph_graph_destroy(metagraph_graph_t *graph);
+
+// ============================================================================
+// Mutation
+// ============================================================================
+
+/**
+ * @brief Add a node
+ * @param graph Target graph
+ * @param metadata Node description
+ * @param out_index Receives the node index (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_EXISTS if the ID is taken,
+ *         METAGRAPH_ERROR_MAX_NODES_EXCEEDED if the node limit is reached
+ */
+metagraph_result_t
+metagraph_graph_add_node(metagraph_graph_t *graph,
+                         const metagraph_node_metadata_t *metadata,
+                         metagraph_node_index_t *out_index);
+
+/**
+ * @brief Add a hyperedge between existing nodes
+ * @param graph Target graph
+ * @param metadata Edge description (node_count >= 2)
+ * @param out_index Receives the edge index (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND if a referenced
+ *         node does not exist, METAGRAPH_ERROR_EDGE_EXISTS if the ID is taken,
+ *         METAGRAPH_ERROR_MAX_EDGES_EXCEEDED if the edge limit is reached
+ */
+metagraph_result_t
+metagraph_graph_add_edge(metagraph_graph_t *graph,
+                         const metagraph_edge_metadata_t *metadata,
+                         metagraph_edge_index_t *out_index);
+
+// ============================================================================
+// Lookup
+// ============================================================================
+
+/**
+ * @brief Resolve a node ID to its index
+ * @param graph Graph to search
+ * @param node_id ID to look up
+ * @param out_index Receives the node index
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND
+ */
+metagraph_result_t metagraph_graph_find_node(const metagraph_graph_t *graph,
+                                             metagraph_id_t node_id,
+                                             metagraph_node_index_t *out_index);
+
+/**
+ * @brief Resolve an edge ID to its index
+ * @param graph Graph to search
+ * @param edge_id ID to look up
+ * @param out_index Receives the edge index
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_EDGE_NOT_FOUND
+ */
+metagraph_result_t metagraph_graph_find_edge(const metagraph_graph_t *graph,
+                                             metagraph_id_t edge_id,
+                                             metagraph_edge_index_t *out_index);
+
+/**
+ * @brief Resolve many node IDs in one call
+ *
+ * Gives the same indices as metagraph_graph_find_node() per ID, but the
+ * table lines for a small group of IDs are prefetched before any of them
+ * is probed, so the group's cache misses overlap instead of following one
+ * another. IDs not in the graph resolve to METAGRAPH_INVALID_INDEX.
+ *
+ * @param graph Graph to search
+ * @param node_ids IDs to look up
+ * @param count Entries in node_ids and out_indices
+ * @param out_indices Receives each ID's node index
+ * @param out_found Receives how many IDs were found (may be NULL)
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NULL_POINTER
+ */
+metagraph_result_t metagraph_graph_find_nodes(
+    const metagraph_graph_t *graph, const metagraph_id_t *node_ids,
+    size_t count, metagraph_node_index_t *out_indices, size_t *out_found);
+
+/**
+ * @brief Resolve many edge IDs in one call
+ *
+ * Same contract as metagraph_graph_find_nodes().
+ */
+metagraph_result_t metagraph_graph_find_edges(
+    const metagraph_graph_t *graph, const metagraph_id_t *edge_ids,
+    size_t count, metagraph_edge_index_t *out_indices, size_t *out_found);
+
+/**
+ * @brief Read a node's metadata
+ *
+ * The returned name points into graph-owned storage and stays valid until
+ * the graph is destroyed.
+ *
+ * @param graph Graph to read
+ * @param node Node index
+ * @param out_metadata Receives the node description
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NODE_NOT_FOUND
+ */
+metagraph_result_t
+metagraph_graph_get_node(const metagraph_graph_t *graph,
+                         metagraph_node_index_t node,
+                         metagraph_node_metadata_t *out_metadata);
+
+/**
+ * @brief Read an edge's metadata
+ *
+ * The nodes field is set to NULL; use metagraph_graph_get_edge_nodes() to
+ * read the member node indices.
+ *
+ * @param graph Graph to read
+ * @param edge Edge index
+ * @param out_metadata Receives the edge description
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_EDGE_NOT_FOUND
+ */
+metagraph_result_t
+metagraph_graph_get_edge(const metagraph_graph_t *graph,
+                         metagraph_edge_index_t edge,
+                         metagraph_edge_metadata_t *out_metadata);
+
+/**
+ * @brief Borrow the member node indices of a hyperedge
+ *
+ * The array starts with the source node. It is valid until the next call
+ * to metagraph_graph_add_edge().
+ *
+ * @param graph Graph to read
+ * @param edge Edge index
+ * @param out_nodes Receives a pointer to the member indices
+ * @param out_count Receives the number of members
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_EDGE_NOT_FOUND
+ */
+metagraph_result_t
+metagraph_graph_get_edge_nodes(const metagraph_graph_t *graph,
+                               metagraph_edge_index_t edge,
+                               const metagraph_node_index_t **out_nodes,
+                               size_t *out_count);
+
+/**
+ * @brief List the edges a node is the source of
+ *
+ * Pass out_edges == NULL to query only the count. Edges are reported in
+ * insertion order.
+ *
+ * @param graph Graph to read
+ * @param node Node index
+ * @param out_edges Caller buffer for edge indices (may be NULL)
+ * @param capacity Capacity of out_edges in elements
+ * @param out_count Receives the number of outgoing edges
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND, or
+ *         METAGRAPH_ERROR_BUFFER_TOO_SMALL (out_count still set)
+ */
+metagraph_result_t
+metagraph_graph_get_outgoing_edges(const metagraph_graph_t *graph,
+                                   metagraph_node_index_t node,
+                                   metagraph_edge_index_t *out_edges,
+                                   size_t capacity, size_t *out_count);
+
+/**
+ * @brief List the edges that target a node
+ *
+ * Same buffer contract as metagraph_graph_get_outgoing_edges().
+ */
+metagraph_result_t
+metagraph_graph_get_incoming_edges(const metagraph_graph_t *graph,
+                                   metagraph_node_index_t node,
+                                   metagraph_edge_index_t *out_edges,
+                                   size_t capacity, size_t *out_count);
+
+/**
+ * @brief Number of nodes in the graph
+ */
+size_t metagraph_graph_node_count(const metagraph_graph_t *graph);
+
+/**
+ * @brief Number of hyperedges in the graph
+ */
+size_t metagraph_graph_edge_count(const metagraph_graph_t *graph);
+
+/**
+ * @brief Collect size and memory statistics
+ * @param graph Graph to inspect
+ * @param out_stats Receives the statistics
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NULL_POINTER
+ */
+metagraph_result_t metagraph_graph_get_stats(const metagraph_graph_t *graph,
+                                             metagraph_graph_stats_t *out_stats);
+
+/**
+ * @brief Compare two IDs for equality
+ */
+static inline bool metagraph_id_equal(metagraph_id_t lhs, metagraph_id_t rhs) {
+    return (bool)((lhs.high == rhs.high) && (lhs.low == rhs.low));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_GRAPH_H
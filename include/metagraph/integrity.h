@@ -0,0 +1,254 @@
+/**
+ * @file integrity.h
+ * @brief BLAKE3 hashing and Merkle trees for content integrity
+ *
+ * Hashing picks the widest SIMD kernel the CPU supports at runtime
+ * (AVX-512, AVX2, SSE4.1, portable) and spreads large inputs across all
+ * online CPUs. BLAKE3 is itself a binary tree over 1 KiB chunks, so the
+ * Merkle trees built here reuse its chaining values: a tree's root hash is
+ * exactly metagraph_blake3_hash() of the data, and any chunk can be checked
+ * without hashing its neighbours.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_INTEGRITY_H
+#define METAGRAPH_INTEGRITY_H
+
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bytes in a BLAKE3 hash
+ */
+#define METAGRAPH_BLAKE3_OUT_LEN 32U
+
+/**
+ * @brief Bytes in a BLAKE3 chunk (the smallest Merkle leaf)
+ */
+#define METAGRAPH_BLAKE3_CHUNK_LEN 1024U
+
+/**
+ * @brief Default Merkle leaf size
+ */
+#define METAGRAPH_MERKLE_DEFAULT_CHUNK_SIZE (64U * 1024U)
+
+/**
+ * @brief Characters needed for a hex hash including the terminator
+ */
+#define METAGRAPH_BLAKE3_HEX_SIZE (2U * METAGRAPH_BLAKE3_OUT_LEN + 1U)
+
+/**
+ * @brief 256-bit BLAKE3 hash
+ */
+typedef struct {
+    uint8_t bytes[METAGRAPH_BLAKE3_OUT_LEN]; ///< Hash bytes
+} metagraph_blake3_hash_t;
+
+/**
+ * @brief BLAKE3 compression kernels
+ */
+typedef enum {
+    METAGRAPH_BLAKE3_PORTABLE, ///< Plain C, one block at a time
+    METAGRAPH_BLAKE3_SSE41,    ///< 4 chunks per pass
+    METAGRAPH_BLAKE3_AVX2,     ///< 8 chunks per pass
+    METAGRAPH_BLAKE3_AVX512    ///< 16 chunks per pass
+} metagraph_blake3_implementation_t;
+
+/**
+ * @brief Streaming hash state
+ */
+typedef struct metagraph_blake3_context metagraph_blake3_context_t;
+
+/**
+ * @brief Hash a buffer
+ *
+ * Inputs of a few MiB or more are split across all online CPUs.
+ */
+metagraph_result_t metagraph_blake3_hash(const void *data, size_t data_size,
+                                         metagraph_blake3_hash_t *out_hash);
+
+/**
+ * @brief Hash a buffer on up to thread_count threads
+ *
+ * @param thread_count Upper bound on threads (0 = online CPUs, 1 = caller
+ *        only)
+ */
+metagraph_result_t
+metagraph_blake3_hash_parallel(const void *data, size_t data_size,
+                               uint32_t thread_count,
+                               metagraph_blake3_hash_t *out_hash);
+
+/**
+ * @brief Hash a buffer and compare against an expected hash
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_CHECKSUM_MISMATCH
+ */
+metagraph_result_t
+metagraph_blake3_verify(const void *data, size_t data_size,
+                        const metagraph_blake3_hash_t *expected_hash);
+
+/**
+ * @brief Start a streaming hash
+ */
+metagraph_result_t
+metagraph_blake3_context_create(metagraph_blake3_context_t **out_context);
+
+/**
+ * @brief Release a streaming hash (NULL is ignored)
+ */
+metagraph_result_t
+metagraph_blake3_context_destroy(metagraph_blake3_context_t *context);
+
+/**
+ * @brief Append data to a streaming hash
+ */
+metagraph_result_t metagraph_blake3_update(metagraph_blake3_context_t *context,
+                                           const void *data, size_t data_size);
+
+/**
+ * @brief Hash of everything appended so far
+ *
+ * Does not modify the context; more data may be appended afterwards.
+ */
+metagraph_result_t
+metagraph_blake3_finalize(const metagraph_blake3_context_t *context,
+                          metagraph_blake3_hash_t *out_hash);
+
+/**
+ * @brief Lowercase hex form of a hash
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_BUFFER_TOO_SMALL when
+ *         buffer_size < METAGRAPH_BLAKE3_HEX_SIZE
+ */
+metagraph_result_t
+metagraph_blake3_hash_to_string(const metagraph_blake3_hash_t *hash,
+                                char *buffer, size_t buffer_size);
+
+/**
+ * @brief Kernel currently used for hashing
+ */
+metagraph_blake3_implementation_t metagraph_blake3_get_implementation(void);
+
+/**
+ * @brief Whether this CPU can run a kernel
+ */
+bool metagraph_blake3_implementation_available(
+    metagraph_blake3_implementation_t implementation);
+
+/**
+ * @brief Force a kernel (for testing and benchmarking)
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE
+ */
+metagraph_result_t metagraph_blake3_set_implementation(
+    metagraph_blake3_implementation_t implementation);
+
+/**
+ * @brief Human-readable kernel name ("portable", "sse4.1", ...)
+ */
+const char *metagraph_blake3_implementation_name(
+    metagraph_blake3_implementation_t implementation);
+
+// ============================================================================
+// Merkle trees
+// ============================================================================
+
+/**
+ * @brief One level of a Merkle tree
+ */
+typedef struct {
+    metagraph_blake3_hash_t *hashes; ///< Chaining values at this level
+    size_t count;                    ///< Nodes at this level
+} metagraph_merkle_level_t;
+
+/**
+ * @brief Merkle tree over fixed-size chunks of a buffer
+ *
+ * levels[0] holds one BLAKE3 chaining value per chunk; each higher level
+ * pairs neighbours left to right and carries an odd last node up
+ * unchanged, matching BLAKE3's own tree shape. root_hash equals
+ * metagraph_blake3_hash() of the whole buffer.
+ */
+typedef struct {
+    metagraph_merkle_level_t *levels; ///< Tree levels, leaves first
+    size_t level_count;               ///< Number of levels
+    size_t chunk_size;                ///< Bytes per leaf (last may be short)
+    size_t data_size;                 ///< Bytes covered by the tree
+    metagraph_blake3_hash_t root_hash; ///< BLAKE3 hash of the data
+} metagraph_merkle_tree_t;
+
+/**
+ * @brief Sibling path from one chunk to the root
+ */
+typedef struct {
+    size_t chunk_index; ///< Chunk the proof is for
+    size_t chunk_count; ///< Leaves in the tree
+    size_t chunk_size;  ///< Bytes per leaf
+    size_t length;      ///< Valid entries in siblings
+    metagraph_blake3_hash_t siblings[64]; ///< Sibling chaining values
+} metagraph_merkle_proof_t;
+
+/**
+ * @brief Build a Merkle tree, hashing chunks on all online CPUs
+ *
+ * @param chunk_size Leaf size: a power of two >= METAGRAPH_BLAKE3_CHUNK_LEN
+ *        (0 = METAGRAPH_MERKLE_DEFAULT_CHUNK_SIZE)
+ */
+metagraph_result_t metagraph_merkle_tree_create(const void *data,
+                                                size_t data_size,
+                                                size_t chunk_size,
+                                                metagraph_merkle_tree_t **out_tree);
+
+/**
+ * @brief Release a tree (NULL is ignored)
+ */
+metagraph_result_t metagraph_merkle_tree_destroy(metagraph_merkle_tree_t *tree);
+
+/**
+ * @brief Check one chunk against its leaf
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_CHECKSUM_MISMATCH or
+ *         METAGRAPH_ERROR_INVALID_ARGUMENT for an out-of-range chunk
+ */
+metagraph_result_t
+metagraph_merkle_tree_verify_chunk(const metagraph_merkle_tree_t *tree,
+                                   size_t chunk_index, const void *chunk_data,
+                                   size_t chunk_size);
+
+/**
+ * @brief Check the chunks covering [offset, offset + size) of data
+ *
+ * data is the start of the buffer the tree was built over; only the
+ * chunks overlapping the range are hashed.
+ */
+metagraph_result_t
+metagraph_merkle_tree_verify_range(const metagraph_merkle_tree_t *tree,
+                                   const void *data, size_t offset,
+                                   size_t size);
+
+/**
+ * @brief Collect the siblings needed to prove one chunk
+ */
+metagraph_result_t
+metagraph_merkle_tree_get_proof(const metagraph_merkle_tree_t *tree,
+                                size_t chunk_index,
+                                metagraph_merkle_proof_t *out_proof);
+
+/**
+ * @brief Check a chunk against a trusted root using only its proof
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_CHECKSUM_MISMATCH
+ */
+metagraph_result_t
+metagraph_merkle_verify_proof(const void *chunk_data, size_t chunk_size,
+                              const metagraph_merkle_proof_t *proof,
+                              const metagraph_blake3_hash_t *root_hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_INTEGRITY_H
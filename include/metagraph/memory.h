@@ -0,0 +1,276 @@
+/**
+ * @file memory.h
+ * @brief Arena, fixed-size object pool and thread-local pool allocators
+ *
+ * Three allocators cover the library's allocation patterns:
+ *
+ * - Arena pools hand out memory by bumping a pointer through a chain of
+ *   blocks. Individual frees are no-ops; a checkpoint captures the bump
+ *   position and restoring it (or resetting the arena) releases everything
+ *   allocated since in O(1), without returning blocks to the system.
+ * - Object pools hand out fixed-size slots carved from slabs and recycle
+ *   them through an intrusive free list. They are safe to share between
+ *   threads.
+ * - Thread-local pools serve small variable-size requests from size classes.
+ *   Each thread keeps a magazine of free slots per class, so the common
+ *   alloc/free path takes no lock; magazines refill from and flush to a
+ *   shared depot in batches.
+ *
+ * Arena and object pools can be bound to a NUMA node so their blocks stay
+ * next to the threads that use them (see numa.h).
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_MEMORY_H
+#define METAGRAPH_MEMORY_H
+
+#include "metagraph/numa.h"
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Allocation strategy of a memory pool
+ */
+typedef enum {
+    METAGRAPH_POOL_TYPE_OBJECT, ///< Fixed-size object slots
+    METAGRAPH_POOL_TYPE_ARENA   ///< Bump allocation, bulk release
+} metagraph_pool_type_t;
+
+/**
+ * @brief Memory pool configuration
+ *
+ * Zero fields take defaults: a 64 KiB initial size, no size limit and
+ * 16-byte alignment. object_size is required for object pools and ignored
+ * otherwise.
+ */
+typedef struct {
+    metagraph_pool_type_t type; ///< Allocation strategy
+    size_t initial_size;        ///< Bytes reserved up front (block/slab size)
+    size_t max_size;            ///< Upper bound on reserved bytes (0 = none)
+    size_t alignment;           ///< Default alignment (power of two)
+    size_t object_size;         ///< Slot size for object pools
+    bool allow_growth;          ///< Reserve more blocks once initial is used
+} metagraph_pool_config_t;
+
+/**
+ * @brief Opaque memory pool (arena or object pool)
+ */
+typedef struct metagraph_memory_pool metagraph_memory_pool_t;
+
+/**
+ * @brief Saved arena bump position
+ *
+ * Only valid for the arena it was taken from, and only until that arena is
+ * reset or restored to an earlier checkpoint.
+ */
+typedef struct {
+    void *block;  ///< Block that was current when the checkpoint was taken
+    size_t used;  ///< Bytes used in that block
+    size_t bytes; ///< Live allocation bytes at checkpoint time
+} metagraph_arena_checkpoint_t;
+
+/**
+ * @brief Memory pool statistics
+ */
+typedef struct {
+    size_t total_size;           ///< Bytes reserved from the system
+    size_t allocated_size;       ///< Bytes currently handed out
+    size_t free_size;            ///< Reserved bytes not handed out
+    size_t largest_free_block;   ///< Largest request satisfiable now
+    uint64_t allocation_count;   ///< Allocations since last stats reset
+    uint64_t deallocation_count; ///< Frees since last stats reset
+    uint64_t growth_count;       ///< Blocks/slabs reserved since last reset
+    double fragmentation_ratio;  ///< 1 - largest_free_block / free_size
+    double utilization_ratio;    ///< allocated_size / total_size
+} metagraph_pool_stats_t;
+
+/**
+ * @brief Create a memory pool
+ *
+ * @param config Pool configuration
+ * @param[out] out_pool Receives the new pool
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_SIZE for an object pool
+ *         without an object size, METAGRAPH_ERROR_INVALID_ALIGNMENT_VALUE
+ *         or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_memory_pool_create(const metagraph_pool_config_t *config,
+                             metagraph_memory_pool_t **out_pool);
+
+/**
+ * @brief Destroy a pool and release every block it reserved
+ *
+ * Pointers handed out by the pool become invalid.
+ */
+metagraph_result_t metagraph_memory_pool_destroy(metagraph_memory_pool_t *pool);
+
+/**
+ * @brief Allocate size bytes at the pool's default alignment
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_POOL_EXHAUSTED when the pool
+ *         cannot reserve more memory within max_size,
+ *         METAGRAPH_ERROR_FRAGMENTATION when an arena that cannot grow has
+ *         enough free bytes but none contiguous, METAGRAPH_ERROR_INVALID_SIZE
+ *         when size exceeds an object pool's slot size
+ */
+metagraph_result_t metagraph_memory_pool_alloc(metagraph_memory_pool_t *pool,
+                                               size_t size, void **out_ptr);
+
+/**
+ * @brief Allocate size bytes aligned to a power-of-two alignment
+ *
+ * Object pools only satisfy alignments up to the one they were created
+ * with.
+ */
+metagraph_result_t
+metagraph_memory_pool_aligned_alloc(metagraph_memory_pool_t *pool, size_t size,
+                                    size_t alignment, void **out_ptr);
+
+/**
+ * @brief Return memory to a pool
+ *
+ * Object pools recycle the slot. Arenas only reclaim the space if ptr was
+ * the most recent allocation; otherwise it is released by the next
+ * reset or restore. NULL is accepted.
+ */
+metagraph_result_t metagraph_memory_pool_free(metagraph_memory_pool_t *pool,
+                                              void *ptr);
+
+/**
+ * @brief Take one slot from an object pool
+ */
+metagraph_result_t metagraph_object_pool_acquire(metagraph_memory_pool_t *pool,
+                                                 void **out_object);
+
+/**
+ * @brief Return a slot to an object pool
+ */
+metagraph_result_t metagraph_object_pool_release(metagraph_memory_pool_t *pool,
+                                                 void *object);
+
+/**
+ * @brief Release every arena allocation in O(1)
+ *
+ * Reserved blocks are kept and reused by later allocations.
+ */
+metagraph_result_t metagraph_arena_reset(metagraph_memory_pool_t *arena);
+
+/**
+ * @brief Record the arena's current bump position
+ */
+metagraph_result_t
+metagraph_arena_checkpoint(metagraph_memory_pool_t *arena,
+                           metagraph_arena_checkpoint_t *out_checkpoint);
+
+/**
+ * @brief Release every allocation made after a checkpoint in O(1)
+ */
+metagraph_result_t
+metagraph_arena_restore(metagraph_memory_pool_t *arena,
+                        const metagraph_arena_checkpoint_t *checkpoint);
+
+/**
+ * @brief Snapshot pool statistics
+ */
+metagraph_result_t
+metagraph_memory_pool_get_stats(const metagraph_memory_pool_t *pool,
+                                metagraph_pool_stats_t *out_stats);
+
+/**
+ * @brief Zero the allocation, deallocation and growth counters
+ */
+metagraph_result_t
+metagraph_memory_pool_reset_stats(metagraph_memory_pool_t *pool);
+
+/**
+ * @brief Prefer a NUMA node for the pool's memory
+ *
+ * Blocks or slabs already reserved are bound (and their touched pages
+ * migrated) now; later ones are bound as they are reserved.
+ * METAGRAPH_NUMA_NODE_ANY drops the preference for future blocks without
+ * moving existing ones. Arena pools are not thread-safe, so bind them
+ * while no other thread allocates from them.
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_ARGUMENT for a node
+ *         outside the topology, or the topology source's bind error
+ */
+metagraph_result_t
+metagraph_memory_pool_bind_numa(metagraph_memory_pool_t *pool, uint32_t node);
+
+/**
+ * @brief Node the pool prefers (METAGRAPH_NUMA_NODE_ANY when unbound)
+ */
+metagraph_result_t
+metagraph_memory_pool_get_numa_node(const metagraph_memory_pool_t *pool,
+                                    uint32_t *out_node);
+
+/**
+ * @brief Largest request a thread-local pool serves from its size classes
+ *
+ * Bigger requests get a dedicated slab of their own and take the pool lock.
+ */
+#define METAGRAPH_THREAD_LOCAL_MAX_SMALL_SIZE 8192U
+
+/**
+ * @brief Opaque thread-local pool
+ */
+typedef struct metagraph_thread_local_pool metagraph_thread_local_pool_t;
+
+/**
+ * @brief Create a thread-local pool
+ *
+ * Only max_size and alignment are used from config (NULL = defaults).
+ * Alignment may not exceed 64 bytes.
+ */
+metagraph_result_t
+metagraph_thread_local_pool_create(const metagraph_pool_config_t *config,
+                                   metagraph_thread_local_pool_t **out_pool);
+
+/**
+ * @brief Destroy a thread-local pool and every thread's magazines
+ *
+ * No thread may use the pool concurrently with or after this call.
+ */
+metagraph_result_t
+metagraph_thread_local_pool_destroy(metagraph_thread_local_pool_t *pool);
+
+/**
+ * @brief Allocate from the calling thread's magazines
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_POOL_EXHAUSTED when refilling
+ *         would exceed max_size, METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_thread_local_alloc(metagraph_thread_local_pool_t *pool, size_t size,
+                             void **out_ptr);
+
+/**
+ * @brief Free memory from any thread into the calling thread's magazines
+ *
+ * NULL is accepted.
+ */
+metagraph_result_t
+metagraph_thread_local_free(metagraph_thread_local_pool_t *pool, void *ptr);
+
+/**
+ * @brief Return the calling thread's cached slots to the shared depot
+ *
+ * Worker threads call this before exiting so their magazines do not strand
+ * memory until the pool is destroyed.
+ */
+metagraph_result_t
+metagraph_thread_local_pool_flush(metagraph_thread_local_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_MEMORY_H
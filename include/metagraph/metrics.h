@@ -0,0 +1,141 @@
+/**
+ * @file metrics.h
+ * @brief Process-wide runtime counters and latency histograms
+ *
+ * Every subsystem reports into one registry: lookups, section hydrations
+ * and the page faults taken while hydrating, pool allocations, traversal
+ * steps, and each error code reported through METAGRAPH_ERR(). Values are
+ * kept in per-thread shards that only their owning thread writes, so an
+ * event costs a thread-local load and a plain add; a snapshot merges the
+ * shards on read. Shards of exited threads are handed to new threads
+ * rather than freed, so nothing recorded is ever lost.
+ *
+ * Counters only grow. To measure an interval, take two snapshots and
+ * subtract; exporters can publish the totals as monotonic counters.
+ *
+ * Histograms are log-linear in the style of HdrHistogram: values below 32
+ * have their own bucket, and every power of two above that is split into
+ * 16 buckets, so a bucket's width is at most 1/16 of its lower bound.
+ * Values are nanoseconds. Lookups are timed on one call in 64 per thread;
+ * hydrations and traversals, which are much rarer, are always timed.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_METRICS_H
+#define METAGRAPH_METRICS_H
+
+#include "metagraph/result.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Event counters
+ */
+typedef enum {
+    METAGRAPH_COUNTER_LOOKUPS = 0,     ///< Node and edge lookups by ID or path
+    METAGRAPH_COUNTER_HYDRATIONS,      ///< Bundle section views built
+    METAGRAPH_COUNTER_MINOR_FAULTS,    ///< Minor page faults during hydration
+    METAGRAPH_COUNTER_MAJOR_FAULTS,    ///< Major page faults during hydration
+    METAGRAPH_COUNTER_POOL_ALLOCS,     ///< Memory and object pool allocations
+    METAGRAPH_COUNTER_TRAVERSAL_STEPS, ///< Nodes expanded by traversals
+    METAGRAPH_COUNTER_ERRORS,          ///< Errors reported, of any code
+    METAGRAPH_COUNTER_COUNT
+} metagraph_counter_t;
+
+/**
+ * @brief Latency histograms
+ */
+typedef enum {
+    METAGRAPH_HISTOGRAM_LOOKUP = 0, ///< Sampled bundle lookup latency
+    METAGRAPH_HISTOGRAM_HYDRATION,  ///< Section hydration latency
+    METAGRAPH_HISTOGRAM_TRAVERSAL,  ///< Whole traversal latency
+    METAGRAPH_HISTOGRAM_COUNT
+} metagraph_histogram_t;
+
+/// Buckets per histogram; the last one also holds every larger value
+#define METAGRAPH_METRICS_BUCKETS 592U
+
+/// Error code slots: ten categories of 16 codes each
+#define METAGRAPH_METRICS_ERROR_SLOTS 160U
+
+/**
+ * @brief Merged histogram
+ */
+typedef struct {
+    uint64_t count; ///< Values recorded
+    uint64_t sum;   ///< Sum of the values recorded
+    uint64_t buckets[METAGRAPH_METRICS_BUCKETS];
+} metagraph_histogram_snapshot_t;
+
+/**
+ * @brief Merged view of every shard
+ *
+ * Large (about 15 KiB); avoid placing it on small thread stacks.
+ */
+typedef struct {
+    uint64_t counters[METAGRAPH_COUNTER_COUNT];
+    metagraph_histogram_snapshot_t histograms[METAGRAPH_HISTOGRAM_COUNT];
+    uint64_t errors[METAGRAPH_METRICS_ERROR_SLOTS]; ///< See error_count()
+    uint32_t shard_count; ///< Shards merged (threads that ever reported)
+} metagraph_metrics_snapshot_t;
+
+/**
+ * @brief Merge every thread's shard into a snapshot
+ *
+ * Values recorded concurrently may or may not be included; each value is
+ * read atomically, but the snapshot as a whole is not a single instant.
+ *
+ * @param out_snapshot Receives the merged values
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_NULL_POINTER
+ */
+metagraph_result_t
+metagraph_metrics_snapshot(metagraph_metrics_snapshot_t *out_snapshot);
+
+/**
+ * @brief Times an error code was reported
+ *
+ * Codes whose last two digits are 15 or more share their hundred's last
+ * slot; every code defined today has a slot of its own.
+ */
+uint64_t
+metagraph_metrics_error_count(const metagraph_metrics_snapshot_t *snapshot,
+                              metagraph_result_t code);
+
+/**
+ * @brief Smallest value that falls in a histogram bucket
+ */
+uint64_t metagraph_metrics_bucket_lower_bound(uint32_t bucket);
+
+/**
+ * @brief Estimate a quantile of a merged histogram
+ *
+ * Returns the lower bound of the bucket holding the quantile, which is
+ * within 1/16 below the true value. Returns 0 for an empty histogram.
+ *
+ * @param histogram Merged histogram
+ * @param quantile Fraction in [0, 1]; 0.99 gives the 99th percentile
+ */
+uint64_t
+metagraph_metrics_quantile(const metagraph_histogram_snapshot_t *histogram,
+                           double quantile);
+
+/**
+ * @brief Name of a counter, for exporters ("lookups", "hydrations", ...)
+ */
+const char *metagraph_metrics_counter_name(metagraph_counter_t counter);
+
+/**
+ * @brief Name of a histogram, for exporters ("lookup_ns", ...)
+ */
+const char *metagraph_metrics_histogram_name(metagraph_histogram_t histogram);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_METRICS_H
@@ -0,0 +1,262 @@
+/**
+ * @file mmap.h
+ * @brief Memory-mapped file access and offset pointer hydration
+ *
+ * Bundles store relative offsets instead of pointers. A mapping turns an
+ * offset into a live pointer only when it is first dereferenced, after
+ * checking that the whole referenced range lies inside the mapping.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_MMAP_H
+#define METAGRAPH_MMAP_H
+
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Access flags for a mapping request
+ */
+typedef enum {
+    METAGRAPH_MAP_ACCESS_READ = 1U << 0U,  ///< Map for reading
+    METAGRAPH_MAP_ACCESS_WRITE = 1U << 1U, ///< Map for writing (shared)
+} metagraph_map_access_flags_t;
+
+/**
+ * @brief Caching hints for a mapping request
+ */
+typedef enum {
+    METAGRAPH_MAP_CACHE_DEFAULT = 0,        ///< Let the OS fault pages lazily
+    METAGRAPH_MAP_CACHE_POPULATE = 1U << 0U, ///< Prefault the whole range
+} metagraph_map_cache_flags_t;
+
+/**
+ * @brief Memory access advice for a mapped range
+ */
+typedef enum {
+    METAGRAPH_ADVICE_NORMAL,     ///< Normal access pattern
+    METAGRAPH_ADVICE_SEQUENTIAL, ///< Sequential access expected
+    METAGRAPH_ADVICE_RANDOM,     ///< Random access expected
+    METAGRAPH_ADVICE_WILLNEED,   ///< Will be needed soon
+    METAGRAPH_ADVICE_DONTNEED,   ///< Won't be needed soon
+    METAGRAPH_ADVICE_NOREUSE,    ///< Won't be reused
+    METAGRAPH_ADVICE_HUGEPAGE,   ///< Back with transparent huge pages
+    METAGRAPH_ADVICE_NOHUGEPAGE, ///< Keep to base pages
+    METAGRAPH_ADVICE_COLD,       ///< Reclaim before other pages
+    METAGRAPH_ADVICE_PAGEOUT     ///< Reclaim now
+} metagraph_memory_advice_t;
+
+/**
+ * @brief Which part of a file to map and how
+ *
+ * A size of zero maps from offset to the end of the file.
+ */
+typedef struct {
+    uint64_t offset;       ///< File offset (rounded down to a page)
+    size_t size;           ///< Bytes to map (0 = to end of file)
+    uint32_t access_flags; ///< metagraph_map_access_flags_t bits
+    uint32_t cache_flags;  ///< metagraph_map_cache_flags_t bits
+} metagraph_mapping_request_t;
+
+/**
+ * @brief A mapped region of a file or of caller-provided memory
+ *
+ * base_address points at the requested offset, not at the page boundary
+ * the OS mapped from.
+ */
+typedef struct {
+    void *base_address;    ///< First byte of the requested range
+    size_t mapped_size;    ///< Bytes addressable from base_address
+    size_t file_size;      ///< Size of the underlying file (or buffer)
+    bool is_writable;      ///< Mapping permits writes
+    bool is_coherent;      ///< Backed by the page cache (file mapping)
+    void *platform_handle; ///< Platform mapping bookkeeping
+} metagraph_memory_map_t;
+
+/**
+ * @brief Serialized reference into a mapping, hydrated on first use
+ *
+ * Not thread-safe: each thread should hydrate its own copy, or the
+ * owner must serialize first access.
+ */
+typedef struct {
+    uint64_t offset;       ///< Offset from the mapping base
+    uint64_t size;         ///< Bytes the pointer must be able to address
+    void *cached_pointer;  ///< Hydrated pointer (valid once is_hydrated)
+    bool is_hydrated;      ///< Whether cached_pointer has been computed
+    uint32_t access_count; ///< Number of hydrate calls served
+} metagraph_offset_pointer_t;
+
+/**
+ * @brief Byte range of a mapping, relative to base_address
+ */
+typedef struct {
+    uint64_t offset; ///< Offset from base_address
+    uint64_t size;   ///< Bytes in the range
+} metagraph_map_range_t;
+
+/**
+ * @brief Read-ahead flags
+ */
+typedef enum {
+    METAGRAPH_READ_AHEAD_DEFAULT = 0,
+    /// Use the pread threads even where io_uring is available
+    METAGRAPH_READ_AHEAD_NO_URING = 1U << 0U,
+} metagraph_read_ahead_flags_t;
+
+/**
+ * @brief How a read-ahead was carried out
+ */
+typedef enum {
+    METAGRAPH_READ_AHEAD_NONE,  ///< Nothing to read (memory or empty ranges)
+    METAGRAPH_READ_AHEAD_URING, ///< Batched io_uring reads
+    METAGRAPH_READ_AHEAD_PREAD, ///< pread() on a thread team
+} metagraph_read_ahead_backend_t;
+
+/**
+ * @brief Read-ahead options (NULL selects defaults)
+ */
+typedef struct {
+    uint32_t flags;        ///< metagraph_read_ahead_flags_t bits
+    uint32_t queue_depth;  ///< io_uring reads in flight (0 = 16)
+    uint32_t chunk_size;   ///< Bytes per read, rounded up to a page
+                           ///< (0 = 256 KiB)
+    uint32_t thread_count; ///< pread threads (0 = one per CPU, the maximum)
+} metagraph_read_ahead_options_t;
+
+/**
+ * @brief What a read-ahead did
+ */
+typedef struct {
+    uint64_t bytes_read; ///< Bytes read from the file
+    uint64_t reads;      ///< Read requests completed
+    metagraph_read_ahead_backend_t backend;
+} metagraph_read_ahead_stats_t;
+
+/**
+ * @brief Map a file
+ * @param file_path Path of the file to map
+ * @param request Range and flags (NULL maps the whole file read-only)
+ * @param out_map Receives the new mapping
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_FILE_NOT_FOUND,
+ *         METAGRAPH_ERROR_FILE_ACCESS_DENIED, METAGRAPH_ERROR_IO_FAILURE or
+ *         METAGRAPH_ERROR_MMAP_FAILED
+ */
+metagraph_result_t
+metagraph_mmap_create_from_file(const char *file_path,
+                                const metagraph_mapping_request_t *request,
+                                metagraph_memory_map_t **out_map);
+
+/**
+ * @brief Wrap caller-owned memory in a mapping object
+ *
+ * The buffer is borrowed and must outlive the mapping.
+ */
+metagraph_result_t metagraph_mmap_create_from_memory(
+    void *buffer, size_t size, bool writable, metagraph_memory_map_t **out_map);
+
+/**
+ * @brief Unmap and free a mapping (NULL is ignored)
+ */
+metagraph_result_t metagraph_mmap_destroy(metagraph_memory_map_t *map);
+
+/**
+ * @brief Flush a writable file mapping range to storage
+ */
+metagraph_result_t metagraph_mmap_sync(metagraph_memory_map_t *map,
+                                       uint64_t offset, size_t size);
+
+/**
+ * @brief Pass an access-pattern hint for a range to the OS
+ *
+ * Hints are advisory; ranges are widened to page boundaries. Memory
+ * mappings created from caller buffers accept and ignore advice.
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_SIZE for a range
+ *         outside the mapping, METAGRAPH_ERROR_PLATFORM_NOT_SUPPORTED when
+ *         the OS has no such advice (HUGEPAGE, NOHUGEPAGE, COLD and PAGEOUT
+ *         need Linux 5.4, and HUGEPAGE on a file mapping needs
+ *         CONFIG_READ_ONLY_THP_FOR_FS) or METAGRAPH_ERROR_IO_FAILURE
+ */
+metagraph_result_t metagraph_mmap_advise(metagraph_memory_map_t *map,
+                                         uint64_t offset, size_t size,
+                                         metagraph_memory_advice_t advice);
+
+/**
+ * @brief Count the pages of a range that are resident in memory
+ *
+ * The range is widened to page boundaries. Mappings created from caller
+ * buffers, and platforms without mincore(), report every page resident.
+ *
+ * @param out_resident Receives the resident page count
+ * @param out_pages Receives the page count of the widened range
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_SIZE for a range
+ *         outside the mapping, METAGRAPH_ERROR_OUT_OF_MEMORY or
+ *         METAGRAPH_ERROR_IO_FAILURE
+ */
+metagraph_result_t metagraph_mmap_residency(const metagraph_memory_map_t *map,
+                                            uint64_t offset, size_t size,
+                                            size_t *out_resident,
+                                            size_t *out_pages);
+
+/**
+ * @brief Read ranges of a file mapping into the page cache ahead of use
+ *
+ * Faulting a cold mapping reads one fault's worth of pages at a time on
+ * the faulting thread. This instead issues large reads in batches: through
+ * io_uring with registered buffers where the kernel allows it, otherwise
+ * with pread() on a thread team. The data read is discarded; later faults
+ * on the mapping find it in the page cache. Ranges are widened to pages,
+ * merged and clipped to the mapping. Mappings created from caller buffers
+ * have nothing to read.
+ *
+ * @param out_stats Receives what was done (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_SIZE for a range
+ *         outside the mapping, METAGRAPH_ERROR_IO_FAILURE,
+ *         METAGRAPH_ERROR_OUT_OF_MEMORY or a thread error
+ */
+metagraph_result_t
+metagraph_mmap_read_ahead(const metagraph_memory_map_t *map,
+                          const metagraph_map_range_t *ranges, size_t count,
+                          const metagraph_read_ahead_options_t *options,
+                          metagraph_read_ahead_stats_t *out_stats);
+
+/**
+ * @brief Check that [pointer, pointer + required_size) lies in the mapping
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_BUNDLE_CORRUPTED
+ */
+metagraph_result_t metagraph_validate_pointer(const metagraph_memory_map_t *map,
+                                              const void *pointer,
+                                              size_t required_size);
+
+/**
+ * @brief Turn an offset pointer into a live pointer, validating bounds once
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_BUNDLE_CORRUPTED
+ */
+metagraph_result_t metagraph_hydrate_pointer(const metagraph_memory_map_t *map,
+                                             metagraph_offset_pointer_t *offset_ptr,
+                                             void **out_pointer);
+
+/**
+ * @brief Hydrate many offset pointers at once
+ *
+ * Stops at the first pointer that fails validation.
+ */
+metagraph_result_t
+metagraph_hydrate_pointer_batch(const metagraph_memory_map_t *map,
+                                metagraph_offset_pointer_t *offset_ptrs,
+                                size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_MMAP_H
@@ -0,0 +1,104 @@
+/**
+ * @file numa.h
+ * @brief NUMA topology, thread placement queries and memory binding
+ *
+ * Everything goes through a topology source. The system source reads the
+ * node layout from sysfs, asks getcpu() where the calling thread runs and
+ * binds memory with mbind(); on other platforms, and on kernels without
+ * NUMA support, it reports a single node and binding does nothing. A
+ * custom source can stand in for it, for example to exercise placement
+ * with a fake multi-node machine on a single-node host.
+ *
+ * Placement is a preference: binding asks the kernel to keep pages on a
+ * node and to migrate pages already touched, but memory is still handed
+ * out from other nodes when the preferred one is full.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_NUMA_H
+#define METAGRAPH_NUMA_H
+
+#include "metagraph/result.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Node value meaning "no preference"
+ */
+#define METAGRAPH_NUMA_NODE_ANY UINT32_MAX
+
+/**
+ * @brief Which node each CPU belongs to
+ */
+typedef struct {
+    uint32_t node_count;       ///< Nodes, at least 1
+    uint32_t cpu_count;        ///< Entries in cpu_nodes
+    const uint32_t *cpu_nodes; ///< Node of each CPU, below node_count
+} metagraph_numa_topology_t;
+
+/**
+ * @brief Where topology, thread placement and binding come from
+ *
+ * All three callbacks are required and may be called from any thread.
+ */
+typedef struct {
+    /// Describe the machine; the arrays must stay valid while the source
+    /// is installed
+    metagraph_result_t (*get_topology)(void *context,
+                                       metagraph_numa_topology_t *out);
+    /// Node the calling thread is running on
+    uint32_t (*current_node)(void *context);
+    /// Prefer node for the pages of [address, address + size), which is
+    /// page-aligned
+    metagraph_result_t (*bind)(void *context, void *address, size_t size,
+                               uint32_t node);
+    void *context; ///< Passed to every callback
+} metagraph_numa_source_t;
+
+/**
+ * @brief Install a topology source (NULL restores the system source)
+ *
+ * The source is copied. Install it before other threads use the library;
+ * placement decided under the previous source is not revisited.
+ *
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_INVALID_ARGUMENT for a
+ *         source with a missing callback
+ */
+metagraph_result_t
+metagraph_numa_set_source(const metagraph_numa_source_t *source);
+
+/**
+ * @brief Describe the machine through the installed source
+ */
+metagraph_result_t
+metagraph_get_numa_topology(metagraph_numa_topology_t *out_topology);
+
+/**
+ * @brief Node the calling thread runs on (0 when unknown)
+ */
+uint32_t metagraph_numa_current_node(void);
+
+/**
+ * @brief Prefer a node for the whole pages inside [address, address + size)
+ *
+ * Partial pages at either end are left alone, so neighbouring allocations
+ * keep their placement.
+ *
+ * @return METAGRAPH_SUCCESS (also when no whole page is covered),
+ *         METAGRAPH_ERROR_INVALID_ARGUMENT for a node outside the
+ *         topology or the source's error
+ */
+metagraph_result_t metagraph_numa_bind(void *address, size_t size,
+                                       uint32_t node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_NUMA_H
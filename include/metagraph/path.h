@@ -0,0 +1,55 @@
+/**
+ * @file path.h
+ * @brief Asset path normalization
+ *
+ * Bundles index nodes by their name treated as an asset path, so paths are
+ * normalized before they are hashed: the writer normalizes every node name
+ * and lookups normalize the query, and two spellings of the same path find
+ * the same node.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_PATH_H
+#define METAGRAPH_PATH_H
+
+#include "metagraph/result.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Longest path, excluding the terminator, that can be normalized
+ */
+#define METAGRAPH_PATH_MAX 4096U
+
+/**
+ * @brief Normalize a '/'-separated asset path
+ *
+ * Repeated separators collapse, "." segments are dropped, ".." removes the
+ * preceding segment and a trailing separator is removed. A leading '/' is
+ * kept, so "/" stays "/", and a relative path that normalizes to nothing
+ * becomes ".". Paths that are already normal are copied after a
+ * vectorized scan.
+ *
+ * @param path NUL-terminated path
+ * @param out_path Receives the NUL-terminated normalized path
+ * @param out_size Capacity of out_path in bytes
+ * @param out_length Receives the normalized length (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_ARGUMENT for an empty
+ *         path or one whose ".." segments escape the root,
+ *         METAGRAPH_ERROR_INVALID_SIZE for a path longer than
+ *         METAGRAPH_PATH_MAX or METAGRAPH_ERROR_BUFFER_TOO_SMALL
+ */
+metagraph_result_t metagraph_path_normalize(const char *path, char *out_path,
+                                            size_t out_size,
+                                            size_t *out_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_PATH_H
@@ -0,0 +1,143 @@
+/**
+ * @file residency.h
+ * @brief Adaptive page advice and huge-page policy for mapped bundles
+ *
+ * A residency policy watches how a bundle is read and keeps the kernel's
+ * paging advice in step with it. Accessors count reads per section while
+ * a policy is attached; each metagraph_residency_tune() call closes an
+ * interval, samples which pages are resident, and re-advises every section
+ * the bundle holds:
+ *
+ * - hot sections read mostly in order get MADV_SEQUENTIAL;
+ * - hot sections read out of order that are still faulting pages in get
+ *   MADV_WILLNEED, and MADV_RANDOM once they stop faulting;
+ * - lightly used sections go back to MADV_NORMAL; idle ones keep their
+ *   advice.
+ *
+ * The STORE is also tracked in 2 MiB ranges. Ranges left unread for a few
+ * intervals are advised MADV_COLD, and optionally MADV_PAGEOUT later, so
+ * cold payloads make room for the tables lookups depend on. With huge
+ * pages enabled, the INDEX, LOOKUP and EDGES sections are advised
+ * MADV_HUGEPAGE when the policy attaches, cutting TLB misses on their
+ * random probes.
+ *
+ * Advice the OS does not offer is skipped and reported. Sections an
+ * applied delta inherits belong to its base and are not tuned, and a
+ * compressed STORE is read from its decoded copy, so its ranges are not
+ * tracked.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_RESIDENCY_H
+#define METAGRAPH_RESIDENCY_H
+
+#include "metagraph/bundle.h"
+#include "metagraph/mmap.h"
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Opaque residency policy attached to one bundle
+ */
+typedef struct metagraph_residency metagraph_residency_t;
+
+/**
+ * @brief Residency policy flags
+ */
+typedef enum {
+    METAGRAPH_RESIDENCY_DEFAULT = 0,
+    /// Advise INDEX, LOOKUP and EDGES to use transparent huge pages
+    METAGRAPH_RESIDENCY_HUGE_PAGES = 1U << 0U,
+    /// Page out STORE ranges that stay cold
+    METAGRAPH_RESIDENCY_PAGEOUT = 1U << 1U,
+} metagraph_residency_flags_t;
+
+/**
+ * @brief Residency policy parameters (NULL or zero fields select defaults)
+ */
+typedef struct {
+    uint32_t flags;             ///< metagraph_residency_flags_t bits
+    uint32_t hot_accesses;      ///< Accesses per interval that make a
+                                ///< section hot (0 = 64)
+    uint32_t cold_intervals;    ///< Idle intervals before a STORE range is
+                                ///< advised cold (0 = 2)
+    uint32_t pageout_intervals; ///< Further idle intervals before a cold
+                                ///< range is paged out (0 = 4)
+} metagraph_residency_policy_t;
+
+/**
+ * @brief What one tuning interval saw for a section
+ */
+typedef struct {
+    bool present;            ///< The bundle holds this section itself
+    bool huge_pages;         ///< Huge-page advice was accepted
+    uint64_t accesses;       ///< Reads counted in the interval
+    uint64_t sequential;     ///< Reads that continued the previous one
+    uint64_t resident_pages; ///< Pages resident at the end of the interval
+    uint64_t total_pages;    ///< Pages the section spans
+    uint64_t faults;         ///< Pages that became resident in the interval
+    metagraph_memory_advice_t advice; ///< Advice in force after tuning
+} metagraph_residency_section_report_t;
+
+/**
+ * @brief Result of one tuning interval
+ */
+typedef struct {
+    /// Indexed by metagraph_section_type_t
+    metagraph_residency_section_report_t
+        sections[METAGRAPH_SECTION_TYPE_COUNT];
+    uint64_t store_ranges;     ///< STORE ranges tracked
+    uint64_t cold_ranges;      ///< Of which advised cold
+    uint64_t paged_out_ranges; ///< Of which paged out
+    uint32_t advice_calls;     ///< Advice issued by this interval
+    uint32_t unsupported;      ///< Advice the OS declined as unsupported
+} metagraph_residency_report_t;
+
+/**
+ * @brief Attach a residency policy to a bundle
+ *
+ * One policy may be attached to a bundle at a time, and it must be
+ * destroyed before the bundle.
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_ARGUMENT when the
+ *         bundle already has a policy, METAGRAPH_ERROR_OUT_OF_MEMORY or an
+ *         advice error
+ */
+metagraph_result_t
+metagraph_residency_create(const metagraph_bundle_t *bundle,
+                           const metagraph_residency_policy_t *policy,
+                           metagraph_residency_t **out_residency);
+
+/**
+ * @brief Detach a policy (NULL is ignored)
+ *
+ * Access-pattern advice goes back to MADV_NORMAL; huge-page advice and
+ * ranges already paged out are left as they are.
+ */
+void metagraph_residency_destroy(metagraph_residency_t *residency);
+
+/**
+ * @brief Close an interval and re-advise the bundle's sections
+ *
+ * Call it periodically, from one thread at a time; readers may keep
+ * using the bundle meanwhile.
+ *
+ * @param out_report Receives what the interval saw (may be NULL)
+ * @return METAGRAPH_SUCCESS or a residency or advice error
+ */
+metagraph_result_t
+metagraph_residency_tune(metagraph_residency_t *residency,
+                         metagraph_residency_report_t *out_report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_RESIDENCY_H
@@ -169,8 +169,26 @@ metagraph_set_error_context(metagraph_result_t code, const char *file, int line,
                             const char *function, const char *format, ...)
     __attribute__((format(printf, 5, 6)));
 
+/**
+ * @brief Record an error without a message
+ *
+ * Used by METAGRAPH_ERR() when METAGRAPH_ERROR_NO_STRINGS is defined. The
+ * context's message reads as metagraph_result_to_string(code).
+ *
+ * @param code Error code
+ * @param file Source file name
+ * @param line Source line number
+ * @return The error code passed in (for convenience)
+ */
+metagraph_result_t metagraph_set_error_location(metagraph_result_t code,
+                                                const char *file, int line);
+
 /**
  * @brief Get error context for current thread
+ *
+ * The message is formatted here, from the format string and the copy of
+ * its arguments taken when the error was reported.
+ *
  * @param context Output parameter for error context
  * @return METAGRAPH_SUCCESS if context available, error code otherwise
  */
@@ -185,11 +203,10 @@ void metagraph_clear_error_context(void);
 /* Optional thread cleanup function */
 #ifdef METAGRAPH_EXPOSE_THREAD_CLEANUP
 /**
- * @brief Free thread-local error context storage
+ * @brief Reset the calling thread's error context
  *
- * Optional function to explicitly free thread-local storage before
- * thread exit. Not required as the OS will reclaim memory on thread
- * termination, but useful for thread pools that create/destroy many threads.
+ * The context lives in thread-local storage and owns no heap memory, so
+ * calling this before thread exit is not required.
  */
 void metagraph_thread_cleanup(void);
 #endif
@@ -203,8 +220,34 @@ void metagraph_thread_cleanup(void);
  */
 #define METAGRAPH_OK() (METAGRAPH_SUCCESS)
 
+#if defined(METAGRAPH_ERROR_NO_STRINGS)
+
+/**
+ * @brief Never defined; names the message arguments inside sizeof so they
+ *        count as used without being evaluated or emitted
+ */
+int metagraph_error_unused_args(const char *format, ...);
+
+/**
+ * @brief Return error with code and source location only
+ *
+ * METAGRAPH_ERROR_NO_STRINGS builds drop format strings and function
+ * names from the binary; the message arguments are not evaluated.
+ */
+#define METAGRAPH_ERR(code, ...)                                               \
+    ((void)sizeof(metagraph_error_unused_args(__VA_ARGS__)),                   \
+     metagraph_set_error_location((code), __FILE__, __LINE__))
+
+#define METAGRAPH_ERR_CODE(code)                                               \
+    metagraph_set_error_location((code), __FILE__, __LINE__)
+
+#else
+
 /**
  * @brief Return error with context information
+ *
+ * The message is formatted lazily by metagraph_get_error_context().
+ *
  * @param code Error code to return
  * @param ... Printf-style format and arguments for error message
  */
@@ -220,6 +263,8 @@ void metagraph_thread_cleanup(void);
     metagraph_set_error_context((code), __FILE__, __LINE__, __func__, "%s",    \
                                 metagraph_result_to_string(code))
 
+#endif
+
 /**
  * @brief Check if operation succeeded, return error if not
  * @param expr Expression that returns metagraph_result_t
@@ -0,0 +1,161 @@
+/**
+ * @file scheduler.h
+ * @brief Work-stealing task scheduler and task graphs
+ *
+ * The library runs its parallel work (hashing, section decoding, parallel
+ * traversals, dependency-ordered loading) on one process-wide pool of
+ * worker threads instead of starting threads per call. The pool is created
+ * on first use with one thread per CPU beyond the first; the thread that
+ * submits work joins in while it waits, so a call never sits idle next to
+ * a busy pool. Separate schedulers can be created for work that should not
+ * compete with the library's own, such as blocking I/O.
+ *
+ * A task graph is a set of tasks plus "runs after" relations between
+ * them. Running it starts every task as soon as its own prerequisites have
+ * finished: there are no level-wide barriers, so one slow task only holds
+ * back the tasks that actually depend on it. A task that fails (or whose
+ * prerequisite failed) causes its dependents to be skipped; independent
+ * tasks still run.
+ *
+ * Schedulers are thread-safe. A task graph may be run by several threads
+ * at once, but must not be modified while it is running.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_SCHEDULER_H
+#define METAGRAPH_SCHEDULER_H
+
+#include "metagraph/result.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct metagraph_scheduler metagraph_scheduler_t;
+typedef struct metagraph_task_graph metagraph_task_graph_t;
+
+/**
+ * @brief Task body
+ * @param context Pointer given when the task was added
+ * @return METAGRAPH_SUCCESS, or an error that skips the task's dependents
+ */
+typedef metagraph_result_t (*metagraph_task_fn)(void *context);
+
+typedef uint32_t metagraph_task_id_t;
+
+/**
+ * @brief Outcome of one task graph run
+ */
+typedef struct {
+    size_t completed; ///< Tasks that returned METAGRAPH_SUCCESS
+    size_t failed;    ///< Tasks that returned an error
+    size_t skipped;   ///< Tasks not run because a prerequisite did not succeed
+} metagraph_task_graph_stats_t;
+
+/**
+ * @brief Start a private scheduler
+ * @param thread_count Worker threads (0 = one per CPU beyond the first)
+ * @param out_scheduler Receives the scheduler
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_OUT_OF_MEMORY or
+ *         METAGRAPH_ERROR_THREAD_CREATION_FAILED
+ */
+metagraph_result_t
+metagraph_scheduler_create(uint32_t thread_count,
+                           metagraph_scheduler_t **out_scheduler);
+
+/**
+ * @brief Stop a private scheduler's threads and free it
+ *
+ * No work may be pending or running on it.
+ *
+ * @param scheduler Scheduler to destroy (NULL is ignored)
+ * @return METAGRAPH_SUCCESS, or METAGRAPH_ERROR_INVALID_ARGUMENT for the
+ *         shared scheduler
+ */
+metagraph_result_t
+metagraph_scheduler_destroy(metagraph_scheduler_t *scheduler);
+
+/**
+ * @brief The process-wide scheduler the library itself uses
+ *
+ * Started on the first call and kept until the process exits.
+ *
+ * @param out_scheduler Receives the shared scheduler
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_THREAD_CREATION_FAILED
+ */
+metagraph_result_t
+metagraph_scheduler_get_shared(metagraph_scheduler_t **out_scheduler);
+
+/**
+ * @brief Number of worker threads, not counting threads that submit work
+ */
+uint32_t
+metagraph_scheduler_thread_count(const metagraph_scheduler_t *scheduler);
+
+/**
+ * @brief Create an empty task graph
+ * @param out_graph Receives the graph
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_task_graph_create(metagraph_task_graph_t **out_graph);
+
+/**
+ * @brief Destroy a task graph
+ * @param graph Graph to destroy (NULL is ignored)
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t metagraph_task_graph_destroy(metagraph_task_graph_t *graph);
+
+/**
+ * @brief Add a task
+ * @param graph Graph to extend
+ * @param fn Task body
+ * @param context Passed to fn
+ * @param out_id Receives the task's ID; IDs count up from 0 (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_OUT_OF_MEMORY or
+ *         METAGRAPH_ERROR_MAX_NODES_EXCEEDED
+ */
+metagraph_result_t metagraph_task_graph_add_task(metagraph_task_graph_t *graph,
+                                                 metagraph_task_fn fn,
+                                                 void *context,
+                                                 metagraph_task_id_t *out_id);
+
+/**
+ * @brief Make task run only after prerequisite has succeeded
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_OUT_OF_MEMORY or
+ *         METAGRAPH_ERROR_INVALID_ARGUMENT for an unknown ID or a task
+ *         that would depend on itself
+ */
+metagraph_result_t
+metagraph_task_graph_add_dependency(metagraph_task_graph_t *graph,
+                                    metagraph_task_id_t task,
+                                    metagraph_task_id_t prerequisite);
+
+/**
+ * @brief Run every task, each as soon as its prerequisites succeed
+ *
+ * Returns once every task has run or been skipped. Tasks run on the
+ * scheduler's threads and on the calling thread. When a task fails, the
+ * first failure's error is returned with its context message.
+ *
+ * @param graph Graph to run
+ * @param scheduler Scheduler to use (NULL = the shared scheduler)
+ * @param out_stats Receives task counts (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_DEPENDENCY_CYCLE (nothing
+ *         runs), METAGRAPH_ERROR_OUT_OF_MEMORY, or a task's error
+ */
+metagraph_result_t
+metagraph_task_graph_run(const metagraph_task_graph_t *graph,
+                         metagraph_scheduler_t *scheduler,
+                         metagraph_task_graph_stats_t *out_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_SCHEDULER_H
@@ -0,0 +1,124 @@
+/**
+ * @file trace.h
+ * @brief Static tracepoints and an in-process span recorder
+ *
+ * Builds with the METAGRAPH_USDT option (on by default) and <sys/sdt.h>
+ * available carry USDT probes under the "metagraph" provider. They cost
+ * a nop until a tracer attaches, so they can be left in production
+ * binaries and used without a rebuild:
+ *
+ * | Probe                    | Arguments                                  |
+ * |--------------------------|--------------------------------------------|
+ * | bundle__open__start      | path (NULL from memory)                    |
+ * | bundle__open__done       | path, result                               |
+ * | section__load__start     | bundle, section type                       |
+ * | section__load__done      | bundle, section type, result               |
+ * | pointer__hydrate         | map, offset                                |
+ * | verify__start            | bundle, section type, first, last leaf     |
+ * | verify__done             | bundle, section type, result               |
+ * | verify__bundle__start    | bundle                                     |
+ * | verify__bundle__done     | bundle, result                             |
+ * | traverse__start          | kind, start node                           |
+ * | traverse__done           | kind, nodes reached, result                |
+ *
+ * Traversal kinds are 0 for DFS, 1 for BFS and 2 for frozen-graph BFS.
+ * For example, to see which section loads are slow:
+ *
+ *     bpftrace -e 'usdt:./app:metagraph:section__load__start
+ *         { @s[tid] = nsecs; }
+ *         usdt:./app:metagraph:section__load__done /@s[tid]/
+ *         { @ns[arg1] = hist(nsecs - @s[tid]); delete(@s[tid]); }'
+ *
+ * Builds with the METAGRAPH_TRACING option also record the same regions
+ * as spans into a fixed-size in-process buffer, which can be written out
+ * as Chrome trace event JSON (chrome://tracing, Perfetto). Without the
+ * option the recording hooks compile to nothing and every function here
+ * except metagraph_trace_available() returns
+ * METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE.
+ *
+ * Recording may run while any number of threads use the library. The
+ * control functions (start, stop, write, discard) must not race each
+ * other.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_TRACE_H
+#define METAGRAPH_TRACE_H
+
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Span recorder state
+ */
+typedef struct {
+    size_t capacity; ///< Spans the buffer holds
+    size_t recorded; ///< Spans completed and kept
+    size_t dropped;  ///< Spans lost because the buffer was full
+    bool recording;  ///< Between start and stop
+} metagraph_trace_stats_t;
+
+/**
+ * @brief Whether this build includes the span recorder
+ */
+bool metagraph_trace_available(void);
+
+/**
+ * @brief Start recording spans, discarding any earlier recording
+ *
+ * @param capacity Spans to keep; later ones are counted as dropped
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_SIZE for a zero
+ *         capacity, METAGRAPH_ERROR_OUT_OF_MEMORY or
+ *         METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE
+ */
+metagraph_result_t metagraph_trace_start(size_t capacity);
+
+/**
+ * @brief Stop recording; spans still in flight are dropped
+ *
+ * Returns once no thread is still writing into the buffer. The spans
+ * recorded so far are kept for metagraph_trace_write_chrome().
+ *
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE
+ */
+metagraph_result_t metagraph_trace_stop(void);
+
+/**
+ * @brief Write the recorded spans as Chrome trace event JSON
+ *
+ * Spans are complete ("X") events with microsecond timestamps relative to
+ * metagraph_trace_start(); each thread that recorded gets its own track.
+ * May be called while recording; spans completed by then are written.
+ *
+ * @param path File to create or replace
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_IO_FAILURE or
+ *         METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE
+ */
+metagraph_result_t metagraph_trace_write_chrome(const char *path);
+
+/**
+ * @brief Report the recorder's state
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NULL_POINTER or
+ *         METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE
+ */
+metagraph_result_t
+metagraph_trace_get_stats(metagraph_trace_stats_t *out_stats);
+
+/**
+ * @brief Stop recording and release the span buffer
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE
+ */
+metagraph_result_t metagraph_trace_discard(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_TRACE_H
@@ -0,0 +1,304 @@
+/**
+ * @file traversal.h
+ * @brief Graph traversal engine: visitors, DFS, parallel BFS and parallel
+ *        topological ordering
+ *
+ * Traversals follow dependency direction: from an edge's source to each of
+ * its targets. Breadth-first search is level-synchronous and
+ * direction-optimizing: small frontiers are expanded top-down along
+ * outgoing edges, and once the frontier's edges outweigh the unexplored
+ * part of the graph each undiscovered node instead scans its incoming
+ * edges for a parent in the frontier (bottom-up). Topological ordering is
+ * Kahn's algorithm over atomic per-node dependency counters, one parallel
+ * step per level. Parallel work is spread over a work-stealing thread
+ * team.
+ *
+ * Traversal cursors run a DFS or BFS in slices: each step stops once it has
+ * used up a node, edge or time budget, and the next step carries on from
+ * exactly where it stopped, so a huge traversal can be spread over frames
+ * or requests without blocking any one of them.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_TRAVERSAL_H
+#define METAGRAPH_TRAVERSAL_H
+
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What a visitor asks the traversal to do next
+ */
+typedef enum {
+    METAGRAPH_VISIT_CONTINUE, ///< Continue traversal
+    METAGRAPH_VISIT_SKIP,     ///< Do not expand this node / follow this edge
+    METAGRAPH_VISIT_TERMINATE ///< Stop the entire traversal
+} metagraph_visit_result_t;
+
+/**
+ * @brief Called once per reached node
+ */
+typedef metagraph_visit_result_t (*metagraph_node_visitor_t)(
+    const metagraph_graph_t *graph, metagraph_node_index_t node,
+    uint32_t depth, void *user_data);
+
+/**
+ * @brief Called for an edge that would reach an undiscovered node
+ *
+ * from is the edge's source, to one of its targets, and depth the depth
+ * of from. Returning SKIP leaves `to` to be reached through another edge.
+ */
+typedef metagraph_visit_result_t (*metagraph_edge_visitor_t)(
+    const metagraph_graph_t *graph, metagraph_edge_index_t edge,
+    metagraph_node_index_t from, metagraph_node_index_t to, uint32_t depth,
+    void *user_data);
+
+/**
+ * @brief Traversal parameters
+ */
+typedef struct {
+    const metagraph_graph_t *graph; ///< Graph to traverse
+    void *user_data;                ///< Passed to every visitor call
+    uint32_t max_depth; ///< Nodes deeper than this are not reached (0 = none)
+} metagraph_traversal_context_t;
+
+/**
+ * @brief Parallel execution parameters
+ *
+ * Zero fields take defaults. The team is also capped so every thread gets
+ * at least one work unit of nodes.
+ */
+typedef struct {
+    uint32_t thread_count; ///< Worker threads including the caller (0 = CPUs)
+    size_t work_unit_size; ///< Nodes per stealable work unit (0 = 1024)
+} metagraph_parallel_config_t;
+
+// ============================================================================
+// Depth-first search
+// ============================================================================
+
+/**
+ * @brief When the node visitor runs during DFS
+ */
+typedef enum {
+    METAGRAPH_DFS_PREORDER,  ///< Visit node before its dependencies
+    METAGRAPH_DFS_POSTORDER, ///< Visit node after its dependencies
+    METAGRAPH_DFS_BOTH       ///< Visit node before and after
+} metagraph_dfs_mode_t;
+
+/**
+ * @brief Single-threaded depth-first traversal from one node
+ *
+ * Each node is reached at most once. SKIP from a preorder visit prevents
+ * descending into the node; postorder results other than TERMINATE are
+ * ignored.
+ *
+ * @param context Traversal parameters
+ * @param start Node to start from
+ * @param mode When to call node_visitor
+ * @param node_visitor Node callback (may be NULL)
+ * @param edge_visitor Edge callback (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND or
+ *         METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_traverse_dfs(const metagraph_traversal_context_t *context,
+                       metagraph_node_index_t start, metagraph_dfs_mode_t mode,
+                       metagraph_node_visitor_t node_visitor,
+                       metagraph_edge_visitor_t edge_visitor);
+
+// ============================================================================
+// Resumable traversals
+// ============================================================================
+
+/**
+ * @brief Order a cursor walks the graph in
+ */
+typedef enum {
+    METAGRAPH_CURSOR_DFS, ///< Depth-first, as metagraph_traverse_dfs()
+    METAGRAPH_CURSOR_BFS  ///< Breadth-first on the stepping thread
+} metagraph_cursor_order_t;
+
+/**
+ * @brief What a cursor traverses
+ */
+typedef struct {
+    metagraph_cursor_order_t order;
+    metagraph_dfs_mode_t dfs_mode;         ///< DFS visit timing (BFS: unused)
+    metagraph_node_index_t start;          ///< Node to start from
+    metagraph_node_visitor_t node_visitor; ///< Node callback (may be NULL)
+    metagraph_edge_visitor_t edge_visitor; ///< Edge callback (may be NULL)
+} metagraph_cursor_config_t;
+
+/**
+ * @brief Work one cursor step may do; zero fields are unlimited
+ *
+ * Time is checked every few edge targets, so a step can overrun max_ns by
+ * that many visitor calls.
+ */
+typedef struct {
+    uint64_t max_nodes; ///< Nodes to reach
+    uint64_t max_edges; ///< Edge targets to examine
+    uint64_t max_ns;    ///< Wall-clock nanoseconds to spend
+} metagraph_traversal_budget_t;
+
+/**
+ * @brief Totals since the cursor was created
+ */
+typedef struct {
+    uint64_t nodes_reached;  ///< Nodes reached, including the start
+    uint64_t edges_examined; ///< Edge targets looked at
+    bool finished;           ///< Nothing is left to do
+} metagraph_cursor_progress_t;
+
+typedef struct metagraph_traversal_cursor metagraph_traversal_cursor_t;
+
+/**
+ * @brief Set up a traversal without running any of it
+ *
+ * The context is copied; its graph must outlive the cursor and must not
+ * change while the cursor is in use. Visitors behave as in
+ * metagraph_traverse_dfs(); a BFS cursor visits each node when it is
+ * reached, level by level.
+ *
+ * @param context Traversal parameters
+ * @param config What to traverse
+ * @param out_cursor Receives the cursor
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND,
+ *         METAGRAPH_ERROR_INVALID_ARGUMENT or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t metagraph_traversal_cursor_create(
+    const metagraph_traversal_context_t *context,
+    const metagraph_cursor_config_t *config,
+    metagraph_traversal_cursor_t **out_cursor);
+
+/**
+ * @brief Continue a traversal until it ends or the budget runs out
+ *
+ * A step stops just before the unit of work that would exceed the budget,
+ * so no node or edge is ever handled twice across steps. Every step does
+ * some work; the first one always reaches the start node. Stepping a
+ * finished cursor does nothing.
+ *
+ * @param cursor Cursor to advance
+ * @param budget Limits for this step (NULL = run to the end)
+ * @param out_progress Receives the totals so far (may be NULL)
+ * @return METAGRAPH_SUCCESS once the traversal is complete or a visitor
+ *         returned TERMINATE, METAGRAPH_ERROR_TRAVERSAL_LIMIT_EXCEEDED when
+ *         paused with work left, or METAGRAPH_ERROR_OUT_OF_MEMORY (the
+ *         cursor is then finished)
+ */
+metagraph_result_t
+metagraph_traversal_cursor_step(metagraph_traversal_cursor_t *cursor,
+                                const metagraph_traversal_budget_t *budget,
+                                metagraph_cursor_progress_t *out_progress);
+
+/**
+ * @brief Destroy a cursor, finished or not
+ * @param cursor Cursor to destroy (NULL is ignored)
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t
+metagraph_traversal_cursor_destroy(metagraph_traversal_cursor_t *cursor);
+
+// ============================================================================
+// Breadth-first search
+// ============================================================================
+
+/**
+ * @brief Per-node BFS outcome
+ */
+typedef struct {
+    uint32_t distance; ///< Levels from the start (UINT32_MAX = unreached)
+    metagraph_node_index_t parent;    ///< BFS tree parent (INVALID at roots)
+    metagraph_edge_index_t parent_edge; ///< Edge from parent (INVALID at roots)
+} metagraph_bfs_node_info_t;
+
+/**
+ * @brief Parallel direction-optimizing breadth-first traversal
+ *
+ * Visitors run concurrently on worker threads and must be thread-safe.
+ * Every node at level d is visited before any node at level d + 1; the
+ * order within a level is unspecified, and so is the choice between
+ * equally short parents. Distances do not depend on the thread count.
+ *
+ * @param context Traversal parameters
+ * @param start Node to start from
+ * @param parallel Execution parameters (NULL selects defaults)
+ * @param node_visitor Node callback (may be NULL)
+ * @param edge_visitor Edge callback (may be NULL)
+ * @param out_info Receives one entry per graph node (may be NULL)
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_NODE_NOT_FOUND,
+ *         METAGRAPH_ERROR_OUT_OF_MEMORY or
+ *         METAGRAPH_ERROR_THREAD_CREATION_FAILED
+ */
+metagraph_result_t
+metagraph_traverse_bfs(const metagraph_traversal_context_t *context,
+                       metagraph_node_index_t start,
+                       const metagraph_parallel_config_t *parallel,
+                       metagraph_node_visitor_t node_visitor,
+                       metagraph_edge_visitor_t edge_visitor,
+                       metagraph_bfs_node_info_t *out_info);
+
+// ============================================================================
+// Topological ordering
+// ============================================================================
+
+/**
+ * @brief Dependency order of a graph
+ *
+ * nodes lists dependencies before their dependents. On a cycle, nodes holds
+ * every node that could be ordered and cycle_nodes one offending cycle:
+ * cycle_nodes[i] depends on cycle_nodes[i + 1], and the last node depends
+ * on the first.
+ */
+typedef struct {
+    metagraph_node_index_t *nodes;       ///< Ordered node indices
+    size_t node_count;                   ///< Entries in nodes
+    metagraph_node_index_t *cycle_nodes; ///< One dependency cycle, or NULL
+    size_t cycle_count;                  ///< Entries in cycle_nodes
+} metagraph_topological_result_t;
+
+/**
+ * @brief Order every node after the nodes it depends on
+ *
+ * Nodes are emitted in dependency levels; within a level they are sorted
+ * by index, so the order does not depend on the thread count. On a cycle
+ * the path is also written to the thread's error context.
+ *
+ * @param graph Graph to order
+ * @param parallel Execution parameters (NULL selects defaults)
+ * @param out_result Receives the order; release it with
+ *        metagraph_topological_result_destroy() on success and on
+ *        METAGRAPH_ERROR_DEPENDENCY_CYCLE
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_DEPENDENCY_CYCLE,
+ *         METAGRAPH_ERROR_OUT_OF_MEMORY or
+ *         METAGRAPH_ERROR_THREAD_CREATION_FAILED
+ */
+metagraph_result_t
+metagraph_compute_topological_order(const metagraph_graph_t *graph,
+                                    const metagraph_parallel_config_t *parallel,
+                                    metagraph_topological_result_t *out_result);
+
+/**
+ * @brief Release the arrays of a topological result
+ * @param result Result to clear (NULL is ignored)
+ * @return METAGRAPH_SUCCESS
+ */
+metagraph_result_t
+metagraph_topological_result_destroy(metagraph_topological_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_TRAVERSAL_H
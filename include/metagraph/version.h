@@ -64,8 +64,8 @@ extern "C" {
 // =============================================================================
 
 #define METAGRAPH_FEATURE_VERSIONED_BUNDLES 1
-#define METAGRAPH_FEATURE_DELTA_PATCHES 0  // Reserved for future
-#define METAGRAPH_FEATURE_COMPRESSION_V2 0 // Reserved for future
+#define METAGRAPH_FEATURE_DELTA_PATCHES 1
+#define METAGRAPH_FEATURE_COMPRESSION_V2 1
 
 // =============================================================================
 // Runtime Version API
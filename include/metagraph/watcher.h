@@ -0,0 +1,141 @@
+/**
+ * @file watcher.h
+ * @brief Hot reload of a bundle file that readers never wait for
+ *
+ * A watcher owns the current version of a bundle file. A background thread
+ * notices when the file is replaced (inotify on Linux, polling the file's
+ * identity elsewhere and as a backstop), maps and validates the new file,
+ * then publishes it with a single atomic pointer store. Readers bracket
+ * their use of the bundle with metagraph_file_watcher_acquire() and
+ * metagraph_file_watcher_release(); neither takes a lock, so a reload
+ * never stalls a reader. A replaced version is unmapped once every reader
+ * that could still hold it has released it.
+ *
+ * Replace the file by writing a new one and renaming it over the old path,
+ * as metagraph_bundle_write_graph() does. Rewriting a mapped bundle in
+ * place changes bytes under its readers.
+ *
+ * @copyright Apache License 2.0 - see LICENSE file for details
+ */
+
+#ifndef METAGRAPH_WATCHER_H
+#define METAGRAPH_WATCHER_H
+
+#include "metagraph/bundle.h"
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bundle file kept current by a background thread
+ */
+typedef struct metagraph_file_watcher metagraph_file_watcher_t;
+
+/**
+ * @brief Called after every reload attempt, on the thread that made it
+ *
+ * On success bundle is the newly published version and generation its
+ * number. On failure result is the error (its context is readable with
+ * metagraph_get_error_context() during the call) and bundle is the version
+ * that stays current. bundle is valid for the duration of the call.
+ */
+typedef void (*metagraph_reload_callback_t)(void *user_data,
+                                            const metagraph_bundle_t *bundle,
+                                            uint64_t generation,
+                                            metagraph_result_t result);
+
+/**
+ * @brief Watcher flags
+ */
+typedef enum {
+    METAGRAPH_FILE_WATCHER_NONE = 0,
+    /// Hash every section of a new version before publishing it
+    METAGRAPH_FILE_WATCHER_VERIFY = 1U << 0U,
+    /// Start no thread; only metagraph_file_watcher_reload() reloads
+    METAGRAPH_FILE_WATCHER_MANUAL = 1U << 1U,
+} metagraph_file_watcher_flags_t;
+
+/**
+ * @brief Watcher configuration (NULL selects defaults)
+ */
+typedef struct {
+    uint32_t flags;            ///< metagraph_file_watcher_flags_t bits
+    uint32_t poll_interval_ms; ///< Identity checks and reclamation between
+                               ///< events (0 = 1000)
+    metagraph_bundle_options_t open_options; ///< Used for every version
+    metagraph_reload_callback_t on_reload;   ///< May be NULL
+    void *user_data;                         ///< Passed to on_reload
+} metagraph_file_watcher_config_t;
+
+/**
+ * @brief Open a bundle file and start watching it
+ *
+ * The first version is opened and validated before this returns, so a
+ * watcher always has a current bundle.
+ *
+ * @return METAGRAPH_SUCCESS, an error from opening or verifying the file,
+ *         or METAGRAPH_ERROR_THREAD_CREATION_FAILED
+ */
+metagraph_result_t
+metagraph_file_watcher_create(const char *file_path,
+                              const metagraph_file_watcher_config_t *config,
+                              metagraph_file_watcher_t **out_watcher);
+
+/**
+ * @brief Stop watching and unmap every version
+ *
+ * No thread may be between acquire and release.
+ */
+metagraph_result_t
+metagraph_file_watcher_destroy(metagraph_file_watcher_t *watcher);
+
+/**
+ * @brief Borrow the current version on the calling thread
+ *
+ * The bundle stays mapped until the matching
+ * metagraph_file_watcher_release() on the same thread, even if a newer
+ * version is published meanwhile. Acquisitions nest; each one returns the
+ * version current at that moment. Never blocks; only the first
+ * acquisition on a thread allocates.
+ *
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_file_watcher_acquire(const metagraph_file_watcher_t *watcher,
+                               const metagraph_bundle_t **out_bundle);
+
+/**
+ * @brief End the calling thread's latest acquisition
+ */
+void metagraph_file_watcher_release(const metagraph_file_watcher_t *watcher);
+
+/**
+ * @brief Reload now if the file changed since the current version
+ *
+ * Runs on the calling thread and is serialized with the watcher thread.
+ * on_reload is called as for a background reload.
+ *
+ * @param watcher Watcher to reload
+ * @param force Reload even if the file looks unchanged
+ * @return METAGRAPH_SUCCESS (also when there was nothing to reload) or the
+ *         error that kept the current version in place
+ */
+metagraph_result_t
+metagraph_file_watcher_reload(metagraph_file_watcher_t *watcher, bool force);
+
+/**
+ * @brief Number of the current version, starting at 1
+ */
+uint64_t
+metagraph_file_watcher_generation(const metagraph_file_watcher_t *watcher);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METAGRAPH_WATCHER_H
@@ -250,6 +250,36 @@ run_pgo() {
     echo "[INFO] PGO comparison saved to: .ignored/pgo-comparison.txt"
 }
 
+# Static tracepoints (Linux only; needs sys/sdt.h at build time)
+profile_with_probes() {
+    if [ "$(uname -s)" != "Linux" ]; then
+        mg_yellow "[WARN] USDT probes are only available on Linux"
+        return
+    fi
+
+    echo "[INFO] 📍 Listing USDT probes..."
+
+    # The library is static, so the probes live in the linked binary
+    bin=./build-profile/bin/mg_benchmarks
+    if ! readelf -n "$bin" | grep -q stapsdt; then
+        mg_yellow "[WARN] No probes found; install systemtap-sdt-dev and rebuild"
+        return
+    fi
+    readelf -n "$bin" | grep -A4 stapsdt | grep -E 'Name:|Arguments:'
+
+    if ! command -v bpftrace >/dev/null 2>&1; then
+        echo "[INFO] Install bpftrace to attach to the probes"
+        return
+    fi
+
+    echo "[INFO] Section load latency by section type..."
+    bpftrace -e "usdt:$bin:metagraph:section__load__start
+        { @s[tid] = nsecs; }
+        usdt:$bin:metagraph:section__load__done /@s[tid]/
+        { @ns[arg1] = hist(nsecs - @s[tid]); delete(@s[tid]); }" \
+        -c ./build-profile/bin/mg_benchmarks
+}
+
 # Fuzzing with address sanitizer
 run_fuzzing() {
     echo "[INFO] 🐛 Running fuzzing tests..."
@@ -307,6 +337,10 @@ main() {
         "fuzz")
             run_fuzzing
             ;;
+        "probes")
+            build_for_profiling
+            profile_with_probes
+            ;;
         "all")
             build_for_profiling
             benchmark_timing
@@ -319,7 +353,7 @@ main() {
             run_fuzzing
             ;;
         *)
-            echo "Usage: $0 [perf|valgrind|gprof|timing|targets|pgo|fuzz|all]"
+            echo "Usage: $0 [perf|valgrind|gprof|timing|targets|pgo|fuzz|probes|all]"
             echo ""
             echo "Options:"
             echo "  perf      - Performance profiling with perf (Linux only)"
@@ -329,6 +363,7 @@ main() {
             echo "  targets   - Check adherence to documented performance targets"
             echo "  pgo       - Profile-Guided Optimization"
             echo "  fuzz      - Fuzzing tests"
+            echo "  probes    - List USDT probes and trace section loads with bpftrace"
             echo "  all       - Run all profiling tests"
             exit 1
             ;;
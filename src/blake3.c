@@ -0,0 +1,768 @@
+/**
+ * @file blake3.c
+ * @brief BLAKE3 hashing: portable compression, tree hashing and dispatch
+ *
+ * Whole buffers are hashed top-down: a subtree is split at the largest
+ * power-of-two number of chunks that leaves the right side non-empty,
+ * exactly as BLAKE3's tree is shaped. Subtrees of up to
+ * METAGRAPH_BLAKE3_BATCH_CHUNKS chunks are hashed bottom-up instead, with
+ * the active SIMD kernel compressing many chunks (and then many parents) in
+ * lockstep. Above METAGRAPH_BLAKE3_PARALLEL_MIN bytes the left half of a
+ * split is forked onto the shared scheduler while the caller hashes the
+ * right half.
+ */
+
+#include "metagraph/integrity.h"
+#include "metagraph/result.h"
+
+#include "blake3_internal.h"
+#include "platform.h"
+#include "scheduler_internal.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Chunks hashed bottom-up in one batch (2 KiB of chaining values)
+#define METAGRAPH_BLAKE3_BATCH_CHUNKS 64U
+
+// Smallest subtree worth forking
+#define METAGRAPH_BLAKE3_PARALLEL_MIN (1024U * 1024U)
+
+// Enough entries for 2^54 chunks, the BLAKE3 input limit
+#define METAGRAPH_BLAKE3_MAX_DEPTH 54U
+
+const uint32_t metagraph_blake3_iv[8] = {
+    0x6A09E667U, 0xBB67AE85U, 0x3C6EF372U, 0xA54FF53AU,
+    0x510E527FU, 0x9B05688CU, 0x1F83D9ABU, 0x5BE0CD19U,
+};
+
+// Message word order for each of the seven rounds
+const uint8_t metagraph_blake3_schedule[7][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13},
+};
+
+// ---------------------------------------------------------------------------
+// Portable compression
+// ---------------------------------------------------------------------------
+
+static inline uint32_t metagraph_blake3_rotr(uint32_t value, uint32_t bits) {
+    return (value >> bits) | (value << (32U - bits));
+}
+
+static inline void metagraph_blake3_g(uint32_t *state, size_t a, size_t b,
+                                      size_t c, size_t d, uint32_t mx,
+                                      uint32_t my) {
+    state[a] = state[a] + state[b] + mx;
+    state[d] = metagraph_blake3_rotr(state[d] ^ state[a], 16U);
+    state[c] = state[c] + state[d];
+    state[b] = metagraph_blake3_rotr(state[b] ^ state[c], 12U);
+    state[a] = state[a] + state[b] + my;
+    state[d] = metagraph_blake3_rotr(state[d] ^ state[a], 8U);
+    state[c] = state[c] + state[d];
+    state[b] = metagraph_blake3_rotr(state[b] ^ state[c], 7U);
+}
+
+void metagraph_blake3_compress_in_place(uint32_t cv[8],
+                                        const uint8_t block[64],
+                                        uint8_t block_len, uint64_t counter,
+                                        uint8_t flags) {
+    uint32_t m[16];
+    for (size_t i = 0; i < 16; i++) {
+        m[i] = metagraph_blake3_load32(block + 4U * i);
+    }
+    uint32_t state[16] = {
+        cv[0],
+        cv[1],
+        cv[2],
+        cv[3],
+        cv[4],
+        cv[5],
+        cv[6],
+        cv[7],
+        metagraph_blake3_iv[0],
+        metagraph_blake3_iv[1],
+        metagraph_blake3_iv[2],
+        metagraph_blake3_iv[3],
+        (uint32_t)counter,
+        (uint32_t)(counter >> 32U),
+        block_len,
+        flags,
+    };
+    for (size_t round = 0; round < 7; round++) {
+        const uint8_t *s = metagraph_blake3_schedule[round];
+        metagraph_blake3_g(state, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        metagraph_blake3_g(state, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        metagraph_blake3_g(state, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        metagraph_blake3_g(state, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        metagraph_blake3_g(state, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        metagraph_blake3_g(state, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        metagraph_blake3_g(state, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        metagraph_blake3_g(state, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    for (size_t i = 0; i < 8; i++) {
+        cv[i] = state[i] ^ state[i + 8U];
+    }
+}
+
+static void metagraph_blake3_store_cv(uint8_t out[METAGRAPH_BLAKE3_OUT_LEN],
+                                      const uint32_t cv[8]) {
+    for (size_t i = 0; i < 8; i++) {
+        metagraph_blake3_store32(out + 4U * i, cv[i]);
+    }
+}
+
+void metagraph_blake3_hash_many_portable(
+    const uint8_t *const *inputs, size_t count, size_t blocks,
+    const uint32_t key[8], uint64_t counter, bool increment_counter,
+    uint8_t flags, uint8_t flags_start, uint8_t flags_end, uint8_t *out) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t cv[8];
+        memcpy(cv, key, sizeof(cv));
+        uint8_t block_flags = (uint8_t)(flags | flags_start);
+        for (size_t b = 0; b < blocks; b++) {
+            if (b + 1U == blocks) {
+                block_flags = (uint8_t)(block_flags | flags_end);
+            }
+            metagraph_blake3_compress_in_place(
+                cv, inputs[i] + b * METAGRAPH_BLAKE3_BLOCK_LEN,
+                METAGRAPH_BLAKE3_BLOCK_LEN, counter, block_flags);
+            block_flags = flags;
+        }
+        metagraph_blake3_store_cv(out + i * METAGRAPH_BLAKE3_OUT_LEN, cv);
+        if (increment_counter) {
+            counter++;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Kernel dispatch
+// ---------------------------------------------------------------------------
+
+// Resolved lazily to the widest supported kernel; -1 until then.
+static _Atomic(int) metagraph_blake3_active = -1;
+
+static metagraph_blake3_implementation_t metagraph_blake3_resolve(void) {
+    int active = atomic_load_explicit(&metagraph_blake3_active,
+                                      memory_order_relaxed);
+    if (active < 0) {
+        static const metagraph_blake3_implementation_t preference[] = {
+            METAGRAPH_BLAKE3_AVX512,
+            METAGRAPH_BLAKE3_AVX2,
+            METAGRAPH_BLAKE3_SSE41,
+        };
+        active = (int)METAGRAPH_BLAKE3_PORTABLE;
+        for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]);
+             i++) {
+            if (metagraph_blake3_implementation_available(preference[i])) {
+                active = (int)preference[i];
+                break;
+            }
+        }
+        atomic_store_explicit(&metagraph_blake3_active, active,
+                              memory_order_relaxed);
+    }
+    return (metagraph_blake3_implementation_t)active;
+}
+
+static void metagraph_blake3_hash_many(const uint8_t *const *inputs,
+                                       size_t count, size_t blocks,
+                                       uint64_t counter, bool increment_counter,
+                                       uint8_t flags, uint8_t flags_start,
+                                       uint8_t flags_end, uint8_t *out) {
+    size_t lanes = 1;
+    metagraph_blake3_hash_many_fn kernel =
+        metagraph_blake3_simd_kernel(metagraph_blake3_resolve(), &lanes);
+    if (!kernel) {
+        kernel = metagraph_blake3_hash_many_portable;
+    }
+    kernel(inputs, count, blocks, metagraph_blake3_iv, counter,
+           increment_counter, flags, flags_start, flags_end, out);
+}
+
+bool metagraph_blake3_implementation_available(
+    metagraph_blake3_implementation_t implementation) {
+    if (implementation == METAGRAPH_BLAKE3_PORTABLE) {
+        return true;
+    }
+    size_t lanes = 0;
+    return metagraph_blake3_simd_kernel(implementation, &lanes) != NULL &&
+           metagraph_blake3_cpu_supports(implementation);
+}
+
+metagraph_blake3_implementation_t metagraph_blake3_get_implementation(void) {
+    return metagraph_blake3_resolve();
+}
+
+metagraph_result_t metagraph_blake3_set_implementation(
+    metagraph_blake3_implementation_t implementation) {
+    if (!metagraph_blake3_implementation_available(implementation)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                             "BLAKE3 kernel %s is not available on this CPU",
+                             metagraph_blake3_implementation_name(
+                                 implementation));
+    }
+    atomic_store_explicit(&metagraph_blake3_active, (int)implementation,
+                          memory_order_relaxed);
+    return METAGRAPH_OK();
+}
+
+const char *metagraph_blake3_implementation_name(
+    metagraph_blake3_implementation_t implementation) {
+    switch (implementation) {
+    case METAGRAPH_BLAKE3_PORTABLE:
+        return "portable";
+    case METAGRAPH_BLAKE3_SSE41:
+        return "sse4.1";
+    case METAGRAPH_BLAKE3_AVX2:
+        return "avx2";
+    case METAGRAPH_BLAKE3_AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Chunks and parents
+// ---------------------------------------------------------------------------
+
+// Incremental state of one chunk
+typedef struct {
+    uint32_t cv[8];
+    uint64_t chunk_counter;
+    uint8_t block[METAGRAPH_BLAKE3_BLOCK_LEN];
+    uint8_t block_len;
+    uint8_t blocks_compressed;
+} metagraph_blake3_chunk_t;
+
+// Inputs of the last compression of a node, before it is finalized as a
+// chaining value or as the root.
+typedef struct {
+    uint32_t input_cv[8];
+    uint8_t block[METAGRAPH_BLAKE3_BLOCK_LEN];
+    uint64_t counter;
+    uint8_t block_len;
+    uint8_t flags;
+} metagraph_blake3_output_t;
+
+static void metagraph_blake3_chunk_init(metagraph_blake3_chunk_t *chunk,
+                                        uint64_t chunk_counter) {
+    memcpy(chunk->cv, metagraph_blake3_iv, sizeof(chunk->cv));
+    chunk->chunk_counter = chunk_counter;
+    memset(chunk->block, 0, sizeof(chunk->block));
+    chunk->block_len = 0;
+    chunk->blocks_compressed = 0;
+}
+
+static size_t metagraph_blake3_chunk_len(const metagraph_blake3_chunk_t *chunk) {
+    return METAGRAPH_BLAKE3_BLOCK_LEN * (size_t)chunk->blocks_compressed +
+           chunk->block_len;
+}
+
+static uint8_t
+metagraph_blake3_chunk_start_flag(const metagraph_blake3_chunk_t *chunk) {
+    return chunk->blocks_compressed == 0 ? METAGRAPH_BLAKE3_CHUNK_START : 0U;
+}
+
+static void metagraph_blake3_chunk_update(metagraph_blake3_chunk_t *chunk,
+                                          const uint8_t *input, size_t len) {
+    while (len > 0) {
+        // A full buffered block is only compressed once more input arrives:
+        // the last block of a chunk needs CHUNK_END.
+        if (chunk->block_len == METAGRAPH_BLAKE3_BLOCK_LEN) {
+            metagraph_blake3_compress_in_place(
+                chunk->cv, chunk->block, METAGRAPH_BLAKE3_BLOCK_LEN,
+                chunk->chunk_counter, metagraph_blake3_chunk_start_flag(chunk));
+            chunk->blocks_compressed++;
+            chunk->block_len = 0;
+            memset(chunk->block, 0, sizeof(chunk->block));
+        }
+        size_t take = METAGRAPH_BLAKE3_BLOCK_LEN - chunk->block_len;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(chunk->block + chunk->block_len, input, take);
+        chunk->block_len = (uint8_t)(chunk->block_len + take);
+        input += take;
+        len -= take;
+    }
+}
+
+static metagraph_blake3_output_t
+metagraph_blake3_chunk_output(const metagraph_blake3_chunk_t *chunk) {
+    metagraph_blake3_output_t output;
+    memcpy(output.input_cv, chunk->cv, sizeof(output.input_cv));
+    memcpy(output.block, chunk->block, sizeof(output.block));
+    output.counter = chunk->chunk_counter;
+    output.block_len = chunk->block_len;
+    output.flags = (uint8_t)(metagraph_blake3_chunk_start_flag(chunk) |
+                             METAGRAPH_BLAKE3_CHUNK_END);
+    return output;
+}
+
+static metagraph_blake3_output_t
+metagraph_blake3_parent_output(const uint8_t left[METAGRAPH_BLAKE3_OUT_LEN],
+                               const uint8_t right[METAGRAPH_BLAKE3_OUT_LEN]) {
+    metagraph_blake3_output_t output;
+    memcpy(output.input_cv, metagraph_blake3_iv, sizeof(output.input_cv));
+    memcpy(output.block, left, METAGRAPH_BLAKE3_OUT_LEN);
+    memcpy(output.block + METAGRAPH_BLAKE3_OUT_LEN, right,
+           METAGRAPH_BLAKE3_OUT_LEN);
+    output.counter = 0;
+    output.block_len = METAGRAPH_BLAKE3_BLOCK_LEN;
+    output.flags = METAGRAPH_BLAKE3_PARENT;
+    return output;
+}
+
+static void
+metagraph_blake3_output_cv(const metagraph_blake3_output_t *output,
+                           uint8_t out[METAGRAPH_BLAKE3_OUT_LEN]) {
+    uint32_t cv[8];
+    memcpy(cv, output->input_cv, sizeof(cv));
+    metagraph_blake3_compress_in_place(cv, output->block, output->block_len,
+                                       output->counter, output->flags);
+    metagraph_blake3_store_cv(out, cv);
+}
+
+// The root is compressed with output block counter 0, not the node's own
+// chunk counter.
+static void
+metagraph_blake3_output_root(const metagraph_blake3_output_t *output,
+                             uint8_t out[METAGRAPH_BLAKE3_OUT_LEN]) {
+    uint32_t cv[8];
+    memcpy(cv, output->input_cv, sizeof(cv));
+    metagraph_blake3_compress_in_place(
+        cv, output->block, output->block_len, 0,
+        (uint8_t)(output->flags | METAGRAPH_BLAKE3_ROOT));
+    metagraph_blake3_store_cv(out, cv);
+}
+
+void metagraph_blake3_parent(const uint8_t left[METAGRAPH_BLAKE3_OUT_LEN],
+                             const uint8_t right[METAGRAPH_BLAKE3_OUT_LEN],
+                             bool root, uint8_t out[METAGRAPH_BLAKE3_OUT_LEN]) {
+    const metagraph_blake3_output_t output =
+        metagraph_blake3_parent_output(left, right);
+    if (root) {
+        metagraph_blake3_output_root(&output, out);
+    } else {
+        metagraph_blake3_output_cv(&output, out);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Subtrees
+// ---------------------------------------------------------------------------
+
+// Bytes in the left subtree of an input longer than one chunk
+static size_t metagraph_blake3_left_len(size_t len) {
+    size_t full_chunks = (len - 1U) / METAGRAPH_BLAKE3_CHUNK_LEN;
+    size_t power = 1;
+    while (power * 2U <= full_chunks) {
+        power *= 2U;
+    }
+    return power * METAGRAPH_BLAKE3_CHUNK_LEN;
+}
+
+// Chaining values of every chunk of input (at most a batch), returned in
+// cvs; the last chunk may be partial.
+static size_t metagraph_blake3_chunk_cvs(const uint8_t *input, size_t len,
+                                         uint64_t chunk_counter, uint8_t *cvs) {
+    const uint8_t *inputs[METAGRAPH_BLAKE3_BATCH_CHUNKS];
+    size_t full = len / METAGRAPH_BLAKE3_CHUNK_LEN;
+    // A trailing full chunk is still a chunk; only a remainder is partial.
+    size_t remainder = len - full * METAGRAPH_BLAKE3_CHUNK_LEN;
+    for (size_t i = 0; i < full; i++) {
+        inputs[i] = input + i * METAGRAPH_BLAKE3_CHUNK_LEN;
+    }
+    metagraph_blake3_hash_many(inputs, full, METAGRAPH_BLAKE3_CHUNK_BLOCKS,
+                               chunk_counter, true, 0,
+                               METAGRAPH_BLAKE3_CHUNK_START,
+                               METAGRAPH_BLAKE3_CHUNK_END, cvs);
+    if (remainder > 0) {
+        metagraph_blake3_chunk_t chunk;
+        metagraph_blake3_chunk_init(&chunk, chunk_counter + full);
+        metagraph_blake3_chunk_update(
+            &chunk, input + full * METAGRAPH_BLAKE3_CHUNK_LEN, remainder);
+        const metagraph_blake3_output_t output =
+            metagraph_blake3_chunk_output(&chunk);
+        metagraph_blake3_output_cv(&output,
+                                   cvs + full * METAGRAPH_BLAKE3_OUT_LEN);
+        full++;
+    }
+    return full;
+}
+
+// Pair neighbouring chaining values level by level until two remain. An
+// odd last value moves up unchanged, which yields BLAKE3's left-heavy tree.
+static void metagraph_blake3_reduce_to_pair(uint8_t *cvs, size_t count) {
+    const uint8_t *inputs[METAGRAPH_BLAKE3_BATCH_CHUNKS / 2U];
+    uint8_t parents[METAGRAPH_BLAKE3_BATCH_CHUNKS / 2U *
+                    METAGRAPH_BLAKE3_OUT_LEN];
+    while (count > 2U) {
+        const size_t pairs = count / 2U;
+        for (size_t i = 0; i < pairs; i++) {
+            inputs[i] = cvs + i * 2U * METAGRAPH_BLAKE3_OUT_LEN;
+        }
+        metagraph_blake3_hash_many(inputs, pairs, 1, 0, false,
+                                   METAGRAPH_BLAKE3_PARENT, 0, 0, parents);
+        if (count % 2U != 0) {
+            memcpy(parents + pairs * METAGRAPH_BLAKE3_OUT_LEN,
+                   cvs + (count - 1U) * METAGRAPH_BLAKE3_OUT_LEN,
+                   METAGRAPH_BLAKE3_OUT_LEN);
+        }
+        count = pairs + count % 2U;
+        memcpy(cvs, parents, count * METAGRAPH_BLAKE3_OUT_LEN);
+    }
+}
+
+typedef struct {
+    metagraph_task_t task;
+    metagraph_scheduler_t *scheduler;
+    metagraph_latch_t done;
+    const uint8_t *input;
+    size_t len;
+    uint64_t chunk_counter;
+    uint32_t threads;
+    uint8_t *out_cv;
+} metagraph_blake3_subtree_job_t;
+
+static void metagraph_blake3_subtree_children(
+    const uint8_t *input, size_t len, uint64_t chunk_counter, uint32_t threads,
+    uint8_t out_pair[2U * METAGRAPH_BLAKE3_OUT_LEN]);
+
+static void metagraph_blake3_subtree_job_run(metagraph_task_t *task) {
+    metagraph_blake3_subtree_job_t *job =
+        (metagraph_blake3_subtree_job_t *)(void *)task;
+    metagraph_blake3_subtree_cv(job->input, job->len, job->chunk_counter,
+                                job->threads, job->out_cv);
+    metagraph_scheduler_arrive(job->scheduler, &job->done);
+}
+
+// Chaining values of the two children of the subtree spanning input
+// (len > one chunk).
+static void metagraph_blake3_subtree_children(
+    const uint8_t *input, size_t len, uint64_t chunk_counter, uint32_t threads,
+    uint8_t out_pair[2U * METAGRAPH_BLAKE3_OUT_LEN]) {
+    if (len <= METAGRAPH_BLAKE3_BATCH_CHUNKS * METAGRAPH_BLAKE3_CHUNK_LEN) {
+        uint8_t cvs[METAGRAPH_BLAKE3_BATCH_CHUNKS * METAGRAPH_BLAKE3_OUT_LEN];
+        const size_t count =
+            metagraph_blake3_chunk_cvs(input, len, chunk_counter, cvs);
+        metagraph_blake3_reduce_to_pair(cvs, count);
+        memcpy(out_pair, cvs, 2U * METAGRAPH_BLAKE3_OUT_LEN);
+        return;
+    }
+
+    const size_t left_len = metagraph_blake3_left_len(len);
+    const uint64_t right_counter =
+        chunk_counter + left_len / METAGRAPH_BLAKE3_CHUNK_LEN;
+    uint8_t *right_cv = out_pair + METAGRAPH_BLAKE3_OUT_LEN;
+    metagraph_scheduler_t *scheduler =
+        threads > 1U && len - left_len >= METAGRAPH_BLAKE3_PARALLEL_MIN
+            ? metagraph_scheduler_default()
+            : NULL;
+    if (scheduler) {
+        // Fork the left half; an idle worker picks it up while this
+        // thread hashes the right half.
+        const uint32_t right_threads = threads / 2U;
+        metagraph_blake3_subtree_job_t job = {
+            .task = {.run = metagraph_blake3_subtree_job_run},
+            .scheduler = scheduler,
+            .input = input,
+            .len = left_len,
+            .chunk_counter = chunk_counter,
+            .threads = threads - right_threads,
+            .out_cv = out_pair,
+        };
+        atomic_init(&job.done.pending, 1U);
+        metagraph_scheduler_spawn(scheduler, &job.task);
+        metagraph_blake3_subtree_cv(input + left_len, len - left_len,
+                                    right_counter, right_threads, right_cv);
+        metagraph_scheduler_wait(scheduler, &job.done);
+        return;
+    }
+    metagraph_blake3_subtree_cv(input, left_len, chunk_counter, threads,
+                                out_pair);
+    metagraph_blake3_subtree_cv(input + left_len, len - left_len,
+                                right_counter, threads, right_cv);
+}
+
+void metagraph_blake3_subtree_cv(const uint8_t *input, size_t len,
+                                 uint64_t chunk_counter, uint32_t threads,
+                                 uint8_t out_cv[METAGRAPH_BLAKE3_OUT_LEN]) {
+    if (len <= METAGRAPH_BLAKE3_CHUNK_LEN) {
+        metagraph_blake3_chunk_t chunk;
+        metagraph_blake3_chunk_init(&chunk, chunk_counter);
+        metagraph_blake3_chunk_update(&chunk, input, len);
+        const metagraph_blake3_output_t output =
+            metagraph_blake3_chunk_output(&chunk);
+        metagraph_blake3_output_cv(&output, out_cv);
+        return;
+    }
+    uint8_t pair[2U * METAGRAPH_BLAKE3_OUT_LEN];
+    metagraph_blake3_subtree_children(input, len, chunk_counter, threads,
+                                      pair);
+    metagraph_blake3_parent(pair, pair + METAGRAPH_BLAKE3_OUT_LEN, false,
+                            out_cv);
+}
+
+void metagraph_blake3_root(const uint8_t *input, size_t len, uint32_t threads,
+                           uint8_t out[METAGRAPH_BLAKE3_OUT_LEN]) {
+    if (len <= METAGRAPH_BLAKE3_CHUNK_LEN) {
+        metagraph_blake3_chunk_t chunk;
+        metagraph_blake3_chunk_init(&chunk, 0);
+        metagraph_blake3_chunk_update(&chunk, input, len);
+        const metagraph_blake3_output_t output =
+            metagraph_blake3_chunk_output(&chunk);
+        metagraph_blake3_output_root(&output, out);
+        return;
+    }
+    uint8_t pair[2U * METAGRAPH_BLAKE3_OUT_LEN];
+    metagraph_blake3_subtree_children(input, len, 0, threads, pair);
+    metagraph_blake3_parent(pair, pair + METAGRAPH_BLAKE3_OUT_LEN, true, out);
+}
+
+// ---------------------------------------------------------------------------
+// One-shot API
+// ---------------------------------------------------------------------------
+
+metagraph_result_t
+metagraph_blake3_hash_parallel(const void *data, size_t data_size,
+                               uint32_t thread_count,
+                               metagraph_blake3_hash_t *out_hash) {
+    METAGRAPH_CHECK_NULL(out_hash);
+    if (!data && data_size > 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NULL_POINTER,
+                             "NULL data with non-zero size");
+    }
+    if (thread_count == 0) {
+        thread_count = metagraph_cpu_count();
+    }
+    metagraph_blake3_root(data, data_size, thread_count, out_hash->bytes);
+    return METAGRAPH_OK();
+}
+
+uint32_t metagraph_blake3_thread_budget(size_t len) {
+    const size_t by_size = len / METAGRAPH_BLAKE3_PARALLEL_MIN;
+    if (by_size <= 1U) {
+        return 1;
+    }
+    const uint32_t cpus = metagraph_cpu_count();
+    return by_size < cpus ? (uint32_t)by_size : cpus;
+}
+
+metagraph_result_t metagraph_blake3_hash(const void *data, size_t data_size,
+                                         metagraph_blake3_hash_t *out_hash) {
+    return metagraph_blake3_hash_parallel(
+        data, data_size, metagraph_blake3_thread_budget(data_size), out_hash);
+}
+
+metagraph_result_t
+metagraph_blake3_verify(const void *data, size_t data_size,
+                        const metagraph_blake3_hash_t *expected_hash) {
+    METAGRAPH_CHECK_NULL(expected_hash);
+    metagraph_blake3_hash_t actual;
+    METAGRAPH_CHECK(metagraph_blake3_hash(data, data_size, &actual));
+    if (memcmp(actual.bytes, expected_hash->bytes, sizeof(actual.bytes)) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                             "BLAKE3 hash of %zu bytes does not match",
+                             data_size);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_blake3_hash_to_string(const metagraph_blake3_hash_t *hash,
+                                char *buffer, size_t buffer_size) {
+    METAGRAPH_CHECK_NULL(hash);
+    METAGRAPH_CHECK_NULL(buffer);
+    if (buffer_size < METAGRAPH_BLAKE3_HEX_SIZE) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUFFER_TOO_SMALL,
+                             "Hex hash needs %u bytes, got %zu",
+                             (unsigned)METAGRAPH_BLAKE3_HEX_SIZE, buffer_size);
+    }
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < METAGRAPH_BLAKE3_OUT_LEN; i++) {
+        buffer[2U * i] = digits[hash->bytes[i] >> 4U];
+        buffer[2U * i + 1U] = digits[hash->bytes[i] & 0x0FU];
+    }
+    buffer[2U * METAGRAPH_BLAKE3_OUT_LEN] = '\0';
+    return METAGRAPH_OK();
+}
+
+// ---------------------------------------------------------------------------
+// Streaming API
+// ---------------------------------------------------------------------------
+
+struct metagraph_blake3_context {
+    metagraph_blake3_chunk_t chunk;
+    // Chaining values of completed subtrees, merged lazily so the last
+    // two stay available for the root.
+    uint8_t cv_stack[(METAGRAPH_BLAKE3_MAX_DEPTH + 1U) *
+                     METAGRAPH_BLAKE3_OUT_LEN];
+    size_t cv_stack_len;
+};
+
+static size_t metagraph_blake3_popcount(uint64_t value) {
+    size_t count = 0;
+    while (value) {
+        value &= value - 1U;
+        count++;
+    }
+    return count;
+}
+
+// After `total_chunks` chunks, the stack holds one entry per set bit.
+static void metagraph_blake3_merge_stack(metagraph_blake3_context_t *context,
+                                         uint64_t total_chunks) {
+    const size_t target = metagraph_blake3_popcount(total_chunks);
+    while (context->cv_stack_len > target) {
+        uint8_t *left =
+            context->cv_stack +
+            (context->cv_stack_len - 2U) * METAGRAPH_BLAKE3_OUT_LEN;
+        uint8_t parent[METAGRAPH_BLAKE3_OUT_LEN];
+        metagraph_blake3_parent(left, left + METAGRAPH_BLAKE3_OUT_LEN, false,
+                                parent);
+        memcpy(left, parent, sizeof(parent));
+        context->cv_stack_len--;
+    }
+}
+
+static void metagraph_blake3_push_cv(metagraph_blake3_context_t *context,
+                                     const uint8_t cv[METAGRAPH_BLAKE3_OUT_LEN],
+                                     uint64_t chunk_counter) {
+    metagraph_blake3_merge_stack(context, chunk_counter);
+    memcpy(context->cv_stack + context->cv_stack_len * METAGRAPH_BLAKE3_OUT_LEN,
+           cv, METAGRAPH_BLAKE3_OUT_LEN);
+    context->cv_stack_len++;
+}
+
+metagraph_result_t
+metagraph_blake3_context_create(metagraph_blake3_context_t **out_context) {
+    METAGRAPH_CHECK_NULL(out_context);
+    metagraph_blake3_context_t *context = calloc(1, sizeof(*context));
+    METAGRAPH_CHECK_ALLOC(context);
+    metagraph_blake3_chunk_init(&context->chunk, 0);
+    *out_context = context;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_blake3_context_destroy(metagraph_blake3_context_t *context) {
+    free(context);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_blake3_update(metagraph_blake3_context_t *context,
+                                           const void *data, size_t data_size) {
+    METAGRAPH_CHECK_NULL(context);
+    if (data_size == 0) {
+        return METAGRAPH_OK();
+    }
+    METAGRAPH_CHECK_NULL(data);
+    const uint8_t *input = data;
+
+    // Top up a partially filled chunk first.
+    if (metagraph_blake3_chunk_len(&context->chunk) > 0) {
+        size_t take =
+            METAGRAPH_BLAKE3_CHUNK_LEN - metagraph_blake3_chunk_len(&context->chunk);
+        if (take > data_size) {
+            take = data_size;
+        }
+        metagraph_blake3_chunk_update(&context->chunk, input, take);
+        input += take;
+        data_size -= take;
+        if (data_size == 0) {
+            return METAGRAPH_OK();
+        }
+        uint8_t cv[METAGRAPH_BLAKE3_OUT_LEN];
+        const metagraph_blake3_output_t output =
+            metagraph_blake3_chunk_output(&context->chunk);
+        metagraph_blake3_output_cv(&output, cv);
+        metagraph_blake3_push_cv(context, cv, context->chunk.chunk_counter);
+        metagraph_blake3_chunk_init(&context->chunk,
+                                    context->chunk.chunk_counter + 1U);
+    }
+
+    // Hash whole aligned subtrees directly, keeping at least one byte back
+    // so finalize always has a node to mark as the root.
+    while (data_size > METAGRAPH_BLAKE3_CHUNK_LEN) {
+        size_t subtree_len = METAGRAPH_BLAKE3_CHUNK_LEN;
+        while (subtree_len * 2U <= data_size) {
+            subtree_len *= 2U;
+        }
+        const uint64_t so_far =
+            context->chunk.chunk_counter * METAGRAPH_BLAKE3_CHUNK_LEN;
+        while (((uint64_t)(subtree_len - 1U) & so_far) != 0) {
+            subtree_len /= 2U;
+        }
+        const uint64_t subtree_chunks = subtree_len / METAGRAPH_BLAKE3_CHUNK_LEN;
+        if (subtree_len <= METAGRAPH_BLAKE3_CHUNK_LEN) {
+            uint8_t cv[METAGRAPH_BLAKE3_OUT_LEN];
+            metagraph_blake3_subtree_cv(input, subtree_len,
+                                        context->chunk.chunk_counter, 1, cv);
+            metagraph_blake3_push_cv(context, cv, context->chunk.chunk_counter);
+        } else {
+            uint8_t pair[2U * METAGRAPH_BLAKE3_OUT_LEN];
+            metagraph_blake3_subtree_children(
+                input, subtree_len, context->chunk.chunk_counter, 1, pair);
+            metagraph_blake3_push_cv(context, pair,
+                                     context->chunk.chunk_counter);
+            metagraph_blake3_push_cv(
+                context, pair + METAGRAPH_BLAKE3_OUT_LEN,
+                context->chunk.chunk_counter + subtree_chunks / 2U);
+        }
+        context->chunk.chunk_counter += subtree_chunks;
+        input += subtree_len;
+        data_size -= subtree_len;
+    }
+
+    if (data_size > 0) {
+        metagraph_blake3_chunk_update(&context->chunk, input, data_size);
+        metagraph_blake3_merge_stack(context, context->chunk.chunk_counter);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_blake3_finalize(const metagraph_blake3_context_t *context,
+                          metagraph_blake3_hash_t *out_hash) {
+    METAGRAPH_CHECK_NULL(context);
+    METAGRAPH_CHECK_NULL(out_hash);
+
+    if (context->cv_stack_len == 0) {
+        const metagraph_blake3_output_t output =
+            metagraph_blake3_chunk_output(&context->chunk);
+        metagraph_blake3_output_root(&output, out_hash->bytes);
+        return METAGRAPH_OK();
+    }
+
+    metagraph_blake3_output_t output;
+    size_t remaining = 0;
+    if (metagraph_blake3_chunk_len(&context->chunk) > 0) {
+        remaining = context->cv_stack_len;
+        output = metagraph_blake3_chunk_output(&context->chunk);
+    } else {
+        remaining = context->cv_stack_len - 2U;
+        const uint8_t *left =
+            context->cv_stack + remaining * METAGRAPH_BLAKE3_OUT_LEN;
+        output = metagraph_blake3_parent_output(
+            left, left + METAGRAPH_BLAKE3_OUT_LEN);
+    }
+    while (remaining > 0) {
+        remaining--;
+        uint8_t right[METAGRAPH_BLAKE3_OUT_LEN];
+        metagraph_blake3_output_cv(&output, right);
+        output = metagraph_blake3_parent_output(
+            context->cv_stack + remaining * METAGRAPH_BLAKE3_OUT_LEN, right);
+    }
+    metagraph_blake3_output_root(&output, out_hash->bytes);
+    return METAGRAPH_OK();
+}
@@ -0,0 +1,145 @@
+/**
+ * @file blake3_internal.h
+ * @brief BLAKE3 primitives shared by the hasher, SIMD kernels and Merkle
+ *        trees
+ */
+
+#ifndef SRC_BLAKE3_INTERNAL_H
+#define SRC_BLAKE3_INTERNAL_H
+
+#include "metagraph/integrity.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define METAGRAPH_BLAKE3_BLOCK_LEN 64U
+#define METAGRAPH_BLAKE3_CHUNK_BLOCKS                                          \
+    (METAGRAPH_BLAKE3_CHUNK_LEN / METAGRAPH_BLAKE3_BLOCK_LEN)
+
+// Widest kernel (AVX-512: 16 lanes)
+#define METAGRAPH_BLAKE3_MAX_LANES 16U
+
+// Domain separation flags
+enum {
+    METAGRAPH_BLAKE3_CHUNK_START = 1U << 0U,
+    METAGRAPH_BLAKE3_CHUNK_END = 1U << 1U,
+    METAGRAPH_BLAKE3_PARENT = 1U << 2U,
+    METAGRAPH_BLAKE3_ROOT = 1U << 3U,
+};
+
+extern const uint32_t metagraph_blake3_iv[8];
+extern const uint8_t metagraph_blake3_schedule[7][16];
+
+static inline uint32_t metagraph_blake3_load32(const uint8_t *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static inline void metagraph_blake3_store32(uint8_t *bytes, uint32_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    memcpy(bytes, &value, sizeof(value));
+}
+
+/**
+ * @brief Hash `count` inputs of `blocks` 64-byte blocks each in lockstep
+ *
+ * Writes one 32-byte chaining value per input to out. The counter of input
+ * i is counter + i when increment_counter is set, counter otherwise.
+ * flags_start is added on the first block and flags_end on the last.
+ */
+typedef void (*metagraph_blake3_hash_many_fn)(
+    const uint8_t *const *inputs, size_t count, size_t blocks,
+    const uint32_t key[8], uint64_t counter, bool increment_counter,
+    uint8_t flags, uint8_t flags_start, uint8_t flags_end, uint8_t *out);
+
+/**
+ * @brief Compress one block into cv (the portable kernel's core)
+ */
+void metagraph_blake3_compress_in_place(uint32_t cv[8],
+                                        const uint8_t block[64],
+                                        uint8_t block_len, uint64_t counter,
+                                        uint8_t flags);
+
+/**
+ * @brief Portable hash_many: one input at a time
+ */
+void metagraph_blake3_hash_many_portable(
+    const uint8_t *const *inputs, size_t count, size_t blocks,
+    const uint32_t key[8], uint64_t counter, bool increment_counter,
+    uint8_t flags, uint8_t flags_start, uint8_t flags_end, uint8_t *out);
+
+/**
+ * @brief Kernel for an implementation, or NULL if not compiled in
+ */
+metagraph_blake3_hash_many_fn
+metagraph_blake3_simd_kernel(metagraph_blake3_implementation_t implementation,
+                             size_t *out_lanes);
+
+/**
+ * @brief Whether the running CPU supports an implementation
+ */
+bool metagraph_blake3_cpu_supports(
+    metagraph_blake3_implementation_t implementation);
+
+/**
+ * @brief Chaining value of a non-root subtree
+ *
+ * input must start at chunk chunk_counter and len must not exceed the
+ * largest power-of-two number of chunks chunk_counter is aligned to, i.e.
+ * the range is a complete left subtree or the right edge of the input.
+ * Work is split across up to `threads` threads.
+ */
+void metagraph_blake3_subtree_cv(const uint8_t *input, size_t len,
+                                 uint64_t chunk_counter, uint32_t threads,
+                                 uint8_t out_cv[METAGRAPH_BLAKE3_OUT_LEN]);
+
+/**
+ * @brief Chaining value (or root hash) of a parent node
+ */
+void metagraph_blake3_parent(const uint8_t left[METAGRAPH_BLAKE3_OUT_LEN],
+                             const uint8_t right[METAGRAPH_BLAKE3_OUT_LEN],
+                             bool root, uint8_t out[METAGRAPH_BLAKE3_OUT_LEN]);
+
+/**
+ * @brief Root hash of a whole input on up to `threads` threads
+ */
+void metagraph_blake3_root(const uint8_t *input, size_t len, uint32_t threads,
+                           uint8_t out[METAGRAPH_BLAKE3_OUT_LEN]);
+
+/**
+ * @brief Threads worth using for len bytes (1 below a few MiB)
+ */
+uint32_t metagraph_blake3_thread_budget(size_t len);
+
+/**
+ * @brief Leaves of a Merkle tree over size bytes (at least one)
+ */
+size_t metagraph_merkle_leaf_count(size_t size, size_t chunk_size);
+
+/**
+ * @brief Hash every chunk_size leaf of data on up to `threads` threads
+ *
+ * leaves must hold metagraph_merkle_leaf_count(size, chunk_size) entries.
+ */
+void metagraph_merkle_hash_leaves(const uint8_t *data, size_t size,
+                                  size_t chunk_size, uint32_t threads,
+                                  metagraph_blake3_hash_t *leaves);
+
+/**
+ * @brief Fold two or more leaf chaining values into the root hash
+ *
+ * scratch must hold (count + 1) / 2 entries.
+ */
+void metagraph_merkle_fold(const metagraph_blake3_hash_t *leaves, size_t count,
+                           metagraph_blake3_hash_t *scratch,
+                           metagraph_blake3_hash_t *out_root);
+
+#endif // SRC_BLAKE3_INTERNAL_H
@@ -0,0 +1,140 @@
+/**
+ * @file blake3_kernel.h
+ * @brief Template for a multi-lane BLAKE3 hash_many kernel
+ *
+ * Included once per instruction set by blake3_simd.c with these macros set:
+ *
+ * - METAGRAPH_B3K_FN:     name of the generated hash_many function
+ * - METAGRAPH_B3K_VEC:    name of the vector type to declare
+ * - METAGRAPH_B3K_LANES:  32-bit lanes per vector (4, 8 or 16)
+ * - METAGRAPH_B3K_TARGET: GCC target string ("sse4.1", "avx2", ...)
+ *
+ * Each lane hashes one input, so LANES chunks (or parents) are compressed
+ * per pass. The macros are undefined again at the end of this file.
+ */
+
+// No include guard: this file is meant to be included repeatedly.
+
+typedef uint32_t METAGRAPH_B3K_VEC
+    __attribute__((vector_size(METAGRAPH_B3K_LANES * sizeof(uint32_t))));
+
+#define METAGRAPH_B3K_ROTR(v, n) (((v) >> (n)) | ((v) << (32U - (n))))
+
+#define METAGRAPH_B3K_G(s, a, b, c, d, mx, my)                                 \
+    do {                                                                       \
+        (s)[a] = (s)[a] + (s)[b] + (mx);                                       \
+        (s)[d] = METAGRAPH_B3K_ROTR((s)[d] ^ (s)[a], 16U);                     \
+        (s)[c] = (s)[c] + (s)[d];                                              \
+        (s)[b] = METAGRAPH_B3K_ROTR((s)[b] ^ (s)[c], 12U);                     \
+        (s)[a] = (s)[a] + (s)[b] + (my);                                       \
+        (s)[d] = METAGRAPH_B3K_ROTR((s)[d] ^ (s)[a], 8U);                      \
+        (s)[c] = (s)[c] + (s)[d];                                              \
+        (s)[b] = METAGRAPH_B3K_ROTR((s)[b] ^ (s)[c], 7U);                      \
+    } while (0)
+
+__attribute__((target(METAGRAPH_B3K_TARGET))) static void
+METAGRAPH_B3K_FN(const uint8_t *const *inputs, size_t count, size_t blocks,
+                 const uint32_t key[8], uint64_t counter,
+                 bool increment_counter, uint8_t flags, uint8_t flags_start,
+                 uint8_t flags_end, uint8_t *out) {
+    while (count >= METAGRAPH_B3K_LANES) {
+        uint32_t lanes_lo[METAGRAPH_B3K_LANES];
+        uint32_t lanes_hi[METAGRAPH_B3K_LANES];
+        for (size_t lane = 0; lane < METAGRAPH_B3K_LANES; lane++) {
+            const uint64_t lane_counter =
+                counter + (increment_counter ? lane : 0U);
+            lanes_lo[lane] = (uint32_t)lane_counter;
+            lanes_hi[lane] = (uint32_t)(lane_counter >> 32U);
+        }
+        METAGRAPH_B3K_VEC counter_lo;
+        METAGRAPH_B3K_VEC counter_hi;
+        memcpy(&counter_lo, lanes_lo, sizeof(counter_lo));
+        memcpy(&counter_hi, lanes_hi, sizeof(counter_hi));
+
+        METAGRAPH_B3K_VEC h[8];
+        for (size_t i = 0; i < 8; i++) {
+            h[i] = (METAGRAPH_B3K_VEC){0} + key[i];
+        }
+
+        for (size_t block = 0; block < blocks; block++) {
+            // Transpose: word w of every lane's block into vector m[w].
+            uint32_t words[16][METAGRAPH_B3K_LANES];
+            for (size_t lane = 0; lane < METAGRAPH_B3K_LANES; lane++) {
+                const uint8_t *src =
+                    inputs[lane] + block * METAGRAPH_BLAKE3_BLOCK_LEN;
+                for (size_t w = 0; w < 16; w++) {
+                    words[w][lane] = metagraph_blake3_load32(src + 4U * w);
+                }
+            }
+            METAGRAPH_B3K_VEC m[16];
+            memcpy(m, words, sizeof(m));
+
+            uint32_t block_flags = flags;
+            if (block == 0) {
+                block_flags |= flags_start;
+            }
+            if (block + 1U == blocks) {
+                block_flags |= flags_end;
+            }
+
+            METAGRAPH_B3K_VEC s[16] = {
+                h[0],
+                h[1],
+                h[2],
+                h[3],
+                h[4],
+                h[5],
+                h[6],
+                h[7],
+                (METAGRAPH_B3K_VEC){0} + metagraph_blake3_iv[0],
+                (METAGRAPH_B3K_VEC){0} + metagraph_blake3_iv[1],
+                (METAGRAPH_B3K_VEC){0} + metagraph_blake3_iv[2],
+                (METAGRAPH_B3K_VEC){0} + metagraph_blake3_iv[3],
+                counter_lo,
+                counter_hi,
+                (METAGRAPH_B3K_VEC){0} + METAGRAPH_BLAKE3_BLOCK_LEN,
+                (METAGRAPH_B3K_VEC){0} + block_flags,
+            };
+            for (size_t round = 0; round < 7; round++) {
+                const uint8_t *r = metagraph_blake3_schedule[round];
+                METAGRAPH_B3K_G(s, 0, 4, 8, 12, m[r[0]], m[r[1]]);
+                METAGRAPH_B3K_G(s, 1, 5, 9, 13, m[r[2]], m[r[3]]);
+                METAGRAPH_B3K_G(s, 2, 6, 10, 14, m[r[4]], m[r[5]]);
+                METAGRAPH_B3K_G(s, 3, 7, 11, 15, m[r[6]], m[r[7]]);
+                METAGRAPH_B3K_G(s, 0, 5, 10, 15, m[r[8]], m[r[9]]);
+                METAGRAPH_B3K_G(s, 1, 6, 11, 12, m[r[10]], m[r[11]]);
+                METAGRAPH_B3K_G(s, 2, 7, 8, 13, m[r[12]], m[r[13]]);
+                METAGRAPH_B3K_G(s, 3, 4, 9, 14, m[r[14]], m[r[15]]);
+            }
+            for (size_t i = 0; i < 8; i++) {
+                h[i] = s[i] ^ s[i + 8U];
+            }
+        }
+
+        uint32_t cvs[8][METAGRAPH_B3K_LANES];
+        memcpy(cvs, h, sizeof(cvs));
+        for (size_t lane = 0; lane < METAGRAPH_B3K_LANES; lane++) {
+            for (size_t w = 0; w < 8; w++) {
+                metagraph_blake3_store32(out + 4U * w, cvs[w][lane]);
+            }
+            out += METAGRAPH_BLAKE3_OUT_LEN;
+        }
+
+        inputs += METAGRAPH_B3K_LANES;
+        count -= METAGRAPH_B3K_LANES;
+        if (increment_counter) {
+            counter += METAGRAPH_B3K_LANES;
+        }
+    }
+    // Fewer inputs than lanes: finish one at a time.
+    metagraph_blake3_hash_many_portable(inputs, count, blocks, key, counter,
+                                        increment_counter, flags, flags_start,
+                                        flags_end, out);
+}
+
+#undef METAGRAPH_B3K_G
+#undef METAGRAPH_B3K_ROTR
+#undef METAGRAPH_B3K_FN
+#undef METAGRAPH_B3K_VEC
+#undef METAGRAPH_B3K_LANES
+#undef METAGRAPH_B3K_TARGET
@@ -0,0 +1,89 @@
+/**
+ * @file blake3_simd.c
+ * @brief SSE4.1, AVX2 and AVX-512 BLAKE3 kernels with runtime detection
+ *
+ * The kernels are generated from blake3_kernel.h with GCC vector
+ * extensions and per-function target attributes, so the library itself
+ * builds for the baseline ISA and only the selected kernel ever executes
+ * wider instructions.
+ */
+
+#include "blake3_internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define METAGRAPH_BLAKE3_X86_KERNELS 1
+#endif
+
+#ifdef METAGRAPH_BLAKE3_X86_KERNELS
+
+#define METAGRAPH_B3K_FN metagraph_blake3_hash_many_sse41
+#define METAGRAPH_B3K_VEC metagraph_blake3_vec4_t
+#define METAGRAPH_B3K_LANES 4U
+#define METAGRAPH_B3K_TARGET "sse4.1"
+#include "blake3_kernel.h"
+
+#define METAGRAPH_B3K_FN metagraph_blake3_hash_many_avx2
+#define METAGRAPH_B3K_VEC metagraph_blake3_vec8_t
+#define METAGRAPH_B3K_LANES 8U
+#define METAGRAPH_B3K_TARGET "avx2"
+#include "blake3_kernel.h"
+
+#define METAGRAPH_B3K_FN metagraph_blake3_hash_many_avx512
+#define METAGRAPH_B3K_VEC metagraph_blake3_vec16_t
+#define METAGRAPH_B3K_LANES 16U
+#define METAGRAPH_B3K_TARGET "avx512f"
+#include "blake3_kernel.h"
+
+bool metagraph_blake3_cpu_supports(
+    metagraph_blake3_implementation_t implementation) {
+    __builtin_cpu_init();
+    switch (implementation) {
+    case METAGRAPH_BLAKE3_PORTABLE:
+        return true;
+    case METAGRAPH_BLAKE3_SSE41:
+        return __builtin_cpu_supports("sse4.1") != 0;
+    case METAGRAPH_BLAKE3_AVX2:
+        return __builtin_cpu_supports("avx2") != 0;
+    case METAGRAPH_BLAKE3_AVX512:
+        return __builtin_cpu_supports("avx512f") != 0;
+    default:
+        return false;
+    }
+}
+
+metagraph_blake3_hash_many_fn
+metagraph_blake3_simd_kernel(metagraph_blake3_implementation_t implementation,
+                             size_t *out_lanes) {
+    switch (implementation) {
+    case METAGRAPH_BLAKE3_SSE41:
+        *out_lanes = 4;
+        return metagraph_blake3_hash_many_sse41;
+    case METAGRAPH_BLAKE3_AVX2:
+        *out_lanes = 8;
+        return metagraph_blake3_hash_many_avx2;
+    case METAGRAPH_BLAKE3_AVX512:
+        *out_lanes = METAGRAPH_BLAKE3_MAX_LANES;
+        return metagraph_blake3_hash_many_avx512;
+    case METAGRAPH_BLAKE3_PORTABLE:
+    default:
+        *out_lanes = 1;
+        return NULL;
+    }
+}
+
+#else // !METAGRAPH_BLAKE3_X86_KERNELS
+
+bool metagraph_blake3_cpu_supports(
+    metagraph_blake3_implementation_t implementation) {
+    return implementation == METAGRAPH_BLAKE3_PORTABLE;
+}
+
+metagraph_blake3_hash_many_fn
+metagraph_blake3_simd_kernel(metagraph_blake3_implementation_t implementation,
+                             size_t *out_lanes) {
+    (void)implementation;
+    *out_lanes = 1;
+    return NULL;
+}
+
+#endif // METAGRAPH_BLAKE3_X86_KERNELS
@@ -0,0 +1,2328 @@
+/**
+ * @file bundle.c
+ * @brief Memory-mapped bundle reader with lazy section hydration
+ *
+ * Opening a bundle validates the header and section table only. Typed views
+ * of each section are built on first access under a small per-section state
+ * machine, so untouched sections cost neither page faults nor validation.
+ * Views are pointers into the mapping; nothing is copied.
+ *
+ * The INTEGRITY section hydrates like any other: its own hash is checked
+ * against the header and every section's leaves are folded back to the
+ * recorded root. Leaves are then verified on demand and remembered in a
+ * per-section bitmap, so each leaf is hashed at most once.
+ *
+ * ID and path lookups go through the LOOKUP section's perfect hash tables
+ * when the bundle has one; hydrating it only checks the table shapes.
+ *
+ * A compressed STORE hydrates to an empty decompressed copy and a state
+ * per block. Reading a node decodes the blocks it covers into the copy,
+ * each exactly once, so concurrent readers decode different blocks in
+ * parallel and payloads spanning many blocks are decoded on a worker team.
+ *
+ * An applied delta keeps its base open underneath it. Its node records are
+ * the base's copied once with the delta's patches applied; store reads
+ * below the base's STORE size, and sections the delta inherits, are
+ * answered by the base, so unchanged data is still read in place.
+ *
+ * Accessors report what they touch to a residency tracker once a policy
+ * has attached one; until then the hook is a single pointer load.
+ */
+
+#include "metagraph/bundle.h"
+#include "metagraph/integrity.h"
+#include "metagraph/memory.h"
+#include "metagraph/result.h"
+
+#include "blake3_internal.h"
+#include "bundle_internal.h"
+#include "id_index.h"
+#include "lz.h"
+#include "metrics_internal.h"
+#include "path_internal.h"
+#include "perfect_hash.h"
+#include "platform.h"
+#include "residency_internal.h"
+#include "trace_internal.h"
+#include "work_pool.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Loader bookkeeping is small; one block covers it.
+#define METAGRAPH_BUNDLE_ARENA_SIZE 4096U
+
+// Reads covering this many compressed blocks are decoded on a worker team.
+#define METAGRAPH_BUNDLE_PARALLEL_BLOCKS 8U
+
+// Section hydration states
+enum {
+    METAGRAPH_SECTION_STATE_COLD = 0,
+    METAGRAPH_SECTION_STATE_BUSY = 1,
+    METAGRAPH_SECTION_STATE_READY = 2,
+    METAGRAPH_SECTION_STATE_FAILED = 3,
+};
+
+typedef struct {
+    const metagraph_bundle_node_record_t *records;
+    size_t count;
+    metagraph_bundle_node_record_t *patched; ///< Records of an applied delta
+} metagraph_bundle_nodes_view_t;
+
+typedef struct {
+    const metagraph_bundle_edge_record_t *records;
+    size_t count;
+    const uint32_t *members;
+    size_t member_count;
+    const uint32_t *out_rows;
+    const uint32_t *out_edges;
+    size_t out_count;
+    const uint32_t *in_rows;
+    const uint32_t *in_edges;
+    size_t in_count;
+} metagraph_bundle_edges_view_t;
+
+typedef struct {
+    const int8_t *ctrl;
+    const metagraph_id_slot_t *slots;
+    size_t capacity;
+} metagraph_bundle_index_view_t;
+
+// base and size describe the payload bytes: the section itself, or the
+// decompressed copy when the STORE is compressed.
+typedef struct {
+    const uint8_t *base;
+    size_t size;
+    const uint8_t *packed; ///< Section bytes of a compressed STORE
+    const uint64_t *seek;  ///< block_count + 1 block offsets into packed
+    size_t block_count;
+    uint32_t block_log2;
+    uint8_t *raw; ///< Decompressed copy, filled block by block
+    _Atomic(uint32_t) *block_state; ///< Section hydration states per block
+} metagraph_bundle_store_view_t;
+
+typedef struct {
+    metagraph_perfect_hash_t ids;
+    const metagraph_id_slot_t *id_slots;
+    metagraph_perfect_hash_t paths;
+    const metagraph_bundle_path_slot_t *path_slots;
+} metagraph_bundle_lookup_view_t;
+
+// Merkle tree per covered section type; entry is NULL when not covered.
+typedef struct {
+    const metagraph_bundle_integrity_entry_t *entry[METAGRAPH_SECTION_TYPE_COUNT];
+    const metagraph_blake3_hash_t *leaves[METAGRAPH_SECTION_TYPE_COUNT];
+    _Atomic(uint64_t) *verified[METAGRAPH_SECTION_TYPE_COUNT]; ///< Leaf bits
+    size_t chunk_size;
+} metagraph_bundle_integrity_view_t;
+
+// Lazily built state. Kept behind a pointer so const accessors can fill it.
+typedef struct {
+    _Atomic(uint32_t) state[METAGRAPH_SECTION_TYPE_COUNT];
+    // Why a section failed; written before state turns FAILED.
+    metagraph_result_t failure[METAGRAPH_SECTION_TYPE_COUNT];
+    metagraph_bundle_nodes_view_t nodes;
+    metagraph_bundle_edges_view_t edges;
+    metagraph_bundle_index_view_t index;
+    metagraph_bundle_store_view_t store;
+    metagraph_bundle_lookup_view_t lookup;
+    metagraph_bundle_integrity_view_t integrity;
+    const metagraph_bundle_delta_header_t *delta;
+    _Atomic(metagraph_residency_tracker_t *) tracker;
+} metagraph_bundle_views_t;
+
+struct metagraph_bundle {
+    metagraph_memory_map_t *map;
+    const uint8_t *base;
+    size_t size;
+    uint32_t flags; ///< metagraph_bundle_open_flags_t bits
+    const metagraph_bundle_header_t *header;
+    const metagraph_section_header_t *sections;
+    // Section table entry per type, or UINT32_MAX when absent
+    uint32_t section_slot[METAGRAPH_SECTION_TYPE_COUNT];
+    metagraph_bundle_views_t *views;
+    metagraph_bundle_t *parent; ///< Base of an applied delta (owned)
+    // Owns the bundle, its views and anything built while hydrating;
+    // released in one step by metagraph_bundle_destroy(). Only INTEGRITY
+    // hydration allocates after open, and it runs once, so no lock.
+    metagraph_memory_pool_t *arena;
+};
+
+static metagraph_result_t
+metagraph_bundle_integrity(const metagraph_bundle_t *bundle,
+                           const metagraph_bundle_integrity_view_t **out_view);
+
+void metagraph_bundle_format_uuid_bytes(uint8_t out_uuid[16]) {
+    static const char text[] = METAGRAPH_BUNDLE_FORMAT_UUID;
+    size_t out = 0;
+    int high = -1;
+    for (size_t i = 0; text[i] != '\0' && out < 16U; i++) {
+        const char c = text[i];
+        int nibble;
+        if (c >= '0' && c <= '9') {
+            nibble = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            nibble = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            nibble = c - 'A' + 10;
+        } else {
+            continue;
+        }
+        if (high < 0) {
+            high = nibble;
+        } else {
+            out_uuid[out++] = (uint8_t)((high << 4) | nibble);
+            high = -1;
+        }
+    }
+    while (out < 16U) {
+        out_uuid[out++] = 0;
+    }
+}
+
+// True when [offset, offset + count * element_size) fits inside limit
+static inline bool metagraph_bundle_range_ok(uint64_t offset, uint64_t count,
+                                             uint64_t element_size,
+                                             uint64_t limit) {
+    if (offset > limit) {
+        return false;
+    }
+    if (element_size && count > (limit - offset) / element_size) {
+        return false;
+    }
+    return true;
+}
+
+static metagraph_result_t metagraph_bundle_validate(metagraph_bundle_t *bundle) {
+    if (bundle->size < sizeof(metagraph_bundle_header_t)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Bundle of %zu bytes is smaller than its header",
+                             bundle->size);
+    }
+    if ((uintptr_t)bundle->base % _Alignof(metagraph_bundle_header_t) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ALIGNMENT,
+                             "Bundle data must be 8-byte aligned");
+    }
+
+    const metagraph_bundle_header_t *header =
+        (const metagraph_bundle_header_t *)(const void *)bundle->base;
+    if (memcmp(header->magic, METAGRAPH_BUNDLE_MAGIC,
+               METAGRAPH_BUNDLE_MAGIC_SIZE) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Bad bundle magic");
+    }
+    uint8_t uuid[16];
+    metagraph_bundle_format_uuid_bytes(uuid);
+    if (memcmp(header->format_uuid, uuid, sizeof(uuid)) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_VERSION_MISMATCH,
+                             "Bundle was written for a different format");
+    }
+    if (header->format_version != METAGRAPH_BUNDLE_FORMAT_VERSION) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_VERSION_MISMATCH,
+                             "Bundle format version %u, expected %u",
+                             header->format_version,
+                             (unsigned)METAGRAPH_BUNDLE_FORMAT_VERSION);
+    }
+    if (header->header_checksum != metagraph_bundle_header_checksum(header)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Bundle header checksum mismatch");
+    }
+    if (header->total_size != bundle->size) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Bundle records %llu bytes but %zu are present",
+                             (unsigned long long)header->total_size,
+                             bundle->size);
+    }
+    if (header->section_table_offset % 8U != 0 ||
+        !metagraph_bundle_range_ok(header->section_table_offset,
+                                   header->section_count,
+                                   sizeof(metagraph_section_header_t),
+                                   bundle->size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Section table escapes the bundle");
+    }
+
+    bundle->header = header;
+    bundle->sections =
+        (const metagraph_section_header_t *)(const void *)(bundle->base +
+                                                           header->section_table_offset);
+    for (uint32_t type = 0; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        bundle->section_slot[type] = UINT32_MAX;
+    }
+    for (uint32_t i = 0; i < header->section_count; i++) {
+        const metagraph_section_header_t *section = &bundle->sections[i];
+        if (section->offset % 8U != 0 ||
+            !metagraph_bundle_range_ok(section->offset, section->size, 1U,
+                                       bundle->size)) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                 "Section %u escapes the bundle", i);
+        }
+        // Unknown section types are skipped for forward compatibility.
+        if (section->type < METAGRAPH_SECTION_TYPE_COUNT &&
+            bundle->section_slot[section->type] == UINT32_MAX) {
+            bundle->section_slot[section->type] = i;
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t metagraph_bundle_open(metagraph_memory_map_t *map,
+                                                uint32_t flags,
+                                                metagraph_bundle_t **out_bundle) {
+    const metagraph_pool_config_t arena_config = {
+        .type = METAGRAPH_POOL_TYPE_ARENA,
+        .initial_size = METAGRAPH_BUNDLE_ARENA_SIZE,
+        .allow_growth = true,
+    };
+    metagraph_memory_pool_t *arena = NULL;
+    metagraph_bundle_t *bundle = NULL;
+    metagraph_bundle_views_t *views = NULL;
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(metagraph_memory_pool_create(&arena_config, &arena),
+                         fail);
+    METAGRAPH_CHECK_GOTO(metagraph_memory_pool_alloc(arena, sizeof(*bundle),
+                                                     (void **)&bundle),
+                         fail);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_memory_pool_alloc(arena, sizeof(*views), (void **)&views),
+        fail);
+    memset(bundle, 0, sizeof(*bundle));
+    memset(views, 0, sizeof(*views));
+    for (size_t i = 0; i < METAGRAPH_SECTION_TYPE_COUNT; i++) {
+        atomic_init(&views->state[i], METAGRAPH_SECTION_STATE_COLD);
+    }
+    bundle->map = map;
+    bundle->base = map->base_address;
+    bundle->size = map->mapped_size;
+    bundle->views = views;
+    bundle->arena = arena;
+    bundle->flags = flags;
+
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_validate(bundle), fail);
+    if (flags & METAGRAPH_BUNDLE_OPEN_VERIFY) {
+        // Fail fast on missing or forged integrity data.
+        const metagraph_bundle_integrity_view_t *integrity = NULL;
+        METAGRAPH_CHECK_GOTO(metagraph_bundle_integrity(bundle, &integrity),
+                             fail);
+    }
+    *out_bundle = bundle;
+    return METAGRAPH_OK();
+
+fail:
+    (void)metagraph_memory_pool_destroy(arena);
+    (void)metagraph_mmap_destroy(map);
+    return result;
+}
+
+static metagraph_result_t
+metagraph_bundle_check_host(void) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return METAGRAPH_ERR(METAGRAPH_ERROR_PLATFORM_NOT_SUPPORTED,
+                         "Bundles are little-endian; big-endian hosts are "
+                         "not supported");
+#else
+    return METAGRAPH_OK();
+#endif
+}
+
+metagraph_result_t
+metagraph_bundle_create_from_file(const char *file_path,
+                                  const metagraph_bundle_options_t *options,
+                                  metagraph_bundle_t **out_bundle) {
+    METAGRAPH_CHECK_NULL(file_path);
+    METAGRAPH_CHECK_NULL(out_bundle);
+    *out_bundle = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_check_host());
+
+    const uint32_t flags = options ? options->flags : 0U;
+    const metagraph_mapping_request_t request = {
+        .offset = 0,
+        .size = 0,
+        .access_flags = METAGRAPH_MAP_ACCESS_READ,
+        .cache_flags = (flags & METAGRAPH_BUNDLE_OPEN_POPULATE)
+                           ? (uint32_t)METAGRAPH_MAP_CACHE_POPULATE
+                           : (uint32_t)METAGRAPH_MAP_CACHE_DEFAULT,
+    };
+    METAGRAPH_PROBE1(bundle__open__start, file_path);
+    METAGRAPH_SPAN_BEGIN(span, "bundle_open", 0);
+    metagraph_memory_map_t *map = NULL;
+    metagraph_result_t result =
+        metagraph_mmap_create_from_file(file_path, &request, &map);
+    if (result == METAGRAPH_SUCCESS) {
+        result = metagraph_bundle_open(map, flags, out_bundle);
+    }
+    METAGRAPH_SPAN_END(span);
+    METAGRAPH_PROBE2(bundle__open__done, file_path, (int)result);
+    return result;
+}
+
+metagraph_result_t
+metagraph_bundle_create_from_memory(const void *data, size_t data_size,
+                                    const metagraph_bundle_options_t *options,
+                                    metagraph_bundle_t **out_bundle) {
+    METAGRAPH_CHECK_NULL(data);
+    METAGRAPH_CHECK_NULL(out_bundle);
+    *out_bundle = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_check_host());
+
+    METAGRAPH_PROBE1(bundle__open__start, (const char *)NULL);
+    METAGRAPH_SPAN_BEGIN(span, "bundle_open", 1);
+    // The mapping is created read-only; the cast only satisfies its API.
+    metagraph_memory_map_t *map = NULL;
+    metagraph_result_t result = metagraph_mmap_create_from_memory(
+        (void *)(uintptr_t)data, data_size, false, &map);
+    if (result == METAGRAPH_SUCCESS) {
+        result = metagraph_bundle_open(map, options ? options->flags : 0U,
+                                       out_bundle);
+    }
+    METAGRAPH_SPAN_END(span);
+    METAGRAPH_PROBE2(bundle__open__done, (const char *)NULL, (int)result);
+    return result;
+}
+
+metagraph_result_t metagraph_bundle_destroy(metagraph_bundle_t *bundle) {
+    if (!bundle) {
+        return METAGRAPH_OK();
+    }
+    metagraph_bundle_t *parent = bundle->parent;
+    metagraph_result_t result = metagraph_mmap_destroy(bundle->map);
+    metagraph_aligned_free(bundle->views->store.raw);
+    free(bundle->views->store.block_state);
+    free(bundle->views->nodes.patched);
+    metagraph_residency_tracker_free(
+        atomic_load_explicit(&bundle->views->tracker, memory_order_acquire));
+    (void)metagraph_memory_pool_destroy(bundle->arena);
+    const metagraph_result_t parent_result = metagraph_bundle_destroy(parent);
+    return result != METAGRAPH_SUCCESS ? result : parent_result;
+}
+
+const metagraph_bundle_header_t *
+metagraph_bundle_get_header(const metagraph_bundle_t *bundle) {
+    return bundle ? bundle->header : NULL;
+}
+
+const metagraph_memory_map_t *
+metagraph_bundle_get_map(const metagraph_bundle_t *bundle) {
+    return bundle ? bundle->map : NULL;
+}
+
+static metagraph_result_t
+metagraph_bundle_section(const metagraph_bundle_t *bundle,
+                         metagraph_section_type_t type,
+                         const uint8_t **out_data, uint64_t *out_size) {
+    const uint32_t slot = (uint32_t)type < METAGRAPH_SECTION_TYPE_COUNT
+                              ? bundle->section_slot[type]
+                              : UINT32_MAX;
+    if (slot == UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Bundle has no section of type %u",
+                             (unsigned)type);
+    }
+    *out_data = bundle->base + bundle->sections[slot].offset;
+    *out_size = bundle->sections[slot].size;
+    return METAGRAPH_OK();
+}
+
+// The bundle whose section of this type is read: the bundle itself, or
+// for an applied delta the nearest base when the section is inherited.
+static const metagraph_bundle_t *
+metagraph_bundle_owner(const metagraph_bundle_t *bundle,
+                       metagraph_section_type_t type) {
+    while (bundle->parent && bundle->section_slot[type] == UINT32_MAX &&
+           (bundle->views->delta->inherited_sections & (1U << type))) {
+        bundle = bundle->parent;
+    }
+    return bundle;
+}
+
+bool metagraph_bundle_has_section(const metagraph_bundle_t *bundle,
+                                  metagraph_section_type_t type) {
+    if ((uint32_t)type >= METAGRAPH_SECTION_TYPE_COUNT) {
+        return false;
+    }
+    bundle = metagraph_bundle_owner(bundle, type);
+    return bundle->section_slot[type] != UINT32_MAX;
+}
+
+bool metagraph_bundle_own_section(const metagraph_bundle_t *bundle,
+                                  metagraph_section_type_t type,
+                                  uint64_t *out_offset, uint64_t *out_size,
+                                  uint32_t *out_flags) {
+    const uint32_t slot = (uint32_t)type < METAGRAPH_SECTION_TYPE_COUNT
+                              ? bundle->section_slot[type]
+                              : UINT32_MAX;
+    if (slot == UINT32_MAX) {
+        return false;
+    }
+    // The bundle starts at the mapping's base, so file offsets are map
+    // offsets.
+    *out_offset = bundle->sections[slot].offset;
+    *out_size = bundle->sections[slot].size;
+    *out_flags = bundle->sections[slot].flags;
+    return true;
+}
+
+_Atomic(metagraph_residency_tracker_t *) *
+metagraph_bundle_tracker_slot(const metagraph_bundle_t *bundle) {
+    return &bundle->views->tracker;
+}
+
+// Report an access to the bundle's residency tracker, if it has one.
+static inline void metagraph_bundle_note(const metagraph_bundle_t *bundle,
+                                         metagraph_section_type_t type,
+                                         uint64_t position) {
+    metagraph_residency_tracker_t *tracker =
+        atomic_load_explicit(&bundle->views->tracker, memory_order_acquire);
+    if (tracker) {
+        metagraph_residency_note(tracker, type, position);
+    }
+}
+
+metagraph_result_t metagraph_bundle_get_section(const metagraph_bundle_t *bundle,
+                                                metagraph_section_type_t type,
+                                                const void **out_data,
+                                                size_t *out_size) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_data);
+    METAGRAPH_CHECK_NULL(out_size);
+    if ((uint32_t)type < METAGRAPH_SECTION_TYPE_COUNT) {
+        bundle = metagraph_bundle_owner(bundle, type);
+    }
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(metagraph_bundle_section(bundle, type, &data, &size));
+    *out_data = data;
+    *out_size = (size_t)size;
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Section hydration
+// ============================================================================
+
+static metagraph_result_t
+metagraph_bundle_build_patched_nodes(const metagraph_bundle_t *bundle);
+
+static metagraph_result_t
+metagraph_bundle_build_nodes(const metagraph_bundle_t *bundle) {
+    if (bundle->parent) {
+        return metagraph_bundle_build_patched_nodes(bundle);
+    }
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(
+        metagraph_bundle_section(bundle, METAGRAPH_SECTION_NODES, &data, &size));
+    const uint64_t count = bundle->sections[bundle->section_slot[METAGRAPH_SECTION_NODES]]
+                               .item_count;
+    if (!metagraph_bundle_range_ok(0, count,
+                                   sizeof(metagraph_bundle_node_record_t),
+                                   size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "NODES section too small for %llu records",
+                             (unsigned long long)count);
+    }
+    bundle->views->nodes.records =
+        (const metagraph_bundle_node_record_t *)(const void *)data;
+    bundle->views->nodes.count = (size_t)count;
+    return METAGRAPH_OK();
+}
+
+static bool metagraph_bundle_u32_array_ok(uint64_t offset, uint64_t count,
+                                          uint64_t section_size) {
+    return offset % sizeof(uint32_t) == 0 &&
+           metagraph_bundle_range_ok(offset, count, sizeof(uint32_t),
+                                     section_size);
+}
+
+// Rows must be monotonic and end at the array length so row slices are
+// always in bounds without per-read checks.
+static bool metagraph_bundle_rows_ok(const uint32_t *rows, size_t node_count,
+                                     size_t entry_count) {
+    if (rows[0] != 0 || rows[node_count] != entry_count) {
+        return false;
+    }
+    for (size_t i = 0; i < node_count; i++) {
+        if (rows[i] > rows[i + 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every entry must index into an array of bound elements, so readers can
+// follow members and adjacency lists without per-read checks.
+static bool metagraph_bundle_indices_ok(const uint32_t *values, size_t count,
+                                        size_t bound) {
+    for (size_t i = 0; i < count; i++) {
+        if (values[i] >= bound) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static metagraph_result_t
+metagraph_bundle_build_edges(const metagraph_bundle_t *bundle) {
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(
+        metagraph_bundle_section(bundle, METAGRAPH_SECTION_EDGES, &data, &size));
+    if (size < sizeof(metagraph_bundle_edges_header_t)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "EDGES section too small for its header");
+    }
+    const metagraph_bundle_edges_header_t *header =
+        (const metagraph_bundle_edges_header_t *)(const void *)data;
+    const size_t node_count = bundle->views->nodes.count;
+    if (header->node_count != node_count ||
+        header->records_offset % 8U != 0 ||
+        !metagraph_bundle_range_ok(header->records_offset, header->edge_count,
+                                   sizeof(metagraph_bundle_edge_record_t),
+                                   size) ||
+        !metagraph_bundle_u32_array_ok(header->members_offset,
+                                       header->member_count, size) ||
+        !metagraph_bundle_u32_array_ok(header->out_rows_offset,
+                                       header->node_count + 1U, size) ||
+        !metagraph_bundle_u32_array_ok(header->out_edges_offset,
+                                       header->out_count, size) ||
+        !metagraph_bundle_u32_array_ok(header->in_rows_offset,
+                                       header->node_count + 1U, size) ||
+        !metagraph_bundle_u32_array_ok(header->in_edges_offset,
+                                       header->in_count, size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "EDGES section arrays escape the section");
+    }
+
+    metagraph_bundle_edges_view_t view = {
+        .records = (const metagraph_bundle_edge_record_t *)(const void *)(
+            data + header->records_offset),
+        .count = (size_t)header->edge_count,
+        .members = (const uint32_t *)(const void *)(data + header->members_offset),
+        .member_count = (size_t)header->member_count,
+        .out_rows = (const uint32_t *)(const void *)(data + header->out_rows_offset),
+        .out_edges =
+            (const uint32_t *)(const void *)(data + header->out_edges_offset),
+        .out_count = (size_t)header->out_count,
+        .in_rows = (const uint32_t *)(const void *)(data + header->in_rows_offset),
+        .in_edges = (const uint32_t *)(const void *)(data + header->in_edges_offset),
+        .in_count = (size_t)header->in_count,
+    };
+    if (!metagraph_bundle_rows_ok(view.out_rows, node_count, view.out_count) ||
+        !metagraph_bundle_rows_ok(view.in_rows, node_count, view.in_count)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "EDGES adjacency rows are inconsistent");
+    }
+    if (!metagraph_bundle_indices_ok(view.members, view.member_count,
+                                     node_count)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "EDGES members reference nodes out of range");
+    }
+    if (!metagraph_bundle_indices_ok(view.out_edges, view.out_count,
+                                     view.count) ||
+        !metagraph_bundle_indices_ok(view.in_edges, view.in_count,
+                                     view.count)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "EDGES adjacency references edges out of range");
+    }
+    bundle->views->edges = view;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_build_index(const metagraph_bundle_t *bundle) {
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(
+        metagraph_bundle_section(bundle, METAGRAPH_SECTION_INDEX, &data, &size));
+    if (size < sizeof(metagraph_bundle_index_header_t)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "INDEX section too small for its header");
+    }
+    const metagraph_bundle_index_header_t *header =
+        (const metagraph_bundle_index_header_t *)(const void *)data;
+    const uint64_t capacity = header->capacity;
+    if (capacity < METAGRAPH_ID_INDEX_GROUP || (capacity & (capacity - 1U)) ||
+        header->count >= capacity || header->slots_offset % 8U != 0 ||
+        !metagraph_bundle_range_ok(header->ctrl_offset,
+                                   capacity + METAGRAPH_ID_INDEX_GROUP, 1U,
+                                   size) ||
+        !metagraph_bundle_range_ok(header->slots_offset, capacity,
+                                   sizeof(metagraph_id_slot_t), size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "INDEX section table is malformed");
+    }
+    const int8_t *ctrl =
+        (const int8_t *)(const void *)(data + header->ctrl_offset);
+    // Without an EMPTY control byte a miss would probe forever.
+    if (!metagraph_id_index_ctrl_ok(ctrl, (size_t)capacity)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "INDEX control bytes are malformed");
+    }
+    bundle->views->index.ctrl = ctrl;
+    bundle->views->index.slots =
+        (const metagraph_id_slot_t *)(const void *)(data + header->slots_offset);
+    bundle->views->index.capacity = (size_t)capacity;
+    return METAGRAPH_OK();
+}
+
+// The seek table must be monotonic, stay inside the section and give no
+// block more bytes than it expands to, so decoding a block needs no
+// checks beyond the codec's own.
+static metagraph_result_t
+metagraph_bundle_build_packed_store(const metagraph_bundle_t *bundle,
+                                    const uint8_t *data, uint64_t size) {
+    const bool verify = (bundle->flags & METAGRAPH_BUNDLE_OPEN_VERIFY) != 0;
+    if (size < sizeof(metagraph_bundle_compression_header_t)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "STORE section too small for its compression "
+                             "header");
+    }
+    if (verify) {
+        METAGRAPH_CHECK(metagraph_bundle_verify_range(
+            bundle, METAGRAPH_SECTION_STORE, 0,
+            sizeof(metagraph_bundle_compression_header_t)));
+    }
+    const metagraph_bundle_compression_header_t *header =
+        (const metagraph_bundle_compression_header_t *)(const void *)data;
+    if (header->codec != METAGRAPH_COMPRESSION_LZ) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_COMPRESSION_FAILED,
+                             "STORE uses unknown codec %u",
+                             (unsigned)header->codec);
+    }
+    if (header->block_log2 < METAGRAPH_BUNDLE_MIN_BLOCK_LOG2 ||
+        header->block_log2 > METAGRAPH_BUNDLE_MAX_BLOCK_LOG2 ||
+        header->raw_size > SIZE_MAX / 2U ||
+        header->block_count !=
+            (header->raw_size + ((uint64_t)1U << header->block_log2) - 1U) >>
+                header->block_log2 ||
+        header->seek_offset % 8U != 0 ||
+        !metagraph_bundle_range_ok(header->seek_offset,
+                                   header->block_count + 1U, sizeof(uint64_t),
+                                   size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "STORE compression header is malformed");
+    }
+    const size_t block_count = (size_t)header->block_count;
+    const uint64_t seek_size = (header->block_count + 1U) * sizeof(uint64_t);
+    if (verify) {
+        METAGRAPH_CHECK(metagraph_bundle_verify_range(
+            bundle, METAGRAPH_SECTION_STORE, header->seek_offset, seek_size));
+    }
+    const uint64_t *seek =
+        (const uint64_t *)(const void *)(data + header->seek_offset);
+    const uint64_t block_size = (uint64_t)1U << header->block_log2;
+    bool seek_ok = seek[0] >= header->seek_offset + seek_size &&
+                   seek[block_count] <= size;
+    for (size_t i = 0; seek_ok && i < block_count; i++) {
+        const uint64_t remaining = header->raw_size - (uint64_t)i * block_size;
+        const uint64_t length = remaining < block_size ? remaining : block_size;
+        seek_ok = seek[i] <= seek[i + 1U] && seek[i + 1U] - seek[i] <= length;
+    }
+    if (!seek_ok) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "STORE seek table is malformed");
+    }
+
+    metagraph_bundle_store_view_t *view = &bundle->views->store;
+    // Pages of the copy are only touched as blocks are decoded.
+    view->raw = metagraph_aligned_alloc(
+        METAGRAPH_BUNDLE_DATA_ALIGN,
+        header->raw_size ? (size_t)header->raw_size : 1U);
+    view->block_state = malloc((block_count ? block_count : 1U) *
+                               sizeof(*view->block_state));
+    if (!view->raw || !view->block_state) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Cannot reserve %llu bytes for the decompressed "
+                             "STORE",
+                             (unsigned long long)header->raw_size);
+    }
+    for (size_t i = 0; i < block_count; i++) {
+        atomic_init(&view->block_state[i], METAGRAPH_SECTION_STATE_COLD);
+    }
+    view->packed = data;
+    view->seek = seek;
+    view->block_count = block_count;
+    view->block_log2 = header->block_log2;
+    view->base = view->raw;
+    view->size = (size_t)header->raw_size;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_build_store(const metagraph_bundle_t *bundle) {
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(
+        metagraph_bundle_section(bundle, METAGRAPH_SECTION_STORE, &data, &size));
+    const metagraph_section_header_t *section =
+        &bundle->sections[bundle->section_slot[METAGRAPH_SECTION_STORE]];
+    if (section->flags & METAGRAPH_SECTION_FLAG_COMPRESSED) {
+        return metagraph_bundle_build_packed_store(bundle, data, size);
+    }
+    bundle->views->store.base = data;
+    bundle->views->store.size = (size_t)size;
+    return METAGRAPH_OK();
+}
+
+// Shapes must match what the writer derives from the key count, and every
+// remapped slot must be in range, so lookups need no bounds checks.
+static bool
+metagraph_bundle_lookup_table_ok(const uint8_t *data, uint64_t size,
+                                 const metagraph_bundle_lookup_table_t *table,
+                                 uint64_t slot_size) {
+    uint64_t bucket_count = 0;
+    uint64_t table_size = 0;
+    metagraph_perfect_hash_shape(table->key_count, &bucket_count, &table_size);
+    if (table->key_count >= UINT32_MAX ||
+        table->bucket_count != bucket_count ||
+        table->table_size != table_size || table->slots_offset % 8U != 0 ||
+        !metagraph_bundle_u32_array_ok(table->pilots_offset, bucket_count,
+                                       size) ||
+        !metagraph_bundle_u32_array_ok(table->remap_offset,
+                                       table_size - table->key_count, size) ||
+        !metagraph_bundle_range_ok(table->slots_offset, table->key_count,
+                                   slot_size, size)) {
+        return false;
+    }
+    const uint32_t *remap =
+        (const uint32_t *)(const void *)(data + table->remap_offset);
+    for (uint64_t i = 0; i < table_size - table->key_count; i++) {
+        if (remap[i] >= table->key_count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static metagraph_perfect_hash_t
+metagraph_bundle_lookup_table(const uint8_t *data,
+                              const metagraph_bundle_lookup_table_t *table) {
+    return (metagraph_perfect_hash_t){
+        .seed = table->seed,
+        .key_count = table->key_count,
+        .bucket_count = table->bucket_count,
+        .table_size = table->table_size,
+        .pilots = (const uint32_t *)(const void *)(data + table->pilots_offset),
+        .remap = (const uint32_t *)(const void *)(data + table->remap_offset),
+    };
+}
+
+static metagraph_result_t
+metagraph_bundle_build_lookup(const metagraph_bundle_t *bundle) {
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(
+        metagraph_bundle_section(bundle, METAGRAPH_SECTION_LOOKUP, &data, &size));
+    if (size < sizeof(metagraph_bundle_lookup_header_t)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "LOOKUP section too small for its header");
+    }
+    const metagraph_bundle_lookup_header_t *header =
+        (const metagraph_bundle_lookup_header_t *)(const void *)data;
+    if (!metagraph_bundle_lookup_table_ok(data, size, &header->ids,
+                                          sizeof(metagraph_id_slot_t)) ||
+        !metagraph_bundle_lookup_table_ok(data, size, &header->paths,
+                                          sizeof(metagraph_bundle_path_slot_t))) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "LOOKUP section tables are malformed");
+    }
+    metagraph_bundle_lookup_view_t *view = &bundle->views->lookup;
+    view->ids = metagraph_bundle_lookup_table(data, &header->ids);
+    view->id_slots = (const metagraph_id_slot_t *)(const void *)(
+        data + header->ids.slots_offset);
+    view->paths = metagraph_bundle_lookup_table(data, &header->paths);
+    view->path_slots = (const metagraph_bundle_path_slot_t *)(const void *)(
+        data + header->paths.slots_offset);
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Integrity
+// ============================================================================
+
+metagraph_result_t metagraph_bundle_integrity_digest(
+    const metagraph_bundle_header_t *header,
+    const metagraph_section_header_t *sections, const void *integrity,
+    size_t integrity_size, metagraph_blake3_hash_t *out_hash) {
+    metagraph_bundle_header_t copy;
+    memcpy(&copy, header, sizeof(copy));
+    copy.header_checksum = 0;
+    memset(copy.integrity_hash, 0, sizeof(copy.integrity_hash));
+
+    metagraph_blake3_context_t *context = NULL;
+    METAGRAPH_CHECK(metagraph_blake3_context_create(&context));
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(metagraph_blake3_update(context, &copy, sizeof(copy)),
+                         done);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_blake3_update(context, sections,
+                                copy.section_count * sizeof(*sections)),
+        done);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_blake3_update(context, integrity, integrity_size), done);
+    METAGRAPH_CHECK_GOTO(metagraph_blake3_finalize(context, out_hash), done);
+done:
+    (void)metagraph_blake3_context_destroy(context);
+    return result;
+}
+
+static bool metagraph_bundle_has_integrity(const metagraph_bundle_t *bundle) {
+    if (bundle->section_slot[METAGRAPH_SECTION_INTEGRITY] == UINT32_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(bundle->header->integrity_hash); i++) {
+        if (bundle->header->integrity_hash[i] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Structural checks of one entry against the section it covers
+static metagraph_result_t
+metagraph_bundle_check_entry(const metagraph_bundle_t *bundle,
+                             const metagraph_bundle_integrity_entry_t *entry,
+                             size_t chunk_size, uint64_t integrity_size) {
+    const metagraph_bundle_integrity_view_t *view = &bundle->views->integrity;
+    if (entry->type >= METAGRAPH_SECTION_TYPE_COUNT ||
+        entry->type == METAGRAPH_SECTION_INTEGRITY ||
+        bundle->section_slot[entry->type] == UINT32_MAX ||
+        view->entry[entry->type] != NULL) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "INTEGRITY entry for section type %u is invalid",
+                             entry->type);
+    }
+    const metagraph_section_header_t *section =
+        &bundle->sections[bundle->section_slot[entry->type]];
+    if (entry->leaf_count !=
+            metagraph_merkle_leaf_count((size_t)section->size, chunk_size) ||
+        !metagraph_bundle_range_ok(entry->leaves_offset, entry->leaf_count,
+                                   sizeof(metagraph_blake3_hash_t),
+                                   integrity_size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "INTEGRITY leaves of section type %u are "
+                             "malformed",
+                             entry->type);
+    }
+    if (section->checksum != metagraph_bundle_section_checksum(entry->root)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                             "Section type %u checksum disagrees with its "
+                             "Merkle root",
+                             entry->type);
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_build_integrity(const metagraph_bundle_t *bundle) {
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(metagraph_bundle_section(bundle, METAGRAPH_SECTION_INTEGRITY,
+                                             &data, &size));
+    if (size < sizeof(metagraph_bundle_integrity_header_t)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "INTEGRITY section too small for its header");
+    }
+    metagraph_blake3_hash_t digest;
+    METAGRAPH_CHECK(metagraph_bundle_integrity_digest(
+        bundle->header, bundle->sections, data, (size_t)size, &digest));
+    if (memcmp(digest.bytes, bundle->header->integrity_hash,
+               sizeof(digest.bytes)) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                             "Bundle integrity hash mismatch");
+    }
+
+    const metagraph_bundle_integrity_header_t *header =
+        (const metagraph_bundle_integrity_header_t *)(const void *)data;
+    if (header->chunk_log2 < METAGRAPH_BUNDLE_MIN_CHUNK_LOG2 ||
+        header->chunk_log2 > METAGRAPH_BUNDLE_MAX_CHUNK_LOG2 ||
+        !metagraph_bundle_range_ok(sizeof(*header), header->entry_count,
+                                   sizeof(metagraph_bundle_integrity_entry_t),
+                                   size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "INTEGRITY section header is malformed");
+    }
+
+    metagraph_bundle_integrity_view_t *view = &bundle->views->integrity;
+    view->chunk_size = (size_t)1U << header->chunk_log2;
+    const metagraph_bundle_integrity_entry_t *entries =
+        (const metagraph_bundle_integrity_entry_t *)(const void *)(data +
+                                                                   sizeof(*header));
+    size_t max_leaves = 1;
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        const metagraph_bundle_integrity_entry_t *entry = &entries[i];
+        METAGRAPH_CHECK(
+            metagraph_bundle_check_entry(bundle, entry, view->chunk_size, size));
+        const size_t leaf_count = (size_t)entry->leaf_count;
+        void *bits = NULL;
+        const size_t words = (leaf_count + 63U) / 64U;
+        METAGRAPH_CHECK(metagraph_memory_pool_alloc(
+            bundle->arena, words * sizeof(_Atomic(uint64_t)), &bits));
+        view->verified[entry->type] = bits;
+        for (size_t w = 0; w < words; w++) {
+            atomic_init(&view->verified[entry->type][w], 0);
+        }
+        view->entry[entry->type] = entry;
+        view->leaves[entry->type] =
+            (const metagraph_blake3_hash_t *)(const void *)(data +
+                                                            entry->leaves_offset);
+        max_leaves = leaf_count > max_leaves ? leaf_count : max_leaves;
+    }
+
+    // Leaves must fold to the recorded roots. Single-leaf sections are
+    // checked against their root when the leaf itself is verified.
+    metagraph_arena_checkpoint_t checkpoint;
+    METAGRAPH_CHECK(metagraph_arena_checkpoint(bundle->arena, &checkpoint));
+    void *storage = NULL;
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(
+        metagraph_memory_pool_alloc(bundle->arena,
+                                    (max_leaves + 1U) / 2U *
+                                        sizeof(metagraph_blake3_hash_t),
+                                    &storage),
+        done);
+    for (uint32_t type = 0; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        const metagraph_bundle_integrity_entry_t *entry = view->entry[type];
+        if (!entry || entry->leaf_count < 2U) {
+            continue;
+        }
+        metagraph_blake3_hash_t root;
+        metagraph_merkle_fold(view->leaves[type], (size_t)entry->leaf_count,
+                              storage, &root);
+        if (memcmp(root.bytes, entry->root, sizeof(root.bytes)) != 0) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                                   "Merkle leaves of section type %u do not "
+                                   "match its root",
+                                   type);
+            break;
+        }
+    }
+done:
+    (void)metagraph_arena_restore(bundle->arena, &checkpoint);
+    return result;
+}
+
+typedef metagraph_result_t (*metagraph_bundle_builder_fn)(
+    const metagraph_bundle_t *bundle);
+
+static metagraph_result_t
+metagraph_bundle_verify_leaves(const metagraph_bundle_t *bundle,
+                               metagraph_section_type_t type, size_t first,
+                               size_t last);
+
+// Build a section view exactly once. Racing callers wait for the winner,
+// which may be validating rows or, with METAGRAPH_BUNDLE_OPEN_VERIFY,
+// hashing the whole section; they back off to yielding so a long build
+// does not also cost every waiter a core.
+static metagraph_result_t
+metagraph_bundle_hydrate(const metagraph_bundle_t *bundle,
+                         metagraph_section_type_t type,
+                         metagraph_bundle_builder_fn build) {
+    _Atomic(uint32_t) *state = &bundle->views->state[type];
+    uint32_t current = atomic_load_explicit(state, memory_order_acquire);
+    if (current == METAGRAPH_SECTION_STATE_READY) {
+        return METAGRAPH_OK();
+    }
+
+    uint32_t spins = 0;
+    for (;;) {
+        if (current == METAGRAPH_SECTION_STATE_COLD &&
+            atomic_compare_exchange_weak_explicit(
+                state, &current, METAGRAPH_SECTION_STATE_BUSY,
+                memory_order_acquire, memory_order_acquire)) {
+            METAGRAPH_PROBE2(section__load__start, bundle, (unsigned)type);
+            METAGRAPH_SPAN_BEGIN(span, "section_load", type);
+            const uint64_t start = metagraph_monotonic_ns();
+            uint64_t minor_faults = 0;
+            uint64_t major_faults = 0;
+            metagraph_page_faults(&minor_faults, &major_faults);
+            metagraph_result_t result = METAGRAPH_SUCCESS;
+            if ((bundle->flags & METAGRAPH_BUNDLE_OPEN_VERIFY) &&
+                bundle->section_slot[type] != UINT32_MAX &&
+                type != METAGRAPH_SECTION_STORE &&
+                type != METAGRAPH_SECTION_INTEGRITY) {
+                // Store payloads are verified per read instead.
+                result = metagraph_bundle_verify_leaves(bundle, type, 0,
+                                                        SIZE_MAX);
+            }
+            if (result == METAGRAPH_SUCCESS) {
+                result = build(bundle);
+            }
+            uint64_t minor_after = 0;
+            uint64_t major_after = 0;
+            metagraph_page_faults(&minor_after, &major_after);
+            metagraph_metrics_add(METAGRAPH_COUNTER_HYDRATIONS, 1U);
+            metagraph_metrics_add(METAGRAPH_COUNTER_MINOR_FAULTS,
+                                  minor_after - minor_faults);
+            metagraph_metrics_add(METAGRAPH_COUNTER_MAJOR_FAULTS,
+                                  major_after - major_faults);
+            metagraph_metrics_record(METAGRAPH_HISTOGRAM_HYDRATION,
+                                     metagraph_monotonic_ns() - start);
+            METAGRAPH_SPAN_END(span);
+            METAGRAPH_PROBE3(section__load__done, bundle, (unsigned)type,
+                             (int)result);
+            bundle->views->failure[type] = result;
+            atomic_store_explicit(state,
+                                  result == METAGRAPH_SUCCESS
+                                      ? METAGRAPH_SECTION_STATE_READY
+                                      : METAGRAPH_SECTION_STATE_FAILED,
+                                  memory_order_release);
+            return result;
+        }
+        if (current == METAGRAPH_SECTION_STATE_READY) {
+            return METAGRAPH_OK();
+        }
+        if (current == METAGRAPH_SECTION_STATE_FAILED) {
+            return METAGRAPH_ERR(bundle->views->failure[type],
+                                 "Section of type %u failed validation",
+                                 (unsigned)type);
+        }
+        if (current == METAGRAPH_SECTION_STATE_BUSY) {
+            metagraph_backoff(&spins);
+        }
+        current = atomic_load_explicit(state, memory_order_acquire);
+    }
+}
+
+static metagraph_result_t
+metagraph_bundle_integrity(const metagraph_bundle_t *bundle,
+                           const metagraph_bundle_integrity_view_t **out_view) {
+    if (!metagraph_bundle_has_integrity(bundle)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                             "Bundle carries no integrity data");
+    }
+    METAGRAPH_CHECK(metagraph_bundle_hydrate(bundle, METAGRAPH_SECTION_INTEGRITY,
+                                             metagraph_bundle_build_integrity));
+    *out_view = &bundle->views->integrity;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_check_leaves(const metagraph_bundle_t *bundle,
+                              metagraph_section_type_t type, size_t first,
+                              size_t last) {
+    const metagraph_bundle_integrity_view_t *view = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_integrity(bundle, &view));
+    const metagraph_bundle_integrity_entry_t *entry = view->entry[type];
+    if (!entry) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Section type %u is not covered by the "
+                             "INTEGRITY section",
+                             (unsigned)type);
+    }
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(metagraph_bundle_section(bundle, type, &data, &size));
+    const size_t leaf_count = (size_t)entry->leaf_count;
+    if (last >= leaf_count) {
+        last = leaf_count - 1U;
+    }
+
+    _Atomic(uint64_t) *bits = view->verified[type];
+    for (size_t i = first; i <= last; i++) {
+        const uint64_t mask = 1ULL << (i % 64U);
+        if (atomic_load_explicit(&bits[i / 64U], memory_order_acquire) & mask) {
+            continue;
+        }
+        const size_t offset = i * view->chunk_size;
+        const size_t remaining = (size_t)size - offset;
+        const size_t length =
+            remaining < view->chunk_size ? remaining : view->chunk_size;
+        metagraph_blake3_hash_t actual;
+        const uint8_t *expected = NULL;
+        if (leaf_count == 1U) {
+            metagraph_blake3_root(data, length, 1, actual.bytes);
+            expected = entry->root;
+        } else {
+            metagraph_blake3_subtree_cv(data + offset, length,
+                                        offset / METAGRAPH_BLAKE3_CHUNK_LEN, 1,
+                                        actual.bytes);
+            expected = view->leaves[type][i].bytes;
+        }
+        if (memcmp(actual.bytes, expected, sizeof(actual.bytes)) != 0) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                                 "Section type %u chunk %zu fails "
+                                 "verification",
+                                 (unsigned)type, i);
+        }
+        atomic_fetch_or_explicit(&bits[i / 64U], mask, memory_order_release);
+    }
+    return METAGRAPH_OK();
+}
+
+// Verify leaves [first, last] of a section (last is clamped), skipping
+// leaves already verified.
+static metagraph_result_t
+metagraph_bundle_verify_leaves(const metagraph_bundle_t *bundle,
+                               metagraph_section_type_t type, size_t first,
+                               size_t last) {
+    METAGRAPH_PROBE4(verify__start, bundle, (unsigned)type, first, last);
+    METAGRAPH_SPAN_BEGIN(span, "verify", type);
+    const metagraph_result_t result =
+        metagraph_bundle_check_leaves(bundle, type, first, last);
+    METAGRAPH_SPAN_END(span);
+    METAGRAPH_PROBE3(verify__done, bundle, (unsigned)type, (int)result);
+    return result;
+}
+
+metagraph_result_t metagraph_bundle_verify_range(const metagraph_bundle_t *bundle,
+                                                 metagraph_section_type_t type,
+                                                 uint64_t offset, uint64_t size) {
+    METAGRAPH_CHECK_NULL(bundle);
+    const uint8_t *data = NULL;
+    uint64_t section_size = 0;
+    METAGRAPH_CHECK(metagraph_bundle_section(bundle, type, &data, &section_size));
+    if (!metagraph_bundle_range_ok(offset, size, 1U, section_size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Range escapes section type %u", (unsigned)type);
+    }
+    const metagraph_bundle_integrity_view_t *view = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_integrity(bundle, &view));
+    if (size == 0) {
+        return METAGRAPH_OK();
+    }
+    return metagraph_bundle_verify_leaves(
+        bundle, type, (size_t)(offset / view->chunk_size),
+        (size_t)((offset + size - 1U) / view->chunk_size));
+}
+
+static metagraph_result_t
+metagraph_bundle_verify_all(const metagraph_bundle_t *bundle,
+                            const metagraph_blake3_hash_t *expected_hash) {
+    if (expected_hash &&
+        memcmp(expected_hash->bytes, bundle->header->integrity_hash,
+               sizeof(expected_hash->bytes)) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                             "Bundle integrity hash differs from the "
+                             "expected hash");
+    }
+    const metagraph_bundle_integrity_view_t *view = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_integrity(bundle, &view));
+
+    for (uint32_t type = 0; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        const metagraph_bundle_integrity_entry_t *entry = view->entry[type];
+        if (!entry) {
+            continue;
+        }
+        if (entry->leaf_count == 1U) {
+            METAGRAPH_CHECK(metagraph_bundle_verify_leaves(
+                bundle, (metagraph_section_type_t)type, 0, 0));
+            continue;
+        }
+        // Hash every leaf on all CPUs, then compare in one pass.
+        const uint8_t *data = NULL;
+        uint64_t size = 0;
+        METAGRAPH_CHECK(metagraph_bundle_section(
+            bundle, (metagraph_section_type_t)type, &data, &size));
+        const size_t leaf_count = (size_t)entry->leaf_count;
+        metagraph_blake3_hash_t *actual =
+            malloc(leaf_count * sizeof(metagraph_blake3_hash_t));
+        METAGRAPH_CHECK_ALLOC(actual);
+        metagraph_merkle_hash_leaves(data, (size_t)size, view->chunk_size,
+                                     metagraph_blake3_thread_budget(
+                                         (size_t)size),
+                                     actual);
+        size_t bad = SIZE_MAX;
+        for (size_t i = 0; i < leaf_count; i++) {
+            if (memcmp(actual[i].bytes, view->leaves[type][i].bytes,
+                       sizeof(actual[i].bytes)) != 0) {
+                bad = i;
+                break;
+            }
+            atomic_fetch_or_explicit(&view->verified[type][i / 64U],
+                                     1ULL << (i % 64U), memory_order_release);
+        }
+        free(actual);
+        if (bad != SIZE_MAX) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                                 "Section type %u chunk %zu fails "
+                                 "verification",
+                                 type, bad);
+        }
+    }
+    return bundle->parent ? metagraph_bundle_verify_integrity(bundle->parent,
+                                                              NULL)
+                          : METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_bundle_verify_integrity(const metagraph_bundle_t *bundle,
+                                  const metagraph_blake3_hash_t *expected_hash) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_PROBE1(verify__bundle__start, bundle);
+    METAGRAPH_SPAN_BEGIN(span, "verify_bundle", 0);
+    const metagraph_result_t result =
+        metagraph_bundle_verify_all(bundle, expected_hash);
+    METAGRAPH_SPAN_END(span);
+    METAGRAPH_PROBE2(verify__bundle__done, bundle, (int)result);
+    return result;
+}
+
+static inline metagraph_result_t
+metagraph_bundle_nodes(const metagraph_bundle_t *bundle,
+                       const metagraph_bundle_nodes_view_t **out_view) {
+    // Checked before hydrating so the failure is not cached past the
+    // delta being applied.
+    if ((bundle->header->flags & METAGRAPH_BUNDLE_FLAG_DELTA) &&
+        !bundle->parent) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                             "Delta bundle has no base applied");
+    }
+    METAGRAPH_CHECK(metagraph_bundle_hydrate(bundle, METAGRAPH_SECTION_NODES,
+                                             metagraph_bundle_build_nodes));
+    *out_view = &bundle->views->nodes;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_edges(const metagraph_bundle_t *bundle,
+                       const metagraph_bundle_edges_view_t **out_view) {
+    // Row arrays are validated against the node count.
+    const metagraph_bundle_nodes_view_t *nodes = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_nodes(bundle, &nodes));
+    const metagraph_bundle_t *owner =
+        metagraph_bundle_owner(bundle, METAGRAPH_SECTION_EDGES);
+    if (owner != bundle) {
+        METAGRAPH_CHECK(metagraph_bundle_edges(owner, out_view));
+        if (owner->views->nodes.count != nodes->count) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                 "Inherited EDGES cover %zu nodes, not %zu",
+                                 owner->views->nodes.count, nodes->count);
+        }
+        return METAGRAPH_OK();
+    }
+    METAGRAPH_CHECK(metagraph_bundle_hydrate(bundle, METAGRAPH_SECTION_EDGES,
+                                             metagraph_bundle_build_edges));
+    *out_view = &bundle->views->edges;
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Compressed STORE
+// ============================================================================
+
+static metagraph_result_t
+metagraph_bundle_decode_block(const metagraph_bundle_t *bundle, size_t block) {
+    const metagraph_bundle_store_view_t *store = &bundle->views->store;
+    const size_t block_size = (size_t)1U << store->block_log2;
+    const size_t offset = block << store->block_log2;
+    const size_t remaining = store->size - offset;
+    const size_t length = remaining < block_size ? remaining : block_size;
+    const uint64_t begin = store->seek[block];
+    const size_t packed_size = (size_t)(store->seek[block + 1U] - begin);
+    if (bundle->flags & METAGRAPH_BUNDLE_OPEN_VERIFY) {
+        METAGRAPH_CHECK(metagraph_bundle_verify_range(
+            bundle, METAGRAPH_SECTION_STORE, begin, packed_size));
+    }
+    if (packed_size == length) {
+        memcpy(store->raw + offset, store->packed + begin, length);
+    } else if (!metagraph_lz_decompress(store->packed + begin, packed_size,
+                                        store->raw + offset, length)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_COMPRESSION_FAILED,
+                             "STORE block %zu does not decode", block);
+    }
+    return METAGRAPH_OK();
+}
+
+// Decode a block exactly once. Racing readers wait for the winner; a
+// block that fails goes back to cold, so every reader sees the failure.
+static metagraph_result_t
+metagraph_bundle_inflate_block(const metagraph_bundle_t *bundle, size_t block) {
+    _Atomic(uint32_t) *state = &bundle->views->store.block_state[block];
+    uint32_t current = atomic_load_explicit(state, memory_order_acquire);
+    uint32_t spins = 0;
+    for (;;) {
+        if (current == METAGRAPH_SECTION_STATE_READY) {
+            return METAGRAPH_OK();
+        }
+        if (current == METAGRAPH_SECTION_STATE_COLD &&
+            atomic_compare_exchange_weak_explicit(
+                state, &current, METAGRAPH_SECTION_STATE_BUSY,
+                memory_order_acquire, memory_order_acquire)) {
+            const metagraph_result_t result =
+                metagraph_bundle_decode_block(bundle, block);
+            atomic_store_explicit(state,
+                                  result == METAGRAPH_SUCCESS
+                                      ? METAGRAPH_SECTION_STATE_READY
+                                      : METAGRAPH_SECTION_STATE_COLD,
+                                  memory_order_release);
+            return result;
+        }
+        if (current == METAGRAPH_SECTION_STATE_BUSY) {
+            metagraph_backoff(&spins);
+        }
+        current = atomic_load_explicit(state, memory_order_acquire);
+    }
+}
+
+typedef struct {
+    const metagraph_bundle_t *bundle;
+    const size_t *blocks; ///< Blocks to decode, or NULL for a run
+    size_t first;         ///< First block of the run
+    atomic_flag failed;
+    metagraph_error_context_t error; ///< First failure, for the caller
+} metagraph_bundle_inflate_job_t;
+
+static void metagraph_bundle_inflate_range(void *context, uint32_t worker,
+                                           size_t begin, size_t end) {
+    (void)worker;
+    metagraph_bundle_inflate_job_t *job = context;
+    for (size_t i = begin; i < end; i++) {
+        const size_t block = job->blocks ? job->blocks[i] : job->first + i;
+        const metagraph_result_t result =
+            metagraph_bundle_inflate_block(job->bundle, block);
+        // Error contexts are thread-local; keep the first for the caller.
+        if (metagraph_result_is_error(result) &&
+            !atomic_flag_test_and_set(&job->failed)) {
+            (void)metagraph_get_error_context(&job->error);
+            job->error.code = result;
+            return;
+        }
+    }
+}
+
+// Decode count blocks, listed in blocks or running from first, on up to
+// thread_count threads (0 = one per CPU).
+static metagraph_result_t
+metagraph_bundle_inflate_blocks(const metagraph_bundle_t *bundle,
+                                const size_t *blocks, size_t first,
+                                size_t count, uint32_t thread_count) {
+    uint32_t threads = thread_count ? thread_count : metagraph_cpu_count();
+    if (threads > count) {
+        threads = (uint32_t)count;
+    }
+    if (threads <= 1U) {
+        for (size_t i = 0; i < count; i++) {
+            METAGRAPH_CHECK(metagraph_bundle_inflate_block(
+                bundle, blocks ? blocks[i] : first + i));
+        }
+        return METAGRAPH_OK();
+    }
+
+    metagraph_work_pool_t *pool = NULL;
+    METAGRAPH_CHECK(metagraph_work_pool_create(threads, &pool));
+    metagraph_bundle_inflate_job_t job = {
+        .bundle = bundle,
+        .blocks = blocks,
+        .first = first,
+        .failed = ATOMIC_FLAG_INIT,
+        .error = {.code = METAGRAPH_SUCCESS},
+    };
+    metagraph_work_pool_for(pool, count, 1, metagraph_bundle_inflate_range,
+                            &job);
+    metagraph_work_pool_destroy(pool);
+    if (job.error.code != METAGRAPH_SUCCESS) {
+        return METAGRAPH_ERR(job.error.code, "%s", job.error.message);
+    }
+    return METAGRAPH_OK();
+}
+
+// Make [offset, offset + size) of a hydrated STORE readable.
+static metagraph_result_t
+metagraph_bundle_inflate(const metagraph_bundle_t *bundle, uint64_t offset,
+                         uint64_t size) {
+    const metagraph_bundle_store_view_t *store = &bundle->views->store;
+    if (!store->block_state || size == 0) {
+        return METAGRAPH_OK();
+    }
+    const size_t first = (size_t)(offset >> store->block_log2);
+    const size_t last = (size_t)((offset + size - 1U) >> store->block_log2);
+    if (last - first + 1U >= METAGRAPH_BUNDLE_PARALLEL_BLOCKS) {
+        return metagraph_bundle_inflate_blocks(bundle, NULL, first,
+                                               last - first + 1U, 0);
+    }
+    for (size_t block = first; block <= last; block++) {
+        METAGRAPH_CHECK(metagraph_bundle_inflate_block(bundle, block));
+    }
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Delta bundles
+// ============================================================================
+
+static metagraph_result_t
+metagraph_bundle_build_delta(const metagraph_bundle_t *bundle) {
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(metagraph_bundle_section(bundle, METAGRAPH_SECTION_DELTA,
+                                             &data, &size));
+    if (size < sizeof(metagraph_bundle_delta_header_t)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "DELTA section too small for its header");
+    }
+    const metagraph_bundle_delta_header_t *header =
+        (const metagraph_bundle_delta_header_t *)(const void *)data;
+    if (header->node_count > UINT32_MAX ||
+        header->base_node_count > UINT32_MAX ||
+        header->patch_count > header->node_count ||
+        (header->inherited_sections & ~METAGRAPH_BUNDLE_INHERITABLE_SECTIONS) ||
+        header->patch_records_offset % 8U != 0 ||
+        !metagraph_bundle_u32_array_ok(header->patch_nodes_offset,
+                                       header->patch_count, size) ||
+        !metagraph_bundle_range_ok(header->patch_records_offset,
+                                   header->patch_count,
+                                   sizeof(metagraph_bundle_node_record_t),
+                                   size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "DELTA section header is malformed");
+    }
+    if (bundle->section_slot[METAGRAPH_SECTION_NODES] != UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Delta bundle carries a NODES section");
+    }
+    bundle->views->delta = header;
+    return METAGRAPH_OK();
+}
+
+// Copy the base's records and apply the delta's patches. Patches must be
+// ascending and cover every node past the base; inherited ID tables
+// require every node to keep its base ID.
+static metagraph_result_t
+metagraph_bundle_build_patched_nodes(const metagraph_bundle_t *bundle) {
+    const metagraph_bundle_nodes_view_t *base = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_nodes(bundle->parent, &base));
+    const metagraph_bundle_delta_header_t *header = bundle->views->delta;
+    const uint8_t *data = (const uint8_t *)header;
+    const uint32_t *patch_nodes =
+        (const uint32_t *)(const void *)(data + header->patch_nodes_offset);
+    const metagraph_bundle_node_record_t *patch_records =
+        (const metagraph_bundle_node_record_t *)(const void *)(
+            data + header->patch_records_offset);
+    const size_t count = (size_t)header->node_count;
+    const size_t kept = base->count < count ? base->count : count;
+    const size_t patch_count = (size_t)header->patch_count;
+    const bool same_ids =
+        (header->inherited_sections & ((1U << METAGRAPH_SECTION_INDEX) |
+                                       (1U << METAGRAPH_SECTION_LOOKUP))) != 0;
+
+    size_t appended = 0;
+    for (size_t i = 0; i < patch_count; i++) {
+        const uint32_t node = patch_nodes[i];
+        if (node >= count || (i > 0 && node <= patch_nodes[i - 1U])) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                 "DELTA patch %zu targets node %u", i, node);
+        }
+        if (node >= kept) {
+            appended++;
+        } else if (same_ids &&
+                   (patch_records[i].id.high != base->records[node].id.high ||
+                    patch_records[i].id.low != base->records[node].id.low)) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                 "DELTA renames node %u but inherits the ID "
+                                 "tables",
+                                 node);
+        }
+    }
+    if (appended != count - kept || (same_ids && count != base->count)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "DELTA patches do not cover its %zu nodes",
+                             count);
+    }
+
+    metagraph_bundle_node_record_t *records =
+        malloc((count ? count : 1U) * sizeof(*records));
+    METAGRAPH_CHECK_ALLOC(records);
+    memcpy(records, base->records, kept * sizeof(*records));
+    for (size_t i = 0; i < patch_count; i++) {
+        records[patch_nodes[i]] = patch_records[i];
+    }
+    bundle->views->nodes.patched = records;
+    bundle->views->nodes.records = records;
+    bundle->views->nodes.count = count;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_bundle_store_extent(const metagraph_bundle_t *bundle,
+                              uint64_t *out_size) {
+    METAGRAPH_CHECK(metagraph_bundle_hydrate(bundle, METAGRAPH_SECTION_STORE,
+                                             metagraph_bundle_build_store));
+    *out_size = bundle->views->store.size +
+                (bundle->parent ? bundle->views->delta->base_store_size : 0U);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_bundle_apply_delta(metagraph_bundle_t *delta,
+                                                metagraph_bundle_t *base) {
+    METAGRAPH_CHECK_NULL(delta);
+    METAGRAPH_CHECK_NULL(base);
+    if (!(delta->header->flags & METAGRAPH_BUNDLE_FLAG_DELTA) ||
+        delta->parent || delta == base) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Bundle is not a delta awaiting its base");
+    }
+    METAGRAPH_CHECK(metagraph_bundle_hydrate(delta, METAGRAPH_SECTION_DELTA,
+                                             metagraph_bundle_build_delta));
+    const metagraph_bundle_delta_header_t *header = delta->views->delta;
+    if (memcmp(header->base_format_uuid, base->header->format_uuid,
+               sizeof(header->base_format_uuid)) != 0 ||
+        memcmp(header->base_integrity_hash, base->header->integrity_hash,
+               sizeof(header->base_integrity_hash)) != 0 ||
+        header->base_total_size != base->header->total_size) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_VERSION_MISMATCH,
+                             "Delta was made from a different base bundle");
+    }
+    // The base is the right one, so disagreement means a corrupt delta.
+    uint64_t store_size = 0;
+    const metagraph_bundle_nodes_view_t *nodes = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_store_extent(base, &store_size));
+    METAGRAPH_CHECK(metagraph_bundle_nodes(base, &nodes));
+    if (store_size != header->base_store_size ||
+        nodes->count != header->base_node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "DELTA section disagrees with its base");
+    }
+    delta->parent = base;
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+metagraph_result_t
+metagraph_bundle_get_metadata(const metagraph_bundle_t *bundle,
+                              metagraph_bundle_metadata_t *out_metadata) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_metadata);
+    const uint8_t *data = NULL;
+    uint64_t size = 0;
+    METAGRAPH_CHECK(metagraph_bundle_section(bundle, METAGRAPH_SECTION_METADATA,
+                                             &data, &size));
+    if (bundle->flags & METAGRAPH_BUNDLE_OPEN_VERIFY) {
+        METAGRAPH_CHECK(metagraph_bundle_verify_leaves(
+            bundle, METAGRAPH_SECTION_METADATA, 0, SIZE_MAX));
+    }
+    if (size < sizeof(*out_metadata)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "METADATA section too small");
+    }
+    memcpy(out_metadata, data, sizeof(*out_metadata));
+    out_metadata->creator[sizeof(out_metadata->creator) - 1U] = '\0';
+    out_metadata->description[sizeof(out_metadata->description) - 1U] = '\0';
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_bundle_node_count(const metagraph_bundle_t *bundle,
+                                               size_t *out_count) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_count);
+    const metagraph_bundle_nodes_view_t *nodes = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_nodes(bundle, &nodes));
+    *out_count = nodes->count;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_bundle_edge_count(const metagraph_bundle_t *bundle,
+                                               size_t *out_count) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_count);
+    const metagraph_bundle_edges_view_t *edges = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_edges(bundle, &edges));
+    *out_count = edges->count;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_lookup_id(const metagraph_bundle_t *bundle,
+                           metagraph_id_t node_id,
+                           metagraph_node_index_t *out_index) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_index);
+    const metagraph_bundle_nodes_view_t *nodes = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_nodes(bundle, &nodes));
+
+    uint32_t value = 0;
+    bool found = false;
+    const metagraph_bundle_t *owner =
+        metagraph_bundle_owner(bundle, METAGRAPH_SECTION_LOOKUP);
+    if (owner->section_slot[METAGRAPH_SECTION_LOOKUP] != UINT32_MAX) {
+        METAGRAPH_CHECK(metagraph_bundle_hydrate(owner, METAGRAPH_SECTION_LOOKUP,
+                                                 metagraph_bundle_build_lookup));
+        const metagraph_bundle_lookup_view_t *lookup = &owner->views->lookup;
+        if (lookup->ids.key_count) {
+            const metagraph_id_slot_t *slot =
+                &lookup->id_slots[metagraph_perfect_hash_slot(&lookup->ids,
+                                                              node_id)];
+            found = slot->id.high == node_id.high && slot->id.low == node_id.low;
+            value = slot->value;
+            metagraph_bundle_note(owner, METAGRAPH_SECTION_LOOKUP,
+                                  (uint64_t)(slot - lookup->id_slots));
+        }
+    } else {
+        owner = metagraph_bundle_owner(bundle, METAGRAPH_SECTION_INDEX);
+        METAGRAPH_CHECK(metagraph_bundle_hydrate(owner, METAGRAPH_SECTION_INDEX,
+                                                 metagraph_bundle_build_index));
+        const metagraph_bundle_index_view_t *index = &owner->views->index;
+        found = metagraph_id_index_find_raw(index->ctrl, index->slots,
+                                            index->capacity, node_id, &value);
+        metagraph_bundle_note(owner, METAGRAPH_SECTION_INDEX, value);
+    }
+    if (!found) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node %016llx%016llx not in bundle",
+                             (unsigned long long)node_id.high,
+                             (unsigned long long)node_id.low);
+    }
+    if (value >= nodes->count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Index maps to node %u of %zu", value,
+                             nodes->count);
+    }
+    *out_index = value;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_bundle_find_node(const metagraph_bundle_t *bundle,
+                                              metagraph_id_t node_id,
+                                              metagraph_node_index_t *out_index) {
+    const uint64_t start = metagraph_metrics_begin_lookup();
+    const metagraph_result_t result =
+        metagraph_bundle_lookup_id(bundle, node_id, out_index);
+    metagraph_metrics_end(METAGRAPH_HISTOGRAM_LOOKUP, start);
+    return result;
+}
+
+// Resolve node_ids[0, count) through the LOOKUP section's perfect hash
+static void metagraph_bundle_lookup_perfect(
+    const metagraph_bundle_t *owner, const metagraph_id_t *node_ids,
+    size_t count, metagraph_node_index_t *out_indices, size_t *out_found) {
+    const metagraph_bundle_lookup_view_t *lookup = &owner->views->lookup;
+    uint64_t slots[METAGRAPH_ID_INDEX_BATCH];
+    for (size_t base = 0; base < count; base += METAGRAPH_ID_INDEX_BATCH) {
+        const size_t group = count - base < METAGRAPH_ID_INDEX_BATCH
+                                 ? count - base
+                                 : METAGRAPH_ID_INDEX_BATCH;
+        const metagraph_id_t *keys = node_ids + base;
+        if (!lookup->ids.key_count) {
+            for (size_t i = 0; i < group; i++) {
+                out_indices[base + i] = METAGRAPH_INVALID_INDEX;
+            }
+            continue;
+        }
+        metagraph_perfect_hash_slots(&lookup->ids, keys, group, slots);
+        for (size_t i = 0; i < group; i++) {
+            METAGRAPH_PREFETCH(&lookup->id_slots[slots[i]]);
+        }
+        for (size_t i = 0; i < group; i++) {
+            const metagraph_id_slot_t *slot = &lookup->id_slots[slots[i]];
+            if (metagraph_id_equal(slot->id, keys[i])) {
+                out_indices[base + i] = slot->value;
+                (*out_found)++;
+            } else {
+                out_indices[base + i] = METAGRAPH_INVALID_INDEX;
+            }
+            metagraph_bundle_note(owner, METAGRAPH_SECTION_LOOKUP, slots[i]);
+        }
+    }
+}
+
+metagraph_result_t metagraph_bundle_find_nodes(
+    const metagraph_bundle_t *bundle, const metagraph_id_t *node_ids,
+    size_t count, metagraph_node_index_t *out_indices, size_t *out_found) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(node_ids);
+    METAGRAPH_CHECK_NULL(out_indices);
+    const metagraph_bundle_nodes_view_t *nodes = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_nodes(bundle, &nodes));
+    metagraph_metrics_add(METAGRAPH_COUNTER_LOOKUPS, count);
+
+    size_t found = 0;
+    const metagraph_bundle_t *owner =
+        metagraph_bundle_owner(bundle, METAGRAPH_SECTION_LOOKUP);
+    const bool by_index =
+        owner->section_slot[METAGRAPH_SECTION_LOOKUP] == UINT32_MAX;
+    if (!by_index) {
+        METAGRAPH_CHECK(metagraph_bundle_hydrate(owner, METAGRAPH_SECTION_LOOKUP,
+                                                 metagraph_bundle_build_lookup));
+        metagraph_bundle_lookup_perfect(owner, node_ids, count, out_indices,
+                                        &found);
+    } else {
+        owner = metagraph_bundle_owner(bundle, METAGRAPH_SECTION_INDEX);
+        METAGRAPH_CHECK(metagraph_bundle_hydrate(owner, METAGRAPH_SECTION_INDEX,
+                                                 metagraph_bundle_build_index));
+        const metagraph_bundle_index_view_t *index = &owner->views->index;
+        found = metagraph_id_index_find_batch_raw(index->ctrl, index->slots,
+                                                  index->capacity, node_ids,
+                                                  count, out_indices);
+    }
+    for (size_t i = 0; i < count; i++) {
+        const metagraph_node_index_t value = out_indices[i];
+        if (value == METAGRAPH_INVALID_INDEX) {
+            continue;
+        }
+        if (value >= nodes->count) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                 "Index maps to node %u of %zu", value,
+                                 nodes->count);
+        }
+        if (by_index) {
+            metagraph_bundle_note(owner, METAGRAPH_SECTION_INDEX, value);
+        }
+    }
+    if (out_found) {
+        *out_found = found;
+    }
+    return METAGRAPH_OK();
+}
+
+// A slot's check matched; confirm the node's name normalizes to key.
+static bool metagraph_bundle_name_matches(const char *name, const char *key,
+                                          size_t key_length) {
+    const size_t length = strlen(name);
+    if (length == key_length && memcmp(name, key, length) == 0) {
+        return true;
+    }
+    char normalized[METAGRAPH_PATH_MAX + 1U];
+    size_t normalized_length = 0;
+    return length <= METAGRAPH_PATH_MAX &&
+           metagraph_path_normalize_into(name, length, normalized,
+                                         &normalized_length) &&
+           normalized_length == key_length &&
+           memcmp(normalized, key, key_length) == 0;
+}
+
+static metagraph_result_t
+metagraph_bundle_lookup_path(const metagraph_bundle_t *bundle, const char *path,
+                             metagraph_node_index_t *out_index) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(path);
+    METAGRAPH_CHECK_NULL(out_index);
+    const metagraph_bundle_t *owner =
+        metagraph_bundle_owner(bundle, METAGRAPH_SECTION_LOOKUP);
+    if (owner->section_slot[METAGRAPH_SECTION_LOOKUP] == UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                             "Bundle has no path lookup table");
+    }
+    METAGRAPH_CHECK(metagraph_bundle_hydrate(owner, METAGRAPH_SECTION_LOOKUP,
+                                             metagraph_bundle_build_lookup));
+
+    // Names are keyed the way the writer keys them: normalized if possible.
+    const size_t length = strlen(path);
+    char normalized[METAGRAPH_PATH_MAX + 1U];
+    const char *key = path;
+    size_t key_length = length;
+    if (length <= METAGRAPH_PATH_MAX &&
+        metagraph_path_normalize_into(path, length, normalized, &key_length)) {
+        key = normalized;
+    } else {
+        key_length = length;
+    }
+
+    const metagraph_bundle_lookup_view_t *lookup = &owner->views->lookup;
+    if (lookup->paths.key_count) {
+        const metagraph_id_t hash = metagraph_path_hash(key, key_length);
+        const metagraph_bundle_path_slot_t *slot =
+            &lookup->path_slots[metagraph_perfect_hash_slot(&lookup->paths,
+                                                            hash)];
+        if (slot->check == hash.high) {
+            metagraph_node_metadata_t metadata;
+            METAGRAPH_CHECK(metagraph_bundle_get_node(bundle, slot->node,
+                                                      &metadata));
+            if (metadata.name &&
+                metagraph_bundle_name_matches(metadata.name, key, key_length)) {
+                *out_index = slot->node;
+                return METAGRAPH_OK();
+            }
+        }
+    }
+    return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                         "No node at path %s", path);
+}
+
+metagraph_result_t
+metagraph_bundle_find_node_by_path(const metagraph_bundle_t *bundle,
+                                   const char *path,
+                                   metagraph_node_index_t *out_index) {
+    const uint64_t start = metagraph_metrics_begin_lookup();
+    const metagraph_result_t result =
+        metagraph_bundle_lookup_path(bundle, path, out_index);
+    metagraph_metrics_end(METAGRAPH_HISTOGRAM_LOOKUP, start);
+    return result;
+}
+
+metagraph_result_t
+metagraph_bundle_node_record(
+    const metagraph_bundle_t *bundle, metagraph_node_index_t node,
+    const metagraph_bundle_node_record_t **out_record) {
+    const metagraph_bundle_nodes_view_t *nodes = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_nodes(bundle, &nodes));
+    if (node >= nodes->count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node index %u out of range", node);
+    }
+    metagraph_bundle_note(bundle, METAGRAPH_SECTION_NODES, node);
+    *out_record = &nodes->records[node];
+    return METAGRAPH_OK();
+}
+
+// Make [offset, offset + size) of the store node records address readable:
+// the bundle's own STORE or, below base_store_size, an applied delta's
+// base. Compressed blocks are decoded (and verified first); plain ranges
+// are verified leaf by leaf when the bundle was opened with VERIFY.
+static metagraph_result_t
+metagraph_bundle_store_bytes(const metagraph_bundle_t *bundle, uint64_t offset,
+                             uint64_t size, const uint8_t **out_bytes) {
+    if (bundle->parent) {
+        const uint64_t base_size = bundle->views->delta->base_store_size;
+        if (offset < base_size) {
+            if (size > base_size - offset) {
+                return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                     "Store range straddles a delta and its "
+                                     "base");
+            }
+            return metagraph_bundle_store_bytes(bundle->parent, offset, size,
+                                                out_bytes);
+        }
+        offset -= base_size;
+    }
+    METAGRAPH_CHECK(metagraph_bundle_hydrate(bundle, METAGRAPH_SECTION_STORE,
+                                             metagraph_bundle_build_store));
+    const metagraph_bundle_store_view_t *store = &bundle->views->store;
+    if (!metagraph_bundle_range_ok(offset, size, 1U, store->size)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Store range escapes the STORE section");
+    }
+    metagraph_bundle_note(bundle, METAGRAPH_SECTION_STORE, offset);
+    if (store->block_state) {
+        METAGRAPH_CHECK(metagraph_bundle_inflate(bundle, offset, size));
+    } else if ((bundle->flags & METAGRAPH_BUNDLE_OPEN_VERIFY) && size) {
+        // Only the leaves this range lives in.
+        METAGRAPH_CHECK(metagraph_bundle_verify_range(
+            bundle, METAGRAPH_SECTION_STORE, offset, size));
+    }
+    *out_bytes = store->base + offset;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_bundle_get_node(const metagraph_bundle_t *bundle,
+                          metagraph_node_index_t node,
+                          metagraph_node_metadata_t *out_metadata) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_metadata);
+    const metagraph_bundle_node_record_t *record = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_node_record(bundle, node, &record));
+
+    const uint8_t *data = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_store_bytes(bundle, record->data_offset,
+                                                 record->data_size, &data));
+    const char *name = NULL;
+    if (record->name_offset != METAGRAPH_BUNDLE_NO_OFFSET) {
+        const uint8_t *bytes = NULL;
+        METAGRAPH_CHECK(metagraph_bundle_store_bytes(
+            bundle, record->name_offset, (uint64_t)record->name_length + 1U,
+            &bytes));
+        if (bytes[record->name_length] != '\0') {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                 "Name of node %u is malformed", node);
+        }
+        name = (const char *)bytes;
+    }
+
+    out_metadata->id = record->id;
+    out_metadata->name = name;
+    out_metadata->type = record->type;
+    out_metadata->data_size = (size_t)record->data_size;
+    // Read-only mapping; the metadata struct is shared with the mutable graph.
+    out_metadata->data = record->data_size ? (void *)(uintptr_t)data : NULL;
+    out_metadata->hash = record->hash;
+    return METAGRAPH_OK();
+}
+
+typedef struct {
+    uint64_t offset;
+    uint64_t size;
+} metagraph_bundle_range_t;
+
+// Decode every compressed block of the bundle's store, bases first.
+static metagraph_result_t
+metagraph_bundle_prefetch_all(const metagraph_bundle_t *bundle,
+                              uint32_t thread_count) {
+    if (bundle->parent) {
+        METAGRAPH_CHECK(
+            metagraph_bundle_prefetch_all(bundle->parent, thread_count));
+    }
+    METAGRAPH_CHECK(metagraph_bundle_hydrate(bundle, METAGRAPH_SECTION_STORE,
+                                             metagraph_bundle_build_store));
+    const metagraph_bundle_store_view_t *store = &bundle->views->store;
+    if (!store->block_state) {
+        return METAGRAPH_OK();
+    }
+    return metagraph_bundle_inflate_blocks(bundle, NULL, 0, store->block_count,
+                                           thread_count);
+}
+
+// Decode the compressed blocks covering ranges of the store node records
+// address. A delta hands the ranges below its base's STORE size to the
+// base; ranges is reordered and rebased along the way.
+static metagraph_result_t
+metagraph_bundle_prefetch_ranges(const metagraph_bundle_t *bundle,
+                                 metagraph_bundle_range_t *ranges, size_t count,
+                                 uint32_t thread_count) {
+    if (bundle->parent) {
+        const uint64_t base_size = bundle->views->delta->base_store_size;
+        size_t below = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (ranges[i].offset < base_size) {
+                const metagraph_bundle_range_t range = ranges[i];
+                ranges[i] = ranges[below];
+                ranges[below++] = range;
+            }
+        }
+        METAGRAPH_CHECK(metagraph_bundle_prefetch_ranges(
+            bundle->parent, ranges, below, thread_count));
+        ranges += below;
+        count -= below;
+        for (size_t i = 0; i < count; i++) {
+            ranges[i].offset -= base_size;
+        }
+    }
+    METAGRAPH_CHECK(metagraph_bundle_hydrate(bundle, METAGRAPH_SECTION_STORE,
+                                             metagraph_bundle_build_store));
+    const metagraph_bundle_store_view_t *store = &bundle->views->store;
+    if (!store->block_state || count == 0) {
+        return METAGRAPH_OK();
+    }
+
+    // Collect each wanted block once, in section order.
+    const size_t words = (store->block_count + 63U) / 64U;
+    uint64_t *wanted = calloc(words ? words : 1U, sizeof(*wanted));
+    METAGRAPH_CHECK_ALLOC(wanted);
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    size_t *blocks = NULL;
+    size_t block_total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!metagraph_bundle_range_ok(ranges[i].offset, ranges[i].size, 1U,
+                                       store->size)) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                   "Store range escapes the STORE section");
+            goto done;
+        }
+        const uint64_t end = ranges[i].offset + ranges[i].size - 1U;
+        for (size_t b = (size_t)(ranges[i].offset >> store->block_log2);
+             b <= (size_t)(end >> store->block_log2); b++) {
+            const uint64_t mask = 1ULL << (b % 64U);
+            if (!(wanted[b / 64U] & mask)) {
+                wanted[b / 64U] |= mask;
+                block_total++;
+            }
+        }
+    }
+    blocks = malloc((block_total ? block_total : 1U) * sizeof(*blocks));
+    if (!blocks) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Cannot list %zu STORE blocks", block_total);
+        goto done;
+    }
+    size_t listed = 0;
+    for (size_t b = 0; b < store->block_count; b++) {
+        if (wanted[b / 64U] & (1ULL << (b % 64U))) {
+            blocks[listed++] = b;
+        }
+    }
+    result = metagraph_bundle_inflate_blocks(bundle, blocks, 0, listed,
+                                             thread_count);
+done:
+    free(wanted);
+    free(blocks);
+    return result;
+}
+
+metagraph_result_t
+metagraph_bundle_prefetch_nodes(const metagraph_bundle_t *bundle,
+                                const metagraph_node_index_t *nodes,
+                                size_t count, uint32_t thread_count) {
+    METAGRAPH_CHECK_NULL(bundle);
+    const metagraph_bundle_nodes_view_t *view = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_nodes(bundle, &view));
+    if (!nodes) {
+        return metagraph_bundle_prefetch_all(bundle, thread_count);
+    }
+
+    // A payload and a name per node; empty ones are skipped.
+    metagraph_bundle_range_t *ranges =
+        malloc((count ? count : 1U) * 2U * sizeof(*ranges));
+    METAGRAPH_CHECK_ALLOC(ranges);
+    size_t range_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (nodes[i] >= view->count) {
+            free(ranges);
+            return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                                 "Node index %u out of range", nodes[i]);
+        }
+        const metagraph_bundle_node_record_t *record = &view->records[nodes[i]];
+        if (record->data_size) {
+            ranges[range_count++] = (metagraph_bundle_range_t){
+                record->data_offset, record->data_size};
+        }
+        if (record->name_offset != METAGRAPH_BUNDLE_NO_OFFSET) {
+            ranges[range_count++] = (metagraph_bundle_range_t){
+                record->name_offset, (uint64_t)record->name_length + 1U};
+        }
+    }
+    const metagraph_result_t result = metagraph_bundle_prefetch_ranges(
+        bundle, ranges, range_count, thread_count);
+    free(ranges);
+    return result;
+}
+
+// Read the sections in mask that this bundle's file holds, then hand the
+// rest (and, for a delta, the base's share of the STORE) to the base.
+static metagraph_result_t
+metagraph_bundle_read_sections(const metagraph_bundle_t *bundle, uint32_t mask,
+                               const metagraph_read_ahead_options_t *options,
+                               metagraph_read_ahead_stats_t *stats) {
+    metagraph_map_range_t ranges[METAGRAPH_SECTION_TYPE_COUNT];
+    size_t count = 0;
+    uint32_t forward = 0;
+    for (uint32_t type = 0; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        if (!(mask & (1U << type))) {
+            continue;
+        }
+        const uint32_t slot = bundle->section_slot[type];
+        if (slot != UINT32_MAX) {
+            const metagraph_section_header_t *section = &bundle->sections[slot];
+            ranges[count++] = (metagraph_map_range_t){
+                (uint64_t)(bundle->base - (const uint8_t *)
+                                              bundle->map->base_address) +
+                    section->offset,
+                section->size};
+        }
+        if (bundle->parent &&
+            (slot == UINT32_MAX || type == METAGRAPH_SECTION_STORE)) {
+            forward |= 1U << type;
+        }
+    }
+    metagraph_read_ahead_stats_t own = {0};
+    METAGRAPH_CHECK(
+        metagraph_mmap_read_ahead(bundle->map, ranges, count, options, &own));
+    stats->bytes_read += own.bytes_read;
+    stats->reads += own.reads;
+    if (own.backend != METAGRAPH_READ_AHEAD_NONE) {
+        stats->backend = own.backend;
+    }
+    if (forward) {
+        return metagraph_bundle_read_sections(bundle->parent, forward, options,
+                                              stats);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_bundle_prefetch_sections(
+    const metagraph_bundle_t *bundle, const metagraph_section_type_t *types,
+    size_t count, const metagraph_read_ahead_options_t *options,
+    metagraph_read_ahead_stats_t *out_stats) {
+    METAGRAPH_CHECK_NULL(bundle);
+    uint32_t mask = (1U << METAGRAPH_SECTION_TYPE_COUNT) - 1U;
+    if (types) {
+        mask = 0;
+        for (size_t i = 0; i < count; i++) {
+            if ((uint32_t)types[i] >= METAGRAPH_SECTION_TYPE_COUNT) {
+                return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                                     "Unknown section type %u",
+                                     (unsigned)types[i]);
+            }
+            mask |= 1U << types[i];
+        }
+    }
+    metagraph_read_ahead_stats_t stats = {.backend = METAGRAPH_READ_AHEAD_NONE};
+    const metagraph_result_t result =
+        metagraph_bundle_read_sections(bundle, mask, options, &stats);
+    if (out_stats) {
+        *out_stats = stats;
+    }
+    return result;
+}
+
+static metagraph_result_t
+metagraph_bundle_edge_record(const metagraph_bundle_t *bundle,
+                             metagraph_edge_index_t edge,
+                             const metagraph_bundle_edges_view_t **out_view,
+                             const metagraph_bundle_edge_record_t **out_record) {
+    const metagraph_bundle_edges_view_t *edges = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_edges(bundle, &edges));
+    if (edge >= edges->count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_EDGE_NOT_FOUND,
+                             "Edge index %u out of range", edge);
+    }
+    const metagraph_bundle_edge_record_t *record = &edges->records[edge];
+    if (!metagraph_bundle_range_ok(record->member_begin, record->member_count,
+                                   1U, edges->member_count)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Members of edge %u escape the member array",
+                             edge);
+    }
+    metagraph_bundle_note(metagraph_bundle_owner(bundle,
+                                                 METAGRAPH_SECTION_EDGES),
+                          METAGRAPH_SECTION_EDGES, edge);
+    *out_view = edges;
+    *out_record = record;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_bundle_get_edge(const metagraph_bundle_t *bundle,
+                          metagraph_edge_index_t edge,
+                          metagraph_edge_metadata_t *out_metadata) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_metadata);
+    const metagraph_bundle_edges_view_t *edges = NULL;
+    const metagraph_bundle_edge_record_t *record = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_edge_record(bundle, edge, &edges, &record));
+
+    out_metadata->id = record->id;
+    out_metadata->type = record->type;
+    out_metadata->weight = record->weight;
+    out_metadata->node_count = record->member_count;
+    out_metadata->nodes = NULL;
+    out_metadata->properties = NULL;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_bundle_get_edge_nodes(const metagraph_bundle_t *bundle,
+                                metagraph_edge_index_t edge,
+                                const metagraph_node_index_t **out_nodes,
+                                size_t *out_count) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_nodes);
+    METAGRAPH_CHECK_NULL(out_count);
+    const metagraph_bundle_edges_view_t *edges = NULL;
+    const metagraph_bundle_edge_record_t *record = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_edge_record(bundle, edge, &edges, &record));
+
+    *out_nodes = edges->members + record->member_begin;
+    *out_count = record->member_count;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_adjacency(const metagraph_bundle_t *bundle,
+                           metagraph_node_index_t node, bool outgoing,
+                           const metagraph_edge_index_t **out_edges,
+                           size_t *out_count) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_edges);
+    METAGRAPH_CHECK_NULL(out_count);
+    const metagraph_bundle_edges_view_t *edges = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_edges(bundle, &edges));
+    if (node >= bundle->views->nodes.count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node index %u out of range", node);
+    }
+    metagraph_bundle_note(metagraph_bundle_owner(bundle,
+                                                 METAGRAPH_SECTION_EDGES),
+                          METAGRAPH_SECTION_EDGES, node);
+    const uint32_t *rows = outgoing ? edges->out_rows : edges->in_rows;
+    const uint32_t *list = outgoing ? edges->out_edges : edges->in_edges;
+    *out_edges = list + rows[node];
+    *out_count = rows[node + 1U] - rows[node];
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_bundle_get_outgoing_edges(const metagraph_bundle_t *bundle,
+                                    metagraph_node_index_t node,
+                                    const metagraph_edge_index_t **out_edges,
+                                    size_t *out_count) {
+    return metagraph_bundle_adjacency(bundle, node, true, out_edges, out_count);
+}
+
+metagraph_result_t
+metagraph_bundle_get_incoming_edges(const metagraph_bundle_t *bundle,
+                                    metagraph_node_index_t node,
+                                    const metagraph_edge_index_t **out_edges,
+                                    size_t *out_count) {
+    return metagraph_bundle_adjacency(bundle, node, false, out_edges,
+                                      out_count);
+}
+
+static metagraph_result_t metagraph_bundle_adjacency_batch(
+    const metagraph_bundle_t *bundle, const metagraph_node_index_t *nodes,
+    size_t count, bool outgoing, const metagraph_edge_index_t **out_edges,
+    size_t *out_counts) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(nodes);
+    METAGRAPH_CHECK_NULL(out_edges);
+    METAGRAPH_CHECK_NULL(out_counts);
+    const metagraph_bundle_edges_view_t *edges = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_edges(bundle, &edges));
+    const metagraph_bundle_t *owner =
+        metagraph_bundle_owner(bundle, METAGRAPH_SECTION_EDGES);
+    const size_t node_count = bundle->views->nodes.count;
+    const uint32_t *rows = outgoing ? edges->out_rows : edges->in_rows;
+    const uint32_t *list = outgoing ? edges->out_edges : edges->in_edges;
+
+    for (size_t base = 0; base < count; base += METAGRAPH_ID_INDEX_BATCH) {
+        const size_t group = count - base < METAGRAPH_ID_INDEX_BATCH
+                                 ? count - base
+                                 : METAGRAPH_ID_INDEX_BATCH;
+        for (size_t i = base; i < base + group; i++) {
+            if (nodes[i] < node_count) {
+                METAGRAPH_PREFETCH(&rows[nodes[i]]);
+                METAGRAPH_PREFETCH(&rows[nodes[i] + 1U]);
+            }
+        }
+        for (size_t i = base; i < base + group; i++) {
+            const metagraph_node_index_t node = nodes[i];
+            if (node == METAGRAPH_INVALID_INDEX) {
+                out_edges[i] = NULL;
+                out_counts[i] = 0;
+                continue;
+            }
+            if (node >= node_count) {
+                return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                                     "Node index %u out of range", node);
+            }
+            metagraph_bundle_note(owner, METAGRAPH_SECTION_EDGES, node);
+            out_edges[i] = list + rows[node];
+            out_counts[i] = rows[node + 1U] - rows[node];
+            // The caller reads the lists next; start on their first lines.
+            METAGRAPH_PREFETCH(out_edges[i]);
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_bundle_get_outgoing_edges_batch(
+    const metagraph_bundle_t *bundle, const metagraph_node_index_t *nodes,
+    size_t count, const metagraph_edge_index_t **out_edges,
+    size_t *out_counts) {
+    return metagraph_bundle_adjacency_batch(bundle, nodes, count, true,
+                                            out_edges, out_counts);
+}
+
+metagraph_result_t metagraph_bundle_get_incoming_edges_batch(
+    const metagraph_bundle_t *bundle, const metagraph_node_index_t *nodes,
+    size_t count, const metagraph_edge_index_t **out_edges,
+    size_t *out_counts) {
+    return metagraph_bundle_adjacency_batch(bundle, nodes, count, false,
+                                            out_edges, out_counts);
+}
+
+metagraph_result_t
+metagraph_bundle_edge_arrays(const metagraph_bundle_t *bundle,
+                             metagraph_bundle_edge_arrays_t *out_arrays) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_arrays);
+    const metagraph_bundle_edges_view_t *edges = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_edges(bundle, &edges));
+    *out_arrays = (metagraph_bundle_edge_arrays_t){
+        .records = edges->records,
+        .edge_count = edges->count,
+        .members = edges->members,
+        .member_count = edges->member_count,
+        .node_count = bundle->views->nodes.count,
+        .out_rows = edges->out_rows,
+        .out_edges = edges->out_edges,
+        .out_count = edges->out_count,
+        .in_rows = edges->in_rows,
+        .in_edges = edges->in_edges,
+        .in_count = edges->in_count,
+    };
+    return METAGRAPH_OK();
+}
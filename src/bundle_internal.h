@@ -0,0 +1,198 @@
+/**
+ * @file bundle_internal.h
+ * @brief Format helpers shared by the bundle reader and writer
+ */
+
+#ifndef SRC_BUNDLE_INTERNAL_H
+#define SRC_BUNDLE_INTERNAL_H
+
+#include "metagraph/bundle.h"
+#include "metagraph/version.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+_Static_assert(sizeof(metagraph_bundle_header_t) == 128,
+               "bundle header layout is part of the format");
+_Static_assert(sizeof(metagraph_section_header_t) == 40,
+               "section table layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_node_record_t) == 64,
+               "node record layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_edge_record_t) == 32,
+               "edge record layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_edges_header_t) == 96,
+               "edges sub-header layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_index_header_t) == 32,
+               "index sub-header layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_integrity_header_t) == 16,
+               "integrity sub-header layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_integrity_entry_t) == 56,
+               "integrity entry layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_lookup_table_t) == 64,
+               "lookup table layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_lookup_header_t) == 128,
+               "lookup sub-header layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_path_slot_t) == 16,
+               "path slot layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_compression_header_t) == 32,
+               "compression sub-header layout is part of the format");
+_Static_assert(sizeof(metagraph_bundle_delta_header_t) == 112,
+               "delta sub-header layout is part of the format");
+
+#define METAGRAPH_BUNDLE_MAGIC_SIZE 8U
+
+// Node payloads are aligned so SIMD consumers can load them directly.
+#define METAGRAPH_BUNDLE_DATA_ALIGN 16U
+
+// Merkle leaves are 1 KiB (one BLAKE3 chunk) to 1 TiB.
+#define METAGRAPH_BUNDLE_MIN_CHUNK_LOG2 10U
+#define METAGRAPH_BUNDLE_MAX_CHUNK_LOG2 40U
+
+// Compressed STORE blocks are 4 KiB to 16 MiB before compression.
+#define METAGRAPH_BUNDLE_MIN_BLOCK_LOG2 12U
+#define METAGRAPH_BUNDLE_MAX_BLOCK_LOG2 24U
+#define METAGRAPH_BUNDLE_DEFAULT_BLOCK_SIZE (64U * 1024U)
+
+// Sections a delta may inherit from its base; the others are its own.
+#define METAGRAPH_BUNDLE_INHERITABLE_SECTIONS                                  \
+    ((1U << METAGRAPH_SECTION_EDGES) | (1U << METAGRAPH_SECTION_INDEX) |      \
+     (1U << METAGRAPH_SECTION_LOOKUP))
+
+static inline uint64_t metagraph_bundle_align_up(uint64_t value,
+                                                 uint64_t alignment) {
+    return (value + alignment - 1U) & ~(alignment - 1U);
+}
+
+static inline uint32_t metagraph_bundle_api_version(void) {
+    return ((uint32_t)METAGRAPH_API_VERSION_MAJOR << 16U) |
+           (uint32_t)METAGRAPH_API_VERSION_MINOR;
+}
+
+/**
+ * @brief 64-bit FNV-1a over a byte range
+ */
+static inline uint64_t metagraph_bundle_checksum64(const void *data,
+                                                   size_t size) {
+    const uint8_t *bytes = data;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Checksum of a header with its header_checksum field zeroed
+ */
+static inline uint64_t
+metagraph_bundle_header_checksum(const metagraph_bundle_header_t *header) {
+    metagraph_bundle_header_t copy;
+    memcpy(&copy, header, sizeof(copy));
+    copy.header_checksum = 0;
+    return metagraph_bundle_checksum64(&copy, sizeof(copy));
+}
+
+/**
+ * @brief Section table checksum recorded for a section's BLAKE3 hash
+ */
+static inline uint64_t
+metagraph_bundle_section_checksum(const uint8_t root[METAGRAPH_BLAKE3_OUT_LEN]) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(value); i++) {
+        value |= (uint64_t)root[i] << (8U * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Binary form of METAGRAPH_BUNDLE_FORMAT_UUID
+ */
+void metagraph_bundle_format_uuid_bytes(uint8_t out_uuid[16]);
+
+/**
+ * @brief Hash binding the header, section table and INTEGRITY section
+ *
+ * The header is hashed with header_checksum and integrity_hash zeroed.
+ */
+metagraph_result_t metagraph_bundle_integrity_digest(
+    const metagraph_bundle_header_t *header,
+    const metagraph_section_header_t *sections, const void *integrity,
+    size_t integrity_size, metagraph_blake3_hash_t *out_hash);
+
+/**
+ * @brief Uncompressed STORE size, including the STOREs of a delta's bases
+ *
+ * Node records address this many bytes of store.
+ */
+metagraph_result_t
+metagraph_bundle_store_extent(const metagraph_bundle_t *bundle,
+                              uint64_t *out_size);
+
+/**
+ * @brief Whether a section is present, in the bundle or inherited
+ *
+ * false for a type at or beyond METAGRAPH_SECTION_TYPE_COUNT.
+ */
+bool metagraph_bundle_has_section(const metagraph_bundle_t *bundle,
+                                  metagraph_section_type_t type);
+
+/**
+ * @brief Borrow a node's record, patched for an applied delta
+ */
+metagraph_result_t metagraph_bundle_node_record(
+    const metagraph_bundle_t *bundle, metagraph_node_index_t node,
+    const metagraph_bundle_node_record_t **out_record);
+
+/**
+ * @brief Access counters a residency policy reads (see residency.c)
+ */
+typedef struct metagraph_residency_tracker metagraph_residency_tracker_t;
+
+/**
+ * @brief The bundle's tracker slot, NULL until a policy first attaches
+ *
+ * A tracker, once installed, lives as long as the bundle.
+ */
+_Atomic(metagraph_residency_tracker_t *) *
+metagraph_bundle_tracker_slot(const metagraph_bundle_t *bundle);
+
+/**
+ * @brief Where a section the bundle itself holds lies in its mapping
+ * @return false when the section is absent or inherited from a base
+ */
+bool metagraph_bundle_own_section(const metagraph_bundle_t *bundle,
+                                  metagraph_section_type_t type,
+                                  uint64_t *out_offset, uint64_t *out_size,
+                                  uint32_t *out_flags);
+
+/**
+ * @brief Borrowed arrays of the EDGES section, the bundle's or inherited
+ */
+typedef struct {
+    const metagraph_bundle_edge_record_t *records;
+    size_t edge_count;
+    const uint32_t *members;
+    size_t member_count;
+    size_t node_count; ///< Nodes covered by the row arrays
+    const uint32_t *out_rows;
+    const uint32_t *out_edges;
+    size_t out_count;
+    const uint32_t *in_rows;
+    const uint32_t *in_edges;
+    size_t in_count;
+} metagraph_bundle_edge_arrays_t;
+
+/**
+ * @brief Hydrate EDGES and borrow its arrays
+ *
+ * Row arrays are validated; edge records and list entries are not.
+ */
+metagraph_result_t
+metagraph_bundle_edge_arrays(const metagraph_bundle_t *bundle,
+                             metagraph_bundle_edge_arrays_t *out_arrays);
+
+#endif // SRC_BUNDLE_INTERNAL_H
@@ -0,0 +1,2675 @@
+/**
+ * @file bundle_writer.c
+ * @brief Serialize a graph into the bundle format
+ *
+ * The layout is computed up front so every record can be written in a
+ * single sequential pass. Output goes to a temporary file that is renamed
+ * over the destination once complete, so readers never observe a partially
+ * written bundle. Once the data sections are on disk the temporary file is
+ * mapped and hashed in parallel to produce the INTEGRITY section, and the
+ * header and section table are rewritten with the resulting hashes.
+ *
+ * The LOOKUP section's perfect hash tables are built at write time from
+ * the node IDs and the hashes of the normalized node names, so readers
+ * never build a table.
+ *
+ * A compressed STORE is laid out raw first, then compressed a batch of
+ * blocks at a time on a worker team into a temporary file. Its size is
+ * only known once every block is compressed, so this happens before the
+ * sections are placed.
+ *
+ * The streaming builder shares the layout and hashing code but never holds
+ * the graph: records, payloads and members go to spill files as they are
+ * added, and finishing copies and encodes each section into a mapping of
+ * the output on a worker team before hashing and fixing up the header.
+ */
+
+#include "metagraph/bundle.h"
+#include "metagraph/integrity.h"
+#include "metagraph/memory.h"
+#include "metagraph/mmap.h"
+#include "metagraph/result.h"
+
+#include "blake3_internal.h"
+#include "bundle_internal.h"
+#include "id_index.h"
+#include "lz.h"
+#include "path_internal.h"
+#include "perfect_hash.h"
+#include "platform.h"
+#include "reorder.h"
+#include "work_pool.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Initial scratch arena block; grows for graphs with high-degree nodes.
+#define METAGRAPH_WRITE_SCRATCH_SIZE (64U * 1024U)
+
+// STORE blocks compressed per worker per batch, and the batch size cap
+#define METAGRAPH_WRITE_DEFLATE_BLOCKS_PER_THREAD 4U
+#define METAGRAPH_WRITE_DEFLATE_BATCH_LIMIT (64U * 1024U * 1024U)
+
+// Buffer for copying a temporary file into the output
+#define METAGRAPH_WRITE_COPY_BUFFER (64U * 1024U)
+
+// Section order in the file
+enum {
+    METAGRAPH_WRITE_INDEX,
+    METAGRAPH_WRITE_NODES,
+    METAGRAPH_WRITE_EDGES,
+    METAGRAPH_WRITE_STORE,
+    METAGRAPH_WRITE_METADATA,
+    METAGRAPH_WRITE_LOOKUP,
+    METAGRAPH_WRITE_INTEGRITY, // hashes everything before it; keep last
+    METAGRAPH_WRITE_SECTION_COUNT
+};
+
+// Sections covered by a Merkle tree
+#define METAGRAPH_WRITE_HASHED_COUNT METAGRAPH_WRITE_INTEGRITY
+
+typedef struct {
+    FILE *file;
+    const char *path;
+    uint64_t position;
+} metagraph_bundle_sink_t;
+
+// Path lookup key of a named node
+typedef struct {
+    metagraph_id_t hash; ///< metagraph_path_hash() of the normalized name
+    uint32_t node;
+    uint32_t reserved;
+} metagraph_bundle_path_key_t;
+
+typedef struct {
+    const metagraph_graph_t *graph;
+    size_t node_count;
+    size_t edge_count;
+    uint64_t member_count;
+    uint64_t out_count;
+    uint64_t in_count;
+    uint64_t store_size; ///< Uncompressed STORE size
+    metagraph_bundle_compression_header_t store_header; ///< codec and
+                                                        ///< block_log2 set
+                                                        ///< from the options
+    uint64_t *store_seek; ///< Block offsets of a compressed STORE
+    metagraph_bundle_sink_t *packed; ///< Compressed STORE blocks (borrowed)
+    size_t max_degree;
+    metagraph_id_index_t index;
+    metagraph_bundle_index_header_t index_header;
+    metagraph_bundle_edges_header_t edges_header;
+    metagraph_bundle_path_key_t *path_keys; ///< Distinct once planned
+    size_t path_key_count;
+    metagraph_bundle_lookup_header_t lookup_header; ///< Seeds left zero
+    metagraph_section_header_t sections[METAGRAPH_WRITE_SECTION_COUNT];
+    uint32_t chunk_log2; ///< Merkle leaf size of the INTEGRITY section
+    metagraph_memory_pool_t *scratch; ///< Temporaries of this write
+} metagraph_bundle_layout_t;
+
+static metagraph_result_t metagraph_bundle_emit(metagraph_bundle_sink_t *sink,
+                                                const void *data, size_t size) {
+    if (size && fwrite(data, 1, size, sink->file) != size) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Write to %s failed (errno %d)", sink->path,
+                             errno);
+    }
+    sink->position += size;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t metagraph_bundle_pad_to(metagraph_bundle_sink_t *sink,
+                                                  uint64_t offset) {
+    static const uint8_t zeros[256];
+    while (sink->position < offset) {
+        uint64_t gap = offset - sink->position;
+        size_t chunk = gap < sizeof(zeros) ? (size_t)gap : sizeof(zeros);
+        METAGRAPH_CHECK(metagraph_bundle_emit(sink, zeros, chunk));
+    }
+    return METAGRAPH_OK();
+}
+
+// Read everything written through a temporary sink back into dest.
+static metagraph_result_t
+metagraph_bundle_sink_read(const metagraph_bundle_sink_t *sink, uint8_t *dest) {
+    const size_t size = (size_t)sink->position;
+    if (fseek(sink->file, 0, SEEK_SET) != 0 ||
+        fread(dest, 1, size, sink->file) != size) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Reading back %s failed (errno %d)", sink->path,
+                             errno);
+    }
+    return METAGRAPH_OK();
+}
+
+// Append everything written through a temporary sink to another sink.
+static metagraph_result_t
+metagraph_bundle_sink_copy(metagraph_bundle_sink_t *sink,
+                           const metagraph_bundle_sink_t *from) {
+    uint8_t buffer[METAGRAPH_WRITE_COPY_BUFFER];
+    if (fseek(from->file, 0, SEEK_SET) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Seek in %s failed (errno %d)", from->path,
+                             errno);
+    }
+    uint64_t remaining = from->position;
+    while (remaining > 0) {
+        const size_t chunk = remaining < sizeof(buffer) ? (size_t)remaining
+                                                        : sizeof(buffer);
+        if (fread(buffer, 1, chunk, from->file) != chunk) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                                 "Reading back %s failed (errno %d)",
+                                 from->path, errno);
+        }
+        METAGRAPH_CHECK(metagraph_bundle_emit(sink, buffer, chunk));
+        remaining -= chunk;
+    }
+    return METAGRAPH_OK();
+}
+
+// Store offset of a node's payload and name given the running cursor.
+// The layout pass and the STORE pass must agree, so both use this.
+static void metagraph_bundle_store_place(const metagraph_node_metadata_t *node,
+                                         uint64_t *cursor,
+                                         uint64_t *out_data_offset,
+                                         uint64_t *out_name_offset) {
+    *out_data_offset =
+        metagraph_bundle_align_up(*cursor, METAGRAPH_BUNDLE_DATA_ALIGN);
+    *cursor = *out_data_offset + node->data_size;
+    if (node->name) {
+        *out_name_offset = *cursor;
+        *cursor += strlen(node->name) + 1U;
+    } else {
+        *out_name_offset = METAGRAPH_BUNDLE_NO_OFFSET;
+    }
+}
+
+// Names that cannot be normalized are keyed verbatim, as lookups of them
+// are.
+static metagraph_id_t metagraph_bundle_name_hash(const char *name) {
+    const size_t length = strlen(name);
+    char normalized[METAGRAPH_PATH_MAX + 1U];
+    size_t normalized_length = 0;
+    if (length <= METAGRAPH_PATH_MAX &&
+        metagraph_path_normalize_into(name, length, normalized,
+                                      &normalized_length)) {
+        return metagraph_path_hash(normalized, normalized_length);
+    }
+    return metagraph_path_hash(name, length);
+}
+
+static int metagraph_bundle_compare_path_keys(const void *left,
+                                              const void *right) {
+    const metagraph_bundle_path_key_t *a = left;
+    const metagraph_bundle_path_key_t *b = right;
+    if (a->hash.high != b->hash.high) {
+        return a->hash.high < b->hash.high ? -1 : 1;
+    }
+    if (a->hash.low != b->hash.low) {
+        return a->hash.low < b->hash.low ? -1 : 1;
+    }
+    return a->node < b->node ? -1 : (a->node > b->node ? 1 : 0);
+}
+
+// Sort the path keys and keep the lowest node of each name. Names with
+// equal 128-bit hashes are treated as the same name.
+static void metagraph_bundle_unique_paths(metagraph_bundle_layout_t *layout) {
+    metagraph_bundle_path_key_t *keys = layout->path_keys;
+    if (layout->path_key_count < 2U) {
+        return;
+    }
+    qsort(keys, layout->path_key_count, sizeof(*keys),
+          metagraph_bundle_compare_path_keys);
+    size_t unique = 1;
+    for (size_t i = 1; i < layout->path_key_count; i++) {
+        if (keys[i].hash.high != keys[unique - 1U].hash.high ||
+            keys[i].hash.low != keys[unique - 1U].hash.low) {
+            keys[unique++] = keys[i];
+        }
+    }
+    layout->path_key_count = unique;
+}
+
+// Place a perfect hash table's arrays from offset; returns its end.
+static uint64_t
+metagraph_bundle_plan_lookup_table(metagraph_bundle_lookup_table_t *table,
+                                   uint64_t key_count, uint64_t slot_size,
+                                   uint64_t offset) {
+    memset(table, 0, sizeof(*table));
+    table->key_count = key_count;
+    metagraph_perfect_hash_shape(key_count, &table->bucket_count,
+                                 &table->table_size);
+    table->pilots_offset = offset;
+    table->remap_offset = offset + table->bucket_count * 4U;
+    table->slots_offset = metagraph_bundle_align_up(
+        table->remap_offset + (table->table_size - key_count) * 4U, 8U);
+    return table->slots_offset + key_count * slot_size;
+}
+
+// Place every section given the counts, index and store size in layout.
+static metagraph_result_t
+metagraph_bundle_plan_sections(metagraph_bundle_layout_t *layout) {
+    if (layout->member_count > UINT32_MAX || layout->out_count > UINT32_MAX ||
+        layout->in_count > UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Graph adjacency exceeds 32-bit bundle offsets");
+    }
+
+    // INDEX: header, control bytes, slots
+    metagraph_bundle_index_header_t *index_header = &layout->index_header;
+    index_header->capacity = layout->index.capacity;
+    index_header->count = layout->node_count;
+    index_header->ctrl_offset = sizeof(*index_header);
+    index_header->slots_offset = metagraph_bundle_align_up(
+        index_header->ctrl_offset + layout->index.capacity +
+            METAGRAPH_ID_INDEX_GROUP,
+        8U);
+    const uint64_t index_size =
+        index_header->slots_offset +
+        layout->index.capacity * sizeof(metagraph_id_slot_t);
+
+    // EDGES: header, records, members, out CSR, in CSR
+    const uint64_t rows_size = ((uint64_t)layout->node_count + 1U) * 4U;
+    metagraph_bundle_edges_header_t *edges_header = &layout->edges_header;
+    edges_header->node_count = layout->node_count;
+    edges_header->edge_count = layout->edge_count;
+    edges_header->member_count = layout->member_count;
+    edges_header->out_count = layout->out_count;
+    edges_header->in_count = layout->in_count;
+    edges_header->records_offset = sizeof(*edges_header);
+    edges_header->members_offset =
+        edges_header->records_offset +
+        layout->edge_count * sizeof(metagraph_bundle_edge_record_t);
+    edges_header->out_rows_offset =
+        edges_header->members_offset + layout->member_count * 4U;
+    edges_header->out_edges_offset = edges_header->out_rows_offset + rows_size;
+    edges_header->in_rows_offset =
+        edges_header->out_edges_offset + layout->out_count * 4U;
+    edges_header->in_edges_offset = edges_header->in_rows_offset + rows_size;
+    const uint64_t edges_size =
+        edges_header->in_edges_offset + layout->in_count * 4U;
+
+    // LOOKUP: header, then pilots, remap and slots of the ID and path tables
+    metagraph_bundle_lookup_header_t *lookup_header = &layout->lookup_header;
+    const uint64_t lookup_size = metagraph_bundle_plan_lookup_table(
+        &lookup_header->paths, layout->path_key_count,
+        sizeof(metagraph_bundle_path_slot_t),
+        metagraph_bundle_plan_lookup_table(&lookup_header->ids,
+                                           layout->node_count,
+                                           sizeof(metagraph_id_slot_t),
+                                           sizeof(*lookup_header)));
+
+    // STORE: raw, or sub-header, seek table and packed blocks
+    const bool compressed =
+        layout->store_header.codec != METAGRAPH_COMPRESSION_NONE;
+    const uint64_t store_size =
+        compressed ? layout->store_seek[layout->store_header.block_count]
+                   : layout->store_size;
+    const uint32_t store_flags =
+        compressed ? (uint32_t)METAGRAPH_SECTION_FLAG_COMPRESSED : 0U;
+
+    struct {
+        uint32_t type;
+        uint64_t size;
+        uint64_t items;
+        uint32_t flags;
+    } plan[METAGRAPH_WRITE_SECTION_COUNT] = {
+        [METAGRAPH_WRITE_INDEX] = {METAGRAPH_SECTION_INDEX, index_size,
+                                   layout->node_count},
+        [METAGRAPH_WRITE_NODES] = {METAGRAPH_SECTION_NODES,
+                                   layout->node_count *
+                                       sizeof(metagraph_bundle_node_record_t),
+                                   layout->node_count},
+        [METAGRAPH_WRITE_EDGES] = {METAGRAPH_SECTION_EDGES, edges_size,
+                                   layout->edge_count},
+        [METAGRAPH_WRITE_STORE] = {METAGRAPH_SECTION_STORE, store_size,
+                                   layout->node_count, store_flags},
+        [METAGRAPH_WRITE_METADATA] = {METAGRAPH_SECTION_METADATA,
+                                      sizeof(metagraph_bundle_metadata_t), 1U},
+        [METAGRAPH_WRITE_LOOKUP] = {METAGRAPH_SECTION_LOOKUP, lookup_size,
+                                    layout->node_count + layout->path_key_count},
+    };
+
+    // INTEGRITY: header, one entry per hashed section, then their leaves
+    uint64_t integrity_size =
+        sizeof(metagraph_bundle_integrity_header_t) +
+        METAGRAPH_WRITE_HASHED_COUNT * sizeof(metagraph_bundle_integrity_entry_t);
+    for (size_t i = 0; i < METAGRAPH_WRITE_HASHED_COUNT; i++) {
+        integrity_size +=
+            metagraph_merkle_leaf_count((size_t)plan[i].size,
+                                        (size_t)1U << layout->chunk_log2) *
+            sizeof(metagraph_blake3_hash_t);
+    }
+    plan[METAGRAPH_WRITE_INTEGRITY].type = METAGRAPH_SECTION_INTEGRITY;
+    plan[METAGRAPH_WRITE_INTEGRITY].size = integrity_size;
+    plan[METAGRAPH_WRITE_INTEGRITY].items = METAGRAPH_WRITE_HASHED_COUNT;
+
+    uint64_t offset = metagraph_bundle_align_up(
+        sizeof(metagraph_bundle_header_t) +
+            sizeof(layout->sections),
+        METAGRAPH_BUNDLE_SECTION_ALIGN);
+    for (size_t i = 0; i < METAGRAPH_WRITE_SECTION_COUNT; i++) {
+        layout->sections[i] = (metagraph_section_header_t){
+            .type = plan[i].type,
+            .flags = plan[i].flags,
+            .offset = offset,
+            .size = plan[i].size,
+            .item_count = (uint32_t)plan[i].items,
+        };
+        offset = metagraph_bundle_align_up(offset + plan[i].size,
+                                           METAGRAPH_BUNDLE_SECTION_ALIGN);
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_pack_graph_store(metagraph_bundle_layout_t *layout);
+
+static metagraph_result_t
+metagraph_bundle_plan(metagraph_bundle_layout_t *layout) {
+    const metagraph_graph_t *graph = layout->graph;
+    layout->node_count = metagraph_graph_node_count(graph);
+    layout->edge_count = metagraph_graph_edge_count(graph);
+
+    METAGRAPH_CHECK(metagraph_id_index_init(&layout->index, layout->node_count));
+    layout->path_keys =
+        malloc((layout->node_count ? layout->node_count : 1U) *
+               sizeof(*layout->path_keys));
+    METAGRAPH_CHECK_ALLOC(layout->path_keys);
+    for (size_t i = 0; i < layout->node_count; i++) {
+        metagraph_node_metadata_t node;
+        METAGRAPH_CHECK(
+            metagraph_graph_get_node(graph, (metagraph_node_index_t)i, &node));
+        bool inserted = false;
+        METAGRAPH_CHECK(
+            metagraph_id_index_insert(&layout->index, node.id, (uint32_t)i,
+                                      &inserted));
+        if (node.name) {
+            layout->path_keys[layout->path_key_count++] =
+                (metagraph_bundle_path_key_t){
+                    .hash = metagraph_bundle_name_hash(node.name),
+                    .node = (uint32_t)i,
+                };
+        }
+
+        uint64_t data_offset = 0;
+        uint64_t name_offset = 0;
+        metagraph_bundle_store_place(&node, &layout->store_size, &data_offset,
+                                     &name_offset);
+
+        size_t out_degree = 0;
+        size_t in_degree = 0;
+        METAGRAPH_CHECK(metagraph_graph_get_outgoing_edges(
+            graph, (metagraph_node_index_t)i, NULL, 0, &out_degree));
+        METAGRAPH_CHECK(metagraph_graph_get_incoming_edges(
+            graph, (metagraph_node_index_t)i, NULL, 0, &in_degree));
+        layout->out_count += out_degree;
+        layout->in_count += in_degree;
+        if (out_degree > layout->max_degree) {
+            layout->max_degree = out_degree;
+        }
+        if (in_degree > layout->max_degree) {
+            layout->max_degree = in_degree;
+        }
+    }
+    for (size_t i = 0; i < layout->edge_count; i++) {
+        metagraph_edge_metadata_t edge;
+        METAGRAPH_CHECK(
+            metagraph_graph_get_edge(graph, (metagraph_edge_index_t)i, &edge));
+        layout->member_count += edge.node_count;
+    }
+    metagraph_bundle_unique_paths(layout);
+    if (layout->store_header.codec != METAGRAPH_COMPRESSION_NONE) {
+        METAGRAPH_CHECK(metagraph_bundle_pack_graph_store(layout));
+    }
+    return metagraph_bundle_plan_sections(layout);
+}
+
+static uint64_t
+metagraph_bundle_file_size(const metagraph_bundle_layout_t *layout) {
+    const metagraph_section_header_t *last =
+        &layout->sections[METAGRAPH_WRITE_SECTION_COUNT - 1U];
+    return last->offset + last->size;
+}
+
+static void
+metagraph_bundle_fill_header(const metagraph_bundle_layout_t *layout,
+                             const metagraph_bundle_write_options_t *options,
+                             metagraph_bundle_header_t *out_header) {
+    metagraph_bundle_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, METAGRAPH_BUNDLE_MAGIC, METAGRAPH_BUNDLE_MAGIC_SIZE);
+    metagraph_bundle_format_uuid_bytes(header.format_uuid);
+    header.format_version = METAGRAPH_BUNDLE_FORMAT_VERSION;
+    header.api_version = metagraph_bundle_api_version();
+    header.total_size = metagraph_bundle_file_size(layout);
+    header.creation_time = options->creation_time;
+    header.bundle_id = options->bundle_id;
+    header.section_count = METAGRAPH_WRITE_SECTION_COUNT;
+    header.section_table_offset = sizeof(header);
+    if (layout->store_header.codec != METAGRAPH_COMPRESSION_NONE) {
+        header.flags |= METAGRAPH_BUNDLE_FLAG_COMPRESSED;
+    }
+    *out_header = header;
+}
+
+// integrity_hash is NULL for the placeholder written before hashing.
+static metagraph_result_t
+metagraph_bundle_write_header(metagraph_bundle_sink_t *sink,
+                              const metagraph_bundle_layout_t *layout,
+                              const metagraph_bundle_write_options_t *options,
+                              const metagraph_blake3_hash_t *integrity_hash) {
+    metagraph_bundle_header_t header;
+    metagraph_bundle_fill_header(layout, options, &header);
+    if (integrity_hash) {
+        memcpy(header.integrity_hash, integrity_hash->bytes,
+               sizeof(header.integrity_hash));
+    }
+    header.header_checksum = metagraph_bundle_header_checksum(&header);
+
+    METAGRAPH_CHECK(metagraph_bundle_emit(sink, &header, sizeof(header)));
+    return metagraph_bundle_emit(sink, layout->sections,
+                                 sizeof(layout->sections));
+}
+
+static metagraph_result_t
+metagraph_bundle_write_index(metagraph_bundle_sink_t *sink,
+                             const metagraph_bundle_layout_t *layout) {
+    const uint64_t base = sink->position;
+    const metagraph_id_index_t *index = &layout->index;
+    METAGRAPH_CHECK(metagraph_bundle_emit(sink, &layout->index_header,
+                                          sizeof(layout->index_header)));
+    METAGRAPH_CHECK(metagraph_bundle_emit(
+        sink, index->ctrl, index->capacity + METAGRAPH_ID_INDEX_GROUP));
+    METAGRAPH_CHECK(
+        metagraph_bundle_pad_to(sink, base + layout->index_header.slots_offset));
+    // Unused slots hold stale bytes in memory; write them zeroed.
+    for (size_t i = 0; i < index->capacity; i++) {
+        metagraph_id_slot_t slot = {0};
+        if (index->ctrl[i] >= 0) {
+            slot = index->slots[i];
+        }
+        METAGRAPH_CHECK(metagraph_bundle_emit(sink, &slot, sizeof(slot)));
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_write_nodes(metagraph_bundle_sink_t *sink,
+                             const metagraph_bundle_layout_t *layout) {
+    uint64_t cursor = 0;
+    for (size_t i = 0; i < layout->node_count; i++) {
+        metagraph_node_metadata_t node;
+        METAGRAPH_CHECK(metagraph_graph_get_node(
+            layout->graph, (metagraph_node_index_t)i, &node));
+        metagraph_bundle_node_record_t record;
+        memset(&record, 0, sizeof(record));
+        metagraph_bundle_store_place(&node, &cursor, &record.data_offset,
+                                     &record.name_offset);
+        record.id = node.id;
+        record.hash = node.hash;
+        record.data_size = node.data_size;
+        record.name_length = node.name ? (uint32_t)strlen(node.name) : 0U;
+        record.type = node.type;
+        METAGRAPH_CHECK(metagraph_bundle_emit(sink, &record, sizeof(record)));
+    }
+    return METAGRAPH_OK();
+}
+
+typedef metagraph_result_t (*metagraph_bundle_adjacency_fn)(
+    const metagraph_graph_t *graph, metagraph_node_index_t node,
+    metagraph_edge_index_t *out_edges, size_t capacity, size_t *out_count);
+
+static metagraph_result_t
+metagraph_bundle_write_csr(metagraph_bundle_sink_t *sink,
+                           const metagraph_bundle_layout_t *layout,
+                           metagraph_bundle_adjacency_fn adjacency,
+                           metagraph_edge_index_t *scratch) {
+    uint32_t row = 0;
+    METAGRAPH_CHECK(metagraph_bundle_emit(sink, &row, sizeof(row)));
+    for (size_t i = 0; i < layout->node_count; i++) {
+        size_t degree = 0;
+        METAGRAPH_CHECK(adjacency(layout->graph, (metagraph_node_index_t)i,
+                                  NULL, 0, &degree));
+        row += (uint32_t)degree;
+        METAGRAPH_CHECK(metagraph_bundle_emit(sink, &row, sizeof(row)));
+    }
+    for (size_t i = 0; i < layout->node_count; i++) {
+        size_t degree = 0;
+        METAGRAPH_CHECK(adjacency(layout->graph, (metagraph_node_index_t)i,
+                                  scratch, layout->max_degree, &degree));
+        METAGRAPH_CHECK(
+            metagraph_bundle_emit(sink, scratch, degree * sizeof(*scratch)));
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_write_edges(metagraph_bundle_sink_t *sink,
+                             const metagraph_bundle_layout_t *layout) {
+    const metagraph_graph_t *graph = layout->graph;
+    METAGRAPH_CHECK(metagraph_bundle_emit(sink, &layout->edges_header,
+                                          sizeof(layout->edges_header)));
+
+    uint32_t member_begin = 0;
+    for (size_t i = 0; i < layout->edge_count; i++) {
+        metagraph_edge_metadata_t edge;
+        METAGRAPH_CHECK(
+            metagraph_graph_get_edge(graph, (metagraph_edge_index_t)i, &edge));
+        const metagraph_bundle_edge_record_t record = {
+            .id = edge.id,
+            .type = edge.type,
+            .weight = edge.weight,
+            .member_begin = member_begin,
+            .member_count = (uint32_t)edge.node_count,
+        };
+        member_begin += record.member_count;
+        METAGRAPH_CHECK(metagraph_bundle_emit(sink, &record, sizeof(record)));
+    }
+    for (size_t i = 0; i < layout->edge_count; i++) {
+        const metagraph_node_index_t *members = NULL;
+        size_t count = 0;
+        METAGRAPH_CHECK(metagraph_graph_get_edge_nodes(
+            graph, (metagraph_edge_index_t)i, &members, &count));
+        METAGRAPH_CHECK(
+            metagraph_bundle_emit(sink, members, count * sizeof(*members)));
+    }
+
+    void *storage = NULL;
+    METAGRAPH_CHECK(metagraph_memory_pool_alloc(
+        layout->scratch,
+        (layout->max_degree ? layout->max_degree : 1U) *
+            sizeof(metagraph_edge_index_t),
+        &storage));
+    metagraph_edge_index_t *scratch = storage;
+    METAGRAPH_CHECK(metagraph_bundle_write_csr(
+        sink, layout, metagraph_graph_get_outgoing_edges, scratch));
+    return metagraph_bundle_write_csr(
+        sink, layout, metagraph_graph_get_incoming_edges, scratch);
+}
+
+static metagraph_result_t
+metagraph_bundle_write_store(metagraph_bundle_sink_t *sink,
+                             const metagraph_bundle_layout_t *layout) {
+    const uint64_t base = sink->position;
+    uint64_t cursor = 0;
+    for (size_t i = 0; i < layout->node_count; i++) {
+        metagraph_node_metadata_t node;
+        METAGRAPH_CHECK(metagraph_graph_get_node(
+            layout->graph, (metagraph_node_index_t)i, &node));
+        uint64_t data_offset = 0;
+        uint64_t name_offset = 0;
+        metagraph_bundle_store_place(&node, &cursor, &data_offset,
+                                     &name_offset);
+        METAGRAPH_CHECK(metagraph_bundle_pad_to(sink, base + data_offset));
+        METAGRAPH_CHECK(metagraph_bundle_emit(sink, node.data, node.data_size));
+        if (node.name) {
+            METAGRAPH_CHECK(
+                metagraph_bundle_emit(sink, node.name, strlen(node.name) + 1U));
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+// One batch of STORE blocks: block i is read from raw and written to
+// packed at i << block_log2.
+typedef struct {
+    const uint8_t *raw;
+    uint8_t *packed;
+    size_t *packed_size;
+    size_t raw_size; ///< Raw bytes in the batch
+    uint32_t block_log2;
+} metagraph_bundle_deflate_job_t;
+
+static void metagraph_bundle_deflate_range(void *context, uint32_t worker,
+                                           size_t begin, size_t end) {
+    (void)worker;
+    const metagraph_bundle_deflate_job_t *job = context;
+    const size_t block_size = (size_t)1U << job->block_log2;
+    for (size_t i = begin; i < end; i++) {
+        const size_t offset = i * block_size;
+        const size_t remaining = job->raw_size - offset;
+        const size_t length = remaining < block_size ? remaining : block_size;
+        // Blocks that do not shrink are stored as is.
+        size_t size = metagraph_lz_compress(job->raw + offset, length,
+                                            job->packed + offset, length - 1U);
+        if (size == 0) {
+            memcpy(job->packed + offset, job->raw + offset, length);
+            size = length;
+        }
+        job->packed_size[i] = size;
+    }
+}
+
+// Compress the raw STORE written through raw into packed and fill in the
+// STORE sub-header and seek table. Blocks are read a batch at a time and
+// compressed on a worker team, so memory is bounded by the batch size and
+// the output does not depend on the thread count.
+static metagraph_result_t
+metagraph_bundle_deflate_store(metagraph_bundle_layout_t *layout,
+                               metagraph_bundle_sink_t *raw,
+                               metagraph_bundle_sink_t *packed,
+                               uint32_t thread_count) {
+    metagraph_bundle_compression_header_t *header = &layout->store_header;
+    const uint32_t block_log2 = header->block_log2;
+    const size_t block_size = (size_t)1U << block_log2;
+    header->raw_size = layout->store_size;
+    header->block_count = (layout->store_size + block_size - 1U) >> block_log2;
+    header->seek_offset = sizeof(*header);
+    const size_t block_count = (size_t)header->block_count;
+
+    void *storage = NULL;
+    METAGRAPH_CHECK(metagraph_memory_pool_alloc(
+        layout->scratch, (block_count + 1U) * sizeof(uint64_t), &storage));
+    uint64_t *seek = storage;
+    layout->store_seek = seek;
+    uint64_t cursor = metagraph_bundle_align_up(
+        sizeof(*header) + (block_count + 1U) * sizeof(uint64_t),
+        METAGRAPH_BUNDLE_DATA_ALIGN);
+    seek[block_count] = cursor;
+    if (block_count == 0) {
+        return METAGRAPH_OK();
+    }
+
+    METAGRAPH_CHECK(metagraph_bundle_pad_to(raw, layout->store_size));
+    if (fseek(raw->file, 0, SEEK_SET) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Seek in %s failed (errno %d)", raw->path, errno);
+    }
+    uint32_t threads = thread_count ? thread_count : metagraph_cpu_count();
+    size_t batch_blocks =
+        (size_t)threads * METAGRAPH_WRITE_DEFLATE_BLOCKS_PER_THREAD;
+    if (batch_blocks > METAGRAPH_WRITE_DEFLATE_BATCH_LIMIT >> block_log2) {
+        batch_blocks = METAGRAPH_WRITE_DEFLATE_BATCH_LIMIT >> block_log2;
+    }
+    if (batch_blocks > block_count) {
+        batch_blocks = block_count;
+    }
+    if (threads > batch_blocks) {
+        threads = (uint32_t)batch_blocks;
+    }
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_work_pool_t *pool = NULL;
+    uint8_t *raw_batch = malloc(batch_blocks << block_log2);
+    uint8_t *packed_batch = malloc(batch_blocks << block_log2);
+    size_t *packed_size = malloc(batch_blocks * sizeof(*packed_size));
+    if (!raw_batch || !packed_batch || !packed_size) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Cannot allocate %zu STORE blocks to compress",
+                               batch_blocks);
+        goto done;
+    }
+    METAGRAPH_CHECK_GOTO(metagraph_work_pool_create(threads, &pool), done);
+
+    for (size_t first = 0; first < block_count; first += batch_blocks) {
+        const size_t count = block_count - first < batch_blocks
+                                 ? block_count - first
+                                 : batch_blocks;
+        const uint64_t begin = (uint64_t)first << block_log2;
+        const uint64_t available = layout->store_size - begin;
+        const size_t bytes = available < ((uint64_t)count << block_log2)
+                                 ? (size_t)available
+                                 : count << block_log2;
+        if (fread(raw_batch, 1, bytes, raw->file) != bytes) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                                   "Reading back %s failed (errno %d)",
+                                   raw->path, errno);
+            goto done;
+        }
+        metagraph_bundle_deflate_job_t job = {
+            .raw = raw_batch,
+            .packed = packed_batch,
+            .packed_size = packed_size,
+            .raw_size = bytes,
+            .block_log2 = block_log2,
+        };
+        metagraph_work_pool_for(pool, count, 1, metagraph_bundle_deflate_range,
+                                &job);
+        for (size_t i = 0; i < count; i++) {
+            seek[first + i] = cursor;
+            METAGRAPH_CHECK_GOTO(
+                metagraph_bundle_emit(packed, packed_batch + (i << block_log2),
+                                      packed_size[i]),
+                done);
+            cursor += packed_size[i];
+        }
+    }
+    seek[block_count] = cursor;
+
+done:
+    metagraph_work_pool_destroy(pool);
+    free(raw_batch);
+    free(packed_batch);
+    free(packed_size);
+    return result;
+}
+
+// Lay the graph's STORE out in a temporary file and compress it into
+// layout->packed.
+static metagraph_result_t
+metagraph_bundle_pack_graph_store(metagraph_bundle_layout_t *layout) {
+    metagraph_bundle_sink_t raw = {.file = tmpfile(),
+                                   .path = "temporary STORE file"};
+    if (!raw.file) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Cannot create a temporary STORE file (errno %d)",
+                             errno);
+    }
+    metagraph_result_t result = metagraph_bundle_write_store(&raw, layout);
+    if (metagraph_result_is_success(result)) {
+        result =
+            metagraph_bundle_deflate_store(layout, &raw, layout->packed, 0);
+    }
+    (void)fclose(raw.file);
+    return result;
+}
+
+// Sub-header, seek table and packed blocks of a compressed STORE
+static metagraph_result_t
+metagraph_bundle_write_packed_store(metagraph_bundle_sink_t *sink,
+                                    const metagraph_bundle_layout_t *layout) {
+    const uint64_t base = sink->position;
+    const metagraph_bundle_compression_header_t *header = &layout->store_header;
+    METAGRAPH_CHECK(metagraph_bundle_emit(sink, header, sizeof(*header)));
+    METAGRAPH_CHECK(metagraph_bundle_emit(
+        sink, layout->store_seek,
+        ((size_t)header->block_count + 1U) * sizeof(uint64_t)));
+    METAGRAPH_CHECK(
+        metagraph_bundle_pad_to(sink, base + layout->store_seek[0]));
+    return metagraph_bundle_sink_copy(sink, layout->packed);
+}
+
+static void metagraph_bundle_copy_text(char *dest, size_t capacity,
+                                       const char *text) {
+    if (!text) {
+        return;
+    }
+    size_t length = strlen(text);
+    if (length >= capacity) {
+        length = capacity - 1U;
+    }
+    memcpy(dest, text, length);
+    dest[length] = '\0';
+}
+
+static void
+metagraph_bundle_fill_metadata(const metagraph_bundle_write_options_t *options,
+                               metagraph_bundle_metadata_t *out_metadata) {
+    metagraph_bundle_metadata_t metadata;
+    memset(&metadata, 0, sizeof(metadata));
+    metadata.creation_time = options->creation_time;
+    metadata.modification_time = options->creation_time;
+    metagraph_bundle_copy_text(metadata.creator, sizeof(metadata.creator),
+                               options->creator);
+    metagraph_bundle_copy_text(metadata.description,
+                               sizeof(metadata.description),
+                               options->description);
+    metadata.target_platform = options->target_platform;
+    metadata.compression_type = options->compression;
+    *out_metadata = metadata;
+}
+
+static metagraph_result_t
+metagraph_bundle_write_metadata(metagraph_bundle_sink_t *sink,
+                                const metagraph_bundle_write_options_t *options) {
+    metagraph_bundle_metadata_t metadata;
+    metagraph_bundle_fill_metadata(options, &metadata);
+    return metagraph_bundle_emit(sink, &metadata, sizeof(metadata));
+}
+
+// Build one perfect hash table into the zero-filled LOOKUP section at
+// section and record its seed. *out_slots (freed by the caller) receives
+// the slot of every key.
+static metagraph_result_t
+metagraph_bundle_fill_lookup_table(uint8_t *section, size_t header_offset,
+                                   const metagraph_bundle_lookup_table_t *plan,
+                                   const metagraph_id_t *keys,
+                                   uint32_t **out_slots) {
+    metagraph_bundle_lookup_table_t table = *plan;
+    uint32_t *slots = malloc((table.key_count ? (size_t)table.key_count : 1U) *
+                             sizeof(*slots));
+    METAGRAPH_CHECK_ALLOC(slots);
+    const metagraph_result_t result = metagraph_perfect_hash_build(
+        keys, (size_t)table.key_count,
+        (uint32_t *)(void *)(section + table.pilots_offset),
+        (uint32_t *)(void *)(section + table.remap_offset), slots, &table.seed);
+    if (metagraph_result_is_error(result)) {
+        free(slots);
+        return result;
+    }
+    memcpy(section + header_offset, &table, sizeof(table));
+    *out_slots = slots;
+    return METAGRAPH_OK();
+}
+
+// ids holds every node's ID in node order.
+static metagraph_result_t
+metagraph_bundle_fill_id_lookup(uint8_t *section,
+                                const metagraph_bundle_layout_t *layout,
+                                const metagraph_id_t *ids) {
+    const metagraph_bundle_lookup_table_t *table = &layout->lookup_header.ids;
+    uint32_t *slot_of = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_fill_lookup_table(
+        section, offsetof(metagraph_bundle_lookup_header_t, ids), table, ids,
+        &slot_of));
+    metagraph_id_slot_t *slots =
+        (metagraph_id_slot_t *)(void *)(section + table->slots_offset);
+    for (size_t i = 0; i < layout->node_count; i++) {
+        slots[slot_of[i]] = (metagraph_id_slot_t){.id = ids[i],
+                                                  .value = (uint32_t)i};
+    }
+    free(slot_of);
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_fill_path_lookup(uint8_t *section,
+                                  const metagraph_bundle_layout_t *layout) {
+    const metagraph_bundle_lookup_table_t *table = &layout->lookup_header.paths;
+    const size_t count = layout->path_key_count;
+    metagraph_id_t *keys = calloc(count ? count : 1U, sizeof(*keys));
+    METAGRAPH_CHECK_ALLOC(keys);
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = layout->path_keys[i].hash;
+    }
+    uint32_t *slot_of = NULL;
+    const metagraph_result_t result = metagraph_bundle_fill_lookup_table(
+        section, offsetof(metagraph_bundle_lookup_header_t, paths), table, keys,
+        &slot_of);
+    free(keys);
+    METAGRAPH_CHECK(result);
+    metagraph_bundle_path_slot_t *slots =
+        (metagraph_bundle_path_slot_t *)(void *)(section + table->slots_offset);
+    for (size_t i = 0; i < count; i++) {
+        slots[slot_of[i]] = (metagraph_bundle_path_slot_t){
+            .check = layout->path_keys[i].hash.high,
+            .node = layout->path_keys[i].node,
+        };
+    }
+    free(slot_of);
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_write_lookup(metagraph_bundle_sink_t *sink,
+                              const metagraph_bundle_layout_t *layout) {
+    const size_t size = (size_t)layout->sections[METAGRAPH_WRITE_LOOKUP].size;
+    void *storage = NULL;
+    METAGRAPH_CHECK(metagraph_memory_pool_alloc(layout->scratch, size, &storage));
+    uint8_t *section = storage;
+    memset(section, 0, size);
+    METAGRAPH_CHECK(metagraph_memory_pool_alloc(
+        layout->scratch,
+        (layout->node_count ? layout->node_count : 1U) * sizeof(metagraph_id_t),
+        &storage));
+    metagraph_id_t *ids = storage;
+    for (size_t i = 0; i < layout->node_count; i++) {
+        metagraph_node_metadata_t node;
+        METAGRAPH_CHECK(metagraph_graph_get_node(
+            layout->graph, (metagraph_node_index_t)i, &node));
+        ids[i] = node.id;
+    }
+    METAGRAPH_CHECK(metagraph_bundle_fill_id_lookup(section, layout, ids));
+    METAGRAPH_CHECK(metagraph_bundle_fill_path_lookup(section, layout));
+    return metagraph_bundle_emit(sink, section, size);
+}
+
+// Build the INTEGRITY payload from the first hashed_count sections of a
+// bundle image and record each section's hash in the section table.
+static metagraph_result_t
+metagraph_bundle_hash_image(const uint8_t *file,
+                            metagraph_section_header_t *sections,
+                            size_t hashed_count, uint32_t chunk_log2,
+                            metagraph_memory_pool_t *scratch,
+                            uint8_t *integrity) {
+    const size_t chunk_size = (size_t)1U << chunk_log2;
+    size_t max_leaves = 1;
+    for (size_t i = 0; i < hashed_count; i++) {
+        const size_t leaves =
+            metagraph_merkle_leaf_count((size_t)sections[i].size, chunk_size);
+        max_leaves = leaves > max_leaves ? leaves : max_leaves;
+    }
+    void *storage = NULL;
+    METAGRAPH_CHECK(metagraph_memory_pool_alloc(
+        scratch, (max_leaves + 1U) / 2U * sizeof(metagraph_blake3_hash_t),
+        &storage));
+    metagraph_blake3_hash_t *fold_scratch = storage;
+
+    const metagraph_bundle_integrity_header_t header = {
+        .chunk_log2 = chunk_log2,
+        .entry_count = (uint32_t)hashed_count,
+    };
+    memcpy(integrity, &header, sizeof(header));
+    uint64_t leaves_offset =
+        sizeof(header) +
+        hashed_count * sizeof(metagraph_bundle_integrity_entry_t);
+
+    for (size_t i = 0; i < hashed_count; i++) {
+        metagraph_section_header_t *section = &sections[i];
+        const uint8_t *data = file + section->offset;
+        const size_t size = (size_t)section->size;
+        const size_t leaf_count = metagraph_merkle_leaf_count(size, chunk_size);
+        metagraph_blake3_hash_t *leaves =
+            (metagraph_blake3_hash_t *)(void *)(integrity + leaves_offset);
+        metagraph_merkle_hash_leaves(data, size, chunk_size,
+                                     metagraph_blake3_thread_budget(size),
+                                     leaves);
+
+        metagraph_bundle_integrity_entry_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.type = section->type;
+        entry.leaf_count = leaf_count;
+        entry.leaves_offset = leaves_offset;
+        if (leaf_count == 1U) {
+            metagraph_blake3_root(data, size, 1, entry.root);
+        } else {
+            metagraph_blake3_hash_t root;
+            metagraph_merkle_fold(leaves, leaf_count, fold_scratch, &root);
+            memcpy(entry.root, root.bytes, sizeof(entry.root));
+        }
+        section->checksum = metagraph_bundle_section_checksum(entry.root);
+        memcpy(integrity + sizeof(header) + i * sizeof(entry), &entry,
+               sizeof(entry));
+        leaves_offset += leaf_count * sizeof(metagraph_blake3_hash_t);
+    }
+    return METAGRAPH_OK();
+}
+
+// Hash the data sections already written through the sink.
+static metagraph_result_t
+metagraph_bundle_hash_sections(const metagraph_bundle_sink_t *sink,
+                               metagraph_bundle_layout_t *layout,
+                               uint8_t *integrity) {
+    if (fflush(sink->file) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Flushing %s failed (errno %d)", sink->path,
+                             errno);
+    }
+    const metagraph_mapping_request_t request = {
+        .access_flags = METAGRAPH_MAP_ACCESS_READ,
+        .cache_flags = METAGRAPH_MAP_CACHE_POPULATE,
+    };
+    metagraph_memory_map_t *map = NULL;
+    METAGRAPH_CHECK(
+        metagraph_mmap_create_from_file(sink->path, &request, &map));
+    const metagraph_result_t result = metagraph_bundle_hash_image(
+        map->base_address, layout->sections, METAGRAPH_WRITE_HASHED_COUNT,
+        layout->chunk_log2, layout->scratch, integrity);
+    (void)metagraph_mmap_destroy(map);
+    return result;
+}
+
+static metagraph_result_t
+metagraph_bundle_write_all(metagraph_bundle_sink_t *sink,
+                           metagraph_bundle_layout_t *layout,
+                           const metagraph_bundle_write_options_t *options) {
+    METAGRAPH_CHECK(metagraph_bundle_write_header(sink, layout, options, NULL));
+
+    const metagraph_section_header_t *sections = layout->sections;
+    METAGRAPH_CHECK(
+        metagraph_bundle_pad_to(sink, sections[METAGRAPH_WRITE_INDEX].offset));
+    METAGRAPH_CHECK(metagraph_bundle_write_index(sink, layout));
+    METAGRAPH_CHECK(
+        metagraph_bundle_pad_to(sink, sections[METAGRAPH_WRITE_NODES].offset));
+    METAGRAPH_CHECK(metagraph_bundle_write_nodes(sink, layout));
+    METAGRAPH_CHECK(
+        metagraph_bundle_pad_to(sink, sections[METAGRAPH_WRITE_EDGES].offset));
+    METAGRAPH_CHECK(metagraph_bundle_write_edges(sink, layout));
+    METAGRAPH_CHECK(
+        metagraph_bundle_pad_to(sink, sections[METAGRAPH_WRITE_STORE].offset));
+    METAGRAPH_CHECK(layout->store_header.codec != METAGRAPH_COMPRESSION_NONE
+                        ? metagraph_bundle_write_packed_store(sink, layout)
+                        : metagraph_bundle_write_store(sink, layout));
+    METAGRAPH_CHECK(metagraph_bundle_pad_to(
+        sink, sections[METAGRAPH_WRITE_METADATA].offset));
+    METAGRAPH_CHECK(metagraph_bundle_write_metadata(sink, options));
+    METAGRAPH_CHECK(
+        metagraph_bundle_pad_to(sink, sections[METAGRAPH_WRITE_LOOKUP].offset));
+    METAGRAPH_CHECK(metagraph_bundle_write_lookup(sink, layout));
+
+    const metagraph_section_header_t *integrity_section =
+        &sections[METAGRAPH_WRITE_INTEGRITY];
+    METAGRAPH_CHECK(metagraph_bundle_pad_to(sink, integrity_section->offset));
+    void *storage = NULL;
+    METAGRAPH_CHECK(metagraph_memory_pool_alloc(
+        layout->scratch, (size_t)integrity_section->size, &storage));
+    uint8_t *integrity = storage;
+    METAGRAPH_CHECK(metagraph_bundle_hash_sections(sink, layout, integrity));
+    METAGRAPH_CHECK(metagraph_bundle_emit(sink, integrity,
+                                          (size_t)integrity_section->size));
+
+    if (sink->position != metagraph_bundle_file_size(layout)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INTERNAL_STATE,
+                             "Bundle layout mismatch: wrote %llu of %llu bytes",
+                             (unsigned long long)sink->position,
+                             (unsigned long long)metagraph_bundle_file_size(
+                                 layout));
+    }
+
+    // Rewrite the header and table now that the hashes are known.
+    metagraph_bundle_header_t header;
+    metagraph_bundle_fill_header(layout, options, &header);
+    metagraph_blake3_hash_t integrity_hash;
+    METAGRAPH_CHECK(metagraph_bundle_integrity_digest(
+        &header, layout->sections, integrity, (size_t)integrity_section->size,
+        &integrity_hash));
+    if (fseek(sink->file, 0, SEEK_SET) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Seek in %s failed (errno %d)", sink->path, errno);
+    }
+    sink->position = 0;
+    return metagraph_bundle_write_header(sink, layout, options,
+                                         &integrity_hash);
+}
+
+// Apply option defaults and derive the Merkle leaf size.
+static metagraph_result_t
+metagraph_bundle_resolve_options(const metagraph_bundle_write_options_t *options,
+                                 metagraph_bundle_write_options_t *out_effective,
+                                 metagraph_bundle_layout_t *layout) {
+    metagraph_bundle_write_options_t effective = {0};
+    if (options) {
+        effective = *options;
+    }
+    if (effective.creation_time == 0) {
+        effective.creation_time = (uint64_t)time(NULL);
+    }
+    if (effective.integrity_chunk_size == 0) {
+        effective.integrity_chunk_size = METAGRAPH_MERKLE_DEFAULT_CHUNK_SIZE;
+    }
+    const size_t chunk_size = effective.integrity_chunk_size;
+    if (chunk_size < METAGRAPH_BLAKE3_CHUNK_LEN ||
+        (chunk_size & (chunk_size - 1U)) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Integrity chunk size %zu is not a power of two "
+                             ">= %u",
+                             chunk_size, (unsigned)METAGRAPH_BLAKE3_CHUNK_LEN);
+    }
+    layout->chunk_log2 = 0;
+    while (((size_t)1U << layout->chunk_log2) < chunk_size) {
+        layout->chunk_log2++;
+    }
+
+    if (effective.compression > METAGRAPH_COMPRESSION_LZ) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Unknown compression codec %u",
+                             (unsigned)effective.compression);
+    }
+    if (effective.compression_block_size == 0) {
+        effective.compression_block_size = METAGRAPH_BUNDLE_DEFAULT_BLOCK_SIZE;
+    }
+    const size_t block_size = effective.compression_block_size;
+    if (block_size < ((size_t)1U << METAGRAPH_BUNDLE_MIN_BLOCK_LOG2) ||
+        block_size > ((size_t)1U << METAGRAPH_BUNDLE_MAX_BLOCK_LOG2) ||
+        (block_size & (block_size - 1U)) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Compression block size %zu is not a power of "
+                             "two from 4 KiB to 16 MiB",
+                             block_size);
+    }
+    if (effective.reorder > METAGRAPH_REORDER_GORDER) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Unknown reorder method %u",
+                             (unsigned)effective.reorder);
+    }
+    layout->store_header.codec = effective.compression;
+    layout->store_header.block_log2 = 0;
+    while (((size_t)1U << layout->store_header.block_log2) < block_size) {
+        layout->store_header.block_log2++;
+    }
+    *out_effective = effective;
+    return METAGRAPH_OK();
+}
+
+// Create path at its final size and map it writable, for writers that
+// encode sections in place. A file left behind is the caller's to remove.
+static metagraph_result_t
+metagraph_bundle_map_output(const char *path, uint64_t size,
+                            metagraph_memory_map_t **out_map) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return METAGRAPH_ERR(errno == EACCES ? METAGRAPH_ERROR_FILE_ACCESS_DENIED
+                                             : METAGRAPH_ERROR_IO_FAILURE,
+                             "Cannot create %s (errno %d)", path, errno);
+    }
+    const int resize_status = metagraph_file_resize(file, size);
+    const int close_status = fclose(file);
+    if (resize_status != 0 || close_status != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Cannot size %s to %llu bytes (errno %d)", path,
+                             (unsigned long long)size, errno);
+    }
+    const metagraph_mapping_request_t request = {
+        .access_flags = METAGRAPH_MAP_ACCESS_READ | METAGRAPH_MAP_ACCESS_WRITE,
+    };
+    return metagraph_mmap_create_from_file(path, &request, out_map);
+}
+
+// Sort key placing edges in the new order of their sources, ties kept in
+// graph order.
+static uint64_t metagraph_bundle_edge_key(const metagraph_graph_t *graph,
+                                          const metagraph_node_index_t *rank,
+                                          metagraph_edge_index_t edge) {
+    const metagraph_node_index_t *members = NULL;
+    size_t count = 0;
+    (void)metagraph_graph_get_edge_nodes(graph, edge, &members, &count);
+    return ((uint64_t)rank[members[0]] << 32U) | edge;
+}
+
+static int metagraph_bundle_compare_keys(const void *left, const void *right) {
+    const uint64_t a = *(const uint64_t *)left;
+    const uint64_t b = *(const uint64_t *)right;
+    return (a > b) - (a < b);
+}
+
+// Copy graph with its nodes renumbered by the selected method and its
+// edges sorted by source, so the unchanged writer lays the bundle out in
+// the new order. Payloads stay borrowed from graph.
+static metagraph_result_t
+metagraph_bundle_reorder_graph(const metagraph_graph_t *graph,
+                               const metagraph_bundle_write_options_t *options,
+                               metagraph_memory_pool_t *scratch,
+                               metagraph_graph_t **out_graph) {
+    const size_t node_count = metagraph_graph_node_count(graph);
+    const size_t edge_count = metagraph_graph_edge_count(graph);
+    void *storage = NULL;
+    METAGRAPH_CHECK(metagraph_memory_pool_alloc(
+        scratch, (2U * node_count + 1U) * sizeof(metagraph_node_index_t),
+        &storage));
+    metagraph_node_index_t *order = storage;
+    metagraph_node_index_t *rank = order + node_count;
+    METAGRAPH_CHECK(metagraph_memory_pool_alloc(
+        scratch, (edge_count + 1U) * sizeof(uint64_t), &storage));
+    uint64_t *edge_keys = storage;
+
+    METAGRAPH_CHECK(metagraph_reorder_nodes(
+        graph, (metagraph_reorder_t)options->reorder, order));
+    for (size_t i = 0; i < node_count; i++) {
+        rank[order[i]] = (metagraph_node_index_t)i;
+    }
+    if (options->reorder_report) {
+        METAGRAPH_CHECK(metagraph_reorder_measure(
+            graph, NULL, &options->reorder_report->before));
+        METAGRAPH_CHECK(metagraph_reorder_measure(
+            graph, rank, &options->reorder_report->after));
+    }
+    size_t max_members = 0;
+    for (size_t i = 0; i < edge_count; i++) {
+        edge_keys[i] =
+            metagraph_bundle_edge_key(graph, rank, (metagraph_edge_index_t)i);
+        metagraph_edge_metadata_t edge;
+        METAGRAPH_CHECK(
+            metagraph_graph_get_edge(graph, (metagraph_edge_index_t)i, &edge));
+        if (edge.node_count > max_members) {
+            max_members = edge.node_count;
+        }
+    }
+    qsort(edge_keys, edge_count, sizeof(*edge_keys),
+          metagraph_bundle_compare_keys);
+    METAGRAPH_CHECK(metagraph_memory_pool_alloc(
+        scratch, (max_members + 1U) * sizeof(metagraph_id_t), &storage));
+    metagraph_id_t *member_ids = storage;
+
+    const metagraph_graph_config_t config = {
+        .initial_node_capacity = node_count,
+        .initial_edge_capacity = edge_count,
+    };
+    metagraph_graph_t *copy = NULL;
+    METAGRAPH_CHECK(metagraph_graph_create(&config, &copy));
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    for (size_t i = 0; i < node_count; i++) {
+        metagraph_node_metadata_t node;
+        METAGRAPH_CHECK_GOTO(metagraph_graph_get_node(graph, order[i], &node),
+                             failed);
+        METAGRAPH_CHECK_GOTO(metagraph_graph_add_node(copy, &node, NULL),
+                             failed);
+    }
+    for (size_t i = 0; i < edge_count; i++) {
+        const metagraph_edge_index_t index =
+            (metagraph_edge_index_t)edge_keys[i];
+        metagraph_edge_metadata_t edge;
+        const metagraph_node_index_t *members = NULL;
+        size_t count = 0;
+        METAGRAPH_CHECK_GOTO(metagraph_graph_get_edge(graph, index, &edge),
+                             failed);
+        METAGRAPH_CHECK_GOTO(
+            metagraph_graph_get_edge_nodes(graph, index, &members, &count),
+            failed);
+        for (size_t m = 0; m < count; m++) {
+            metagraph_node_metadata_t node;
+            METAGRAPH_CHECK_GOTO(
+                metagraph_graph_get_node(graph, members[m], &node), failed);
+            member_ids[m] = node.id;
+        }
+        edge.nodes = member_ids;
+        METAGRAPH_CHECK_GOTO(metagraph_graph_add_edge(copy, &edge, NULL),
+                             failed);
+    }
+    *out_graph = copy;
+    return METAGRAPH_OK();
+
+failed:
+    (void)metagraph_graph_destroy(copy);
+    return result;
+}
+
+metagraph_result_t
+metagraph_bundle_write_graph(const metagraph_graph_t *graph,
+                             const char *file_path,
+                             const metagraph_bundle_write_options_t *options) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(file_path);
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_bundle_layout_t layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.graph = graph;
+    metagraph_bundle_write_options_t effective;
+    METAGRAPH_CHECK(
+        metagraph_bundle_resolve_options(options, &effective, &layout));
+    metagraph_bundle_sink_t packed = {.file = NULL,
+                                      .path = "temporary STORE file"};
+
+    const metagraph_pool_config_t scratch_config = {
+        .type = METAGRAPH_POOL_TYPE_ARENA,
+        .initial_size = METAGRAPH_WRITE_SCRATCH_SIZE,
+        .allow_growth = true,
+    };
+    METAGRAPH_CHECK(
+        metagraph_memory_pool_create(&scratch_config, &layout.scratch));
+    metagraph_graph_t *reordered = NULL;
+    if (effective.reorder != METAGRAPH_REORDER_NONE) {
+        METAGRAPH_CHECK_GOTO(metagraph_bundle_reorder_graph(graph, &effective,
+                                                            layout.scratch,
+                                                            &reordered),
+                             cleanup);
+        layout.graph = reordered;
+    } else if (effective.reorder_report) {
+        METAGRAPH_CHECK_GOTO(
+            metagraph_reorder_measure(graph, NULL,
+                                      &effective.reorder_report->before),
+            cleanup);
+        effective.reorder_report->after = effective.reorder_report->before;
+    }
+
+    const size_t path_length = strlen(file_path);
+    void *storage = NULL;
+    METAGRAPH_CHECK_GOTO(metagraph_memory_pool_aligned_alloc(
+                             layout.scratch, path_length + sizeof(".tmp"), 1,
+                             &storage),
+                         cleanup);
+    char *temp_path = storage;
+    memcpy(temp_path, file_path, path_length);
+    memcpy(temp_path + path_length, ".tmp", sizeof(".tmp"));
+
+    metagraph_bundle_sink_t sink = {.file = NULL, .path = temp_path};
+    if (effective.compression != METAGRAPH_COMPRESSION_NONE) {
+        packed.file = tmpfile();
+        if (!packed.file) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                                   "Cannot create %s (errno %d)", packed.path,
+                                   errno);
+            goto done;
+        }
+        layout.packed = &packed;
+    }
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_plan(&layout), done);
+
+    sink.file = fopen(temp_path, "wb");
+    if (!sink.file) {
+        result = METAGRAPH_ERR(errno == EACCES
+                                   ? METAGRAPH_ERROR_FILE_ACCESS_DENIED
+                                   : METAGRAPH_ERROR_IO_FAILURE,
+                               "Cannot create %s (errno %d)", temp_path, errno);
+        goto done;
+    }
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_write_all(&sink, &layout, &effective),
+                         done);
+    const int close_status = fclose(sink.file);
+    sink.file = NULL;
+    if (close_status != 0) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                               "Closing %s failed (errno %d)", temp_path,
+                               errno);
+        goto done;
+    }
+    if (rename(temp_path, file_path) != 0) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                               "Cannot move bundle into place at %s (errno %d)",
+                               file_path, errno);
+        goto done;
+    }
+
+done:
+    if (sink.file) {
+        (void)fclose(sink.file);
+    }
+    if (result != METAGRAPH_SUCCESS) {
+        (void)remove(temp_path);
+    }
+cleanup:
+    if (packed.file) {
+        (void)fclose(packed.file);
+    }
+    (void)metagraph_memory_pool_destroy(layout.scratch);
+    metagraph_id_index_destroy(&layout.index);
+    free(layout.path_keys);
+    (void)metagraph_graph_destroy(reordered);
+    return result;
+}
+
+// ============================================================================
+// Streaming builder
+// ============================================================================
+
+// Spill write buffering when the config leaves it unset
+#define METAGRAPH_BUILD_DEFAULT_BUFFERING (16U * 1024U * 1024U)
+#define METAGRAPH_BUILD_MIN_SPILL_BUFFER (4U * 1024U)
+
+// Named spills: "metagraph-spill-<pid>-<builder>-<serial>" and how many
+// serials to try past files left behind by other builders
+#define METAGRAPH_BUILD_SPILL_NAME_SIZE 64U
+#define METAGRAPH_BUILD_SPILL_ATTEMPTS 16U
+
+// Spill files, one per stream of appended data
+enum {
+    METAGRAPH_SPILL_NODES,   // metagraph_bundle_node_record_t per node
+    METAGRAPH_SPILL_STORE,   // STORE section bytes, already laid out
+    METAGRAPH_SPILL_EDGES,   // metagraph_bundle_edge_record_t per edge
+    METAGRAPH_SPILL_MEMBERS, // uint32_t member indices of every edge
+    METAGRAPH_SPILL_COUNT
+};
+
+// Encoding tasks run by finish(): the copy phase (with the path table,
+// which only needs the resident name hashes), then the index, ID table and
+// CSR phase which reads the records and members the copy phase placed.
+enum {
+    METAGRAPH_BUILD_NODES,
+    METAGRAPH_BUILD_EDGES,
+    METAGRAPH_BUILD_STORE,
+    METAGRAPH_BUILD_METADATA,
+    METAGRAPH_BUILD_PATH_LOOKUP,
+    METAGRAPH_BUILD_INDEX,
+    METAGRAPH_BUILD_ID_LOOKUP,
+    METAGRAPH_BUILD_OUT_CSR,
+    METAGRAPH_BUILD_IN_CSR,
+    METAGRAPH_BUILD_TASK_COUNT
+};
+
+#define METAGRAPH_BUILD_COPY_TASKS METAGRAPH_BUILD_INDEX
+
+typedef struct {
+    metagraph_bundle_sink_t sink;
+    char *path;   // Named spill to delete on destroy (NULL for tmpfile())
+    char *buffer; // stdio buffer of sink.file
+} metagraph_bundle_spill_t;
+
+struct metagraph_bundle_builder {
+    metagraph_bundle_write_options_t options;
+    uint32_t thread_count;
+    bool finished;
+    metagraph_result_t status; // First spill failure; the builder is unusable
+    metagraph_bundle_layout_t layout; // Node index, name hashes, counts and
+                                      // scratch arena
+    metagraph_id_index_t edge_index;
+    uint32_t *out_degree; // Per node; become CSR fill cursors in finish()
+    uint32_t *in_degree;
+    size_t degree_capacity;
+    metagraph_node_index_t *members; // Resolved members of one edge
+    size_t members_capacity;
+    metagraph_bundle_spill_t spills[METAGRAPH_SPILL_COUNT];
+    char *temp_directory; // Copy of the config's, NULL for tmpfile()
+    metagraph_bundle_spill_t packed; // Compressed STORE, opened by finish()
+};
+
+typedef struct {
+    metagraph_bundle_builder_t *builder;
+    uint8_t *file;     // Mapped output
+    size_t first_task; // Task run for range index 0 of the current phase
+    metagraph_error_context_t errors[METAGRAPH_BUILD_TASK_COUNT];
+} metagraph_bundle_encode_job_t;
+
+typedef metagraph_result_t (*metagraph_bundle_encode_task_fn)(
+    metagraph_bundle_encode_job_t *job);
+
+static metagraph_result_t
+metagraph_bundle_spill_open(metagraph_bundle_spill_t *spill,
+                            const char *directory, uintptr_t owner,
+                            size_t buffer_size) {
+    if (!directory) {
+        spill->sink.file = tmpfile();
+        spill->sink.path = "temporary spill file";
+    } else {
+        // Exclusive create: a clash fails instead of sharing another file.
+        // The PID keeps processes apart; a leftover file from a dead one
+        // just moves us on to the next serial.
+        static _Atomic(uint32_t) serial;
+        const size_t directory_length = strlen(directory);
+        char *path =
+            malloc(directory_length + METAGRAPH_BUILD_SPILL_NAME_SIZE + 1U);
+        METAGRAPH_CHECK_ALLOC(path);
+        memcpy(path, directory, directory_length);
+        path[directory_length] = '/';
+        for (uint32_t attempt = 0; attempt < METAGRAPH_BUILD_SPILL_ATTEMPTS;
+             attempt++) {
+            const uint32_t number = atomic_fetch_add(&serial, 1U);
+            (void)snprintf(path + directory_length + 1U,
+                           METAGRAPH_BUILD_SPILL_NAME_SIZE,
+                           "metagraph-spill-%llx-%llx-%x",
+                           (unsigned long long)metagraph_process_id(),
+                           (unsigned long long)owner, number);
+            spill->sink.file = fopen(path, "wb+x");
+            if (spill->sink.file || errno != EEXIST) {
+                break;
+            }
+        }
+        if (spill->sink.file) {
+            spill->path = path;
+        } else {
+            free(path);
+        }
+        spill->sink.path = directory;
+    }
+    if (!spill->sink.file) {
+        return METAGRAPH_ERR(errno == EACCES ? METAGRAPH_ERROR_FILE_ACCESS_DENIED
+                                             : METAGRAPH_ERROR_IO_FAILURE,
+                             "Cannot create spill file in %s (errno %d)",
+                             directory ? directory : "the temporary directory",
+                             errno);
+    }
+    spill->buffer = malloc(buffer_size);
+    METAGRAPH_CHECK_ALLOC(spill->buffer);
+    if (setvbuf(spill->sink.file, spill->buffer, _IOFBF, buffer_size) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Cannot buffer %s", spill->sink.path);
+    }
+    return METAGRAPH_OK();
+}
+
+static void metagraph_bundle_spill_close(metagraph_bundle_spill_t *spill) {
+    if (spill->sink.file) {
+        (void)fclose(spill->sink.file);
+    }
+    if (spill->path) {
+        (void)remove(spill->path);
+    }
+    free(spill->path);
+    free(spill->buffer);
+}
+
+metagraph_result_t
+metagraph_bundle_builder_create(const metagraph_bundle_builder_config_t *config,
+                                metagraph_bundle_builder_t **out_builder) {
+    METAGRAPH_CHECK_NULL(out_builder);
+    *out_builder = NULL;
+
+    metagraph_bundle_builder_config_t effective = {0};
+    if (config) {
+        effective = *config;
+    }
+    metagraph_bundle_builder_t *builder = calloc(1, sizeof(*builder));
+    METAGRAPH_CHECK_ALLOC(builder);
+    builder->thread_count = effective.thread_count;
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_resolve_options(&effective.write,
+                                                          &builder->options,
+                                                          &builder->layout),
+                         failed);
+    if (effective.write.reorder != METAGRAPH_REORDER_NONE) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                               "Streaming builders write nodes in the order "
+                               "they are added");
+        goto failed;
+    }
+    const metagraph_pool_config_t scratch_config = {
+        .type = METAGRAPH_POOL_TYPE_ARENA,
+        .initial_size = METAGRAPH_WRITE_SCRATCH_SIZE,
+        .allow_growth = true,
+    };
+    METAGRAPH_CHECK_GOTO(
+        metagraph_memory_pool_create(&scratch_config, &builder->layout.scratch),
+        failed);
+    METAGRAPH_CHECK_GOTO(metagraph_id_index_init(&builder->layout.index, 0),
+                         failed);
+    METAGRAPH_CHECK_GOTO(metagraph_id_index_init(&builder->edge_index, 0),
+                         failed);
+
+    if (effective.temp_directory) {
+        const size_t length = strlen(effective.temp_directory);
+        builder->temp_directory = malloc(length + 1U);
+        if (!builder->temp_directory) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                   "Cannot copy the spill directory");
+            goto failed;
+        }
+        memcpy(builder->temp_directory, effective.temp_directory, length + 1U);
+    }
+
+    const size_t buffering = effective.max_memory_usage
+                                 ? effective.max_memory_usage
+                                 : METAGRAPH_BUILD_DEFAULT_BUFFERING;
+    size_t spill_buffer = buffering / METAGRAPH_SPILL_COUNT;
+    if (spill_buffer < METAGRAPH_BUILD_MIN_SPILL_BUFFER) {
+        spill_buffer = METAGRAPH_BUILD_MIN_SPILL_BUFFER;
+    }
+    for (size_t i = 0; i < METAGRAPH_SPILL_COUNT; i++) {
+        METAGRAPH_CHECK_GOTO(
+            metagraph_bundle_spill_open(&builder->spills[i],
+                                        effective.temp_directory,
+                                        (uintptr_t)builder, spill_buffer),
+            failed);
+    }
+    *out_builder = builder;
+    return METAGRAPH_OK();
+
+failed:
+    (void)metagraph_bundle_builder_destroy(builder);
+    return result;
+}
+
+metagraph_result_t
+metagraph_bundle_builder_destroy(metagraph_bundle_builder_t *builder) {
+    if (!builder) {
+        return METAGRAPH_OK();
+    }
+    for (size_t i = 0; i < METAGRAPH_SPILL_COUNT; i++) {
+        metagraph_bundle_spill_close(&builder->spills[i]);
+    }
+    metagraph_bundle_spill_close(&builder->packed);
+    free(builder->temp_directory);
+    free(builder->out_degree);
+    free(builder->in_degree);
+    free(builder->layout.path_keys);
+    free(builder->members);
+    metagraph_id_index_destroy(&builder->edge_index);
+    metagraph_id_index_destroy(&builder->layout.index);
+    (void)metagraph_memory_pool_destroy(builder->layout.scratch);
+    free(builder);
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_builder_check_open(const metagraph_bundle_builder_t *builder) {
+    if (builder->finished) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Bundle builder was already finished");
+    }
+    if (builder->status != METAGRAPH_SUCCESS) {
+        return METAGRAPH_ERR(builder->status,
+                             "Bundle builder failed to spill earlier data");
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_builder_reserve_nodes(metagraph_bundle_builder_t *builder,
+                                       size_t count) {
+    if (count <= builder->degree_capacity) {
+        return METAGRAPH_OK();
+    }
+    const size_t capacity =
+        builder->degree_capacity ? builder->degree_capacity * 2U : 1024U;
+    uint32_t *out_degree =
+        realloc(builder->out_degree, capacity * sizeof(*out_degree));
+    METAGRAPH_CHECK_ALLOC(out_degree);
+    builder->out_degree = out_degree;
+    uint32_t *in_degree =
+        realloc(builder->in_degree, capacity * sizeof(*in_degree));
+    METAGRAPH_CHECK_ALLOC(in_degree);
+    builder->in_degree = in_degree;
+    metagraph_bundle_path_key_t *path_keys = realloc(
+        builder->layout.path_keys, capacity * sizeof(*path_keys));
+    METAGRAPH_CHECK_ALLOC(path_keys);
+    builder->layout.path_keys = path_keys;
+    builder->degree_capacity = capacity;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_bundle_builder_add_node(metagraph_bundle_builder_t *builder,
+                                  const metagraph_node_metadata_t *metadata,
+                                  metagraph_node_index_t *out_index) {
+    METAGRAPH_CHECK_NULL(builder);
+    METAGRAPH_CHECK_NULL(metadata);
+    METAGRAPH_CHECK(metagraph_bundle_builder_check_open(builder));
+    if (metadata->data_size && !metadata->data) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NULL_POINTER,
+                             "Node payload of %zu bytes has no data",
+                             metadata->data_size);
+    }
+
+    metagraph_bundle_layout_t *layout = &builder->layout;
+    if (layout->node_count >= METAGRAPH_GRAPH_MAX_NODES) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_MAX_NODES_EXCEEDED,
+                             "Bundle already holds %zu nodes",
+                             layout->node_count);
+    }
+    METAGRAPH_CHECK(
+        metagraph_bundle_builder_reserve_nodes(builder, layout->node_count + 1U));
+    const metagraph_node_index_t node = (metagraph_node_index_t)layout->node_count;
+    bool inserted = false;
+    METAGRAPH_CHECK(
+        metagraph_id_index_insert(&layout->index, metadata->id, node, &inserted));
+    if (!inserted) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_EXISTS,
+                             "Node %016llx%016llx already exists",
+                             (unsigned long long)metadata->id.high,
+                             (unsigned long long)metadata->id.low);
+    }
+
+    metagraph_bundle_node_record_t record;
+    memset(&record, 0, sizeof(record));
+    metagraph_bundle_store_place(metadata, &layout->store_size,
+                                 &record.data_offset, &record.name_offset);
+    record.id = metadata->id;
+    record.hash = metadata->hash;
+    record.data_size = metadata->data_size;
+    record.name_length = metadata->name ? (uint32_t)strlen(metadata->name) : 0U;
+    record.type = metadata->type;
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_bundle_sink_t *store = &builder->spills[METAGRAPH_SPILL_STORE].sink;
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_pad_to(store, record.data_offset),
+                         failed);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_emit(store, metadata->data, metadata->data_size),
+        failed);
+    if (metadata->name) {
+        METAGRAPH_CHECK_GOTO(metagraph_bundle_emit(store, metadata->name,
+                                                   record.name_length + 1U),
+                             failed);
+    }
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_emit(&builder->spills[METAGRAPH_SPILL_NODES].sink,
+                              &record, sizeof(record)),
+        failed);
+
+    builder->out_degree[node] = 0;
+    builder->in_degree[node] = 0;
+    if (metadata->name) {
+        layout->path_keys[layout->path_key_count++] =
+            (metagraph_bundle_path_key_t){
+                .hash = metagraph_bundle_name_hash(metadata->name),
+                .node = node,
+            };
+    }
+    layout->node_count++;
+    if (out_index) {
+        *out_index = node;
+    }
+    return METAGRAPH_OK();
+
+failed:
+    builder->status = result;
+    return result;
+}
+
+static metagraph_result_t
+metagraph_bundle_builder_resolve_members(metagraph_bundle_builder_t *builder,
+                                         const metagraph_edge_metadata_t *metadata) {
+    if (metadata->node_count > builder->members_capacity) {
+        metagraph_node_index_t *members = realloc(
+            builder->members, metadata->node_count * sizeof(*members));
+        METAGRAPH_CHECK_ALLOC(members);
+        builder->members = members;
+        builder->members_capacity = metadata->node_count;
+    }
+    for (size_t i = 0; i < metadata->node_count; i++) {
+        if (!metagraph_id_index_find(&builder->layout.index, metadata->nodes[i],
+                                     &builder->members[i])) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                                 "Edge member %zu (%016llx%016llx) not found",
+                                 i, (unsigned long long)metadata->nodes[i].high,
+                                 (unsigned long long)metadata->nodes[i].low);
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_bundle_builder_add_edge(metagraph_bundle_builder_t *builder,
+                                  const metagraph_edge_metadata_t *metadata,
+                                  metagraph_edge_index_t *out_index) {
+    METAGRAPH_CHECK_NULL(builder);
+    METAGRAPH_CHECK_NULL(metadata);
+    METAGRAPH_CHECK(metagraph_bundle_builder_check_open(builder));
+
+    metagraph_bundle_layout_t *layout = &builder->layout;
+    if (metadata->node_count < 2U || !metadata->nodes) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Hyperedge needs at least 2 nodes, got %zu",
+                             metadata->node_count);
+    }
+    if (layout->edge_count >= METAGRAPH_GRAPH_MAX_EDGES) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_MAX_EDGES_EXCEEDED,
+                             "Bundle already holds %zu edges",
+                             layout->edge_count);
+    }
+    if (metadata->node_count > UINT32_MAX - layout->member_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Graph adjacency exceeds 32-bit bundle offsets");
+    }
+    uint32_t existing = 0;
+    if (metagraph_id_index_find(&builder->edge_index, metadata->id, &existing)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_EDGE_EXISTS,
+                             "Edge %016llx%016llx already exists",
+                             (unsigned long long)metadata->id.high,
+                             (unsigned long long)metadata->id.low);
+    }
+    METAGRAPH_CHECK(metagraph_bundle_builder_resolve_members(builder, metadata));
+
+    const metagraph_edge_index_t edge = (metagraph_edge_index_t)layout->edge_count;
+    bool inserted = false;
+    METAGRAPH_CHECK(metagraph_id_index_insert(&builder->edge_index, metadata->id,
+                                              edge, &inserted));
+    const metagraph_bundle_edge_record_t record = {
+        .id = metadata->id,
+        .type = metadata->type,
+        .weight = metadata->weight,
+        .member_begin = (uint32_t)layout->member_count,
+        .member_count = (uint32_t)metadata->node_count,
+    };
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_emit(&builder->spills[METAGRAPH_SPILL_EDGES].sink,
+                              &record, sizeof(record)),
+        failed);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_emit(&builder->spills[METAGRAPH_SPILL_MEMBERS].sink,
+                              builder->members,
+                              metadata->node_count * sizeof(*builder->members)),
+        failed);
+
+    builder->out_degree[builder->members[0]]++;
+    for (size_t i = 1; i < metadata->node_count; i++) {
+        builder->in_degree[builder->members[i]]++;
+    }
+    layout->out_count++;
+    layout->in_count += metadata->node_count - 1U;
+    layout->member_count += metadata->node_count;
+    layout->edge_count++;
+    if (out_index) {
+        *out_index = edge;
+    }
+    return METAGRAPH_OK();
+
+failed:
+    builder->status = result;
+    return result;
+}
+
+static uint8_t *
+metagraph_bundle_encode_section(const metagraph_bundle_encode_job_t *job,
+                               size_t section) {
+    return job->file + job->builder->layout.sections[section].offset;
+}
+
+// Fills the presized index in node order, as the one-shot writer does,
+// so the INDEX section does not depend on how the builder's own index
+// grew. The output starts zero-filled, so only occupied slots are written.
+static metagraph_result_t
+metagraph_bundle_encode_index(metagraph_bundle_encode_job_t *job) {
+    metagraph_bundle_layout_t *layout = &job->builder->layout;
+    metagraph_id_index_t *index = &layout->index;
+    const metagraph_bundle_node_record_t *records =
+        (const metagraph_bundle_node_record_t *)(const void *)
+            metagraph_bundle_encode_section(job, METAGRAPH_WRITE_NODES);
+    for (size_t i = 0; i < layout->node_count; i++) {
+        bool inserted = false;
+        METAGRAPH_CHECK(metagraph_id_index_insert(index, records[i].id,
+                                                  (uint32_t)i, &inserted));
+    }
+
+    uint8_t *dest = metagraph_bundle_encode_section(job, METAGRAPH_WRITE_INDEX);
+    memcpy(dest, &layout->index_header, sizeof(layout->index_header));
+    memcpy(dest + layout->index_header.ctrl_offset, index->ctrl,
+           index->capacity + METAGRAPH_ID_INDEX_GROUP);
+    metagraph_id_slot_t *slots =
+        (metagraph_id_slot_t *)(void *)(dest + layout->index_header.slots_offset);
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (index->ctrl[i] >= 0) {
+            slots[i] = index->slots[i];
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_encode_nodes(metagraph_bundle_encode_job_t *job) {
+    return metagraph_bundle_sink_read(
+        &job->builder->spills[METAGRAPH_SPILL_NODES].sink,
+        metagraph_bundle_encode_section(job, METAGRAPH_WRITE_NODES));
+}
+
+static metagraph_result_t
+metagraph_bundle_encode_edges(metagraph_bundle_encode_job_t *job) {
+    metagraph_bundle_builder_t *builder = job->builder;
+    const metagraph_bundle_edges_header_t *header =
+        &builder->layout.edges_header;
+    uint8_t *dest = metagraph_bundle_encode_section(job, METAGRAPH_WRITE_EDGES);
+    memcpy(dest, header, sizeof(*header));
+    METAGRAPH_CHECK(metagraph_bundle_sink_read(
+        &builder->spills[METAGRAPH_SPILL_EDGES].sink,
+        dest + header->records_offset));
+    return metagraph_bundle_sink_read(
+        &builder->spills[METAGRAPH_SPILL_MEMBERS].sink,
+        dest + header->members_offset);
+}
+
+static metagraph_result_t
+metagraph_bundle_encode_store(metagraph_bundle_encode_job_t *job) {
+    const metagraph_bundle_layout_t *layout = &job->builder->layout;
+    uint8_t *dest = metagraph_bundle_encode_section(job, METAGRAPH_WRITE_STORE);
+    const metagraph_bundle_compression_header_t *header = &layout->store_header;
+    if (header->codec == METAGRAPH_COMPRESSION_NONE) {
+        return metagraph_bundle_sink_read(
+            &job->builder->spills[METAGRAPH_SPILL_STORE].sink, dest);
+    }
+    memcpy(dest, header, sizeof(*header));
+    memcpy(dest + header->seek_offset, layout->store_seek,
+           ((size_t)header->block_count + 1U) * sizeof(uint64_t));
+    return metagraph_bundle_sink_read(layout->packed,
+                                      dest + layout->store_seek[0]);
+}
+
+static metagraph_result_t
+metagraph_bundle_encode_metadata(metagraph_bundle_encode_job_t *job) {
+    metagraph_bundle_metadata_t metadata;
+    metagraph_bundle_fill_metadata(&job->builder->options, &metadata);
+    memcpy(metagraph_bundle_encode_section(job, METAGRAPH_WRITE_METADATA),
+           &metadata, sizeof(metadata));
+    return METAGRAPH_OK();
+}
+
+// Rows are running degree totals; the degree counters then serve as fill
+// cursors. Edges are visited in index order, matching the order in which
+// a graph links its incidence lists.
+static metagraph_result_t
+metagraph_bundle_encode_csr(metagraph_bundle_encode_job_t *job, bool outgoing) {
+    metagraph_bundle_builder_t *builder = job->builder;
+    const metagraph_bundle_layout_t *layout = &builder->layout;
+    const metagraph_bundle_edges_header_t *header = &layout->edges_header;
+    uint8_t *section =
+        metagraph_bundle_encode_section(job, METAGRAPH_WRITE_EDGES);
+    const uint64_t rows_offset =
+        outgoing ? header->out_rows_offset : header->in_rows_offset;
+    const uint64_t edges_offset =
+        outgoing ? header->out_edges_offset : header->in_edges_offset;
+    uint32_t *rows = (uint32_t *)(void *)(section + rows_offset);
+    uint32_t *edges = (uint32_t *)(void *)(section + edges_offset);
+    uint32_t *cursor = outgoing ? builder->out_degree : builder->in_degree;
+
+    uint32_t row = 0;
+    rows[0] = 0;
+    for (size_t node = 0; node < layout->node_count; node++) {
+        const uint32_t degree = cursor[node];
+        cursor[node] = row;
+        row += degree;
+        rows[node + 1U] = row;
+    }
+
+    const uint8_t *records_start = section + header->records_offset;
+    const metagraph_bundle_edge_record_t *records =
+        (const metagraph_bundle_edge_record_t *)(const void *)records_start;
+    const uint32_t *members =
+        (const uint32_t *)(const void *)(section + header->members_offset);
+    for (size_t edge = 0; edge < layout->edge_count; edge++) {
+        const uint32_t *edge_members = members + records[edge].member_begin;
+        if (outgoing) {
+            edges[cursor[edge_members[0]]++] = (uint32_t)edge;
+            continue;
+        }
+        for (uint32_t i = 1; i < records[edge].member_count; i++) {
+            edges[cursor[edge_members[i]]++] = (uint32_t)edge;
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_bundle_encode_path_lookup(metagraph_bundle_encode_job_t *job) {
+    return metagraph_bundle_fill_path_lookup(
+        metagraph_bundle_encode_section(job, METAGRAPH_WRITE_LOOKUP),
+        &job->builder->layout);
+}
+
+static metagraph_result_t
+metagraph_bundle_encode_id_lookup(metagraph_bundle_encode_job_t *job) {
+    const metagraph_bundle_layout_t *layout = &job->builder->layout;
+    const metagraph_bundle_node_record_t *records =
+        (const metagraph_bundle_node_record_t *)(const void *)
+            metagraph_bundle_encode_section(job, METAGRAPH_WRITE_NODES);
+    metagraph_id_t *ids =
+        malloc((layout->node_count ? layout->node_count : 1U) * sizeof(*ids));
+    METAGRAPH_CHECK_ALLOC(ids);
+    for (size_t i = 0; i < layout->node_count; i++) {
+        ids[i] = records[i].id;
+    }
+    const metagraph_result_t result = metagraph_bundle_fill_id_lookup(
+        metagraph_bundle_encode_section(job, METAGRAPH_WRITE_LOOKUP), layout,
+        ids);
+    free(ids);
+    return result;
+}
+
+static metagraph_result_t
+metagraph_bundle_encode_out_csr(metagraph_bundle_encode_job_t *job) {
+    return metagraph_bundle_encode_csr(job, true);
+}
+
+static metagraph_result_t
+metagraph_bundle_encode_in_csr(metagraph_bundle_encode_job_t *job) {
+    return metagraph_bundle_encode_csr(job, false);
+}
+
+static const metagraph_bundle_encode_task_fn
+    metagraph_bundle_encode_tasks[METAGRAPH_BUILD_TASK_COUNT] = {
+        [METAGRAPH_BUILD_NODES] = metagraph_bundle_encode_nodes,
+        [METAGRAPH_BUILD_EDGES] = metagraph_bundle_encode_edges,
+        [METAGRAPH_BUILD_STORE] = metagraph_bundle_encode_store,
+        [METAGRAPH_BUILD_METADATA] = metagraph_bundle_encode_metadata,
+        [METAGRAPH_BUILD_PATH_LOOKUP] = metagraph_bundle_encode_path_lookup,
+        [METAGRAPH_BUILD_INDEX] = metagraph_bundle_encode_index,
+        [METAGRAPH_BUILD_ID_LOOKUP] = metagraph_bundle_encode_id_lookup,
+        [METAGRAPH_BUILD_OUT_CSR] = metagraph_bundle_encode_out_csr,
+        [METAGRAPH_BUILD_IN_CSR] = metagraph_bundle_encode_in_csr,
+};
+
+// Error contexts are thread-local, so workers keep a copy for the caller.
+static void metagraph_bundle_encode_range(void *context, uint32_t worker,
+                                         size_t begin, size_t end) {
+    (void)worker;
+    metagraph_bundle_encode_job_t *job = context;
+    for (size_t i = begin; i < end; i++) {
+        const size_t task = job->first_task + i;
+        const metagraph_result_t result = metagraph_bundle_encode_tasks[task](job);
+        if (metagraph_result_is_error(result)) {
+            (void)metagraph_get_error_context(&job->errors[task]);
+            job->errors[task].code = result;
+        }
+    }
+}
+
+static metagraph_result_t
+metagraph_bundle_encode_phase(metagraph_work_pool_t *pool,
+                             metagraph_bundle_encode_job_t *job, size_t first,
+                             size_t count) {
+    job->first_task = first;
+    metagraph_work_pool_for(pool, count, 1, metagraph_bundle_encode_range, job);
+    for (size_t task = first; task < first + count; task++) {
+        if (job->errors[task].code != METAGRAPH_SUCCESS) {
+            return METAGRAPH_ERR(job->errors[task].code, "%s",
+                                 job->errors[task].message);
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+// Encode every section into the mapped output, then hash it and fill in
+// the header and section table.
+static metagraph_result_t
+metagraph_bundle_encode_image(metagraph_bundle_builder_t *builder,
+                             uint8_t *file) {
+    metagraph_bundle_layout_t *layout = &builder->layout;
+    uint32_t threads =
+        builder->thread_count ? builder->thread_count : metagraph_cpu_count();
+    if (threads > METAGRAPH_BUILD_COPY_TASKS) {
+        threads = METAGRAPH_BUILD_COPY_TASKS;
+    }
+    metagraph_work_pool_t *pool = NULL;
+    METAGRAPH_CHECK(metagraph_work_pool_create(threads, &pool));
+    metagraph_bundle_encode_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.builder = builder;
+    job.file = file;
+    metagraph_result_t result = metagraph_bundle_encode_phase(
+        pool, &job, 0, METAGRAPH_BUILD_COPY_TASKS);
+    if (metagraph_result_is_success(result)) {
+        result = metagraph_bundle_encode_phase(
+            pool, &job, METAGRAPH_BUILD_COPY_TASKS,
+            METAGRAPH_BUILD_TASK_COUNT - METAGRAPH_BUILD_COPY_TASKS);
+    }
+    metagraph_work_pool_destroy(pool);
+    METAGRAPH_CHECK(result);
+
+    const metagraph_section_header_t *integrity_section =
+        &layout->sections[METAGRAPH_WRITE_INTEGRITY];
+    uint8_t *integrity = file + integrity_section->offset;
+    METAGRAPH_CHECK(metagraph_bundle_hash_image(
+        file, layout->sections, METAGRAPH_WRITE_HASHED_COUNT,
+        layout->chunk_log2, layout->scratch, integrity));
+
+    metagraph_bundle_header_t header;
+    metagraph_bundle_fill_header(layout, &builder->options, &header);
+    metagraph_blake3_hash_t integrity_hash;
+    METAGRAPH_CHECK(metagraph_bundle_integrity_digest(
+        &header, layout->sections, integrity, (size_t)integrity_section->size,
+        &integrity_hash));
+    memcpy(header.integrity_hash, integrity_hash.bytes,
+           sizeof(header.integrity_hash));
+    header.header_checksum = metagraph_bundle_header_checksum(&header);
+    memcpy(file, &header, sizeof(header));
+    memcpy(file + header.section_table_offset, layout->sections,
+           sizeof(layout->sections));
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_bundle_builder_finish(metagraph_bundle_builder_t *builder,
+                                const char *file_path) {
+    METAGRAPH_CHECK_NULL(builder);
+    METAGRAPH_CHECK_NULL(file_path);
+    METAGRAPH_CHECK(metagraph_bundle_builder_check_open(builder));
+    builder->finished = true;
+
+    // Swap the lookup index for an empty one sized like the one-shot
+    // writer's; metagraph_bundle_encode_index() refills it.
+    metagraph_bundle_layout_t *layout = &builder->layout;
+    metagraph_id_index_destroy(&layout->index);
+    METAGRAPH_CHECK(metagraph_id_index_init(&layout->index, layout->node_count));
+    metagraph_bundle_unique_paths(layout);
+    if (layout->store_header.codec != METAGRAPH_COMPRESSION_NONE) {
+        METAGRAPH_CHECK(metagraph_bundle_spill_open(
+            &builder->packed, builder->temp_directory, (uintptr_t)builder,
+            METAGRAPH_BUILD_MIN_SPILL_BUFFER));
+        layout->packed = &builder->packed.sink;
+        METAGRAPH_CHECK(metagraph_bundle_deflate_store(
+            layout, &builder->spills[METAGRAPH_SPILL_STORE].sink,
+            layout->packed, builder->thread_count));
+    }
+    METAGRAPH_CHECK(metagraph_bundle_plan_sections(layout));
+    const uint64_t file_size = metagraph_bundle_file_size(layout);
+
+    const size_t path_length = strlen(file_path);
+    void *storage = NULL;
+    METAGRAPH_CHECK(metagraph_memory_pool_aligned_alloc(
+        layout->scratch, path_length + sizeof(".tmp"), 1, &storage));
+    char *temp_path = storage;
+    memcpy(temp_path, file_path, path_length);
+    memcpy(temp_path + path_length, ".tmp", sizeof(".tmp"));
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_memory_map_t *map = NULL;
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_map_output(temp_path, file_size, &map), done);
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_encode_image(builder, map->base_address),
+                         done);
+    METAGRAPH_CHECK_GOTO(metagraph_mmap_sync(map, 0, (size_t)file_size), done);
+    const metagraph_result_t unmap_result = metagraph_mmap_destroy(map);
+    map = NULL;
+    METAGRAPH_CHECK_GOTO(unmap_result, done);
+    if (rename(temp_path, file_path) != 0) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                               "Cannot move bundle into place at %s (errno %d)",
+                               file_path, errno);
+    }
+
+done:
+    if (map) {
+        (void)metagraph_mmap_destroy(map);
+    }
+    if (result != METAGRAPH_SUCCESS) {
+        (void)remove(temp_path);
+    }
+    return result;
+}
+
+// ============================================================================
+// Delta bundles
+// ============================================================================
+
+// Section order in a delta file. Sections the delta inherits, and those
+// target lacks, are left out of the table.
+enum {
+    METAGRAPH_DELTA_WRITE_DELTA,
+    METAGRAPH_DELTA_WRITE_INDEX,
+    METAGRAPH_DELTA_WRITE_EDGES,
+    METAGRAPH_DELTA_WRITE_STORE,
+    METAGRAPH_DELTA_WRITE_METADATA,
+    METAGRAPH_DELTA_WRITE_LOOKUP,
+    METAGRAPH_DELTA_WRITE_INTEGRITY, // hashes everything before it
+    METAGRAPH_DELTA_WRITE_SECTION_COUNT
+};
+
+// Per target node: bytes the base lacks, and whether the record is patched
+#define METAGRAPH_DELTA_NEW_DATA 1U
+#define METAGRAPH_DELTA_NEW_NAME 2U
+#define METAGRAPH_DELTA_PATCHED 4U
+
+// Target nodes compared per work pool chunk
+#define METAGRAPH_DELTA_DIFF_GRAIN 256U
+
+typedef struct {
+    const metagraph_bundle_t *base;
+    const metagraph_bundle_t *target;
+    metagraph_bundle_node_record_t *records; ///< Target's, base offsets
+                                             ///< where the bytes are shared
+    uint8_t *marks;                          ///< METAGRAPH_DELTA_* per node
+    atomic_flag failed;
+    metagraph_error_context_t error; ///< First failure, for the caller
+} metagraph_bundle_diff_job_t;
+
+typedef struct {
+    uint32_t type;
+    uint64_t size;
+    uint64_t items;
+    uint32_t flags;
+    const void *source; ///< Bytes copied from target, or NULL
+} metagraph_bundle_delta_plan_t;
+
+// Point a target node's record at the base's copy of its payload and name
+// when the base node with the same ID holds the same bytes.
+static metagraph_result_t
+metagraph_bundle_diff_node(metagraph_bundle_diff_job_t *job,
+                           metagraph_node_index_t node) {
+    const metagraph_bundle_node_record_t *record = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_node_record(job->target, node, &record));
+    metagraph_bundle_node_record_t merged = *record;
+    uint8_t marks = METAGRAPH_DELTA_NEW_DATA;
+    if (record->name_offset != METAGRAPH_BUNDLE_NO_OFFSET) {
+        marks |= METAGRAPH_DELTA_NEW_NAME;
+    }
+
+    metagraph_node_index_t match = 0;
+    const metagraph_result_t found =
+        metagraph_bundle_find_node(job->base, record->id, &match);
+    if (found != METAGRAPH_ERROR_NODE_NOT_FOUND) {
+        METAGRAPH_CHECK(found);
+        const metagraph_bundle_node_record_t *base_record = NULL;
+        metagraph_node_metadata_t ours;
+        metagraph_node_metadata_t theirs;
+        METAGRAPH_CHECK(
+            metagraph_bundle_node_record(job->base, match, &base_record));
+        METAGRAPH_CHECK(metagraph_bundle_get_node(job->target, node, &ours));
+        METAGRAPH_CHECK(metagraph_bundle_get_node(job->base, match, &theirs));
+        if (ours.data_size == theirs.data_size &&
+            (ours.data_size == 0 ||
+             memcmp(ours.data, theirs.data, ours.data_size) == 0)) {
+            merged.data_offset = base_record->data_offset;
+            marks &= (uint8_t)~METAGRAPH_DELTA_NEW_DATA;
+        }
+        if (ours.name && theirs.name && strcmp(ours.name, theirs.name) == 0) {
+            merged.name_offset = base_record->name_offset;
+            marks &= (uint8_t)~METAGRAPH_DELTA_NEW_NAME;
+        }
+    }
+    job->records[node] = merged;
+    job->marks[node] = marks;
+    return METAGRAPH_OK();
+}
+
+static void metagraph_bundle_diff_range(void *context, uint32_t worker,
+                                        size_t begin, size_t end) {
+    (void)worker;
+    metagraph_bundle_diff_job_t *job = context;
+    for (size_t i = begin; i < end; i++) {
+        const metagraph_result_t result =
+            metagraph_bundle_diff_node(job, (metagraph_node_index_t)i);
+        // Error contexts are thread-local; keep the first for the caller.
+        if (metagraph_result_is_error(result) &&
+            !atomic_flag_test_and_set(&job->failed)) {
+            (void)metagraph_get_error_context(&job->error);
+            job->error.code = result;
+            return;
+        }
+    }
+}
+
+static metagraph_result_t
+metagraph_bundle_diff_nodes(metagraph_bundle_diff_job_t *job, size_t count) {
+    uint32_t threads = metagraph_cpu_count();
+    const size_t chunks =
+        (count + METAGRAPH_DELTA_DIFF_GRAIN - 1U) / METAGRAPH_DELTA_DIFF_GRAIN;
+    if (threads > chunks) {
+        threads = chunks ? (uint32_t)chunks : 1U;
+    }
+    metagraph_work_pool_t *pool = NULL;
+    METAGRAPH_CHECK(metagraph_work_pool_create(threads, &pool));
+    metagraph_work_pool_for(pool, count, METAGRAPH_DELTA_DIFF_GRAIN,
+                            metagraph_bundle_diff_range, job);
+    metagraph_work_pool_destroy(pool);
+    if (job->error.code != METAGRAPH_SUCCESS) {
+        return METAGRAPH_ERR(job->error.code, "%s", job->error.message);
+    }
+    return METAGRAPH_OK();
+}
+
+// Plan one of target's INDEX, EDGES or LOOKUP sections: inherited when
+// its bytes match the base's, copied when they do not, left out when
+// target has none.
+static metagraph_result_t
+metagraph_bundle_plan_delta_section(const metagraph_bundle_t *base,
+                                    const metagraph_bundle_t *target,
+                                    metagraph_section_type_t type,
+                                    uint64_t items,
+                                    metagraph_bundle_delta_plan_t *plan,
+                                    uint32_t *inherited) {
+    *plan = (metagraph_bundle_delta_plan_t){0};
+    if (!metagraph_bundle_has_section(target, type)) {
+        return METAGRAPH_OK();
+    }
+    const void *data = NULL;
+    size_t size = 0;
+    METAGRAPH_CHECK(metagraph_bundle_get_section(target, type, &data, &size));
+    if (metagraph_bundle_has_section(base, type)) {
+        const void *base_data = NULL;
+        size_t base_size = 0;
+        METAGRAPH_CHECK(
+            metagraph_bundle_get_section(base, type, &base_data, &base_size));
+        if (base_size == size && memcmp(base_data, data, size) == 0) {
+            *inherited |= 1U << type;
+            return METAGRAPH_OK();
+        }
+    }
+    *plan = (metagraph_bundle_delta_plan_t){
+        .type = type, .size = size, .items = items, .source = data};
+    return METAGRAPH_OK();
+}
+
+// Lay the delta's new bytes out through raw, in node order, then
+// compress them into layout->packed if a codec is selected.
+static metagraph_result_t
+metagraph_bundle_write_delta_store(metagraph_bundle_layout_t *layout,
+                                   const metagraph_bundle_t *target,
+                                   const metagraph_bundle_diff_job_t *job,
+                                   uint64_t base_store_size,
+                                   metagraph_bundle_sink_t *raw) {
+    for (size_t i = 0; i < layout->node_count; i++) {
+        const uint8_t marks = job->marks[i];
+        if (!(marks & (METAGRAPH_DELTA_NEW_DATA | METAGRAPH_DELTA_NEW_NAME))) {
+            continue;
+        }
+        const metagraph_bundle_node_record_t *record = &job->records[i];
+        metagraph_node_metadata_t node;
+        METAGRAPH_CHECK(metagraph_bundle_get_node(
+            target, (metagraph_node_index_t)i, &node));
+        if (marks & METAGRAPH_DELTA_NEW_DATA) {
+            METAGRAPH_CHECK(metagraph_bundle_pad_to(
+                raw, record->data_offset - base_store_size));
+            METAGRAPH_CHECK(
+                metagraph_bundle_emit(raw, node.data, node.data_size));
+        }
+        if (marks & METAGRAPH_DELTA_NEW_NAME) {
+            METAGRAPH_CHECK(metagraph_bundle_emit(
+                raw, node.name, (size_t)record->name_length + 1U));
+        }
+    }
+    METAGRAPH_CHECK(metagraph_bundle_pad_to(raw, layout->store_size));
+    if (layout->store_header.codec == METAGRAPH_COMPRESSION_NONE) {
+        return METAGRAPH_OK();
+    }
+    return metagraph_bundle_deflate_store(layout, raw, layout->packed, 0);
+}
+
+// Fill the mapped delta image: DELTA, copied sections, STORE, METADATA,
+// then INTEGRITY, the header and the section table.
+static metagraph_result_t metagraph_bundle_encode_delta(
+    uint8_t *file, metagraph_bundle_layout_t *layout,
+    const metagraph_bundle_delta_plan_t *plan, size_t section_count,
+    const metagraph_bundle_delta_header_t *delta,
+    const metagraph_bundle_diff_job_t *job, const metagraph_bundle_sink_t *raw,
+    const metagraph_bundle_write_options_t *options,
+    metagraph_bundle_header_t *header) {
+    metagraph_section_header_t *sections = layout->sections;
+    for (size_t i = 0; i < section_count; i++) {
+        uint8_t *dest = file + sections[i].offset;
+        switch (plan[i].type) {
+        case METAGRAPH_SECTION_DELTA: {
+            memcpy(dest, delta, sizeof(*delta));
+            uint32_t *patch_nodes =
+                (uint32_t *)(void *)(dest + delta->patch_nodes_offset);
+            metagraph_bundle_node_record_t *patch_records =
+                (metagraph_bundle_node_record_t *)(void *)(
+                    dest + delta->patch_records_offset);
+            size_t patch = 0;
+            for (size_t node = 0; node < layout->node_count; node++) {
+                if (job->marks[node] & METAGRAPH_DELTA_PATCHED) {
+                    patch_nodes[patch] = (uint32_t)node;
+                    patch_records[patch++] = job->records[node];
+                }
+            }
+            break;
+        }
+        case METAGRAPH_SECTION_STORE: {
+            const metagraph_bundle_compression_header_t *store =
+                &layout->store_header;
+            if (store->codec == METAGRAPH_COMPRESSION_NONE) {
+                METAGRAPH_CHECK(metagraph_bundle_sink_read(raw, dest));
+                break;
+            }
+            memcpy(dest, store, sizeof(*store));
+            memcpy(dest + store->seek_offset, layout->store_seek,
+                   ((size_t)store->block_count + 1U) * sizeof(uint64_t));
+            METAGRAPH_CHECK(metagraph_bundle_sink_read(
+                layout->packed, dest + layout->store_seek[0]));
+            break;
+        }
+        case METAGRAPH_SECTION_METADATA: {
+            metagraph_bundle_metadata_t metadata;
+            metagraph_bundle_fill_metadata(options, &metadata);
+            memcpy(dest, &metadata, sizeof(metadata));
+            break;
+        }
+        case METAGRAPH_SECTION_INTEGRITY:
+            METAGRAPH_CHECK(metagraph_bundle_hash_image(
+                file, sections, section_count - 1U, layout->chunk_log2,
+                layout->scratch, dest));
+            break;
+        default:
+            memcpy(dest, plan[i].source, (size_t)plan[i].size);
+            break;
+        }
+    }
+
+    const metagraph_section_header_t *integrity_section =
+        &sections[section_count - 1U];
+    metagraph_blake3_hash_t integrity_hash;
+    METAGRAPH_CHECK(metagraph_bundle_integrity_digest(
+        header, sections, file + integrity_section->offset,
+        (size_t)integrity_section->size, &integrity_hash));
+    memcpy(header->integrity_hash, integrity_hash.bytes,
+           sizeof(header->integrity_hash));
+    header->header_checksum = metagraph_bundle_header_checksum(header);
+    memcpy(file, header, sizeof(*header));
+    memcpy(file + header->section_table_offset, sections,
+           section_count * sizeof(*sections));
+    return METAGRAPH_OK();
+}
+
+// Place the planned sections, filling in the INTEGRITY entry, and fill
+// the header. Returns the file size.
+static uint64_t metagraph_bundle_place_delta(
+    metagraph_bundle_layout_t *layout, metagraph_bundle_delta_plan_t *plan,
+    size_t section_count, const metagraph_bundle_header_t *base_header,
+    const metagraph_bundle_write_options_t *options,
+    metagraph_bundle_header_t *out_header) {
+    const size_t hashed_count = section_count - 1U;
+    uint64_t integrity_size =
+        sizeof(metagraph_bundle_integrity_header_t) +
+        hashed_count * sizeof(metagraph_bundle_integrity_entry_t);
+    for (size_t i = 0; i < hashed_count; i++) {
+        integrity_size +=
+            metagraph_merkle_leaf_count((size_t)plan[i].size,
+                                        (size_t)1U << layout->chunk_log2) *
+            sizeof(metagraph_blake3_hash_t);
+    }
+    plan[hashed_count] = (metagraph_bundle_delta_plan_t){
+        .type = METAGRAPH_SECTION_INTEGRITY,
+        .size = integrity_size,
+        .items = hashed_count,
+    };
+
+    uint64_t offset = metagraph_bundle_align_up(
+        sizeof(metagraph_bundle_header_t) +
+            section_count * sizeof(metagraph_section_header_t),
+        METAGRAPH_BUNDLE_SECTION_ALIGN);
+    uint64_t end = offset;
+    for (size_t i = 0; i < section_count; i++) {
+        layout->sections[i] = (metagraph_section_header_t){
+            .type = plan[i].type,
+            .flags = plan[i].flags,
+            .offset = offset,
+            .size = plan[i].size,
+            .item_count = (uint32_t)plan[i].items,
+        };
+        end = offset + plan[i].size;
+        offset = metagraph_bundle_align_up(end, METAGRAPH_BUNDLE_SECTION_ALIGN);
+    }
+
+    metagraph_bundle_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, METAGRAPH_BUNDLE_MAGIC, METAGRAPH_BUNDLE_MAGIC_SIZE);
+    metagraph_bundle_format_uuid_bytes(header.format_uuid);
+    header.format_version = METAGRAPH_BUNDLE_FORMAT_VERSION;
+    header.api_version = metagraph_bundle_api_version();
+    header.total_size = end;
+    header.creation_time = options->creation_time;
+    header.bundle_id = options->bundle_id;
+    header.delta_base_id = (uint32_t)base_header->bundle_id;
+    header.section_count = (uint32_t)section_count;
+    header.section_table_offset = sizeof(header);
+    header.flags = METAGRAPH_BUNDLE_FLAG_DELTA;
+    if (layout->store_header.codec != METAGRAPH_COMPRESSION_NONE) {
+        header.flags |= METAGRAPH_BUNDLE_FLAG_COMPRESSED;
+    }
+    *out_header = header;
+    return end;
+}
+
+metagraph_result_t
+metagraph_bundle_write_delta(const metagraph_bundle_t *base,
+                             const metagraph_bundle_t *target,
+                             const char *file_path,
+                             const metagraph_bundle_write_options_t *options) {
+    METAGRAPH_CHECK_NULL(base);
+    METAGRAPH_CHECK_NULL(target);
+    METAGRAPH_CHECK_NULL(file_path);
+    const metagraph_bundle_header_t *base_header =
+        metagraph_bundle_get_header(base);
+    static const uint8_t zero_hash[sizeof(base_header->integrity_hash)] = {0};
+    if (memcmp(base_header->integrity_hash, zero_hash, sizeof(zero_hash)) ==
+        0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                             "Base bundle has no integrity hash to reference");
+    }
+
+    metagraph_bundle_layout_t layout;
+    memset(&layout, 0, sizeof(layout));
+    metagraph_bundle_write_options_t effective;
+    METAGRAPH_CHECK(
+        metagraph_bundle_resolve_options(options, &effective, &layout));
+    if (effective.reorder != METAGRAPH_REORDER_NONE) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                             "A delta keeps its target's node order");
+    }
+    metagraph_bundle_metadata_t target_metadata;
+    METAGRAPH_CHECK(metagraph_bundle_get_metadata(target, &target_metadata));
+    if (!effective.creator) {
+        effective.creator = target_metadata.creator;
+    }
+    if (!effective.description) {
+        effective.description = target_metadata.description;
+    }
+    if (effective.target_platform == 0) {
+        effective.target_platform = target_metadata.target_platform;
+    }
+
+    size_t base_count = 0;
+    uint64_t base_store_size = 0;
+    size_t edge_count = 0;
+    METAGRAPH_CHECK(metagraph_bundle_node_count(base, &base_count));
+    METAGRAPH_CHECK(metagraph_bundle_store_extent(base, &base_store_size));
+    METAGRAPH_CHECK(metagraph_bundle_node_count(target, &layout.node_count));
+    METAGRAPH_CHECK(metagraph_bundle_edge_count(target, &edge_count));
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_bundle_sink_t raw = {.file = NULL,
+                                   .path = "temporary STORE file"};
+    metagraph_bundle_sink_t packed = {.file = NULL,
+                                      .path = "temporary STORE file"};
+    metagraph_memory_map_t *map = NULL;
+    char *temp_path = NULL;
+    const metagraph_pool_config_t scratch_config = {
+        .type = METAGRAPH_POOL_TYPE_ARENA,
+        .initial_size = METAGRAPH_WRITE_SCRATCH_SIZE,
+        .allow_growth = true,
+    };
+    METAGRAPH_CHECK(
+        metagraph_memory_pool_create(&scratch_config, &layout.scratch));
+
+    const size_t count = layout.node_count;
+    metagraph_bundle_diff_job_t job = {
+        .base = base,
+        .target = target,
+        .failed = ATOMIC_FLAG_INIT,
+        .error = {.code = METAGRAPH_SUCCESS},
+    };
+    void *storage = NULL;
+    METAGRAPH_CHECK_GOTO(
+        metagraph_memory_pool_alloc(
+            layout.scratch, (count ? count : 1U) * sizeof(*job.records),
+            &storage),
+        cleanup);
+    job.records = storage;
+    METAGRAPH_CHECK_GOTO(
+        metagraph_memory_pool_alloc(layout.scratch, count ? count : 1U,
+                                    &storage),
+        cleanup);
+    job.marks = storage;
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_diff_nodes(&job, count), cleanup);
+
+    // New bytes go to the delta's STORE in node order, addressed past the
+    // base's; a record is patched when it differs from the base's at the
+    // same index.
+    size_t patch_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        metagraph_bundle_node_record_t *record = &job.records[i];
+        if (job.marks[i] & METAGRAPH_DELTA_NEW_DATA) {
+            const uint64_t data_offset = metagraph_bundle_align_up(
+                layout.store_size, METAGRAPH_BUNDLE_DATA_ALIGN);
+            record->data_offset = base_store_size + data_offset;
+            layout.store_size = data_offset + record->data_size;
+        }
+        if (job.marks[i] & METAGRAPH_DELTA_NEW_NAME) {
+            record->name_offset = base_store_size + layout.store_size;
+            layout.store_size += (uint64_t)record->name_length + 1U;
+        }
+        const metagraph_bundle_node_record_t *base_record = NULL;
+        if (i < base_count) {
+            METAGRAPH_CHECK_GOTO(
+                metagraph_bundle_node_record(
+                    base, (metagraph_node_index_t)i, &base_record),
+                cleanup);
+        }
+        if (!base_record ||
+            memcmp(record, base_record, sizeof(*record)) != 0) {
+            job.marks[i] |= METAGRAPH_DELTA_PATCHED;
+            patch_count++;
+        }
+    }
+
+    raw.file = tmpfile();
+    if (effective.compression != METAGRAPH_COMPRESSION_NONE) {
+        packed.file = tmpfile();
+        layout.packed = &packed;
+    }
+    if (!raw.file || (layout.packed && !packed.file)) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                               "Cannot create a temporary STORE file "
+                               "(errno %d)",
+                               errno);
+        goto cleanup;
+    }
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_write_delta_store(
+                             &layout, target, &job, base_store_size, &raw),
+                         cleanup);
+
+    metagraph_bundle_delta_header_t delta = {
+        .base_total_size = base_header->total_size,
+        .base_store_size = base_store_size,
+        .base_node_count = base_count,
+        .node_count = count,
+        .patch_count = patch_count,
+        .patch_nodes_offset = sizeof(metagraph_bundle_delta_header_t),
+        .patch_records_offset = metagraph_bundle_align_up(
+            sizeof(metagraph_bundle_delta_header_t) + patch_count * 4U, 8U),
+    };
+    memcpy(delta.base_format_uuid, base_header->format_uuid,
+           sizeof(delta.base_format_uuid));
+    memcpy(delta.base_integrity_hash, base_header->integrity_hash,
+           sizeof(delta.base_integrity_hash));
+
+    metagraph_bundle_delta_plan_t plan[METAGRAPH_DELTA_WRITE_SECTION_COUNT];
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_plan_delta_section(
+            base, target, METAGRAPH_SECTION_INDEX, count,
+            &plan[METAGRAPH_DELTA_WRITE_INDEX], &delta.inherited_sections),
+        cleanup);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_plan_delta_section(
+            base, target, METAGRAPH_SECTION_EDGES, edge_count,
+            &plan[METAGRAPH_DELTA_WRITE_EDGES], &delta.inherited_sections),
+        cleanup);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_plan_delta_section(
+            base, target, METAGRAPH_SECTION_LOOKUP, count,
+            &plan[METAGRAPH_DELTA_WRITE_LOOKUP], &delta.inherited_sections),
+        cleanup);
+    plan[METAGRAPH_DELTA_WRITE_DELTA] = (metagraph_bundle_delta_plan_t){
+        .type = METAGRAPH_SECTION_DELTA,
+        .size = delta.patch_records_offset +
+                patch_count * sizeof(metagraph_bundle_node_record_t),
+        .items = patch_count,
+    };
+    const bool compressed =
+        layout.store_header.codec != METAGRAPH_COMPRESSION_NONE;
+    plan[METAGRAPH_DELTA_WRITE_STORE] = (metagraph_bundle_delta_plan_t){
+        .type = METAGRAPH_SECTION_STORE,
+        .size = compressed ? layout.store_seek[layout.store_header.block_count]
+                           : layout.store_size,
+        .items = count,
+        .flags = compressed ? (uint32_t)METAGRAPH_SECTION_FLAG_COMPRESSED : 0U,
+    };
+    plan[METAGRAPH_DELTA_WRITE_METADATA] = (metagraph_bundle_delta_plan_t){
+        .type = METAGRAPH_SECTION_METADATA,
+        .size = sizeof(metagraph_bundle_metadata_t),
+        .items = 1U,
+    };
+    size_t section_count = 0;
+    for (size_t i = 0; i < METAGRAPH_DELTA_WRITE_INTEGRITY; i++) {
+        if (plan[i].type != 0) {
+            plan[section_count++] = plan[i];
+        }
+    }
+    section_count++; // INTEGRITY
+    metagraph_bundle_header_t header;
+    const uint64_t file_size = metagraph_bundle_place_delta(
+        &layout, plan, section_count, base_header, &effective, &header);
+
+    const size_t path_length = strlen(file_path);
+    METAGRAPH_CHECK_GOTO(metagraph_memory_pool_aligned_alloc(
+                             layout.scratch, path_length + sizeof(".tmp"), 1,
+                             &storage),
+                         cleanup);
+    temp_path = storage;
+    memcpy(temp_path, file_path, path_length);
+    memcpy(temp_path + path_length, ".tmp", sizeof(".tmp"));
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_map_output(temp_path, file_size, &map), done);
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_encode_delta(
+                             map->base_address, &layout, plan, section_count,
+                             &delta, &job, &raw, &effective, &header),
+                         done);
+    METAGRAPH_CHECK_GOTO(metagraph_mmap_sync(map, 0, (size_t)file_size), done);
+    const metagraph_result_t unmap_result = metagraph_mmap_destroy(map);
+    map = NULL;
+    METAGRAPH_CHECK_GOTO(unmap_result, done);
+    if (rename(temp_path, file_path) != 0) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                               "Cannot move bundle into place at %s (errno %d)",
+                               file_path, errno);
+    }
+
+done:
+    if (map) {
+        (void)metagraph_mmap_destroy(map);
+    }
+    if (result != METAGRAPH_SUCCESS) {
+        (void)remove(temp_path);
+    }
+cleanup:
+    if (raw.file) {
+        (void)fclose(raw.file);
+    }
+    if (packed.file) {
+        (void)fclose(packed.file);
+    }
+    (void)metagraph_memory_pool_destroy(layout.scratch);
+    return result;
+}
@@ -0,0 +1,573 @@
+/**
+ * @file concurrent.c
+ * @brief Lock-free readable ID table and concurrent node store
+ *
+ * A table is a snapshot (capacity, control bytes, slots) published through
+ * one atomic pointer. Control bytes are 0 (empty), 1 (tombstone) or the top
+ * seven hash bits with the high bit set (live); readers probe linearly from
+ * the hash's home slot until they hit an empty byte. The writer fills a
+ * slot's key and value before the control byte, so a reader that sees a
+ * live byte sees the whole entry, and it never rewrites a slot once it has
+ * been live: tombstones are only dropped when the table is rebuilt into a
+ * fresh snapshot.
+ *
+ * Snapshot control-byte and pointer accesses are sequentially consistent
+ * so they order correctly against the epoch announcements in epoch.c. On
+ * x86 and AArch64 those loads compile to the same instructions as acquire
+ * loads.
+ */
+
+#include "metagraph/concurrent.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include "epoch.h"
+#include "id_index.h"
+#include "platform.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METAGRAPH_CTABLE_DEFAULT_CAPACITY 64U
+#define METAGRAPH_CTABLE_MIN_SLOTS 16U
+#define METAGRAPH_CTABLE_EMPTY 0U
+#define METAGRAPH_CTABLE_DELETED 1U
+#define METAGRAPH_CTABLE_LIVE 0x80U
+
+typedef struct {
+    metagraph_id_t key;
+    void *value;
+} metagraph_ctable_slot_t;
+
+typedef struct {
+    metagraph_epoch_node_t retire; ///< Must stay first: released with free()
+    size_t capacity;               ///< Power of two
+    size_t used;                   ///< Live slots plus tombstones (writer)
+    metagraph_ctable_slot_t *slots;
+    _Atomic(uint8_t) *ctrl;
+} metagraph_ctable_snapshot_t;
+
+struct metagraph_concurrent_hashtable {
+    _Atomic(metagraph_ctable_snapshot_t *) current;
+    _Atomic(size_t) count;
+    metagraph_epoch_domain_t *domain;
+    metagraph_mutex_t write_lock;
+};
+
+typedef struct {
+    metagraph_epoch_node_t retire; ///< Must stay first: released with free()
+    metagraph_node_metadata_t metadata;
+    char name[];
+} metagraph_cnode_t;
+
+struct metagraph_concurrent_graph {
+    metagraph_concurrent_hashtable_t nodes; ///< ID -> metagraph_cnode_t
+    size_t max_nodes;
+    _Atomic(uint64_t) version;
+};
+
+static uint8_t metagraph_ctable_tag(uint64_t hash) {
+    return (uint8_t)(METAGRAPH_CTABLE_LIVE | (uint8_t)(hash >> 57U));
+}
+
+// Slots to allocate so `entries` live entries fill at most half of them.
+static size_t metagraph_ctable_capacity_for(size_t entries) {
+    size_t capacity = METAGRAPH_CTABLE_MIN_SLOTS;
+    while (capacity / 2U < entries) {
+        if (capacity > SIZE_MAX / 4U) {
+            return 0;
+        }
+        capacity *= 2U;
+    }
+    return capacity;
+}
+
+// Rebuild threshold: live slots plus tombstones may use 7/8 of the table,
+// which keeps at least one empty slot to terminate every probe.
+static size_t metagraph_ctable_max_used(size_t capacity) {
+    return capacity - capacity / 8U;
+}
+
+static void metagraph_ctable_release(metagraph_epoch_node_t *node) {
+    free(node);
+}
+
+static metagraph_ctable_snapshot_t *metagraph_ctable_snapshot_new(size_t capacity) {
+    const size_t header = sizeof(metagraph_ctable_snapshot_t);
+    const size_t slots_bytes = capacity * sizeof(metagraph_ctable_slot_t);
+    if (capacity > (SIZE_MAX - header) / (sizeof(metagraph_ctable_slot_t) + 1U)) {
+        return NULL;
+    }
+    // One block: header, slots, then control bytes (zero = all empty).
+    metagraph_ctable_snapshot_t *snapshot =
+        calloc(1, header + slots_bytes + capacity);
+    if (!snapshot) {
+        return NULL;
+    }
+    unsigned char *base = (unsigned char *)(void *)snapshot;
+    snapshot->capacity = capacity;
+    snapshot->slots = (metagraph_ctable_slot_t *)(void *)(base + header);
+    snapshot->ctrl = (_Atomic(uint8_t) *)(void *)(base + header + slots_bytes);
+    return snapshot;
+}
+
+// Slot holding key, or capacity if absent.
+static size_t metagraph_ctable_find(const metagraph_ctable_snapshot_t *snapshot,
+                                    metagraph_id_t key) {
+    const uint64_t hash = metagraph_id_hash(key);
+    const uint8_t tag = metagraph_ctable_tag(hash);
+    const size_t mask = snapshot->capacity - 1U;
+    size_t pos = (size_t)hash & mask;
+    for (size_t probe = 0; probe < snapshot->capacity; probe++) {
+        const uint8_t ctrl =
+            atomic_load_explicit(&snapshot->ctrl[pos], memory_order_seq_cst);
+        if (ctrl == METAGRAPH_CTABLE_EMPTY) {
+            break;
+        }
+        if (ctrl == tag && metagraph_id_equal(snapshot->slots[pos].key, key)) {
+            return pos;
+        }
+        pos = (pos + 1U) & mask;
+    }
+    return snapshot->capacity;
+}
+
+// Writer only: place an entry known to be absent into an empty slot.
+static void metagraph_ctable_place(metagraph_ctable_snapshot_t *snapshot,
+                                   metagraph_id_t key, void *value) {
+    const uint64_t hash = metagraph_id_hash(key);
+    const size_t mask = snapshot->capacity - 1U;
+    size_t pos = (size_t)hash & mask;
+    while (atomic_load_explicit(&snapshot->ctrl[pos], memory_order_relaxed) !=
+           METAGRAPH_CTABLE_EMPTY) {
+        pos = (pos + 1U) & mask;
+    }
+    snapshot->slots[pos].key = key;
+    snapshot->slots[pos].value = value;
+    snapshot->used++;
+    atomic_store_explicit(&snapshot->ctrl[pos], metagraph_ctable_tag(hash),
+                          memory_order_seq_cst);
+}
+
+static metagraph_result_t
+metagraph_ctable_init(metagraph_concurrent_hashtable_t *table,
+                      size_t initial_capacity) {
+    const size_t capacity = metagraph_ctable_capacity_for(
+        initial_capacity ? initial_capacity : METAGRAPH_CTABLE_DEFAULT_CAPACITY);
+    if (capacity == 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Initial capacity %zu is too large",
+                             initial_capacity);
+    }
+    metagraph_ctable_snapshot_t *snapshot = metagraph_ctable_snapshot_new(capacity);
+    if (!snapshot) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate a %zu-slot table", capacity);
+    }
+    table->domain = malloc(sizeof(*table->domain));
+    if (!table->domain) {
+        free(snapshot);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate reclamation domain");
+    }
+    metagraph_result_t result = metagraph_epoch_domain_init(table->domain);
+    if (metagraph_result_is_error(result)) {
+        free(table->domain);
+        free(snapshot);
+        return result;
+    }
+    if (metagraph_mutex_init(&table->write_lock) != 0) {
+        metagraph_epoch_domain_destroy(table->domain);
+        free(table->domain);
+        free(snapshot);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_RESOURCE_EXHAUSTED,
+                             "Failed to initialize table writer lock");
+    }
+    atomic_init(&table->current, snapshot);
+    atomic_init(&table->count, 0);
+    return METAGRAPH_OK();
+}
+
+static void metagraph_ctable_fini(metagraph_concurrent_hashtable_t *table) {
+    metagraph_epoch_domain_destroy(table->domain);
+    free(table->domain);
+    free(atomic_load_explicit(&table->current, memory_order_relaxed));
+    metagraph_mutex_destroy(&table->write_lock);
+}
+
+// Writer only: build a snapshot sized for `entries` live entries, copy the
+// live slots into it, publish it and retire the old one.
+static metagraph_result_t
+metagraph_ctable_rebuild(metagraph_concurrent_hashtable_t *table,
+                         size_t entries) {
+    metagraph_ctable_snapshot_t *old =
+        atomic_load_explicit(&table->current, memory_order_relaxed);
+    const size_t capacity = metagraph_ctable_capacity_for(entries);
+    metagraph_ctable_snapshot_t *fresh =
+        capacity ? metagraph_ctable_snapshot_new(capacity) : NULL;
+    if (!fresh) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to grow table for %zu entries", entries);
+    }
+    for (size_t i = 0; i < old->capacity; i++) {
+        if (atomic_load_explicit(&old->ctrl[i], memory_order_relaxed) & METAGRAPH_CTABLE_LIVE) {
+            metagraph_ctable_place(fresh, old->slots[i].key,
+                                   old->slots[i].value);
+        }
+    }
+    atomic_store_explicit(&table->current, fresh, memory_order_seq_cst);
+    metagraph_epoch_retire(table->domain, &old->retire,
+                           metagraph_ctable_release);
+    return METAGRAPH_OK();
+}
+
+// Writer only.
+static metagraph_result_t
+metagraph_ctable_insert_locked(metagraph_concurrent_hashtable_t *table,
+                               metagraph_id_t key, void *value) {
+    metagraph_ctable_snapshot_t *snapshot =
+        atomic_load_explicit(&table->current, memory_order_relaxed);
+    if (metagraph_ctable_find(snapshot, key) != snapshot->capacity) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_EXISTS,
+                             "Key %016llx%016llx already present",
+                             (unsigned long long)key.high,
+                             (unsigned long long)key.low);
+    }
+    const size_t count = atomic_load_explicit(&table->count, memory_order_relaxed);
+    if (snapshot->used + 1U > metagraph_ctable_max_used(snapshot->capacity)) {
+        METAGRAPH_CHECK(metagraph_ctable_rebuild(table, count + 1U));
+        snapshot = atomic_load_explicit(&table->current, memory_order_relaxed);
+    }
+    metagraph_ctable_place(snapshot, key, value);
+    atomic_store_explicit(&table->count, count + 1U, memory_order_relaxed);
+    return METAGRAPH_OK();
+}
+
+// Writer only. Returns the removed value through out_value.
+static metagraph_result_t
+metagraph_ctable_remove_locked(metagraph_concurrent_hashtable_t *table,
+                               metagraph_id_t key, void **out_value) {
+    metagraph_ctable_snapshot_t *snapshot =
+        atomic_load_explicit(&table->current, memory_order_relaxed);
+    const size_t pos = metagraph_ctable_find(snapshot, key);
+    if (pos == snapshot->capacity) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Key %016llx%016llx not found",
+                             (unsigned long long)key.high,
+                             (unsigned long long)key.low);
+    }
+    *out_value = snapshot->slots[pos].value;
+    atomic_store_explicit(&snapshot->ctrl[pos], METAGRAPH_CTABLE_DELETED,
+                          memory_order_seq_cst);
+    atomic_fetch_sub_explicit(&table->count, 1, memory_order_relaxed);
+    return METAGRAPH_OK();
+}
+
+// Reader side: caller is inside the table's epoch.
+static bool
+metagraph_ctable_lookup_pinned(const metagraph_concurrent_hashtable_t *table,
+                               metagraph_id_t key, void **out_value) {
+    const metagraph_ctable_snapshot_t *snapshot =
+        atomic_load_explicit(&table->current, memory_order_seq_cst);
+    const size_t pos = metagraph_ctable_find(snapshot, key);
+    if (pos == snapshot->capacity) {
+        return false;
+    }
+    *out_value = snapshot->slots[pos].value;
+    return true;
+}
+
+// ============================================================================
+// Concurrent hash table
+// ============================================================================
+
+metagraph_result_t
+metagraph_concurrent_hashtable_create(size_t initial_capacity,
+                                      metagraph_concurrent_hashtable_t **out_table) {
+    METAGRAPH_CHECK_NULL(out_table);
+    *out_table = NULL;
+    metagraph_concurrent_hashtable_t *table = calloc(1, sizeof(*table));
+    METAGRAPH_CHECK_ALLOC(table);
+    metagraph_result_t result = metagraph_ctable_init(table, initial_capacity);
+    if (metagraph_result_is_error(result)) {
+        free(table);
+        return result;
+    }
+    *out_table = table;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_concurrent_hashtable_destroy(metagraph_concurrent_hashtable_t *table) {
+    if (!table) {
+        return METAGRAPH_OK();
+    }
+    metagraph_ctable_fini(table);
+    free(table);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_concurrent_hashtable_insert(metagraph_concurrent_hashtable_t *table,
+                                      metagraph_id_t key, void *value) {
+    METAGRAPH_CHECK_NULL(table);
+    metagraph_mutex_lock(&table->write_lock);
+    const metagraph_result_t result =
+        metagraph_ctable_insert_locked(table, key, value);
+    metagraph_mutex_unlock(&table->write_lock);
+    return result;
+}
+
+metagraph_result_t
+metagraph_concurrent_hashtable_lookup(const metagraph_concurrent_hashtable_t *table,
+                                      metagraph_id_t key, void **out_value) {
+    METAGRAPH_CHECK_NULL(table);
+    METAGRAPH_CHECK_NULL(out_value);
+    metagraph_epoch_record_t *record = metagraph_epoch_enter(table->domain);
+    METAGRAPH_CHECK_ALLOC(record);
+    const bool found = metagraph_ctable_lookup_pinned(table, key, out_value);
+    metagraph_epoch_exit(record);
+    if (!found) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Key %016llx%016llx not found",
+                             (unsigned long long)key.high,
+                             (unsigned long long)key.low);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_concurrent_hashtable_remove(metagraph_concurrent_hashtable_t *table,
+                                      metagraph_id_t key) {
+    METAGRAPH_CHECK_NULL(table);
+    void *value = NULL;
+    metagraph_mutex_lock(&table->write_lock);
+    const metagraph_result_t result =
+        metagraph_ctable_remove_locked(table, key, &value);
+    metagraph_mutex_unlock(&table->write_lock);
+    return result;
+}
+
+size_t
+metagraph_concurrent_hashtable_count(const metagraph_concurrent_hashtable_t *table) {
+    return table ? atomic_load_explicit(&table->count, memory_order_relaxed) : 0;
+}
+
+// ============================================================================
+// Concurrent node store
+// ============================================================================
+
+static void metagraph_cnode_release(metagraph_epoch_node_t *node) {
+    free(node);
+}
+
+metagraph_result_t
+metagraph_concurrent_graph_create(const metagraph_graph_config_t *config,
+                                  metagraph_concurrent_graph_t **out_graph) {
+    METAGRAPH_CHECK_NULL(out_graph);
+    *out_graph = NULL;
+    size_t initial = 0;
+    size_t max_nodes = METAGRAPH_GRAPH_MAX_NODES;
+    if (config) {
+        initial = config->initial_node_capacity;
+        if (config->max_nodes) {
+            if (config->max_nodes > METAGRAPH_GRAPH_MAX_NODES) {
+                return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                                     "max_nodes %zu exceeds %zu",
+                                     config->max_nodes,
+                                     (size_t)METAGRAPH_GRAPH_MAX_NODES);
+            }
+            max_nodes = config->max_nodes;
+        }
+    }
+    metagraph_concurrent_graph_t *graph = calloc(1, sizeof(*graph));
+    METAGRAPH_CHECK_ALLOC(graph);
+    metagraph_result_t result = metagraph_ctable_init(&graph->nodes, initial);
+    if (metagraph_result_is_error(result)) {
+        free(graph);
+        return result;
+    }
+    graph->max_nodes = max_nodes;
+    atomic_init(&graph->version, 0);
+    *out_graph = graph;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_concurrent_graph_destroy(metagraph_concurrent_graph_t *graph) {
+    if (!graph) {
+        return METAGRAPH_OK();
+    }
+    metagraph_ctable_snapshot_t *snapshot =
+        atomic_load_explicit(&graph->nodes.current, memory_order_relaxed);
+    for (size_t i = 0; i < snapshot->capacity; i++) {
+        if (atomic_load_explicit(&snapshot->ctrl[i], memory_order_relaxed) &
+            METAGRAPH_CTABLE_LIVE) {
+            free(snapshot->slots[i].value);
+        }
+    }
+    metagraph_ctable_fini(&graph->nodes);
+    free(graph);
+    return METAGRAPH_OK();
+}
+
+// Writer side: mark a mutation in progress (odd version) or published.
+static void metagraph_cgraph_bump(metagraph_concurrent_graph_t *graph) {
+    atomic_fetch_add_explicit(&graph->version, 1, memory_order_seq_cst);
+}
+
+metagraph_result_t
+metagraph_concurrent_graph_add_node(metagraph_concurrent_graph_t *graph,
+                                    const metagraph_node_metadata_t *metadata) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(metadata);
+    const size_t name_size = metadata->name ? strlen(metadata->name) + 1U : 0;
+    metagraph_cnode_t *node = malloc(sizeof(*node) + name_size);
+    METAGRAPH_CHECK_ALLOC(node);
+    node->metadata = *metadata;
+    if (metadata->name) {
+        memcpy(node->name, metadata->name, name_size);
+        node->metadata.name = node->name;
+    }
+
+    metagraph_mutex_lock(&graph->nodes.write_lock);
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    if (atomic_load_explicit(&graph->nodes.count, memory_order_relaxed) >=
+        graph->max_nodes) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_MAX_NODES_EXCEEDED,
+                               "Node limit %zu reached", graph->max_nodes);
+    } else {
+        metagraph_cgraph_bump(graph);
+        result =
+            metagraph_ctable_insert_locked(&graph->nodes, metadata->id, node);
+        metagraph_cgraph_bump(graph);
+    }
+    metagraph_mutex_unlock(&graph->nodes.write_lock);
+    if (metagraph_result_is_error(result)) {
+        free(node);
+    }
+    return result;
+}
+
+metagraph_result_t
+metagraph_concurrent_graph_remove_node(metagraph_concurrent_graph_t *graph,
+                                       metagraph_id_t node_id) {
+    METAGRAPH_CHECK_NULL(graph);
+    void *value = NULL;
+    metagraph_mutex_lock(&graph->nodes.write_lock);
+    metagraph_cgraph_bump(graph);
+    const metagraph_result_t result =
+        metagraph_ctable_remove_locked(&graph->nodes, node_id, &value);
+    metagraph_cgraph_bump(graph);
+    if (metagraph_result_is_success(result)) {
+        metagraph_cnode_t *node = value;
+        metagraph_epoch_retire(graph->nodes.domain, &node->retire,
+                               metagraph_cnode_release);
+    }
+    metagraph_mutex_unlock(&graph->nodes.write_lock);
+    return result;
+}
+
+metagraph_result_t
+metagraph_concurrent_graph_read_begin(const metagraph_concurrent_graph_t *graph) {
+    METAGRAPH_CHECK_NULL(graph);
+    const metagraph_epoch_record_t *record =
+        metagraph_epoch_enter(graph->nodes.domain);
+    METAGRAPH_CHECK_ALLOC(record);
+    return METAGRAPH_OK();
+}
+
+void metagraph_concurrent_graph_read_end(const metagraph_concurrent_graph_t *graph) {
+    if (!graph) {
+        return;
+    }
+    metagraph_epoch_record_t *record = metagraph_epoch_current(graph->nodes.domain);
+    if (record) {
+        metagraph_epoch_exit(record);
+    }
+}
+
+metagraph_result_t
+metagraph_concurrent_graph_find_node(const metagraph_concurrent_graph_t *graph,
+                                     metagraph_id_t node_id,
+                                     metagraph_node_metadata_t *out_metadata) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_metadata);
+    metagraph_epoch_record_t *record = metagraph_epoch_enter(graph->nodes.domain);
+    METAGRAPH_CHECK_ALLOC(record);
+    void *value = NULL;
+    const bool found =
+        metagraph_ctable_lookup_pinned(&graph->nodes, node_id, &value);
+    if (found) {
+        const metagraph_cnode_t *node = value;
+        *out_metadata = node->metadata;
+    }
+    metagraph_epoch_exit(record);
+    if (!found) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node %016llx%016llx not found",
+                             (unsigned long long)node_id.high,
+                             (unsigned long long)node_id.low);
+    }
+    return METAGRAPH_OK();
+}
+
+size_t
+metagraph_concurrent_graph_node_count(const metagraph_concurrent_graph_t *graph) {
+    return graph ? metagraph_concurrent_hashtable_count(&graph->nodes) : 0;
+}
+
+metagraph_result_t
+metagraph_concurrent_graph_enumerate_nodes(const metagraph_concurrent_graph_t *graph,
+                                           metagraph_id_t *node_ids,
+                                           size_t capacity, size_t *out_count) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_count);
+    metagraph_epoch_record_t *record = metagraph_epoch_enter(graph->nodes.domain);
+    METAGRAPH_CHECK_ALLOC(record);
+    const metagraph_ctable_snapshot_t *snapshot =
+        atomic_load_explicit(&graph->nodes.current, memory_order_seq_cst);
+    size_t count = 0;
+    for (size_t i = 0; i < snapshot->capacity; i++) {
+        if (!(atomic_load_explicit(&snapshot->ctrl[i], memory_order_seq_cst) &
+              METAGRAPH_CTABLE_LIVE)) {
+            continue;
+        }
+        if (node_ids && count < capacity) {
+            node_ids[count] = snapshot->slots[i].key;
+        }
+        count++;
+    }
+    metagraph_epoch_exit(record);
+    *out_count = count;
+    if (node_ids && count > capacity) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUFFER_TOO_SMALL,
+                             "Need room for %zu node IDs, have %zu", count,
+                             capacity);
+    }
+    return METAGRAPH_OK();
+}
+
+uint64_t
+metagraph_concurrent_graph_version(const metagraph_concurrent_graph_t *graph) {
+    return graph ? atomic_load_explicit(&graph->version, memory_order_seq_cst)
+                 : 0;
+}
+
+metagraph_result_t
+metagraph_concurrent_graph_validate(const metagraph_concurrent_graph_t *graph,
+                                    uint64_t version) {
+    METAGRAPH_CHECK_NULL(graph);
+    const uint64_t current =
+        atomic_load_explicit(&graph->version, memory_order_seq_cst);
+    if ((version & 1U) || current != version) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_CONCURRENT_MODIFICATION,
+                             "Graph changed during read (version %llu -> %llu)",
+                             (unsigned long long)version,
+                             (unsigned long long)current);
+    }
+    return METAGRAPH_OK();
+}
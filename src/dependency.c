@@ -0,0 +1,747 @@
+/**
+ * @file dependency.c
+ * @brief Incremental dependency ordering (Pearce-Kelly)
+ *
+ * The context keeps order (slot -> node) and position (node -> slot) with
+ * every dependency in an earlier slot than its dependents. Adding "a
+ * depends on d" while position[d] > position[a] only disturbs the slots in
+ * [position[a], position[d]]: a forward search from a over dependents and
+ * a backward search from d over dependencies, both confined to that range,
+ * find every node that has to move. Those nodes are re-placed into the
+ * slots they already occupied, the backward set first, each set keeping
+ * its relative order. The forward search reaching d means the new
+ * dependency closes a cycle.
+ *
+ * Searches share one mark array stamped with a generation counter, so
+ * nothing proportional to the graph is cleared per update.
+ */
+
+#include "metagraph/dependency.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+#include "metagraph/scheduler.h"
+#include "metagraph/traversal.h"
+
+#include "graph_internal.h"
+#include "id_index.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METAGRAPH_DEPENDENCY_MESSAGE_SIZE 192U
+
+typedef struct {
+    metagraph_node_index_t *items;
+    uint32_t count;
+    uint32_t capacity;
+} metagraph_dependency_list_t;
+
+struct metagraph_dependency_context {
+    const metagraph_graph_t *graph;
+    size_t node_count;
+
+    metagraph_dependency_list_t *dependencies; ///< Per node: what it needs
+    metagraph_dependency_list_t *dependents;   ///< Per node: who needs it
+    // Initial lists are slices of one block; a list that outgrows its
+    // slice moves to its own allocation.
+    metagraph_node_index_t *initial_items;
+    size_t initial_size;
+
+    uint32_t *position;
+    metagraph_node_index_t *order;
+
+    // Search scratch
+    uint32_t *mark;
+    uint32_t generation;
+    metagraph_node_index_t *parent;
+    metagraph_dependency_list_t stack;
+    metagraph_dependency_list_t forward;
+    metagraph_dependency_list_t backward;
+    metagraph_dependency_list_t slots;
+
+    metagraph_dependency_list_t changed; ///< Updated since the last resolve
+};
+
+// ============================================================================
+// Node lists
+// ============================================================================
+
+static bool
+metagraph_dependency_list_borrowed(const metagraph_dependency_context_t *context,
+                                   const metagraph_dependency_list_t *list) {
+    const uintptr_t items = (uintptr_t)list->items;
+    const uintptr_t block = (uintptr_t)context->initial_items;
+    return context->initial_items && items >= block &&
+           items < block + context->initial_size * sizeof(*list->items);
+}
+
+static void
+metagraph_dependency_list_free(const metagraph_dependency_context_t *context,
+                               metagraph_dependency_list_t *list) {
+    if (!metagraph_dependency_list_borrowed(context, list)) {
+        free(list->items);
+    }
+    *list = (metagraph_dependency_list_t){0};
+}
+
+static metagraph_result_t
+metagraph_dependency_list_push(const metagraph_dependency_context_t *context,
+                               metagraph_dependency_list_t *list,
+                               metagraph_node_index_t node) {
+    if (list->count == list->capacity) {
+        const uint32_t capacity = list->capacity ? list->capacity * 2U : 4U;
+        metagraph_node_index_t *items = NULL;
+        if (metagraph_dependency_list_borrowed(context, list)) {
+            items = malloc(capacity * sizeof(*items));
+            if (items) {
+                memcpy(items, list->items, list->count * sizeof(*items));
+            }
+        } else {
+            items = realloc(list->items, capacity * sizeof(*items));
+        }
+        if (!items) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                 "Failed to grow dependency list to %u entries",
+                                 capacity);
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = node;
+    return METAGRAPH_OK();
+}
+
+// Remove one occurrence of node; order within the list is not kept.
+static void metagraph_dependency_list_remove(metagraph_dependency_list_t *list,
+                                             metagraph_node_index_t node) {
+    for (uint32_t i = 0; i < list->count; i++) {
+        if (list->items[i] == node) {
+            list->items[i] = list->items[--list->count];
+            return;
+        }
+    }
+}
+
+static int metagraph_dependency_compare(const void *lhs, const void *rhs) {
+    const uint32_t a = *(const uint32_t *)lhs;
+    const uint32_t b = *(const uint32_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+// Sort a list of nodes by their position in the order.
+static void
+metagraph_dependency_sort(const metagraph_dependency_context_t *context,
+                          metagraph_dependency_list_t *list) {
+    for (uint32_t i = 0; i < list->count; i++) {
+        list->items[i] = context->position[list->items[i]];
+    }
+    qsort(list->items, list->count, sizeof(*list->items),
+          metagraph_dependency_compare);
+    for (uint32_t i = 0; i < list->count; i++) {
+        list->items[i] = context->order[list->items[i]];
+    }
+}
+
+static uint32_t
+metagraph_dependency_next_generation(metagraph_dependency_context_t *context) {
+    if (++context->generation == 0) {
+        memset(context->mark, 0, context->node_count * sizeof(*context->mark));
+        context->generation = 1;
+    }
+    return context->generation;
+}
+
+// ============================================================================
+// Creation
+// ============================================================================
+
+static metagraph_result_t
+metagraph_dependency_build(metagraph_dependency_context_t *context) {
+    const metagraph_graph_t *graph = context->graph;
+    const size_t node_count = context->node_count;
+
+    // Size every list first so the initial lists can share one block.
+    size_t total = 0;
+    for (size_t node = 0; node < node_count; node++) {
+        for (uint32_t record = graph->node_out_head[node];
+             record != METAGRAPH_INVALID_INDEX;
+             record = graph->incidence_next[record]) {
+            const uint32_t targets =
+                graph->edge_member_count[graph->incidence_edge[record]] - 1U;
+            context->dependencies[node].capacity += targets;
+            total += targets;
+        }
+        for (uint32_t record = graph->node_in_head[node];
+             record != METAGRAPH_INVALID_INDEX;
+             record = graph->incidence_next[record]) {
+            context->dependents[node].capacity++;
+        }
+    }
+    if (total == 0) {
+        return METAGRAPH_OK();
+    }
+    context->initial_size = 2U * total;
+    context->initial_items =
+        malloc(context->initial_size * sizeof(*context->initial_items));
+    METAGRAPH_CHECK_ALLOC(context->initial_items);
+
+    metagraph_node_index_t *cursor = context->initial_items;
+    for (size_t node = 0; node < node_count; node++) {
+        metagraph_dependency_list_t *lists[] = {&context->dependencies[node],
+                                                &context->dependents[node]};
+        for (size_t i = 0; i < 2; i++) {
+            // Empty lists own nothing, so they never point into the block.
+            lists[i]->items = lists[i]->capacity ? cursor : NULL;
+            cursor += lists[i]->capacity;
+        }
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        for (uint32_t record = graph->node_out_head[node];
+             record != METAGRAPH_INVALID_INDEX;
+             record = graph->incidence_next[record]) {
+            const metagraph_edge_index_t edge = graph->incidence_edge[record];
+            const metagraph_node_index_t *members =
+                graph->members + graph->edge_member_begin[edge];
+            for (uint32_t m = 1; m < graph->edge_member_count[edge]; m++) {
+                metagraph_dependency_list_t *dependents =
+                    &context->dependents[members[m]];
+                context->dependencies[node]
+                    .items[context->dependencies[node].count++] = members[m];
+                dependents->items[dependents->count++] =
+                    (metagraph_node_index_t)node;
+            }
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_dependency_context_create(const metagraph_dependency_config_t *config,
+                                    metagraph_dependency_context_t **out_context) {
+    METAGRAPH_CHECK_NULL(config);
+    METAGRAPH_CHECK_NULL(config->graph);
+    METAGRAPH_CHECK_NULL(out_context);
+    *out_context = NULL;
+
+    metagraph_topological_result_t topological;
+    metagraph_result_t result = metagraph_compute_topological_order(
+        config->graph, &config->parallel, &topological);
+    if (metagraph_result_is_error(result)) {
+        (void)metagraph_topological_result_destroy(&topological);
+        return result;
+    }
+
+    metagraph_dependency_context_t *context = calloc(1, sizeof(*context));
+    if (!context) {
+        (void)metagraph_topological_result_destroy(&topological);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate dependency context");
+    }
+    const size_t node_count = config->graph->node_count;
+    context->graph = config->graph;
+    context->node_count = node_count;
+    context->order = topological.nodes;
+    context->dependencies = calloc(node_count, sizeof(*context->dependencies));
+    context->dependents = calloc(node_count, sizeof(*context->dependents));
+    context->position = malloc(node_count * sizeof(*context->position));
+    context->mark = calloc(node_count, sizeof(*context->mark));
+    context->parent = malloc(node_count * sizeof(*context->parent));
+    if (node_count > 0 &&
+        (!context->dependencies || !context->dependents ||
+         !context->position || !context->mark || !context->parent)) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Failed to allocate dependency state for %zu "
+                               "nodes",
+                               node_count);
+        goto fail;
+    }
+    METAGRAPH_CHECK_GOTO(metagraph_dependency_build(context), fail);
+    for (size_t slot = 0; slot < node_count; slot++) {
+        context->position[context->order[slot]] = (uint32_t)slot;
+    }
+    free(topological.cycle_nodes);
+    *out_context = context;
+    return METAGRAPH_OK();
+
+fail:
+    free(topological.cycle_nodes);
+    (void)metagraph_dependency_context_destroy(context);
+    return result;
+}
+
+metagraph_result_t
+metagraph_dependency_context_destroy(metagraph_dependency_context_t *context) {
+    if (!context) {
+        return METAGRAPH_OK();
+    }
+    for (size_t node = 0; context->dependencies && node < context->node_count;
+         node++) {
+        metagraph_dependency_list_free(context, &context->dependencies[node]);
+    }
+    for (size_t node = 0; context->dependents && node < context->node_count;
+         node++) {
+        metagraph_dependency_list_free(context, &context->dependents[node]);
+    }
+    metagraph_dependency_list_free(context, &context->stack);
+    metagraph_dependency_list_free(context, &context->forward);
+    metagraph_dependency_list_free(context, &context->backward);
+    metagraph_dependency_list_free(context, &context->slots);
+    metagraph_dependency_list_free(context, &context->changed);
+    free(context->dependencies);
+    free(context->dependents);
+    free(context->initial_items);
+    free(context->position);
+    free(context->order);
+    free(context->mark);
+    free(context->parent);
+    free(context);
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Reordering
+// ============================================================================
+
+static metagraph_result_t
+metagraph_dependency_report_cycle(const metagraph_dependency_context_t *context,
+                                  metagraph_node_index_t asset,
+                                  metagraph_node_index_t dependency,
+                                  metagraph_node_index_t reached_from) {
+    // asset -> dependency -> reached_from -> ... -> asset, following the
+    // forward search tree back up to asset.
+    metagraph_dependency_list_t cycle = {0};
+    metagraph_result_t result =
+        metagraph_dependency_list_push(context, &cycle, asset);
+    if (dependency != asset) {
+        if (metagraph_result_is_success(result)) {
+            result = metagraph_dependency_list_push(context, &cycle, dependency);
+        }
+        for (metagraph_node_index_t node = reached_from;
+             node != asset && metagraph_result_is_success(result);
+             node = context->parent[node]) {
+            result = metagraph_dependency_list_push(context, &cycle, node);
+        }
+    }
+    if (metagraph_result_is_success(result)) {
+        char message[METAGRAPH_DEPENDENCY_MESSAGE_SIZE];
+        metagraph_graph_format_cycle(context->graph, cycle.items, cycle.count,
+                                     message, sizeof(message));
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_DEPENDENCY_CYCLE,
+                               "Dependency cycle: %s", message);
+    }
+    free(cycle.items);
+    return result;
+}
+
+// Search from `start` through `links`, staying strictly inside
+// (lower, upper) by position, and collect the nodes reached into `out`.
+// With a target, reaching it stops the search and reports the node it was
+// reached from through out_reached_from.
+static metagraph_result_t metagraph_dependency_search(
+    metagraph_dependency_context_t *context,
+    const metagraph_dependency_list_t *links, metagraph_node_index_t start,
+    uint32_t lower, uint32_t upper, metagraph_node_index_t target,
+    metagraph_dependency_list_t *out,
+    metagraph_node_index_t *out_reached_from) {
+    const uint32_t generation = context->generation;
+    context->stack.count = 0;
+    context->mark[start] = generation;
+    METAGRAPH_CHECK(metagraph_dependency_list_push(context, &context->stack,
+                                                   start));
+    while (context->stack.count > 0) {
+        const metagraph_node_index_t node =
+            context->stack.items[--context->stack.count];
+        METAGRAPH_CHECK(metagraph_dependency_list_push(context, out, node));
+        const metagraph_dependency_list_t *next = &links[node];
+        for (uint32_t i = 0; i < next->count; i++) {
+            const metagraph_node_index_t candidate = next->items[i];
+            if (candidate == target) {
+                *out_reached_from = node;
+                return METAGRAPH_ERROR_DEPENDENCY_CYCLE;
+            }
+            const uint32_t position = context->position[candidate];
+            if (context->mark[candidate] == generation || position <= lower ||
+                position >= upper) {
+                continue;
+            }
+            context->mark[candidate] = generation;
+            context->parent[candidate] = node;
+            METAGRAPH_CHECK(metagraph_dependency_list_push(
+                context, &context->stack, candidate));
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+// Restore the order invariant after `asset` gained `dependency`.
+static metagraph_result_t
+metagraph_dependency_order_edge(metagraph_dependency_context_t *context,
+                                metagraph_node_index_t asset,
+                                metagraph_node_index_t dependency) {
+    if (asset == dependency) {
+        return metagraph_dependency_report_cycle(context, asset, asset, asset);
+    }
+    const uint32_t lower = context->position[asset];
+    const uint32_t upper = context->position[dependency];
+    if (upper < lower) {
+        return METAGRAPH_OK();
+    }
+
+    (void)metagraph_dependency_next_generation(context);
+    context->forward.count = 0;
+    context->backward.count = 0;
+    metagraph_node_index_t reached_from = METAGRAPH_INVALID_INDEX;
+    // The range bounds are exclusive; the searches start at the bounds.
+    metagraph_result_t result = metagraph_dependency_search(
+        context, context->dependents, asset, lower, upper, dependency,
+        &context->forward, &reached_from);
+    if (result == METAGRAPH_ERROR_DEPENDENCY_CYCLE) {
+        return metagraph_dependency_report_cycle(context, asset, dependency,
+                                                 reached_from);
+    }
+    METAGRAPH_CHECK(result);
+    METAGRAPH_CHECK(metagraph_dependency_search(
+        context, context->dependencies, dependency, lower, upper,
+        METAGRAPH_INVALID_INDEX, &context->backward, &reached_from));
+
+    metagraph_dependency_sort(context, &context->forward);
+    metagraph_dependency_sort(context, &context->backward);
+
+    // Slots freed by both sets, in ascending order.
+    metagraph_dependency_list_t *forward = &context->forward;
+    metagraph_dependency_list_t *backward = &context->backward;
+    context->slots.count = 0;
+    uint32_t f = 0;
+    uint32_t b = 0;
+    while (f < forward->count || b < backward->count) {
+        const bool take_backward =
+            f == forward->count ||
+            (b < backward->count && context->position[backward->items[b]] <
+                                        context->position[forward->items[f]]);
+        const metagraph_node_index_t node =
+            take_backward ? backward->items[b++] : forward->items[f++];
+        METAGRAPH_CHECK(metagraph_dependency_list_push(
+            context, &context->slots, context->position[node]));
+    }
+
+    // Dependencies of `dependency` take the lower slots, then the nodes
+    // that depend on `asset`.
+    uint32_t slot = 0;
+    for (uint32_t i = 0; i < backward->count; i++, slot++) {
+        const metagraph_node_index_t node = backward->items[i];
+        context->order[context->slots.items[slot]] = node;
+        context->position[node] = context->slots.items[slot];
+    }
+    for (uint32_t i = 0; i < forward->count; i++, slot++) {
+        const metagraph_node_index_t node = forward->items[i];
+        context->order[context->slots.items[slot]] = node;
+        context->position[node] = context->slots.items[slot];
+    }
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Updates
+// ============================================================================
+
+static metagraph_result_t
+metagraph_dependency_lookup(const metagraph_dependency_context_t *context,
+                            metagraph_id_t id, metagraph_node_index_t *out_node) {
+    METAGRAPH_CHECK(metagraph_graph_find_node(context->graph, id, out_node));
+    if (*out_node >= context->node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node %u was added after the dependency context",
+                             *out_node);
+    }
+    return METAGRAPH_OK();
+}
+
+// Drop every entry of `dependencies` from asset's dependency list and the
+// matching back-links.
+static void
+metagraph_dependency_unlink(metagraph_dependency_context_t *context,
+                            metagraph_node_index_t asset,
+                            const metagraph_dependency_list_t *dependencies) {
+    for (uint32_t i = 0; i < dependencies->count; i++) {
+        metagraph_dependency_list_remove(
+            &context->dependents[dependencies->items[i]], asset);
+    }
+}
+
+metagraph_result_t
+metagraph_dependency_update_asset(metagraph_dependency_context_t *context,
+                                  metagraph_id_t asset_id,
+                                  const metagraph_id_t *new_dependencies,
+                                  size_t dependency_count) {
+    METAGRAPH_CHECK_NULL(context);
+    if (dependency_count > 0) {
+        METAGRAPH_CHECK_NULL(new_dependencies);
+    }
+    if (dependency_count > UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Too many dependencies: %zu", dependency_count);
+    }
+    metagraph_node_index_t asset = 0;
+    METAGRAPH_CHECK(metagraph_dependency_lookup(context, asset_id, &asset));
+
+    metagraph_dependency_list_t replacement = {
+        .items = malloc((dependency_count ? dependency_count : 1U) *
+                        sizeof(metagraph_node_index_t)),
+        .capacity = (uint32_t)dependency_count,
+    };
+    METAGRAPH_CHECK_ALLOC(replacement.items);
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    for (size_t i = 0; i < dependency_count; i++) {
+        METAGRAPH_CHECK_GOTO(
+            metagraph_dependency_lookup(context, new_dependencies[i],
+                                        &replacement.items[i]),
+            discard);
+    }
+    METAGRAPH_CHECK_GOTO(
+        metagraph_dependency_list_push(context, &context->changed, asset),
+        discard);
+
+    // Removing dependencies never breaks the order; adding them one at a
+    // time keeps the order valid before each reordering step.
+    metagraph_dependency_list_t previous = context->dependencies[asset];
+    metagraph_dependency_unlink(context, asset, &previous);
+    context->dependencies[asset] = replacement;
+    context->dependencies[asset].count = 0;
+    for (uint32_t i = 0; i < (uint32_t)dependency_count; i++) {
+        const metagraph_node_index_t dependency = replacement.items[i];
+        METAGRAPH_CHECK_GOTO(
+            metagraph_dependency_list_push(
+                context, &context->dependents[dependency], asset),
+            rollback);
+        context->dependencies[asset].count++;
+        METAGRAPH_CHECK_GOTO(
+            metagraph_dependency_order_edge(context, asset, dependency),
+            rollback);
+    }
+    metagraph_dependency_list_free(context, &previous);
+    return METAGRAPH_OK();
+
+rollback:
+    // The order stays valid with fewer constraints; only the links need
+    // restoring. Removal never shrinks a list, so re-adding cannot fail.
+    metagraph_dependency_unlink(context, asset, &context->dependencies[asset]);
+    free(context->dependencies[asset].items);
+    context->dependencies[asset] = previous;
+    for (uint32_t i = 0; i < previous.count; i++) {
+        (void)metagraph_dependency_list_push(
+            context, &context->dependents[previous.items[i]], asset);
+    }
+    context->changed.count--;
+    return result;
+
+discard:
+    free(replacement.items);
+    return result;
+}
+
+// ============================================================================
+// Resolution
+// ============================================================================
+
+metagraph_result_t metagraph_dependency_resolve_incremental(
+    metagraph_dependency_context_t *context,
+    const metagraph_id_t *changed_assets, size_t changed_count,
+    metagraph_resolution_result_t *out_result) {
+    METAGRAPH_CHECK_NULL(context);
+    METAGRAPH_CHECK_NULL(out_result);
+    if (changed_count > 0) {
+        METAGRAPH_CHECK_NULL(changed_assets);
+    }
+    memset(out_result, 0, sizeof(*out_result));
+
+    const uint32_t generation = metagraph_dependency_next_generation(context);
+    metagraph_dependency_list_t *affected = &context->forward;
+    metagraph_dependency_list_t *stack = &context->stack;
+    affected->count = 0;
+    stack->count = 0;
+    for (size_t i = 0; i < changed_count + context->changed.count; i++) {
+        metagraph_node_index_t node = 0;
+        if (i < changed_count) {
+            METAGRAPH_CHECK(
+                metagraph_dependency_lookup(context, changed_assets[i], &node));
+        } else {
+            node = context->changed.items[i - changed_count];
+        }
+        if (context->mark[node] != generation) {
+            context->mark[node] = generation;
+            METAGRAPH_CHECK(metagraph_dependency_list_push(context, stack, node));
+        }
+    }
+    while (stack->count > 0) {
+        const metagraph_node_index_t node = stack->items[--stack->count];
+        METAGRAPH_CHECK(metagraph_dependency_list_push(context, affected, node));
+        const metagraph_dependency_list_t *dependents =
+            &context->dependents[node];
+        for (uint32_t i = 0; i < dependents->count; i++) {
+            const metagraph_node_index_t dependent = dependents->items[i];
+            if (context->mark[dependent] != generation) {
+                context->mark[dependent] = generation;
+                METAGRAPH_CHECK(
+                    metagraph_dependency_list_push(context, stack, dependent));
+            }
+        }
+    }
+    metagraph_dependency_sort(context, affected);
+
+    const size_t count = affected->count;
+    out_result->nodes = malloc((count ? count : 1U) * sizeof(*out_result->nodes));
+    out_result->load_order =
+        malloc((count ? count : 1U) * sizeof(*out_result->load_order));
+    if (!out_result->nodes || !out_result->load_order) {
+        (void)metagraph_resolution_result_destroy(out_result);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate load order of %zu assets",
+                             count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        out_result->nodes[i] = affected->items[i];
+        out_result->load_order[i] = context->graph->node_ids[affected->items[i]];
+    }
+    out_result->load_order_count = count;
+    context->changed.count = 0;
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Scheduled loading
+// ============================================================================
+
+typedef struct {
+    metagraph_asset_load_fn load;
+    void *user_data;
+    const metagraph_resolution_result_t *assets;
+} metagraph_dependency_load_job_t;
+
+typedef struct {
+    const metagraph_dependency_load_job_t *job;
+    size_t index;
+} metagraph_dependency_load_task_t;
+
+static metagraph_result_t metagraph_dependency_load_one(void *context) {
+    const metagraph_dependency_load_task_t *task = context;
+    const metagraph_dependency_load_job_t *job = task->job;
+    return job->load(job->user_data, job->assets->nodes[task->index],
+                     job->assets->load_order[task->index]);
+}
+
+// One task per asset, linked to the tasks of its in-set dependencies.
+// Task IDs equal asset positions; lookups go through an index over the
+// set's IDs so the cost follows the set, not the graph.
+static metagraph_result_t metagraph_dependency_load_graph(
+    const metagraph_dependency_context_t *context,
+    const metagraph_resolution_result_t *assets,
+    metagraph_dependency_load_task_t *tasks, metagraph_task_graph_t *graph) {
+    const size_t count = assets->load_order_count;
+    metagraph_id_index_t index;
+    METAGRAPH_CHECK(metagraph_id_index_init(&index, count));
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    for (size_t i = 0; i < count; i++) {
+        if (assets->nodes[i] >= context->node_count) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                                   "Asset %zu has node index %u of %zu", i,
+                                   assets->nodes[i], context->node_count);
+            goto done;
+        }
+        bool inserted = false;
+        METAGRAPH_CHECK_GOTO(
+            metagraph_id_index_insert(&index, assets->load_order[i],
+                                      (uint32_t)i, &inserted),
+            done);
+        if (!inserted) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                                   "Asset %zu is listed twice", i);
+            goto done;
+        }
+        METAGRAPH_CHECK_GOTO(
+            metagraph_task_graph_add_task(graph, metagraph_dependency_load_one,
+                                          &tasks[i], NULL),
+            done);
+    }
+    for (size_t i = 0; i < count; i++) {
+        const metagraph_dependency_list_t *dependencies =
+            &context->dependencies[assets->nodes[i]];
+        for (uint32_t d = 0; d < dependencies->count; d++) {
+            uint32_t prerequisite = 0;
+            if (metagraph_id_index_find(
+                    &index, context->graph->node_ids[dependencies->items[d]],
+                    &prerequisite)) {
+                METAGRAPH_CHECK_GOTO(metagraph_task_graph_add_dependency(
+                                         graph, (metagraph_task_id_t)i,
+                                         prerequisite),
+                                     done);
+            }
+        }
+    }
+done:
+    metagraph_id_index_destroy(&index);
+    return result;
+}
+
+metagraph_result_t
+metagraph_dependency_load(const metagraph_dependency_context_t *context,
+                          const metagraph_resolution_result_t *assets,
+                          metagraph_asset_load_fn load, void *user_data,
+                          metagraph_scheduler_t *scheduler,
+                          metagraph_task_graph_stats_t *out_stats) {
+    METAGRAPH_CHECK_NULL(context);
+    METAGRAPH_CHECK_NULL(assets);
+    METAGRAPH_CHECK_NULL(load);
+    if (out_stats) {
+        memset(out_stats, 0, sizeof(*out_stats));
+    }
+    const size_t count = assets->load_order_count;
+    if (count == 0) {
+        return METAGRAPH_OK();
+    }
+    const metagraph_dependency_load_job_t job = {
+        .load = load,
+        .user_data = user_data,
+        .assets = assets,
+    };
+    metagraph_dependency_load_task_t *tasks = malloc(count * sizeof(*tasks));
+    METAGRAPH_CHECK_ALLOC(tasks);
+    for (size_t i = 0; i < count; i++) {
+        tasks[i] = (metagraph_dependency_load_task_t){.job = &job, .index = i};
+    }
+    metagraph_task_graph_t *graph = NULL;
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(metagraph_task_graph_create(&graph), done);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_dependency_load_graph(context, assets, tasks, graph), done);
+    METAGRAPH_CHECK_GOTO(metagraph_task_graph_run(graph, scheduler, out_stats),
+                         done);
+done:
+    (void)metagraph_task_graph_destroy(graph);
+    free(tasks);
+    return result;
+}
+
+metagraph_result_t
+metagraph_dependency_get_order(const metagraph_dependency_context_t *context,
+                               const metagraph_node_index_t **out_order,
+                               size_t *out_count) {
+    METAGRAPH_CHECK_NULL(context);
+    METAGRAPH_CHECK_NULL(out_order);
+    METAGRAPH_CHECK_NULL(out_count);
+    *out_order = context->order;
+    *out_count = context->node_count;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_resolution_result_destroy(metagraph_resolution_result_t *result) {
+    if (!result) {
+        return METAGRAPH_OK();
+    }
+    free(result->load_order);
+    free(result->nodes);
+    memset(result, 0, sizeof(*result));
+    return METAGRAPH_OK();
+}
@@ -0,0 +1,211 @@
+/**
+ * @file epoch.c
+ * @brief Epoch-based reclamation for lock-free readers
+ *
+ * Every retirement advances the global epoch, so retire stamps are unique
+ * and the retire list is ordered by stamp: reclamation frees a prefix of
+ * it. Readers find their per-domain record through a small thread-local
+ * binding cache keyed by domain ID, falling back to the domain's record
+ * list; a thread registers a record the first time it reads a domain.
+ *
+ * Ordering: a reader publishes its epoch and then loads shared pointers; a
+ * writer unlinks an object, advances the epoch and then loads the reader
+ * announcements. All four are sequentially consistent, so either the
+ * writer sees the announcement or the reader sees the unlink.
+ */
+
+#include "epoch.h"
+
+#include "metagraph/result.h"
+
+#include "platform.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define METAGRAPH_EPOCH_BINDING_SLOTS 8U
+#define METAGRAPH_EPOCH_RECLAIM_INTERVAL 32U
+
+typedef struct {
+    uint64_t domain_id;
+    metagraph_epoch_record_t *record;
+} metagraph_epoch_binding_t;
+
+// Domain IDs are never reused, so a binding left behind by a destroyed
+// domain can never match a live one.
+static _Atomic(uint64_t) metagraph_epoch_next_domain_id = 1;
+static METAGRAPH_THREAD_LOCAL metagraph_epoch_binding_t
+    metagraph_epoch_bindings[METAGRAPH_EPOCH_BINDING_SLOTS];
+static METAGRAPH_THREAD_LOCAL uint32_t metagraph_epoch_next_binding;
+static METAGRAPH_THREAD_LOCAL char metagraph_epoch_token;
+
+metagraph_result_t metagraph_epoch_domain_init(metagraph_epoch_domain_t *domain) {
+    METAGRAPH_CHECK_NULL(domain);
+    if (metagraph_mutex_init(&domain->registry_lock) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_RESOURCE_EXHAUSTED,
+                             "Failed to initialize epoch registry lock");
+    }
+    domain->id = atomic_fetch_add_explicit(&metagraph_epoch_next_domain_id, 1,
+                                           memory_order_relaxed);
+    // Epoch 0 means "quiescent" in a record, so counting starts at 1.
+    atomic_init(&domain->epoch, 1);
+    atomic_init(&domain->records, NULL);
+    domain->retired_head = NULL;
+    domain->retired_tail = NULL;
+    domain->retired_count = 0;
+    domain->retired_since_reclaim = 0;
+    return METAGRAPH_OK();
+}
+
+void metagraph_epoch_domain_destroy(metagraph_epoch_domain_t *domain) {
+    if (!domain) {
+        return;
+    }
+    metagraph_epoch_node_t *node = domain->retired_head;
+    while (node) {
+        metagraph_epoch_node_t *next = node->next;
+        node->release(node);
+        node = next;
+    }
+    domain->retired_head = NULL;
+    domain->retired_tail = NULL;
+    domain->retired_count = 0;
+
+    metagraph_epoch_record_t *record =
+        atomic_load_explicit(&domain->records, memory_order_acquire);
+    while (record) {
+        metagraph_epoch_record_t *next = record->next;
+        free(record);
+        record = next;
+    }
+    atomic_store_explicit(&domain->records, NULL, memory_order_relaxed);
+    metagraph_mutex_destroy(&domain->registry_lock);
+}
+
+static metagraph_epoch_record_t *
+metagraph_epoch_find_record(const metagraph_epoch_domain_t *domain) {
+    for (uint32_t i = 0; i < METAGRAPH_EPOCH_BINDING_SLOTS; i++) {
+        if (metagraph_epoch_bindings[i].domain_id == domain->id) {
+            return metagraph_epoch_bindings[i].record;
+        }
+    }
+    // Evicted from the cache: records are only ever prepended, so a
+    // lock-free walk sees every record published before it started.
+    metagraph_epoch_record_t *record =
+        atomic_load_explicit(&domain->records, memory_order_acquire);
+    while (record && record->owner != &metagraph_epoch_token) {
+        record = record->next;
+    }
+    return record;
+}
+
+static void metagraph_epoch_bind(const metagraph_epoch_domain_t *domain,
+                                 metagraph_epoch_record_t *record) {
+    const uint32_t slot =
+        metagraph_epoch_next_binding++ % METAGRAPH_EPOCH_BINDING_SLOTS;
+    metagraph_epoch_bindings[slot].domain_id = domain->id;
+    metagraph_epoch_bindings[slot].record = record;
+}
+
+// Slow path: register a record for this thread.
+static metagraph_epoch_record_t *
+metagraph_epoch_register(metagraph_epoch_domain_t *domain) {
+    metagraph_epoch_record_t *record = metagraph_epoch_find_record(domain);
+    if (record) {
+        metagraph_epoch_bind(domain, record);
+        return record;
+    }
+    record = calloc(1, sizeof(*record));
+    if (!record) {
+        return NULL;
+    }
+    atomic_init(&record->epoch, 0);
+    record->owner = &metagraph_epoch_token;
+
+    metagraph_mutex_lock(&domain->registry_lock);
+    record->next = atomic_load_explicit(&domain->records, memory_order_relaxed);
+    atomic_store_explicit(&domain->records, record, memory_order_release);
+    metagraph_mutex_unlock(&domain->registry_lock);
+
+    metagraph_epoch_bind(domain, record);
+    return record;
+}
+
+metagraph_epoch_record_t *
+metagraph_epoch_enter(metagraph_epoch_domain_t *domain) {
+    metagraph_epoch_record_t *record = NULL;
+    for (uint32_t i = 0; i < METAGRAPH_EPOCH_BINDING_SLOTS; i++) {
+        if (metagraph_epoch_bindings[i].domain_id == domain->id) {
+            record = metagraph_epoch_bindings[i].record;
+            break;
+        }
+    }
+    if (!record) {
+        record = metagraph_epoch_register(domain);
+        if (!record) {
+            return NULL;
+        }
+    }
+    if (record->nesting++ == 0) {
+        // A stale (smaller) epoch only delays reclamation.
+        const uint64_t epoch =
+            atomic_load_explicit(&domain->epoch, memory_order_seq_cst);
+        atomic_store_explicit(&record->epoch, epoch, memory_order_seq_cst);
+    }
+    return record;
+}
+
+metagraph_epoch_record_t *
+metagraph_epoch_current(const metagraph_epoch_domain_t *domain) {
+    metagraph_epoch_record_t *record = metagraph_epoch_find_record(domain);
+    return (record && record->nesting > 0) ? record : NULL;
+}
+
+size_t metagraph_epoch_reclaim(metagraph_epoch_domain_t *domain) {
+    domain->retired_since_reclaim = 0;
+    if (!domain->retired_head) {
+        return 0;
+    }
+    uint64_t oldest = atomic_load_explicit(&domain->epoch, memory_order_seq_cst);
+    for (const metagraph_epoch_record_t *record =
+             atomic_load_explicit(&domain->records, memory_order_acquire);
+         record; record = record->next) {
+        const uint64_t epoch =
+            atomic_load_explicit(&record->epoch, memory_order_seq_cst);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    // A reader that announced epoch E may hold anything retired at E or
+    // later; everything stamped before the oldest announcement is free.
+    while (domain->retired_head && domain->retired_head->epoch < oldest) {
+        metagraph_epoch_node_t *node = domain->retired_head;
+        domain->retired_head = node->next;
+        domain->retired_count--;
+        node->release(node);
+    }
+    if (!domain->retired_head) {
+        domain->retired_tail = NULL;
+    }
+    return domain->retired_count;
+}
+
+void metagraph_epoch_retire(metagraph_epoch_domain_t *domain,
+                            metagraph_epoch_node_t *node,
+                            void (*release)(metagraph_epoch_node_t *node)) {
+    node->next = NULL;
+    node->release = release;
+    node->epoch = atomic_fetch_add_explicit(&domain->epoch, 1,
+                                            memory_order_seq_cst);
+    if (domain->retired_tail) {
+        domain->retired_tail->next = node;
+    } else {
+        domain->retired_head = node;
+    }
+    domain->retired_tail = node;
+    domain->retired_count++;
+    if (++domain->retired_since_reclaim >= METAGRAPH_EPOCH_RECLAIM_INTERVAL) {
+        (void)metagraph_epoch_reclaim(domain);
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * @file epoch.h
+ * @brief Internal epoch-based memory reclamation
+ *
+ * Readers announce the global epoch they observed before touching shared
+ * memory and clear the announcement when they are done. Writers unlink an
+ * object, then retire it: retirement stamps the object with the current
+ * epoch and advances the global epoch. A retired object is released once
+ * every active reader announces a later epoch, because such readers loaded
+ * their pointers after the unlink and cannot hold a reference to it.
+ *
+ * Reader entry and exit take no locks. Retirement and reclamation must be
+ * serialized by the caller (they run under the owning structure's writer
+ * lock).
+ */
+
+#ifndef SRC_EPOCH_H
+#define SRC_EPOCH_H
+
+#include "metagraph/result.h"
+
+#include "platform.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Intrusive retire-list link, embedded as the first member of
+ *        reclaimable objects
+ */
+typedef struct metagraph_epoch_node {
+    struct metagraph_epoch_node *next;
+    void (*release)(struct metagraph_epoch_node *node);
+    uint64_t epoch; ///< Global epoch at retirement
+} metagraph_epoch_node_t;
+
+/**
+ * @brief One thread's announcement slot in a domain
+ *
+ * Records are never freed before the domain, so a reader's pointer to its
+ * record stays valid for the domain's lifetime.
+ */
+typedef struct metagraph_epoch_record {
+    _Atomic(uint64_t) epoch; ///< Announced epoch, 0 while quiescent
+    uint32_t nesting;        ///< Owning thread only
+    const void *owner;       ///< Address of the owning thread's TLS token
+    struct metagraph_epoch_record *next;
+} metagraph_epoch_record_t;
+
+/**
+ * @brief Reclamation domain shared by a structure and its readers
+ */
+typedef struct {
+    uint64_t id;
+    _Atomic(uint64_t) epoch;
+    _Atomic(metagraph_epoch_record_t *) records;
+    metagraph_mutex_t registry_lock; ///< Serializes record registration
+
+    // Writer side (caller-serialized)
+    metagraph_epoch_node_t *retired_head;
+    metagraph_epoch_node_t *retired_tail;
+    size_t retired_count;
+    size_t retired_since_reclaim;
+} metagraph_epoch_domain_t;
+
+metagraph_result_t metagraph_epoch_domain_init(metagraph_epoch_domain_t *domain);
+
+/**
+ * @brief Release every retired object and every record
+ *
+ * No reader may be inside the domain.
+ */
+void metagraph_epoch_domain_destroy(metagraph_epoch_domain_t *domain);
+
+/**
+ * @brief Enter a read-side critical section (nestable)
+ * @return The calling thread's record, or NULL if it could not be allocated
+ */
+metagraph_epoch_record_t *
+metagraph_epoch_enter(metagraph_epoch_domain_t *domain);
+
+/**
+ * @brief Leave a read-side critical section entered on the same thread
+ */
+static inline void metagraph_epoch_exit(metagraph_epoch_record_t *record) {
+    if (--record->nesting == 0) {
+        atomic_store_explicit(&record->epoch, 0, memory_order_release);
+    }
+}
+
+/**
+ * @brief The calling thread's record if it is inside the domain, else NULL
+ */
+metagraph_epoch_record_t *
+metagraph_epoch_current(const metagraph_epoch_domain_t *domain);
+
+/**
+ * @brief Retire an object that is no longer reachable by new readers
+ *
+ * node->release runs once no reader can still reference the object, at
+ * the latest when the domain is destroyed. Reclamation is attempted every
+ * few retirements.
+ */
+void metagraph_epoch_retire(metagraph_epoch_domain_t *domain,
+                            metagraph_epoch_node_t *node,
+                            void (*release)(metagraph_epoch_node_t *node));
+
+/**
+ * @brief Release every retired object no active reader can reference
+ * @return Objects still waiting for readers
+ */
+size_t metagraph_epoch_reclaim(metagraph_epoch_domain_t *domain);
+
+#endif // SRC_EPOCH_H
@@ -2,31 +2,52 @@
  * @file error.c
  * @brief Implementation of error handling and context management
  *
- * Thread-local error contexts are cached for the lifetime of each thread.
- * The memory is intentionally not freed on thread exit to avoid complexity
- * with thread cleanup handlers. The OS will reclaim the memory when the
- * thread terminates.
+ * Each thread's error context lives in thread-local storage, so reporting
+ * an error never allocates and nothing is left behind when a thread exits.
+ *
+ * Messages are formatted lazily. Reporting an error records the format
+ * string and a packed copy of its arguments (string arguments are copied,
+ * since the caller's buffers may be gone by the time anyone asks); the
+ * message is rendered only when metagraph_get_error_context() is called.
+ * Errors that are expected and discarded, such as lookups that miss,
+ * therefore never pay for vsnprintf.
  */
 
 #include "metagraph/result.h"
+#include "metrics_internal.h"
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 
-// C23 thread-local storage for error context
-// Note: This memory is cached per-thread and not freed until thread exit
-static _Thread_local metagraph_error_context_t *thread_error_context = NULL;
+// Arguments and string bytes one deferred message can capture; anything
+// larger is formatted immediately instead.
+#define METAGRAPH_ERROR_MAX_ARGS 16
+#define METAGRAPH_ERROR_STRING_CAPACITY 256
 
-// Get thread-local error context, creating if necessary
-static metagraph_error_context_t *metagraph_get_thread_error_context(void) {
-    if (!thread_error_context) {
-        thread_error_context = calloc(1, sizeof(metagraph_error_context_t));
-        // If allocation fails, we can't store error context but that's OK
-        // The functions will handle NULL context gracefully
-    }
-    return thread_error_context;
-}
+// One captured argument; the format says which member is live.
+typedef union {
+    intmax_t signed_value; // Signed integers, %c and '*' widths
+    uintmax_t unsigned_value;
+    double real;
+    long double long_real;
+    const void *pointer;
+    size_t string_offset; // Into metagraph_error_state_t.strings
+} metagraph_error_arg_t;
+
+typedef struct {
+    metagraph_error_context_t context;
+    const char *format; // Pending format, NULL once message is current
+    size_t arg_count;
+    size_t string_size;
+    metagraph_error_arg_t args[METAGRAPH_ERROR_MAX_ARGS];
+    char strings[METAGRAPH_ERROR_STRING_CAPACITY];
+} metagraph_error_state_t;
+
+// C23 thread-local storage for error context
+static _Thread_local metagraph_error_state_t thread_error_state;
 
 // Error string lookup table
 typedef struct {
@@ -171,6 +192,509 @@ static void metagraph_format_error_message(char *buffer, size_t cap,
     }
 }
 
+// ============================================================================
+// Deferred formatting
+// ============================================================================
+
+typedef enum {
+    METAGRAPH_ERROR_LENGTH_NONE,
+    METAGRAPH_ERROR_LENGTH_HH,
+    METAGRAPH_ERROR_LENGTH_H,
+    METAGRAPH_ERROR_LENGTH_L,
+    METAGRAPH_ERROR_LENGTH_LL,
+    METAGRAPH_ERROR_LENGTH_J,
+    METAGRAPH_ERROR_LENGTH_Z,
+    METAGRAPH_ERROR_LENGTH_T,
+    METAGRAPH_ERROR_LENGTH_LONG_DOUBLE,
+} metagraph_error_length_t;
+
+typedef enum {
+    METAGRAPH_ERROR_ARG_SIGNED,
+    METAGRAPH_ERROR_ARG_UNSIGNED,
+    METAGRAPH_ERROR_ARG_CHAR,
+    METAGRAPH_ERROR_ARG_REAL,
+    METAGRAPH_ERROR_ARG_STRING,
+    METAGRAPH_ERROR_ARG_POINTER,
+} metagraph_error_arg_kind_t;
+
+// One conversion of a printf format, as far as capture and rendering need
+typedef struct {
+    const char *flags; // flag_count flag characters
+    size_t flag_count;
+    int width;     // -1 = none; a '*' width is read from the arguments
+    int precision; // -1 = none; likewise for '*'
+    bool width_star;
+    bool precision_star;
+    metagraph_error_length_t length;
+    metagraph_error_arg_kind_t kind;
+    char conversion;
+    const char *end; // One past the conversion character
+} metagraph_error_spec_t;
+
+// Limits keep rebuilt conversion specs short; wider output would be
+// truncated by the message buffer anyway.
+#define METAGRAPH_ERROR_MAX_FLAGS 8U
+#define METAGRAPH_ERROR_MAX_FIELD 9999
+
+static int metagraph_error_parse_number(const char **cursor) {
+    int value = 0;
+    while (**cursor >= '0' && **cursor <= '9') {
+        if (value <= METAGRAPH_ERROR_MAX_FIELD) {
+            value = value * 10 + (**cursor - '0');
+        }
+        (*cursor)++;
+    }
+    return value > METAGRAPH_ERROR_MAX_FIELD ? METAGRAPH_ERROR_MAX_FIELD
+                                             : value;
+}
+
+static metagraph_error_length_t
+metagraph_error_parse_length(const char **cursor) {
+    const char first = **cursor;
+    switch (first) {
+    case 'h':
+    case 'l':
+        (*cursor)++;
+        if (**cursor == first) {
+            (*cursor)++;
+            return first == 'h' ? METAGRAPH_ERROR_LENGTH_HH
+                                : METAGRAPH_ERROR_LENGTH_LL;
+        }
+        return first == 'h' ? METAGRAPH_ERROR_LENGTH_H
+                            : METAGRAPH_ERROR_LENGTH_L;
+    case 'j':
+        (*cursor)++;
+        return METAGRAPH_ERROR_LENGTH_J;
+    case 'z':
+        (*cursor)++;
+        return METAGRAPH_ERROR_LENGTH_Z;
+    case 't':
+        (*cursor)++;
+        return METAGRAPH_ERROR_LENGTH_T;
+    case 'L':
+        (*cursor)++;
+        return METAGRAPH_ERROR_LENGTH_LONG_DOUBLE;
+    default:
+        return METAGRAPH_ERROR_LENGTH_NONE;
+    }
+}
+
+// Parse the conversion starting just after '%'. Returns false for
+// anything the deferred path does not handle (wide characters, %n, ...).
+static bool metagraph_error_parse_spec(const char *cursor,
+                                       metagraph_error_spec_t *spec) {
+    spec->flags = cursor;
+    while (*cursor && strchr("-+ #0", *cursor)) {
+        cursor++;
+    }
+    spec->flag_count = (size_t)(cursor - spec->flags);
+    if (spec->flag_count > METAGRAPH_ERROR_MAX_FLAGS) {
+        return false;
+    }
+    spec->width = -1;
+    spec->width_star = *cursor == '*';
+    if (spec->width_star) {
+        cursor++;
+    } else if (*cursor >= '0' && *cursor <= '9') {
+        spec->width = metagraph_error_parse_number(&cursor);
+    }
+    spec->precision = -1;
+    spec->precision_star = false;
+    if (*cursor == '.') {
+        cursor++;
+        spec->precision_star = *cursor == '*';
+        if (spec->precision_star) {
+            cursor++;
+        } else {
+            spec->precision = metagraph_error_parse_number(&cursor);
+        }
+    }
+    spec->length = metagraph_error_parse_length(&cursor);
+    spec->conversion = *cursor;
+
+    switch (spec->conversion) {
+    case 'd':
+    case 'i':
+        spec->kind = METAGRAPH_ERROR_ARG_SIGNED;
+        break;
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+        spec->kind = METAGRAPH_ERROR_ARG_UNSIGNED;
+        break;
+    case 'c':
+        spec->kind = METAGRAPH_ERROR_ARG_CHAR;
+        break;
+    case 'a':
+    case 'A':
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+        spec->kind = METAGRAPH_ERROR_ARG_REAL;
+        break;
+    case 's':
+        spec->kind = METAGRAPH_ERROR_ARG_STRING;
+        break;
+    case 'p':
+        spec->kind = METAGRAPH_ERROR_ARG_POINTER;
+        break;
+    default:
+        return false;
+    }
+
+    // 'l' has no effect on floating conversions; 'L' only applies to them.
+    if (spec->kind == METAGRAPH_ERROR_ARG_REAL) {
+        if (spec->length == METAGRAPH_ERROR_LENGTH_L) {
+            spec->length = METAGRAPH_ERROR_LENGTH_NONE;
+        }
+        if (spec->length != METAGRAPH_ERROR_LENGTH_NONE &&
+            spec->length != METAGRAPH_ERROR_LENGTH_LONG_DOUBLE) {
+            return false;
+        }
+    } else if (spec->length == METAGRAPH_ERROR_LENGTH_LONG_DOUBLE ||
+               (spec->kind != METAGRAPH_ERROR_ARG_SIGNED &&
+                spec->kind != METAGRAPH_ERROR_ARG_UNSIGNED &&
+                spec->length != METAGRAPH_ERROR_LENGTH_NONE)) {
+        return false;
+    }
+    spec->end = cursor + 1;
+    return true;
+}
+
+static intmax_t metagraph_error_read_signed(metagraph_error_length_t length,
+                                            va_list *args) {
+    switch (length) {
+    case METAGRAPH_ERROR_LENGTH_HH:
+        return (signed char)va_arg(*args, int);
+    case METAGRAPH_ERROR_LENGTH_H:
+        return (short)va_arg(*args, int);
+    case METAGRAPH_ERROR_LENGTH_L:
+        return va_arg(*args, long);
+    case METAGRAPH_ERROR_LENGTH_LL:
+        return va_arg(*args, long long);
+    case METAGRAPH_ERROR_LENGTH_J:
+        return va_arg(*args, intmax_t);
+    case METAGRAPH_ERROR_LENGTH_Z:
+        return (intmax_t)(ptrdiff_t)va_arg(*args, size_t);
+    case METAGRAPH_ERROR_LENGTH_T:
+        return va_arg(*args, ptrdiff_t);
+    case METAGRAPH_ERROR_LENGTH_NONE:
+    case METAGRAPH_ERROR_LENGTH_LONG_DOUBLE:
+    default:
+        return va_arg(*args, int);
+    }
+}
+
+static uintmax_t metagraph_error_read_unsigned(metagraph_error_length_t length,
+                                               va_list *args) {
+    switch (length) {
+    case METAGRAPH_ERROR_LENGTH_HH:
+        return (unsigned char)va_arg(*args, unsigned int);
+    case METAGRAPH_ERROR_LENGTH_H:
+        return (unsigned short)va_arg(*args, unsigned int);
+    case METAGRAPH_ERROR_LENGTH_L:
+        return va_arg(*args, unsigned long);
+    case METAGRAPH_ERROR_LENGTH_LL:
+        return va_arg(*args, unsigned long long);
+    case METAGRAPH_ERROR_LENGTH_J:
+        return va_arg(*args, uintmax_t);
+    case METAGRAPH_ERROR_LENGTH_Z:
+        return va_arg(*args, size_t);
+    case METAGRAPH_ERROR_LENGTH_T:
+        return (uintmax_t)(size_t)va_arg(*args, ptrdiff_t);
+    case METAGRAPH_ERROR_LENGTH_NONE:
+    case METAGRAPH_ERROR_LENGTH_LONG_DOUBLE:
+    default:
+        return va_arg(*args, unsigned int);
+    }
+}
+
+static bool metagraph_error_push(metagraph_error_state_t *state,
+                                 const metagraph_error_arg_t *arg) {
+    if (state->arg_count == METAGRAPH_ERROR_MAX_ARGS) {
+        return false;
+    }
+    state->args[state->arg_count++] = *arg;
+    return true;
+}
+
+static bool metagraph_error_push_star(metagraph_error_state_t *state,
+                                      va_list *args, int *out_value) {
+    int value = va_arg(*args, int);
+    if (value > METAGRAPH_ERROR_MAX_FIELD) {
+        value = METAGRAPH_ERROR_MAX_FIELD;
+    } else if (value < -METAGRAPH_ERROR_MAX_FIELD) {
+        value = -METAGRAPH_ERROR_MAX_FIELD;
+    }
+    *out_value = value;
+    const metagraph_error_arg_t arg = {.signed_value = value};
+    return metagraph_error_push(state, &arg);
+}
+
+// Copy a string argument, honouring the precision. Returns false if the
+// string area is full; the caller then formats eagerly.
+static bool metagraph_error_push_string(metagraph_error_state_t *state,
+                                        const char *text, int precision) {
+    if (!text) {
+        text = "(null)";
+    }
+    size_t length = 0;
+    while (text[length] && (precision < 0 || length < (size_t)precision)) {
+        length++;
+    }
+    if (length >= METAGRAPH_ERROR_STRING_CAPACITY - state->string_size) {
+        return false;
+    }
+    const metagraph_error_arg_t arg = {.string_offset = state->string_size};
+    memcpy(state->strings + state->string_size, text, length);
+    state->string_size += length;
+    state->strings[state->string_size++] = '\0';
+    return metagraph_error_push(state, &arg);
+}
+
+static bool metagraph_error_capture_arg(metagraph_error_state_t *state,
+                                        const metagraph_error_spec_t *spec,
+                                        va_list *args) {
+    int precision = spec->precision;
+    if (spec->width_star) {
+        int width = 0;
+        if (!metagraph_error_push_star(state, args, &width)) {
+            return false;
+        }
+    }
+    if (spec->precision_star &&
+        !metagraph_error_push_star(state, args, &precision)) {
+        return false;
+    }
+
+    metagraph_error_arg_t arg;
+    switch (spec->kind) {
+    case METAGRAPH_ERROR_ARG_SIGNED:
+        arg.signed_value = metagraph_error_read_signed(spec->length, args);
+        break;
+    case METAGRAPH_ERROR_ARG_UNSIGNED:
+        arg.unsigned_value = metagraph_error_read_unsigned(spec->length, args);
+        break;
+    case METAGRAPH_ERROR_ARG_CHAR:
+        arg.signed_value = va_arg(*args, int);
+        break;
+    case METAGRAPH_ERROR_ARG_REAL:
+        if (spec->length == METAGRAPH_ERROR_LENGTH_LONG_DOUBLE) {
+            arg.long_real = va_arg(*args, long double);
+        } else {
+            arg.real = va_arg(*args, double);
+        }
+        break;
+    case METAGRAPH_ERROR_ARG_STRING:
+        return metagraph_error_push_string(state, va_arg(*args, const char *),
+                                           precision);
+    case METAGRAPH_ERROR_ARG_POINTER:
+        arg.pointer = va_arg(*args, void *);
+        break;
+    default:
+        return false;
+    }
+    return metagraph_error_push(state, &arg);
+}
+
+// Record the arguments `format` consumes. Returns false if they do not
+// fit or use a conversion the renderer does not support.
+static bool metagraph_error_capture(metagraph_error_state_t *state,
+                                    const char *format, va_list *args) {
+    state->arg_count = 0;
+    state->string_size = 0;
+    const char *cursor = format;
+    while ((cursor = strchr(cursor, '%')) != NULL) {
+        if (cursor[1] == '%') {
+            cursor += 2;
+            continue;
+        }
+        metagraph_error_spec_t spec;
+        if (!metagraph_error_parse_spec(cursor + 1, &spec) ||
+            !metagraph_error_capture_arg(state, &spec, args)) {
+            return false;
+        }
+        cursor = spec.end;
+    }
+    return true;
+}
+
+typedef struct {
+    char *buffer;
+    size_t capacity;
+    size_t length;
+    bool truncated;
+} metagraph_error_writer_t;
+
+static void metagraph_error_write(metagraph_error_writer_t *writer,
+                                  const char *text, size_t length) {
+    const size_t room = writer->capacity - 1U - writer->length;
+    if (length > room) {
+        length = room;
+        writer->truncated = true;
+    }
+    memcpy(writer->buffer + writer->length, text, length);
+    writer->length += length;
+    writer->buffer[writer->length] = '\0';
+}
+
+// Format one captured argument through a spec the renderer rebuilt.
+static void metagraph_error_write_formatted(metagraph_error_writer_t *writer,
+                                            const char *spec, ...) {
+    const size_t room = writer->capacity - writer->length;
+    va_list args;
+    va_start(args, spec);
+    const int written = vsnprintf(writer->buffer + writer->length, room, spec,
+                                  args);
+    va_end(args);
+    if (written < 0) {
+        writer->buffer[writer->length] = '\0';
+    } else if ((size_t)written >= room) {
+        writer->length = writer->capacity - 1U;
+        writer->truncated = true;
+    } else {
+        writer->length += (size_t)written;
+    }
+}
+
+static void metagraph_error_append_decimal(char *text, size_t *length,
+                                           int value) {
+    char digits[8];
+    size_t count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        text[(*length)++] = digits[--count];
+    }
+}
+
+// Rebuild a conversion with '*' fields resolved and the length modifier
+// widened to the type the argument was captured as.
+// A negative '*' width means left-justified; a negative '*' precision
+// means none.
+static void metagraph_error_build_spec(const metagraph_error_spec_t *spec,
+                                       int width, int precision,
+                                       char text[32]) {
+    size_t length = 0;
+    text[length++] = '%';
+    memcpy(text + length, spec->flags, spec->flag_count);
+    length += spec->flag_count;
+    if (spec->width_star && width < 0) {
+        text[length++] = '-';
+        width = -width;
+    }
+    if (width >= 0) {
+        metagraph_error_append_decimal(text, &length, width);
+    }
+    if (precision >= 0) {
+        text[length++] = '.';
+        metagraph_error_append_decimal(text, &length, precision);
+    }
+    if (spec->kind == METAGRAPH_ERROR_ARG_SIGNED ||
+        spec->kind == METAGRAPH_ERROR_ARG_UNSIGNED) {
+        text[length++] = 'j';
+    } else if (spec->length == METAGRAPH_ERROR_LENGTH_LONG_DOUBLE) {
+        text[length++] = 'L';
+    }
+    text[length++] = spec->conversion;
+    text[length] = '\0';
+}
+
+static void metagraph_error_render(metagraph_error_state_t *state) {
+    metagraph_error_writer_t writer = {
+        .buffer = state->context.message,
+        .capacity = sizeof(state->context.message),
+    };
+    writer.buffer[0] = '\0';
+    size_t next = 0;
+    const char *cursor = state->format;
+    const char *percent = NULL;
+    while ((percent = strchr(cursor, '%')) != NULL) {
+        metagraph_error_write(&writer, cursor, (size_t)(percent - cursor));
+        if (percent[1] == '%') {
+            metagraph_error_write(&writer, "%", 1);
+            cursor = percent + 2;
+            continue;
+        }
+        // Capture already accepted this format, so parsing succeeds.
+        metagraph_error_spec_t spec;
+        (void)metagraph_error_parse_spec(percent + 1, &spec);
+        cursor = spec.end;
+        int width = spec.width;
+        int precision = spec.precision;
+        if (spec.width_star) {
+            width = (int)state->args[next++].signed_value;
+        }
+        if (spec.precision_star) {
+            precision = (int)state->args[next++].signed_value;
+            precision = precision < 0 ? -1 : precision;
+        }
+        char text[32];
+        metagraph_error_build_spec(&spec, width, precision, text);
+        const metagraph_error_arg_t *arg = &state->args[next++];
+        switch (spec.kind) {
+        case METAGRAPH_ERROR_ARG_SIGNED:
+            metagraph_error_write_formatted(&writer, text, arg->signed_value);
+            break;
+        case METAGRAPH_ERROR_ARG_UNSIGNED:
+            metagraph_error_write_formatted(&writer, text, arg->unsigned_value);
+            break;
+        case METAGRAPH_ERROR_ARG_CHAR:
+            metagraph_error_write_formatted(&writer, text,
+                                            (int)arg->signed_value);
+            break;
+        case METAGRAPH_ERROR_ARG_REAL:
+            if (spec.length == METAGRAPH_ERROR_LENGTH_LONG_DOUBLE) {
+                metagraph_error_write_formatted(&writer, text, arg->long_real);
+            } else {
+                metagraph_error_write_formatted(&writer, text, arg->real);
+            }
+            break;
+        case METAGRAPH_ERROR_ARG_STRING:
+            metagraph_error_write_formatted(
+                &writer, text, state->strings + arg->string_offset);
+            break;
+        case METAGRAPH_ERROR_ARG_POINTER:
+            metagraph_error_write_formatted(&writer, text, arg->pointer);
+            break;
+        default:
+            break;
+        }
+    }
+    metagraph_error_write(&writer, cursor, strlen(cursor));
+
+    static const char ellipsis[] = "...";
+    if (writer.truncated) {
+        memcpy(writer.buffer + writer.capacity - sizeof(ellipsis), ellipsis,
+               sizeof(ellipsis));
+    }
+    state->format = NULL;
+}
+
+// ============================================================================
+// Context management
+// ============================================================================
+
+static void metagraph_error_reset(metagraph_error_state_t *state,
+                                  metagraph_result_t code, const char *file,
+                                  int line, const char *function) {
+    state->context.code = code;
+    state->context.file = file;
+    state->context.line = line;
+    state->context.function = function;
+    state->context.message[0] = '\0';
+    // Note: Ownership of detail pointer is caller's responsibility
+    state->context.detail = NULL;
+    state->context.detail_size = 0;
+    state->format = NULL;
+}
+
 METAGRAPH_ATTR_COLD
 metagraph_result_t metagraph_set_error_context(
     metagraph_result_t code, const char *file, int line,
@@ -178,31 +702,31 @@ metagraph_result_t metagraph_set_error_context(
     const char *format, ...) {
     // Rationale: parameters are supplied exclusively by macros
     // (__FILE__, __LINE__, __func__), so swap risk is nil.
-    metagraph_error_context_t *context = metagraph_get_thread_error_context();
-    if (!context) {
-        // Can't store context due to allocation failure, but still return the
-        // error
-        return code;
-    }
-
-    // Set basic error information
-    context->code = code;
-    context->file = file;
-    context->line = line;
-    context->function = function;
+    metagraph_error_state_t *state = &thread_error_state;
+    metagraph_error_reset(state, code, file, line, function);
+    metagraph_metrics_error(code);
 
-    // Format the error message
     va_list args;
     va_start(args, format);
-    metagraph_format_error_message(context->message, sizeof(context->message),
-                                   format, args);
+    va_list replay;
+    va_copy(replay, args);
+    if (metagraph_error_capture(state, format, &args)) {
+        state->format = format;
+    } else {
+        metagraph_format_error_message(state->context.message,
+                                       sizeof(state->context.message), format,
+                                       replay);
+    }
+    va_end(replay);
     va_end(args);
+    return code;
+}
 
-    // Clear any previous detail data
-    // Note: Ownership of detail pointer is caller's responsibility
-    context->detail = NULL;
-    context->detail_size = 0;
-
+METAGRAPH_ATTR_COLD
+metagraph_result_t metagraph_set_error_location(metagraph_result_t code,
+                                                const char *file, int line) {
+    metagraph_error_reset(&thread_error_state, code, file, line, NULL);
+    metagraph_metrics_error(code);
     return code;
 }
 
@@ -212,46 +736,35 @@ metagraph_get_error_context(metagraph_error_context_t *context) {
         return METAGRAPH_ERROR_NULL_POINTER;
     }
 
-    metagraph_error_context_t *thread_context =
-        metagraph_get_thread_error_context();
-    if (!thread_context) {
-        // No context available (allocation failed), return success with empty
-        // context
-        memset(context, 0, sizeof(*context));
-        context->code = METAGRAPH_SUCCESS;
-        return METAGRAPH_SUCCESS;
-    }
-
     // If no error has been set, return success with clear context
-    if (thread_context->code == METAGRAPH_SUCCESS) {
+    metagraph_error_state_t *state = &thread_error_state;
+    if (state->context.code == METAGRAPH_SUCCESS) {
         memset(context, 0, sizeof(*context));
         context->code = METAGRAPH_SUCCESS;
         return METAGRAPH_SUCCESS;
     }
 
-    // Copy the error context
-    *context = *thread_context;
+    if (state->format) {
+        metagraph_error_render(state);
+    }
+    // Errors recorded without a message describe themselves by code.
+    if (state->context.message[0] == '\0') {
+        const char *text = metagraph_result_to_string(state->context.code);
+        metagraph_error_writer_t writer = {
+            .buffer = state->context.message,
+            .capacity = sizeof(state->context.message),
+        };
+        metagraph_error_write(&writer, text, strlen(text));
+    }
+    *context = state->context;
     return METAGRAPH_SUCCESS;
 }
 
 void metagraph_clear_error_context(void) {
-    metagraph_error_context_t *context = thread_error_context;
-    if (context) {
-        memset(context, 0, sizeof(metagraph_error_context_t));
-        context->code = METAGRAPH_SUCCESS;
-        // Note: We intentionally keep the allocated memory for reuse
-        // rather than freeing it. This avoids repeated allocations
-        // and the complexity of thread cleanup handlers.
-    }
+    metagraph_error_reset(&thread_error_state, METAGRAPH_SUCCESS, NULL, 0, NULL);
 }
 
-// Optional: Call this before thread exit to free the thread-local storage
-// Not required as the OS will reclaim memory on thread termination
+// Optional: the context no longer owns heap memory, so this only resets it
 #ifdef METAGRAPH_EXPOSE_THREAD_CLEANUP
-void metagraph_thread_cleanup(void) {
-    if (thread_error_context) {
-        free(thread_error_context);
-        thread_error_context = NULL;
-    }
-}
+void metagraph_thread_cleanup(void) { metagraph_clear_error_context(); }
 #endif
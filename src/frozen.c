@@ -0,0 +1,709 @@
+/**
+ * @file frozen.c
+ * @brief Frozen CSR topology with Stream VByte packed adjacency
+ *
+ * A list of n deltas is stored as ceil(n / 4) control bytes followed by
+ * the data bytes. Control byte g holds the length codes (byte count - 1)
+ * of deltas 4g .. 4g + 3, lowest bits first, and the first delta of a list
+ * is taken from zero. The packed buffer ends in METAGRAPH_FROZEN_PAD spare
+ * bytes so a vector decoder may always load 16 bytes of data.
+ *
+ * The vector decoders look up a 16-byte shuffle mask and the group's data
+ * length by control byte, gather four deltas into 32-bit lanes, and turn
+ * them into values with two shifted adds plus the previous group's last
+ * value. A list's final partial group is decoded by the scalar loop.
+ */
+
+#include "metagraph/frozen.h"
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include "bundle_internal.h"
+#include "graph_internal.h"
+#include "metrics_internal.h"
+#include "platform.h"
+#include "trace_internal.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define METAGRAPH_FROZEN_SSSE3 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define METAGRAPH_FROZEN_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define METAGRAPH_FROZEN_PAD 16U
+
+struct metagraph_frozen_graph {
+    size_t node_count;
+    size_t edge_count;
+    size_t member_count;
+
+    // Incidence in the EDGES section layout
+    const metagraph_bundle_edge_record_t *records;
+    const uint32_t *members;
+    const uint32_t *out_rows;
+    const uint32_t *out_edges;
+    const uint32_t *in_rows;
+    const uint32_t *in_edges;
+    void *incidence;        ///< Owned copy of the above, NULL over a bundle
+    size_t incidence_bytes;
+
+    // Node n's adjacency holds neighbor_rows[n + 1] - neighbor_rows[n]
+    // entries encoded at packed + packed_rows[n].
+    uint32_t *neighbor_rows;
+    uint64_t *packed_rows;
+    uint8_t *packed;
+    size_t packed_size; ///< Excluding the padding
+    uint32_t max_degree;
+};
+
+// ============================================================================
+// Stream VByte coding
+// ============================================================================
+
+typedef void (*metagraph_frozen_decode_fn)(const uint8_t *list, size_t count,
+                                           uint32_t *out);
+
+static struct {
+    metagraph_once_t once;
+    metagraph_frozen_decode_fn decode;
+    bool simd;
+    uint8_t group_length[256];
+    uint8_t shuffle[256][16];
+} metagraph_frozen_tables;
+
+static uint32_t metagraph_frozen_code(uint8_t control, size_t lane) {
+    return ((uint32_t)control >> (lane * 2U)) & 3U;
+}
+
+// Decode entries first .. count - 1, continuing from value and data.
+static void metagraph_frozen_decode_tail(const uint8_t *control,
+                                         const uint8_t *data, size_t first,
+                                         size_t count, uint32_t value,
+                                         uint32_t *out) {
+    for (size_t i = first; i < count; i++) {
+        const uint32_t length =
+            metagraph_frozen_code(control[i >> 2U], i & 3U) + 1U;
+        uint32_t delta = 0;
+        for (uint32_t byte = 0; byte < length; byte++) {
+            delta |= (uint32_t)data[byte] << (8U * byte);
+        }
+        data += length;
+        value += delta;
+        out[i] = value;
+    }
+}
+
+static void metagraph_frozen_decode_scalar(const uint8_t *list, size_t count,
+                                           uint32_t *out) {
+    metagraph_frozen_decode_tail(list, list + (count + 3U) / 4U, 0, count, 0,
+                                 out);
+}
+
+#ifdef METAGRAPH_FROZEN_SSSE3
+
+__attribute__((target("ssse3"))) static void
+metagraph_frozen_decode_ssse3(const uint8_t *list, size_t count,
+                              uint32_t *out) {
+    const uint8_t *control = list;
+    const uint8_t *data = list + (count + 3U) / 4U;
+    const size_t groups = count / 4U;
+    __m128i previous = _mm_setzero_si128();
+    for (size_t group = 0; group < groups; group++) {
+        const uint8_t code = control[group];
+        const void *shuffle = metagraph_frozen_tables.shuffle[code];
+        const __m128i mask = _mm_loadu_si128((const __m128i *)shuffle);
+        __m128i values = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)(const void *)data), mask);
+        data += metagraph_frozen_tables.group_length[code];
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+        values = _mm_add_epi32(values, previous);
+        _mm_storeu_si128((__m128i *)(void *)(out + 4U * group), values);
+        previous = _mm_shuffle_epi32(values, 0xFF);
+    }
+    const uint32_t value = groups ? out[4U * groups - 1U] : 0U;
+    metagraph_frozen_decode_tail(control, data, 4U * groups, count, value,
+                                 out);
+}
+
+#endif // METAGRAPH_FROZEN_SSSE3
+
+#ifdef METAGRAPH_FROZEN_NEON
+
+static void metagraph_frozen_decode_neon(const uint8_t *list, size_t count,
+                                         uint32_t *out) {
+    const uint8_t *control = list;
+    const uint8_t *data = list + (count + 3U) / 4U;
+    const size_t groups = count / 4U;
+    const uint32x4_t zero = vdupq_n_u32(0);
+    uint32x4_t previous = zero;
+    for (size_t group = 0; group < groups; group++) {
+        const uint8_t code = control[group];
+        const uint8x16_t mask = vld1q_u8(metagraph_frozen_tables.shuffle[code]);
+        uint32x4_t values =
+            vreinterpretq_u32_u8(vqtbl1q_u8(vld1q_u8(data), mask));
+        data += metagraph_frozen_tables.group_length[code];
+        values = vaddq_u32(values, vextq_u32(zero, values, 3));
+        values = vaddq_u32(values, vextq_u32(zero, values, 2));
+        values = vaddq_u32(values, previous);
+        vst1q_u32(out + 4U * group, values);
+        previous = vdupq_laneq_u32(values, 3);
+    }
+    const uint32_t value = groups ? out[4U * groups - 1U] : 0U;
+    metagraph_frozen_decode_tail(control, data, 4U * groups, count, value,
+                                 out);
+}
+
+#endif // METAGRAPH_FROZEN_NEON
+
+static void metagraph_frozen_fill_tables(void) {
+    for (uint32_t control = 0; control < 256U; control++) {
+        uint8_t *mask = metagraph_frozen_tables.shuffle[control];
+        memset(mask, 0xFF, 16U);
+        uint32_t offset = 0;
+        for (size_t lane = 0; lane < 4U; lane++) {
+            const uint32_t length =
+                metagraph_frozen_code((uint8_t)control, lane) + 1U;
+            for (uint32_t byte = 0; byte < length; byte++) {
+                mask[lane * 4U + byte] = (uint8_t)(offset + byte);
+            }
+            offset += length;
+        }
+        metagraph_frozen_tables.group_length[control] = (uint8_t)offset;
+    }
+    metagraph_frozen_tables.decode = metagraph_frozen_decode_scalar;
+#if defined(METAGRAPH_FROZEN_SSSE3)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) {
+        metagraph_frozen_tables.decode = metagraph_frozen_decode_ssse3;
+        metagraph_frozen_tables.simd = true;
+    }
+#elif defined(METAGRAPH_FROZEN_NEON)
+    metagraph_frozen_tables.decode = metagraph_frozen_decode_neon;
+    metagraph_frozen_tables.simd = true;
+#endif
+}
+
+static void metagraph_frozen_init(void) {
+    metagraph_once(&metagraph_frozen_tables.once, metagraph_frozen_fill_tables);
+}
+
+// Encode ascending values as deltas; returns the bytes written.
+static size_t metagraph_frozen_encode(const uint32_t *values, size_t count,
+                                      uint8_t *out) {
+    uint8_t *control = out;
+    const size_t control_bytes = (count + 3U) / 4U;
+    memset(control, 0, control_bytes);
+    uint8_t *data = out + control_bytes;
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t delta = values[i] - previous;
+        previous = values[i];
+        const uint32_t length = delta < (1U << 8U)    ? 1U
+                                : delta < (1U << 16U) ? 2U
+                                : delta < (1U << 24U) ? 3U
+                                                      : 4U;
+        control[i >> 2U] |= (uint8_t)((length - 1U) << ((i & 3U) * 2U));
+        for (uint32_t byte = 0; byte < length; byte++) {
+            *data++ = (uint8_t)(delta >> (8U * byte));
+        }
+    }
+    return (size_t)(data - out);
+}
+
+// ============================================================================
+// Freezing
+// ============================================================================
+
+static int metagraph_frozen_compare(const void *lhs, const void *rhs) {
+    const uint32_t a = *(const uint32_t *)lhs;
+    const uint32_t b = *(const uint32_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+// Gather, sort and deduplicate the targets of node's outgoing edges into
+// scratch, which holds capacity entries; out_count receives the number of
+// distinct targets.
+static metagraph_result_t
+metagraph_frozen_targets(const metagraph_frozen_graph_t *frozen,
+                         metagraph_node_index_t node, uint32_t *scratch,
+                         size_t capacity, size_t *out_count) {
+    size_t count = 0;
+    for (uint32_t i = frozen->out_rows[node]; i < frozen->out_rows[node + 1U];
+         i++) {
+        const metagraph_bundle_edge_record_t *record =
+            &frozen->records[frozen->out_edges[i]];
+        const size_t targets = record->member_count - 1U;
+        if (targets > capacity - count) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                 "Out edges of node %u list more targets "
+                                 "than there are members",
+                                 node);
+        }
+        memcpy(scratch + count, frozen->members + record->member_begin + 1U,
+               targets * sizeof(*scratch));
+        count += targets;
+    }
+    *out_count = count;
+    if (count < 2U) {
+        return METAGRAPH_OK();
+    }
+    qsort(scratch, count, sizeof(*scratch), metagraph_frozen_compare);
+    size_t unique = 1;
+    for (size_t i = 1; i < count; i++) {
+        if (scratch[i] != scratch[unique - 1U]) {
+            scratch[unique++] = scratch[i];
+        }
+    }
+    *out_count = unique;
+    return METAGRAPH_OK();
+}
+
+// Build the packed adjacency from the incidence arrays.
+static metagraph_result_t
+metagraph_frozen_pack(metagraph_frozen_graph_t *frozen) {
+    const size_t nodes = frozen->node_count;
+    if (frozen->member_count > UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "%zu members exceed 32-bit adjacency rows",
+                             frozen->member_count);
+    }
+    frozen->neighbor_rows = malloc((nodes + 1U) * sizeof(uint32_t));
+    frozen->packed_rows = malloc((nodes + 1U) * sizeof(uint64_t));
+    METAGRAPH_CHECK_ALLOC(frozen->neighbor_rows);
+    METAGRAPH_CHECK_ALLOC(frozen->packed_rows);
+
+    // Worst case: four data bytes per target plus a partial control byte
+    // per list. Trimmed once the real size is known.
+    const size_t bound = frozen->member_count * 5U + nodes;
+    frozen->packed = malloc(bound + METAGRAPH_FROZEN_PAD);
+    METAGRAPH_CHECK_ALLOC(frozen->packed);
+    const size_t capacity = frozen->member_count + 1U;
+    uint32_t *scratch = malloc(capacity * sizeof(*scratch));
+    METAGRAPH_CHECK_ALLOC(scratch);
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    uint32_t neighbors = 0;
+    size_t offset = 0;
+    for (size_t node = 0; node < nodes; node++) {
+        size_t count = 0;
+        METAGRAPH_CHECK_GOTO(
+            metagraph_frozen_targets(frozen, (metagraph_node_index_t)node,
+                                     scratch, capacity, &count),
+            done);
+        frozen->neighbor_rows[node] = neighbors;
+        frozen->packed_rows[node] = offset;
+        offset += metagraph_frozen_encode(scratch, count,
+                                          frozen->packed + offset);
+        neighbors += (uint32_t)count;
+        if (count > frozen->max_degree) {
+            frozen->max_degree = (uint32_t)count;
+        }
+    }
+    frozen->neighbor_rows[nodes] = neighbors;
+    frozen->packed_rows[nodes] = offset;
+    frozen->packed_size = offset;
+
+    memset(frozen->packed + offset, 0, METAGRAPH_FROZEN_PAD);
+    uint8_t *packed = realloc(frozen->packed, offset + METAGRAPH_FROZEN_PAD);
+    if (packed) {
+        frozen->packed = packed;
+    }
+
+done:
+    free(scratch);
+    return result;
+}
+
+static metagraph_result_t
+metagraph_frozen_allocate(metagraph_frozen_graph_t **out_frozen) {
+    metagraph_frozen_init();
+    metagraph_frozen_graph_t *frozen = calloc(1, sizeof(*frozen));
+    METAGRAPH_CHECK_ALLOC(frozen);
+    *out_frozen = frozen;
+    return METAGRAPH_OK();
+}
+
+// Copy a node's linked incidence list into CSR form.
+static uint32_t metagraph_frozen_copy_list(const metagraph_graph_t *graph,
+                                           uint32_t head, uint32_t *list,
+                                           uint32_t at) {
+    for (uint32_t record = head; record != METAGRAPH_INVALID_INDEX;
+         record = graph->incidence_next[record]) {
+        list[at++] = graph->incidence_edge[record];
+    }
+    return at;
+}
+
+static metagraph_result_t
+metagraph_frozen_copy_graph(metagraph_frozen_graph_t *frozen,
+                            const metagraph_graph_t *graph) {
+    const size_t nodes = graph->node_count;
+    const size_t edges = graph->edge_count;
+    const size_t members = graph->member_count;
+    // Every edge is on its source's outgoing list and on one incoming list
+    // per target.
+    const size_t in_count = members - edges;
+    const size_t words = members + 2U * (nodes + 1U) + edges + in_count;
+    frozen->incidence_bytes =
+        edges * sizeof(metagraph_bundle_edge_record_t) + words * 4U;
+    frozen->incidence = malloc(frozen->incidence_bytes);
+    METAGRAPH_CHECK_ALLOC(frozen->incidence);
+
+    metagraph_bundle_edge_record_t *records = frozen->incidence;
+    uint32_t *member_list = (uint32_t *)(void *)(records + edges);
+    uint32_t *out_rows = member_list + members;
+    uint32_t *out_edges = out_rows + nodes + 1U;
+    uint32_t *in_rows = out_edges + edges;
+    uint32_t *in_edges = in_rows + nodes + 1U;
+
+    for (size_t edge = 0; edge < edges; edge++) {
+        records[edge] = (metagraph_bundle_edge_record_t){
+            .id = graph->edge_ids[edge],
+            .type = graph->edge_types[edge],
+            .weight = graph->edge_weights[edge],
+            .member_begin = graph->edge_member_begin[edge],
+            .member_count = graph->edge_member_count[edge],
+        };
+    }
+    if (members) {
+        memcpy(member_list, graph->members, members * sizeof(*member_list));
+    }
+    uint32_t out_at = 0;
+    uint32_t in_at = 0;
+    for (size_t node = 0; node < nodes; node++) {
+        out_rows[node] = out_at;
+        in_rows[node] = in_at;
+        out_at = metagraph_frozen_copy_list(graph, graph->node_out_head[node],
+                                            out_edges, out_at);
+        in_at = metagraph_frozen_copy_list(graph, graph->node_in_head[node],
+                                           in_edges, in_at);
+    }
+    out_rows[nodes] = out_at;
+    in_rows[nodes] = in_at;
+
+    frozen->node_count = nodes;
+    frozen->edge_count = edges;
+    frozen->member_count = members;
+    frozen->records = records;
+    frozen->members = member_list;
+    frozen->out_rows = out_rows;
+    frozen->out_edges = out_edges;
+    frozen->in_rows = in_rows;
+    frozen->in_edges = in_edges;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_frozen_graph_create(const metagraph_graph_t *graph,
+                              metagraph_frozen_graph_t **out_frozen) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_frozen);
+    metagraph_frozen_graph_t *frozen = NULL;
+    METAGRAPH_CHECK(metagraph_frozen_allocate(&frozen));
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(metagraph_frozen_copy_graph(frozen, graph), fail);
+    METAGRAPH_CHECK_GOTO(metagraph_frozen_pack(frozen), fail);
+    *out_frozen = frozen;
+    return METAGRAPH_OK();
+
+fail:
+    metagraph_frozen_graph_destroy(frozen);
+    return result;
+}
+
+// Each edge may only sit on its own source's out list, and only once, or
+// packing would gather more targets than the member array holds.
+static metagraph_result_t
+metagraph_frozen_check_sources(const metagraph_bundle_edge_arrays_t *arrays) {
+    bool *seen = calloc(arrays->edge_count + 1U, sizeof(*seen));
+    METAGRAPH_CHECK_ALLOC(seen);
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    for (size_t node = 0; node < arrays->node_count; node++) {
+        for (uint32_t i = arrays->out_rows[node];
+             i < arrays->out_rows[node + 1U]; i++) {
+            const uint32_t edge = arrays->out_edges[i];
+            const metagraph_bundle_edge_record_t *record =
+                &arrays->records[edge];
+            if (arrays->members[record->member_begin] != node) {
+                result = METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                       "Out list of node %zu names edge %u "
+                                       "of another source",
+                                       node, edge);
+                goto done;
+            }
+            // With the source fixed, a second sighting is a duplicate.
+            if (seen[edge]) {
+                result = METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                       "Out list of node %zu names edge %u "
+                                       "twice",
+                                       node, edge);
+                goto done;
+            }
+            seen[edge] = true;
+        }
+    }
+
+done:
+    free(seen);
+    return result;
+}
+
+// EDGES arrays come from a file: check every index before trusting them.
+static metagraph_result_t
+metagraph_frozen_validate(const metagraph_bundle_edge_arrays_t *arrays) {
+    for (size_t edge = 0; edge < arrays->edge_count; edge++) {
+        const metagraph_bundle_edge_record_t *record = &arrays->records[edge];
+        if (record->member_count == 0 ||
+            record->member_begin > arrays->member_count ||
+            record->member_count >
+                arrays->member_count - record->member_begin) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                 "Members of edge %zu escape the member array",
+                                 edge);
+        }
+    }
+    for (size_t i = 0; i < arrays->member_count; i++) {
+        if (arrays->members[i] >= arrays->node_count) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                 "Member %zu names node %u of %zu", i,
+                                 arrays->members[i], arrays->node_count);
+        }
+    }
+    const uint32_t *lists[2] = {arrays->out_edges, arrays->in_edges};
+    const size_t counts[2] = {arrays->out_count, arrays->in_count};
+    for (size_t list = 0; list < 2U; list++) {
+        for (size_t i = 0; i < counts[list]; i++) {
+            if (lists[list][i] >= arrays->edge_count) {
+                return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                                     "Adjacency entry %zu names edge %u of %zu",
+                                     i, lists[list][i], arrays->edge_count);
+            }
+        }
+    }
+    return metagraph_frozen_check_sources(arrays);
+}
+
+metagraph_result_t
+metagraph_frozen_graph_from_bundle(const metagraph_bundle_t *bundle,
+                                   metagraph_frozen_graph_t **out_frozen) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_frozen);
+    metagraph_bundle_edge_arrays_t arrays;
+    METAGRAPH_CHECK(metagraph_bundle_edge_arrays(bundle, &arrays));
+    METAGRAPH_CHECK(metagraph_frozen_validate(&arrays));
+
+    metagraph_frozen_graph_t *frozen = NULL;
+    METAGRAPH_CHECK(metagraph_frozen_allocate(&frozen));
+    frozen->node_count = arrays.node_count;
+    frozen->edge_count = arrays.edge_count;
+    frozen->member_count = arrays.member_count;
+    frozen->records = arrays.records;
+    frozen->members = arrays.members;
+    frozen->out_rows = arrays.out_rows;
+    frozen->out_edges = arrays.out_edges;
+    frozen->in_rows = arrays.in_rows;
+    frozen->in_edges = arrays.in_edges;
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(metagraph_frozen_pack(frozen), fail);
+    *out_frozen = frozen;
+    return METAGRAPH_OK();
+
+fail:
+    metagraph_frozen_graph_destroy(frozen);
+    return result;
+}
+
+void metagraph_frozen_graph_destroy(metagraph_frozen_graph_t *frozen) {
+    if (!frozen) {
+        return;
+    }
+    free(frozen->incidence);
+    free(frozen->neighbor_rows);
+    free(frozen->packed_rows);
+    free(frozen->packed);
+    free(frozen);
+}
+
+// ============================================================================
+// Accessors
+// ============================================================================
+
+// Decode node's adjacency into out; returns its length.
+static size_t metagraph_frozen_decode(const metagraph_frozen_graph_t *frozen,
+                                      metagraph_node_index_t node,
+                                      uint32_t *out) {
+    const size_t count =
+        frozen->neighbor_rows[node + 1U] - frozen->neighbor_rows[node];
+    metagraph_frozen_tables.decode(frozen->packed + frozen->packed_rows[node],
+                                   count, out);
+    return count;
+}
+
+metagraph_result_t
+metagraph_frozen_graph_neighbors(const metagraph_frozen_graph_t *frozen,
+                                 metagraph_node_index_t node,
+                                 metagraph_node_index_t *out_nodes,
+                                 size_t capacity, size_t *out_count) {
+    METAGRAPH_CHECK_NULL(frozen);
+    METAGRAPH_CHECK_NULL(out_count);
+    if (node >= frozen->node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node index %u out of range", node);
+    }
+    const size_t count =
+        frozen->neighbor_rows[node + 1U] - frozen->neighbor_rows[node];
+    *out_count = count;
+    if (!out_nodes) {
+        return METAGRAPH_OK();
+    }
+    if (count > capacity) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUFFER_TOO_SMALL,
+                             "Need room for %zu neighbors, have %zu", count,
+                             capacity);
+    }
+    (void)metagraph_frozen_decode(frozen, node, out_nodes);
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_frozen_incidence(const metagraph_frozen_graph_t *frozen,
+                           metagraph_node_index_t node, bool outgoing,
+                           const metagraph_edge_index_t **out_edges,
+                           size_t *out_count) {
+    METAGRAPH_CHECK_NULL(frozen);
+    METAGRAPH_CHECK_NULL(out_edges);
+    METAGRAPH_CHECK_NULL(out_count);
+    if (node >= frozen->node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node index %u out of range", node);
+    }
+    const uint32_t *rows = outgoing ? frozen->out_rows : frozen->in_rows;
+    const uint32_t *list = outgoing ? frozen->out_edges : frozen->in_edges;
+    *out_edges = list + rows[node];
+    *out_count = rows[node + 1U] - rows[node];
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_frozen_graph_outgoing_edges(
+    const metagraph_frozen_graph_t *frozen, metagraph_node_index_t node,
+    const metagraph_edge_index_t **out_edges, size_t *out_count) {
+    return metagraph_frozen_incidence(frozen, node, true, out_edges,
+                                      out_count);
+}
+
+metagraph_result_t metagraph_frozen_graph_incoming_edges(
+    const metagraph_frozen_graph_t *frozen, metagraph_node_index_t node,
+    const metagraph_edge_index_t **out_edges, size_t *out_count) {
+    return metagraph_frozen_incidence(frozen, node, false, out_edges,
+                                      out_count);
+}
+
+metagraph_result_t metagraph_frozen_graph_edge_nodes(
+    const metagraph_frozen_graph_t *frozen, metagraph_edge_index_t edge,
+    const metagraph_node_index_t **out_nodes, size_t *out_count) {
+    METAGRAPH_CHECK_NULL(frozen);
+    METAGRAPH_CHECK_NULL(out_nodes);
+    METAGRAPH_CHECK_NULL(out_count);
+    if (edge >= frozen->edge_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_EDGE_NOT_FOUND,
+                             "Edge index %u out of range", edge);
+    }
+    const metagraph_bundle_edge_record_t *record = &frozen->records[edge];
+    *out_nodes = frozen->members + record->member_begin;
+    *out_count = record->member_count;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_frozen_graph_get_stats(const metagraph_frozen_graph_t *frozen,
+                                 metagraph_frozen_stats_t *out_stats) {
+    METAGRAPH_CHECK_NULL(frozen);
+    METAGRAPH_CHECK_NULL(out_stats);
+    const size_t rows = frozen->node_count + 1U;
+    *out_stats = (metagraph_frozen_stats_t){
+        .node_count = frozen->node_count,
+        .edge_count = frozen->edge_count,
+        .member_count = frozen->member_count,
+        .neighbor_count = frozen->neighbor_rows[frozen->node_count],
+        .packed_bytes = frozen->packed_size,
+        .memory_bytes = sizeof(*frozen) + frozen->incidence_bytes +
+                        rows * (sizeof(uint32_t) + sizeof(uint64_t)) +
+                        frozen->packed_size + METAGRAPH_FROZEN_PAD,
+        .max_degree = frozen->max_degree,
+        .simd_decode = metagraph_frozen_tables.simd,
+    };
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Traversal
+// ============================================================================
+
+metagraph_result_t
+metagraph_frozen_traverse_bfs(const metagraph_frozen_graph_t *frozen,
+                              metagraph_node_index_t start, uint32_t max_depth,
+                              uint32_t *out_distance, size_t *out_reached) {
+    METAGRAPH_CHECK_NULL(frozen);
+    METAGRAPH_CHECK_NULL(out_distance);
+    if (start >= frozen->node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Start node %u out of range", start);
+    }
+    METAGRAPH_PROBE2(traverse__start, 2, start);
+    METAGRAPH_SPAN_BEGIN(span, "frozen_bfs", start);
+    const uint64_t started = metagraph_monotonic_ns();
+    metagraph_node_index_t *queue =
+        malloc(frozen->node_count * sizeof(*queue));
+    METAGRAPH_CHECK_ALLOC(queue);
+    metagraph_node_index_t *neighbors =
+        malloc(((size_t)frozen->max_degree + 1U) * sizeof(*neighbors));
+    if (!neighbors) {
+        free(queue);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate %u-entry neighbor buffer",
+                             frozen->max_degree + 1U);
+    }
+
+    memset(out_distance, 0xFF, frozen->node_count * sizeof(*out_distance));
+    out_distance[start] = 0;
+    queue[0] = start;
+    size_t head = 0;
+    size_t tail = 1;
+    while (head < tail) {
+        const metagraph_node_index_t node = queue[head++];
+        const uint32_t depth = out_distance[node];
+        if (max_depth != 0 && depth >= max_depth) {
+            continue;
+        }
+        const size_t count = metagraph_frozen_decode(frozen, node, neighbors);
+        for (size_t i = 0; i < count; i++) {
+            const metagraph_node_index_t target = neighbors[i];
+            if (out_distance[target] == UINT32_MAX) {
+                out_distance[target] = depth + 1U;
+                queue[tail++] = target;
+            }
+        }
+    }
+    free(neighbors);
+    free(queue);
+    if (out_reached) {
+        *out_reached = tail;
+    }
+    metagraph_metrics_add(METAGRAPH_COUNTER_TRAVERSAL_STEPS, tail);
+    metagraph_metrics_record(METAGRAPH_HISTOGRAM_TRAVERSAL,
+                             metagraph_monotonic_ns() - started);
+    METAGRAPH_SPAN_END(span);
+    METAGRAPH_PROBE3(traverse__done, 2, tail, (int)METAGRAPH_SUCCESS);
+    return METAGRAPH_OK();
+}
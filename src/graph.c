@@ -0,0 +1,616 @@
+/**
+ * @file graph.c
+ * @brief Structure-of-arrays metagraph store
+ *
+ * Nodes and hyperedges are kept as parallel arrays indexed by their dense
+ * index. Adjacency is stored as singly linked incidence lists threaded
+ * through two flat arrays (edge, next), with head/tail arrays per node, so
+ * appending an edge never reallocates per-node storage and enumeration keeps
+ * insertion order.
+ */
+
+#include "metagraph/graph.h"
+#include "metagraph/memory.h"
+#include "metagraph/result.h"
+
+#include "graph_internal.h"
+#include "id_index.h"
+#include "metrics_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METAGRAPH_GRAPH_DEFAULT_CAPACITY 64U
+#define METAGRAPH_NAME_BLOCK_SIZE 4096U
+
+typedef struct {
+    void **array;
+    size_t element_size;
+} metagraph_graph_column_t;
+
+// Grow every column to new_capacity; columns keep their old contents on
+// failure, so the caller's capacity field is only updated on success.
+static metagraph_result_t
+metagraph_graph_grow_columns(const metagraph_graph_column_t *columns,
+                             size_t column_count, size_t new_capacity) {
+    for (size_t i = 0; i < column_count; i++) {
+        void *grown =
+            realloc(*columns[i].array, new_capacity * columns[i].element_size);
+        if (!grown) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                 "Failed to grow graph storage to %zu entries",
+                                 new_capacity);
+        }
+        *columns[i].array = grown;
+    }
+    return METAGRAPH_OK();
+}
+
+static size_t metagraph_graph_next_capacity(size_t current, size_t required) {
+    size_t capacity = current ? current : METAGRAPH_GRAPH_DEFAULT_CAPACITY;
+    while (capacity < required) {
+        capacity *= 2U;
+    }
+    return capacity;
+}
+
+static metagraph_result_t metagraph_graph_reserve_nodes(metagraph_graph_t *graph,
+                                                        size_t required) {
+    if (required <= graph->node_capacity) {
+        return METAGRAPH_OK();
+    }
+    const size_t capacity =
+        metagraph_graph_next_capacity(graph->node_capacity, required);
+    const metagraph_graph_column_t columns[] = {
+        {(void **)&graph->node_ids, sizeof(*graph->node_ids)},
+        {(void **)&graph->node_types, sizeof(*graph->node_types)},
+        {(void **)&graph->node_hashes, sizeof(*graph->node_hashes)},
+        {(void **)&graph->node_data_sizes, sizeof(*graph->node_data_sizes)},
+        {(void **)&graph->node_data, sizeof(*graph->node_data)},
+        {(void **)&graph->node_names, sizeof(*graph->node_names)},
+        {(void **)&graph->node_out_head, sizeof(*graph->node_out_head)},
+        {(void **)&graph->node_out_tail, sizeof(*graph->node_out_tail)},
+        {(void **)&graph->node_in_head, sizeof(*graph->node_in_head)},
+        {(void **)&graph->node_in_tail, sizeof(*graph->node_in_tail)},
+    };
+    METAGRAPH_CHECK(metagraph_graph_grow_columns(
+        columns, sizeof(columns) / sizeof(columns[0]), capacity));
+    graph->node_capacity = capacity;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t metagraph_graph_reserve_edges(metagraph_graph_t *graph,
+                                                        size_t required) {
+    if (required <= graph->edge_capacity) {
+        return METAGRAPH_OK();
+    }
+    const size_t capacity =
+        metagraph_graph_next_capacity(graph->edge_capacity, required);
+    const metagraph_graph_column_t columns[] = {
+        {(void **)&graph->edge_ids, sizeof(*graph->edge_ids)},
+        {(void **)&graph->edge_types, sizeof(*graph->edge_types)},
+        {(void **)&graph->edge_weights, sizeof(*graph->edge_weights)},
+        {(void **)&graph->edge_properties, sizeof(*graph->edge_properties)},
+        {(void **)&graph->edge_member_begin, sizeof(*graph->edge_member_begin)},
+        {(void **)&graph->edge_member_count, sizeof(*graph->edge_member_count)},
+    };
+    METAGRAPH_CHECK(metagraph_graph_grow_columns(
+        columns, sizeof(columns) / sizeof(columns[0]), capacity));
+    graph->edge_capacity = capacity;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_graph_reserve_members(metagraph_graph_t *graph, size_t additional) {
+    const size_t required = graph->member_count + additional;
+    if (required > UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_MAX_EDGES_EXCEEDED,
+                             "Edge membership storage exceeds %u entries",
+                             UINT32_MAX);
+    }
+    if (required > graph->member_capacity) {
+        const size_t capacity =
+            metagraph_graph_next_capacity(graph->member_capacity, required);
+        const metagraph_graph_column_t member_columns[] = {
+            {(void **)&graph->members, sizeof(*graph->members)},
+        };
+        METAGRAPH_CHECK(metagraph_graph_grow_columns(member_columns, 1, capacity));
+        graph->member_capacity = capacity;
+    }
+    const size_t incidence_required = graph->incidence_count + additional;
+    if (incidence_required > graph->incidence_capacity) {
+        const size_t capacity = metagraph_graph_next_capacity(
+            graph->incidence_capacity, incidence_required);
+        const metagraph_graph_column_t incidence_columns[] = {
+            {(void **)&graph->incidence_edge, sizeof(*graph->incidence_edge)},
+            {(void **)&graph->incidence_next, sizeof(*graph->incidence_next)},
+        };
+        METAGRAPH_CHECK(
+            metagraph_graph_grow_columns(incidence_columns, 2, capacity));
+        graph->incidence_capacity = capacity;
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t metagraph_graph_copy_name(metagraph_graph_t *graph,
+                                                    const char *name,
+                                                    const char **out_copy) {
+    *out_copy = NULL;
+    if (!name) {
+        return METAGRAPH_OK();
+    }
+    const size_t length = strlen(name) + 1U;
+    void *storage = NULL;
+    METAGRAPH_CHECK(
+        metagraph_memory_pool_aligned_alloc(graph->names, length, 1, &storage));
+    char *copy = storage;
+    memcpy(copy, name, length);
+    *out_copy = copy;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_graph_create(const metagraph_graph_config_t *config,
+                                          metagraph_graph_t **out_graph) {
+    METAGRAPH_CHECK_NULL(out_graph);
+    *out_graph = NULL;
+
+    const metagraph_graph_config_t defaults = {0};
+    if (!config) {
+        config = &defaults;
+    }
+    if (config->max_nodes > METAGRAPH_GRAPH_MAX_NODES ||
+        config->max_edges > METAGRAPH_GRAPH_MAX_EDGES) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Graph limits exceed the 32-bit index space");
+    }
+
+    metagraph_graph_t *graph = calloc(1, sizeof(*graph));
+    METAGRAPH_CHECK_ALLOC(graph);
+    graph->max_nodes = config->max_nodes ? config->max_nodes
+                                         : METAGRAPH_GRAPH_MAX_NODES;
+    graph->max_edges = config->max_edges ? config->max_edges
+                                         : METAGRAPH_GRAPH_MAX_EDGES;
+
+    const size_t node_capacity = config->initial_node_capacity
+                                     ? config->initial_node_capacity
+                                     : METAGRAPH_GRAPH_DEFAULT_CAPACITY;
+    const size_t edge_capacity = config->initial_edge_capacity
+                                     ? config->initial_edge_capacity
+                                     : METAGRAPH_GRAPH_DEFAULT_CAPACITY;
+
+    const metagraph_pool_config_t names_config = {
+        .type = METAGRAPH_POOL_TYPE_ARENA,
+        .initial_size = METAGRAPH_NAME_BLOCK_SIZE,
+        .allow_growth = true,
+    };
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(
+        metagraph_memory_pool_create(&names_config, &graph->names), fail);
+    METAGRAPH_CHECK_GOTO(metagraph_graph_reserve_nodes(graph, node_capacity),
+                         fail);
+    METAGRAPH_CHECK_GOTO(metagraph_graph_reserve_edges(graph, edge_capacity),
+                         fail);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_id_index_init(&graph->node_index, node_capacity), fail);
+    METAGRAPH_CHECK_GOTO(
+        metagraph_id_index_init(&graph->edge_index, edge_capacity), fail);
+
+    *out_graph = graph;
+    return METAGRAPH_OK();
+
+fail:
+    (void)metagraph_graph_destroy(graph);
+    return result;
+}
+
+metagraph_result_t metagraph_graph_destroy(metagraph_graph_t *graph) {
+    if (!graph) {
+        return METAGRAPH_OK();
+    }
+
+    free(graph->node_ids);
+    free(graph->node_types);
+    free(graph->node_hashes);
+    free(graph->node_data_sizes);
+    free(graph->node_data);
+    free((void *)graph->node_names);
+    free(graph->node_out_head);
+    free(graph->node_out_tail);
+    free(graph->node_in_head);
+    free(graph->node_in_tail);
+
+    free(graph->edge_ids);
+    free(graph->edge_types);
+    free(graph->edge_weights);
+    free(graph->edge_properties);
+    free(graph->edge_member_begin);
+    free(graph->edge_member_count);
+    free(graph->members);
+    free(graph->incidence_edge);
+    free(graph->incidence_next);
+
+    (void)metagraph_memory_pool_destroy(graph->names);
+
+    metagraph_id_index_destroy(&graph->node_index);
+    metagraph_id_index_destroy(&graph->edge_index);
+    free(graph);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_graph_add_node(metagraph_graph_t *graph,
+                         const metagraph_node_metadata_t *metadata,
+                         metagraph_node_index_t *out_index) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(metadata);
+
+    if (graph->node_count >= graph->max_nodes) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_MAX_NODES_EXCEEDED,
+                             "Graph already holds %zu nodes",
+                             graph->node_count);
+    }
+    METAGRAPH_CHECK(metagraph_graph_reserve_nodes(graph, graph->node_count + 1U));
+
+    const metagraph_node_index_t node = (metagraph_node_index_t)graph->node_count;
+    bool inserted = false;
+    METAGRAPH_CHECK(metagraph_id_index_insert(&graph->node_index, metadata->id,
+                                              node, &inserted));
+    if (!inserted) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_EXISTS,
+                             "Node %016llx%016llx already exists",
+                             (unsigned long long)metadata->id.high,
+                             (unsigned long long)metadata->id.low);
+    }
+
+    const char *name = NULL;
+    metagraph_result_t result =
+        metagraph_graph_copy_name(graph, metadata->name, &name);
+    if (metagraph_result_is_error(result)) {
+        (void)metagraph_id_index_erase(&graph->node_index, metadata->id);
+        return result;
+    }
+
+    graph->node_ids[node] = metadata->id;
+    graph->node_types[node] = metadata->type;
+    graph->node_hashes[node] = metadata->hash;
+    graph->node_data_sizes[node] = metadata->data_size;
+    graph->node_data[node] = metadata->data;
+    graph->node_names[node] = name;
+    graph->node_out_head[node] = METAGRAPH_INVALID_INDEX;
+    graph->node_out_tail[node] = METAGRAPH_INVALID_INDEX;
+    graph->node_in_head[node] = METAGRAPH_INVALID_INDEX;
+    graph->node_in_tail[node] = METAGRAPH_INVALID_INDEX;
+    graph->node_count++;
+
+    if (out_index) {
+        *out_index = node;
+    }
+    return METAGRAPH_OK();
+}
+
+// Append edge to the incidence list rooted at head/tail[node]
+static void metagraph_graph_link_incidence(metagraph_graph_t *graph,
+                                           uint32_t *head, uint32_t *tail,
+                                           metagraph_node_index_t node,
+                                           metagraph_edge_index_t edge) {
+    const uint32_t record = (uint32_t)graph->incidence_count++;
+    graph->incidence_edge[record] = edge;
+    graph->incidence_next[record] = METAGRAPH_INVALID_INDEX;
+    if (tail[node] == METAGRAPH_INVALID_INDEX) {
+        head[node] = record;
+    } else {
+        graph->incidence_next[tail[node]] = record;
+    }
+    tail[node] = record;
+}
+
+static metagraph_result_t
+metagraph_graph_validate_edge(const metagraph_graph_t *graph,
+                              const metagraph_edge_metadata_t *metadata) {
+    if (metadata->node_count < 2U || !metadata->nodes) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Hyperedge needs at least 2 nodes, got %zu",
+                             metadata->node_count);
+    }
+    if (graph->edge_count >= graph->max_edges) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_MAX_EDGES_EXCEEDED,
+                             "Graph already holds %zu edges",
+                             graph->edge_count);
+    }
+    uint32_t existing = 0;
+    if (metagraph_id_index_find(&graph->edge_index, metadata->id, &existing)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_EDGE_EXISTS,
+                             "Edge %016llx%016llx already exists",
+                             (unsigned long long)metadata->id.high,
+                             (unsigned long long)metadata->id.low);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_graph_add_edge(metagraph_graph_t *graph,
+                         const metagraph_edge_metadata_t *metadata,
+                         metagraph_edge_index_t *out_index) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(metadata);
+    METAGRAPH_CHECK(metagraph_graph_validate_edge(graph, metadata));
+    METAGRAPH_CHECK(metagraph_graph_reserve_edges(graph, graph->edge_count + 1U));
+    METAGRAPH_CHECK(metagraph_graph_reserve_members(graph, metadata->node_count));
+
+    // Resolve every member before mutating anything.
+    metagraph_node_index_t *members = graph->members + graph->member_count;
+    for (size_t i = 0; i < metadata->node_count; i++) {
+        if (!metagraph_id_index_find(&graph->node_index, metadata->nodes[i],
+                                     &members[i])) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                                 "Edge member %zu (%016llx%016llx) not found",
+                                 i, (unsigned long long)metadata->nodes[i].high,
+                                 (unsigned long long)metadata->nodes[i].low);
+        }
+    }
+
+    const metagraph_edge_index_t edge = (metagraph_edge_index_t)graph->edge_count;
+    bool inserted = false;
+    METAGRAPH_CHECK(metagraph_id_index_insert(&graph->edge_index, metadata->id,
+                                              edge, &inserted));
+
+    graph->edge_ids[edge] = metadata->id;
+    graph->edge_types[edge] = metadata->type;
+    graph->edge_weights[edge] = metadata->weight;
+    graph->edge_properties[edge] = metadata->properties;
+    graph->edge_member_begin[edge] = (uint32_t)graph->member_count;
+    graph->edge_member_count[edge] = (uint32_t)metadata->node_count;
+    graph->member_count += metadata->node_count;
+    graph->edge_count++;
+
+    metagraph_graph_link_incidence(graph, graph->node_out_head,
+                                   graph->node_out_tail, members[0], edge);
+    for (size_t i = 1; i < metadata->node_count; i++) {
+        metagraph_graph_link_incidence(graph, graph->node_in_head,
+                                       graph->node_in_tail, members[i], edge);
+    }
+
+    if (out_index) {
+        *out_index = edge;
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_graph_find_node(const metagraph_graph_t *graph,
+                                             metagraph_id_t node_id,
+                                             metagraph_node_index_t *out_index) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_index);
+    metagraph_metrics_add(METAGRAPH_COUNTER_LOOKUPS, 1U);
+    if (!metagraph_id_index_find(&graph->node_index, node_id, out_index)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node %016llx%016llx not found",
+                             (unsigned long long)node_id.high,
+                             (unsigned long long)node_id.low);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_graph_find_edge(const metagraph_graph_t *graph,
+                                             metagraph_id_t edge_id,
+                                             metagraph_edge_index_t *out_index) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_index);
+    metagraph_metrics_add(METAGRAPH_COUNTER_LOOKUPS, 1U);
+    if (!metagraph_id_index_find(&graph->edge_index, edge_id, out_index)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_EDGE_NOT_FOUND,
+                             "Edge %016llx%016llx not found",
+                             (unsigned long long)edge_id.high,
+                             (unsigned long long)edge_id.low);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_graph_find_nodes(
+    const metagraph_graph_t *graph, const metagraph_id_t *node_ids,
+    size_t count, metagraph_node_index_t *out_indices, size_t *out_found) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(node_ids);
+    METAGRAPH_CHECK_NULL(out_indices);
+    metagraph_metrics_add(METAGRAPH_COUNTER_LOOKUPS, count);
+    const size_t found = metagraph_id_index_find_batch(
+        &graph->node_index, node_ids, count, out_indices);
+    if (out_found) {
+        *out_found = found;
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_graph_find_edges(
+    const metagraph_graph_t *graph, const metagraph_id_t *edge_ids,
+    size_t count, metagraph_edge_index_t *out_indices, size_t *out_found) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(edge_ids);
+    METAGRAPH_CHECK_NULL(out_indices);
+    metagraph_metrics_add(METAGRAPH_COUNTER_LOOKUPS, count);
+    const size_t found = metagraph_id_index_find_batch(
+        &graph->edge_index, edge_ids, count, out_indices);
+    if (out_found) {
+        *out_found = found;
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_graph_get_node(const metagraph_graph_t *graph,
+                         metagraph_node_index_t node,
+                         metagraph_node_metadata_t *out_metadata) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_metadata);
+    if (node >= graph->node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node index %u out of range", node);
+    }
+    out_metadata->id = graph->node_ids[node];
+    out_metadata->name = graph->node_names[node];
+    out_metadata->type = graph->node_types[node];
+    out_metadata->data_size = graph->node_data_sizes[node];
+    out_metadata->data = graph->node_data[node];
+    out_metadata->hash = graph->node_hashes[node];
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_graph_get_edge(const metagraph_graph_t *graph,
+                         metagraph_edge_index_t edge,
+                         metagraph_edge_metadata_t *out_metadata) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_metadata);
+    if (edge >= graph->edge_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_EDGE_NOT_FOUND,
+                             "Edge index %u out of range", edge);
+    }
+    out_metadata->id = graph->edge_ids[edge];
+    out_metadata->type = graph->edge_types[edge];
+    out_metadata->weight = graph->edge_weights[edge];
+    out_metadata->node_count = graph->edge_member_count[edge];
+    out_metadata->nodes = NULL;
+    out_metadata->properties = graph->edge_properties[edge];
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_graph_get_edge_nodes(const metagraph_graph_t *graph,
+                               metagraph_edge_index_t edge,
+                               const metagraph_node_index_t **out_nodes,
+                               size_t *out_count) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_nodes);
+    METAGRAPH_CHECK_NULL(out_count);
+    if (edge >= graph->edge_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_EDGE_NOT_FOUND,
+                             "Edge index %u out of range", edge);
+    }
+    *out_nodes = graph->members + graph->edge_member_begin[edge];
+    *out_count = graph->edge_member_count[edge];
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_graph_collect_incidence(const metagraph_graph_t *graph,
+                                  uint32_t head, metagraph_edge_index_t *out_edges,
+                                  size_t capacity, size_t *out_count) {
+    size_t count = 0;
+    for (uint32_t record = head; record != METAGRAPH_INVALID_INDEX;
+         record = graph->incidence_next[record]) {
+        if (out_edges && count < capacity) {
+            out_edges[count] = graph->incidence_edge[record];
+        }
+        count++;
+    }
+    *out_count = count;
+    if (out_edges && count > capacity) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUFFER_TOO_SMALL,
+                             "Need room for %zu edges, have %zu", count,
+                             capacity);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_graph_get_outgoing_edges(const metagraph_graph_t *graph,
+                                   metagraph_node_index_t node,
+                                   metagraph_edge_index_t *out_edges,
+                                   size_t capacity, size_t *out_count) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_count);
+    if (node >= graph->node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node index %u out of range", node);
+    }
+    return metagraph_graph_collect_incidence(graph, graph->node_out_head[node],
+                                             out_edges, capacity, out_count);
+}
+
+metagraph_result_t
+metagraph_graph_get_incoming_edges(const metagraph_graph_t *graph,
+                                   metagraph_node_index_t node,
+                                   metagraph_edge_index_t *out_edges,
+                                   size_t capacity, size_t *out_count) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_count);
+    if (node >= graph->node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Node index %u out of range", node);
+    }
+    return metagraph_graph_collect_incidence(graph, graph->node_in_head[node],
+                                             out_edges, capacity, out_count);
+}
+
+size_t metagraph_graph_node_count(const metagraph_graph_t *graph) {
+    return graph ? graph->node_count : 0;
+}
+
+size_t metagraph_graph_edge_count(const metagraph_graph_t *graph) {
+    return graph ? graph->edge_count : 0;
+}
+
+metagraph_result_t metagraph_graph_get_stats(const metagraph_graph_t *graph,
+                                             metagraph_graph_stats_t *out_stats) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_stats);
+
+    const size_t node_row = sizeof(metagraph_id_t) + sizeof(uint32_t) +
+                            sizeof(uint64_t) + sizeof(size_t) +
+                            sizeof(void *) + sizeof(const char *) +
+                            4U * sizeof(uint32_t);
+    const size_t edge_row = sizeof(metagraph_id_t) + sizeof(uint32_t) +
+                            sizeof(float) + sizeof(void *) +
+                            2U * sizeof(uint32_t);
+
+    metagraph_pool_stats_t names_stats;
+    METAGRAPH_CHECK(metagraph_memory_pool_get_stats(graph->names, &names_stats));
+
+    out_stats->node_count = graph->node_count;
+    out_stats->edge_count = graph->edge_count;
+    out_stats->incidence_count = graph->incidence_count;
+    out_stats->index_capacity = graph->node_index.capacity;
+    out_stats->memory_bytes =
+        sizeof(*graph) + graph->node_capacity * node_row +
+        graph->edge_capacity * edge_row +
+        graph->member_capacity * sizeof(metagraph_node_index_t) +
+        graph->incidence_capacity * 2U * sizeof(uint32_t) +
+        names_stats.total_size +
+        metagraph_id_index_memory(&graph->node_index) +
+        metagraph_id_index_memory(&graph->edge_index);
+    return METAGRAPH_OK();
+}
+
+// Append as much of text as fits, keeping message NUL-terminated.
+static size_t metagraph_graph_append_text(char *message, size_t size,
+                                          size_t used, const char *text) {
+    while (*text && used + 1U < size) {
+        message[used++] = *text++;
+    }
+    message[used] = '\0';
+    return used;
+}
+
+void metagraph_graph_format_cycle(const metagraph_graph_t *graph,
+                                  const metagraph_node_index_t *cycle,
+                                  size_t count, char *message, size_t size) {
+    size_t used = 0;
+    message[0] = '\0';
+    for (size_t i = 0; i <= count; i++) {
+        const metagraph_node_index_t node = cycle[i % count];
+        if (i) {
+            used = metagraph_graph_append_text(message, size, used, " -> ");
+        }
+        const char *label = graph->node_names[node];
+        char hex[33];
+        if (!label) {
+            (void)snprintf(hex, sizeof(hex), "%016llx%016llx",
+                           (unsigned long long)graph->node_ids[node].high,
+                           (unsigned long long)graph->node_ids[node].low);
+            label = hex;
+        }
+        used = metagraph_graph_append_text(message, size, used, label);
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file graph_internal.h
+ * @brief Graph storage layout shared with traversal and dependency tracking
+ *
+ * Both walk the incidence lists and membership arrays directly
+ * rather than copying them out through the public accessors.
+ */
+
+#ifndef SRC_GRAPH_INTERNAL_H
+#define SRC_GRAPH_INTERNAL_H
+
+#include "metagraph/graph.h"
+#include "metagraph/memory.h"
+
+#include "id_index.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct metagraph_graph {
+    size_t max_nodes;
+    size_t max_edges;
+
+    // Node store
+    size_t node_count;
+    size_t node_capacity;
+    metagraph_id_t *node_ids;
+    uint32_t *node_types;
+    uint64_t *node_hashes;
+    size_t *node_data_sizes;
+    void **node_data;
+    const char **node_names;
+    uint32_t *node_out_head;
+    uint32_t *node_out_tail;
+    uint32_t *node_in_head;
+    uint32_t *node_in_tail;
+
+    // Hyperedge store
+    size_t edge_count;
+    size_t edge_capacity;
+    metagraph_id_t *edge_ids;
+    uint32_t *edge_types;
+    float *edge_weights;
+    void **edge_properties;
+    uint32_t *edge_member_begin;
+    uint32_t *edge_member_count;
+
+    // Edge membership (node indices, source first)
+    size_t member_count;
+    size_t member_capacity;
+    metagraph_node_index_t *members;
+
+    // Incidence lists
+    size_t incidence_count;
+    size_t incidence_capacity;
+    metagraph_edge_index_t *incidence_edge;
+    uint32_t *incidence_next;
+
+    // Graph-owned string storage. Arena blocks are never reallocated, so
+    // name pointers handed out by metagraph_graph_get_node() stay stable.
+    metagraph_memory_pool_t *names;
+
+    metagraph_id_index_t node_index;
+    metagraph_id_index_t edge_index;
+};
+
+/**
+ * @brief Source node of a hyperedge
+ */
+static inline metagraph_node_index_t
+metagraph_graph_edge_source(const metagraph_graph_t *graph,
+                            metagraph_edge_index_t edge) {
+    return graph->members[graph->edge_member_begin[edge]];
+}
+
+/**
+ * @brief Render a cycle as "a -> b -> ... -> a" for error messages
+ *
+ * Nodes are labelled by name, or by hex ID when unnamed. The text is
+ * truncated to fit `size` bytes and is always NUL-terminated.
+ */
+void metagraph_graph_format_cycle(const metagraph_graph_t *graph,
+                                  const metagraph_node_index_t *cycle,
+                                  size_t count, char *message, size_t size);
+
+#endif // SRC_GRAPH_INTERNAL_H
@@ -0,0 +1,329 @@
+/**
+ * @file id_index.c
+ * @brief Open-addressing ID -> index table with SIMD group probing
+ *
+ * Probing walks groups of METAGRAPH_ID_INDEX_GROUP control bytes in
+ * triangular order. A hit costs one control-group load plus one slot load;
+ * a miss usually stops at the first group because it contains an EMPTY byte.
+ */
+
+#include "id_index.h"
+#include "platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define METAGRAPH_ID_CTRL_EMPTY ((int8_t)-128)
+#define METAGRAPH_ID_CTRL_DELETED ((int8_t)-2)
+
+// Keep the table at most 7/8 full so every probe sequence meets an EMPTY.
+#define METAGRAPH_ID_INDEX_MAX_LOAD(capacity) ((capacity) - ((capacity) / 8U))
+
+// Bitmask of bytes in the group equal to tag (bit i = byte i)
+static inline uint32_t metagraph_id_group_match(const int8_t *group_ctrl,
+                                                int8_t tag) {
+#if defined(__SSE2__)
+    __m128i group;
+    memcpy(&group, group_ctrl, sizeof(group));
+    return (uint32_t)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < METAGRAPH_ID_INDEX_GROUP; i++) {
+        if (group_ctrl[i] == tag) {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+// Bitmask of EMPTY or DELETED bytes (both have the sign bit set)
+static inline uint32_t metagraph_id_group_match_free(const int8_t *group_ctrl) {
+#if defined(__SSE2__)
+    __m128i group;
+    memcpy(&group, group_ctrl, sizeof(group));
+    return (uint32_t)_mm_movemask_epi8(group);
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < METAGRAPH_ID_INDEX_GROUP; i++) {
+        if (group_ctrl[i] < 0) {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+static inline int8_t metagraph_id_hash_tag(uint64_t hash) {
+    return (int8_t)(hash & 0x7FU);
+}
+
+static inline size_t metagraph_id_hash_start(uint64_t hash, size_t capacity) {
+    return (size_t)(hash >> 7U) & (capacity - 1U);
+}
+
+static inline void metagraph_id_set_ctrl(metagraph_id_index_t *index,
+                                         size_t slot, int8_t value) {
+    index->ctrl[slot] = value;
+    if (slot < METAGRAPH_ID_INDEX_GROUP) {
+        index->ctrl[index->capacity + slot] = value;
+    }
+}
+
+static size_t metagraph_id_capacity_for(size_t expected_count) {
+    size_t capacity = METAGRAPH_ID_INDEX_GROUP;
+    while (METAGRAPH_ID_INDEX_MAX_LOAD(capacity) < expected_count) {
+        capacity *= 2U;
+    }
+    return capacity;
+}
+
+static metagraph_result_t metagraph_id_index_alloc(metagraph_id_index_t *index,
+                                                   size_t capacity) {
+    int8_t *ctrl = malloc(capacity + METAGRAPH_ID_INDEX_GROUP);
+    metagraph_id_slot_t *slots = malloc(capacity * sizeof(*slots));
+    if (!ctrl || !slots) {
+        free(ctrl);
+        free(slots);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate ID index with %zu slots",
+                             capacity);
+    }
+    memset(ctrl, METAGRAPH_ID_CTRL_EMPTY, capacity + METAGRAPH_ID_INDEX_GROUP);
+    index->ctrl = ctrl;
+    index->slots = slots;
+    index->capacity = capacity;
+    index->count = 0;
+    index->growth_left = METAGRAPH_ID_INDEX_MAX_LOAD(capacity);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_id_index_init(metagraph_id_index_t *index,
+                                           size_t expected_count) {
+    METAGRAPH_CHECK_NULL(index);
+    return metagraph_id_index_alloc(index,
+                                    metagraph_id_capacity_for(expected_count));
+}
+
+void metagraph_id_index_destroy(metagraph_id_index_t *index) {
+    if (!index) {
+        return;
+    }
+    free(index->ctrl);
+    free(index->slots);
+    memset(index, 0, sizeof(*index));
+}
+
+// Returns the slot holding id, or capacity if absent
+static size_t metagraph_id_probe(const int8_t *ctrl,
+                                 const metagraph_id_slot_t *slots,
+                                 size_t capacity, metagraph_id_t id,
+                                 uint64_t hash) {
+    const size_t mask = capacity - 1U;
+    const int8_t tag = metagraph_id_hash_tag(hash);
+    size_t pos = metagraph_id_hash_start(hash, capacity);
+
+    for (size_t stride = METAGRAPH_ID_INDEX_GROUP;;
+         stride += METAGRAPH_ID_INDEX_GROUP) {
+        const int8_t *group = ctrl + pos;
+        uint32_t hits = metagraph_id_group_match(group, tag);
+        while (hits) {
+            size_t slot = (pos + (size_t)__builtin_ctz(hits)) & mask;
+            if (metagraph_id_equal(slots[slot].id, id)) {
+                return slot;
+            }
+            hits &= hits - 1U;
+        }
+        if (metagraph_id_group_match(group, METAGRAPH_ID_CTRL_EMPTY)) {
+            return capacity;
+        }
+        pos = (pos + stride) & mask;
+    }
+}
+
+bool metagraph_id_index_ctrl_ok(const int8_t *ctrl, size_t capacity) {
+    if (memcmp(ctrl, ctrl + capacity, METAGRAPH_ID_INDEX_GROUP) != 0) {
+        return false;
+    }
+    return memchr(ctrl, (uint8_t)METAGRAPH_ID_CTRL_EMPTY, capacity) != NULL;
+}
+
+static inline size_t metagraph_id_index_probe(const metagraph_id_index_t *index,
+                                              metagraph_id_t id,
+                                              uint64_t hash) {
+    return metagraph_id_probe(index->ctrl, index->slots, index->capacity, id,
+                              hash);
+}
+
+// First EMPTY or DELETED slot on the probe sequence for hash
+static size_t metagraph_id_index_find_free(const metagraph_id_index_t *index,
+                                           uint64_t hash) {
+    const size_t mask = index->capacity - 1U;
+    size_t pos = metagraph_id_hash_start(hash, index->capacity);
+
+    for (size_t stride = METAGRAPH_ID_INDEX_GROUP;;
+         stride += METAGRAPH_ID_INDEX_GROUP) {
+        uint32_t free_mask = metagraph_id_group_match_free(index->ctrl + pos);
+        if (free_mask) {
+            return (pos + (size_t)__builtin_ctz(free_mask)) & mask;
+        }
+        pos = (pos + stride) & mask;
+    }
+}
+
+static metagraph_result_t metagraph_id_index_rehash(metagraph_id_index_t *index,
+                                                    size_t new_capacity) {
+    metagraph_id_index_t old = *index;
+    METAGRAPH_CHECK(metagraph_id_index_alloc(index, new_capacity));
+
+    for (size_t slot = 0; slot < old.capacity; slot++) {
+        if (old.ctrl[slot] < 0) {
+            continue;
+        }
+        uint64_t hash = metagraph_id_hash(old.slots[slot].id);
+        size_t target = metagraph_id_index_find_free(index, hash);
+        metagraph_id_set_ctrl(index, target, metagraph_id_hash_tag(hash));
+        index->slots[target] = old.slots[slot];
+    }
+    index->count = old.count;
+    index->growth_left -= old.count;
+
+    free(old.ctrl);
+    free(old.slots);
+    return METAGRAPH_OK();
+}
+
+bool metagraph_id_index_find(const metagraph_id_index_t *index,
+                             metagraph_id_t id, uint32_t *out_value) {
+    size_t slot = metagraph_id_index_probe(index, id, metagraph_id_hash(id));
+    if (slot == index->capacity) {
+        return false;
+    }
+    *out_value = index->slots[slot].value;
+    return true;
+}
+
+bool metagraph_id_index_find_raw(const int8_t *ctrl,
+                                 const metagraph_id_slot_t *slots,
+                                 size_t capacity, metagraph_id_t id,
+                                 uint32_t *out_value) {
+    size_t slot =
+        metagraph_id_probe(ctrl, slots, capacity, id, metagraph_id_hash(id));
+    if (slot == capacity) {
+        return false;
+    }
+    *out_value = slots[slot].value;
+    return true;
+}
+
+// Prefetch both lines of an object that may straddle a line boundary
+static inline void metagraph_id_prefetch(const void *address, size_t size) {
+    METAGRAPH_PREFETCH(address);
+    METAGRAPH_PREFETCH((const char *)address + size - 1U);
+}
+
+size_t metagraph_id_index_find_batch_raw(const int8_t *ctrl,
+                                         const metagraph_id_slot_t *slots,
+                                         size_t capacity,
+                                         const metagraph_id_t *ids,
+                                         size_t count, uint32_t *out_values) {
+    const size_t mask = capacity - 1U;
+    uint64_t hashes[METAGRAPH_ID_INDEX_BATCH];
+    size_t found = 0;
+
+    for (size_t base = 0; base < count; base += METAGRAPH_ID_INDEX_BATCH) {
+        const size_t group = count - base < METAGRAPH_ID_INDEX_BATCH
+                                 ? count - base
+                                 : METAGRAPH_ID_INDEX_BATCH;
+        const metagraph_id_t *keys = ids + base;
+        for (size_t i = 0; i < group; i++) {
+            hashes[i] = metagraph_id_hash(keys[i]);
+            metagraph_id_prefetch(
+                ctrl + metagraph_id_hash_start(hashes[i], capacity),
+                METAGRAPH_ID_INDEX_GROUP);
+        }
+        // Most hits are the first tag match in the first group.
+        for (size_t i = 0; i < group; i++) {
+            const size_t pos = metagraph_id_hash_start(hashes[i], capacity);
+            const uint32_t hits = metagraph_id_group_match(
+                ctrl + pos, metagraph_id_hash_tag(hashes[i]));
+            if (hits) {
+                metagraph_id_prefetch(
+                    &slots[(pos + (size_t)__builtin_ctz(hits)) & mask],
+                    sizeof(*slots));
+            }
+        }
+        for (size_t i = 0; i < group; i++) {
+            const size_t slot =
+                metagraph_id_probe(ctrl, slots, capacity, keys[i], hashes[i]);
+            if (slot == capacity) {
+                out_values[base + i] = METAGRAPH_INVALID_INDEX;
+            } else {
+                out_values[base + i] = slots[slot].value;
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+size_t metagraph_id_index_find_batch(const metagraph_id_index_t *index,
+                                     const metagraph_id_t *ids, size_t count,
+                                     uint32_t *out_values) {
+    return metagraph_id_index_find_batch_raw(index->ctrl, index->slots,
+                                             index->capacity, ids, count,
+                                             out_values);
+}
+
+metagraph_result_t metagraph_id_index_insert(metagraph_id_index_t *index,
+                                             metagraph_id_t id, uint32_t value,
+                                             bool *out_inserted) {
+    const uint64_t hash = metagraph_id_hash(id);
+    *out_inserted = false;
+    if (metagraph_id_index_probe(index, id, hash) != index->capacity) {
+        return METAGRAPH_OK();
+    }
+
+    size_t slot = metagraph_id_index_find_free(index, hash);
+    if (index->growth_left == 0 &&
+        index->ctrl[slot] == METAGRAPH_ID_CTRL_EMPTY) {
+        // Grow when genuinely full; otherwise just purge tombstones.
+        size_t new_capacity =
+            (index->count + 1U > METAGRAPH_ID_INDEX_MAX_LOAD(index->capacity) / 2U)
+                ? index->capacity * 2U
+                : index->capacity;
+        METAGRAPH_CHECK(metagraph_id_index_rehash(index, new_capacity));
+        slot = metagraph_id_index_find_free(index, hash);
+    }
+
+    if (index->ctrl[slot] == METAGRAPH_ID_CTRL_EMPTY) {
+        index->growth_left--;
+    }
+    metagraph_id_set_ctrl(index, slot, metagraph_id_hash_tag(hash));
+    index->slots[slot].id = id;
+    index->slots[slot].value = value;
+    index->slots[slot].reserved = 0;
+    index->count++;
+    *out_inserted = true;
+    return METAGRAPH_OK();
+}
+
+bool metagraph_id_index_erase(metagraph_id_index_t *index, metagraph_id_t id) {
+    size_t slot = metagraph_id_index_probe(index, id, metagraph_id_hash(id));
+    if (slot == index->capacity) {
+        return false;
+    }
+    metagraph_id_set_ctrl(index, slot, METAGRAPH_ID_CTRL_DELETED);
+    index->count--;
+    return true;
+}
+
+size_t metagraph_id_index_memory(const metagraph_id_index_t *index) {
+    return index->capacity + METAGRAPH_ID_INDEX_GROUP +
+           index->capacity * sizeof(metagraph_id_slot_t);
+}
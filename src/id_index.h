@@ -0,0 +1,141 @@
+/**
+ * @file id_index.h
+ * @brief Internal open-addressing ID -> index table
+ *
+ * Layout follows the "Swiss table" scheme: one control byte per slot holds
+ * either EMPTY, DELETED, or the low 7 bits of the key hash. Lookups load a
+ * 16-byte group of control bytes, compare all of them against the hash tag
+ * at once, and only touch slots whose tag matches. The first group's control
+ * bytes are mirrored after the end of the array so a group load never has to
+ * wrap.
+ */
+
+#ifndef SRC_ID_INDEX_H
+#define SRC_ID_INDEX_H
+
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define METAGRAPH_ID_INDEX_GROUP 16U
+
+// Keys the batch lookups keep in flight at once: enough cache misses to
+// cover memory latency, few enough for the hashes to stay in registers
+// and on the stack.
+#define METAGRAPH_ID_INDEX_BATCH 16U
+
+/**
+ * @brief One table slot: the key and the dense index it maps to
+ */
+typedef struct {
+    metagraph_id_t id;
+    uint32_t value;
+    uint32_t reserved;
+} metagraph_id_slot_t;
+
+_Static_assert(sizeof(metagraph_id_slot_t) == 24,
+               "ID index slots are serialized into bundles");
+
+/**
+ * @brief Open-addressing table keyed by metagraph_id_t
+ */
+typedef struct {
+    int8_t *ctrl;               ///< capacity + GROUP control bytes
+    metagraph_id_slot_t *slots; ///< capacity slots
+    size_t capacity;            ///< Power of two, >= GROUP
+    size_t count;               ///< Live entries
+    size_t growth_left;         ///< Inserts remaining before a rehash
+} metagraph_id_index_t;
+
+/**
+ * @brief Mix a 128-bit ID down to a well-distributed 64-bit hash
+ */
+static inline uint64_t metagraph_id_hash(metagraph_id_t id) {
+    uint64_t hash = id.high ^ (id.low * 0x9E3779B97F4A7C15ULL);
+    hash ^= hash >> 32U;
+    hash *= 0xD6E8FEB86659FD93ULL;
+    hash ^= hash >> 32U;
+    return hash;
+}
+
+metagraph_result_t metagraph_id_index_init(metagraph_id_index_t *index,
+                                           size_t expected_count);
+
+void metagraph_id_index_destroy(metagraph_id_index_t *index);
+
+/**
+ * @brief Look up an ID
+ * @return true and sets *out_value when found
+ */
+bool metagraph_id_index_find(const metagraph_id_index_t *index,
+                             metagraph_id_t id, uint32_t *out_value);
+
+/**
+ * @brief Look up an ID in a table given as raw arrays
+ *
+ * Used to probe tables that live in read-only memory, such as the INDEX
+ * section of a mapped bundle. The hash function is part of the bundle
+ * format; changing metagraph_id_hash() requires a format version bump.
+ */
+bool metagraph_id_index_find_raw(const int8_t *ctrl,
+                                 const metagraph_id_slot_t *slots,
+                                 size_t capacity, metagraph_id_t id,
+                                 uint32_t *out_value);
+
+/**
+ * @brief Whether raw control bytes are safe to probe
+ *
+ * Probes stop at a group holding an EMPTY byte, so a table read from a
+ * file needs at least one, and its trailing group must mirror the first
+ * for wrapped group loads to see the same bytes.
+ */
+bool metagraph_id_index_ctrl_ok(const int8_t *ctrl, size_t capacity);
+
+/**
+ * @brief Look up many IDs, overlapping their cache misses
+ *
+ * Works through the IDs METAGRAPH_ID_INDEX_BATCH at a time: hashes the
+ * whole group and prefetches each first control group, then prefetches the
+ * slot each tag match points at, and only then probes, so the group's
+ * misses are served in parallel instead of one after another.
+ *
+ * @param out_values Receives each ID's value, or METAGRAPH_INVALID_INDEX
+ * @return Number of IDs found
+ */
+size_t metagraph_id_index_find_batch(const metagraph_id_index_t *index,
+                                     const metagraph_id_t *ids, size_t count,
+                                     uint32_t *out_values);
+
+/**
+ * @brief metagraph_id_index_find_batch() over a table given as raw arrays
+ */
+size_t metagraph_id_index_find_batch_raw(const int8_t *ctrl,
+                                         const metagraph_id_slot_t *slots,
+                                         size_t capacity,
+                                         const metagraph_id_t *ids,
+                                         size_t count, uint32_t *out_values);
+
+/**
+ * @brief Insert an ID unless it is already present
+ * @param out_inserted Set to false (and nothing changes) if the ID exists
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t metagraph_id_index_insert(metagraph_id_index_t *index,
+                                             metagraph_id_t id, uint32_t value,
+                                             bool *out_inserted);
+
+/**
+ * @brief Remove an ID
+ * @return true if the ID was present
+ */
+bool metagraph_id_index_erase(metagraph_id_index_t *index, metagraph_id_t id);
+
+/**
+ * @brief Bytes allocated by the table
+ */
+size_t metagraph_id_index_memory(const metagraph_id_index_t *index);
+
+#endif // SRC_ID_INDEX_H
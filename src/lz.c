@@ -0,0 +1,217 @@
+/**
+ * @file lz.c
+ * @brief Byte-oriented LZ77 block codec
+ *
+ * Compression hashes the next four bytes at each position into a table of
+ * recent positions and takes the candidate when its four bytes match.
+ * After a run of misses the scan steps further between probes, so
+ * incompressible data is skipped quickly.
+ */
+
+#include "lz.h"
+
+#include <string.h>
+
+#define METAGRAPH_LZ_MIN_MATCH 4U
+#define METAGRAPH_LZ_MAX_OFFSET 65535U
+#define METAGRAPH_LZ_HASH_LOG 14U
+#define METAGRAPH_LZ_NIBBLE_MAX 15U
+
+static inline uint32_t metagraph_lz_read32(const uint8_t *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint32_t metagraph_lz_hash(uint32_t value) {
+    return (value * 2654435761U) >> (32U - METAGRAPH_LZ_HASH_LOG);
+}
+
+typedef struct {
+    uint8_t *out;
+    size_t length;
+    size_t capacity;
+} metagraph_lz_writer_t;
+
+static bool metagraph_lz_put_length(metagraph_lz_writer_t *writer,
+                                    size_t excess) {
+    while (excess >= 255U) {
+        if (writer->length == writer->capacity) {
+            return false;
+        }
+        writer->out[writer->length++] = 255U;
+        excess -= 255U;
+    }
+    if (writer->length == writer->capacity) {
+        return false;
+    }
+    writer->out[writer->length++] = (uint8_t)excess;
+    return true;
+}
+
+// One sequence; match_length 0 ends the block after the literals.
+static bool metagraph_lz_put_sequence(metagraph_lz_writer_t *writer,
+                                      const uint8_t *literals,
+                                      size_t literal_length, size_t offset,
+                                      size_t match_length) {
+    const size_t match_code =
+        match_length ? match_length - METAGRAPH_LZ_MIN_MATCH : 0U;
+    const size_t literal_nibble = literal_length < METAGRAPH_LZ_NIBBLE_MAX
+                                      ? literal_length
+                                      : METAGRAPH_LZ_NIBBLE_MAX;
+    const size_t match_nibble =
+        match_code < METAGRAPH_LZ_NIBBLE_MAX ? match_code
+                                             : METAGRAPH_LZ_NIBBLE_MAX;
+    if (writer->length == writer->capacity) {
+        return false;
+    }
+    writer->out[writer->length++] = (uint8_t)((literal_nibble << 4U) |
+                                              match_nibble);
+    if (literal_nibble == METAGRAPH_LZ_NIBBLE_MAX &&
+        !metagraph_lz_put_length(writer,
+                                 literal_length - METAGRAPH_LZ_NIBBLE_MAX)) {
+        return false;
+    }
+    if (literal_length > writer->capacity - writer->length) {
+        return false;
+    }
+    memcpy(writer->out + writer->length, literals, literal_length);
+    writer->length += literal_length;
+    if (match_length == 0) {
+        return true;
+    }
+    if (writer->capacity - writer->length < 2U) {
+        return false;
+    }
+    writer->out[writer->length++] = (uint8_t)(offset & 0xFFU);
+    writer->out[writer->length++] = (uint8_t)(offset >> 8U);
+    return match_nibble < METAGRAPH_LZ_NIBBLE_MAX ||
+           metagraph_lz_put_length(writer,
+                                   match_code - METAGRAPH_LZ_NIBBLE_MAX);
+}
+
+size_t metagraph_lz_compress(const uint8_t *src, size_t size, uint8_t *dst,
+                             size_t capacity) {
+    // Positions are stored + 1 so that zero means empty.
+    uint32_t table[1U << METAGRAPH_LZ_HASH_LOG];
+    memset(table, 0, sizeof(table));
+    metagraph_lz_writer_t writer = {.out = dst, .capacity = capacity};
+
+    size_t anchor = 0;
+    size_t position = 0;
+    uint32_t misses = 0;
+    while (size >= METAGRAPH_LZ_MIN_MATCH &&
+           position <= size - METAGRAPH_LZ_MIN_MATCH) {
+        const uint32_t sequence = metagraph_lz_read32(src + position);
+        const uint32_t slot = metagraph_lz_hash(sequence);
+        const size_t candidate = table[slot];
+        table[slot] = (uint32_t)position + 1U;
+        if (candidate == 0 ||
+            position - (candidate - 1U) > METAGRAPH_LZ_MAX_OFFSET ||
+            metagraph_lz_read32(src + candidate - 1U) != sequence) {
+            position += 1U + (misses++ >> 6U);
+            continue;
+        }
+        misses = 0;
+
+        size_t match_start = position;
+        size_t source = candidate - 1U;
+        size_t match_end = position + METAGRAPH_LZ_MIN_MATCH;
+        size_t source_end = source + METAGRAPH_LZ_MIN_MATCH;
+        while (match_end < size && src[match_end] == src[source_end]) {
+            match_end++;
+            source_end++;
+        }
+        // Extend backwards into the pending literals.
+        while (match_start > anchor && source > 0 &&
+               src[match_start - 1U] == src[source - 1U]) {
+            match_start--;
+            source--;
+        }
+        if (!metagraph_lz_put_sequence(&writer, src + anchor,
+                                       match_start - anchor,
+                                       match_start - source,
+                                       match_end - match_start)) {
+            return 0;
+        }
+        if (match_end >= 2U && match_end - 2U > match_start &&
+            match_end + METAGRAPH_LZ_MIN_MATCH - 2U <= size) {
+            table[metagraph_lz_hash(metagraph_lz_read32(src + match_end - 2U))] =
+                (uint32_t)(match_end - 2U) + 1U;
+        }
+        anchor = match_end;
+        position = match_end;
+    }
+    if (anchor < size &&
+        !metagraph_lz_put_sequence(&writer, src + anchor, size - anchor, 0, 0)) {
+        return 0;
+    }
+    return writer.length;
+}
+
+// Read an extended length; *length already holds the nibble value.
+static bool metagraph_lz_get_length(const uint8_t **cursor, const uint8_t *end,
+                                    size_t limit, size_t *length) {
+    const uint8_t *in = *cursor;
+    uint8_t byte;
+    do {
+        if (in == end || *length > limit) {
+            return false;
+        }
+        byte = *in++;
+        *length += byte;
+    } while (byte == 255U);
+    *cursor = in;
+    return true;
+}
+
+bool metagraph_lz_decompress(const uint8_t *src, size_t src_size, uint8_t *dst,
+                             size_t dst_size) {
+    const uint8_t *in = src;
+    const uint8_t *const end = src + src_size;
+    size_t written = 0;
+    while (in < end) {
+        const uint8_t token = *in++;
+        size_t literals = token >> 4U;
+        if (literals == METAGRAPH_LZ_NIBBLE_MAX &&
+            !metagraph_lz_get_length(&in, end, dst_size, &literals)) {
+            return false;
+        }
+        if (literals > (size_t)(end - in) || literals > dst_size - written) {
+            return false;
+        }
+        memcpy(dst + written, in, literals);
+        in += literals;
+        written += literals;
+        if (in == end) {
+            break;
+        }
+
+        if (end - in < 2) {
+            return false;
+        }
+        const size_t offset = (size_t)in[0] | ((size_t)in[1] << 8U);
+        in += 2;
+        size_t match = token & METAGRAPH_LZ_NIBBLE_MAX;
+        if (match == METAGRAPH_LZ_NIBBLE_MAX &&
+            !metagraph_lz_get_length(&in, end, dst_size, &match)) {
+            return false;
+        }
+        match += METAGRAPH_LZ_MIN_MATCH;
+        if (offset == 0 || offset > written || match > dst_size - written) {
+            return false;
+        }
+        uint8_t *out = dst + written;
+        const uint8_t *from = out - offset;
+        if (offset >= match) {
+            memcpy(out, from, match);
+        } else {
+            // Overlapping copy repeats the last offset bytes.
+            for (size_t i = 0; i < match; i++) {
+                out[i] = from[i];
+            }
+        }
+        written += match;
+    }
+    return written == dst_size;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file lz.h
+ * @brief Internal byte-oriented LZ77 block codec
+ *
+ * A block is a run of sequences, each a token byte (high nibble: literal
+ * count, low nibble: match length - 4; 15 means more length bytes follow,
+ * each adding up to 255), the literals, and unless the block ends there a
+ * 16-bit little-endian match offset and the match length bytes. Blocks are
+ * independent: nothing carries over from one block to the next, so any
+ * block can be decoded on its own.
+ *
+ * The codec favours decode speed over ratio, like LZ4: greedy matching
+ * with a single-entry hash table while compressing, and only copies while
+ * decoding.
+ */
+
+#ifndef SRC_LZ_H
+#define SRC_LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Compress src into dst
+ * @return Compressed size, or 0 if the result does not fit in capacity
+ */
+size_t metagraph_lz_compress(const uint8_t *src, size_t size, uint8_t *dst,
+                             size_t capacity);
+
+/**
+ * @brief Decode a block that expands to exactly dst_size bytes
+ *
+ * Every length and offset is bounds-checked, so corrupt input fails
+ * instead of reading or writing out of range.
+ *
+ * @return false if the block is malformed
+ */
+bool metagraph_lz_decompress(const uint8_t *src, size_t src_size, uint8_t *dst,
+                             size_t dst_size);
+
+#endif // SRC_LZ_H
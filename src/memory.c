@@ -0,0 +1,1038 @@
+/**
+ * @file memory.c
+ * @brief Arena, object pool and thread-local magazine allocators
+ *
+ * Arenas bump through a singly linked chain of blocks. Reset and restore
+ * only move the bump position back; blocks after it stay in the chain and
+ * are reused in order, so neither operation touches the system allocator.
+ *
+ * Object pools carve fixed-size slots from slabs and keep released slots on
+ * an intrusive free list guarded by a mutex.
+ *
+ * A pool bound to a NUMA node binds the whole pages of every block or slab
+ * it already holds and of each one it reserves later. Binding a fresh
+ * block is best effort: the allocation succeeds on whatever node the
+ * kernel picks if the bind call fails.
+ *
+ * Thread-local pools carve power-of-two size classes from slabs aligned to
+ * their own size, so free() finds the owning slab (and size class) by
+ * masking the pointer. Each thread owns one cache per pool holding a
+ * magazine of free slots per class; only magazine refills and flushes touch
+ * the per-class depot lock.
+ */
+
+#include "metagraph/memory.h"
+#include "metagraph/numa.h"
+#include "metagraph/result.h"
+
+#include "metrics_internal.h"
+#include "platform.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METAGRAPH_POOL_DEFAULT_SIZE (64U * 1024U)
+#define METAGRAPH_POOL_DEFAULT_ALIGNMENT 16U
+
+static bool metagraph_memory_is_pow2(size_t value) {
+    return value != 0 && (value & (value - 1U)) == 0;
+}
+
+static size_t metagraph_memory_align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1U) & ~(alignment - 1U);
+}
+
+// ---------------------------------------------------------------------------
+// Memory pools (arena + object)
+// ---------------------------------------------------------------------------
+
+typedef struct metagraph_arena_block {
+    struct metagraph_arena_block *next;
+    size_t size; ///< Usable bytes after the header
+    size_t used; ///< Bump offset into the usable bytes
+    _Alignas(METAGRAPH_POOL_DEFAULT_ALIGNMENT) unsigned char data[];
+} metagraph_arena_block_t;
+
+typedef struct metagraph_object_slab {
+    struct metagraph_object_slab *next;
+} metagraph_object_slab_t;
+
+typedef struct metagraph_free_slot {
+    struct metagraph_free_slot *next;
+} metagraph_free_slot_t;
+
+struct metagraph_memory_pool {
+    metagraph_pool_type_t type;
+    size_t initial_size;
+    size_t max_size;
+    size_t alignment;
+    bool allow_growth;
+    uint32_t numa_node; ///< Preferred node or METAGRAPH_NUMA_NODE_ANY
+
+    size_t reserved;  ///< Usable bytes reserved from the system
+    size_t allocated; ///< Bytes currently handed out
+    uint64_t allocation_count;
+    uint64_t deallocation_count;
+    uint64_t growth_count;
+
+    // Arena
+    metagraph_arena_block_t *first;
+    metagraph_arena_block_t *current;
+    void *last_alloc;   ///< Most recent allocation in current block
+    size_t last_offset; ///< current->used before last_alloc
+
+    // Object pool
+    metagraph_mutex_t lock;
+    size_t object_size;
+    size_t slot_size;
+    size_t slab_header;
+    size_t slots_per_slab;
+    metagraph_object_slab_t *slabs;
+    metagraph_free_slot_t *free_slots;
+};
+
+static bool metagraph_pool_may_reserve(const metagraph_memory_pool_t *pool,
+                                       size_t bytes) {
+    if (pool->max_size == 0) {
+        return true;
+    }
+    return pool->reserved <= pool->max_size &&
+           bytes <= pool->max_size - pool->reserved;
+}
+
+static size_t metagraph_object_slab_bytes(const metagraph_memory_pool_t *pool) {
+    return pool->slab_header + pool->slot_size * pool->slots_per_slab;
+}
+
+// Bind a block the pool just reserved; placement is only a preference, so
+// a failed bind leaves the block where the kernel put it.
+static void metagraph_pool_place(const metagraph_memory_pool_t *pool,
+                                 void *memory, size_t bytes) {
+    if (pool->numa_node != METAGRAPH_NUMA_NODE_ANY) {
+        (void)metagraph_numa_bind(memory, bytes, pool->numa_node);
+    }
+}
+
+// NULL when the system allocator fails
+static metagraph_arena_block_t *
+metagraph_arena_new_block(metagraph_memory_pool_t *pool, size_t size) {
+    metagraph_arena_block_t *block = malloc(sizeof(*block) + size);
+    if (!block) {
+        return NULL;
+    }
+    metagraph_pool_place(pool, block, sizeof(*block) + size);
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    pool->reserved += size;
+    pool->growth_count++;
+    return block;
+}
+
+// Offset at which an allocation of size/alignment would start in block, or
+// SIZE_MAX when it does not fit.
+static size_t metagraph_arena_fit(const metagraph_arena_block_t *block,
+                                  size_t used, size_t size, size_t alignment) {
+    const uintptr_t base = (uintptr_t)block->data;
+    const uintptr_t start =
+        (base + used + alignment - 1U) & ~((uintptr_t)alignment - 1U);
+    const size_t offset = (size_t)(start - base);
+    if (offset > block->size || size > block->size - offset) {
+        return SIZE_MAX;
+    }
+    return offset;
+}
+
+// Free bytes the arena could hand out without reserving, used to tell
+// exhaustion from fragmentation.
+static size_t metagraph_arena_free_bytes(const metagraph_memory_pool_t *pool,
+                                         size_t *out_largest) {
+    const metagraph_arena_block_t *block = pool->current;
+    size_t total = block->size - block->used;
+    size_t largest = total;
+    for (block = block->next; block; block = block->next) {
+        total += block->size;
+        if (block->size > largest) {
+            largest = block->size;
+        }
+    }
+    if (out_largest) {
+        *out_largest = largest;
+    }
+    return total;
+}
+
+static metagraph_result_t metagraph_arena_alloc(metagraph_memory_pool_t *pool,
+                                                size_t size, size_t alignment,
+                                                void **out_ptr) {
+    metagraph_arena_block_t *block = pool->current;
+    size_t offset = metagraph_arena_fit(block, block->used, size, alignment);
+
+    if (offset == SIZE_MAX && block->next &&
+        metagraph_arena_fit(block->next, 0, size, alignment) != SIZE_MAX) {
+        // Reuse a block left in the chain by reset/restore.
+        block = block->next;
+        block->used = 0;
+        offset = metagraph_arena_fit(block, 0, size, alignment);
+    } else if (offset == SIZE_MAX) {
+        const size_t needed = size + alignment;
+        const size_t block_size =
+            needed > pool->initial_size ? needed : pool->initial_size;
+        if (needed < size || !pool->allow_growth ||
+            !metagraph_pool_may_reserve(pool, block_size)) {
+            const size_t free_bytes = metagraph_arena_free_bytes(pool, NULL);
+            if (free_bytes >= size) {
+                return METAGRAPH_ERR(
+                    METAGRAPH_ERROR_FRAGMENTATION,
+                    "Arena has %zu free bytes but no %zu-byte run", free_bytes,
+                    size);
+            }
+            return METAGRAPH_ERR(METAGRAPH_ERROR_POOL_EXHAUSTED,
+                                 "Arena cannot reserve %zu more bytes (limit "
+                                 "%zu, reserved %zu)",
+                                 block_size, pool->max_size, pool->reserved);
+        }
+        metagraph_arena_block_t *grown =
+            metagraph_arena_new_block(pool, block_size);
+        if (!grown) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                 "Failed to reserve a %zu-byte arena block",
+                                 block_size);
+        }
+        grown->next = block->next;
+        block->next = grown;
+        block = grown;
+        offset = metagraph_arena_fit(block, 0, size, alignment);
+    }
+
+    const size_t consumed = offset + size - block->used;
+    pool->last_offset = block->used;
+    block->used = offset + size;
+    pool->current = block;
+    pool->allocated += consumed;
+    pool->allocation_count++;
+    metagraph_metrics_add(METAGRAPH_COUNTER_POOL_ALLOCS, 1U);
+    pool->last_alloc = block->data + offset;
+    *out_ptr = pool->last_alloc;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_object_pool_grow(metagraph_memory_pool_t *pool) {
+    const size_t bytes = pool->slot_size * pool->slots_per_slab;
+    if ((pool->slabs && !pool->allow_growth) ||
+        !metagraph_pool_may_reserve(pool, bytes)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_POOL_EXHAUSTED,
+                             "Object pool exhausted at %zu reserved bytes",
+                             pool->reserved);
+    }
+    unsigned char *memory = metagraph_aligned_alloc(
+        pool->alignment, metagraph_object_slab_bytes(pool));
+    METAGRAPH_CHECK_ALLOC(memory);
+    metagraph_pool_place(pool, memory, metagraph_object_slab_bytes(pool));
+
+    metagraph_object_slab_t *slab = (void *)memory;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    // Thread the new slots onto the free list in address order.
+    unsigned char *slots = memory + pool->slab_header;
+    for (size_t i = pool->slots_per_slab; i-- > 0;) {
+        metagraph_free_slot_t *slot = (void *)(slots + i * pool->slot_size);
+        slot->next = pool->free_slots;
+        pool->free_slots = slot;
+    }
+    pool->reserved += bytes;
+    pool->growth_count++;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_memory_pool_create(const metagraph_pool_config_t *config,
+                             metagraph_memory_pool_t **out_pool) {
+    METAGRAPH_CHECK_NULL(config);
+    METAGRAPH_CHECK_NULL(out_pool);
+    *out_pool = NULL;
+
+    const size_t alignment =
+        config->alignment ? config->alignment : METAGRAPH_POOL_DEFAULT_ALIGNMENT;
+    if (!metagraph_memory_is_pow2(alignment)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ALIGNMENT_VALUE,
+                             "Pool alignment %zu is not a power of two",
+                             alignment);
+    }
+    if (config->type == METAGRAPH_POOL_TYPE_OBJECT && config->object_size == 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Object pools need a non-zero object size");
+    }
+
+    metagraph_memory_pool_t *pool = calloc(1, sizeof(*pool));
+    METAGRAPH_CHECK_ALLOC(pool);
+    pool->type = config->type;
+    pool->initial_size =
+        config->initial_size ? config->initial_size : METAGRAPH_POOL_DEFAULT_SIZE;
+    pool->max_size = config->max_size;
+    pool->alignment = alignment;
+    pool->allow_growth = config->allow_growth;
+    pool->numa_node = METAGRAPH_NUMA_NODE_ANY;
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    switch (config->type) {
+    case METAGRAPH_POOL_TYPE_ARENA:
+        if (!metagraph_pool_may_reserve(pool, pool->initial_size)) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                                   "Arena initial size exceeds its limit");
+            goto fail;
+        }
+        pool->first = metagraph_arena_new_block(pool, pool->initial_size);
+        if (!pool->first) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                   "Failed to reserve a %zu-byte arena block",
+                                   pool->initial_size);
+            goto fail;
+        }
+        pool->current = pool->first;
+        break;
+    case METAGRAPH_POOL_TYPE_OBJECT: {
+        const size_t min_slot = config->object_size > sizeof(void *)
+                                    ? config->object_size
+                                    : sizeof(void *);
+        const size_t slot_alignment = alignment > _Alignof(metagraph_free_slot_t)
+                                          ? alignment
+                                          : _Alignof(metagraph_free_slot_t);
+        pool->alignment = slot_alignment;
+        pool->object_size = config->object_size;
+        pool->slot_size = metagraph_memory_align_up(min_slot, slot_alignment);
+        pool->slab_header = metagraph_memory_align_up(
+            sizeof(metagraph_object_slab_t), slot_alignment);
+        pool->slots_per_slab = pool->initial_size / pool->slot_size;
+        if (pool->slots_per_slab == 0) {
+            pool->slots_per_slab = 1;
+        }
+        if (metagraph_mutex_init(&pool->lock) != 0) {
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_RESOURCE_EXHAUSTED,
+                                   "Failed to initialize pool lock");
+            goto fail;
+        }
+        METAGRAPH_CHECK_GOTO(metagraph_object_pool_grow(pool), fail_locked);
+        break;
+    }
+    default:
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                               "Unknown pool type %d", (int)config->type);
+        goto fail;
+    }
+
+    pool->growth_count = 0;
+    *out_pool = pool;
+    return METAGRAPH_OK();
+
+fail_locked:
+    metagraph_mutex_destroy(&pool->lock);
+fail:
+    free(pool->first);
+    free(pool);
+    return result;
+}
+
+metagraph_result_t metagraph_memory_pool_destroy(metagraph_memory_pool_t *pool) {
+    if (!pool) {
+        return METAGRAPH_OK();
+    }
+    if (pool->type == METAGRAPH_POOL_TYPE_ARENA) {
+        metagraph_arena_block_t *block = pool->first;
+        while (block) {
+            metagraph_arena_block_t *next = block->next;
+            free(block);
+            block = next;
+        }
+    } else {
+        metagraph_object_slab_t *slab = pool->slabs;
+        while (slab) {
+            metagraph_object_slab_t *next = slab->next;
+            metagraph_aligned_free(slab);
+            slab = next;
+        }
+        metagraph_mutex_destroy(&pool->lock);
+    }
+    free(pool);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_memory_pool_aligned_alloc(metagraph_memory_pool_t *pool, size_t size,
+                                    size_t alignment, void **out_ptr) {
+    METAGRAPH_CHECK_NULL(pool);
+    METAGRAPH_CHECK_NULL(out_ptr);
+    *out_ptr = NULL;
+    if (!metagraph_memory_is_pow2(alignment)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ALIGNMENT_VALUE,
+                             "Alignment %zu is not a power of two", alignment);
+    }
+    if (size == 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Zero-byte pool allocation");
+    }
+    if (pool->type == METAGRAPH_POOL_TYPE_ARENA) {
+        return metagraph_arena_alloc(pool, size, alignment, out_ptr);
+    }
+    if (size > pool->object_size) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Request of %zu bytes exceeds object size %zu",
+                             size, pool->object_size);
+    }
+    if (alignment > pool->alignment) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ALIGNMENT,
+                             "Object pool slots are only %zu-byte aligned",
+                             pool->alignment);
+    }
+    return metagraph_object_pool_acquire(pool, out_ptr);
+}
+
+metagraph_result_t metagraph_memory_pool_alloc(metagraph_memory_pool_t *pool,
+                                               size_t size, void **out_ptr) {
+    METAGRAPH_CHECK_NULL(pool);
+    return metagraph_memory_pool_aligned_alloc(pool, size, pool->alignment,
+                                               out_ptr);
+}
+
+metagraph_result_t metagraph_memory_pool_free(metagraph_memory_pool_t *pool,
+                                              void *ptr) {
+    METAGRAPH_CHECK_NULL(pool);
+    if (!ptr) {
+        return METAGRAPH_OK();
+    }
+    if (pool->type == METAGRAPH_POOL_TYPE_OBJECT) {
+        return metagraph_object_pool_release(pool, ptr);
+    }
+    if (ptr == pool->last_alloc) {
+        pool->allocated -= pool->current->used - pool->last_offset;
+        pool->current->used = pool->last_offset;
+        pool->last_alloc = NULL;
+    }
+    pool->deallocation_count++;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_object_pool_acquire(metagraph_memory_pool_t *pool,
+                                                 void **out_object) {
+    METAGRAPH_CHECK_NULL(pool);
+    METAGRAPH_CHECK_NULL(out_object);
+    *out_object = NULL;
+    if (pool->type != METAGRAPH_POOL_TYPE_OBJECT) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Pool is not an object pool");
+    }
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_mutex_lock(&pool->lock);
+    if (!pool->free_slots) {
+        METAGRAPH_CHECK_GOTO(metagraph_object_pool_grow(pool), done);
+    }
+    metagraph_free_slot_t *slot = pool->free_slots;
+    pool->free_slots = slot->next;
+    pool->allocated += pool->slot_size;
+    pool->allocation_count++;
+    metagraph_metrics_add(METAGRAPH_COUNTER_POOL_ALLOCS, 1U);
+    *out_object = slot;
+done:
+    metagraph_mutex_unlock(&pool->lock);
+    return result;
+}
+
+metagraph_result_t metagraph_object_pool_release(metagraph_memory_pool_t *pool,
+                                                 void *object) {
+    METAGRAPH_CHECK_NULL(pool);
+    METAGRAPH_CHECK_NULL(object);
+    if (pool->type != METAGRAPH_POOL_TYPE_OBJECT) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Pool is not an object pool");
+    }
+    if ((uintptr_t)object % pool->alignment != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ALIGNMENT,
+                             "Released object is not a pool slot");
+    }
+    metagraph_free_slot_t *slot = object;
+    metagraph_mutex_lock(&pool->lock);
+    slot->next = pool->free_slots;
+    pool->free_slots = slot;
+    pool->allocated -= pool->slot_size;
+    pool->deallocation_count++;
+    metagraph_mutex_unlock(&pool->lock);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_memory_pool_bind_numa(metagraph_memory_pool_t *pool, uint32_t node) {
+    METAGRAPH_CHECK_NULL(pool);
+    if (node != METAGRAPH_NUMA_NODE_ANY) {
+        metagraph_numa_topology_t topology;
+        METAGRAPH_CHECK(metagraph_get_numa_topology(&topology));
+        if (node >= topology.node_count) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                                 "NUMA node %u out of range (%u nodes)", node,
+                                 topology.node_count);
+        }
+    }
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    if (pool->type == METAGRAPH_POOL_TYPE_ARENA) {
+        pool->numa_node = node;
+        for (metagraph_arena_block_t *block = pool->first;
+             block && node != METAGRAPH_NUMA_NODE_ANY; block = block->next) {
+            METAGRAPH_CHECK(metagraph_numa_bind(
+                block, sizeof(*block) + block->size, node));
+        }
+        return METAGRAPH_OK();
+    }
+
+    metagraph_mutex_lock(&pool->lock);
+    pool->numa_node = node;
+    for (metagraph_object_slab_t *slab = pool->slabs;
+         slab && node != METAGRAPH_NUMA_NODE_ANY; slab = slab->next) {
+        METAGRAPH_CHECK_GOTO(
+            metagraph_numa_bind(slab, metagraph_object_slab_bytes(pool), node),
+            done);
+    }
+done:
+    metagraph_mutex_unlock(&pool->lock);
+    return result;
+}
+
+metagraph_result_t
+metagraph_memory_pool_get_numa_node(const metagraph_memory_pool_t *pool,
+                                    uint32_t *out_node) {
+    METAGRAPH_CHECK_NULL(pool);
+    METAGRAPH_CHECK_NULL(out_node);
+    *out_node = pool->numa_node;
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_arena_require(const metagraph_memory_pool_t *arena) {
+    METAGRAPH_CHECK_NULL(arena);
+    if (arena->type != METAGRAPH_POOL_TYPE_ARENA) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Pool is not an arena");
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_arena_reset(metagraph_memory_pool_t *arena) {
+    METAGRAPH_CHECK(metagraph_arena_require(arena));
+    arena->current = arena->first;
+    arena->current->used = 0;
+    arena->allocated = 0;
+    arena->last_alloc = NULL;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_arena_checkpoint(metagraph_memory_pool_t *arena,
+                           metagraph_arena_checkpoint_t *out_checkpoint) {
+    METAGRAPH_CHECK(metagraph_arena_require(arena));
+    METAGRAPH_CHECK_NULL(out_checkpoint);
+    out_checkpoint->block = arena->current;
+    out_checkpoint->used = arena->current->used;
+    out_checkpoint->bytes = arena->allocated;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_arena_restore(metagraph_memory_pool_t *arena,
+                        const metagraph_arena_checkpoint_t *checkpoint) {
+    METAGRAPH_CHECK(metagraph_arena_require(arena));
+    METAGRAPH_CHECK_NULL(checkpoint);
+    METAGRAPH_CHECK_NULL(checkpoint->block);
+    metagraph_arena_block_t *block = checkpoint->block;
+    if (checkpoint->used > block->size || checkpoint->bytes > arena->allocated) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Checkpoint is newer than the arena position");
+    }
+    arena->current = block;
+    block->used = checkpoint->used;
+    arena->allocated = checkpoint->bytes;
+    arena->last_alloc = NULL;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_memory_pool_get_stats(const metagraph_memory_pool_t *pool,
+                                metagraph_pool_stats_t *out_stats) {
+    METAGRAPH_CHECK_NULL(pool);
+    METAGRAPH_CHECK_NULL(out_stats);
+    memset(out_stats, 0, sizeof(*out_stats));
+
+    metagraph_memory_pool_t *mutable_pool = (void *)(uintptr_t)pool;
+    if (pool->type == METAGRAPH_POOL_TYPE_OBJECT) {
+        metagraph_mutex_lock(&mutable_pool->lock);
+    }
+    out_stats->total_size = pool->reserved;
+    out_stats->allocated_size = pool->allocated;
+    out_stats->allocation_count = pool->allocation_count;
+    out_stats->deallocation_count = pool->deallocation_count;
+    out_stats->growth_count = pool->growth_count;
+    if (pool->type == METAGRAPH_POOL_TYPE_ARENA) {
+        out_stats->free_size =
+            metagraph_arena_free_bytes(pool, &out_stats->largest_free_block);
+    } else {
+        out_stats->free_size = pool->reserved - pool->allocated;
+        out_stats->largest_free_block = pool->free_slots ? pool->slot_size : 0;
+        metagraph_mutex_unlock(&mutable_pool->lock);
+    }
+
+    if (out_stats->free_size > 0) {
+        out_stats->fragmentation_ratio =
+            1.0 - (double)out_stats->largest_free_block /
+                      (double)out_stats->free_size;
+    }
+    if (out_stats->total_size > 0) {
+        out_stats->utilization_ratio = (double)out_stats->allocated_size /
+                                       (double)out_stats->total_size;
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_memory_pool_reset_stats(metagraph_memory_pool_t *pool) {
+    METAGRAPH_CHECK_NULL(pool);
+    if (pool->type == METAGRAPH_POOL_TYPE_OBJECT) {
+        metagraph_mutex_lock(&pool->lock);
+    }
+    pool->allocation_count = 0;
+    pool->deallocation_count = 0;
+    pool->growth_count = 0;
+    if (pool->type == METAGRAPH_POOL_TYPE_OBJECT) {
+        metagraph_mutex_unlock(&pool->lock);
+    }
+    return METAGRAPH_OK();
+}
+
+// ---------------------------------------------------------------------------
+// Thread-local pools
+// ---------------------------------------------------------------------------
+
+// Slabs are aligned to their size so a slot's slab header is ptr & ~mask.
+#define METAGRAPH_TL_SLAB_SIZE (64U * 1024U)
+#define METAGRAPH_TL_SLAB_HEADER 64U
+#define METAGRAPH_TL_SLAB_MAGIC 0x4D47544CU
+#define METAGRAPH_TL_MIN_CLASS_SHIFT 4U
+#define METAGRAPH_TL_CLASS_COUNT 10U // 16 B .. 8 KiB
+#define METAGRAPH_TL_LARGE_CLASS UINT32_MAX
+#define METAGRAPH_TL_MAGAZINE_SIZE 64U
+#define METAGRAPH_TL_BATCH (METAGRAPH_TL_MAGAZINE_SIZE / 2U)
+#define METAGRAPH_TL_CACHE_SLOTS 4U
+#define METAGRAPH_TL_MAX_ALIGNMENT 64U
+
+_Static_assert(METAGRAPH_THREAD_LOCAL_MAX_SMALL_SIZE ==
+                   1U << (METAGRAPH_TL_MIN_CLASS_SHIFT +
+                          METAGRAPH_TL_CLASS_COUNT - 1U),
+               "largest size class must match the public limit");
+
+typedef struct metagraph_tl_slab {
+    uint32_t magic;
+    uint32_t size_class;
+    size_t bytes;
+    struct metagraph_tl_slab *prev;
+    struct metagraph_tl_slab *next;
+    const metagraph_thread_local_pool_t *pool;
+} metagraph_tl_slab_t;
+
+_Static_assert(sizeof(metagraph_tl_slab_t) <= METAGRAPH_TL_SLAB_HEADER,
+               "slab header must fit before the first slot");
+
+typedef struct {
+    metagraph_mutex_t lock;
+    metagraph_free_slot_t *free_slots;
+} metagraph_tl_depot_t;
+
+typedef struct {
+    uint32_t count;
+    void *slots[METAGRAPH_TL_MAGAZINE_SIZE];
+} metagraph_tl_magazine_t;
+
+typedef struct metagraph_tl_cache {
+    struct metagraph_tl_cache *next;
+    const void *owner; ///< Address of the owning thread's TLS token
+    metagraph_tl_magazine_t magazines[METAGRAPH_TL_CLASS_COUNT];
+} metagraph_tl_cache_t;
+
+struct metagraph_thread_local_pool {
+    uint64_t id;
+    size_t max_size;
+    size_t min_class_size;
+
+    metagraph_mutex_t lock; ///< Guards slabs, caches and reserved
+    metagraph_tl_slab_t *slabs;
+    metagraph_tl_cache_t *caches;
+    size_t reserved;
+
+    metagraph_tl_depot_t depots[METAGRAPH_TL_CLASS_COUNT];
+};
+
+typedef struct {
+    uint64_t pool_id;
+    metagraph_tl_cache_t *cache;
+} metagraph_tl_binding_t;
+
+// Pool IDs are never reused, so a binding left behind by a destroyed pool
+// can never match a live one.
+static _Atomic(uint64_t) metagraph_tl_next_pool_id = 1;
+static METAGRAPH_THREAD_LOCAL metagraph_tl_binding_t
+    metagraph_tl_bindings[METAGRAPH_TL_CACHE_SLOTS];
+static METAGRAPH_THREAD_LOCAL uint32_t metagraph_tl_next_binding;
+static METAGRAPH_THREAD_LOCAL char metagraph_tl_token;
+
+static uint32_t metagraph_tl_size_class(size_t size) {
+    if (size <= (1U << METAGRAPH_TL_MIN_CLASS_SHIFT)) {
+        return 0;
+    }
+#if defined(__GNUC__)
+    const uint32_t bits =
+        64U - (uint32_t)__builtin_clzll((unsigned long long)(size - 1U));
+#else
+    uint32_t bits = 0;
+    for (size_t value = size - 1U; value; value >>= 1U) {
+        bits++;
+    }
+#endif
+    return bits - METAGRAPH_TL_MIN_CLASS_SHIFT;
+}
+
+static size_t metagraph_tl_class_size(uint32_t size_class) {
+    return (size_t)1U << (size_class + METAGRAPH_TL_MIN_CLASS_SHIFT);
+}
+
+static metagraph_tl_slab_t *metagraph_tl_slab_of(const void *ptr) {
+    return (void *)((uintptr_t)ptr & ~(uintptr_t)(METAGRAPH_TL_SLAB_SIZE - 1U));
+}
+
+// Reserve a slab and link it into the pool. Caller holds no pool lock.
+static metagraph_result_t
+metagraph_tl_slab_create(metagraph_thread_local_pool_t *pool,
+                         uint32_t size_class, size_t bytes,
+                         metagraph_tl_slab_t **out_slab) {
+    metagraph_mutex_lock(&pool->lock);
+    if (pool->max_size != 0 &&
+        (pool->reserved > pool->max_size ||
+         bytes > pool->max_size - pool->reserved)) {
+        const size_t reserved = pool->reserved;
+        metagraph_mutex_unlock(&pool->lock);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_POOL_EXHAUSTED,
+                             "Thread-local pool exhausted at %zu bytes",
+                             reserved);
+    }
+    pool->reserved += bytes;
+    metagraph_mutex_unlock(&pool->lock);
+
+    metagraph_tl_slab_t *slab =
+        metagraph_aligned_alloc(METAGRAPH_TL_SLAB_SIZE, bytes);
+    if (!slab) {
+        metagraph_mutex_lock(&pool->lock);
+        pool->reserved -= bytes;
+        metagraph_mutex_unlock(&pool->lock);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to reserve a %zu-byte slab", bytes);
+    }
+    slab->magic = METAGRAPH_TL_SLAB_MAGIC;
+    slab->size_class = size_class;
+    slab->bytes = bytes;
+    slab->pool = pool;
+    slab->prev = NULL;
+
+    metagraph_mutex_lock(&pool->lock);
+    slab->next = pool->slabs;
+    if (pool->slabs) {
+        pool->slabs->prev = slab;
+    }
+    pool->slabs = slab;
+    metagraph_mutex_unlock(&pool->lock);
+    *out_slab = slab;
+    return METAGRAPH_OK();
+}
+
+static metagraph_tl_cache_t *
+metagraph_tl_cache_lookup(const metagraph_thread_local_pool_t *pool) {
+    for (uint32_t i = 0; i < METAGRAPH_TL_CACHE_SLOTS; i++) {
+        if (metagraph_tl_bindings[i].pool_id == pool->id) {
+            return metagraph_tl_bindings[i].cache;
+        }
+    }
+    return NULL;
+}
+
+// Slow path: find this thread's cache in the pool registry (it may have
+// been evicted from the bindings) or register a new one.
+static metagraph_result_t
+metagraph_tl_cache_bind(metagraph_thread_local_pool_t *pool,
+                        metagraph_tl_cache_t **out_cache) {
+    metagraph_mutex_lock(&pool->lock);
+    metagraph_tl_cache_t *cache = pool->caches;
+    while (cache && cache->owner != &metagraph_tl_token) {
+        cache = cache->next;
+    }
+    if (!cache) {
+        cache = calloc(1, sizeof(*cache));
+        if (!cache) {
+            metagraph_mutex_unlock(&pool->lock);
+            return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                 "Failed to allocate thread cache");
+        }
+        cache->owner = &metagraph_tl_token;
+        cache->next = pool->caches;
+        pool->caches = cache;
+    }
+    metagraph_mutex_unlock(&pool->lock);
+
+    const uint32_t slot = metagraph_tl_next_binding++ % METAGRAPH_TL_CACHE_SLOTS;
+    metagraph_tl_bindings[slot].pool_id = pool->id;
+    metagraph_tl_bindings[slot].cache = cache;
+    *out_cache = cache;
+    return METAGRAPH_OK();
+}
+
+// Move up to METAGRAPH_TL_BATCH slots from the depot into the magazine,
+// carving a fresh slab when the depot is empty.
+static metagraph_result_t
+metagraph_tl_refill(metagraph_thread_local_pool_t *pool, uint32_t size_class,
+                    metagraph_tl_magazine_t *magazine) {
+    metagraph_tl_depot_t *depot = &pool->depots[size_class];
+    metagraph_mutex_lock(&depot->lock);
+    while (magazine->count < METAGRAPH_TL_BATCH && depot->free_slots) {
+        metagraph_free_slot_t *slot = depot->free_slots;
+        depot->free_slots = slot->next;
+        magazine->slots[magazine->count++] = slot;
+    }
+    metagraph_mutex_unlock(&depot->lock);
+    if (magazine->count > 0) {
+        return METAGRAPH_OK();
+    }
+
+    metagraph_tl_slab_t *slab = NULL;
+    METAGRAPH_CHECK(metagraph_tl_slab_create(pool, size_class,
+                                             METAGRAPH_TL_SLAB_SIZE, &slab));
+    const size_t slot_size = metagraph_tl_class_size(size_class);
+    // Slots start after the 64-byte header, so each is aligned to
+    // min(slot_size, 64).
+    unsigned char *cursor =
+        (unsigned char *)(void *)slab + METAGRAPH_TL_SLAB_HEADER;
+    const unsigned char *end = (unsigned char *)(void *)slab +
+                               METAGRAPH_TL_SLAB_SIZE;
+    metagraph_free_slot_t *spill = NULL;
+    metagraph_free_slot_t *spill_tail = NULL;
+    for (; cursor + slot_size <= end; cursor += slot_size) {
+        if (magazine->count < METAGRAPH_TL_BATCH) {
+            magazine->slots[magazine->count++] = cursor;
+            continue;
+        }
+        metagraph_free_slot_t *slot = (void *)cursor;
+        slot->next = NULL;
+        if (spill_tail) {
+            spill_tail->next = slot;
+        } else {
+            spill = slot;
+        }
+        spill_tail = slot;
+    }
+    if (spill) {
+        metagraph_mutex_lock(&depot->lock);
+        spill_tail->next = depot->free_slots;
+        depot->free_slots = spill;
+        metagraph_mutex_unlock(&depot->lock);
+    }
+    return METAGRAPH_OK();
+}
+
+// Hand the newest `count` magazine slots back to the depot.
+static void metagraph_tl_flush(metagraph_thread_local_pool_t *pool,
+                               uint32_t size_class,
+                               metagraph_tl_magazine_t *magazine,
+                               uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+    metagraph_free_slot_t *head = NULL;
+    metagraph_free_slot_t *tail = NULL;
+    for (uint32_t i = 0; i < count; i++) {
+        metagraph_free_slot_t *slot = magazine->slots[--magazine->count];
+        slot->next = head;
+        head = slot;
+        if (!tail) {
+            tail = slot;
+        }
+    }
+    metagraph_tl_depot_t *depot = &pool->depots[size_class];
+    metagraph_mutex_lock(&depot->lock);
+    tail->next = depot->free_slots;
+    depot->free_slots = head;
+    metagraph_mutex_unlock(&depot->lock);
+}
+
+metagraph_result_t
+metagraph_thread_local_pool_create(const metagraph_pool_config_t *config,
+                                   metagraph_thread_local_pool_t **out_pool) {
+    METAGRAPH_CHECK_NULL(out_pool);
+    *out_pool = NULL;
+
+    const size_t alignment = config && config->alignment
+                                 ? config->alignment
+                                 : METAGRAPH_POOL_DEFAULT_ALIGNMENT;
+    if (!metagraph_memory_is_pow2(alignment) ||
+        alignment > METAGRAPH_TL_MAX_ALIGNMENT) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ALIGNMENT_VALUE,
+                             "Thread-local pool alignment %zu unsupported",
+                             alignment);
+    }
+
+    metagraph_thread_local_pool_t *pool = calloc(1, sizeof(*pool));
+    METAGRAPH_CHECK_ALLOC(pool);
+    pool->id = atomic_fetch_add_explicit(&metagraph_tl_next_pool_id, 1,
+                                         memory_order_relaxed);
+    pool->max_size = config ? config->max_size : 0;
+    pool->min_class_size = alignment;
+
+    uint32_t depots_ready = 0;
+    if (metagraph_mutex_init(&pool->lock) != 0) {
+        goto fail;
+    }
+    for (; depots_ready < METAGRAPH_TL_CLASS_COUNT; depots_ready++) {
+        if (metagraph_mutex_init(&pool->depots[depots_ready].lock) != 0) {
+            metagraph_mutex_destroy(&pool->lock);
+            goto fail;
+        }
+    }
+    *out_pool = pool;
+    return METAGRAPH_OK();
+
+fail:
+    while (depots_ready-- > 0) {
+        metagraph_mutex_destroy(&pool->depots[depots_ready].lock);
+    }
+    free(pool);
+    return METAGRAPH_ERR(METAGRAPH_ERROR_RESOURCE_EXHAUSTED,
+                         "Failed to initialize thread-local pool locks");
+}
+
+metagraph_result_t
+metagraph_thread_local_pool_destroy(metagraph_thread_local_pool_t *pool) {
+    if (!pool) {
+        return METAGRAPH_OK();
+    }
+    metagraph_tl_slab_t *slab = pool->slabs;
+    while (slab) {
+        metagraph_tl_slab_t *next = slab->next;
+        metagraph_aligned_free(slab);
+        slab = next;
+    }
+    metagraph_tl_cache_t *cache = pool->caches;
+    while (cache) {
+        metagraph_tl_cache_t *next = cache->next;
+        free(cache);
+        cache = next;
+    }
+    for (uint32_t i = 0; i < METAGRAPH_TL_CLASS_COUNT; i++) {
+        metagraph_mutex_destroy(&pool->depots[i].lock);
+    }
+    metagraph_mutex_destroy(&pool->lock);
+    free(pool);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_thread_local_alloc(metagraph_thread_local_pool_t *pool, size_t size,
+                             void **out_ptr) {
+    METAGRAPH_CHECK_NULL(pool);
+    METAGRAPH_CHECK_NULL(out_ptr);
+    *out_ptr = NULL;
+    if (size == 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Zero-byte pool allocation");
+    }
+
+    if (size > METAGRAPH_THREAD_LOCAL_MAX_SMALL_SIZE) {
+        const size_t bytes = metagraph_memory_align_up(
+            size + METAGRAPH_TL_SLAB_HEADER, METAGRAPH_TL_SLAB_SIZE);
+        if (bytes < size) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                                 "Allocation of %zu bytes overflows", size);
+        }
+        metagraph_tl_slab_t *slab = NULL;
+        METAGRAPH_CHECK(metagraph_tl_slab_create(
+            pool, METAGRAPH_TL_LARGE_CLASS, bytes, &slab));
+        *out_ptr = (unsigned char *)(void *)slab + METAGRAPH_TL_SLAB_HEADER;
+        metagraph_metrics_add(METAGRAPH_COUNTER_POOL_ALLOCS, 1U);
+        return METAGRAPH_OK();
+    }
+
+    const uint32_t size_class = metagraph_tl_size_class(
+        size > pool->min_class_size ? size : pool->min_class_size);
+    metagraph_tl_cache_t *cache = metagraph_tl_cache_lookup(pool);
+    if (!cache) {
+        METAGRAPH_CHECK(metagraph_tl_cache_bind(pool, &cache));
+    }
+    metagraph_tl_magazine_t *magazine = &cache->magazines[size_class];
+    if (magazine->count == 0) {
+        METAGRAPH_CHECK(metagraph_tl_refill(pool, size_class, magazine));
+    }
+    *out_ptr = magazine->slots[--magazine->count];
+    metagraph_metrics_add(METAGRAPH_COUNTER_POOL_ALLOCS, 1U);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_thread_local_free(metagraph_thread_local_pool_t *pool, void *ptr) {
+    METAGRAPH_CHECK_NULL(pool);
+    if (!ptr) {
+        return METAGRAPH_OK();
+    }
+    metagraph_tl_slab_t *slab = metagraph_tl_slab_of(ptr);
+    if (slab->magic != METAGRAPH_TL_SLAB_MAGIC || slab->pool != pool) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Pointer was not allocated from this pool");
+    }
+
+    if (slab->size_class == METAGRAPH_TL_LARGE_CLASS) {
+        metagraph_mutex_lock(&pool->lock);
+        if (slab->prev) {
+            slab->prev->next = slab->next;
+        } else {
+            pool->slabs = slab->next;
+        }
+        if (slab->next) {
+            slab->next->prev = slab->prev;
+        }
+        pool->reserved -= slab->bytes;
+        metagraph_mutex_unlock(&pool->lock);
+        slab->magic = 0;
+        metagraph_aligned_free(slab);
+        return METAGRAPH_OK();
+    }
+
+    metagraph_tl_cache_t *cache = metagraph_tl_cache_lookup(pool);
+    if (!cache) {
+        METAGRAPH_CHECK(metagraph_tl_cache_bind(pool, &cache));
+    }
+    metagraph_tl_magazine_t *magazine = &cache->magazines[slab->size_class];
+    if (magazine->count == METAGRAPH_TL_MAGAZINE_SIZE) {
+        metagraph_tl_flush(pool, slab->size_class, magazine,
+                           METAGRAPH_TL_BATCH);
+    }
+    magazine->slots[magazine->count++] = ptr;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_thread_local_pool_flush(metagraph_thread_local_pool_t *pool) {
+    METAGRAPH_CHECK_NULL(pool);
+    metagraph_tl_cache_t *cache = metagraph_tl_cache_lookup(pool);
+    if (!cache) {
+        return METAGRAPH_OK();
+    }
+    for (uint32_t i = 0; i < METAGRAPH_TL_CLASS_COUNT; i++) {
+        metagraph_tl_flush(pool, i, &cache->magazines[i],
+                           cache->magazines[i].count);
+    }
+    return METAGRAPH_OK();
+}
@@ -0,0 +1,352 @@
+/**
+ * @file merkle.c
+ * @brief Merkle trees whose nodes are BLAKE3 chaining values
+ *
+ * Leaves are whole power-of-two runs of BLAKE3 chunks, so each leaf is a
+ * subtree of BLAKE3's own tree and the tree root is the plain BLAKE3 hash
+ * of the data. Leaves are hashed independently, which makes both building
+ * (spread over the shared scheduler) and checking a single leaf cheap.
+ */
+
+#include "metagraph/integrity.h"
+#include "metagraph/result.h"
+
+#include "blake3_internal.h"
+#include "work_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+size_t metagraph_merkle_leaf_count(size_t size, size_t chunk_size) {
+    if (size == 0) {
+        return 1;
+    }
+    return (size - 1U) / chunk_size + 1U;
+}
+
+// Bytes in leaf index of a size-byte buffer
+static size_t metagraph_merkle_leaf_size(size_t size, size_t chunk_size,
+                                         size_t index) {
+    const size_t offset = index * chunk_size;
+    const size_t remaining = size - offset;
+    return remaining < chunk_size ? remaining : chunk_size;
+}
+
+static void metagraph_merkle_leaf_cv(const uint8_t *data, size_t size,
+                                     size_t chunk_size, size_t index,
+                                     metagraph_blake3_hash_t *out) {
+    const size_t offset = index * chunk_size;
+    metagraph_blake3_subtree_cv(
+        data + offset, metagraph_merkle_leaf_size(size, chunk_size, index),
+        offset / METAGRAPH_BLAKE3_CHUNK_LEN, 1, out->bytes);
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t chunk_size;
+    metagraph_blake3_hash_t *leaves;
+} metagraph_merkle_job_t;
+
+static void metagraph_merkle_leaf_range(void *context, uint32_t worker,
+                                        size_t begin, size_t end) {
+    (void)worker;
+    const metagraph_merkle_job_t *job = context;
+    for (size_t i = begin; i < end; i++) {
+        metagraph_merkle_leaf_cv(job->data, job->size, job->chunk_size, i,
+                                 &job->leaves[i]);
+    }
+}
+
+void metagraph_merkle_hash_leaves(const uint8_t *data, size_t size,
+                                  size_t chunk_size, uint32_t threads,
+                                  metagraph_blake3_hash_t *leaves) {
+    const size_t count = metagraph_merkle_leaf_count(size, chunk_size);
+    metagraph_merkle_job_t job = {
+        .data = data,
+        .size = size,
+        .chunk_size = chunk_size,
+        .leaves = leaves,
+    };
+    metagraph_work_pool_t *pool = NULL;
+    if (threads <= 1U || count <= 1U ||
+        metagraph_work_pool_create(threads, &pool) != METAGRAPH_SUCCESS) {
+        metagraph_merkle_leaf_range(&job, 0, 0, count);
+        return;
+    }
+    // Leaves are equal-sized, so one per grain balances by stealing.
+    metagraph_work_pool_for(pool, count, 1, metagraph_merkle_leaf_range, &job);
+    metagraph_work_pool_destroy(pool);
+}
+
+// One level up: pair neighbours, carry an odd last node unchanged.
+static size_t metagraph_merkle_parent_level(const metagraph_blake3_hash_t *in,
+                                            size_t count,
+                                            metagraph_blake3_hash_t *out) {
+    const size_t pairs = count / 2U;
+    for (size_t i = 0; i < pairs; i++) {
+        metagraph_blake3_parent(in[2U * i].bytes, in[2U * i + 1U].bytes, false,
+                                out[i].bytes);
+    }
+    if (count % 2U != 0) {
+        out[pairs] = in[count - 1U];
+    }
+    return pairs + count % 2U;
+}
+
+void metagraph_merkle_fold(const metagraph_blake3_hash_t *leaves, size_t count,
+                           metagraph_blake3_hash_t *scratch,
+                           metagraph_blake3_hash_t *out_root) {
+    const metagraph_blake3_hash_t *level = leaves;
+    while (count > 2U) {
+        count = metagraph_merkle_parent_level(level, count, scratch);
+        level = scratch;
+    }
+    metagraph_blake3_parent(level[0].bytes, level[1].bytes, true,
+                            out_root->bytes);
+}
+
+static metagraph_result_t metagraph_merkle_check_chunk_size(size_t chunk_size) {
+    if (chunk_size < METAGRAPH_BLAKE3_CHUNK_LEN ||
+        (chunk_size & (chunk_size - 1U)) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Merkle chunk size %zu is not a power of two "
+                             ">= %u",
+                             chunk_size, (unsigned)METAGRAPH_BLAKE3_CHUNK_LEN);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_merkle_tree_create(const void *data,
+                                                size_t data_size,
+                                                size_t chunk_size,
+                                                metagraph_merkle_tree_t **out_tree) {
+    METAGRAPH_CHECK_NULL(out_tree);
+    if (!data && data_size > 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NULL_POINTER,
+                             "NULL data with non-zero size");
+    }
+    if (chunk_size == 0) {
+        chunk_size = METAGRAPH_MERKLE_DEFAULT_CHUNK_SIZE;
+    }
+    METAGRAPH_CHECK(metagraph_merkle_check_chunk_size(chunk_size));
+
+    const size_t leaf_count = metagraph_merkle_leaf_count(data_size, chunk_size);
+    size_t level_count = 1;
+    for (size_t n = leaf_count; n > 2U; n = (n + 1U) / 2U) {
+        level_count++;
+    }
+
+    metagraph_merkle_tree_t *tree = calloc(1, sizeof(*tree));
+    METAGRAPH_CHECK_ALLOC(tree);
+    tree->levels = calloc(level_count, sizeof(*tree->levels));
+    if (!tree->levels) {
+        free(tree);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate %zu Merkle levels",
+                             level_count);
+    }
+    tree->level_count = level_count;
+    tree->chunk_size = chunk_size;
+    tree->data_size = data_size;
+
+    size_t count = leaf_count;
+    for (size_t level = 0; level < level_count; level++) {
+        tree->levels[level].hashes = calloc(count, sizeof(metagraph_blake3_hash_t));
+        if (!tree->levels[level].hashes) {
+            (void)metagraph_merkle_tree_destroy(tree);
+            return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                 "Failed to allocate %zu Merkle nodes", count);
+        }
+        tree->levels[level].count = count;
+        count = (count + 1U) / 2U;
+    }
+
+    const uint8_t *bytes = data;
+    metagraph_merkle_hash_leaves(bytes, data_size, chunk_size,
+                                 metagraph_blake3_thread_budget(data_size),
+                                 tree->levels[0].hashes);
+    for (size_t level = 1; level < level_count; level++) {
+        (void)metagraph_merkle_parent_level(tree->levels[level - 1U].hashes,
+                                            tree->levels[level - 1U].count,
+                                            tree->levels[level].hashes);
+    }
+
+    const metagraph_merkle_level_t *top = &tree->levels[level_count - 1U];
+    if (top->count == 1U) {
+        // A single leaf is the whole input: its root needs the ROOT flag
+        // on the final chunk, not a parent node.
+        metagraph_blake3_root(bytes, data_size, 1, tree->root_hash.bytes);
+    } else {
+        metagraph_blake3_parent(top->hashes[0].bytes, top->hashes[1].bytes,
+                                true, tree->root_hash.bytes);
+    }
+
+    *out_tree = tree;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_merkle_tree_destroy(metagraph_merkle_tree_t *tree) {
+    if (!tree) {
+        return METAGRAPH_OK();
+    }
+    if (tree->levels) {
+        for (size_t level = 0; level < tree->level_count; level++) {
+            free(tree->levels[level].hashes);
+        }
+        free(tree->levels);
+    }
+    free(tree);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_merkle_tree_verify_chunk(const metagraph_merkle_tree_t *tree,
+                                   size_t chunk_index, const void *chunk_data,
+                                   size_t chunk_size) {
+    METAGRAPH_CHECK_NULL(tree);
+    const size_t leaf_count = tree->levels[0].count;
+    if (chunk_index >= leaf_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Chunk %zu out of range (%zu chunks)", chunk_index,
+                             leaf_count);
+    }
+    if (!chunk_data && chunk_size > 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NULL_POINTER,
+                             "NULL chunk with non-zero size");
+    }
+    const size_t expected_size =
+        metagraph_merkle_leaf_size(tree->data_size, tree->chunk_size,
+                                   chunk_index);
+    if (chunk_size != expected_size) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                             "Chunk %zu is %zu bytes, expected %zu",
+                             chunk_index, chunk_size, expected_size);
+    }
+    metagraph_blake3_hash_t actual;
+    metagraph_blake3_subtree_cv(chunk_data, chunk_size,
+                                chunk_index * tree->chunk_size /
+                                    METAGRAPH_BLAKE3_CHUNK_LEN,
+                                1, actual.bytes);
+    if (memcmp(actual.bytes, tree->levels[0].hashes[chunk_index].bytes,
+               sizeof(actual.bytes)) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                             "Chunk %zu does not match its Merkle leaf",
+                             chunk_index);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_merkle_tree_verify_range(const metagraph_merkle_tree_t *tree,
+                                   const void *data, size_t offset,
+                                   size_t size) {
+    METAGRAPH_CHECK_NULL(tree);
+    METAGRAPH_CHECK_NULL(data);
+    if (offset > tree->data_size || size > tree->data_size - offset) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Range [%zu, +%zu) exceeds %zu bytes", offset,
+                             size, tree->data_size);
+    }
+    if (size == 0) {
+        return METAGRAPH_OK();
+    }
+    const uint8_t *bytes = data;
+    const size_t first = offset / tree->chunk_size;
+    const size_t last = (offset + size - 1U) / tree->chunk_size;
+    for (size_t i = first; i <= last; i++) {
+        METAGRAPH_CHECK(metagraph_merkle_tree_verify_chunk(
+            tree, i, bytes + i * tree->chunk_size,
+            metagraph_merkle_leaf_size(tree->data_size, tree->chunk_size, i)));
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_merkle_tree_get_proof(const metagraph_merkle_tree_t *tree,
+                                size_t chunk_index,
+                                metagraph_merkle_proof_t *out_proof) {
+    METAGRAPH_CHECK_NULL(tree);
+    METAGRAPH_CHECK_NULL(out_proof);
+    if (chunk_index >= tree->levels[0].count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Chunk %zu out of range (%zu chunks)", chunk_index,
+                             tree->levels[0].count);
+    }
+    memset(out_proof, 0, sizeof(*out_proof));
+    out_proof->chunk_index = chunk_index;
+    out_proof->chunk_count = tree->levels[0].count;
+    out_proof->chunk_size = tree->chunk_size;
+
+    // Siblings bottom-up; a node carried up unchanged has none at that
+    // level, which the verifier re-derives from index and count.
+    size_t index = chunk_index;
+    for (size_t level = 0; level < tree->level_count; level++) {
+        const metagraph_merkle_level_t *nodes = &tree->levels[level];
+        const size_t sibling = index ^ 1U;
+        if (sibling < nodes->count) {
+            out_proof->siblings[out_proof->length++] = nodes->hashes[sibling];
+        }
+        index /= 2U;
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_merkle_verify_proof(const void *chunk_data, size_t chunk_size,
+                              const metagraph_merkle_proof_t *proof,
+                              const metagraph_blake3_hash_t *root_hash) {
+    METAGRAPH_CHECK_NULL(proof);
+    METAGRAPH_CHECK_NULL(root_hash);
+    if (!chunk_data && chunk_size > 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NULL_POINTER,
+                             "NULL chunk with non-zero size");
+    }
+    if (proof->chunk_index >= proof->chunk_count ||
+        metagraph_result_is_error(
+            metagraph_merkle_check_chunk_size(proof->chunk_size)) ||
+        chunk_size > proof->chunk_size) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Malformed Merkle proof");
+    }
+
+    metagraph_blake3_hash_t node;
+    if (proof->chunk_count == 1U) {
+        metagraph_blake3_root(chunk_data, chunk_size, 1, node.bytes);
+    } else {
+        metagraph_blake3_subtree_cv(
+            chunk_data, chunk_size,
+            proof->chunk_index * proof->chunk_size / METAGRAPH_BLAKE3_CHUNK_LEN,
+            1, node.bytes);
+        size_t index = proof->chunk_index;
+        size_t count = proof->chunk_count;
+        size_t used = 0;
+        while (count > 1U) {
+            const size_t sibling = index ^ 1U;
+            if (sibling < count) {
+                if (used >= proof->length) {
+                    return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                                         "Merkle proof is too short");
+                }
+                const bool root = count == 2U;
+                const uint8_t *other = proof->siblings[used++].bytes;
+                if (index % 2U == 0) {
+                    metagraph_blake3_parent(node.bytes, other, root,
+                                            node.bytes);
+                } else {
+                    metagraph_blake3_parent(other, node.bytes, root,
+                                            node.bytes);
+                }
+            }
+            index /= 2U;
+            count = (count + 1U) / 2U;
+        }
+    }
+
+    if (memcmp(node.bytes, root_hash->bytes, sizeof(node.bytes)) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_CHECKSUM_MISMATCH,
+                             "Chunk %zu does not match the Merkle root",
+                             proof->chunk_index);
+    }
+    return METAGRAPH_OK();
+}
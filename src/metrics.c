@@ -0,0 +1,188 @@
+/**
+ * @file metrics.c
+ * @brief Shard registry and merge-on-read snapshots
+ *
+ * A thread gets its shard on first use: a spare one left by an exited
+ * thread if there is one, otherwise a fresh allocation linked into the
+ * registry list. Shards are never freed, so counts recorded by threads
+ * that have exited stay in every later snapshot, and the registry grows
+ * only to the peak number of threads that reported at once.
+ */
+
+#include "metagraph/metrics.h"
+#include "metrics_internal.h"
+#include "platform.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static struct {
+    metagraph_once_t once;
+    metagraph_mutex_t lock; ///< Guards shards and spares
+    metagraph_thread_key_t key;
+    bool key_ready;
+    metagraph_metrics_shard_t *shards;
+    metagraph_metrics_shard_t *spares;
+    uint32_t shard_count;
+} metagraph_metrics_registry;
+
+// Threads that could not get a shard record here; never merged.
+static metagraph_metrics_shard_t metagraph_metrics_discard;
+
+METAGRAPH_THREAD_LOCAL metagraph_metrics_shard_t *metagraph_metrics_local;
+
+static const char *const METAGRAPH_COUNTER_NAMES[METAGRAPH_COUNTER_COUNT] = {
+    "lookups",      "hydrations",      "minor_faults", "major_faults",
+    "pool_allocs",  "traversal_steps", "errors",
+};
+
+static const char *const METAGRAPH_HISTOGRAM_NAMES[METAGRAPH_HISTOGRAM_COUNT] =
+    {"lookup_ns", "hydration_ns", "traversal_ns"};
+
+// Runs at thread exit: the shard's counts stay, the shard is reused.
+// Destructors that run after this one may still record; they go to the
+// discard shard rather than into a shard another thread now owns.
+static void metagraph_metrics_detach(void *value) {
+    metagraph_metrics_shard_t *shard = value;
+    metagraph_metrics_local = &metagraph_metrics_discard;
+    metagraph_mutex_lock(&metagraph_metrics_registry.lock);
+    shard->spare = metagraph_metrics_registry.spares;
+    metagraph_metrics_registry.spares = shard;
+    metagraph_mutex_unlock(&metagraph_metrics_registry.lock);
+}
+
+static void metagraph_metrics_build(void) {
+    (void)metagraph_mutex_init(&metagraph_metrics_registry.lock);
+    // Without an exit hook shards are simply not recycled.
+    metagraph_metrics_registry.key_ready =
+        metagraph_thread_key_create(&metagraph_metrics_registry.key,
+                                    metagraph_metrics_detach) == 0;
+}
+
+static void metagraph_metrics_init(void) {
+    metagraph_once(&metagraph_metrics_registry.once, metagraph_metrics_build);
+}
+
+metagraph_metrics_shard_t *metagraph_metrics_attach(void) {
+    metagraph_metrics_init();
+    metagraph_mutex_lock(&metagraph_metrics_registry.lock);
+    metagraph_metrics_shard_t *shard = metagraph_metrics_registry.spares;
+    if (shard) {
+        metagraph_metrics_registry.spares = shard->spare;
+    } else {
+        shard = calloc(1, sizeof(*shard));
+        if (shard) {
+            shard->next = metagraph_metrics_registry.shards;
+            metagraph_metrics_registry.shards = shard;
+            metagraph_metrics_registry.shard_count++;
+        }
+    }
+    metagraph_mutex_unlock(&metagraph_metrics_registry.lock);
+
+    if (!shard) {
+        shard = &metagraph_metrics_discard;
+    } else if (metagraph_metrics_registry.key_ready) {
+        (void)metagraph_thread_key_set(metagraph_metrics_registry.key, shard);
+    }
+    metagraph_metrics_local = shard;
+    return shard;
+}
+
+metagraph_result_t
+metagraph_metrics_snapshot(metagraph_metrics_snapshot_t *out_snapshot) {
+    METAGRAPH_CHECK_NULL(out_snapshot);
+    memset(out_snapshot, 0, sizeof(*out_snapshot));
+    metagraph_metrics_init();
+
+    metagraph_mutex_lock(&metagraph_metrics_registry.lock);
+    for (const metagraph_metrics_shard_t *shard =
+             metagraph_metrics_registry.shards;
+         shard; shard = shard->next) {
+        for (uint32_t i = 0; i < METAGRAPH_COUNTER_COUNT; i++) {
+            out_snapshot->counters[i] += atomic_load_explicit(
+                &shard->counters[i], memory_order_relaxed);
+        }
+        for (uint32_t h = 0; h < METAGRAPH_HISTOGRAM_COUNT; h++) {
+            metagraph_histogram_snapshot_t *histogram =
+                &out_snapshot->histograms[h];
+            histogram->sum +=
+                atomic_load_explicit(&shard->sums[h], memory_order_relaxed);
+            for (uint32_t b = 0; b < METAGRAPH_METRICS_BUCKETS; b++) {
+                const uint64_t count = atomic_load_explicit(
+                    &shard->buckets[h][b], memory_order_relaxed);
+                histogram->buckets[b] += count;
+                histogram->count += count;
+            }
+        }
+        for (uint32_t i = 0; i < METAGRAPH_METRICS_ERROR_SLOTS; i++) {
+            out_snapshot->errors[i] +=
+                atomic_load_explicit(&shard->errors[i], memory_order_relaxed);
+        }
+    }
+    out_snapshot->shard_count = metagraph_metrics_registry.shard_count;
+    metagraph_mutex_unlock(&metagraph_metrics_registry.lock);
+    return METAGRAPH_OK();
+}
+
+uint64_t
+metagraph_metrics_error_count(const metagraph_metrics_snapshot_t *snapshot,
+                              metagraph_result_t code) {
+    if (!snapshot) {
+        return 0;
+    }
+    return snapshot->errors[metagraph_metrics_error_slot(code)];
+}
+
+uint64_t metagraph_metrics_bucket_lower_bound(uint32_t bucket) {
+    if (bucket >= METAGRAPH_METRICS_BUCKETS) {
+        bucket = METAGRAPH_METRICS_BUCKETS - 1U;
+    }
+    if (bucket < 32U) {
+        return bucket;
+    }
+    const uint32_t msb = bucket / 16U + 3U;
+    return (uint64_t)(16U + bucket % 16U) << (msb - 4U);
+}
+
+uint64_t
+metagraph_metrics_quantile(const metagraph_histogram_snapshot_t *histogram,
+                           double quantile) {
+    if (!histogram || histogram->count == 0) {
+        return 0;
+    }
+    if (!(quantile > 0.0)) {
+        quantile = 0.0;
+    } else if (quantile > 1.0) {
+        quantile = 1.0;
+    }
+    // Rank of the wanted value, 1-based, so quantile 0 is the minimum.
+    uint64_t rank = (uint64_t)(quantile * (double)histogram->count);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < METAGRAPH_METRICS_BUCKETS; b++) {
+        seen += histogram->buckets[b];
+        if (seen >= rank) {
+            return metagraph_metrics_bucket_lower_bound(b);
+        }
+    }
+    return metagraph_metrics_bucket_lower_bound(METAGRAPH_METRICS_BUCKETS -
+                                                1U);
+}
+
+const char *metagraph_metrics_counter_name(metagraph_counter_t counter) {
+    return (uint32_t)counter < METAGRAPH_COUNTER_COUNT
+               ? METAGRAPH_COUNTER_NAMES[counter]
+               : "unknown";
+}
+
+const char *metagraph_metrics_histogram_name(metagraph_histogram_t histogram) {
+    return (uint32_t)histogram < METAGRAPH_HISTOGRAM_COUNT
+               ? METAGRAPH_HISTOGRAM_NAMES[histogram]
+               : "unknown";
+}
@@ -0,0 +1,133 @@
+/**
+ * @file metrics_internal.h
+ * @brief Recording side of the metrics registry
+ *
+ * Recording is inline so an event compiles to a thread-local load and an
+ * add. Only the owning thread writes its shard, which is why a plain
+ * relaxed load and store stand in for an atomic read-modify-write: the
+ * atomics exist so snapshot readers never see a torn value.
+ */
+
+#ifndef SRC_METRICS_INTERNAL_H
+#define SRC_METRICS_INTERNAL_H
+
+#include "metagraph/metrics.h"
+#include "platform.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Lookups timed: one in (mask + 1) per thread
+#define METAGRAPH_METRICS_SAMPLE_MASK 63U
+
+typedef struct metagraph_metrics_shard {
+    _Atomic(uint64_t) counters[METAGRAPH_COUNTER_COUNT];
+    _Atomic(uint64_t) sums[METAGRAPH_HISTOGRAM_COUNT];
+    _Atomic(uint64_t) buckets[METAGRAPH_HISTOGRAM_COUNT]
+                             [METAGRAPH_METRICS_BUCKETS];
+    _Atomic(uint64_t) errors[METAGRAPH_METRICS_ERROR_SLOTS];
+    uint32_t sample_clock;                 ///< Owner only
+    struct metagraph_metrics_shard *next;  ///< Registry list, never unlinked
+    struct metagraph_metrics_shard *spare; ///< Free list of exited threads'
+} metagraph_metrics_shard_t;
+
+extern METAGRAPH_THREAD_LOCAL metagraph_metrics_shard_t
+    *metagraph_metrics_local;
+
+/**
+ * @brief Give the calling thread a shard (never NULL)
+ *
+ * If no shard can be allocated, the thread records into a shared shard
+ * that snapshots ignore.
+ */
+metagraph_metrics_shard_t *metagraph_metrics_attach(void);
+
+static inline metagraph_metrics_shard_t *metagraph_metrics_shard(void) {
+    metagraph_metrics_shard_t *shard = metagraph_metrics_local;
+    return shard ? shard : metagraph_metrics_attach();
+}
+
+static inline void metagraph_metrics_bump(_Atomic(uint64_t) *cell,
+                                          uint64_t amount) {
+    atomic_store_explicit(
+        cell, atomic_load_explicit(cell, memory_order_relaxed) + amount,
+        memory_order_relaxed);
+}
+
+static inline void metagraph_metrics_add(metagraph_counter_t counter,
+                                         uint64_t amount) {
+    metagraph_metrics_bump(&metagraph_metrics_shard()->counters[counter],
+                           amount);
+}
+
+// Values below 32 map to themselves; above, 16 buckets per power of two.
+static inline uint32_t metagraph_metrics_bucket(uint64_t value) {
+    if (value < 32U) {
+        return (uint32_t)value;
+    }
+#if defined(__GNUC__)
+    const uint32_t msb = 63U - (uint32_t)__builtin_clzll(value);
+#else
+    uint32_t msb = 0;
+    for (uint64_t rest = value >> 1U; rest; rest >>= 1U) {
+        msb++;
+    }
+#endif
+    const uint32_t bucket =
+        (msb - 3U) * 16U + (uint32_t)((value >> (msb - 4U)) & 15U);
+    return bucket < METAGRAPH_METRICS_BUCKETS ? bucket
+                                              : METAGRAPH_METRICS_BUCKETS - 1U;
+}
+
+static inline void metagraph_metrics_record(metagraph_histogram_t histogram,
+                                            uint64_t value) {
+    metagraph_metrics_shard_t *shard = metagraph_metrics_shard();
+    metagraph_metrics_bump(
+        &shard->buckets[histogram][metagraph_metrics_bucket(value)], 1U);
+    metagraph_metrics_bump(&shard->sums[histogram], value);
+}
+
+// Sixteen slots per hundred codes; the last takes the category's tail.
+static inline uint32_t metagraph_metrics_error_slot(metagraph_result_t code) {
+    const uint32_t value = (uint32_t)code;
+    const uint32_t category = value / 100U < 9U ? value / 100U : 9U;
+    const uint32_t offset = value % 100U < 15U ? value % 100U : 15U;
+    return category * 16U + offset;
+}
+
+/**
+ * @brief Count an error report
+ */
+static inline void metagraph_metrics_error(metagraph_result_t code) {
+    metagraph_metrics_shard_t *shard = metagraph_metrics_shard();
+    metagraph_metrics_bump(&shard->counters[METAGRAPH_COUNTER_ERRORS], 1U);
+    metagraph_metrics_bump(&shard->errors[metagraph_metrics_error_slot(code)],
+                           1U);
+}
+
+/**
+ * @brief Count a lookup; returns a start time if this one is sampled
+ *
+ * Pass the result to metagraph_metrics_end(); 0 means not sampled.
+ */
+static inline uint64_t metagraph_metrics_begin_lookup(void) {
+    metagraph_metrics_shard_t *shard = metagraph_metrics_shard();
+    metagraph_metrics_bump(&shard->counters[METAGRAPH_COUNTER_LOOKUPS], 1U);
+    if ((++shard->sample_clock & METAGRAPH_METRICS_SAMPLE_MASK) != 0) {
+        return 0;
+    }
+    const uint64_t now = metagraph_monotonic_ns();
+    return now ? now : 1U;
+}
+
+/**
+ * @brief Record the time since start, unless start is 0
+ */
+static inline void metagraph_metrics_end(metagraph_histogram_t histogram,
+                                         uint64_t start) {
+    if (start) {
+        metagraph_metrics_record(histogram, metagraph_monotonic_ns() - start);
+    }
+}
+
+#endif // SRC_METRICS_INTERNAL_H
@@ -0,0 +1,451 @@
+/**
+ * @file mmap.c
+ * @brief POSIX memory mapping and offset pointer hydration
+ */
+
+#include "metagraph/mmap.h"
+#include "metagraph/result.h"
+
+#include "read_ahead.h"
+#include "trace_internal.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define METAGRAPH_HAVE_POSIX_MMAP 1
+#else
+#define METAGRAPH_HAVE_POSIX_MMAP 0
+#endif
+
+// Bookkeeping for the page-aligned region the OS actually mapped
+typedef struct {
+    void *region;         // Page-aligned start (NULL for memory wrappers)
+    size_t region_length; // Length passed to mmap
+    uint64_t offset;      // File offset of base_address
+    int fd;               // Kept open for read-ahead
+} metagraph_map_region_t;
+
+#if METAGRAPH_HAVE_POSIX_MMAP
+
+static metagraph_result_t metagraph_mmap_open_error(const char *file_path,
+                                                    int error_number) {
+    switch (error_number) {
+    case ENOENT:
+    case ENOTDIR:
+        return METAGRAPH_ERR(METAGRAPH_ERROR_FILE_NOT_FOUND,
+                             "File not found: %s", file_path);
+    case EACCES:
+    case EPERM:
+        return METAGRAPH_ERR(METAGRAPH_ERROR_FILE_ACCESS_DENIED,
+                             "Access denied: %s", file_path);
+    default:
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Failed to open %s (errno %d)", file_path,
+                             error_number);
+    }
+}
+
+// madvise() flag for advice, or -1 when this platform has none.
+static int metagraph_mmap_advice_flag(metagraph_memory_advice_t advice) {
+    switch (advice) {
+    case METAGRAPH_ADVICE_SEQUENTIAL:
+        return MADV_SEQUENTIAL;
+    case METAGRAPH_ADVICE_RANDOM:
+        return MADV_RANDOM;
+    case METAGRAPH_ADVICE_WILLNEED:
+        return MADV_WILLNEED;
+    case METAGRAPH_ADVICE_DONTNEED:
+    case METAGRAPH_ADVICE_NOREUSE:
+        // MADV_DONTNEED on a private file mapping only drops the pages,
+        // which is exactly what NOREUSE means for read-only bundles.
+        return MADV_DONTNEED;
+#ifdef MADV_HUGEPAGE
+    case METAGRAPH_ADVICE_HUGEPAGE:
+        return MADV_HUGEPAGE;
+    case METAGRAPH_ADVICE_NOHUGEPAGE:
+        return MADV_NOHUGEPAGE;
+#endif
+#ifdef MADV_COLD
+    case METAGRAPH_ADVICE_COLD:
+        return MADV_COLD;
+    case METAGRAPH_ADVICE_PAGEOUT:
+        return MADV_PAGEOUT;
+#endif
+    case METAGRAPH_ADVICE_NORMAL:
+        return MADV_NORMAL;
+    default:
+        return -1;
+    }
+}
+
+static uintptr_t metagraph_mmap_page_size(void) {
+    const long page_size = sysconf(_SC_PAGESIZE);
+    return page_size > 0 ? (uintptr_t)page_size : 4096U;
+}
+
+static metagraph_result_t
+metagraph_mmap_map_fd(int fd, const char *file_path, size_t file_size,
+                      const metagraph_mapping_request_t *request,
+                      metagraph_memory_map_t *map,
+                      metagraph_map_region_t *region) {
+    const uint64_t page = metagraph_mmap_page_size();
+
+    if (request->offset >= file_size) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Offset %llu beyond end of %s (%zu bytes)",
+                             (unsigned long long)request->offset, file_path,
+                             file_size);
+    }
+    size_t length = request->size ? request->size
+                                  : file_size - (size_t)request->offset;
+    if (length > file_size - (size_t)request->offset) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Mapping of %zu bytes at %llu exceeds %s", length,
+                             (unsigned long long)request->offset, file_path);
+    }
+
+    const uint64_t aligned_offset = request->offset - (request->offset % page);
+    const size_t lead = (size_t)(request->offset - aligned_offset);
+    const bool writable =
+        (request->access_flags & METAGRAPH_MAP_ACCESS_WRITE) != 0U;
+
+    int flags = writable ? MAP_SHARED : MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (request->cache_flags & METAGRAPH_MAP_CACHE_POPULATE) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    const int protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void *address = mmap(NULL, length + lead, protection, flags, fd,
+                         (off_t)aligned_offset);
+    if (address == MAP_FAILED) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_MMAP_FAILED,
+                             "mmap of %s failed (errno %d)", file_path, errno);
+    }
+
+    region->region = address;
+    region->region_length = length + lead;
+    region->offset = request->offset;
+    map->base_address = (uint8_t *)address + lead;
+    map->mapped_size = length;
+    map->file_size = file_size;
+    map->is_writable = writable;
+    map->is_coherent = true;
+    return METAGRAPH_OK();
+}
+
+#endif // METAGRAPH_HAVE_POSIX_MMAP
+
+metagraph_result_t
+metagraph_mmap_create_from_file(const char *file_path,
+                                const metagraph_mapping_request_t *request,
+                                metagraph_memory_map_t **out_map) {
+    METAGRAPH_CHECK_NULL(file_path);
+    METAGRAPH_CHECK_NULL(out_map);
+    *out_map = NULL;
+
+#if METAGRAPH_HAVE_POSIX_MMAP
+    const metagraph_mapping_request_t whole_file = {
+        .access_flags = METAGRAPH_MAP_ACCESS_READ};
+    if (!request) {
+        request = &whole_file;
+    }
+    const bool writable =
+        (request->access_flags & METAGRAPH_MAP_ACCESS_WRITE) != 0U;
+
+    const int fd = open(file_path, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (fd < 0) {
+        return metagraph_mmap_open_error(file_path, errno);
+    }
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_memory_map_t *map = calloc(1, sizeof(*map));
+    metagraph_map_region_t *region = calloc(1, sizeof(*region));
+    if (!map || !region) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Failed to allocate mapping for %s", file_path);
+        goto fail;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                               "fstat of %s failed (errno %d)", file_path,
+                               errno);
+        goto fail;
+    }
+    if (info.st_size <= 0) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_MMAP_FAILED,
+                               "Cannot map empty file %s", file_path);
+        goto fail;
+    }
+
+    METAGRAPH_CHECK_GOTO(metagraph_mmap_map_fd(fd, file_path,
+                                               (size_t)info.st_size, request,
+                                               map, region),
+                         fail);
+    region->fd = fd;
+    map->platform_handle = region;
+    *out_map = map;
+    return METAGRAPH_OK();
+
+fail:
+    (void)close(fd);
+    free(region);
+    free(map);
+    return result;
+#else
+    (void)request;
+    return METAGRAPH_ERR(METAGRAPH_ERROR_PLATFORM_NOT_SUPPORTED,
+                         "Memory mapping is not supported on this platform");
+#endif
+}
+
+metagraph_result_t metagraph_mmap_create_from_memory(
+    void *buffer, size_t size, bool writable, metagraph_memory_map_t **out_map) {
+    METAGRAPH_CHECK_NULL(buffer);
+    METAGRAPH_CHECK_NULL(out_map);
+    *out_map = NULL;
+    if (size == 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Cannot map an empty buffer");
+    }
+
+    metagraph_memory_map_t *map = calloc(1, sizeof(*map));
+    METAGRAPH_CHECK_ALLOC(map);
+    map->base_address = buffer;
+    map->mapped_size = size;
+    map->file_size = size;
+    map->is_writable = writable;
+    map->is_coherent = false;
+    map->platform_handle = NULL;
+    *out_map = map;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_mmap_destroy(metagraph_memory_map_t *map) {
+    if (!map) {
+        return METAGRAPH_OK();
+    }
+    metagraph_map_region_t *region = map->platform_handle;
+#if METAGRAPH_HAVE_POSIX_MMAP
+    if (region && region->region) {
+        (void)munmap(region->region, region->region_length);
+    }
+    if (region) {
+        (void)close(region->fd);
+    }
+#endif
+    free(region);
+    free(map);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_mmap_sync(metagraph_memory_map_t *map,
+                                       uint64_t offset, size_t size) {
+    METAGRAPH_CHECK_NULL(map);
+    if (!map->is_writable || !map->platform_handle) {
+        return METAGRAPH_OK();
+    }
+#if METAGRAPH_HAVE_POSIX_MMAP
+    metagraph_map_region_t *region = map->platform_handle;
+    if (offset > map->mapped_size || size > map->mapped_size - offset) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Sync range exceeds mapping");
+    }
+    const size_t lead =
+        (size_t)((uint8_t *)map->base_address - (uint8_t *)region->region);
+    if (msync(region->region, lead + (size_t)offset + size, MS_SYNC) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "msync failed (errno %d)", errno);
+    }
+#endif
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_mmap_advise(metagraph_memory_map_t *map,
+                                         uint64_t offset, size_t size,
+                                         metagraph_memory_advice_t advice) {
+    METAGRAPH_CHECK_NULL(map);
+    if (offset > map->mapped_size || size > map->mapped_size - offset) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Advice range exceeds mapping");
+    }
+    if (!map->platform_handle || size == 0) {
+        return METAGRAPH_OK();
+    }
+#if METAGRAPH_HAVE_POSIX_MMAP
+    const int flag = metagraph_mmap_advice_flag(advice);
+    if (flag < 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_PLATFORM_NOT_SUPPORTED,
+                             "Advice %d is not available", (int)advice);
+    }
+    const uintptr_t page = metagraph_mmap_page_size();
+    const uintptr_t start = (uintptr_t)map->base_address + (uintptr_t)offset;
+    const uintptr_t aligned = start & ~(page - 1U);
+    if (madvise((void *)aligned, size + (start - aligned), flag) != 0) {
+        // Kernels reject advice they were built without with EINVAL.
+        if (errno == EINVAL && advice >= METAGRAPH_ADVICE_HUGEPAGE) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_PLATFORM_NOT_SUPPORTED,
+                                 "Advice %d rejected by the kernel",
+                                 (int)advice);
+        }
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "madvise failed (errno %d)", errno);
+    }
+#else
+    (void)advice;
+#endif
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_mmap_residency(const metagraph_memory_map_t *map,
+                                            uint64_t offset, size_t size,
+                                            size_t *out_resident,
+                                            size_t *out_pages) {
+    METAGRAPH_CHECK_NULL(map);
+    METAGRAPH_CHECK_NULL(out_resident);
+    METAGRAPH_CHECK_NULL(out_pages);
+    if (offset > map->mapped_size || size > map->mapped_size - offset) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Residency range exceeds mapping");
+    }
+#if METAGRAPH_HAVE_POSIX_MMAP
+    const uintptr_t page = metagraph_mmap_page_size();
+#else
+    const uintptr_t page = 4096U;
+#endif
+    const uintptr_t start = (uintptr_t)map->base_address + (uintptr_t)offset;
+    const uintptr_t aligned = start & ~(page - 1U);
+    const size_t pages = size ? (size + (start - aligned) + page - 1U) / page
+                              : 0;
+    *out_pages = pages;
+    *out_resident = pages;
+#if METAGRAPH_HAVE_POSIX_MMAP
+    if (!map->platform_handle || pages == 0) {
+        return METAGRAPH_OK();
+    }
+    unsigned char *vector = malloc(pages);
+    METAGRAPH_CHECK_ALLOC(vector);
+    if (mincore((void *)aligned, pages * page, (void *)vector) != 0) {
+        const int error_number = errno;
+        free(vector);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "mincore failed (errno %d)", error_number);
+    }
+    size_t resident = 0;
+    for (size_t i = 0; i < pages; i++) {
+        resident += vector[i] & 1U;
+    }
+    free(vector);
+    *out_resident = resident;
+#endif
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_mmap_read_ahead(const metagraph_memory_map_t *map,
+                          const metagraph_map_range_t *ranges, size_t count,
+                          const metagraph_read_ahead_options_t *options,
+                          metagraph_read_ahead_stats_t *out_stats) {
+    METAGRAPH_CHECK_NULL(map);
+    if (count) {
+        METAGRAPH_CHECK_NULL(ranges);
+    }
+    metagraph_read_ahead_stats_t stats = {.backend = METAGRAPH_READ_AHEAD_NONE};
+    if (out_stats) {
+        *out_stats = stats;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (ranges[i].offset > map->mapped_size ||
+            ranges[i].size > map->mapped_size - ranges[i].offset) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                                 "Read-ahead range exceeds mapping");
+        }
+    }
+    const metagraph_map_region_t *region = map->platform_handle;
+    if (!region || count == 0) {
+        return METAGRAPH_OK();
+    }
+
+    // Translate to file offsets; the engine reads the file, not the map.
+    metagraph_map_range_t *file_ranges = malloc(count * sizeof(*file_ranges));
+    METAGRAPH_CHECK_ALLOC(file_ranges);
+    for (size_t i = 0; i < count; i++) {
+        file_ranges[i] = (metagraph_map_range_t){
+            region->offset + ranges[i].offset, ranges[i].size};
+    }
+    const metagraph_read_ahead_options_t defaults = {0};
+    const metagraph_result_t result = metagraph_read_ahead_fd(
+        region->fd, map->file_size, file_ranges, count,
+        options ? options : &defaults, &stats);
+    free(file_ranges);
+    if (out_stats) {
+        *out_stats = stats;
+    }
+    return result;
+}
+
+metagraph_result_t metagraph_validate_pointer(const metagraph_memory_map_t *map,
+                                              const void *pointer,
+                                              size_t required_size) {
+    METAGRAPH_CHECK_NULL(map);
+    const uintptr_t base = (uintptr_t)map->base_address;
+    const uintptr_t address = (uintptr_t)pointer;
+    if (address < base || address - base > map->mapped_size ||
+        required_size > map->mapped_size - (address - base)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                             "Pointer range of %zu bytes escapes the mapping",
+                             required_size);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_hydrate_pointer(const metagraph_memory_map_t *map,
+                                             metagraph_offset_pointer_t *offset_ptr,
+                                             void **out_pointer) {
+    METAGRAPH_CHECK_NULL(map);
+    METAGRAPH_CHECK_NULL(offset_ptr);
+    METAGRAPH_CHECK_NULL(out_pointer);
+
+    if (!offset_ptr->is_hydrated) {
+        if (offset_ptr->offset > map->mapped_size ||
+            offset_ptr->size > map->mapped_size - offset_ptr->offset) {
+            *out_pointer = NULL;
+            return METAGRAPH_ERR(
+                METAGRAPH_ERROR_BUNDLE_CORRUPTED,
+                "Offset %llu (+%llu bytes) escapes %zu-byte mapping",
+                (unsigned long long)offset_ptr->offset,
+                (unsigned long long)offset_ptr->size, map->mapped_size);
+        }
+        METAGRAPH_PROBE2(pointer__hydrate, map, offset_ptr->offset);
+        offset_ptr->cached_pointer =
+            (uint8_t *)map->base_address + offset_ptr->offset;
+        offset_ptr->is_hydrated = true;
+    }
+    offset_ptr->access_count++;
+    *out_pointer = offset_ptr->cached_pointer;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_hydrate_pointer_batch(const metagraph_memory_map_t *map,
+                                metagraph_offset_pointer_t *offset_ptrs,
+                                size_t count) {
+    METAGRAPH_CHECK_NULL(map);
+    if (count && !offset_ptrs) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NULL_POINTER,
+                             "Null pointer: offset_ptrs");
+    }
+    for (size_t i = 0; i < count; i++) {
+        void *pointer = NULL;
+        METAGRAPH_CHECK(metagraph_hydrate_pointer(map, &offset_ptrs[i], &pointer));
+    }
+    return METAGRAPH_OK();
+}
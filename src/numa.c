@@ -0,0 +1,306 @@
+/**
+ * @file numa.c
+ * @brief NUMA topology sources and memory binding
+ *
+ * The system source on Linux reads /sys/devices/system/node once, on first
+ * use, and keeps the CPU-to-node table for the life of the process. Thread
+ * placement comes from getcpu() and binding from mbind() with
+ * MPOL_PREFERRED, both as raw syscalls so the library needs no libnuma.
+ * Anything missing (no sysfs node directory, a kernel built without NUMA)
+ * degrades to one node holding every CPU.
+ */
+
+#include "metagraph/numa.h"
+#include "metagraph/result.h"
+
+#include "platform.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#define METAGRAPH_HAVE_LINUX_NUMA 1
+#else
+#define METAGRAPH_HAVE_LINUX_NUMA 0
+#endif
+
+#define METAGRAPH_NUMA_MPOL_PREFERRED 1
+#define METAGRAPH_NUMA_MPOL_MF_MOVE (1U << 1U)
+#define METAGRAPH_NUMA_LIST_MAX 4096U
+
+// ============================================================================
+// System source
+// ============================================================================
+
+static struct {
+    metagraph_once_t once;
+    uint32_t node_count;
+    uint32_t cpu_count;
+    uint32_t *cpu_nodes;
+} metagraph_numa_system;
+
+#if METAGRAPH_HAVE_LINUX_NUMA
+
+// Read a sysfs list such as "0-3,8-11" into text; false if unreadable.
+static bool metagraph_numa_read_list(const char *path, char *text,
+                                     size_t size) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    const size_t length = fread(text, 1, size - 1U, file);
+    (void)fclose(file);
+    text[length] = '\0';
+    return length > 0;
+}
+
+// Call visit(first, last, context) for each range in a sysfs list.
+static bool metagraph_numa_parse_list(const char *text,
+                                      void (*visit)(uint32_t, uint32_t,
+                                                    void *),
+                                      void *context) {
+    const char *cursor = text;
+    while (*cursor && *cursor != '\n') {
+        char *end = NULL;
+        const unsigned long first = strtoul(cursor, &end, 10);
+        if (end == cursor) {
+            return false;
+        }
+        unsigned long last = first;
+        cursor = end;
+        if (*cursor == '-') {
+            last = strtoul(cursor + 1, &end, 10);
+            if (end == cursor + 1 || last < first) {
+                return false;
+            }
+            cursor = end;
+        }
+        if (last >= METAGRAPH_NUMA_LIST_MAX) {
+            return false;
+        }
+        visit((uint32_t)first, (uint32_t)last, context);
+        if (*cursor == ',') {
+            cursor++;
+        }
+    }
+    return true;
+}
+
+static void metagraph_numa_track_max(uint32_t first, uint32_t last,
+                                     void *context) {
+    (void)first;
+    uint32_t *count = context;
+    if (last + 1U > *count) {
+        *count = last + 1U;
+    }
+}
+
+typedef struct {
+    uint32_t *cpu_nodes;
+    uint32_t cpu_count;
+    uint32_t node;
+} metagraph_numa_assign_t;
+
+static void metagraph_numa_assign(uint32_t first, uint32_t last,
+                                  void *context) {
+    metagraph_numa_assign_t *assign = context;
+    for (uint32_t cpu = first; cpu <= last && cpu < assign->cpu_count; cpu++) {
+        assign->cpu_nodes[cpu] = assign->node;
+    }
+}
+
+// Fill the system table from sysfs; false leaves it for the fallback.
+static bool metagraph_numa_discover(void) {
+    char text[METAGRAPH_NUMA_LIST_MAX];
+    uint32_t node_count = 0;
+    uint32_t cpu_count = 0;
+    if (!metagraph_numa_read_list("/sys/devices/system/node/online", text,
+                                  sizeof(text)) ||
+        !metagraph_numa_parse_list(text, metagraph_numa_track_max,
+                                   &node_count) ||
+        !metagraph_numa_read_list("/sys/devices/system/cpu/possible", text,
+                                  sizeof(text)) ||
+        !metagraph_numa_parse_list(text, metagraph_numa_track_max,
+                                   &cpu_count) ||
+        node_count == 0 || cpu_count == 0) {
+        return false;
+    }
+    uint32_t *cpu_nodes = calloc(cpu_count, sizeof(*cpu_nodes));
+    if (!cpu_nodes) {
+        return false;
+    }
+    for (uint32_t node = 0; node < node_count; node++) {
+        char path[64];
+        (void)snprintf(path, sizeof(path),
+                       "/sys/devices/system/node/node%u/cpulist", node);
+        metagraph_numa_assign_t assign = {cpu_nodes, cpu_count, node};
+        // Offline nodes have no directory; their CPUs stay on node 0.
+        if (metagraph_numa_read_list(path, text, sizeof(text))) {
+            (void)metagraph_numa_parse_list(text, metagraph_numa_assign,
+                                            &assign);
+        }
+    }
+    metagraph_numa_system.node_count = node_count;
+    metagraph_numa_system.cpu_count = cpu_count;
+    metagraph_numa_system.cpu_nodes = cpu_nodes;
+    return true;
+}
+
+#endif // METAGRAPH_HAVE_LINUX_NUMA
+
+// Without sysfs (or outside Linux) every CPU is on a single node 0.
+static void metagraph_numa_system_build(void) {
+    bool found = false;
+#if METAGRAPH_HAVE_LINUX_NUMA
+    found = metagraph_numa_discover();
+#endif
+    if (!found) {
+        static uint32_t single_cpu_node;
+        const uint32_t cpus = metagraph_cpu_count();
+        uint32_t *cpu_nodes = calloc(cpus, sizeof(*cpu_nodes));
+        metagraph_numa_system.node_count = 1;
+        metagraph_numa_system.cpu_count = cpu_nodes ? cpus : 1U;
+        metagraph_numa_system.cpu_nodes =
+            cpu_nodes ? cpu_nodes : &single_cpu_node;
+    }
+}
+
+static void metagraph_numa_system_init(void) {
+    metagraph_once(&metagraph_numa_system.once, metagraph_numa_system_build);
+}
+
+static metagraph_result_t
+metagraph_numa_system_topology(void *context, metagraph_numa_topology_t *out) {
+    (void)context;
+    metagraph_numa_system_init();
+    *out = (metagraph_numa_topology_t){
+        .node_count = metagraph_numa_system.node_count,
+        .cpu_count = metagraph_numa_system.cpu_count,
+        .cpu_nodes = metagraph_numa_system.cpu_nodes,
+    };
+    return METAGRAPH_OK();
+}
+
+static uint32_t metagraph_numa_system_current(void *context) {
+    (void)context;
+#if METAGRAPH_HAVE_LINUX_NUMA
+    metagraph_numa_system_init();
+    if (metagraph_numa_system.node_count > 1U) {
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0 &&
+            node < metagraph_numa_system.node_count) {
+            return node;
+        }
+    }
+#endif
+    return 0;
+}
+
+static metagraph_result_t metagraph_numa_system_bind(void *context,
+                                                     void *address, size_t size,
+                                                     uint32_t node) {
+    (void)context;
+    metagraph_numa_system_init();
+    if (metagraph_numa_system.node_count <= 1U) {
+        return METAGRAPH_OK();
+    }
+#if METAGRAPH_HAVE_LINUX_NUMA
+#define METAGRAPH_NUMA_MASK_BITS (sizeof(unsigned long) * 8U)
+    unsigned long mask[METAGRAPH_NUMA_LIST_MAX / METAGRAPH_NUMA_MASK_BITS] = {
+        0};
+    const size_t words = node / METAGRAPH_NUMA_MASK_BITS + 1U;
+    mask[words - 1U] = 1UL << (node % METAGRAPH_NUMA_MASK_BITS);
+    // The kernel drops the last bit of maxnode, hence the + 1.
+    const unsigned long max_node =
+        (unsigned long)(words * METAGRAPH_NUMA_MASK_BITS + 1U);
+    if (syscall(SYS_mbind, address, size, METAGRAPH_NUMA_MPOL_PREFERRED, mask,
+                max_node, METAGRAPH_NUMA_MPOL_MF_MOVE) != 0) {
+        if (errno == ENOSYS || errno == EPERM) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_PLATFORM_NOT_SUPPORTED,
+                                 "mbind is not available (errno %d)", errno);
+        }
+        return METAGRAPH_ERR(METAGRAPH_ERROR_RESOURCE_EXHAUSTED,
+                             "mbind to node %u failed (errno %d)", node,
+                             errno);
+    }
+#else
+    (void)address;
+    (void)size;
+#endif
+    return METAGRAPH_OK();
+}
+
+static const metagraph_numa_source_t metagraph_numa_system_source = {
+    .get_topology = metagraph_numa_system_topology,
+    .current_node = metagraph_numa_system_current,
+    .bind = metagraph_numa_system_bind,
+};
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+static metagraph_numa_source_t metagraph_numa_source = {
+    .get_topology = metagraph_numa_system_topology,
+    .current_node = metagraph_numa_system_current,
+    .bind = metagraph_numa_system_bind,
+};
+
+metagraph_result_t
+metagraph_numa_set_source(const metagraph_numa_source_t *source) {
+    if (!source) {
+        metagraph_numa_source = metagraph_numa_system_source;
+        return METAGRAPH_OK();
+    }
+    if (!source->get_topology || !source->current_node || !source->bind) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "NUMA source is missing a callback");
+    }
+    metagraph_numa_source = *source;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_get_numa_topology(metagraph_numa_topology_t *out_topology) {
+    METAGRAPH_CHECK_NULL(out_topology);
+    return metagraph_numa_source.get_topology(metagraph_numa_source.context,
+                                              out_topology);
+}
+
+uint32_t metagraph_numa_current_node(void) {
+    return metagraph_numa_source.current_node(metagraph_numa_source.context);
+}
+
+metagraph_result_t metagraph_numa_bind(void *address, size_t size,
+                                       uint32_t node) {
+    METAGRAPH_CHECK_NULL(address);
+    metagraph_numa_topology_t topology;
+    METAGRAPH_CHECK(metagraph_get_numa_topology(&topology));
+    if (node >= topology.node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "NUMA node %u out of range (%u nodes)", node,
+                             topology.node_count);
+    }
+#if defined(_WIN32)
+    const uintptr_t page = 4096U;
+#else
+    const long page_size = sysconf(_SC_PAGESIZE);
+    const uintptr_t page = page_size > 0 ? (uintptr_t)page_size : 4096U;
+#endif
+    const uintptr_t start = ((uintptr_t)address + page - 1U) & ~(page - 1U);
+    const uintptr_t end = ((uintptr_t)address + size) & ~(page - 1U);
+    if (end <= start) {
+        return METAGRAPH_OK();
+    }
+    return metagraph_numa_source.bind(metagraph_numa_source.context,
+                                      (void *)start, (size_t)(end - start),
+                                      node);
+}
@@ -0,0 +1,204 @@
+/**
+ * @file path.c
+ * @brief Asset path normalization and hashing
+ *
+ * Most paths handed to a lookup are already normal, so normalization
+ * first scans the path 16 bytes at a time for the only patterns that need
+ * rewriting: a separator or dot straight after a separator (or at the
+ * start), and a trailing separator. A clean path is copied as is; anything
+ * else goes through the segment-by-segment rewrite.
+ */
+
+#include "metagraph/path.h"
+#include "metagraph/result.h"
+
+#include "path_internal.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// True if the path may need rewriting. The scan starts as if the path were
+// preceded by a separator, so a leading "." or "./" is caught; the root
+// separator of an absolute path is skipped.
+static bool metagraph_path_needs_rewrite(const char *path, size_t length) {
+    if (length > 1U && path[length - 1U] == '/') {
+        return true;
+    }
+    size_t i = path[0] == '/' ? 1U : 0U;
+    uint32_t carry = 1U;
+#if defined(__SSE2__)
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i dot = _mm_set1_epi8('.');
+    for (; i + 16U <= length; i += 16U) {
+        __m128i chunk;
+        memcpy(&chunk, path + i, sizeof(chunk));
+        const uint32_t slashes =
+            (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, slash));
+        const uint32_t dots =
+            (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, dot));
+        const uint32_t after_slash = ((slashes << 1U) | carry) & 0xFFFFU;
+        if (after_slash & (slashes | dots)) {
+            return true;
+        }
+        carry = slashes >> 15U;
+    }
+#endif
+    for (; i < length; i++) {
+        const bool separator = path[i] == '/';
+        if (carry && (separator || path[i] == '.')) {
+            return true;
+        }
+        carry = separator ? 1U : 0U;
+    }
+    return false;
+}
+
+bool metagraph_path_normalize_into(const char *path, size_t length, char *out,
+                                   size_t *out_length) {
+    if (length == 0) {
+        return false;
+    }
+    if (!metagraph_path_needs_rewrite(path, length)) {
+        memcpy(out, path, length);
+        out[length] = '\0';
+        *out_length = length;
+        return true;
+    }
+
+    // Segments are appended as "[/]segment"; root is the length of the
+    // part ".." can never remove.
+    const size_t root = path[0] == '/' ? 1U : 0U;
+    size_t written = root;
+    if (root) {
+        out[0] = '/';
+    }
+    size_t i = 0;
+    while (i < length) {
+        while (i < length && path[i] == '/') {
+            i++;
+        }
+        const size_t start = i;
+        while (i < length && path[i] != '/') {
+            i++;
+        }
+        const size_t segment = i - start;
+        if (segment == 0 || (segment == 1U && path[start] == '.')) {
+            continue;
+        }
+        if (segment == 2U && path[start] == '.' && path[start + 1U] == '.') {
+            if (written == root) {
+                return false;
+            }
+            while (written > root && out[written - 1U] != '/') {
+                written--;
+            }
+            if (written > root) {
+                written--;
+            }
+            continue;
+        }
+        if (written > root) {
+            out[written++] = '/';
+        }
+        memcpy(out + written, path + start, segment);
+        written += segment;
+    }
+    if (written == 0) {
+        out[written++] = '.';
+    }
+    out[written] = '\0';
+    *out_length = written;
+    return true;
+}
+
+metagraph_result_t metagraph_path_normalize(const char *path, char *out_path,
+                                            size_t out_size,
+                                            size_t *out_length) {
+    METAGRAPH_CHECK_NULL(path);
+    METAGRAPH_CHECK_NULL(out_path);
+    const size_t length = strlen(path);
+    if (length == 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Cannot normalize an empty path");
+    }
+    if (length > METAGRAPH_PATH_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Path of %zu bytes exceeds %u", length,
+                             METAGRAPH_PATH_MAX);
+    }
+
+    char buffer[METAGRAPH_PATH_MAX + 1U];
+    size_t normalized = 0;
+    if (!metagraph_path_normalize_into(path, length, buffer, &normalized)) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Path %s escapes its root", path);
+    }
+    if (normalized >= out_size) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_BUFFER_TOO_SMALL,
+                             "Normalized path needs %zu bytes, buffer has %zu",
+                             normalized + 1U, out_size);
+    }
+    memcpy(out_path, buffer, normalized + 1U);
+    if (out_length) {
+        *out_length = normalized;
+    }
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Hashing
+// ============================================================================
+
+// MurmurHash3 x64 128-bit finalizer and mixing constants
+#define METAGRAPH_PATH_C1 0x87C37B91114253D5ULL
+#define METAGRAPH_PATH_C2 0x4CF5AD432745937FULL
+
+static inline uint64_t metagraph_path_rotl(uint64_t value, unsigned shift) {
+    return (value << shift) | (value >> (64U - shift));
+}
+
+static inline uint64_t metagraph_path_fmix(uint64_t value) {
+    value ^= value >> 33U;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33U;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33U;
+    return value;
+}
+
+// MurmurHash3_x64_128 block loop; the tail is zero-padded into one last
+// block, and the length is folded in by the finalizer.
+metagraph_id_t metagraph_path_hash(const char *path, size_t length) {
+    uint64_t h1 = 0x243F6A8885A308D3ULL;
+    uint64_t h2 = 0x13198A2E03707344ULL;
+    for (size_t offset = 0; offset < length; offset += 16U) {
+        uint64_t block[2] = {0, 0};
+        const size_t take = length - offset < 16U ? length - offset : 16U;
+        memcpy(block, path + offset, take);
+
+        uint64_t k1 = block[0] * METAGRAPH_PATH_C1;
+        k1 = metagraph_path_rotl(k1, 31U) * METAGRAPH_PATH_C2;
+        h1 ^= k1;
+        h1 = metagraph_path_rotl(h1, 27U) + h2;
+        h1 = h1 * 5U + 0x52DCE729U;
+
+        uint64_t k2 = block[1] * METAGRAPH_PATH_C2;
+        k2 = metagraph_path_rotl(k2, 33U) * METAGRAPH_PATH_C1;
+        h2 ^= k2;
+        h2 = metagraph_path_rotl(h2, 31U) + h1;
+        h2 = h2 * 5U + 0x38495AB5U;
+    }
+    h1 ^= (uint64_t)length;
+    h2 ^= (uint64_t)length;
+    h1 += h2;
+    h2 += h1;
+    h1 = metagraph_path_fmix(h1);
+    h2 = metagraph_path_fmix(h2);
+    h1 += h2;
+    h2 += h1;
+    return (metagraph_id_t){.high = h2, .low = h1};
+}
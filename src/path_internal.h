@@ -0,0 +1,34 @@
+/**
+ * @file path_internal.h
+ * @brief Path normalization and hashing shared by the bundle reader and
+ *        writer
+ */
+
+#ifndef SRC_PATH_INTERNAL_H
+#define SRC_PATH_INTERNAL_H
+
+#include "metagraph/graph.h"
+#include "metagraph/path.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Normalize path[0, length) into out
+ *
+ * out needs length + 1 bytes and receives a NUL-terminated result.
+ *
+ * @return false if the path is empty or escapes the root
+ */
+bool metagraph_path_normalize_into(const char *path, size_t length, char *out,
+                                   size_t *out_length);
+
+/**
+ * @brief 128-bit hash of a (normalized) path
+ *
+ * Bundles store path lookup keys under this hash, so it is part of the
+ * bundle format; changing it requires a format version bump.
+ */
+metagraph_id_t metagraph_path_hash(const char *path, size_t length);
+
+#endif // SRC_PATH_INTERNAL_H
@@ -0,0 +1,262 @@
+/**
+ * @file perfect_hash.c
+ * @brief Minimal perfect hash construction and batched lookup
+ *
+ * Buckets are placed largest first, while the table is still mostly
+ * empty, and each tries pilots 0, 1, 2, ... until all of its keys land on
+ * free positions. The table has about 3% spare positions, which keeps the
+ * search short for the single-key buckets placed last; positions that end
+ * up past the key count are then remapped into the holes below it.
+ */
+
+#include "perfect_hash.h"
+#include "platform.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Seeds tried before giving up, and pilots tried per bucket and seed
+#define METAGRAPH_PERFECT_HASH_MAX_SEEDS 16U
+#define METAGRAPH_PERFECT_HASH_MAX_PILOT (1U << 20U)
+
+typedef struct {
+    uint32_t *bucket_start; // bucket_count + 1 offsets into members
+    uint32_t *members;      // Key indices grouped by bucket
+    uint32_t *order;        // Buckets, largest first
+    uint64_t *key_hash;     // Pilot-independent position hash per key
+    uint64_t *taken;        // Bitset over table positions
+    uint32_t *size_start;   // Counting sort of buckets by size
+    uint32_t max_size;
+} metagraph_perfect_hash_scratch_t;
+
+static void
+metagraph_perfect_hash_free(metagraph_perfect_hash_scratch_t *scratch) {
+    free(scratch->bucket_start);
+    free(scratch->members);
+    free(scratch->order);
+    free(scratch->key_hash);
+    free(scratch->taken);
+    free(scratch->size_start);
+}
+
+static bool metagraph_perfect_hash_is_taken(const uint64_t *taken,
+                                            uint64_t position) {
+    return (taken[position / 64U] >> (position % 64U)) & 1U;
+}
+
+static void metagraph_perfect_hash_flip(uint64_t *taken, uint64_t position) {
+    taken[position / 64U] ^= 1ULL << (position % 64U);
+}
+
+// Group keys by bucket and order the buckets largest first; both sorts are
+// stable, so the result only depends on the key order.
+static metagraph_result_t
+metagraph_perfect_hash_split(const metagraph_id_t *keys, size_t count,
+                             uint64_t seed, uint64_t bucket_count,
+                             metagraph_perfect_hash_scratch_t *scratch) {
+    // Counts become running ends, then filling back to front turns each
+    // end into its bucket's start.
+    uint32_t *bucket_start = scratch->bucket_start;
+    memset(bucket_start, 0, (bucket_count + 1U) * sizeof(*bucket_start));
+    for (size_t i = 0; i < count; i++) {
+        bucket_start[metagraph_perfect_hash_bucket(keys[i], seed,
+                                                   bucket_count)]++;
+        scratch->key_hash[i] = metagraph_perfect_hash_key(keys[i], seed);
+    }
+    uint32_t max_size = 0;
+    uint32_t running = 0;
+    for (uint64_t bucket = 0; bucket < bucket_count; bucket++) {
+        if (bucket_start[bucket] > max_size) {
+            max_size = bucket_start[bucket];
+        }
+        running += bucket_start[bucket];
+        bucket_start[bucket] = running;
+    }
+    bucket_start[bucket_count] = running;
+    for (size_t i = count; i-- > 0;) {
+        const uint64_t bucket =
+            metagraph_perfect_hash_bucket(keys[i], seed, bucket_count);
+        scratch->members[--bucket_start[bucket]] = (uint32_t)i;
+    }
+
+    if (max_size > scratch->max_size) {
+        free(scratch->size_start);
+        scratch->size_start = calloc((size_t)max_size + 2U, sizeof(uint32_t));
+        METAGRAPH_CHECK_ALLOC(scratch->size_start);
+        scratch->max_size = max_size;
+    }
+    uint32_t *size_start = scratch->size_start;
+    memset(size_start, 0, ((size_t)scratch->max_size + 2U) * sizeof(uint32_t));
+    // Rank by descending size: size s sorts at key max_size - s.
+    for (uint64_t bucket = 0; bucket < bucket_count; bucket++) {
+        const uint32_t size = bucket_start[bucket + 1U] - bucket_start[bucket];
+        size_start[max_size - size + 1U]++;
+    }
+    for (uint32_t rank = 0; rank <= max_size; rank++) {
+        size_start[rank + 1U] += size_start[rank];
+    }
+    for (uint64_t bucket = 0; bucket < bucket_count; bucket++) {
+        const uint32_t size = bucket_start[bucket + 1U] - bucket_start[bucket];
+        scratch->order[size_start[max_size - size]++] = (uint32_t)bucket;
+    }
+    return METAGRAPH_OK();
+}
+
+// Find a pilot for one bucket, marking its positions taken.
+static bool metagraph_perfect_hash_place(
+    const metagraph_perfect_hash_scratch_t *scratch, uint32_t bucket,
+    uint64_t table_size, uint32_t *pilots, uint32_t *positions) {
+    const uint32_t begin = scratch->bucket_start[bucket];
+    const uint32_t end = scratch->bucket_start[bucket + 1U];
+    const uint32_t *members = scratch->members;
+    // Equal hashes in a bucket collide under every pilot.
+    for (uint32_t i = begin; i < end; i++) {
+        for (uint32_t j = i + 1U; j < end; j++) {
+            if (scratch->key_hash[members[i]] == scratch->key_hash[members[j]]) {
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t pilot = 0; pilot < METAGRAPH_PERFECT_HASH_MAX_PILOT;
+         pilot++) {
+        uint32_t placed = begin;
+        for (; placed < end; placed++) {
+            const uint64_t position = metagraph_perfect_hash_position(
+                scratch->key_hash[members[placed]], pilot, table_size);
+            if (metagraph_perfect_hash_is_taken(scratch->taken, position)) {
+                break;
+            }
+            metagraph_perfect_hash_flip(scratch->taken, position);
+            positions[members[placed]] = (uint32_t)position;
+        }
+        if (placed == end) {
+            pilots[bucket] = pilot;
+            return true;
+        }
+        for (uint32_t i = begin; i < placed; i++) {
+            metagraph_perfect_hash_flip(scratch->taken, positions[members[i]]);
+        }
+    }
+    return false;
+}
+
+// Point each taken position past the key count at a free slot below it,
+// then translate positions into slots.
+static void
+metagraph_perfect_hash_remap(const metagraph_perfect_hash_scratch_t *scratch,
+                             size_t count, uint64_t table_size,
+                             uint32_t *remap, uint32_t *slots) {
+    uint64_t hole = 0;
+    for (uint64_t position = count; position < table_size; position++) {
+        uint32_t target = 0;
+        if (metagraph_perfect_hash_is_taken(scratch->taken, position)) {
+            while (metagraph_perfect_hash_is_taken(scratch->taken, hole)) {
+                hole++;
+            }
+            target = (uint32_t)hole++;
+        }
+        remap[position - count] = target;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (slots[i] >= count) {
+            slots[i] = remap[slots[i] - count];
+        }
+    }
+}
+
+metagraph_result_t metagraph_perfect_hash_build(const metagraph_id_t *keys,
+                                                size_t count, uint32_t *pilots,
+                                                uint32_t *remap,
+                                                uint32_t *out_slots,
+                                                uint64_t *out_seed) {
+    METAGRAPH_CHECK_NULL(out_seed);
+    *out_seed = 0;
+    if (count == 0) {
+        return METAGRAPH_OK();
+    }
+    METAGRAPH_CHECK_NULL(keys);
+    METAGRAPH_CHECK_NULL(pilots);
+    METAGRAPH_CHECK_NULL(out_slots);
+    if (count >= UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Perfect hash over %zu keys exceeds 32-bit slots",
+                             count);
+    }
+    uint64_t bucket_count = 0;
+    uint64_t table_size = 0;
+    metagraph_perfect_hash_shape(count, &bucket_count, &table_size);
+
+    const size_t words = (size_t)(table_size + 63U) / 64U;
+    metagraph_perfect_hash_scratch_t scratch = {
+        .bucket_start = malloc(((size_t)bucket_count + 1U) * sizeof(uint32_t)),
+        .members = malloc(count * sizeof(uint32_t)),
+        .order = malloc((size_t)bucket_count * sizeof(uint32_t)),
+        .key_hash = malloc(count * sizeof(uint64_t)),
+        .taken = malloc(words * sizeof(uint64_t)),
+    };
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    if (!scratch.bucket_start || !scratch.members || !scratch.order ||
+        !scratch.key_hash || !scratch.taken) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Failed to allocate perfect hash scratch for "
+                               "%zu keys",
+                               count);
+        goto done;
+    }
+
+    for (uint32_t attempt = 0; attempt < METAGRAPH_PERFECT_HASH_MAX_SEEDS;
+         attempt++) {
+        const uint64_t seed =
+            metagraph_perfect_hash_mix(0x5851F42D4C957F2DULL + attempt);
+        METAGRAPH_CHECK_GOTO(metagraph_perfect_hash_split(
+                                 keys, count, seed, bucket_count, &scratch),
+                             done);
+        memset(scratch.taken, 0, words * sizeof(uint64_t));
+        bool placed = true;
+        for (uint64_t rank = 0; rank < bucket_count && placed; rank++) {
+            const uint32_t bucket = scratch.order[rank];
+            placed = metagraph_perfect_hash_place(&scratch, bucket, table_size,
+                                                  pilots, out_slots);
+        }
+        if (placed) {
+            metagraph_perfect_hash_remap(&scratch, count, table_size, remap,
+                                         out_slots);
+            *out_seed = seed;
+            goto done;
+        }
+    }
+    result = METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                           "No perfect hash found for %zu keys; keys are "
+                           "probably not distinct",
+                           count);
+
+done:
+    metagraph_perfect_hash_free(&scratch);
+    return result;
+}
+
+void metagraph_perfect_hash_slots(const metagraph_perfect_hash_t *table,
+                                  const metagraph_id_t *keys, size_t count,
+                                  uint64_t *out_slots) {
+    for (size_t i = 0; i < count; i++) {
+        out_slots[i] = metagraph_perfect_hash_bucket(keys[i], table->seed,
+                                                     table->bucket_count);
+        METAGRAPH_PREFETCH(&table->pilots[out_slots[i]]);
+    }
+    for (size_t i = 0; i < count; i++) {
+        const uint64_t position = metagraph_perfect_hash_position(
+            metagraph_perfect_hash_key(keys[i], table->seed),
+            table->pilots[out_slots[i]], table->table_size);
+        out_slots[i] = position;
+        if (position >= table->key_count) {
+            METAGRAPH_PREFETCH(&table->remap[position - table->key_count]);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (out_slots[i] >= table->key_count) {
+            out_slots[i] = table->remap[out_slots[i] - table->key_count];
+        }
+    }
+}
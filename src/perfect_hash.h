@@ -0,0 +1,149 @@
+/**
+ * @file perfect_hash.h
+ * @brief Internal minimal perfect hash over 128-bit keys
+ *
+ * The construction follows CHD/PTHash: keys are split into buckets of
+ * about METAGRAPH_PERFECT_HASH_BUCKET_SIZE, and each bucket gets a pilot
+ * value that sends all of its keys to free positions of a table slightly
+ * larger than the key set. Positions past the key count are remapped into
+ * the holes below it, so every key maps to a distinct slot in
+ * [0, key_count). A lookup is one pilot load, one hash and (for a few
+ * percent of keys) one remap load; no probing.
+ *
+ * Keys not in the set also map to some slot, so callers store the key (or
+ * a check value) in the slot and compare it.
+ */
+
+#ifndef SRC_PERFECT_HASH_H
+#define SRC_PERFECT_HASH_H
+
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define METAGRAPH_PERFECT_HASH_BUCKET_SIZE 4U
+
+/**
+ * @brief A built table; the arrays are borrowed
+ */
+typedef struct {
+    uint64_t seed;          ///< Hash seed the pilots were found for
+    uint64_t key_count;     ///< Keys (and slots)
+    uint64_t bucket_count;  ///< Entries in pilots
+    uint64_t table_size;    ///< Positions before remapping (>= key_count)
+    const uint32_t *pilots; ///< Per-bucket pilot values
+    const uint32_t *remap;  ///< table_size - key_count slot numbers
+} metagraph_perfect_hash_t;
+
+/**
+ * @brief Bucket count and table size for a key count
+ *
+ * The shape depends only on the count, so writers can size the arrays
+ * before building.
+ */
+static inline void metagraph_perfect_hash_shape(uint64_t key_count,
+                                                uint64_t *out_bucket_count,
+                                                uint64_t *out_table_size) {
+    if (key_count == 0) {
+        *out_bucket_count = 0;
+        *out_table_size = 0;
+        return;
+    }
+    *out_bucket_count = key_count / METAGRAPH_PERFECT_HASH_BUCKET_SIZE + 1U;
+    *out_table_size = key_count + key_count / 32U + 1U;
+}
+
+static inline uint64_t metagraph_perfect_hash_mix(uint64_t value) {
+    value ^= value >> 33U;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33U;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33U;
+    return value;
+}
+
+// Map a hash onto [0, range) without a division; range < 2^32.
+static inline uint64_t metagraph_perfect_hash_reduce(uint64_t hash,
+                                                     uint64_t range) {
+    return ((hash >> 32U) * range) >> 32U;
+}
+
+static inline uint64_t metagraph_perfect_hash_bucket(metagraph_id_t key,
+                                                     uint64_t seed,
+                                                     uint64_t bucket_count) {
+    const uint64_t hash = metagraph_perfect_hash_mix(
+        key.high ^ metagraph_perfect_hash_mix(key.low ^ seed));
+    return metagraph_perfect_hash_reduce(hash, bucket_count);
+}
+
+// Pilot-independent part of a key's position hash
+static inline uint64_t metagraph_perfect_hash_key(metagraph_id_t key,
+                                                  uint64_t seed) {
+    return metagraph_perfect_hash_mix(
+        key.low ^
+        metagraph_perfect_hash_mix(key.high + seed + 0x9E3779B97F4A7C15ULL));
+}
+
+static inline uint64_t metagraph_perfect_hash_position(uint64_t key_hash,
+                                                       uint32_t pilot,
+                                                       uint64_t table_size) {
+    return metagraph_perfect_hash_reduce(
+        metagraph_perfect_hash_mix(key_hash ^
+                                   ((uint64_t)pilot * 0xD6E8FEB86659FD93ULL)),
+        table_size);
+}
+
+/**
+ * @brief Slot of a key; meaningless unless the key was in the build set
+ *
+ * The table must hold at least one key.
+ */
+static inline uint64_t
+metagraph_perfect_hash_slot(const metagraph_perfect_hash_t *table,
+                            metagraph_id_t key) {
+    const uint64_t bucket =
+        metagraph_perfect_hash_bucket(key, table->seed, table->bucket_count);
+    const uint64_t position = metagraph_perfect_hash_position(
+        metagraph_perfect_hash_key(key, table->seed), table->pilots[bucket],
+        table->table_size);
+    return position < table->key_count
+               ? position
+               : table->remap[position - table->key_count];
+}
+
+/**
+ * @brief Slots of several keys, with their cache misses overlapped
+ *
+ * Same result as metagraph_perfect_hash_slot() per key, but every pilot
+ * load of the group is issued before the first one is used, and likewise
+ * the remap loads. Meant for groups of a few dozen keys at most, so the
+ * prefetched lines are still cached when they are read. The table must
+ * hold at least one key.
+ */
+void metagraph_perfect_hash_slots(const metagraph_perfect_hash_t *table,
+                                  const metagraph_id_t *keys, size_t count,
+                                  uint64_t *out_slots);
+
+/**
+ * @brief Build a table over distinct keys
+ *
+ * The result is a pure function of the keys and their order.
+ *
+ * @param keys Distinct keys
+ * @param count Number of keys (< 2^32)
+ * @param pilots Receives bucket_count pilots (see the shape helper)
+ * @param remap Receives table_size - key_count slot numbers
+ * @param out_slots Receives each key's slot, in key order
+ * @param out_seed Receives the seed
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_OUT_OF_MEMORY or
+ *         METAGRAPH_ERROR_INVALID_ARGUMENT if no seed works (duplicate keys)
+ */
+metagraph_result_t metagraph_perfect_hash_build(const metagraph_id_t *keys,
+                                                size_t count, uint32_t *pilots,
+                                                uint32_t *remap,
+                                                uint32_t *out_slots,
+                                                uint64_t *out_seed);
+
+#endif // SRC_PERFECT_HASH_H
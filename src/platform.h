@@ -0,0 +1,416 @@
+/**
+ * @file platform.h
+ * @brief Thin wrappers over the OS primitives the core library needs
+ *
+ * Only what the library uses today: thread-local storage (with an exit
+ * callback), a read prefetch hint, joinable threads, a non-recursive mutex
+ * with a (optionally timed) condition variable, spin-wait backoff,
+ * one-time initialization, the online CPU count, a monotonic clock, the
+ * calling thread's page fault counts, aligned heap allocation and resizing
+ * an open file. POSIX builds use pthreads; Windows builds use Win32
+ * threads, fiber-local storage, SRW locks, condition variables and the CRT
+ * aligned heap.
+ */
+
+#ifndef SRC_PLATFORM_H
+#define SRC_PLATFORM_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER)
+#define METAGRAPH_THREAD_LOCAL __declspec(thread)
+#else
+#define METAGRAPH_THREAD_LOCAL _Thread_local
+#endif
+
+// Start loading the cache line holding address; a hint only, which
+// never faults and costs nothing to get wrong.
+#if defined(_MSC_VER)
+#define METAGRAPH_PREFETCH(address) ((void)(address))
+#else
+#define METAGRAPH_PREFETCH(address) __builtin_prefetch((address), 0, 3)
+#endif
+
+#if defined(_WIN32)
+typedef SRWLOCK metagraph_mutex_t;
+#else
+typedef pthread_mutex_t metagraph_mutex_t;
+#endif
+
+static inline int metagraph_mutex_init(metagraph_mutex_t *mutex) {
+#if defined(_WIN32)
+    InitializeSRWLock(mutex);
+    return 0;
+#else
+    return pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+static inline void metagraph_mutex_destroy(metagraph_mutex_t *mutex) {
+#if defined(_WIN32)
+    (void)mutex;
+#else
+    (void)pthread_mutex_destroy(mutex);
+#endif
+}
+
+static inline void metagraph_mutex_lock(metagraph_mutex_t *mutex) {
+#if defined(_WIN32)
+    AcquireSRWLockExclusive(mutex);
+#else
+    (void)pthread_mutex_lock(mutex);
+#endif
+}
+
+static inline void metagraph_mutex_unlock(metagraph_mutex_t *mutex) {
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive(mutex);
+#else
+    (void)pthread_mutex_unlock(mutex);
+#endif
+}
+
+#if defined(_WIN32)
+typedef CONDITION_VARIABLE metagraph_cond_t;
+#else
+typedef pthread_cond_t metagraph_cond_t;
+#endif
+
+static inline int metagraph_cond_init(metagraph_cond_t *cond) {
+#if defined(_WIN32)
+    InitializeConditionVariable(cond);
+    return 0;
+#else
+    return pthread_cond_init(cond, NULL);
+#endif
+}
+
+static inline void metagraph_cond_destroy(metagraph_cond_t *cond) {
+#if defined(_WIN32)
+    (void)cond;
+#else
+    (void)pthread_cond_destroy(cond);
+#endif
+}
+
+// Atomically release mutex and sleep; may wake spuriously.
+static inline void metagraph_cond_wait(metagraph_cond_t *cond,
+                                       metagraph_mutex_t *mutex) {
+#if defined(_WIN32)
+    (void)SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+#else
+    (void)pthread_cond_wait(cond, mutex);
+#endif
+}
+
+// Like metagraph_cond_wait(), but gives up after about timeout_ms.
+static inline void metagraph_cond_timedwait(metagraph_cond_t *cond,
+                                            metagraph_mutex_t *mutex,
+                                            uint32_t timeout_ms) {
+#if defined(_WIN32)
+    (void)SleepConditionVariableSRW(cond, mutex, timeout_ms, 0);
+#else
+    struct timespec deadline;
+    (void)clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t)(timeout_ms / 1000U);
+    deadline.tv_nsec += (long)(timeout_ms % 1000U) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    (void)pthread_cond_timedwait(cond, mutex, &deadline);
+#endif
+}
+
+static inline void metagraph_cond_broadcast(metagraph_cond_t *cond) {
+#if defined(_WIN32)
+    WakeAllConditionVariable(cond);
+#else
+    (void)pthread_cond_broadcast(cond);
+#endif
+}
+
+// Spins before a waiting loop starts yielding its CPU instead.
+#define METAGRAPH_SPIN_LIMIT 64U
+
+/**
+ * @brief One round of waiting for another thread to make progress
+ *
+ * Call it each time a wait loop finds nothing has changed, with spins
+ * starting at zero. The first rounds only pause the core (which also
+ * lets a sibling hyperthread run); later rounds give up the time slice,
+ * so a waiter never starves the thread it waits for, even on one CPU.
+ */
+static inline void metagraph_backoff(uint32_t *spins) {
+    if (*spins < METAGRAPH_SPIN_LIMIT) {
+        ++*spins;
+#if defined(_MSC_VER)
+        YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        __asm__ __volatile__("yield");
+#endif
+        return;
+    }
+#if defined(_WIN32)
+    (void)SwitchToThread();
+#else
+    (void)sched_yield();
+#endif
+}
+
+/**
+ * @brief Flag for metagraph_once(); zero-initialize it
+ */
+typedef struct {
+    _Atomic(int) state; ///< 0 = not run, 1 = running, 2 = done
+} metagraph_once_t;
+
+/**
+ * @brief Run init exactly once across all threads
+ *
+ * Callers that race the first one wait until init has returned, so on
+ * return everything init wrote is visible. init must not fail; record
+ * failure in the state it builds instead.
+ */
+static inline void metagraph_once(metagraph_once_t *once, void (*init)(void)) {
+    if (atomic_load_explicit(&once->state, memory_order_acquire) == 2) {
+        return;
+    }
+    int expected = 0;
+    if (atomic_compare_exchange_strong_explicit(&once->state, &expected, 1,
+                                                memory_order_acquire,
+                                                memory_order_acquire)) {
+        init();
+        atomic_store_explicit(&once->state, 2, memory_order_release);
+        return;
+    }
+    uint32_t spins = 0;
+    while (atomic_load_explicit(&once->state, memory_order_acquire) != 2) {
+        metagraph_backoff(&spins);
+    }
+}
+
+/**
+ * @brief Whether a metagraph_once() init has finished; never runs it
+ */
+static inline bool metagraph_once_done(metagraph_once_t *once) {
+    return atomic_load_explicit(&once->state, memory_order_acquire) == 2;
+}
+
+/**
+ * @brief Joinable thread running fn(arg)
+ *
+ * The struct is the thread's start block: it must stay at the same address
+ * until metagraph_thread_join() returns.
+ */
+typedef struct {
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    void (*fn)(void *arg);
+    void *arg;
+} metagraph_thread_t;
+
+#if defined(_WIN32)
+static inline DWORD WINAPI metagraph_thread_start(LPVOID self) {
+    metagraph_thread_t *thread = self;
+    thread->fn(thread->arg);
+    return 0;
+}
+#else
+static inline void *metagraph_thread_start(void *self) {
+    metagraph_thread_t *thread = self;
+    thread->fn(thread->arg);
+    return NULL;
+}
+#endif
+
+// Returns 0 on success
+static inline int metagraph_thread_create(metagraph_thread_t *thread,
+                                          void (*fn)(void *arg), void *arg) {
+    thread->fn = fn;
+    thread->arg = arg;
+#if defined(_WIN32)
+    thread->handle = CreateThread(NULL, 0, metagraph_thread_start, thread, 0,
+                                  NULL);
+    return thread->handle ? 0 : -1;
+#else
+    return pthread_create(&thread->handle, NULL, metagraph_thread_start,
+                          thread);
+#endif
+}
+
+static inline void metagraph_thread_join(metagraph_thread_t *thread) {
+#if defined(_WIN32)
+    (void)WaitForSingleObject(thread->handle, INFINITE);
+    (void)CloseHandle(thread->handle);
+#else
+    (void)pthread_join(thread->handle, NULL);
+#endif
+}
+
+/**
+ * @brief Per-thread slot whose destructor runs at thread exit
+ *
+ * The destructor is called with the thread's value if it is not NULL.
+ */
+#if defined(_WIN32)
+typedef DWORD metagraph_thread_key_t;
+#else
+typedef pthread_key_t metagraph_thread_key_t;
+#endif
+
+// Returns 0 on success
+static inline int metagraph_thread_key_create(metagraph_thread_key_t *key,
+                                              void (*destructor)(void *)) {
+#if defined(_WIN32)
+    // x64 has a single calling convention, so the callback types agree.
+    *key = FlsAlloc((PFLS_CALLBACK_FUNCTION)destructor);
+    return *key == FLS_OUT_OF_INDEXES ? -1 : 0;
+#else
+    return pthread_key_create(key, destructor);
+#endif
+}
+
+// Returns 0 on success
+static inline int metagraph_thread_key_set(metagraph_thread_key_t key,
+                                           void *value) {
+#if defined(_WIN32)
+    return FlsSetValue(key, value) ? 0 : -1;
+#else
+    return pthread_setspecific(key, value);
+#endif
+}
+
+/**
+ * @brief Number of online CPUs (at least 1)
+ */
+static inline uint32_t metagraph_cpu_count(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (uint32_t)info.dwNumberOfProcessors
+                                     : 1U;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1U;
+#endif
+}
+
+/**
+ * @brief ID of the calling process
+ */
+static inline uint64_t metagraph_process_id(void) {
+#if defined(_WIN32)
+    return (uint64_t)GetCurrentProcessId();
+#else
+    return (uint64_t)getpid();
+#endif
+}
+
+/**
+ * @brief Nanoseconds from an arbitrary fixed point; never goes backwards
+ */
+static inline uint64_t metagraph_monotonic_ns(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    const uint64_t ticks = (uint64_t)counter.QuadPart;
+    const uint64_t rate = (uint64_t)frequency.QuadPart;
+    return ticks / rate * 1000000000U + ticks % rate * 1000000000U / rate;
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Page faults taken so far by the calling thread
+ *
+ * Falls back to the whole process where the OS has no per-thread count,
+ * and reports zero on Windows, which only counts faults per process and
+ * without the minor/major split.
+ */
+static inline void metagraph_page_faults(uint64_t *out_minor,
+                                         uint64_t *out_major) {
+    *out_minor = 0;
+    *out_major = 0;
+#if !defined(_WIN32)
+    struct rusage usage;
+#if defined(RUSAGE_THREAD)
+    const int who = RUSAGE_THREAD;
+#else
+    const int who = RUSAGE_SELF;
+#endif
+    if (getrusage(who, &usage) == 0) {
+        *out_minor = (uint64_t)usage.ru_minflt;
+        *out_major = (uint64_t)usage.ru_majflt;
+    }
+#endif
+}
+
+/**
+ * @brief Allocate size bytes aligned to a power-of-two alignment
+ *
+ * size is rounded up to a multiple of alignment as C11 aligned_alloc
+ * requires. Release with metagraph_aligned_free().
+ */
+static inline void *metagraph_aligned_alloc(size_t alignment, size_t size) {
+    const size_t rounded = (size + alignment - 1U) & ~(alignment - 1U);
+    if (rounded < size) {
+        return NULL;
+    }
+#if defined(_WIN32)
+    return _aligned_malloc(rounded, alignment);
+#else
+    return aligned_alloc(alignment, rounded);
+#endif
+}
+
+static inline void metagraph_aligned_free(void *ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+/**
+ * @brief Extend or truncate an open file to size bytes
+ *
+ * Bytes added at the end read as zero and, where the file system supports
+ * it, occupy no disk space until written. Returns 0 on success.
+ */
+static inline int metagraph_file_resize(FILE *file, uint64_t size) {
+#if defined(_WIN32)
+    return _chsize_s(_fileno(file), (__int64)size) == 0 ? 0 : -1;
+#else
+    return ftruncate(fileno(file), (off_t)size);
+#endif
+}
+
+#endif // SRC_PLATFORM_H
@@ -0,0 +1,631 @@
+/**
+ * @file read_ahead.c
+ * @brief Batched file reads over io_uring, with a pread thread fallback
+ *
+ * Ranges become a sorted list of page-aligned chunks of at most chunk_size
+ * bytes. With io_uring the chunks stream through queue_depth slots, each
+ * owning one registered buffer: a completion refills its slot with the
+ * next chunk, so the device keeps queue_depth reads outstanding instead of
+ * the one a faulting thread has. Short reads are resubmitted for the rest
+ * of the chunk. The ring is driven with raw syscalls; the library takes no
+ * dependency on liburing.
+ *
+ * When io_uring is missing or refused (old kernels, seccomp filters that
+ * reject io_uring_setup) the chunks are dealt to a work pool whose workers
+ * pread() into one private buffer each. If the kernel will not pin the
+ * buffers (RLIMIT_MEMLOCK), the ring reads into them unregistered.
+ */
+
+#include "read_ahead.h"
+
+#include "metagraph/mmap.h"
+#include "metagraph/result.h"
+
+#include "platform.h"
+#include "work_pool.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define METAGRAPH_HAVE_PREAD 1
+#else
+#define METAGRAPH_HAVE_PREAD 0
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define METAGRAPH_HAVE_IO_URING 1
+#endif
+#endif
+#ifndef METAGRAPH_HAVE_IO_URING
+#define METAGRAPH_HAVE_IO_URING 0
+#endif
+
+#define METAGRAPH_READ_AHEAD_PAGE 4096U
+#define METAGRAPH_READ_AHEAD_DEFAULT_DEPTH 16U
+#define METAGRAPH_READ_AHEAD_MAX_DEPTH 1024U
+#define METAGRAPH_READ_AHEAD_DEFAULT_CHUNK (256U * 1024U)
+#define METAGRAPH_READ_AHEAD_MAX_CHUNK (64U * 1024U * 1024U)
+
+#if METAGRAPH_HAVE_PREAD
+
+static int metagraph_read_range_compare(const void *left, const void *right) {
+    const uint64_t a = ((const metagraph_map_range_t *)left)->offset;
+    const uint64_t b = ((const metagraph_map_range_t *)right)->offset;
+    return (a > b) - (a < b);
+}
+
+// Widen ranges to pages, clip them to the file, merge them and cut the
+// result into reads of at most chunk bytes.
+static metagraph_result_t
+metagraph_read_ahead_plan(const metagraph_map_range_t *ranges, size_t count,
+                          uint64_t file_size, uint64_t chunk,
+                          metagraph_map_range_t **out_chunks,
+                          size_t *out_count) {
+    *out_chunks = NULL;
+    *out_count = 0;
+    metagraph_map_range_t *spans = malloc((count ? count : 1U) *
+                                          sizeof(*spans));
+    METAGRAPH_CHECK_ALLOC(spans);
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (ranges[i].size == 0 || ranges[i].offset >= file_size) {
+            continue;
+        }
+        const uint64_t start =
+            ranges[i].offset & ~(uint64_t)(METAGRAPH_READ_AHEAD_PAGE - 1U);
+        uint64_t end = ranges[i].size > file_size - ranges[i].offset
+                           ? file_size
+                           : ranges[i].offset + ranges[i].size;
+        end = (end + METAGRAPH_READ_AHEAD_PAGE - 1U) &
+              ~(uint64_t)(METAGRAPH_READ_AHEAD_PAGE - 1U);
+        if (end > file_size) {
+            end = file_size;
+        }
+        spans[used++] = (metagraph_map_range_t){start, end - start};
+    }
+    qsort(spans, used, sizeof(*spans), metagraph_read_range_compare);
+
+    size_t merged = 0;
+    size_t chunk_count = 0;
+    for (size_t i = 0; i < used; i++) {
+        metagraph_map_range_t *last = merged ? &spans[merged - 1U] : NULL;
+        if (last && spans[i].offset <= last->offset + last->size) {
+            const uint64_t end = spans[i].offset + spans[i].size;
+            if (end > last->offset + last->size) {
+                last->size = end - last->offset;
+            }
+        } else {
+            spans[merged++] = spans[i];
+        }
+    }
+    for (size_t i = 0; i < merged; i++) {
+        chunk_count += (size_t)((spans[i].size + chunk - 1U) / chunk);
+    }
+
+    metagraph_map_range_t *chunks =
+        malloc((chunk_count ? chunk_count : 1U) * sizeof(*chunks));
+    if (!chunks) {
+        free(spans);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Cannot plan %zu reads", chunk_count);
+    }
+    size_t out = 0;
+    for (size_t i = 0; i < merged; i++) {
+        for (uint64_t at = 0; at < spans[i].size; at += chunk) {
+            const uint64_t left = spans[i].size - at;
+            chunks[out++] = (metagraph_map_range_t){
+                spans[i].offset + at, left < chunk ? left : chunk};
+        }
+    }
+    free(spans);
+    *out_chunks = chunks;
+    *out_count = chunk_count;
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// io_uring
+// ============================================================================
+
+#if METAGRAPH_HAVE_IO_URING
+
+typedef struct {
+    int fd;
+    uint32_t entries;
+    const _Atomic(uint32_t) *sq_head;
+    _Atomic(uint32_t) *sq_tail;
+    const uint32_t *sq_mask;
+    uint32_t *sq_array;
+    _Atomic(uint32_t) *cq_head;
+    _Atomic(uint32_t) *cq_tail;
+    const uint32_t *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring; ///< Same as sq_ring with IORING_FEAT_SINGLE_MMAP
+    size_t cq_ring_size;
+    size_t sqes_size;
+} metagraph_uring_t;
+
+// One read in flight: what is left of its chunk.
+typedef struct {
+    uint64_t offset;
+    uint32_t remaining;
+    uint32_t filled; ///< Bytes of the chunk already read
+} metagraph_uring_slot_t;
+
+static void metagraph_uring_teardown(metagraph_uring_t *ring) {
+    if (ring->sqes) {
+        (void)munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring && ring->cq_ring != ring->sq_ring) {
+        (void)munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring) {
+        (void)munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    (void)close(ring->fd);
+}
+
+// Field at a kernel-reported offset into a mapped ring.
+static void *metagraph_uring_at(void *ring, uint32_t offset) {
+    return (uint8_t *)ring + offset;
+}
+
+// Create a ring and map its queues; false when io_uring is unavailable.
+static bool metagraph_uring_setup(metagraph_uring_t *ring, uint32_t entries) {
+    memset(ring, 0, sizeof(*ring));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    const long fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        return false;
+    }
+    ring->fd = (int)fd;
+    ring->entries = params.sq_entries;
+    ring->sq_ring_size =
+        params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cq_ring_size = params.cq_off.cqes +
+                         params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0U;
+    if (single) {
+        if (ring->cq_ring_size > ring->sq_ring_size) {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+    void *sq = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) {
+        metagraph_uring_teardown(ring);
+        return false;
+    }
+    ring->sq_ring = sq;
+    void *cq = sq;
+    if (!single) {
+        cq = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) {
+            metagraph_uring_teardown(ring);
+            return false;
+        }
+    }
+    ring->cq_ring = cq;
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        metagraph_uring_teardown(ring);
+        return false;
+    }
+    ring->sqes = sqes;
+
+    ring->sq_head = metagraph_uring_at(sq, params.sq_off.head);
+    ring->sq_tail = metagraph_uring_at(sq, params.sq_off.tail);
+    ring->sq_mask = metagraph_uring_at(sq, params.sq_off.ring_mask);
+    ring->sq_array = metagraph_uring_at(sq, params.sq_off.array);
+    ring->cq_head = metagraph_uring_at(cq, params.cq_off.head);
+    ring->cq_tail = metagraph_uring_at(cq, params.cq_off.tail);
+    ring->cq_mask = metagraph_uring_at(cq, params.cq_off.ring_mask);
+    ring->cqes = metagraph_uring_at(cq, params.cq_off.cqes);
+    return true;
+}
+
+// Queue the rest of a slot's chunk; submitted by the next enter call.
+static void metagraph_uring_push(metagraph_uring_t *ring, int file,
+                                 uint32_t slot_index,
+                                 const metagraph_uring_slot_t *slot,
+                                 uint8_t *buffer, struct iovec *iov,
+                                 bool fixed) {
+    const uint32_t tail =
+        atomic_load_explicit(ring->sq_tail, memory_order_relaxed);
+    const uint32_t index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = file;
+    sqe->off = slot->offset + slot->filled;
+    sqe->user_data = slot_index;
+    if (fixed) {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = (uint64_t)(uintptr_t)(buffer + slot->filled);
+        sqe->len = slot->remaining;
+        sqe->buf_index = (uint16_t)slot_index;
+    } else {
+        // READV predates plain READ, so older kernels take it too.
+        iov->iov_base = buffer + slot->filled;
+        iov->iov_len = slot->remaining;
+        sqe->opcode = IORING_OP_READV;
+        sqe->addr = (uint64_t)(uintptr_t)iov;
+        sqe->len = 1;
+    }
+    ring->sq_array[index] = index;
+    atomic_store_explicit(ring->sq_tail, tail + 1U, memory_order_release);
+}
+
+// Wait out every read the kernel has taken from the submission queue,
+// since it writes into our buffers until it completes. Regular file reads
+// always complete, so this only waits for the device. False if the ring
+// cannot be waited on; the buffers must then never be freed.
+static bool metagraph_uring_drain(metagraph_uring_t *ring,
+                                  uint32_t in_flight) {
+    // Queued entries the kernel never consumed are simply dropped.
+    uint32_t outstanding =
+        in_flight -
+        (atomic_load_explicit(ring->sq_tail, memory_order_relaxed) -
+         atomic_load_explicit(ring->sq_head, memory_order_acquire));
+    while (outstanding) {
+        if (syscall(__NR_io_uring_enter, ring->fd, 0U, 1U,
+                    IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+            errno != EINTR) {
+            return false;
+        }
+        const uint32_t head =
+            atomic_load_explicit(ring->cq_head, memory_order_relaxed);
+        const uint32_t tail =
+            atomic_load_explicit(ring->cq_tail, memory_order_acquire);
+        outstanding -= tail - head;
+        atomic_store_explicit(ring->cq_head, tail, memory_order_release);
+    }
+    return true;
+}
+
+typedef struct {
+    int file;
+    const metagraph_map_range_t *chunks;
+    size_t chunk_count;
+    size_t next; ///< First chunk not yet handed to a slot
+    metagraph_uring_slot_t *slots;
+    struct iovec *iovs;
+    uint8_t *buffers;
+    size_t chunk_size;
+    bool fixed;
+} metagraph_uring_job_t;
+
+// Give slot the next chunk; false when none are left.
+static bool metagraph_uring_refill(metagraph_uring_t *ring,
+                                   metagraph_uring_job_t *job, uint32_t slot) {
+    if (job->next == job->chunk_count) {
+        return false;
+    }
+    const metagraph_map_range_t *chunk = &job->chunks[job->next++];
+    job->slots[slot] = (metagraph_uring_slot_t){
+        .offset = chunk->offset, .remaining = (uint32_t)chunk->size};
+    metagraph_uring_push(ring, job->file, slot, &job->slots[slot],
+                         job->buffers + (size_t)slot * job->chunk_size,
+                         &job->iovs[slot], job->fixed);
+    return true;
+}
+
+// Stream every chunk through the ring. *out_unavailable is set, and
+// nothing read, when the kernel offers no io_uring.
+static metagraph_result_t
+metagraph_read_ahead_uring(int file, const metagraph_map_range_t *chunks,
+                           size_t chunk_count, uint32_t depth,
+                           size_t chunk_size,
+                           metagraph_read_ahead_stats_t *stats,
+                           bool *out_unavailable) {
+    *out_unavailable = false;
+    if ((size_t)depth > chunk_count) {
+        depth = (uint32_t)chunk_count;
+    }
+    metagraph_uring_t ring;
+    if (!metagraph_uring_setup(&ring, depth)) {
+        *out_unavailable = true;
+        return METAGRAPH_OK();
+    }
+    if (depth > ring.entries) {
+        depth = ring.entries;
+    }
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_uring_job_t job = {
+        .file = file,
+        .chunks = chunks,
+        .chunk_count = chunk_count,
+        .slots = calloc(depth, sizeof(*job.slots)),
+        .iovs = calloc(depth, sizeof(*job.iovs)),
+        .buffers = metagraph_aligned_alloc(METAGRAPH_READ_AHEAD_PAGE,
+                                           (size_t)depth * chunk_size),
+        .chunk_size = chunk_size,
+    };
+    if (!job.slots || !job.iovs || !job.buffers) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Cannot allocate %u read buffers", depth);
+        goto done;
+    }
+    for (uint32_t i = 0; i < depth; i++) {
+        job.iovs[i] = (struct iovec){job.buffers + (size_t)i * chunk_size,
+                                     chunk_size};
+    }
+    job.fixed = syscall(__NR_io_uring_register, ring.fd,
+                        IORING_REGISTER_BUFFERS, job.iovs, depth) == 0;
+
+    uint32_t in_flight = 0;
+    uint32_t pending = 0; ///< Queued but not yet submitted
+    for (uint32_t slot = 0; slot < depth; slot++) {
+        if (metagraph_uring_refill(&ring, &job, slot)) {
+            in_flight++;
+            pending++;
+        }
+    }
+    int error_number = 0;
+    while (in_flight) {
+        const long submitted =
+            syscall(__NR_io_uring_enter, ring.fd, pending, 1U,
+                    IORING_ENTER_GETEVENTS, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                                   "io_uring_enter failed (errno %d)", errno);
+            if (!metagraph_uring_drain(&ring, in_flight)) {
+                // Reads may still land in the buffers; leak them instead.
+                job.buffers = NULL;
+            }
+            break;
+        }
+        pending -= (uint32_t)submitted;
+
+        uint32_t head = atomic_load_explicit(ring.cq_head,
+                                             memory_order_relaxed);
+        const uint32_t tail =
+            atomic_load_explicit(ring.cq_tail, memory_order_acquire);
+        for (; head != tail; head++) {
+            const struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            const uint32_t slot = (uint32_t)cqe->user_data;
+            metagraph_uring_slot_t *state = &job.slots[slot];
+            const int32_t res = cqe->res;
+            bool again = false;
+            if (res == -EINTR || res == -EAGAIN) {
+                again = true;
+            } else if (res < 0) {
+                error_number = error_number ? error_number : -res;
+            } else if (res > 0) {
+                stats->bytes_read += (uint64_t)res;
+                stats->reads++;
+                state->filled += (uint32_t)res;
+                state->remaining -= (uint32_t)res;
+                again = state->remaining != 0U;
+            }
+            // res == 0 is end of file: the chunk is done.
+            if (again && !error_number) {
+                metagraph_uring_push(
+                    &ring, job.file, slot, state,
+                    job.buffers + (size_t)slot * chunk_size, &job.iovs[slot],
+                    job.fixed);
+                pending++;
+            } else if (!error_number && metagraph_uring_refill(&ring, &job,
+                                                                 slot)) {
+                pending++;
+            } else {
+                in_flight--;
+            }
+        }
+        atomic_store_explicit(ring.cq_head, head, memory_order_release);
+    }
+    if (error_number && result == METAGRAPH_SUCCESS) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                               "Read-ahead failed (errno %d)", error_number);
+    }
+
+done:
+    metagraph_uring_teardown(&ring);
+    metagraph_aligned_free(job.buffers);
+    free(job.iovs);
+    free(job.slots);
+    return result;
+}
+
+#endif // METAGRAPH_HAVE_IO_URING
+
+// ============================================================================
+// pread fallback
+// ============================================================================
+
+static metagraph_result_t metagraph_pread_chunk(int file,
+                                                metagraph_map_range_t chunk,
+                                                uint8_t *buffer,
+                                                uint64_t *bytes_read,
+                                                uint64_t *reads) {
+    while (chunk.size) {
+        const ssize_t got =
+            pread(file, buffer, (size_t)chunk.size, (off_t)chunk.offset);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                                 "pread at %llu failed (errno %d)",
+                                 (unsigned long long)chunk.offset, errno);
+        }
+        if (got == 0) {
+            break;
+        }
+        *bytes_read += (uint64_t)got;
+        (*reads)++;
+        chunk.offset += (uint64_t)got;
+        chunk.size -= (uint64_t)got;
+    }
+    return METAGRAPH_OK();
+}
+
+typedef struct {
+    int file;
+    const metagraph_map_range_t *chunks;
+    uint8_t *buffers; ///< One chunk_size buffer per worker
+    size_t chunk_size;
+    _Atomic(uint64_t) bytes_read;
+    _Atomic(uint64_t) reads;
+    atomic_flag failed;
+    metagraph_error_context_t error; ///< First failure, for the caller
+} metagraph_pread_job_t;
+
+static void metagraph_pread_range(void *context, uint32_t worker, size_t begin,
+                                  size_t end) {
+    metagraph_pread_job_t *job = context;
+    uint8_t *buffer = job->buffers + (size_t)worker * job->chunk_size;
+    uint64_t bytes_read = 0;
+    uint64_t reads = 0;
+    for (size_t i = begin; i < end; i++) {
+        const metagraph_result_t result = metagraph_pread_chunk(
+            job->file, job->chunks[i], buffer, &bytes_read, &reads);
+        // Error contexts are thread-local; keep the first for the caller.
+        if (metagraph_result_is_error(result)) {
+            if (!atomic_flag_test_and_set(&job->failed)) {
+                (void)metagraph_get_error_context(&job->error);
+                job->error.code = result;
+            }
+            break;
+        }
+    }
+    atomic_fetch_add_explicit(&job->bytes_read, bytes_read,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&job->reads, reads, memory_order_relaxed);
+}
+
+static metagraph_result_t
+metagraph_read_ahead_pread(int file, const metagraph_map_range_t *chunks,
+                           size_t chunk_count, uint32_t thread_count,
+                           size_t chunk_size,
+                           metagraph_read_ahead_stats_t *stats) {
+    uint32_t threads = thread_count ? thread_count : metagraph_cpu_count();
+    if ((size_t)threads > chunk_count) {
+        threads = (uint32_t)chunk_count;
+    }
+    if (threads <= 1U) {
+        uint8_t *buffer = malloc(chunk_size);
+        METAGRAPH_CHECK_ALLOC(buffer);
+        metagraph_result_t result = METAGRAPH_SUCCESS;
+        for (size_t i = 0; i < chunk_count && result == METAGRAPH_SUCCESS;
+             i++) {
+            result = metagraph_pread_chunk(file, chunks[i], buffer,
+                                           &stats->bytes_read, &stats->reads);
+        }
+        free(buffer);
+        return result;
+    }
+
+    metagraph_work_pool_t *pool = NULL;
+    METAGRAPH_CHECK(metagraph_work_pool_create(threads, &pool));
+    metagraph_pread_job_t job = {
+        .file = file,
+        .chunks = chunks,
+        .buffers = malloc((size_t)metagraph_work_pool_size(pool) * chunk_size),
+        .chunk_size = chunk_size,
+        .failed = ATOMIC_FLAG_INIT,
+        .error = {.code = METAGRAPH_SUCCESS},
+    };
+    atomic_init(&job.bytes_read, 0);
+    atomic_init(&job.reads, 0);
+    if (!job.buffers) {
+        metagraph_work_pool_destroy(pool);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Cannot allocate %u read buffers", threads);
+    }
+    metagraph_work_pool_for(pool, chunk_count, 1, metagraph_pread_range, &job);
+    metagraph_work_pool_destroy(pool);
+    free(job.buffers);
+    stats->bytes_read += atomic_load(&job.bytes_read);
+    stats->reads += atomic_load(&job.reads);
+    if (job.error.code != METAGRAPH_SUCCESS) {
+        return METAGRAPH_ERR(job.error.code, "%s", job.error.message);
+    }
+    return METAGRAPH_OK();
+}
+
+#endif // METAGRAPH_HAVE_PREAD
+
+metagraph_result_t
+metagraph_read_ahead_fd(int fd, uint64_t file_size,
+                        const metagraph_map_range_t *ranges, size_t count,
+                        const metagraph_read_ahead_options_t *options,
+                        metagraph_read_ahead_stats_t *stats) {
+    *stats = (metagraph_read_ahead_stats_t){
+        .backend = METAGRAPH_READ_AHEAD_NONE};
+#if METAGRAPH_HAVE_PREAD
+    uint32_t depth = options->queue_depth ? options->queue_depth
+                                          : METAGRAPH_READ_AHEAD_DEFAULT_DEPTH;
+    if (depth > METAGRAPH_READ_AHEAD_MAX_DEPTH) {
+        depth = METAGRAPH_READ_AHEAD_MAX_DEPTH;
+    }
+    uint64_t chunk_size = options->chunk_size
+                              ? options->chunk_size
+                              : METAGRAPH_READ_AHEAD_DEFAULT_CHUNK;
+    if (chunk_size > METAGRAPH_READ_AHEAD_MAX_CHUNK) {
+        chunk_size = METAGRAPH_READ_AHEAD_MAX_CHUNK;
+    }
+    chunk_size = (chunk_size + METAGRAPH_READ_AHEAD_PAGE - 1U) &
+                 ~(uint64_t)(METAGRAPH_READ_AHEAD_PAGE - 1U);
+
+    metagraph_map_range_t *chunks = NULL;
+    size_t chunk_count = 0;
+    METAGRAPH_CHECK(metagraph_read_ahead_plan(ranges, count, file_size,
+                                              chunk_size, &chunks,
+                                              &chunk_count));
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    if (chunk_count == 0) {
+        goto done;
+    }
+#if METAGRAPH_HAVE_IO_URING
+    if (!(options->flags & METAGRAPH_READ_AHEAD_NO_URING)) {
+        bool unavailable = false;
+        stats->backend = METAGRAPH_READ_AHEAD_URING;
+        result = metagraph_read_ahead_uring(fd, chunks, chunk_count, depth,
+                                            (size_t)chunk_size, stats,
+                                            &unavailable);
+        if (!unavailable) {
+            goto done;
+        }
+    }
+#else
+    (void)depth;
+#endif
+    stats->backend = METAGRAPH_READ_AHEAD_PREAD;
+    result = metagraph_read_ahead_pread(fd, chunks, chunk_count,
+                                        options->thread_count,
+                                        (size_t)chunk_size, stats);
+done:
+    free(chunks);
+    return result;
+#else
+    (void)fd;
+    (void)file_size;
+    (void)ranges;
+    (void)count;
+    (void)options;
+    return METAGRAPH_OK();
+#endif
+}
@@ -0,0 +1,35 @@
+/**
+ * @file read_ahead.h
+ * @brief Internal batched file reads that fill the page cache
+ *
+ * The engine behind metagraph_mmap_read_ahead(): it only sees a file
+ * descriptor and absolute file ranges, so the mapping layer owns bounds
+ * checks and offset translation.
+ */
+
+#ifndef SRC_READ_AHEAD_H
+#define SRC_READ_AHEAD_H
+
+#include "metagraph/mmap.h"
+#include "metagraph/result.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Read file ranges of fd into the page cache and discard the data
+ *
+ * Ranges are widened to pages, clipped to file_size, sorted and merged
+ * before they are read, so callers may pass them in any order.
+ *
+ * @param ranges File offsets and sizes (offset field is absolute)
+ * @param options Resolved options (not NULL)
+ * @param stats Receives what was done (not NULL)
+ */
+metagraph_result_t
+metagraph_read_ahead_fd(int fd, uint64_t file_size,
+                        const metagraph_map_range_t *ranges, size_t count,
+                        const metagraph_read_ahead_options_t *options,
+                        metagraph_read_ahead_stats_t *stats);
+
+#endif // SRC_READ_AHEAD_H
@@ -0,0 +1,508 @@
+/**
+ * @file reorder.c
+ * @brief BFS, reverse Cuthill-McKee and Gorder-style node orderings
+ *
+ * All three start from a deduplicated undirected CSR built from the
+ * incidence lists. BFS and RCM place one component at a time. RCM picks
+ * each component's root as the lowest-degree unplaced node, enqueues
+ * neighbors by ascending degree, and finally reverses the whole order.
+ *
+ * The Gorder-style pass (after Wei et al., "Speedup Graph Processing by
+ * Graph Ordering") greedily appends the unplaced node with the highest
+ * score against the last METAGRAPH_REORDER_WINDOW placed nodes, scoring
+ * one per edge to a window node and one per neighbor shared with it.
+ * Scores live in a unit heap, one bucket list per score, since every
+ * update moves a node by exactly one. Nodes of degree above
+ * METAGRAPH_REORDER_HUB_DEGREE do not relay shared-neighbor credit, which
+ * keeps the pass linear in the edges.
+ */
+
+#include "reorder.h"
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include "graph_internal.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METAGRAPH_REORDER_WINDOW 5U
+#define METAGRAPH_REORDER_HUB_DEGREE 64U
+#define METAGRAPH_REORDER_SAMPLES 64U
+#define METAGRAPH_REORDER_WALK 512U
+#define METAGRAPH_REORDER_PAGE_LOG2 6U // 64-byte node records per 4 KiB
+
+typedef struct {
+    size_t node_count;
+    uint32_t *rows; ///< node_count + 1 offsets into neighbors
+    uint32_t *neighbors;
+    uint32_t max_degree;
+} metagraph_reorder_csr_t;
+
+static uint32_t metagraph_reorder_degree(const metagraph_reorder_csr_t *csr,
+                                         uint32_t node) {
+    return csr->rows[node + 1U] - csr->rows[node];
+}
+
+static int metagraph_reorder_compare_u32(const void *lhs, const void *rhs) {
+    const uint32_t a = *(const uint32_t *)lhs;
+    const uint32_t b = *(const uint32_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+static int metagraph_reorder_compare_u64(const void *lhs, const void *rhs) {
+    const uint64_t a = *(const uint64_t *)lhs;
+    const uint64_t b = *(const uint64_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+static void metagraph_reorder_csr_free(metagraph_reorder_csr_t *csr) {
+    free(csr->rows);
+    free(csr->neighbors);
+}
+
+// Relate every edge's source to each of its targets, both ways, then sort
+// and deduplicate each node's row in place.
+static metagraph_result_t
+metagraph_reorder_csr_build(const metagraph_graph_t *graph,
+                            metagraph_reorder_csr_t *csr) {
+    const size_t nodes = graph->node_count;
+    const size_t entries = 2U * (graph->member_count - graph->edge_count);
+    if (entries > UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "%zu adjacency entries exceed 32-bit rows",
+                             entries);
+    }
+    csr->node_count = nodes;
+    csr->rows = calloc(nodes + 1U, sizeof(*csr->rows));
+    csr->neighbors = malloc((entries + 1U) * sizeof(*csr->neighbors));
+    uint32_t *fill = malloc((nodes + 1U) * sizeof(*fill));
+    if (!csr->rows || !csr->neighbors || !fill) {
+        free(fill);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Cannot allocate a %zu-entry adjacency", entries);
+    }
+
+    for (size_t edge = 0; edge < graph->edge_count; edge++) {
+        const metagraph_node_index_t *members =
+            graph->members + graph->edge_member_begin[edge];
+        for (uint32_t i = 1; i < graph->edge_member_count[edge]; i++) {
+            if (members[i] != members[0]) {
+                csr->rows[members[0] + 1U]++;
+                csr->rows[members[i] + 1U]++;
+            }
+        }
+    }
+    for (size_t node = 0; node < nodes; node++) {
+        csr->rows[node + 1U] += csr->rows[node];
+    }
+    memcpy(fill, csr->rows, (nodes + 1U) * sizeof(*fill));
+    for (size_t edge = 0; edge < graph->edge_count; edge++) {
+        const metagraph_node_index_t *members =
+            graph->members + graph->edge_member_begin[edge];
+        for (uint32_t i = 1; i < graph->edge_member_count[edge]; i++) {
+            if (members[i] != members[0]) {
+                csr->neighbors[fill[members[0]]++] = members[i];
+                csr->neighbors[fill[members[i]]++] = members[0];
+            }
+        }
+    }
+    free(fill);
+
+    uint32_t written = 0;
+    uint32_t begin = 0;
+    for (size_t node = 0; node < nodes; node++) {
+        const uint32_t end = csr->rows[node + 1U];
+        uint32_t *row = csr->neighbors + begin;
+        qsort(row, end - begin, sizeof(*row), metagraph_reorder_compare_u32);
+        csr->rows[node] = written;
+        for (uint32_t i = 0; i < end - begin; i++) {
+            if (i == 0 || row[i] != row[i - 1U]) {
+                csr->neighbors[written++] = row[i];
+            }
+        }
+        const uint32_t degree = written - csr->rows[node];
+        if (degree > csr->max_degree) {
+            csr->max_degree = degree;
+        }
+        begin = end;
+    }
+    csr->rows[nodes] = written;
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// BFS and reverse Cuthill-McKee
+// ============================================================================
+
+// Place the component of root breadth-first, order doubling as the queue.
+// With keys, each node's unplaced neighbors are enqueued by degree.
+static size_t metagraph_reorder_component(const metagraph_reorder_csr_t *csr,
+                                          uint32_t root, bool *placed,
+                                          uint32_t *order, size_t tail,
+                                          uint64_t *keys) {
+    placed[root] = true;
+    size_t head = tail;
+    order[tail++] = root;
+    while (head < tail) {
+        const uint32_t node = order[head++];
+        size_t found = 0;
+        for (uint32_t i = csr->rows[node]; i < csr->rows[node + 1U]; i++) {
+            const uint32_t next = csr->neighbors[i];
+            if (placed[next]) {
+                continue;
+            }
+            placed[next] = true;
+            if (keys) {
+                keys[found++] =
+                    ((uint64_t)metagraph_reorder_degree(csr, next) << 32U) |
+                    next;
+            } else {
+                order[tail++] = next;
+            }
+        }
+        if (keys) {
+            qsort(keys, found, sizeof(*keys), metagraph_reorder_compare_u64);
+            for (size_t i = 0; i < found; i++) {
+                order[tail++] = (uint32_t)keys[i];
+            }
+        }
+    }
+    return tail;
+}
+
+static metagraph_result_t
+metagraph_reorder_bfs(const metagraph_reorder_csr_t *csr, bool reverse,
+                      uint32_t *order) {
+    const size_t nodes = csr->node_count;
+    bool *placed = calloc(nodes + 1U, sizeof(*placed));
+    METAGRAPH_CHECK_ALLOC(placed);
+    if (!reverse) {
+        size_t tail = 0;
+        for (uint32_t node = 0; node < nodes; node++) {
+            if (!placed[node]) {
+                tail = metagraph_reorder_component(csr, node, placed, order,
+                                                   tail, NULL);
+            }
+        }
+        free(placed);
+        return METAGRAPH_OK();
+    }
+
+    // Roots by ascending degree; keys is reused for each node's neighbors.
+    const size_t key_count =
+        nodes > csr->max_degree ? nodes : csr->max_degree;
+    uint64_t *keys = malloc((key_count + 1U) * sizeof(*keys));
+    uint32_t *roots = malloc((nodes + 1U) * sizeof(*roots));
+    if (!keys || !roots) {
+        free(placed);
+        free(keys);
+        free(roots);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Cannot allocate RCM queues for %zu nodes",
+                             nodes);
+    }
+    for (uint32_t node = 0; node < nodes; node++) {
+        keys[node] =
+            ((uint64_t)metagraph_reorder_degree(csr, node) << 32U) | node;
+    }
+    qsort(keys, nodes, sizeof(*keys), metagraph_reorder_compare_u64);
+    for (size_t i = 0; i < nodes; i++) {
+        roots[i] = (uint32_t)keys[i];
+    }
+    size_t tail = 0;
+    for (size_t i = 0; i < nodes; i++) {
+        if (!placed[roots[i]]) {
+            tail = metagraph_reorder_component(csr, roots[i], placed, order,
+                                               tail, keys);
+        }
+    }
+    for (size_t i = 0; i < nodes / 2U; i++) {
+        const uint32_t swap = order[i];
+        order[i] = order[nodes - 1U - i];
+        order[nodes - 1U - i] = swap;
+    }
+    free(placed);
+    free(keys);
+    free(roots);
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Gorder-style greedy window placement
+// ============================================================================
+
+typedef struct {
+    uint32_t *score;
+    uint32_t *prev;
+    uint32_t *next;
+    uint32_t *head; ///< First node of each score bucket
+    size_t top;     ///< No bucket above this holds a node
+    bool *placed;
+} metagraph_reorder_heap_t;
+
+static void metagraph_reorder_unlink(metagraph_reorder_heap_t *heap,
+                                     uint32_t node) {
+    const uint32_t prev = heap->prev[node];
+    const uint32_t next = heap->next[node];
+    if (prev != METAGRAPH_INVALID_INDEX) {
+        heap->next[prev] = next;
+    } else {
+        heap->head[heap->score[node]] = next;
+    }
+    if (next != METAGRAPH_INVALID_INDEX) {
+        heap->prev[next] = prev;
+    }
+}
+
+static void metagraph_reorder_link(metagraph_reorder_heap_t *heap,
+                                   uint32_t node) {
+    const uint32_t score = heap->score[node];
+    const uint32_t first = heap->head[score];
+    heap->prev[node] = METAGRAPH_INVALID_INDEX;
+    heap->next[node] = first;
+    if (first != METAGRAPH_INVALID_INDEX) {
+        heap->prev[first] = node;
+    }
+    heap->head[score] = node;
+    if (score > heap->top) {
+        heap->top = score;
+    }
+}
+
+static void metagraph_reorder_adjust(metagraph_reorder_heap_t *heap,
+                                     uint32_t node, bool up) {
+    if (heap->placed[node]) {
+        return;
+    }
+    metagraph_reorder_unlink(heap, node);
+    heap->score[node] = up ? heap->score[node] + 1U : heap->score[node] - 1U;
+    metagraph_reorder_link(heap, node);
+}
+
+// Add (up) or withdraw the credit a window node gives its neighbors and,
+// through non-hub neighbors, the nodes it shares them with.
+static void metagraph_reorder_credit(const metagraph_reorder_csr_t *csr,
+                                     metagraph_reorder_heap_t *heap,
+                                     uint32_t node, bool up) {
+    for (uint32_t i = csr->rows[node]; i < csr->rows[node + 1U]; i++) {
+        const uint32_t neighbor = csr->neighbors[i];
+        metagraph_reorder_adjust(heap, neighbor, up);
+        if (metagraph_reorder_degree(csr, neighbor) >
+            METAGRAPH_REORDER_HUB_DEGREE) {
+            continue;
+        }
+        for (uint32_t j = csr->rows[neighbor]; j < csr->rows[neighbor + 1U];
+             j++) {
+            if (csr->neighbors[j] != node) {
+                metagraph_reorder_adjust(heap, csr->neighbors[j], up);
+            }
+        }
+    }
+}
+
+static uint32_t metagraph_reorder_pop(metagraph_reorder_heap_t *heap) {
+    while (heap->head[heap->top] == METAGRAPH_INVALID_INDEX) {
+        if (heap->top == 0) {
+            return METAGRAPH_INVALID_INDEX;
+        }
+        heap->top--;
+    }
+    const uint32_t node = heap->head[heap->top];
+    metagraph_reorder_unlink(heap, node);
+    heap->placed[node] = true;
+    return node;
+}
+
+static metagraph_result_t
+metagraph_reorder_gorder(const metagraph_reorder_csr_t *csr, uint32_t *order) {
+    const size_t nodes = csr->node_count;
+    // A window node credits another node at most once per shared neighbor
+    // plus once for an edge between them.
+    const size_t buckets =
+        METAGRAPH_REORDER_WINDOW * ((size_t)csr->max_degree + 1U) + 1U;
+    metagraph_reorder_heap_t heap = {
+        .score = calloc(nodes + 1U, sizeof(uint32_t)),
+        .prev = malloc((nodes + 1U) * sizeof(uint32_t)),
+        .next = malloc((nodes + 1U) * sizeof(uint32_t)),
+        .head = malloc(buckets * sizeof(uint32_t)),
+        .placed = calloc(nodes + 1U, sizeof(bool)),
+    };
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    if (!heap.score || !heap.prev || !heap.next || !heap.head ||
+        !heap.placed) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Cannot allocate a %zu-node placement heap",
+                               nodes);
+        goto done;
+    }
+    memset(heap.head, 0xFF, buckets * sizeof(uint32_t));
+    // Linked in reverse so ties go to the lowest index.
+    for (size_t node = nodes; node-- > 0;) {
+        metagraph_reorder_link(&heap, (uint32_t)node);
+    }
+    for (size_t i = 0; i < nodes; i++) {
+        const uint32_t node = metagraph_reorder_pop(&heap);
+        order[i] = node;
+        if (i >= METAGRAPH_REORDER_WINDOW) {
+            metagraph_reorder_credit(csr, &heap,
+                                     order[i - METAGRAPH_REORDER_WINDOW],
+                                     false);
+        }
+        metagraph_reorder_credit(csr, &heap, node, true);
+    }
+
+done:
+    free(heap.score);
+    free(heap.prev);
+    free(heap.next);
+    free(heap.head);
+    free(heap.placed);
+    return result;
+}
+
+metagraph_result_t metagraph_reorder_nodes(const metagraph_graph_t *graph,
+                                           metagraph_reorder_t method,
+                                           metagraph_node_index_t *out_order) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_order);
+    if (method == METAGRAPH_REORDER_NONE) {
+        for (size_t node = 0; node < graph->node_count; node++) {
+            out_order[node] = (metagraph_node_index_t)node;
+        }
+        return METAGRAPH_OK();
+    }
+    if (method != METAGRAPH_REORDER_BFS && method != METAGRAPH_REORDER_RCM &&
+        method != METAGRAPH_REORDER_GORDER) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Unknown reorder method %u", (unsigned)method);
+    }
+
+    metagraph_reorder_csr_t csr = {0};
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    METAGRAPH_CHECK_GOTO(metagraph_reorder_csr_build(graph, &csr), done);
+    if (method == METAGRAPH_REORDER_GORDER) {
+        result = metagraph_reorder_gorder(&csr, out_order);
+    } else {
+        result = metagraph_reorder_bfs(&csr, method == METAGRAPH_REORDER_RCM,
+                                       out_order);
+    }
+
+done:
+    metagraph_reorder_csr_free(&csr);
+    return result;
+}
+
+// ============================================================================
+// Locality metrics
+// ============================================================================
+
+static uint32_t metagraph_reorder_rank(const metagraph_node_index_t *rank,
+                                       uint32_t node) {
+    return rank ? rank[node] : node;
+}
+
+// Walk dependencies breadth-first from start, counting the distinct node
+// record pages of the first METAGRAPH_REORDER_WALK nodes reached.
+static uint64_t metagraph_reorder_walk(const metagraph_graph_t *graph,
+                                       const metagraph_node_index_t *rank,
+                                       uint32_t start, uint32_t stamp,
+                                       uint32_t *node_seen,
+                                       uint32_t *page_seen, uint32_t *queue) {
+    size_t head = 0;
+    size_t tail = 0;
+    uint64_t pages = 0;
+    node_seen[start] = stamp;
+    queue[tail++] = start;
+    while (head < tail) {
+        const uint32_t node = queue[head++];
+        const uint32_t page =
+            metagraph_reorder_rank(rank, node) >> METAGRAPH_REORDER_PAGE_LOG2;
+        if (page_seen[page] != stamp) {
+            page_seen[page] = stamp;
+            pages++;
+        }
+        for (uint32_t record = graph->node_out_head[node];
+             record != METAGRAPH_INVALID_INDEX && tail < METAGRAPH_REORDER_WALK;
+             record = graph->incidence_next[record]) {
+            const metagraph_edge_index_t edge = graph->incidence_edge[record];
+            const metagraph_node_index_t *members =
+                graph->members + graph->edge_member_begin[edge];
+            for (uint32_t i = 1; i < graph->edge_member_count[edge] &&
+                                 tail < METAGRAPH_REORDER_WALK;
+                 i++) {
+                if (node_seen[members[i]] != stamp) {
+                    node_seen[members[i]] = stamp;
+                    queue[tail++] = members[i];
+                }
+            }
+        }
+    }
+    return pages;
+}
+
+metagraph_result_t
+metagraph_reorder_measure(const metagraph_graph_t *graph,
+                          const metagraph_node_index_t *rank,
+                          metagraph_locality_metrics_t *out_metrics) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_metrics);
+    *out_metrics = (metagraph_locality_metrics_t){0};
+    const size_t nodes = graph->node_count;
+    if (nodes == 0) {
+        return METAGRAPH_OK();
+    }
+
+    double span_total = 0.0;
+    uint64_t spans = 0;
+    for (size_t edge = 0; edge < graph->edge_count; edge++) {
+        const metagraph_node_index_t *members =
+            graph->members + graph->edge_member_begin[edge];
+        const uint32_t source = metagraph_reorder_rank(rank, members[0]);
+        for (uint32_t i = 1; i < graph->edge_member_count[edge]; i++) {
+            const uint32_t target = metagraph_reorder_rank(rank, members[i]);
+            const uint64_t span =
+                source > target ? source - target : target - source;
+            span_total += (double)span;
+            spans++;
+            if (span > out_metrics->max_edge_span) {
+                out_metrics->max_edge_span = span;
+            }
+        }
+    }
+    if (spans) {
+        out_metrics->average_edge_span = span_total / (double)spans;
+    }
+
+    uint32_t *node_seen = calloc(nodes, sizeof(*node_seen));
+    uint32_t *page_seen =
+        calloc((nodes >> METAGRAPH_REORDER_PAGE_LOG2) + 1U, sizeof(*page_seen));
+    uint32_t *queue = malloc(METAGRAPH_REORDER_WALK * sizeof(*queue));
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    if (!node_seen || !page_seen || !queue) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Cannot allocate locality walks over %zu nodes",
+                               nodes);
+        goto done;
+    }
+    const size_t samples =
+        nodes < METAGRAPH_REORDER_SAMPLES ? nodes : METAGRAPH_REORDER_SAMPLES;
+    uint64_t pages = 0;
+    for (size_t sample = 0; sample < samples; sample++) {
+        const uint32_t start = (uint32_t)(sample * nodes / samples);
+        pages += metagraph_reorder_walk(graph, rank, start,
+                                        (uint32_t)sample + 1U, node_seen,
+                                        page_seen, queue);
+    }
+    out_metrics->page_touches = (double)pages / (double)samples;
+
+done:
+    free(node_seen);
+    free(page_seen);
+    free(queue);
+    return result;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file reorder.h
+ * @brief Internal locality-improving node orderings for the bundle writer
+ *
+ * Orderings work on the graph's undirected structure: an edge relates its
+ * source to each of its targets (targets are not related to each other),
+ * so a wide hyperedge adds one entry per member rather than a clique.
+ */
+
+#ifndef SRC_REORDER_H
+#define SRC_REORDER_H
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+/**
+ * @brief Compute a new node order
+ *
+ * out_order[i] receives the graph index of the node placed at i, for
+ * every node of the graph.
+ *
+ * @return METAGRAPH_SUCCESS, METAGRAPH_ERROR_INVALID_ARGUMENT for an
+ *         unknown method or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t metagraph_reorder_nodes(const metagraph_graph_t *graph,
+                                           metagraph_reorder_t method,
+                                           metagraph_node_index_t *out_order);
+
+/**
+ * @brief Measure the locality of a numbering
+ *
+ * rank[n] is the new index of graph node n; NULL measures graph order.
+ *
+ * @return METAGRAPH_SUCCESS or METAGRAPH_ERROR_OUT_OF_MEMORY
+ */
+metagraph_result_t
+metagraph_reorder_measure(const metagraph_graph_t *graph,
+                          const metagraph_node_index_t *rank,
+                          metagraph_locality_metrics_t *out_metrics);
+
+#endif // SRC_REORDER_H
@@ -0,0 +1,477 @@
+/**
+ * @file residency.c
+ * @brief Access tracking and adaptive page advice for mapped bundles
+ *
+ * Accessors report to a tracker that lives as long as the bundle, so a
+ * reader racing a policy's destruction never touches freed memory; a
+ * detached tracker just stops counting. Each thread tallies accesses
+ * locally and adds them to the shared per-section counters every
+ * METAGRAPH_RESIDENCY_FLUSH accesses, keeping contended atomics off the
+ * lookup path. STORE ranges record the interval they were last read in
+ * instead of a count; the store is skipped when the range already holds
+ * the current interval, so a hot range's cache line stays shared.
+ */
+
+#include "metagraph/residency.h"
+#include "metagraph/result.h"
+
+#include "bundle_internal.h"
+#include "platform.h"
+#include "residency_internal.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METAGRAPH_RESIDENCY_CACHE_LINE 64U
+#define METAGRAPH_RESIDENCY_FLUSH 64U
+#define METAGRAPH_RESIDENCY_PAGE_LOG2 12U
+#define METAGRAPH_RESIDENCY_RANGE_LOG2 21U // 2 MiB STORE ranges
+#define METAGRAPH_RESIDENCY_DEFAULT_HOT 64U
+#define METAGRAPH_RESIDENCY_DEFAULT_COLD 2U
+#define METAGRAPH_RESIDENCY_DEFAULT_PAGEOUT 4U
+
+// Sections that take huge-page advice: probed at random by every lookup.
+#define METAGRAPH_RESIDENCY_HUGE_SECTIONS                                      \
+    ((1U << METAGRAPH_SECTION_INDEX) | (1U << METAGRAPH_SECTION_LOOKUP) |      \
+     (1U << METAGRAPH_SECTION_EDGES))
+
+// STORE range states
+enum {
+    METAGRAPH_RANGE_WARM = 0,
+    METAGRAPH_RANGE_COLD = 1,
+    METAGRAPH_RANGE_PAGED_OUT = 2,
+};
+
+typedef struct {
+    _Alignas(METAGRAPH_RESIDENCY_CACHE_LINE) _Atomic(uint64_t) accesses;
+    _Atomic(uint64_t) sequential;
+} metagraph_residency_counter_t;
+
+struct metagraph_residency_tracker {
+    metagraph_residency_counter_t counters[METAGRAPH_SECTION_TYPE_COUNT];
+    _Alignas(METAGRAPH_RESIDENCY_CACHE_LINE) _Atomic(bool) attached;
+    _Atomic(uint32_t) interval;
+    size_t store_ranges;
+    _Atomic(uint32_t) *store_touched; ///< Interval of each range's last read
+};
+
+typedef struct {
+    bool present;
+    bool huge_pages;
+    uint64_t offset;
+    uint64_t size;
+    size_t resident;
+    metagraph_memory_advice_t advice;
+} metagraph_residency_section_t;
+
+struct metagraph_residency {
+    metagraph_memory_map_t *map;
+    metagraph_residency_tracker_t *tracker;
+    metagraph_residency_policy_t policy;
+    metagraph_residency_section_t sections[METAGRAPH_SECTION_TYPE_COUNT];
+    uint8_t *range_state;
+};
+
+// ============================================================================
+// Tracking
+// ============================================================================
+
+// A thread's unflushed counts. They belong to one tracker at a time; a
+// thread moving to another bundle drops what it had not flushed.
+typedef struct {
+    const metagraph_residency_tracker_t *owner;
+    uint32_t pending;
+    uint64_t last[METAGRAPH_SECTION_TYPE_COUNT];
+    uint32_t accesses[METAGRAPH_SECTION_TYPE_COUNT];
+    uint32_t sequential[METAGRAPH_SECTION_TYPE_COUNT];
+} metagraph_residency_tally_t;
+
+static METAGRAPH_THREAD_LOCAL metagraph_residency_tally_t
+    metagraph_residency_tally;
+
+static void metagraph_residency_flush(metagraph_residency_tracker_t *tracker,
+                                      metagraph_residency_tally_t *tally) {
+    for (uint32_t type = 0; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        if (tally->accesses[type]) {
+            atomic_fetch_add_explicit(&tracker->counters[type].accesses,
+                                      tally->accesses[type],
+                                      memory_order_relaxed);
+            atomic_fetch_add_explicit(&tracker->counters[type].sequential,
+                                      tally->sequential[type],
+                                      memory_order_relaxed);
+            tally->accesses[type] = 0;
+            tally->sequential[type] = 0;
+        }
+    }
+    tally->pending = 0;
+}
+
+void metagraph_residency_note(metagraph_residency_tracker_t *tracker,
+                              metagraph_section_type_t type,
+                              uint64_t position) {
+    if (!atomic_load_explicit(&tracker->attached, memory_order_relaxed)) {
+        return;
+    }
+    metagraph_residency_tally_t *tally = &metagraph_residency_tally;
+    if (tally->owner != tracker) {
+        memset(tally, 0, sizeof(*tally));
+        tally->owner = tracker;
+        // No position is within one of this, so the first access of each
+        // section never counts as sequential.
+        for (uint32_t i = 0; i < METAGRAPH_SECTION_TYPE_COUNT; i++) {
+            tally->last[i] = UINT64_MAX - 1U;
+        }
+    }
+    if (type == METAGRAPH_SECTION_STORE) {
+        const uint64_t range = position >> METAGRAPH_RESIDENCY_RANGE_LOG2;
+        if (range < tracker->store_ranges) {
+            const uint32_t interval =
+                atomic_load_explicit(&tracker->interval, memory_order_relaxed);
+            _Atomic(uint32_t) *touched = &tracker->store_touched[range];
+            if (atomic_load_explicit(touched, memory_order_relaxed) !=
+                interval) {
+                atomic_store_explicit(touched, interval, memory_order_relaxed);
+            }
+        }
+        position >>= METAGRAPH_RESIDENCY_PAGE_LOG2;
+    }
+    tally->accesses[type]++;
+    if (position - tally->last[type] <= 1U) {
+        tally->sequential[type]++;
+    }
+    tally->last[type] = position;
+    if (++tally->pending == METAGRAPH_RESIDENCY_FLUSH) {
+        metagraph_residency_flush(tracker, tally);
+    }
+}
+
+void metagraph_residency_tracker_free(metagraph_residency_tracker_t *tracker) {
+    if (tracker) {
+        free(tracker->store_touched);
+        metagraph_aligned_free(tracker);
+    }
+}
+
+// The bundle's tracker, installing one on first use.
+static metagraph_result_t
+metagraph_residency_tracker(const metagraph_bundle_t *bundle,
+                            metagraph_residency_tracker_t **out_tracker) {
+    _Atomic(metagraph_residency_tracker_t *) *slot =
+        metagraph_bundle_tracker_slot(bundle);
+    metagraph_residency_tracker_t *tracker =
+        atomic_load_explicit(slot, memory_order_acquire);
+    if (tracker) {
+        *out_tracker = tracker;
+        return METAGRAPH_OK();
+    }
+
+    tracker = metagraph_aligned_alloc(METAGRAPH_RESIDENCY_CACHE_LINE,
+                                      sizeof(*tracker));
+    METAGRAPH_CHECK_ALLOC(tracker);
+    memset(tracker, 0, sizeof(*tracker));
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    uint32_t flags = 0;
+    if (metagraph_bundle_own_section(bundle, METAGRAPH_SECTION_STORE, &offset,
+                                     &size, &flags) &&
+        !(flags & METAGRAPH_SECTION_FLAG_COMPRESSED) && size) {
+        const size_t ranges =
+            (size_t)((size - 1U) >> METAGRAPH_RESIDENCY_RANGE_LOG2) + 1U;
+        tracker->store_touched =
+            calloc(ranges, sizeof(*tracker->store_touched));
+        if (!tracker->store_touched) {
+            metagraph_aligned_free(tracker);
+            return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                 "Failed to allocate %zu range stamps",
+                                 ranges);
+        }
+        tracker->store_ranges = ranges;
+    }
+
+    metagraph_residency_tracker_t *expected = NULL;
+    if (!atomic_compare_exchange_strong_explicit(slot, &expected, tracker,
+                                                 memory_order_acq_rel,
+                                                 memory_order_acquire)) {
+        metagraph_residency_tracker_free(tracker);
+        tracker = expected;
+    }
+    *out_tracker = tracker;
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Policy
+// ============================================================================
+
+// Issue advice, counting it; advice the OS lacks is counted and skipped.
+static metagraph_result_t
+metagraph_residency_advise(metagraph_residency_t *residency, uint64_t offset,
+                           uint64_t size, metagraph_memory_advice_t advice,
+                           metagraph_residency_report_t *report,
+                           bool *out_applied) {
+    *out_applied = false;
+    const metagraph_result_t result = metagraph_mmap_advise(
+        residency->map, offset, (size_t)size, advice);
+    report->advice_calls++;
+    if (result == METAGRAPH_ERROR_PLATFORM_NOT_SUPPORTED) {
+        report->unsupported++;
+        return METAGRAPH_OK();
+    }
+    METAGRAPH_CHECK(result);
+    *out_applied = true;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_residency_create(const metagraph_bundle_t *bundle,
+                           const metagraph_residency_policy_t *policy,
+                           metagraph_residency_t **out_residency) {
+    METAGRAPH_CHECK_NULL(bundle);
+    METAGRAPH_CHECK_NULL(out_residency);
+    *out_residency = NULL;
+
+    metagraph_residency_tracker_t *tracker = NULL;
+    METAGRAPH_CHECK(metagraph_residency_tracker(bundle, &tracker));
+    metagraph_residency_t *residency = calloc(1, sizeof(*residency));
+    METAGRAPH_CHECK_ALLOC(residency);
+    if (tracker->store_ranges) {
+        residency->range_state = calloc(tracker->store_ranges, 1);
+        if (!residency->range_state) {
+            free(residency);
+            return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                 "Failed to allocate %zu range states",
+                                 tracker->store_ranges);
+        }
+    }
+    bool detached = false;
+    if (!atomic_compare_exchange_strong_explicit(&tracker->attached, &detached,
+                                                 true, memory_order_acq_rel,
+                                                 memory_order_relaxed)) {
+        free(residency->range_state);
+        free(residency);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Bundle already has a residency policy");
+    }
+
+    // Advice changes kernel state, not the mapping object.
+    const metagraph_memory_map_t *map = metagraph_bundle_get_map(bundle);
+    residency->map = (void *)(uintptr_t)map;
+    residency->tracker = tracker;
+    if (policy) {
+        residency->policy = *policy;
+    }
+    metagraph_residency_policy_t *settings = &residency->policy;
+    if (!settings->hot_accesses) {
+        settings->hot_accesses = METAGRAPH_RESIDENCY_DEFAULT_HOT;
+    }
+    if (!settings->cold_intervals) {
+        settings->cold_intervals = METAGRAPH_RESIDENCY_DEFAULT_COLD;
+    }
+    if (!settings->pageout_intervals) {
+        settings->pageout_intervals = METAGRAPH_RESIDENCY_DEFAULT_PAGEOUT;
+    }
+
+    // Counts left from an earlier policy belong to its intervals; every
+    // range starts out read in the current one.
+    const uint32_t interval =
+        atomic_load_explicit(&tracker->interval, memory_order_relaxed);
+    for (size_t i = 0; i < tracker->store_ranges; i++) {
+        atomic_store_explicit(&tracker->store_touched[i], interval,
+                              memory_order_relaxed);
+    }
+    for (uint32_t type = 0; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        atomic_store_explicit(&tracker->counters[type].accesses, 0,
+                              memory_order_relaxed);
+        atomic_store_explicit(&tracker->counters[type].sequential, 0,
+                              memory_order_relaxed);
+    }
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_residency_report_t scratch;
+    for (uint32_t type = 1; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        metagraph_residency_section_t *section = &residency->sections[type];
+        uint32_t flags = 0;
+        section->present = metagraph_bundle_own_section(
+            bundle, (metagraph_section_type_t)type, &section->offset,
+            &section->size, &flags);
+        section->advice = METAGRAPH_ADVICE_NORMAL;
+        if (!section->present) {
+            continue;
+        }
+        size_t pages = 0;
+        METAGRAPH_CHECK_GOTO(
+            metagraph_mmap_residency(residency->map, section->offset,
+                                     (size_t)section->size,
+                                     &section->resident, &pages),
+            fail);
+        if ((settings->flags & METAGRAPH_RESIDENCY_HUGE_PAGES) &&
+            (METAGRAPH_RESIDENCY_HUGE_SECTIONS & (1U << type)) &&
+            residency->map->is_coherent) {
+            METAGRAPH_CHECK_GOTO(
+                metagraph_residency_advise(residency, section->offset,
+                                           section->size,
+                                           METAGRAPH_ADVICE_HUGEPAGE, &scratch,
+                                           &section->huge_pages),
+                fail);
+        }
+    }
+    *out_residency = residency;
+    return METAGRAPH_OK();
+
+fail:
+    atomic_store_explicit(&tracker->attached, false, memory_order_release);
+    free(residency->range_state);
+    free(residency);
+    return result;
+}
+
+void metagraph_residency_destroy(metagraph_residency_t *residency) {
+    if (!residency) {
+        return;
+    }
+    atomic_store_explicit(&residency->tracker->attached, false,
+                          memory_order_release);
+    for (uint32_t type = 0; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        const metagraph_residency_section_t *section =
+            &residency->sections[type];
+        if (section->present && section->advice != METAGRAPH_ADVICE_NORMAL) {
+            (void)metagraph_mmap_advise(residency->map, section->offset,
+                                        (size_t)section->size,
+                                        METAGRAPH_ADVICE_NORMAL);
+        }
+    }
+    free(residency->range_state);
+    free(residency);
+}
+
+// Advice for a section from one interval's counts.
+static metagraph_memory_advice_t
+metagraph_residency_choose(const metagraph_residency_t *residency,
+                           const metagraph_residency_section_t *section,
+                           const metagraph_residency_section_report_t *seen) {
+    if (seen->accesses >= residency->policy.hot_accesses) {
+        if (seen->sequential * 2U >= seen->accesses) {
+            return METAGRAPH_ADVICE_SEQUENTIAL;
+        }
+        // Random and still faulting: pull the rest in rather than taking
+        // one fault per probe.
+        if (seen->faults && seen->resident_pages < seen->total_pages) {
+            return METAGRAPH_ADVICE_WILLNEED;
+        }
+        return METAGRAPH_ADVICE_RANDOM;
+    }
+    if (seen->accesses) {
+        return METAGRAPH_ADVICE_NORMAL;
+    }
+    return section->advice;
+}
+
+// Advise STORE ranges by how many intervals they have gone unread.
+static metagraph_result_t
+metagraph_residency_tune_ranges(metagraph_residency_t *residency,
+                                uint32_t interval,
+                                metagraph_residency_report_t *report) {
+    const metagraph_residency_tracker_t *tracker = residency->tracker;
+    const metagraph_residency_section_t *store =
+        &residency->sections[METAGRAPH_SECTION_STORE];
+    const uint32_t cold = residency->policy.cold_intervals;
+    const uint32_t pageout = cold + residency->policy.pageout_intervals;
+    const bool may_page_out =
+        (residency->policy.flags & METAGRAPH_RESIDENCY_PAGEOUT) != 0U;
+    report->store_ranges = tracker->store_ranges;
+
+    for (size_t range = 0; range < tracker->store_ranges; range++) {
+        const uint32_t touched = atomic_load_explicit(
+            &tracker->store_touched[range], memory_order_relaxed);
+        // Whole intervals without a read; a read stamped with the interval
+        // that just opened makes this negative.
+        const int32_t idle = (int32_t)(interval - 1U - touched);
+        uint8_t *state = &residency->range_state[range];
+        const uint64_t offset = (uint64_t)range
+                                << METAGRAPH_RESIDENCY_RANGE_LOG2;
+        const uint64_t size =
+            store->size - offset < (1ULL << METAGRAPH_RESIDENCY_RANGE_LOG2)
+                ? store->size - offset
+                : 1ULL << METAGRAPH_RESIDENCY_RANGE_LOG2;
+        bool applied = false;
+        if (idle <= 0) {
+            // Read again; faults bring the pages back on their own.
+            *state = METAGRAPH_RANGE_WARM;
+        } else if (*state == METAGRAPH_RANGE_WARM && (uint32_t)idle >= cold) {
+            METAGRAPH_CHECK(metagraph_residency_advise(
+                residency, store->offset + offset, size,
+                METAGRAPH_ADVICE_COLD, report, &applied));
+            *state = METAGRAPH_RANGE_COLD;
+        } else if (*state == METAGRAPH_RANGE_COLD && may_page_out &&
+                   (uint32_t)idle >= pageout) {
+            METAGRAPH_CHECK(metagraph_residency_advise(
+                residency, store->offset + offset, size,
+                METAGRAPH_ADVICE_PAGEOUT, report, &applied));
+            *state = METAGRAPH_RANGE_PAGED_OUT;
+        }
+        report->cold_ranges += *state == METAGRAPH_RANGE_COLD;
+        report->paged_out_ranges += *state == METAGRAPH_RANGE_PAGED_OUT;
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_residency_tune(metagraph_residency_t *residency,
+                         metagraph_residency_report_t *out_report) {
+    METAGRAPH_CHECK_NULL(residency);
+    metagraph_residency_tracker_t *tracker = residency->tracker;
+    metagraph_residency_report_t report;
+    memset(&report, 0, sizeof(report));
+
+    // Reads from here on are stamped with the new interval.
+    const uint32_t interval =
+        atomic_fetch_add_explicit(&tracker->interval, 1U,
+                                  memory_order_relaxed) +
+        1U;
+    for (uint32_t type = 1; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        metagraph_residency_section_t *section = &residency->sections[type];
+        metagraph_residency_section_report_t *seen = &report.sections[type];
+        if (!section->present) {
+            continue;
+        }
+        seen->present = true;
+        seen->huge_pages = section->huge_pages;
+        seen->accesses = atomic_exchange_explicit(
+            &tracker->counters[type].accesses, 0, memory_order_relaxed);
+        seen->sequential = atomic_exchange_explicit(
+            &tracker->counters[type].sequential, 0, memory_order_relaxed);
+        size_t resident = 0;
+        size_t pages = 0;
+        METAGRAPH_CHECK(metagraph_mmap_residency(residency->map,
+                                                 section->offset,
+                                                 (size_t)section->size,
+                                                 &resident, &pages));
+        seen->resident_pages = resident;
+        seen->total_pages = pages;
+        seen->faults =
+            resident > section->resident ? resident - section->resident : 0;
+        section->resident = resident;
+
+        const metagraph_memory_advice_t advice =
+            metagraph_residency_choose(residency, section, seen);
+        if (advice != section->advice) {
+            bool applied = false;
+            METAGRAPH_CHECK(metagraph_residency_advise(
+                residency, section->offset, section->size, advice, &report,
+                &applied));
+            if (applied) {
+                section->advice = advice;
+            }
+        }
+        seen->advice = section->advice;
+    }
+    METAGRAPH_CHECK(
+        metagraph_residency_tune_ranges(residency, interval, &report));
+    if (out_report) {
+        *out_report = report;
+    }
+    return METAGRAPH_OK();
+}
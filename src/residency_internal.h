@@ -0,0 +1,29 @@
+/**
+ * @file residency_internal.h
+ * @brief Access tracking hooks the bundle reader calls
+ */
+
+#ifndef SRC_RESIDENCY_INTERNAL_H
+#define SRC_RESIDENCY_INTERNAL_H
+
+#include "bundle_internal.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Count one access to a section
+ *
+ * position orders accesses within the section: a node, edge or slot index,
+ * or a byte offset for the STORE. Counts are batched per thread, so a
+ * tuning pass may miss a few of each thread's most recent accesses.
+ */
+void metagraph_residency_note(metagraph_residency_tracker_t *tracker,
+                              metagraph_section_type_t type,
+                              uint64_t position);
+
+/**
+ * @brief Free a bundle's tracker when the bundle is destroyed (NULL is ok)
+ */
+void metagraph_residency_tracker_free(metagraph_residency_tracker_t *tracker);
+
+#endif // SRC_RESIDENCY_INTERNAL_H
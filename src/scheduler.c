@@ -0,0 +1,771 @@
+/**
+ * @file scheduler.c
+ * @brief Work-stealing task scheduler and task graphs
+ *
+ * Every worker owns a queue of ready tasks. A worker pushes and pops at
+ * the back of its own queue, so forked work runs depth-first while its
+ * data is still cached; an idle worker steals from the front of another
+ * queue, taking the oldest and usually largest piece of work, and tries
+ * workers on its own NUMA node first. Threads that are not workers submit
+ * through a shared injection queue. The queues are rings behind one mutex
+ * each: library tasks are coarse (an asset load, a range of blocks to
+ * hash or decode), so an uncontended lock per push is noise next to the
+ * work, and it keeps growing and stealing simple.
+ *
+ * Waiting never parks a thread that could be working: a thread waiting on
+ * a latch runs queued tasks until the latch opens, and only sleeps when
+ * nothing is queued. A sleeper counts itself in `sleepers` before it
+ * rechecks `queued` and the latch; producers bump `queued` (or count down
+ * the latch) before they look at `sleepers`. Both sides use sequentially
+ * consistent atomics, so either the sleeper's recheck sees the new work
+ * or the producer sees the sleeper and broadcasts.
+ *
+ * A task graph run counts each task's unfinished prerequisites. Whoever
+ * finishes a task releases its dependents; the first dependent that
+ * becomes ready runs next on the same thread and the others are spawned,
+ * so a dependency chain never goes through a queue.
+ */
+
+#include "metagraph/numa.h"
+#include "metagraph/result.h"
+#include "metagraph/scheduler.h"
+
+#include "platform.h"
+#include "scheduler_internal.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METAGRAPH_SCHEDULER_CACHE_LINE 64U
+#define METAGRAPH_SCHEDULER_QUEUE_SIZE 64U
+#define METAGRAPH_TASK_GRAPH_INITIAL 16U
+
+typedef struct {
+    metagraph_mutex_t lock;
+    metagraph_task_t **items; ///< Ring of capacity entries
+    size_t capacity;          ///< Power of two
+    size_t head;              ///< Oldest task
+    _Atomic(size_t) count;    ///< Written under lock, peeked without
+} metagraph_task_queue_t;
+
+typedef struct {
+    _Alignas(METAGRAPH_SCHEDULER_CACHE_LINE) metagraph_task_queue_t queue;
+    metagraph_thread_t thread;
+    metagraph_scheduler_t *scheduler;
+    uint32_t index;
+    _Atomic(uint32_t) node; ///< NUMA node the worker runs on
+} metagraph_scheduler_worker_t;
+
+struct metagraph_scheduler {
+    uint32_t size;
+    metagraph_scheduler_worker_t *workers;
+    metagraph_task_queue_t injected; ///< Tasks from non-worker threads
+
+    _Atomic(size_t) queued; ///< Tasks in any queue (briefly over-counted)
+    _Atomic(uint32_t) sleepers;
+    _Atomic(bool) stop;
+    metagraph_mutex_t lock;
+    metagraph_cond_t wake; ///< New work, an opened latch, or stop
+};
+
+// The worker the calling thread is, if it is one
+static METAGRAPH_THREAD_LOCAL metagraph_scheduler_worker_t
+    *metagraph_scheduler_self;
+
+static struct {
+    metagraph_once_t once;
+    metagraph_scheduler_t *scheduler; ///< NULL if it could not start
+} metagraph_scheduler_shared;
+
+// ============================================================================
+// Task queues
+// ============================================================================
+
+static int metagraph_task_queue_init(metagraph_task_queue_t *queue) {
+    queue->items =
+        malloc(METAGRAPH_SCHEDULER_QUEUE_SIZE * sizeof(*queue->items));
+    if (!queue->items) {
+        return -1;
+    }
+    if (metagraph_mutex_init(&queue->lock) != 0) {
+        free(queue->items);
+        return -1;
+    }
+    queue->capacity = METAGRAPH_SCHEDULER_QUEUE_SIZE;
+    queue->head = 0;
+    atomic_init(&queue->count, 0);
+    return 0;
+}
+
+static void metagraph_task_queue_destroy(metagraph_task_queue_t *queue) {
+    metagraph_mutex_destroy(&queue->lock);
+    free(queue->items);
+}
+
+// False when the ring was full and could not grow.
+static bool metagraph_task_queue_push(metagraph_task_queue_t *queue,
+                                      metagraph_task_t *task) {
+    metagraph_mutex_lock(&queue->lock);
+    const size_t count =
+        atomic_load_explicit(&queue->count, memory_order_relaxed);
+    if (count == queue->capacity) {
+        metagraph_task_t **items =
+            malloc(2U * queue->capacity * sizeof(*items));
+        if (!items) {
+            metagraph_mutex_unlock(&queue->lock);
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            items[i] = queue->items[(queue->head + i) & (queue->capacity - 1U)];
+        }
+        free(queue->items);
+        queue->items = items;
+        queue->capacity *= 2U;
+        queue->head = 0;
+    }
+    queue->items[(queue->head + count) & (queue->capacity - 1U)] = task;
+    atomic_store_explicit(&queue->count, count + 1U, memory_order_relaxed);
+    metagraph_mutex_unlock(&queue->lock);
+    return true;
+}
+
+// Newest task, for the owner.
+static metagraph_task_t *
+metagraph_task_queue_pop_back(metagraph_task_queue_t *queue) {
+    if (atomic_load_explicit(&queue->count, memory_order_relaxed) == 0) {
+        return NULL;
+    }
+    metagraph_task_t *task = NULL;
+    metagraph_mutex_lock(&queue->lock);
+    const size_t count =
+        atomic_load_explicit(&queue->count, memory_order_relaxed);
+    if (count != 0) {
+        task =
+            queue->items[(queue->head + count - 1U) & (queue->capacity - 1U)];
+        atomic_store_explicit(&queue->count, count - 1U, memory_order_relaxed);
+    }
+    metagraph_mutex_unlock(&queue->lock);
+    return task;
+}
+
+// Oldest task, for thieves and the injection queue.
+static metagraph_task_t *
+metagraph_task_queue_pop_front(metagraph_task_queue_t *queue) {
+    if (atomic_load_explicit(&queue->count, memory_order_relaxed) == 0) {
+        return NULL;
+    }
+    metagraph_task_t *task = NULL;
+    metagraph_mutex_lock(&queue->lock);
+    const size_t count =
+        atomic_load_explicit(&queue->count, memory_order_relaxed);
+    if (count != 0) {
+        task = queue->items[queue->head];
+        queue->head = (queue->head + 1U) & (queue->capacity - 1U);
+        atomic_store_explicit(&queue->count, count - 1U, memory_order_relaxed);
+    }
+    metagraph_mutex_unlock(&queue->lock);
+    return task;
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+static metagraph_scheduler_worker_t *
+metagraph_scheduler_current(const metagraph_scheduler_t *scheduler) {
+    metagraph_scheduler_worker_t *self = metagraph_scheduler_self;
+    return self && self->scheduler == scheduler ? self : NULL;
+}
+
+static void metagraph_scheduler_notify(metagraph_scheduler_t *scheduler) {
+    if (atomic_load(&scheduler->sleepers) == 0) {
+        return;
+    }
+    metagraph_mutex_lock(&scheduler->lock);
+    metagraph_cond_broadcast(&scheduler->wake);
+    metagraph_mutex_unlock(&scheduler->lock);
+}
+
+// Steal the oldest task of some worker, trying self's NUMA node first.
+// Threads that are not workers (self == NULL) take from anyone.
+static metagraph_task_t *
+metagraph_scheduler_steal(metagraph_scheduler_t *scheduler,
+                          const metagraph_scheduler_worker_t *self) {
+    const uint32_t start = self ? self->index + 1U : 0;
+    const uint32_t node =
+        self ? atomic_load_explicit(&self->node, memory_order_relaxed) : 0;
+    for (uint32_t pass = 0; pass < 2U; pass++) {
+        for (uint32_t offset = 0; offset < scheduler->size; offset++) {
+            metagraph_scheduler_worker_t *victim =
+                &scheduler->workers[(start + offset) % scheduler->size];
+            if (victim == self) {
+                continue;
+            }
+            const bool local =
+                !self || atomic_load_explicit(&victim->node,
+                                              memory_order_relaxed) == node;
+            if (local != (pass == 0U)) {
+                continue;
+            }
+            metagraph_task_t *task =
+                metagraph_task_queue_pop_front(&victim->queue);
+            if (task) {
+                return task;
+            }
+        }
+    }
+    return NULL;
+}
+
+static metagraph_task_t *
+metagraph_scheduler_take(metagraph_scheduler_t *scheduler,
+                         metagraph_scheduler_worker_t *self) {
+    metagraph_task_t *task =
+        self ? metagraph_task_queue_pop_back(&self->queue) : NULL;
+    if (!task) {
+        task = metagraph_task_queue_pop_front(&scheduler->injected);
+    }
+    if (!task) {
+        task = metagraph_scheduler_steal(scheduler, self);
+    }
+    if (task) {
+        atomic_fetch_sub(&scheduler->queued, 1U);
+    }
+    return task;
+}
+
+// Sleep until something is queued, the latch (if any) opens, or the
+// scheduler stops. Returns false on stop.
+static bool metagraph_scheduler_sleep(metagraph_scheduler_t *scheduler,
+                                      metagraph_latch_t *latch) {
+    metagraph_mutex_lock(&scheduler->lock);
+    atomic_fetch_add(&scheduler->sleepers, 1U);
+    while (!atomic_load(&scheduler->stop) &&
+           atomic_load(&scheduler->queued) == 0 &&
+           !(latch && atomic_load(&latch->pending) == 0)) {
+        metagraph_cond_wait(&scheduler->wake, &scheduler->lock);
+    }
+    atomic_fetch_sub(&scheduler->sleepers, 1U);
+    const bool running = !atomic_load(&scheduler->stop);
+    metagraph_mutex_unlock(&scheduler->lock);
+    return running;
+}
+
+static void metagraph_scheduler_main(void *arg) {
+    metagraph_scheduler_worker_t *self = arg;
+    metagraph_scheduler_t *scheduler = self->scheduler;
+    metagraph_scheduler_self = self;
+    atomic_store_explicit(&self->node, metagraph_numa_current_node(),
+                          memory_order_relaxed);
+    for (;;) {
+        metagraph_task_t *task = metagraph_scheduler_take(scheduler, self);
+        if (task) {
+            task->run(task);
+        } else if (!metagraph_scheduler_sleep(scheduler, NULL)) {
+            return;
+        }
+    }
+}
+
+void metagraph_scheduler_spawn(metagraph_scheduler_t *scheduler,
+                               metagraph_task_t *task) {
+    if (!scheduler) {
+        task->run(task);
+        return;
+    }
+    metagraph_scheduler_worker_t *self = metagraph_scheduler_current(scheduler);
+    // Count first so the task is never taken before it is counted.
+    atomic_fetch_add(&scheduler->queued, 1U);
+    if (!metagraph_task_queue_push(self ? &self->queue : &scheduler->injected,
+                                   task)) {
+        atomic_fetch_sub(&scheduler->queued, 1U);
+        task->run(task);
+        return;
+    }
+    metagraph_scheduler_notify(scheduler);
+}
+
+void metagraph_scheduler_arrive(metagraph_scheduler_t *scheduler,
+                                metagraph_latch_t *latch) {
+    if (atomic_fetch_sub(&latch->pending, 1U) == 1U && scheduler) {
+        metagraph_scheduler_notify(scheduler);
+    }
+}
+
+void metagraph_scheduler_wait(metagraph_scheduler_t *scheduler,
+                              metagraph_latch_t *latch) {
+    if (!scheduler) {
+        // Everything ran when it was spawned.
+        return;
+    }
+    metagraph_scheduler_worker_t *self = metagraph_scheduler_current(scheduler);
+    while (atomic_load(&latch->pending) != 0) {
+        metagraph_task_t *task = metagraph_scheduler_take(scheduler, self);
+        if (task) {
+            task->run(task);
+        } else {
+            (void)metagraph_scheduler_sleep(scheduler, latch);
+        }
+    }
+}
+
+// ============================================================================
+// Scheduler lifetime
+// ============================================================================
+
+static void metagraph_scheduler_stop(metagraph_scheduler_t *scheduler,
+                                     uint32_t started) {
+    metagraph_mutex_lock(&scheduler->lock);
+    atomic_store(&scheduler->stop, true);
+    metagraph_cond_broadcast(&scheduler->wake);
+    metagraph_mutex_unlock(&scheduler->lock);
+    for (uint32_t i = 0; i < started; i++) {
+        metagraph_thread_join(&scheduler->workers[i].thread);
+    }
+}
+
+static void metagraph_scheduler_free(metagraph_scheduler_t *scheduler,
+                                     uint32_t queues) {
+    for (uint32_t i = 0; i < queues; i++) {
+        metagraph_task_queue_destroy(&scheduler->workers[i].queue);
+    }
+    metagraph_task_queue_destroy(&scheduler->injected);
+    metagraph_cond_destroy(&scheduler->wake);
+    metagraph_mutex_destroy(&scheduler->lock);
+    metagraph_aligned_free(scheduler->workers);
+    free(scheduler);
+}
+
+metagraph_result_t
+metagraph_scheduler_create(uint32_t thread_count,
+                           metagraph_scheduler_t **out_scheduler) {
+    METAGRAPH_CHECK_NULL(out_scheduler);
+    *out_scheduler = NULL;
+    if (thread_count == 0) {
+        const uint32_t cpus = metagraph_cpu_count();
+        thread_count = cpus > 1U ? cpus - 1U : 1U;
+    }
+    metagraph_scheduler_t *scheduler = calloc(1, sizeof(*scheduler));
+    METAGRAPH_CHECK_ALLOC(scheduler);
+    scheduler->size = thread_count;
+    scheduler->workers =
+        metagraph_aligned_alloc(METAGRAPH_SCHEDULER_CACHE_LINE,
+                                thread_count * sizeof(*scheduler->workers));
+    if (!scheduler->workers) {
+        free(scheduler);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate %u scheduler workers",
+                             thread_count);
+    }
+    memset(scheduler->workers, 0, thread_count * sizeof(*scheduler->workers));
+    atomic_init(&scheduler->queued, 0);
+    atomic_init(&scheduler->sleepers, 0);
+    atomic_init(&scheduler->stop, false);
+    if (metagraph_mutex_init(&scheduler->lock) != 0 ||
+        metagraph_cond_init(&scheduler->wake) != 0 ||
+        metagraph_task_queue_init(&scheduler->injected) != 0) {
+        metagraph_aligned_free(scheduler->workers);
+        free(scheduler);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_RESOURCE_EXHAUSTED,
+                             "Failed to initialize scheduler locks");
+    }
+    for (uint32_t i = 0; i < thread_count; i++) {
+        metagraph_scheduler_worker_t *worker = &scheduler->workers[i];
+        if (metagraph_task_queue_init(&worker->queue) != 0) {
+            metagraph_scheduler_free(scheduler, i);
+            return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                 "Failed to allocate scheduler queue %u", i);
+        }
+        worker->scheduler = scheduler;
+        worker->index = i;
+        atomic_init(&worker->node, 0);
+    }
+    for (uint32_t i = 0; i < thread_count; i++) {
+        if (metagraph_thread_create(&scheduler->workers[i].thread,
+                                    metagraph_scheduler_main,
+                                    &scheduler->workers[i]) != 0) {
+            metagraph_scheduler_stop(scheduler, i);
+            metagraph_scheduler_free(scheduler, thread_count);
+            return METAGRAPH_ERR(METAGRAPH_ERROR_THREAD_CREATION_FAILED,
+                                 "Failed to start scheduler thread %u", i);
+        }
+    }
+    *out_scheduler = scheduler;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_scheduler_destroy(metagraph_scheduler_t *scheduler) {
+    if (!scheduler) {
+        return METAGRAPH_OK();
+    }
+    // Only compare once the shared scheduler exists; asking for it here
+    // would start its threads just to tear down a private one.
+    if (metagraph_once_done(&metagraph_scheduler_shared.once) &&
+        scheduler == metagraph_scheduler_shared.scheduler) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "The shared scheduler cannot be destroyed");
+    }
+    metagraph_scheduler_stop(scheduler, scheduler->size);
+    metagraph_scheduler_free(scheduler, scheduler->size);
+    return METAGRAPH_OK();
+}
+
+static void metagraph_scheduler_start_shared(void) {
+    metagraph_scheduler_t *scheduler = NULL;
+    if (metagraph_scheduler_create(0, &scheduler) != METAGRAPH_SUCCESS) {
+        // Callers run their work inline from now on.
+        scheduler = NULL;
+    }
+    metagraph_scheduler_shared.scheduler = scheduler;
+}
+
+metagraph_scheduler_t *metagraph_scheduler_default(void) {
+    metagraph_once(&metagraph_scheduler_shared.once,
+                   metagraph_scheduler_start_shared);
+    return metagraph_scheduler_shared.scheduler;
+}
+
+metagraph_result_t
+metagraph_scheduler_get_shared(metagraph_scheduler_t **out_scheduler) {
+    METAGRAPH_CHECK_NULL(out_scheduler);
+    *out_scheduler = metagraph_scheduler_default();
+    if (!*out_scheduler) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_THREAD_CREATION_FAILED,
+                             "The shared scheduler could not be started");
+    }
+    return METAGRAPH_OK();
+}
+
+uint32_t
+metagraph_scheduler_thread_count(const metagraph_scheduler_t *scheduler) {
+    return scheduler ? scheduler->size : 0;
+}
+
+// ============================================================================
+// Task graphs
+// ============================================================================
+
+typedef struct {
+    metagraph_task_fn fn;
+    void *context;
+} metagraph_task_entry_t;
+
+typedef struct {
+    metagraph_task_id_t task;
+    metagraph_task_id_t prerequisite;
+} metagraph_task_edge_t;
+
+struct metagraph_task_graph {
+    metagraph_task_entry_t *tasks;
+    size_t task_count;
+    size_t task_capacity;
+    metagraph_task_edge_t *edges;
+    size_t edge_count;
+    size_t edge_capacity;
+};
+
+typedef struct metagraph_task_run metagraph_task_run_t;
+
+typedef struct {
+    metagraph_task_t task;
+    metagraph_task_run_t *run;
+    metagraph_task_id_t id;
+} metagraph_task_node_t;
+
+// State of one metagraph_task_graph_run() call
+struct metagraph_task_run {
+    metagraph_scheduler_t *scheduler;
+    const metagraph_task_graph_t *graph;
+    metagraph_task_node_t *nodes;
+    _Atomic(uint32_t) *pending;  ///< Unfinished prerequisites per task
+    _Atomic(bool) *blocked;      ///< A prerequisite did not succeed
+    size_t *successor_rows;      ///< task_count + 1 offsets into successors
+    metagraph_task_id_t *successors;
+
+    _Atomic(size_t) completed;
+    _Atomic(size_t) failed;
+    _Atomic(size_t) skipped;
+    atomic_flag errored;
+    metagraph_error_context_t error; ///< First failure, if any
+    metagraph_latch_t done;          ///< One count per task
+};
+
+metagraph_result_t
+metagraph_task_graph_create(metagraph_task_graph_t **out_graph) {
+    METAGRAPH_CHECK_NULL(out_graph);
+    *out_graph = calloc(1, sizeof(**out_graph));
+    METAGRAPH_CHECK_ALLOC(*out_graph);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_task_graph_destroy(metagraph_task_graph_t *graph) {
+    if (!graph) {
+        return METAGRAPH_OK();
+    }
+    free(graph->tasks);
+    free(graph->edges);
+    free(graph);
+    return METAGRAPH_OK();
+}
+
+// Make room for one more element of size bytes in *items.
+static bool metagraph_task_graph_reserve(void **items, size_t *capacity,
+                                         size_t count, size_t size) {
+    if (count < *capacity) {
+        return true;
+    }
+    const size_t grown =
+        *capacity ? 2U * *capacity : METAGRAPH_TASK_GRAPH_INITIAL;
+    void *resized = realloc(*items, grown * size);
+    if (!resized) {
+        return false;
+    }
+    *items = resized;
+    *capacity = grown;
+    return true;
+}
+
+metagraph_result_t metagraph_task_graph_add_task(metagraph_task_graph_t *graph,
+                                                 metagraph_task_fn fn,
+                                                 void *context,
+                                                 metagraph_task_id_t *out_id) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(fn);
+    if (graph->task_count >= UINT32_MAX) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_MAX_NODES_EXCEEDED,
+                             "Task graph is full");
+    }
+    void *tasks = graph->tasks;
+    if (!metagraph_task_graph_reserve(&tasks, &graph->task_capacity,
+                                      graph->task_count,
+                                      sizeof(*graph->tasks))) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to grow task graph");
+    }
+    graph->tasks = tasks;
+    graph->tasks[graph->task_count] =
+        (metagraph_task_entry_t){.fn = fn, .context = context};
+    if (out_id) {
+        *out_id = (metagraph_task_id_t)graph->task_count;
+    }
+    graph->task_count++;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_task_graph_add_dependency(metagraph_task_graph_t *graph,
+                                    metagraph_task_id_t task,
+                                    metagraph_task_id_t prerequisite) {
+    METAGRAPH_CHECK_NULL(graph);
+    if (task >= graph->task_count || prerequisite >= graph->task_count ||
+        task == prerequisite) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Invalid dependency %u -> %u", task,
+                             prerequisite);
+    }
+    void *edges = graph->edges;
+    if (!metagraph_task_graph_reserve(&edges, &graph->edge_capacity,
+                                      graph->edge_count,
+                                      sizeof(*graph->edges))) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to grow task graph");
+    }
+    graph->edges = edges;
+    graph->edges[graph->edge_count++] = (metagraph_task_edge_t){
+        .task = task, .prerequisite = prerequisite};
+    return METAGRAPH_OK();
+}
+
+static void metagraph_task_node_run(metagraph_task_t *task) {
+    metagraph_task_node_t *node = (metagraph_task_node_t *)(void *)task;
+    while (node) {
+        metagraph_task_run_t *run = node->run;
+        const metagraph_task_id_t id = node->id;
+        bool succeeded = false;
+        if (atomic_load_explicit(&run->blocked[id], memory_order_relaxed)) {
+            atomic_fetch_add_explicit(&run->skipped, 1U, memory_order_relaxed);
+        } else {
+            const metagraph_task_entry_t *entry = &run->graph->tasks[id];
+            const metagraph_result_t result = entry->fn(entry->context);
+            if (metagraph_result_is_error(result)) {
+                atomic_fetch_add_explicit(&run->failed, 1U,
+                                          memory_order_relaxed);
+                if (!atomic_flag_test_and_set(&run->errored)) {
+                    (void)metagraph_get_error_context(&run->error);
+                    run->error.code = result;
+                }
+            } else {
+                atomic_fetch_add_explicit(&run->completed, 1U,
+                                          memory_order_relaxed);
+                succeeded = true;
+            }
+        }
+
+        // Release dependents; keep the first ready one for this thread.
+        metagraph_task_node_t *next = NULL;
+        for (size_t i = run->successor_rows[id];
+             i < run->successor_rows[id + 1U]; i++) {
+            const metagraph_task_id_t successor = run->successors[i];
+            if (!succeeded) {
+                atomic_store_explicit(&run->blocked[successor], true,
+                                      memory_order_relaxed);
+            }
+            if (atomic_fetch_sub_explicit(&run->pending[successor], 1U,
+                                          memory_order_acq_rel) == 1U) {
+                if (!next) {
+                    next = &run->nodes[successor];
+                } else {
+                    metagraph_scheduler_spawn(run->scheduler,
+                                              &run->nodes[successor].task);
+                }
+            }
+        }
+        // With next still to run the latch cannot open, so run stays valid.
+        metagraph_scheduler_arrive(run->scheduler, &run->done);
+        node = next;
+    }
+}
+
+// Successor lists in CSR form, plus each task's prerequisite count.
+static metagraph_result_t
+metagraph_task_graph_link(const metagraph_task_graph_t *graph,
+                          metagraph_task_run_t *run, uint32_t *in_degree) {
+    const size_t count = graph->task_count;
+    memset(run->successor_rows, 0, (count + 1U) * sizeof(size_t));
+    memset(in_degree, 0, count * sizeof(*in_degree));
+    for (size_t i = 0; i < graph->edge_count; i++) {
+        run->successor_rows[graph->edges[i].prerequisite + 1U]++;
+        in_degree[graph->edges[i].task]++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        run->successor_rows[i + 1U] += run->successor_rows[i];
+    }
+    size_t *fill = malloc((count + 1U) * sizeof(*fill));
+    METAGRAPH_CHECK_ALLOC(fill);
+    memcpy(fill, run->successor_rows, (count + 1U) * sizeof(*fill));
+    for (size_t i = 0; i < graph->edge_count; i++) {
+        run->successors[fill[graph->edges[i].prerequisite]++] =
+            graph->edges[i].task;
+    }
+    free(fill);
+    return METAGRAPH_OK();
+}
+
+// Kahn's algorithm on a copy of the prerequisite counts; consumes
+// remaining and uses queue as scratch.
+static metagraph_result_t
+metagraph_task_graph_check_acyclic(const metagraph_task_run_t *run,
+                                   size_t count, uint32_t *remaining,
+                                   metagraph_task_id_t *queue) {
+    size_t tail = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (remaining[i] == 0) {
+            queue[tail++] = (metagraph_task_id_t)i;
+        }
+    }
+    for (size_t head = 0; head < tail; head++) {
+        const metagraph_task_id_t id = queue[head];
+        for (size_t i = run->successor_rows[id];
+             i < run->successor_rows[id + 1U]; i++) {
+            if (--remaining[run->successors[i]] == 0) {
+                queue[tail++] = run->successors[i];
+            }
+        }
+    }
+    if (tail != count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_DEPENDENCY_CYCLE,
+                             "Task graph has a cycle; %zu of %zu tasks "
+                             "cannot be ordered",
+                             count - tail, count);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_task_graph_run(const metagraph_task_graph_t *graph,
+                         metagraph_scheduler_t *scheduler,
+                         metagraph_task_graph_stats_t *out_stats) {
+    METAGRAPH_CHECK_NULL(graph);
+    if (out_stats) {
+        memset(out_stats, 0, sizeof(*out_stats));
+    }
+    const size_t count = graph->task_count;
+    if (count == 0) {
+        return METAGRAPH_OK();
+    }
+    if (!scheduler) {
+        scheduler = metagraph_scheduler_default();
+    }
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_task_run_t run = {.scheduler = scheduler, .graph = graph};
+    uint32_t *in_degree = malloc(count * sizeof(*in_degree));
+    metagraph_task_id_t *queue = malloc(count * sizeof(*queue));
+    run.nodes = malloc(count * sizeof(*run.nodes));
+    run.pending = malloc(count * sizeof(*run.pending));
+    run.blocked = malloc(count * sizeof(*run.blocked));
+    run.successor_rows = malloc((count + 1U) * sizeof(*run.successor_rows));
+    run.successors = malloc((graph->edge_count ? graph->edge_count : 1U) *
+                            sizeof(*run.successors));
+    if (!in_degree || !queue || !run.nodes || !run.pending || !run.blocked ||
+        !run.successor_rows || !run.successors) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Failed to allocate task graph run state");
+        goto done;
+    }
+    METAGRAPH_CHECK_GOTO(metagraph_task_graph_link(graph, &run, in_degree),
+                         done);
+    for (size_t i = 0; i < count; i++) {
+        atomic_init(&run.pending[i], in_degree[i]);
+        atomic_init(&run.blocked[i], false);
+        run.nodes[i] = (metagraph_task_node_t){
+            .task = {.run = metagraph_task_node_run},
+            .run = &run,
+            .id = (metagraph_task_id_t)i,
+        };
+    }
+    METAGRAPH_CHECK_GOTO(
+        metagraph_task_graph_check_acyclic(&run, count, in_degree, queue),
+        done);
+
+    atomic_init(&run.completed, 0);
+    atomic_init(&run.failed, 0);
+    atomic_init(&run.skipped, 0);
+    atomic_flag_clear(&run.errored);
+    atomic_init(&run.done.pending, count);
+    // Collect the roots first: once one runs, it can make other tasks
+    // ready and spawn them itself.
+    size_t roots = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (atomic_load_explicit(&run.pending[i], memory_order_relaxed) == 0) {
+            queue[roots++] = (metagraph_task_id_t)i;
+        }
+    }
+    for (size_t i = 0; i < roots; i++) {
+        metagraph_scheduler_spawn(scheduler, &run.nodes[queue[i]].task);
+    }
+    metagraph_scheduler_wait(scheduler, &run.done);
+
+    if (out_stats) {
+        out_stats->completed = atomic_load(&run.completed);
+        out_stats->failed = atomic_load(&run.failed);
+        out_stats->skipped = atomic_load(&run.skipped);
+    }
+    if (run.error.code != METAGRAPH_SUCCESS) {
+        result = METAGRAPH_ERR(run.error.code, "%s", run.error.message);
+    }
+
+done:
+    free(run.successors);
+    free(run.successor_rows);
+    free(run.blocked);
+    free(run.pending);
+    free(run.nodes);
+    free(queue);
+    free(in_degree);
+    return result;
+}
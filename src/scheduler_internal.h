@@ -0,0 +1,72 @@
+/**
+ * @file scheduler_internal.h
+ * @brief Fork-join primitives on top of the shared scheduler
+ *
+ * Library code forks work as intrusive tasks: the caller embeds a
+ * metagraph_task_t in its own job struct, spawns it, and waits on a latch
+ * the task counts down when it is done. Nothing is allocated per task.
+ * Waiting runs other queued tasks, so a task may itself fork and wait
+ * without tying up a thread.
+ *
+ * Every function accepts a NULL scheduler and then runs tasks on the
+ * calling thread at spawn time, which is how callers degrade when the
+ * shared scheduler could not be started.
+ */
+
+#ifndef SRC_SCHEDULER_INTERNAL_H
+#define SRC_SCHEDULER_INTERNAL_H
+
+#include "metagraph/scheduler.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+typedef struct metagraph_task metagraph_task_t;
+
+/**
+ * @brief A unit of work; embed it in the job it belongs to
+ *
+ * run receives the task pointer back and recovers its job from it. The
+ * task must stay valid until it has finished running.
+ */
+struct metagraph_task {
+    void (*run)(metagraph_task_t *task);
+};
+
+/**
+ * @brief Countdown a waiter blocks on until every forked task has arrived
+ *
+ * A task must not touch its job after arriving: the waiter may already
+ * have returned and released it.
+ */
+typedef struct {
+    _Atomic(size_t) pending;
+} metagraph_latch_t;
+
+/**
+ * @brief The shared scheduler, or NULL if its threads could not start
+ */
+metagraph_scheduler_t *metagraph_scheduler_default(void);
+
+/**
+ * @brief Queue a task; runs it right away when scheduler is NULL
+ *
+ * Tasks spawned from a worker thread go to that worker's own queue and
+ * are the first it runs next.
+ */
+void metagraph_scheduler_spawn(metagraph_scheduler_t *scheduler,
+                               metagraph_task_t *task);
+
+/**
+ * @brief Count down a latch, waking its waiter on the last arrival
+ */
+void metagraph_scheduler_arrive(metagraph_scheduler_t *scheduler,
+                                metagraph_latch_t *latch);
+
+/**
+ * @brief Run queued tasks until the latch reaches zero
+ */
+void metagraph_scheduler_wait(metagraph_scheduler_t *scheduler,
+                              metagraph_latch_t *latch);
+
+#endif // SRC_SCHEDULER_INTERNAL_H
@@ -0,0 +1,246 @@
+/**
+ * @file trace.c
+ * @brief Span recorder and Chrome trace export
+ *
+ * Spans are claimed from a fixed array with one atomic increment, so
+ * recording threads never wait on each other; once the array is full,
+ * later spans are only counted. A span is written in full before its
+ * ready flag is published, and the exporter skips slots that are not
+ * ready yet.
+ *
+ * Stopping has to know that no thread is still writing into the array
+ * before it can be freed. Recorders announce themselves in a writer count
+ * before checking that recording is still on, and stop clears the flag
+ * before waiting for the count to drain; with sequentially consistent
+ * atomics on both sides, every recorder either sees the flag cleared or
+ * is seen by stop.
+ */
+
+#include "metagraph/trace.h"
+#include "metagraph/result.h"
+
+#include "platform.h"
+#include "trace_internal.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef METAGRAPH_TRACING
+
+typedef struct {
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+    uint64_t arg;
+    uint32_t thread;
+    _Atomic(bool) ready;
+} metagraph_trace_record_t;
+
+static struct {
+    _Atomic(bool) recording;
+    _Atomic(uint32_t) writers;
+    _Atomic(size_t) next;
+    _Atomic(size_t) dropped;
+    size_t capacity;
+    uint64_t origin;
+    metagraph_trace_record_t *records;
+} metagraph_trace_state;
+
+// Track numbers for the exported trace, in order of first span.
+static _Atomic(uint32_t) metagraph_trace_next_thread = 1;
+static METAGRAPH_THREAD_LOCAL uint32_t metagraph_trace_thread;
+
+void metagraph_trace_span_begin(metagraph_span_t *span, const char *name,
+                                uint64_t arg) {
+    span->name = name;
+    span->arg = arg;
+    span->begin = atomic_load_explicit(&metagraph_trace_state.recording,
+                                       memory_order_relaxed)
+                      ? metagraph_monotonic_ns()
+                      : 0;
+}
+
+void metagraph_trace_span_end(const metagraph_span_t *span) {
+    if (!span->begin) {
+        return;
+    }
+    const uint64_t end = metagraph_monotonic_ns();
+    atomic_fetch_add(&metagraph_trace_state.writers, 1U);
+    if (atomic_load(&metagraph_trace_state.recording)) {
+        const size_t slot = atomic_fetch_add_explicit(
+            &metagraph_trace_state.next, 1U, memory_order_relaxed);
+        if (slot < metagraph_trace_state.capacity) {
+            if (!metagraph_trace_thread) {
+                metagraph_trace_thread = atomic_fetch_add_explicit(
+                    &metagraph_trace_next_thread, 1U, memory_order_relaxed);
+            }
+            metagraph_trace_record_t *record =
+                &metagraph_trace_state.records[slot];
+            record->name = span->name;
+            record->begin = span->begin;
+            record->end = end;
+            record->arg = span->arg;
+            record->thread = metagraph_trace_thread;
+            atomic_store_explicit(&record->ready, true, memory_order_release);
+        } else {
+            atomic_fetch_add_explicit(&metagraph_trace_state.dropped, 1U,
+                                      memory_order_relaxed);
+        }
+    }
+    atomic_fetch_sub(&metagraph_trace_state.writers, 1U);
+}
+
+bool metagraph_trace_available(void) { return true; }
+
+metagraph_result_t metagraph_trace_stop(void) {
+    atomic_store(&metagraph_trace_state.recording, false);
+    uint32_t spins = 0;
+    while (atomic_load(&metagraph_trace_state.writers) != 0) {
+        metagraph_backoff(&spins);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_trace_discard(void) {
+    METAGRAPH_CHECK(metagraph_trace_stop());
+    free(metagraph_trace_state.records);
+    metagraph_trace_state.records = NULL;
+    metagraph_trace_state.capacity = 0;
+    atomic_store_explicit(&metagraph_trace_state.next, 0, memory_order_relaxed);
+    atomic_store_explicit(&metagraph_trace_state.dropped, 0,
+                          memory_order_relaxed);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_trace_start(size_t capacity) {
+    if (capacity == 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                             "Span buffer needs a capacity");
+    }
+    METAGRAPH_CHECK(metagraph_trace_discard());
+    metagraph_trace_record_t *records = calloc(capacity, sizeof(*records));
+    if (!records) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate %zu trace spans", capacity);
+    }
+    metagraph_trace_state.records = records;
+    metagraph_trace_state.capacity = capacity;
+    metagraph_trace_state.origin = metagraph_monotonic_ns();
+    atomic_store(&metagraph_trace_state.recording, true);
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_trace_get_stats(metagraph_trace_stats_t *out_stats) {
+    METAGRAPH_CHECK_NULL(out_stats);
+    const size_t claimed =
+        atomic_load_explicit(&metagraph_trace_state.next, memory_order_relaxed);
+    const size_t capacity = metagraph_trace_state.capacity;
+    *out_stats = (metagraph_trace_stats_t){
+        .capacity = capacity,
+        .recorded = claimed < capacity ? claimed : capacity,
+        .dropped = atomic_load_explicit(&metagraph_trace_state.dropped,
+                                        memory_order_relaxed),
+        .recording = atomic_load(&metagraph_trace_state.recording),
+    };
+    return METAGRAPH_OK();
+}
+
+// Microseconds with nanosecond precision, as Chrome expects
+static int metagraph_trace_print_us(FILE *file, const char *key,
+                                    uint64_t ns) {
+    return fprintf(file, "\"%s\":%llu.%03u", key,
+                   (unsigned long long)(ns / 1000U), (unsigned)(ns % 1000U));
+}
+
+metagraph_result_t metagraph_trace_write_chrome(const char *path) {
+    METAGRAPH_CHECK_NULL(path);
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        const int error = errno;
+        return METAGRAPH_ERR(error == EACCES
+                                 ? METAGRAPH_ERROR_FILE_ACCESS_DENIED
+                                 : METAGRAPH_ERROR_IO_FAILURE,
+                             "Cannot create %s (errno %d)", path, error);
+    }
+
+    const size_t claimed =
+        atomic_load_explicit(&metagraph_trace_state.next, memory_order_relaxed);
+    const size_t count = claimed < metagraph_trace_state.capacity
+                             ? claimed
+                             : metagraph_trace_state.capacity;
+    const uint64_t origin = metagraph_trace_state.origin;
+    (void)fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+    bool first = true;
+    for (size_t i = 0; i < count; i++) {
+        const metagraph_trace_record_t *record =
+            &metagraph_trace_state.records[i];
+        if (!atomic_load_explicit(&record->ready, memory_order_acquire)) {
+            continue;
+        }
+        // Spans begun before a restart are clipped to its start.
+        const uint64_t begin = record->begin > origin ? record->begin : origin;
+        const uint64_t end = record->end > begin ? record->end : begin;
+        (void)fprintf(file,
+                      "%s\n{\"name\":\"%s\",\"cat\":\"metagraph\","
+                      "\"ph\":\"X\",\"pid\":1,\"tid\":%u,",
+                      first ? "" : ",", record->name, record->thread);
+        (void)metagraph_trace_print_us(file, "ts", begin - origin);
+        (void)fputc(',', file);
+        (void)metagraph_trace_print_us(file, "dur", end - begin);
+        (void)fprintf(file, ",\"args\":{\"arg\":%llu}}",
+                      (unsigned long long)record->arg);
+        first = false;
+    }
+    (void)fprintf(file, "\n],\"otherData\":{\"dropped_spans\":%zu}}\n",
+                  atomic_load_explicit(&metagraph_trace_state.dropped,
+                                       memory_order_relaxed));
+
+    const bool failed = ferror(file) != 0;
+    if (fclose(file) != 0 || failed) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Writing trace %s failed (errno %d)", path, errno);
+    }
+    return METAGRAPH_OK();
+}
+
+#else
+
+bool metagraph_trace_available(void) { return false; }
+
+metagraph_result_t metagraph_trace_start(size_t capacity) {
+    return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                         "Built without METAGRAPH_TRACING; cannot record "
+                         "%zu spans",
+                         capacity);
+}
+
+metagraph_result_t metagraph_trace_stop(void) {
+    return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                         "Built without METAGRAPH_TRACING");
+}
+
+metagraph_result_t metagraph_trace_write_chrome(const char *path) {
+    return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                         "Built without METAGRAPH_TRACING; %s not written",
+                         path ? path : "(null)");
+}
+
+metagraph_result_t
+metagraph_trace_get_stats(metagraph_trace_stats_t *out_stats) {
+    (void)out_stats;
+    return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                         "Built without METAGRAPH_TRACING");
+}
+
+metagraph_result_t metagraph_trace_discard(void) {
+    return METAGRAPH_ERR(METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE,
+                         "Built without METAGRAPH_TRACING");
+}
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file trace_internal.h
+ * @brief USDT probe and span recorder hooks
+ *
+ * Both kinds of hook are compile-time optional. USDT probes need the
+ * METAGRAPH_USDT build option and <sys/sdt.h> (systemtap-sdt-dev); each
+ * probe is then a single nop in the instruction stream until a tracer
+ * such as bpftrace attaches to it. Spans need the METAGRAPH_TRACING build
+ * option; without it METAGRAPH_SPAN_BEGIN and METAGRAPH_SPAN_END expand to
+ * nothing, and with it they cost one atomic load while no recording runs.
+ * Probe arguments are still evaluated when probes are compiled out, so
+ * keep them free of side effects.
+ */
+
+#ifndef SRC_TRACE_INTERNAL_H
+#define SRC_TRACE_INTERNAL_H
+
+#include <stdint.h>
+
+#if defined(METAGRAPH_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define METAGRAPH_HAVE_USDT
+#endif
+#endif
+
+#ifdef METAGRAPH_HAVE_USDT
+#define METAGRAPH_PROBE1(name, a) DTRACE_PROBE1(metagraph, name, a)
+#define METAGRAPH_PROBE2(name, a, b) DTRACE_PROBE2(metagraph, name, a, b)
+#define METAGRAPH_PROBE3(name, a, b, c) DTRACE_PROBE3(metagraph, name, a, b, c)
+#define METAGRAPH_PROBE4(name, a, b, c, d)                                     \
+    DTRACE_PROBE4(metagraph, name, a, b, c, d)
+#else
+#define METAGRAPH_PROBE1(name, a) ((void)(a))
+#define METAGRAPH_PROBE2(name, a, b) ((void)(a), (void)(b))
+#define METAGRAPH_PROBE3(name, a, b, c) ((void)(a), (void)(b), (void)(c))
+#define METAGRAPH_PROBE4(name, a, b, c, d)                                     \
+    ((void)(a), (void)(b), (void)(c), (void)(d))
+#endif
+
+#ifdef METAGRAPH_TRACING
+
+typedef struct {
+    const char *name; ///< Static string
+    uint64_t begin;   ///< 0 when no recording was running at the start
+    uint64_t arg;
+} metagraph_span_t;
+
+void metagraph_trace_span_begin(metagraph_span_t *span, const char *name,
+                                uint64_t arg);
+void metagraph_trace_span_end(const metagraph_span_t *span);
+
+#define METAGRAPH_SPAN_BEGIN(span, name, arg)                                  \
+    metagraph_span_t span;                                                     \
+    metagraph_trace_span_begin(&span, (name), (uint64_t)(arg))
+#define METAGRAPH_SPAN_END(span) metagraph_trace_span_end(&span)
+
+#else
+
+#define METAGRAPH_SPAN_BEGIN(span, name, arg)
+#define METAGRAPH_SPAN_END(span)
+
+#endif
+
+#endif // SRC_TRACE_INTERNAL_H
@@ -0,0 +1,1033 @@
+/**
+ * @file traversal.c
+ * @brief DFS, parallel direction-optimizing BFS and parallel Kahn ordering
+ *
+ * BFS keeps an atomic depth per node; a node is claimed by the first
+ * compare-and-swap from "unvisited" to its depth, which also fixes its
+ * parent. Each level runs as one work-pool pass, either top-down over the
+ * frontier queue or bottom-up over every node, with the frontier first
+ * turned into a bitmap. The direction switch follows Beamer et al.: go
+ * bottom-up once the frontier's outgoing incidences exceed 1/ALPHA of the
+ * unexplored ones, and back to top-down once the frontier has shrunk below
+ * 1/BETA of the nodes.
+ *
+ * Workers gather newly reached nodes in a private buffer and append it to
+ * the shared next-level array with one fetch-add per buffer.
+ */
+
+#include "metagraph/traversal.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include "graph_internal.h"
+#include "metrics_internal.h"
+#include "platform.h"
+#include "trace_internal.h"
+#include "work_pool.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METAGRAPH_TRAVERSAL_DEFAULT_UNIT 1024U
+#define METAGRAPH_TRAVERSAL_BUFFER 256U
+#define METAGRAPH_TRAVERSAL_CACHE_LINE 64U
+#define METAGRAPH_BFS_UNVISITED UINT32_MAX
+#define METAGRAPH_BFS_ALPHA 14U
+#define METAGRAPH_BFS_BETA 24U
+#define METAGRAPH_CYCLE_MESSAGE_SIZE 192U
+
+// Per-worker staging buffer for newly reached nodes.
+typedef struct {
+    _Alignas(METAGRAPH_TRAVERSAL_CACHE_LINE) uint32_t count;
+    uint64_t weight; ///< Sum of out-degrees of the buffered nodes (BFS)
+    metagraph_node_index_t nodes[METAGRAPH_TRAVERSAL_BUFFER];
+} metagraph_traversal_buffer_t;
+
+// Number of (edge, target) incidences a node depends on.
+static uint32_t metagraph_traversal_out_degree(const metagraph_graph_t *graph,
+                                               metagraph_node_index_t node) {
+    uint32_t degree = 0;
+    for (uint32_t record = graph->node_out_head[node];
+         record != METAGRAPH_INVALID_INDEX;
+         record = graph->incidence_next[record]) {
+        degree += graph->edge_member_count[graph->incidence_edge[record]] - 1U;
+    }
+    return degree;
+}
+
+static metagraph_result_t
+metagraph_traversal_team(const metagraph_parallel_config_t *parallel,
+                         size_t items, size_t *out_unit,
+                         metagraph_work_pool_t **out_pool) {
+    const size_t unit = (parallel && parallel->work_unit_size)
+                            ? parallel->work_unit_size
+                            : METAGRAPH_TRAVERSAL_DEFAULT_UNIT;
+    uint32_t threads = (parallel && parallel->thread_count)
+                           ? parallel->thread_count
+                           : metagraph_cpu_count();
+    const size_t units = items / unit;
+    if (threads > units) {
+        threads = units ? (uint32_t)units : 1U;
+    }
+    *out_unit = unit;
+    return metagraph_work_pool_create(threads, out_pool);
+}
+
+static metagraph_traversal_buffer_t *
+metagraph_traversal_buffers(const metagraph_work_pool_t *pool) {
+    const size_t bytes =
+        metagraph_work_pool_size(pool) * sizeof(metagraph_traversal_buffer_t);
+    metagraph_traversal_buffer_t *buffers =
+        metagraph_aligned_alloc(METAGRAPH_TRAVERSAL_CACHE_LINE, bytes);
+    if (buffers) {
+        memset(buffers, 0, bytes);
+    }
+    return buffers;
+}
+
+// Append a worker's buffered nodes to dest at an atomically reserved slot.
+static void metagraph_traversal_flush(metagraph_traversal_buffer_t *buffer,
+                                      metagraph_node_index_t *dest,
+                                      _Atomic(size_t) *dest_count) {
+    if (buffer->count == 0) {
+        return;
+    }
+    const size_t at = atomic_fetch_add_explicit(dest_count, buffer->count,
+                                                memory_order_relaxed);
+    memcpy(dest + at, buffer->nodes, buffer->count * sizeof(buffer->nodes[0]));
+    buffer->count = 0;
+}
+
+// ============================================================================
+// Depth-first search
+// ============================================================================
+
+typedef struct {
+    metagraph_node_index_t node;
+    uint32_t record; ///< Next outgoing incidence record to examine
+    uint32_t member; ///< Next member of the current edge
+    uint32_t depth;
+} metagraph_walk_frame_t;
+
+// Sequential traversal state: a DFS stack of frames, or a BFS queue of
+// them with frames [0, head) already expanded. Everything needed to carry
+// on is in here, which is what lets cursors pause between any two steps.
+typedef struct {
+    const metagraph_traversal_context_t *context;
+    metagraph_dfs_mode_t mode; ///< PREORDER for BFS
+    metagraph_node_visitor_t node_visitor;
+    metagraph_edge_visitor_t edge_visitor;
+    uint64_t *visited;
+    metagraph_walk_frame_t *frames;
+    size_t count;
+    size_t capacity;
+    size_t head;
+    uint64_t reached;
+    uint64_t examined; ///< Edge targets looked at
+    bool stopped;      ///< TERMINATE or an error
+} metagraph_walk_t;
+
+// How far one run of a walk may go; counters are compared against the
+// walk's running totals. The clock is read every few examined targets.
+typedef struct {
+    uint64_t node_limit;
+    uint64_t edge_limit;
+    uint64_t deadline; ///< metagraph_monotonic_ns() value (0 = none)
+    uint32_t until_clock;
+} metagraph_walk_allowance_t;
+
+#define METAGRAPH_WALK_CLOCK_INTERVAL 16U
+
+static const metagraph_walk_allowance_t metagraph_walk_unlimited = {
+    .node_limit = UINT64_MAX,
+    .edge_limit = UINT64_MAX,
+};
+
+static bool metagraph_walk_may_examine(const metagraph_walk_t *walk,
+                                       metagraph_walk_allowance_t *allowance) {
+    if (walk->examined >= allowance->edge_limit) {
+        return false;
+    }
+    if (allowance->deadline == 0 || --allowance->until_clock != 0) {
+        return true;
+    }
+    allowance->until_clock = METAGRAPH_WALK_CLOCK_INTERVAL;
+    return metagraph_monotonic_ns() < allowance->deadline;
+}
+
+// Reach a node: mark it, run the preorder visit and push its frame.
+// Sets stopped on TERMINATE or when the frames cannot grow.
+static void metagraph_walk_reach(metagraph_walk_t *walk,
+                                 metagraph_node_index_t node, uint32_t depth,
+                                 metagraph_result_t *result) {
+    const metagraph_graph_t *graph = walk->context->graph;
+    walk->visited[node >> 6U] |= 1ULL << (node & 63U);
+    walk->reached++;
+    if (walk->node_visitor && walk->mode != METAGRAPH_DFS_POSTORDER) {
+        const metagraph_visit_result_t visit =
+            walk->node_visitor(graph, node, depth, walk->context->user_data);
+        if (visit == METAGRAPH_VISIT_TERMINATE) {
+            walk->stopped = true;
+            return;
+        }
+        if (visit == METAGRAPH_VISIT_SKIP) {
+            return;
+        }
+    }
+    if (walk->count == walk->capacity) {
+        const size_t capacity = walk->capacity ? walk->capacity * 2U : 64U;
+        metagraph_walk_frame_t *frames =
+            realloc(walk->frames, capacity * sizeof(*frames));
+        if (!frames) {
+            *result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                    "Failed to grow traversal to %zu frames",
+                                    capacity);
+            walk->stopped = true;
+            return;
+        }
+        walk->frames = frames;
+        walk->capacity = capacity;
+    }
+    walk->frames[walk->count++] = (metagraph_walk_frame_t){
+        .node = node,
+        .record = graph->node_out_head[node],
+        .member = 1,
+        .depth = depth,
+    };
+}
+
+// Look at frame's next edge target and reach it if it is new. Returns
+// false, with nothing consumed, when the allowance does not cover it.
+static bool metagraph_walk_follow(metagraph_walk_t *walk, size_t index,
+                                  metagraph_walk_allowance_t *allowance,
+                                  bool *out_reached,
+                                  metagraph_result_t *result) {
+    const metagraph_graph_t *graph = walk->context->graph;
+    metagraph_walk_frame_t *frame = &walk->frames[index];
+    *out_reached = false;
+    const metagraph_edge_index_t edge = graph->incidence_edge[frame->record];
+    if (frame->member >= graph->edge_member_count[edge]) {
+        frame->record = graph->incidence_next[frame->record];
+        frame->member = 1;
+        return true;
+    }
+    if (!metagraph_walk_may_examine(walk, allowance)) {
+        return false;
+    }
+    const metagraph_node_index_t target =
+        graph->members[graph->edge_member_begin[edge] + frame->member];
+    const bool visited =
+        (walk->visited[target >> 6U] & (1ULL << (target & 63U))) != 0;
+    if (!visited && walk->reached >= allowance->node_limit) {
+        return false;
+    }
+    frame->member++;
+    walk->examined++;
+    if (visited) {
+        return true;
+    }
+    if (walk->edge_visitor) {
+        const metagraph_visit_result_t visit =
+            walk->edge_visitor(graph, edge, frame->node, target, frame->depth,
+                               walk->context->user_data);
+        if (visit == METAGRAPH_VISIT_TERMINATE) {
+            walk->stopped = true;
+            return true;
+        }
+        if (visit == METAGRAPH_VISIT_SKIP) {
+            return true;
+        }
+    }
+    // May reallocate the frames; frame is not used afterwards.
+    metagraph_walk_reach(walk, target, frame->depth + 1U, result);
+    *out_reached = true;
+    return true;
+}
+
+static bool metagraph_walk_expands(const metagraph_walk_t *walk,
+                                   const metagraph_walk_frame_t *frame) {
+    return (walk->context->max_depth == 0 ||
+            frame->depth < walk->context->max_depth) &&
+           frame->record != METAGRAPH_INVALID_INDEX;
+}
+
+// Depth-first until the stack empties, the walk stops, or the allowance
+// runs out. Returns false only when paused with work left.
+static bool metagraph_walk_dfs(metagraph_walk_t *walk,
+                               metagraph_walk_allowance_t *allowance,
+                               metagraph_result_t *result) {
+    while (!walk->stopped && walk->count > 0) {
+        const size_t top = walk->count - 1U;
+        bool descended = false;
+        while (!walk->stopped && !descended &&
+               metagraph_walk_expands(walk, &walk->frames[top])) {
+            if (!metagraph_walk_follow(walk, top, allowance, &descended,
+                                       result)) {
+                return false;
+            }
+        }
+        if (walk->stopped || descended) {
+            continue;
+        }
+        const metagraph_walk_frame_t done = walk->frames[--walk->count];
+        if (walk->node_visitor && walk->mode != METAGRAPH_DFS_PREORDER &&
+            walk->node_visitor(walk->context->graph, done.node, done.depth,
+                               walk->context->user_data) ==
+                METAGRAPH_VISIT_TERMINATE) {
+            walk->stopped = true;
+        }
+    }
+    return true;
+}
+
+// Breadth-first counterpart: expand queued frames in order.
+static bool metagraph_walk_bfs(metagraph_walk_t *walk,
+                               metagraph_walk_allowance_t *allowance,
+                               metagraph_result_t *result) {
+    while (!walk->stopped && walk->head < walk->count) {
+        bool reached = false;
+        if (!metagraph_walk_expands(walk, &walk->frames[walk->head])) {
+            walk->head++;
+        } else if (!metagraph_walk_follow(walk, walk->head, allowance,
+                                          &reached, result)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+metagraph_result_t
+metagraph_traverse_dfs(const metagraph_traversal_context_t *context,
+                       metagraph_node_index_t start, metagraph_dfs_mode_t mode,
+                       metagraph_node_visitor_t node_visitor,
+                       metagraph_edge_visitor_t edge_visitor) {
+    METAGRAPH_CHECK_NULL(context);
+    METAGRAPH_CHECK_NULL(context->graph);
+    const metagraph_graph_t *graph = context->graph;
+    if (start >= graph->node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Start node %u out of range", start);
+    }
+    METAGRAPH_PROBE2(traverse__start, 0, start);
+    METAGRAPH_SPAN_BEGIN(span, "traverse_dfs", start);
+    const uint64_t started = metagraph_monotonic_ns();
+    metagraph_walk_t dfs = {
+        .context = context,
+        .mode = mode,
+        .node_visitor = node_visitor,
+        .edge_visitor = edge_visitor,
+        .visited = calloc((graph->node_count + 63U) / 64U, sizeof(uint64_t)),
+    };
+    METAGRAPH_CHECK_ALLOC(dfs.visited);
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_walk_allowance_t allowance = metagraph_walk_unlimited;
+    metagraph_walk_reach(&dfs, start, 0, &result);
+    (void)metagraph_walk_dfs(&dfs, &allowance, &result);
+    free(dfs.frames);
+    free(dfs.visited);
+    metagraph_metrics_add(METAGRAPH_COUNTER_TRAVERSAL_STEPS, dfs.reached);
+    metagraph_metrics_record(METAGRAPH_HISTOGRAM_TRAVERSAL,
+                             metagraph_monotonic_ns() - started);
+    METAGRAPH_SPAN_END(span);
+    METAGRAPH_PROBE3(traverse__done, 0, dfs.reached, (int)result);
+    return result;
+}
+
+// ============================================================================
+// Resumable traversals
+// ============================================================================
+
+struct metagraph_traversal_cursor {
+    metagraph_traversal_context_t context; ///< The walk points here
+    metagraph_cursor_order_t order;
+    metagraph_node_index_t start;
+    bool started;
+    metagraph_walk_t walk;
+};
+
+metagraph_result_t metagraph_traversal_cursor_create(
+    const metagraph_traversal_context_t *context,
+    const metagraph_cursor_config_t *config,
+    metagraph_traversal_cursor_t **out_cursor) {
+    METAGRAPH_CHECK_NULL(context);
+    METAGRAPH_CHECK_NULL(context->graph);
+    METAGRAPH_CHECK_NULL(config);
+    METAGRAPH_CHECK_NULL(out_cursor);
+    *out_cursor = NULL;
+    const metagraph_graph_t *graph = context->graph;
+    if (config->start >= graph->node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Start node %u out of range", config->start);
+    }
+    if (config->order != METAGRAPH_CURSOR_DFS &&
+        config->order != METAGRAPH_CURSOR_BFS) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Unknown cursor order %d", (int)config->order);
+    }
+    metagraph_traversal_cursor_t *cursor = calloc(1, sizeof(*cursor));
+    METAGRAPH_CHECK_ALLOC(cursor);
+    cursor->context = *context;
+    cursor->order = config->order;
+    cursor->start = config->start;
+    cursor->walk = (metagraph_walk_t){
+        .context = &cursor->context,
+        .mode = config->order == METAGRAPH_CURSOR_DFS ? config->dfs_mode
+                                                      : METAGRAPH_DFS_PREORDER,
+        .node_visitor = config->node_visitor,
+        .edge_visitor = config->edge_visitor,
+        .visited = calloc((graph->node_count + 63U) / 64U, sizeof(uint64_t)),
+    };
+    if (!cursor->walk.visited) {
+        free(cursor);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate traversal cursor for %zu "
+                             "nodes",
+                             graph->node_count);
+    }
+    *out_cursor = cursor;
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_traversal_cursor_step(metagraph_traversal_cursor_t *cursor,
+                                const metagraph_traversal_budget_t *budget,
+                                metagraph_cursor_progress_t *out_progress) {
+    METAGRAPH_CHECK_NULL(cursor);
+    metagraph_walk_t *walk = &cursor->walk;
+    const uint64_t reached = walk->reached;
+    metagraph_walk_allowance_t allowance = metagraph_walk_unlimited;
+    if (budget && budget->max_nodes) {
+        allowance.node_limit = reached + budget->max_nodes;
+    }
+    if (budget && budget->max_edges) {
+        allowance.edge_limit = walk->examined + budget->max_edges;
+    }
+    if (budget && budget->max_ns) {
+        allowance.deadline = metagraph_monotonic_ns() + budget->max_ns;
+        allowance.until_clock = METAGRAPH_WALK_CLOCK_INTERVAL;
+    }
+
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    if (!cursor->started) {
+        cursor->started = true;
+        metagraph_walk_reach(walk, cursor->start, 0, &result);
+    }
+    const bool finished = cursor->order == METAGRAPH_CURSOR_DFS
+                              ? metagraph_walk_dfs(walk, &allowance, &result)
+                              : metagraph_walk_bfs(walk, &allowance, &result);
+    metagraph_metrics_add(METAGRAPH_COUNTER_TRAVERSAL_STEPS,
+                          walk->reached - reached);
+    if (finished && walk->frames) {
+        // Done for good: give the frames back now rather than at destroy.
+        free(walk->frames);
+        walk->frames = NULL;
+        walk->count = 0;
+        walk->capacity = 0;
+        walk->head = 0;
+    }
+    if (out_progress) {
+        *out_progress = (metagraph_cursor_progress_t){
+            .nodes_reached = walk->reached,
+            .edges_examined = walk->examined,
+            .finished = finished,
+        };
+    }
+    if (metagraph_result_is_error(result) || finished) {
+        return result;
+    }
+    return METAGRAPH_ERR(METAGRAPH_ERROR_TRAVERSAL_LIMIT_EXCEEDED,
+                         "Traversal paused after %llu nodes",
+                         (unsigned long long)walk->reached);
+}
+
+metagraph_result_t
+metagraph_traversal_cursor_destroy(metagraph_traversal_cursor_t *cursor) {
+    if (!cursor) {
+        return METAGRAPH_OK();
+    }
+    free(cursor->walk.frames);
+    free(cursor->walk.visited);
+    free(cursor);
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Breadth-first search
+// ============================================================================
+
+typedef struct {
+    const metagraph_graph_t *graph;
+    void *user_data;
+    metagraph_node_visitor_t node_visitor;
+    metagraph_edge_visitor_t edge_visitor;
+
+    uint32_t *out_degree;
+    _Atomic(uint32_t) *depth;
+    metagraph_node_index_t *parent;
+    metagraph_edge_index_t *parent_edge;
+    _Atomic(uint64_t) *frontier_bits;
+    metagraph_bfs_node_info_t *out_info;
+
+    const metagraph_node_index_t *current;
+    metagraph_node_index_t *next;
+    _Atomic(size_t) next_count;
+    _Atomic(uint64_t) next_weight;
+    _Atomic(uint64_t) total_weight;
+    _Atomic(size_t) active;
+    atomic_bool stop;
+
+    uint32_t level;
+    bool expand;
+    metagraph_traversal_buffer_t *buffers;
+} metagraph_bfs_t;
+
+static bool metagraph_bfs_stopped(const metagraph_bfs_t *bfs) {
+    return atomic_load_explicit(&bfs->stop, memory_order_relaxed);
+}
+
+// Run the node visitor; true when the node's edges should be expanded.
+static bool metagraph_bfs_visit(metagraph_bfs_t *bfs,
+                                metagraph_node_index_t node) {
+    if (metagraph_bfs_stopped(bfs)) {
+        return false;
+    }
+    if (bfs->node_visitor) {
+        switch (bfs->node_visitor(bfs->graph, node, bfs->level,
+                                  bfs->user_data)) {
+        case METAGRAPH_VISIT_CONTINUE:
+            break;
+        case METAGRAPH_VISIT_SKIP:
+            return false;
+        case METAGRAPH_VISIT_TERMINATE:
+            atomic_store_explicit(&bfs->stop, true, memory_order_relaxed);
+            return false;
+        default:
+            break;
+        }
+    }
+    return bfs->expand;
+}
+
+// Run the edge visitor; true when the edge may discover `to`.
+static bool metagraph_bfs_follow(metagraph_bfs_t *bfs,
+                                 metagraph_edge_index_t edge,
+                                 metagraph_node_index_t from,
+                                 metagraph_node_index_t to) {
+    if (metagraph_bfs_stopped(bfs)) {
+        return false;
+    }
+    if (!bfs->edge_visitor) {
+        return true;
+    }
+    switch (bfs->edge_visitor(bfs->graph, edge, from, to, bfs->level,
+                              bfs->user_data)) {
+    case METAGRAPH_VISIT_CONTINUE:
+        return true;
+    case METAGRAPH_VISIT_SKIP:
+        return false;
+    case METAGRAPH_VISIT_TERMINATE:
+        atomic_store_explicit(&bfs->stop, true, memory_order_relaxed);
+        return false;
+    default:
+        return true;
+    }
+}
+
+static void metagraph_bfs_flush(metagraph_bfs_t *bfs,
+                                metagraph_traversal_buffer_t *buffer) {
+    if (buffer->weight) {
+        atomic_fetch_add_explicit(&bfs->next_weight, buffer->weight,
+                                  memory_order_relaxed);
+        buffer->weight = 0;
+    }
+    metagraph_traversal_flush(buffer, bfs->next, &bfs->next_count);
+}
+
+static void metagraph_bfs_discover(metagraph_bfs_t *bfs,
+                                   metagraph_traversal_buffer_t *buffer,
+                                   metagraph_node_index_t node,
+                                   metagraph_node_index_t parent,
+                                   metagraph_edge_index_t edge) {
+    bfs->parent[node] = parent;
+    bfs->parent_edge[node] = edge;
+    if (buffer->count == METAGRAPH_TRAVERSAL_BUFFER) {
+        metagraph_bfs_flush(bfs, buffer);
+    }
+    buffer->nodes[buffer->count++] = node;
+    buffer->weight += bfs->out_degree[node];
+}
+
+static void metagraph_bfs_prepare(void *context, uint32_t worker, size_t begin,
+                                  size_t end) {
+    (void)worker;
+    metagraph_bfs_t *bfs = context;
+    uint64_t weight = 0;
+    for (size_t i = begin; i < end; i++) {
+        const metagraph_node_index_t node = (metagraph_node_index_t)i;
+        bfs->out_degree[i] = metagraph_traversal_out_degree(bfs->graph, node);
+        weight += bfs->out_degree[i];
+        atomic_init(&bfs->depth[i], METAGRAPH_BFS_UNVISITED);
+        bfs->parent[i] = METAGRAPH_INVALID_INDEX;
+        bfs->parent_edge[i] = METAGRAPH_INVALID_INDEX;
+        if ((i & 63U) == 0) {
+            atomic_init(&bfs->frontier_bits[i >> 6U], 0);
+        }
+    }
+    atomic_fetch_add_explicit(&bfs->total_weight, weight, memory_order_relaxed);
+}
+
+static void metagraph_bfs_top_down(void *context, uint32_t worker,
+                                   size_t begin, size_t end) {
+    metagraph_bfs_t *bfs = context;
+    const metagraph_graph_t *graph = bfs->graph;
+    metagraph_traversal_buffer_t *buffer = &bfs->buffers[worker];
+    const uint32_t next_depth = bfs->level + 1U;
+    for (size_t i = begin; i < end; i++) {
+        const metagraph_node_index_t node = bfs->current[i];
+        if (!metagraph_bfs_visit(bfs, node)) {
+            continue;
+        }
+        for (uint32_t record = graph->node_out_head[node];
+             record != METAGRAPH_INVALID_INDEX;
+             record = graph->incidence_next[record]) {
+            const metagraph_edge_index_t edge = graph->incidence_edge[record];
+            const metagraph_node_index_t *members =
+                graph->members + graph->edge_member_begin[edge];
+            for (uint32_t m = 1; m < graph->edge_member_count[edge]; m++) {
+                const metagraph_node_index_t target = members[m];
+                if (atomic_load_explicit(&bfs->depth[target],
+                                         memory_order_relaxed) !=
+                        METAGRAPH_BFS_UNVISITED ||
+                    !metagraph_bfs_follow(bfs, edge, node, target)) {
+                    continue;
+                }
+                uint32_t expected = METAGRAPH_BFS_UNVISITED;
+                if (atomic_compare_exchange_strong_explicit(
+                        &bfs->depth[target], &expected, next_depth,
+                        memory_order_relaxed, memory_order_relaxed)) {
+                    metagraph_bfs_discover(bfs, buffer, target, node, edge);
+                }
+            }
+        }
+    }
+    metagraph_bfs_flush(bfs, buffer);
+}
+
+static void metagraph_bfs_mark(void *context, uint32_t worker, size_t begin,
+                               size_t end) {
+    (void)worker;
+    metagraph_bfs_t *bfs = context;
+    size_t active = 0;
+    for (size_t i = begin; i < end; i++) {
+        const metagraph_node_index_t node = bfs->current[i];
+        if (metagraph_bfs_visit(bfs, node)) {
+            atomic_fetch_or_explicit(&bfs->frontier_bits[node >> 6U],
+                                     1ULL << (node & 63U),
+                                     memory_order_relaxed);
+            active++;
+        }
+    }
+    atomic_fetch_add_explicit(&bfs->active, active, memory_order_relaxed);
+}
+
+static void metagraph_bfs_bottom_up(void *context, uint32_t worker,
+                                    size_t begin, size_t end) {
+    metagraph_bfs_t *bfs = context;
+    const metagraph_graph_t *graph = bfs->graph;
+    metagraph_traversal_buffer_t *buffer = &bfs->buffers[worker];
+    const uint32_t next_depth = bfs->level + 1U;
+    for (size_t i = begin; i < end && !metagraph_bfs_stopped(bfs); i++) {
+        const metagraph_node_index_t node = (metagraph_node_index_t)i;
+        if (atomic_load_explicit(&bfs->depth[node], memory_order_relaxed) !=
+            METAGRAPH_BFS_UNVISITED) {
+            continue;
+        }
+        for (uint32_t record = graph->node_in_head[node];
+             record != METAGRAPH_INVALID_INDEX;
+             record = graph->incidence_next[record]) {
+            const metagraph_edge_index_t edge = graph->incidence_edge[record];
+            const metagraph_node_index_t source =
+                metagraph_graph_edge_source(graph, edge);
+            const uint64_t word = atomic_load_explicit(
+                &bfs->frontier_bits[source >> 6U], memory_order_relaxed);
+            if (!(word & (1ULL << (source & 63U))) ||
+                !metagraph_bfs_follow(bfs, edge, source, node)) {
+                continue;
+            }
+            // Only this worker scans `node`, so no CAS is needed.
+            atomic_store_explicit(&bfs->depth[node], next_depth,
+                                  memory_order_relaxed);
+            metagraph_bfs_discover(bfs, buffer, node, source, edge);
+            break;
+        }
+    }
+    metagraph_bfs_flush(bfs, buffer);
+}
+
+static void metagraph_bfs_unmark(void *context, uint32_t worker, size_t begin,
+                                 size_t end) {
+    (void)worker;
+    metagraph_bfs_t *bfs = context;
+    for (size_t i = begin; i < end; i++) {
+        atomic_store_explicit(&bfs->frontier_bits[bfs->current[i] >> 6U], 0,
+                              memory_order_relaxed);
+    }
+}
+
+static void metagraph_bfs_export(void *context, uint32_t worker, size_t begin,
+                                 size_t end) {
+    (void)worker;
+    const metagraph_bfs_t *bfs = context;
+    for (size_t i = begin; i < end; i++) {
+        bfs->out_info[i] = (metagraph_bfs_node_info_t){
+            .distance =
+                atomic_load_explicit(&bfs->depth[i], memory_order_relaxed),
+            .parent = bfs->parent[i],
+            .parent_edge = bfs->parent_edge[i],
+        };
+    }
+}
+
+static void metagraph_bfs_release(metagraph_bfs_t *bfs,
+                                  metagraph_node_index_t *queues) {
+    free(bfs->out_degree);
+    free(bfs->depth);
+    free(bfs->parent);
+    free(bfs->parent_edge);
+    free(bfs->frontier_bits);
+    free(queues);
+    metagraph_aligned_free(bfs->buffers);
+}
+
+metagraph_result_t
+metagraph_traverse_bfs(const metagraph_traversal_context_t *context,
+                       metagraph_node_index_t start,
+                       const metagraph_parallel_config_t *parallel,
+                       metagraph_node_visitor_t node_visitor,
+                       metagraph_edge_visitor_t edge_visitor,
+                       metagraph_bfs_node_info_t *out_info) {
+    METAGRAPH_CHECK_NULL(context);
+    METAGRAPH_CHECK_NULL(context->graph);
+    const metagraph_graph_t *graph = context->graph;
+    const size_t node_count = graph->node_count;
+    if (start >= node_count) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                             "Start node %u out of range", start);
+    }
+
+    METAGRAPH_PROBE2(traverse__start, 1, start);
+    METAGRAPH_SPAN_BEGIN(span, "traverse_bfs", start);
+    const uint64_t started = metagraph_monotonic_ns();
+    size_t unit = 0;
+    metagraph_work_pool_t *pool = NULL;
+    METAGRAPH_CHECK(metagraph_traversal_team(parallel, node_count, &unit, &pool));
+
+    metagraph_bfs_t bfs = {
+        .graph = graph,
+        .user_data = context->user_data,
+        .node_visitor = node_visitor,
+        .edge_visitor = edge_visitor,
+        .out_degree = malloc(node_count * sizeof(uint32_t)),
+        .depth = malloc(node_count * sizeof(_Atomic(uint32_t))),
+        .parent = malloc(node_count * sizeof(metagraph_node_index_t)),
+        .parent_edge = malloc(node_count * sizeof(metagraph_edge_index_t)),
+        .frontier_bits = malloc((node_count + 63U) / 64U * sizeof(uint64_t)),
+        .out_info = out_info,
+        .buffers = metagraph_traversal_buffers(pool),
+    };
+    // Two frontier queues; every node enters at most one of them once.
+    metagraph_node_index_t *queues =
+        malloc(2U * node_count * sizeof(metagraph_node_index_t));
+    if (!bfs.out_degree || !bfs.depth || !bfs.parent || !bfs.parent_edge ||
+        !bfs.frontier_bits || !bfs.buffers || !queues) {
+        metagraph_bfs_release(&bfs, queues);
+        metagraph_work_pool_destroy(pool);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate BFS state for %zu nodes",
+                             node_count);
+    }
+    atomic_init(&bfs.next_count, 0);
+    atomic_init(&bfs.next_weight, 0);
+    atomic_init(&bfs.total_weight, 0);
+    atomic_init(&bfs.active, 0);
+    atomic_init(&bfs.stop, false);
+    metagraph_work_pool_for(pool, node_count, unit, metagraph_bfs_prepare, &bfs);
+
+    metagraph_node_index_t *current = queues;
+    metagraph_node_index_t *next = queues + node_count;
+    atomic_store_explicit(&bfs.depth[start], 0, memory_order_relaxed);
+    current[0] = start;
+    size_t current_count = 1;
+    size_t previous_count = 0;
+    size_t expanded = 0;
+    uint64_t frontier_weight = bfs.out_degree[start];
+    uint64_t unexplored =
+        atomic_load_explicit(&bfs.total_weight, memory_order_relaxed) -
+        frontier_weight;
+    bool bottom_up = false;
+
+    for (uint32_t level = 0; current_count > 0 && !metagraph_bfs_stopped(&bfs);
+         level++) {
+        bfs.level = level;
+        bfs.expand = context->max_depth == 0 || level < context->max_depth;
+        expanded += current_count;
+        bfs.current = current;
+        bfs.next = next;
+        atomic_store_explicit(&bfs.next_count, 0, memory_order_relaxed);
+        atomic_store_explicit(&bfs.next_weight, 0, memory_order_relaxed);
+
+        if (!bottom_up && frontier_weight > unexplored / METAGRAPH_BFS_ALPHA) {
+            bottom_up = true;
+        } else if (bottom_up &&
+                   current_count < node_count / METAGRAPH_BFS_BETA &&
+                   current_count <= previous_count) {
+            bottom_up = false;
+        }
+
+        if (bottom_up && bfs.expand) {
+            atomic_store_explicit(&bfs.active, 0, memory_order_relaxed);
+            metagraph_work_pool_for(pool, current_count, unit,
+                                    metagraph_bfs_mark, &bfs);
+            if (atomic_load_explicit(&bfs.active, memory_order_relaxed) > 0 &&
+                !metagraph_bfs_stopped(&bfs)) {
+                metagraph_work_pool_for(pool, node_count, unit,
+                                        metagraph_bfs_bottom_up, &bfs);
+            }
+            metagraph_work_pool_for(pool, current_count, unit,
+                                    metagraph_bfs_unmark, &bfs);
+        } else {
+            metagraph_work_pool_for(pool, current_count, unit,
+                                    metagraph_bfs_top_down, &bfs);
+        }
+
+        previous_count = current_count;
+        current_count = atomic_load_explicit(&bfs.next_count, memory_order_relaxed);
+        frontier_weight =
+            atomic_load_explicit(&bfs.next_weight, memory_order_relaxed);
+        unexplored -= frontier_weight < unexplored ? frontier_weight : unexplored;
+        metagraph_node_index_t *swap = current;
+        current = next;
+        next = swap;
+    }
+
+    if (out_info) {
+        metagraph_work_pool_for(pool, node_count, unit, metagraph_bfs_export,
+                                &bfs);
+    }
+    metagraph_bfs_release(&bfs, queues);
+    metagraph_work_pool_destroy(pool);
+    metagraph_metrics_add(METAGRAPH_COUNTER_TRAVERSAL_STEPS, expanded);
+    metagraph_metrics_record(METAGRAPH_HISTOGRAM_TRAVERSAL,
+                             metagraph_monotonic_ns() - started);
+    METAGRAPH_SPAN_END(span);
+    METAGRAPH_PROBE3(traverse__done, 1, expanded, (int)METAGRAPH_SUCCESS);
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Topological ordering
+// ============================================================================
+
+typedef struct {
+    const metagraph_graph_t *graph;
+    _Atomic(uint32_t) *pending; ///< Dependencies not yet emitted
+    metagraph_node_index_t *order;
+    _Atomic(size_t) order_count;
+    const metagraph_node_index_t *level;
+    metagraph_traversal_buffer_t *buffers;
+} metagraph_topo_t;
+
+static void metagraph_topo_emit(metagraph_topo_t *topo,
+                                metagraph_traversal_buffer_t *buffer,
+                                metagraph_node_index_t node) {
+    if (buffer->count == METAGRAPH_TRAVERSAL_BUFFER) {
+        metagraph_traversal_flush(buffer, topo->order, &topo->order_count);
+    }
+    buffer->nodes[buffer->count++] = node;
+}
+
+static void metagraph_topo_prepare(void *context, uint32_t worker,
+                                   size_t begin, size_t end) {
+    metagraph_topo_t *topo = context;
+    metagraph_traversal_buffer_t *buffer = &topo->buffers[worker];
+    for (size_t i = begin; i < end; i++) {
+        const metagraph_node_index_t node = (metagraph_node_index_t)i;
+        const uint32_t degree = metagraph_traversal_out_degree(topo->graph, node);
+        atomic_init(&topo->pending[i], degree);
+        if (degree == 0) {
+            metagraph_topo_emit(topo, buffer, node);
+        }
+    }
+    metagraph_traversal_flush(buffer, topo->order, &topo->order_count);
+}
+
+// Release every dependent of the level's nodes; the last release of a
+// dependent emits it into the next level.
+static void metagraph_topo_step(void *context, uint32_t worker, size_t begin,
+                                size_t end) {
+    metagraph_topo_t *topo = context;
+    const metagraph_graph_t *graph = topo->graph;
+    metagraph_traversal_buffer_t *buffer = &topo->buffers[worker];
+    for (size_t i = begin; i < end; i++) {
+        const metagraph_node_index_t node = topo->level[i];
+        for (uint32_t record = graph->node_in_head[node];
+             record != METAGRAPH_INVALID_INDEX;
+             record = graph->incidence_next[record]) {
+            const metagraph_node_index_t dependent = metagraph_graph_edge_source(
+                graph, graph->incidence_edge[record]);
+            if (atomic_fetch_sub_explicit(&topo->pending[dependent], 1,
+                                          memory_order_relaxed) == 1U) {
+                metagraph_topo_emit(topo, buffer, dependent);
+            }
+        }
+    }
+    metagraph_traversal_flush(buffer, topo->order, &topo->order_count);
+}
+
+static int metagraph_topo_compare(const void *lhs, const void *rhs) {
+    const metagraph_node_index_t a = *(const metagraph_node_index_t *)lhs;
+    const metagraph_node_index_t b = *(const metagraph_node_index_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+// A dependency of `node` that was never emitted. One always exists for a
+// node whose pending count is still positive.
+static metagraph_node_index_t
+metagraph_topo_blocked_dependency(const metagraph_topo_t *topo,
+                                  metagraph_node_index_t node) {
+    const metagraph_graph_t *graph = topo->graph;
+    for (uint32_t record = graph->node_out_head[node];
+         record != METAGRAPH_INVALID_INDEX;
+         record = graph->incidence_next[record]) {
+        const metagraph_edge_index_t edge = graph->incidence_edge[record];
+        const metagraph_node_index_t *members =
+            graph->members + graph->edge_member_begin[edge];
+        for (uint32_t m = 1; m < graph->edge_member_count[edge]; m++) {
+            if (atomic_load_explicit(&topo->pending[members[m]],
+                                     memory_order_relaxed) > 0) {
+                return members[m];
+            }
+        }
+    }
+    return METAGRAPH_INVALID_INDEX;
+}
+
+// Walk blocked dependencies from the lowest unemitted node until a node
+// repeats; the repeated suffix is a cycle.
+static metagraph_result_t
+metagraph_topo_find_cycle(const metagraph_topo_t *topo,
+                          metagraph_topological_result_t *out_result) {
+    const metagraph_graph_t *graph = topo->graph;
+    const size_t node_count = graph->node_count;
+    uint32_t *position = malloc(node_count * sizeof(uint32_t));
+    metagraph_node_index_t *path =
+        malloc(node_count * sizeof(metagraph_node_index_t));
+    if (!position || !path) {
+        free(position);
+        free(path);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate cycle search state");
+    }
+    memset(position, 0xFF, node_count * sizeof(uint32_t));
+
+    metagraph_node_index_t node = 0;
+    while (atomic_load_explicit(&topo->pending[node], memory_order_relaxed) ==
+           0) {
+        node++;
+    }
+    uint32_t length = 0;
+    while (position[node] == UINT32_MAX) {
+        position[node] = length;
+        path[length++] = node;
+        node = metagraph_topo_blocked_dependency(topo, node);
+    }
+    const uint32_t cycle_begin = position[node];
+    const size_t cycle_count = length - cycle_begin;
+    memmove(path, path + cycle_begin, cycle_count * sizeof(*path));
+    free(position);
+    out_result->cycle_nodes = path;
+    out_result->cycle_count = cycle_count;
+
+    char message[METAGRAPH_CYCLE_MESSAGE_SIZE];
+    metagraph_graph_format_cycle(graph, path, cycle_count, message,
+                                 sizeof(message));
+    return METAGRAPH_ERR(METAGRAPH_ERROR_DEPENDENCY_CYCLE,
+                         "Dependency cycle: %s", message);
+}
+
+metagraph_result_t
+metagraph_compute_topological_order(const metagraph_graph_t *graph,
+                                    const metagraph_parallel_config_t *parallel,
+                                    metagraph_topological_result_t *out_result) {
+    METAGRAPH_CHECK_NULL(graph);
+    METAGRAPH_CHECK_NULL(out_result);
+    memset(out_result, 0, sizeof(*out_result));
+    const size_t node_count = graph->node_count;
+    if (node_count == 0) {
+        return METAGRAPH_OK();
+    }
+
+    size_t unit = 0;
+    metagraph_work_pool_t *pool = NULL;
+    METAGRAPH_CHECK(metagraph_traversal_team(parallel, node_count, &unit, &pool));
+    metagraph_topo_t topo = {
+        .graph = graph,
+        .pending = malloc(node_count * sizeof(_Atomic(uint32_t))),
+        .order = malloc(node_count * sizeof(metagraph_node_index_t)),
+        .buffers = metagraph_traversal_buffers(pool),
+    };
+    if (!topo.pending || !topo.order || !topo.buffers) {
+        free(topo.pending);
+        free(topo.order);
+        metagraph_aligned_free(topo.buffers);
+        metagraph_work_pool_destroy(pool);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate ordering state for %zu nodes",
+                             node_count);
+    }
+    atomic_init(&topo.order_count, 0);
+    metagraph_work_pool_for(pool, node_count, unit, metagraph_topo_prepare,
+                            &topo);
+
+    // Levels are sorted so the order does not depend on scheduling.
+    size_t level_begin = 0;
+    size_t level_end = atomic_load_explicit(&topo.order_count, memory_order_relaxed);
+    qsort(topo.order, level_end, sizeof(*topo.order), metagraph_topo_compare);
+    while (level_begin < level_end) {
+        topo.level = topo.order + level_begin;
+        metagraph_work_pool_for(pool, level_end - level_begin, unit,
+                                metagraph_topo_step, &topo);
+        const size_t emitted =
+            atomic_load_explicit(&topo.order_count, memory_order_relaxed);
+        qsort(topo.order + level_end, emitted - level_end, sizeof(*topo.order),
+              metagraph_topo_compare);
+        level_begin = level_end;
+        level_end = emitted;
+    }
+    metagraph_work_pool_destroy(pool);
+    metagraph_aligned_free(topo.buffers);
+
+    out_result->nodes = topo.order;
+    out_result->node_count = level_end;
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    if (level_end < node_count) {
+        result = metagraph_topo_find_cycle(&topo, out_result);
+    }
+    free(topo.pending);
+    return result;
+}
+
+metagraph_result_t
+metagraph_topological_result_destroy(metagraph_topological_result_t *result) {
+    if (!result) {
+        return METAGRAPH_OK();
+    }
+    free(result->nodes);
+    free(result->cycle_nodes);
+    memset(result, 0, sizeof(*result));
+    return METAGRAPH_OK();
+}
@@ -0,0 +1,481 @@
+/**
+ * @file watcher.c
+ * @brief Bundle file hot reload with epoch-reclaimed versions
+ *
+ * Each version is a bundle wrapped in an epoch node and published through
+ * one atomic pointer. A reload maps and validates the new file, stores its
+ * version over the old one and retires the old one into the watcher's
+ * reclamation domain; the old bundle is destroyed once every reader that
+ * announced itself before the store has released it (see epoch.h). Reloads
+ * and reclamation run under one mutex, which is all epoch.h asks of
+ * writers.
+ *
+ * The watcher thread on Linux sleeps in poll() on an inotify watch of the
+ * file's directory, since renaming over the file replaces the directory
+ * entry and a watch on the old inode would never fire, plus a pipe that
+ * wakes it for shutdown. Any event in the directory just triggers an
+ * identity check. Elsewhere, and between events, the thread compares the
+ * file's device, inode, size and modification time with the last file it
+ * opened, so a missed event costs at most one poll interval.
+ */
+
+#include "metagraph/watcher.h"
+#include "metagraph/bundle.h"
+#include "metagraph/result.h"
+
+#include "epoch.h"
+#include "platform.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define METAGRAPH_WATCHER_INOTIFY 1
+#else
+#define METAGRAPH_WATCHER_INOTIFY 0
+#endif
+
+#define METAGRAPH_WATCHER_DEFAULT_POLL_MS 1000U
+
+typedef struct {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtime_ns;
+} metagraph_file_identity_t;
+
+typedef struct {
+    metagraph_epoch_node_t retire; ///< Must stay first
+    metagraph_bundle_t *bundle;
+    uint64_t generation;
+} metagraph_watcher_version_t;
+
+struct metagraph_file_watcher {
+    _Atomic(metagraph_watcher_version_t *) current;
+    _Atomic(uint64_t) generation; ///< current->generation, readable unpinned
+    metagraph_epoch_domain_t *domain;
+    metagraph_file_watcher_config_t config;
+    char *path;
+    metagraph_mutex_t reload_lock;   ///< Serializes reloads and reclamation
+    metagraph_file_identity_t tried; ///< Last file opened (reload_lock)
+    bool threaded;
+    metagraph_thread_t thread;
+    metagraph_mutex_t stop_lock;
+    metagraph_cond_t stop_cond;
+    bool stopping; ///< Guarded by stop_lock
+#if METAGRAPH_WATCHER_INOTIFY
+    int inotify_fd; ///< -1 if inotify is unavailable
+    int wake_fds[2];
+#endif
+};
+
+static void metagraph_watcher_release_version(metagraph_epoch_node_t *node) {
+    metagraph_watcher_version_t *version = (metagraph_watcher_version_t *)node;
+    (void)metagraph_bundle_destroy(version->bundle);
+    free(version);
+}
+
+static bool metagraph_watcher_identify(const char *path,
+                                       metagraph_file_identity_t *out) {
+#if defined(_WIN32)
+    struct _stat64 info;
+    if (_stat64(path, &info) != 0) {
+        return false;
+    }
+    const int64_t mtime_ns = (int64_t)info.st_mtime * 1000000000LL;
+#else
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return false;
+    }
+#if defined(__APPLE__)
+    const struct timespec mtime = info.st_mtimespec;
+#else
+    const struct timespec mtime = info.st_mtim;
+#endif
+    const int64_t mtime_ns =
+        (int64_t)mtime.tv_sec * 1000000000LL + (int64_t)mtime.tv_nsec;
+#endif
+    *out = (metagraph_file_identity_t){
+        .device = (uint64_t)info.st_dev,
+        .inode = (uint64_t)info.st_ino,
+        .size = (uint64_t)info.st_size,
+        .mtime_ns = mtime_ns,
+    };
+    return true;
+}
+
+static bool metagraph_watcher_same_file(const metagraph_file_identity_t *a,
+                                        const metagraph_file_identity_t *b) {
+    return a->device == b->device && a->inode == b->inode &&
+           a->size == b->size && a->mtime_ns == b->mtime_ns;
+}
+
+// Map the file and check it the way the watcher's flags ask.
+static metagraph_result_t
+metagraph_watcher_open(const metagraph_file_watcher_t *watcher,
+                       metagraph_bundle_t **out_bundle) {
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_create_from_file(
+        watcher->path, &watcher->config.open_options, &bundle));
+    size_t node_count = 0;
+    metagraph_result_t result =
+        metagraph_bundle_node_count(bundle, &node_count);
+    if (metagraph_result_is_success(result) &&
+        (watcher->config.flags & METAGRAPH_FILE_WATCHER_VERIFY)) {
+        result = metagraph_bundle_verify_integrity(bundle, NULL);
+    }
+    if (metagraph_result_is_error(result)) {
+        (void)metagraph_bundle_destroy(bundle);
+        return result;
+    }
+    *out_bundle = bundle;
+    return METAGRAPH_OK();
+}
+
+// Caller holds reload_lock.
+static metagraph_result_t
+metagraph_watcher_reload_locked(metagraph_file_watcher_t *watcher,
+                                bool force) {
+    metagraph_file_identity_t identity = {0};
+    const bool present = metagraph_watcher_identify(watcher->path, &identity);
+    // A file missing between unlink and rename is not a new version yet.
+    if (!force &&
+        (!present || metagraph_watcher_same_file(&identity, &watcher->tried))) {
+        return METAGRAPH_OK();
+    }
+    watcher->tried = identity;
+
+    metagraph_watcher_version_t *old =
+        atomic_load_explicit(&watcher->current, memory_order_relaxed);
+    metagraph_bundle_t *bundle = NULL;
+    metagraph_result_t result = metagraph_watcher_open(watcher, &bundle);
+    metagraph_watcher_version_t *fresh = NULL;
+    if (metagraph_result_is_success(result)) {
+        fresh = malloc(sizeof(*fresh));
+        if (!fresh) {
+            (void)metagraph_bundle_destroy(bundle);
+            result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                                   "Failed to allocate bundle version");
+        }
+    }
+    if (metagraph_result_is_error(result)) {
+        if (watcher->config.on_reload) {
+            watcher->config.on_reload(watcher->config.user_data, old->bundle,
+                                      old->generation, result);
+        }
+        return result;
+    }
+
+    *fresh = (metagraph_watcher_version_t){
+        .bundle = bundle,
+        .generation = old->generation + 1U,
+    };
+    atomic_store_explicit(&watcher->current, fresh, memory_order_seq_cst);
+    atomic_store_explicit(&watcher->generation, fresh->generation,
+                          memory_order_release);
+    metagraph_epoch_retire(watcher->domain, &old->retire,
+                           metagraph_watcher_release_version);
+    (void)metagraph_epoch_reclaim(watcher->domain);
+    if (watcher->config.on_reload) {
+        watcher->config.on_reload(watcher->config.user_data, bundle,
+                                  fresh->generation, METAGRAPH_OK());
+    }
+    return METAGRAPH_OK();
+}
+
+// ============================================================================
+// Watcher thread
+// ============================================================================
+
+// Sleep until the directory changes, the poll interval passes or the
+// watcher is stopping; true means stop.
+static bool metagraph_watcher_wait(metagraph_file_watcher_t *watcher) {
+    const uint32_t interval = watcher->config.poll_interval_ms;
+#if METAGRAPH_WATCHER_INOTIFY
+    struct pollfd fds[2] = {
+        {.fd = watcher->inotify_fd, .events = POLLIN},
+        {.fd = watcher->wake_fds[0], .events = POLLIN},
+    };
+    const int ready = poll(fds, 2, (int)interval);
+    if (ready > 0 && (fds[0].revents & POLLIN)) {
+        // Only the fact that something changed matters; drain the events.
+        _Alignas(struct inotify_event) char events[4096];
+        while (read(watcher->inotify_fd, events, sizeof(events)) > 0) {
+        }
+    }
+#endif
+    metagraph_mutex_lock(&watcher->stop_lock);
+#if !METAGRAPH_WATCHER_INOTIFY
+    if (!watcher->stopping) {
+        metagraph_cond_timedwait(&watcher->stop_cond, &watcher->stop_lock,
+                                 interval);
+    }
+#endif
+    const bool stopping = watcher->stopping;
+    metagraph_mutex_unlock(&watcher->stop_lock);
+    return stopping;
+}
+
+static void metagraph_watcher_run(void *arg) {
+    metagraph_file_watcher_t *watcher = arg;
+    while (!metagraph_watcher_wait(watcher)) {
+        metagraph_mutex_lock(&watcher->reload_lock);
+        (void)metagraph_watcher_reload_locked(watcher, false);
+        // Versions retired while readers still held them.
+        (void)metagraph_epoch_reclaim(watcher->domain);
+        metagraph_mutex_unlock(&watcher->reload_lock);
+    }
+}
+
+#if METAGRAPH_WATCHER_INOTIFY
+// Watch the directory holding the file. Failing here only costs latency:
+// the thread falls back to polling.
+static void
+metagraph_watcher_watch_directory(metagraph_file_watcher_t *watcher) {
+    watcher->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->inotify_fd < 0) {
+        return;
+    }
+    const char *slash = strrchr(watcher->path, '/');
+    char *directory = NULL;
+    if (!slash) {
+        directory = strdup(".");
+    } else {
+        const size_t length = slash == watcher->path
+                                  ? 1U
+                                  : (size_t)(slash - watcher->path);
+        directory = strndup(watcher->path, length);
+    }
+    if (!directory ||
+        inotify_add_watch(watcher->inotify_fd, directory,
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        (void)close(watcher->inotify_fd);
+        watcher->inotify_fd = -1;
+    }
+    free(directory);
+}
+#endif
+
+// Start the thread and whatever wakes it.
+static metagraph_result_t
+metagraph_watcher_start(metagraph_file_watcher_t *watcher) {
+#if METAGRAPH_WATCHER_INOTIFY
+    if (pipe2(watcher->wake_fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        watcher->wake_fds[0] = -1;
+        watcher->wake_fds[1] = -1;
+        return METAGRAPH_ERR(METAGRAPH_ERROR_RESOURCE_EXHAUSTED,
+                             "Failed to create watcher wake pipe");
+    }
+    metagraph_watcher_watch_directory(watcher);
+#endif
+    if (metagraph_thread_create(&watcher->thread, metagraph_watcher_run,
+                                watcher) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_THREAD_CREATION_FAILED,
+                             "Failed to start watcher thread for %s",
+                             watcher->path);
+    }
+    watcher->threaded = true;
+    return METAGRAPH_OK();
+}
+
+static void metagraph_watcher_stop(metagraph_file_watcher_t *watcher) {
+    if (watcher->threaded) {
+        metagraph_mutex_lock(&watcher->stop_lock);
+        watcher->stopping = true;
+        metagraph_cond_broadcast(&watcher->stop_cond);
+        metagraph_mutex_unlock(&watcher->stop_lock);
+#if METAGRAPH_WATCHER_INOTIFY
+        const char byte = 0;
+        ssize_t written = 0;
+        do {
+            written = write(watcher->wake_fds[1], &byte, 1);
+        } while (written < 0 && errno == EINTR);
+        // A full pipe (EAGAIN) already holds a pending wake. On any other
+        // failure the thread still sees stopping when its poll times out.
+        (void)written;
+#endif
+        metagraph_thread_join(&watcher->thread);
+        watcher->threaded = false;
+    }
+#if METAGRAPH_WATCHER_INOTIFY
+    for (size_t i = 0; i < 2U; i++) {
+        if (watcher->wake_fds[i] >= 0) {
+            (void)close(watcher->wake_fds[i]);
+        }
+    }
+    if (watcher->inotify_fd >= 0) {
+        (void)close(watcher->inotify_fd);
+    }
+#endif
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+static int metagraph_watcher_init_locks(metagraph_file_watcher_t *watcher) {
+    if (metagraph_mutex_init(&watcher->reload_lock) != 0) {
+        return -1;
+    }
+    if (metagraph_mutex_init(&watcher->stop_lock) != 0) {
+        metagraph_mutex_destroy(&watcher->reload_lock);
+        return -1;
+    }
+    if (metagraph_cond_init(&watcher->stop_cond) != 0) {
+        metagraph_mutex_destroy(&watcher->stop_lock);
+        metagraph_mutex_destroy(&watcher->reload_lock);
+        return -1;
+    }
+    return 0;
+}
+
+static void metagraph_watcher_free(metagraph_file_watcher_t *watcher) {
+    metagraph_watcher_stop(watcher);
+    metagraph_epoch_domain_destroy(watcher->domain);
+    free(watcher->domain);
+    metagraph_watcher_version_t *version =
+        atomic_load_explicit(&watcher->current, memory_order_relaxed);
+    if (version) {
+        metagraph_watcher_release_version(&version->retire);
+    }
+    metagraph_cond_destroy(&watcher->stop_cond);
+    metagraph_mutex_destroy(&watcher->stop_lock);
+    metagraph_mutex_destroy(&watcher->reload_lock);
+    free(watcher->path);
+    free(watcher);
+}
+
+metagraph_result_t
+metagraph_file_watcher_create(const char *file_path,
+                              const metagraph_file_watcher_config_t *config,
+                              metagraph_file_watcher_t **out_watcher) {
+    METAGRAPH_CHECK_NULL(file_path);
+    METAGRAPH_CHECK_NULL(out_watcher);
+    *out_watcher = NULL;
+
+    metagraph_file_watcher_t *watcher = calloc(1, sizeof(*watcher));
+    METAGRAPH_CHECK_ALLOC(watcher);
+    if (config) {
+        watcher->config = *config;
+    }
+    if (watcher->config.poll_interval_ms == 0) {
+        watcher->config.poll_interval_ms = METAGRAPH_WATCHER_DEFAULT_POLL_MS;
+    }
+#if METAGRAPH_WATCHER_INOTIFY
+    watcher->inotify_fd = -1;
+    watcher->wake_fds[0] = -1;
+    watcher->wake_fds[1] = -1;
+#endif
+    atomic_init(&watcher->current, NULL);
+    atomic_init(&watcher->generation, 1);
+    watcher->path = strdup(file_path);
+    watcher->domain = malloc(sizeof(*watcher->domain));
+    if (!watcher->path || !watcher->domain) {
+        free(watcher->domain);
+        free(watcher->path);
+        free(watcher);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate file watcher");
+    }
+    metagraph_result_t result = metagraph_epoch_domain_init(watcher->domain);
+    if (metagraph_result_is_error(result)) {
+        free(watcher->domain);
+        free(watcher->path);
+        free(watcher);
+        return result;
+    }
+    if (metagraph_watcher_init_locks(watcher) != 0) {
+        metagraph_epoch_domain_destroy(watcher->domain);
+        free(watcher->domain);
+        free(watcher->path);
+        free(watcher);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_RESOURCE_EXHAUSTED,
+                             "Failed to initialize file watcher locks");
+    }
+
+    // Take the file's identity before opening it: a replacement that lands
+    // in between then looks like a change and is picked up next time.
+    (void)metagraph_watcher_identify(watcher->path, &watcher->tried);
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_CHECK_GOTO(metagraph_watcher_open(watcher, &bundle), fail);
+    metagraph_watcher_version_t *version = malloc(sizeof(*version));
+    if (!version) {
+        (void)metagraph_bundle_destroy(bundle);
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Failed to allocate bundle version");
+        goto fail;
+    }
+    *version = (metagraph_watcher_version_t){.bundle = bundle,
+                                             .generation = 1};
+    atomic_store_explicit(&watcher->current, version, memory_order_relaxed);
+
+    if (!(watcher->config.flags & METAGRAPH_FILE_WATCHER_MANUAL)) {
+        METAGRAPH_CHECK_GOTO(metagraph_watcher_start(watcher), fail);
+    }
+    *out_watcher = watcher;
+    return METAGRAPH_OK();
+
+fail:
+    metagraph_watcher_free(watcher);
+    return result;
+}
+
+metagraph_result_t
+metagraph_file_watcher_destroy(metagraph_file_watcher_t *watcher) {
+    if (watcher) {
+        metagraph_watcher_free(watcher);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t
+metagraph_file_watcher_acquire(const metagraph_file_watcher_t *watcher,
+                               const metagraph_bundle_t **out_bundle) {
+    METAGRAPH_CHECK_NULL(watcher);
+    METAGRAPH_CHECK_NULL(out_bundle);
+    metagraph_epoch_record_t *record = metagraph_epoch_enter(watcher->domain);
+    METAGRAPH_CHECK_ALLOC(record);
+    const metagraph_watcher_version_t *version =
+        atomic_load_explicit(&watcher->current, memory_order_seq_cst);
+    *out_bundle = version->bundle;
+    return METAGRAPH_OK();
+}
+
+void metagraph_file_watcher_release(const metagraph_file_watcher_t *watcher) {
+    if (!watcher) {
+        return;
+    }
+    metagraph_epoch_record_t *record =
+        metagraph_epoch_current(watcher->domain);
+    if (record) {
+        metagraph_epoch_exit(record);
+    }
+}
+
+metagraph_result_t
+metagraph_file_watcher_reload(metagraph_file_watcher_t *watcher, bool force) {
+    METAGRAPH_CHECK_NULL(watcher);
+    metagraph_mutex_lock(&watcher->reload_lock);
+    const metagraph_result_t result =
+        metagraph_watcher_reload_locked(watcher, force);
+    metagraph_mutex_unlock(&watcher->reload_lock);
+    return result;
+}
+
+uint64_t
+metagraph_file_watcher_generation(const metagraph_file_watcher_t *watcher) {
+    if (!watcher) {
+        return 0;
+    }
+    return atomic_load_explicit(&watcher->generation, memory_order_acquire);
+}
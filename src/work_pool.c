@@ -0,0 +1,236 @@
+/**
+ * @file work_pool.c
+ * @brief Fork-join range splitting on the shared scheduler
+ *
+ * Each worker's remaining chunks are one packed atomic word, begin in the
+ * high 32 bits and end in the low 32 bits. The owner pops the front chunk
+ * and thieves split off the back half with a compare-and-swap on the same
+ * word, so neither side ever takes a lock. No chunk is added to a run once
+ * a call has started, so a worker that finds every run empty is done.
+ *
+ * Each worker records the NUMA node it runs on when it starts draining.
+ * Thieves try victims on their own node first, so split-off chunks (and
+ * the graph data they touch) tend to stay on the node that owned them;
+ * other nodes are only raided once the local runs are empty.
+ *
+ * A pool owns no threads. Each call spawns one scheduler task per slot
+ * beyond the first, drains slot 0 on the calling thread, and waits on a
+ * latch the slot tasks count down, running queued tasks meanwhile. Chunk
+ * results therefore happen-before the return of metagraph_work_pool_for(),
+ * and a call made from inside a scheduler task cannot deadlock. A slot
+ * task that starts late finds its run already stolen and returns at once.
+ */
+
+#include "work_pool.h"
+
+#include "metagraph/numa.h"
+#include "metagraph/result.h"
+
+#include "platform.h"
+#include "scheduler_internal.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METAGRAPH_WORK_CACHE_LINE 64U
+
+typedef struct {
+    _Alignas(METAGRAPH_WORK_CACHE_LINE) _Atomic(uint64_t) run;
+    metagraph_task_t task;
+    metagraph_work_pool_t *pool;
+    uint32_t index;
+    _Atomic(uint32_t) node; ///< NUMA node seen at the start of the call
+} metagraph_work_worker_t;
+
+struct metagraph_work_pool {
+    metagraph_scheduler_t *scheduler; ///< NULL runs every slot on the caller
+    uint32_t size;
+    metagraph_work_worker_t *workers;
+    metagraph_latch_t done; ///< Slots 1.. still draining
+
+    // Current call, published by spawning the slot tasks
+    metagraph_work_range_fn fn;
+    void *context;
+    size_t count;
+    size_t grain;
+};
+
+static uint64_t metagraph_work_pack(uint32_t begin, uint32_t end) {
+    return ((uint64_t)begin << 32U) | end;
+}
+
+static bool metagraph_work_pop(metagraph_work_worker_t *worker,
+                               uint32_t *out_chunk) {
+    uint64_t run = atomic_load_explicit(&worker->run, memory_order_relaxed);
+    for (;;) {
+        const uint32_t begin = (uint32_t)(run >> 32U);
+        const uint32_t end = (uint32_t)run;
+        if (begin >= end) {
+            return false;
+        }
+        if (atomic_compare_exchange_weak_explicit(
+                &worker->run, &run, metagraph_work_pack(begin + 1U, end),
+                memory_order_relaxed, memory_order_relaxed)) {
+            *out_chunk = begin;
+            return true;
+        }
+    }
+}
+
+// Move the back half of victim's run into self's run.
+static bool metagraph_work_steal_from(metagraph_work_worker_t *victim,
+                                      metagraph_work_worker_t *self) {
+    uint64_t run = atomic_load_explicit(&victim->run, memory_order_relaxed);
+    for (;;) {
+        const uint32_t begin = (uint32_t)(run >> 32U);
+        const uint32_t end = (uint32_t)run;
+        if (begin >= end) {
+            return false;
+        }
+        const uint32_t middle = begin + (end - begin) / 2U;
+        if (atomic_compare_exchange_weak_explicit(
+                &victim->run, &run, metagraph_work_pack(begin, middle),
+                memory_order_relaxed, memory_order_relaxed)) {
+            atomic_store_explicit(&self->run, metagraph_work_pack(middle, end),
+                                  memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+// Steal from some other worker, preferring ones on self's NUMA node.
+static bool metagraph_work_steal(metagraph_work_pool_t *pool,
+                                 metagraph_work_worker_t *self) {
+    const uint32_t node =
+        atomic_load_explicit(&self->node, memory_order_relaxed);
+    for (uint32_t pass = 0; pass < 2U; pass++) {
+        for (uint32_t offset = 1; offset < pool->size; offset++) {
+            metagraph_work_worker_t *victim =
+                &pool->workers[(self->index + offset) % pool->size];
+            const bool local = atomic_load_explicit(
+                                   &victim->node, memory_order_relaxed) == node;
+            if (local == (pass == 0U) &&
+                metagraph_work_steal_from(victim, self)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void metagraph_work_drain(metagraph_work_pool_t *pool,
+                                 metagraph_work_worker_t *self,
+                                 metagraph_work_range_fn fn, void *context,
+                                 size_t count, size_t grain) {
+    atomic_store_explicit(&self->node, metagraph_numa_current_node(),
+                          memory_order_relaxed);
+    for (;;) {
+        uint32_t chunk = 0;
+        if (!metagraph_work_pop(self, &chunk)) {
+            if (!metagraph_work_steal(pool, self)) {
+                return;
+            }
+            continue;
+        }
+        const size_t begin = (size_t)chunk * grain;
+        const size_t end = count - begin > grain ? begin + grain : count;
+        fn(context, self->index, begin, end);
+    }
+}
+
+// A participant: drain its own slot, then report back.
+static void metagraph_work_slot_run(metagraph_task_t *task) {
+    metagraph_work_worker_t *self =
+        (metagraph_work_worker_t *)(void *)((char *)task -
+                                            offsetof(metagraph_work_worker_t,
+                                                     task));
+    metagraph_work_pool_t *pool = self->pool;
+    metagraph_work_drain(pool, self, pool->fn, pool->context, pool->count,
+                         pool->grain);
+    metagraph_scheduler_arrive(pool->scheduler, &pool->done);
+}
+
+metagraph_result_t metagraph_work_pool_create(uint32_t threads,
+                                              metagraph_work_pool_t **out_pool) {
+    METAGRAPH_CHECK_NULL(out_pool);
+    *out_pool = NULL;
+    metagraph_work_pool_t *pool = calloc(1, sizeof(*pool));
+    METAGRAPH_CHECK_ALLOC(pool);
+    // More participants than threads that can run them only adds steals.
+    pool->scheduler = metagraph_scheduler_default();
+    const uint32_t limit =
+        metagraph_scheduler_thread_count(pool->scheduler) + 1U;
+    pool->size = threads && threads < limit ? threads : limit;
+    pool->workers = metagraph_aligned_alloc(
+        METAGRAPH_WORK_CACHE_LINE, pool->size * sizeof(*pool->workers));
+    if (!pool->workers) {
+        free(pool);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                             "Failed to allocate %u workers", threads);
+    }
+    memset(pool->workers, 0, pool->size * sizeof(*pool->workers));
+    for (uint32_t i = 0; i < pool->size; i++) {
+        atomic_init(&pool->workers[i].run, 0);
+        atomic_init(&pool->workers[i].node, 0);
+        pool->workers[i].task.run = metagraph_work_slot_run;
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+    }
+    *out_pool = pool;
+    return METAGRAPH_OK();
+}
+
+void metagraph_work_pool_destroy(metagraph_work_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+    metagraph_aligned_free(pool->workers);
+    free(pool);
+}
+
+uint32_t metagraph_work_pool_size(const metagraph_work_pool_t *pool) {
+    return pool ? pool->size : 0;
+}
+
+void metagraph_work_pool_for(metagraph_work_pool_t *pool, size_t count,
+                             size_t grain, metagraph_work_range_fn fn,
+                             void *context) {
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+    // Chunk indices are 32-bit.
+    if (count / grain >= UINT32_MAX) {
+        grain = count / (UINT32_MAX - 1U) + 1U;
+    }
+    const size_t chunks = (count + grain - 1U) / grain;
+    if (pool->size == 1 || chunks == 1) {
+        fn(context, 0, 0, count);
+        return;
+    }
+
+    for (uint32_t i = 0; i < pool->size; i++) {
+        const uint32_t begin = (uint32_t)(chunks * i / pool->size);
+        const uint32_t end = (uint32_t)(chunks * (i + 1U) / pool->size);
+        atomic_store_explicit(&pool->workers[i].run,
+                              metagraph_work_pack(begin, end),
+                              memory_order_relaxed);
+    }
+    pool->fn = fn;
+    pool->context = context;
+    pool->count = count;
+    pool->grain = grain;
+    atomic_init(&pool->done.pending, pool->size - 1U);
+    for (uint32_t i = 1; i < pool->size; i++) {
+        metagraph_scheduler_spawn(pool->scheduler, &pool->workers[i].task);
+    }
+
+    metagraph_work_drain(pool, &pool->workers[0], fn, context, count, grain);
+    metagraph_scheduler_wait(pool->scheduler, &pool->done);
+}
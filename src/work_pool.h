@@ -0,0 +1,60 @@
+/**
+ * @file work_pool.h
+ * @brief Internal fork-join range splitting with work stealing
+ *
+ * metagraph_work_pool_for() cuts [0, count) into grain-sized chunks and
+ * deals each worker (the caller is worker 0) a contiguous run of them.
+ * Workers take chunks from the front of their own run; a worker whose run
+ * is empty steals the back half of another worker's run. The call returns
+ * once every chunk has been processed, so consecutive calls act as
+ * barriers (one per BFS level, for example).
+ *
+ * Workers other than the caller are tasks on the shared scheduler, so a
+ * pool is cheap to create and starts no threads of its own.
+ */
+
+#ifndef SRC_WORK_POOL_H
+#define SRC_WORK_POOL_H
+
+#include "metagraph/result.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Process items [begin, end) on behalf of `worker`
+ *
+ * worker is stable for the calling thread during one
+ * metagraph_work_pool_for() call and below metagraph_work_pool_size().
+ */
+typedef void (*metagraph_work_range_fn)(void *context, uint32_t worker,
+                                        size_t begin, size_t end);
+
+typedef struct metagraph_work_pool metagraph_work_pool_t;
+
+/**
+ * @brief Set up a team of `threads` workers (0 = one per CPU)
+ *
+ * The thread calling metagraph_work_pool_for() is worker 0; the others
+ * run as shared scheduler tasks. The team is capped at the scheduler's
+ * thread count plus one, and is just the caller if the scheduler could
+ * not be started.
+ */
+metagraph_result_t metagraph_work_pool_create(uint32_t threads,
+                                              metagraph_work_pool_t **out_pool);
+
+void metagraph_work_pool_destroy(metagraph_work_pool_t *pool);
+
+uint32_t metagraph_work_pool_size(const metagraph_work_pool_t *pool);
+
+/**
+ * @brief Run fn over [0, count) in chunks of `grain` items and wait
+ *
+ * Only one thread may drive a pool at a time, and fn must not call back
+ * into the same pool.
+ */
+void metagraph_work_pool_for(metagraph_work_pool_t *pool, size_t count,
+                             size_t grain, metagraph_work_range_fn fn,
+                             void *context);
+
+#endif // SRC_WORK_POOL_H
@@ -0,0 +1,264 @@
+/*
+ * MetaGraph streaming bundle builder tests
+ */
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_BUILDER_GRAPH_PATH "bundle_builder_graph.mgb"
+#define TEST_BUILDER_PATH "bundle_builder_test.mgb"
+#define TEST_BUILDER_NODES 4000U
+#define TEST_BUILDER_EDGES 9000U
+#define TEST_BUILDER_MAX_MEMBERS 5U
+#define TEST_BUILDER_MAX_PAYLOAD 700U
+
+static metagraph_id_t test_builder_id(uint64_t value) {
+    return (metagraph_id_t){.high = 0xB01DULL, .low = value};
+}
+
+static uint64_t test_builder_state;
+
+static uint32_t test_builder_random(uint32_t bound) {
+    test_builder_state =
+        test_builder_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)((test_builder_state >> 33U) % bound);
+}
+
+static const metagraph_bundle_write_options_t test_builder_options = {
+    .creation_time = 1700000000U,
+    .bundle_id = 9,
+    .creator = "bundle_builder_test",
+    .description = "streamed",
+    .integrity_chunk_size = 1024U,
+};
+
+static const metagraph_bundle_write_options_t test_builder_packed_options = {
+    .creation_time = 1700000000U,
+    .bundle_id = 9,
+    .creator = "bundle_builder_test",
+    .description = "streamed",
+    .integrity_chunk_size = 1024U,
+    .compression = METAGRAPH_COMPRESSION_LZ,
+    .compression_block_size = 4096U,
+};
+
+// Adds the same pseudo-random nodes and hyperedges to a graph or a builder.
+typedef struct {
+    metagraph_graph_t *graph;
+    metagraph_bundle_builder_t *builder;
+} test_builder_target_t;
+
+static void test_builder_populate(const test_builder_target_t *target,
+                                  uint8_t *payloads, char (*names)[24]) {
+    test_builder_state = 0x2545F4914F6CDD1DULL;
+    for (uint32_t i = 0; i < TEST_BUILDER_NODES; i++) {
+        const uint32_t size = test_builder_random(TEST_BUILDER_MAX_PAYLOAD);
+        uint8_t *data = payloads + (size_t)i * TEST_BUILDER_MAX_PAYLOAD;
+        memset(data, (int)(i & 0xFFU), size);
+        (void)snprintf(names[i], sizeof(names[i]), "assets/%u.bin", i);
+        const metagraph_node_metadata_t node = {
+            .id = test_builder_id(i),
+            .name = i % 3U ? names[i] : NULL,
+            .type = i % 7U,
+            .data_size = size,
+            .data = size ? data : NULL,
+            .hash = 0xFEEDULL + i,
+        };
+        metagraph_node_index_t index = 0;
+        if (target->graph) {
+            METAGRAPH_TEST_OK(metagraph_graph_add_node(target->graph, &node,
+                                                       &index));
+        } else {
+            METAGRAPH_TEST_OK(metagraph_bundle_builder_add_node(
+                target->builder, &node, &index));
+        }
+        METAGRAPH_TEST_ASSERT(index == i);
+    }
+    for (uint32_t e = 0; e < TEST_BUILDER_EDGES; e++) {
+        metagraph_id_t members[TEST_BUILDER_MAX_MEMBERS];
+        const uint32_t count = 2U + test_builder_random(TEST_BUILDER_MAX_MEMBERS - 1U);
+        for (uint32_t m = 0; m < count; m++) {
+            // Repeated targets are allowed and appear once per position.
+            members[m] = test_builder_id(test_builder_random(TEST_BUILDER_NODES));
+        }
+        const metagraph_edge_metadata_t edge = {
+            .id = test_builder_id(TEST_BUILDER_NODES + e),
+            .type = e % 5U,
+            .weight = (float)e * 0.5F,
+            .node_count = count,
+            .nodes = members,
+        };
+        if (target->graph) {
+            METAGRAPH_TEST_OK(metagraph_graph_add_edge(target->graph, &edge, NULL));
+        } else {
+            METAGRAPH_TEST_OK(
+                metagraph_bundle_builder_add_edge(target->builder, &edge, NULL));
+        }
+    }
+}
+
+static uint8_t *test_builder_read_file(const char *path, size_t *out_size) {
+    FILE *file = fopen(path, "rb");
+    METAGRAPH_TEST_ASSERT(file != NULL);
+    METAGRAPH_TEST_ASSERT(fseek(file, 0, SEEK_END) == 0);
+    const long size = ftell(file);
+    METAGRAPH_TEST_ASSERT(size > 0);
+    METAGRAPH_TEST_ASSERT(fseek(file, 0, SEEK_SET) == 0);
+    uint8_t *data = malloc((size_t)size);
+    METAGRAPH_TEST_ASSERT(data != NULL);
+    METAGRAPH_TEST_ASSERT(fread(data, 1, (size_t)size, file) == (size_t)size);
+    (void)fclose(file);
+    *out_size = (size_t)size;
+    return data;
+}
+
+static void
+test_builder_matches_write_graph(const metagraph_bundle_write_options_t *opts) {
+    uint8_t *payloads = malloc((size_t)TEST_BUILDER_NODES * TEST_BUILDER_MAX_PAYLOAD);
+    char (*names)[24] = malloc(TEST_BUILDER_NODES * sizeof(*names));
+    METAGRAPH_TEST_ASSERT(payloads != NULL && names != NULL);
+
+    test_builder_target_t target = {0};
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &target.graph));
+    test_builder_populate(&target, payloads, names);
+    METAGRAPH_TEST_OK(metagraph_bundle_write_graph(
+        target.graph, TEST_BUILDER_GRAPH_PATH, opts));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(target.graph));
+    size_t expected_size = 0;
+    uint8_t *expected =
+        test_builder_read_file(TEST_BUILDER_GRAPH_PATH, &expected_size);
+
+    // Small buffers force many spill flushes; both spill locations and
+    // several thread counts must produce the same bytes.
+    const char *const directories[] = {NULL, "."};
+    const uint32_t thread_counts[] = {1, 3, 0};
+    for (size_t run = 0; run < 3; run++) {
+        const metagraph_bundle_builder_config_t config = {
+            .write = *opts,
+            .temp_directory = directories[run % 2U],
+            .max_memory_usage = 16U * 1024U,
+            .thread_count = thread_counts[run],
+        };
+        target.graph = NULL;
+        METAGRAPH_TEST_OK(
+            metagraph_bundle_builder_create(&config, &target.builder));
+        test_builder_populate(&target, payloads, names);
+        METAGRAPH_TEST_OK(
+            metagraph_bundle_builder_finish(target.builder, TEST_BUILDER_PATH));
+        METAGRAPH_TEST_OK(metagraph_bundle_builder_destroy(target.builder));
+
+        size_t size = 0;
+        uint8_t *data = test_builder_read_file(TEST_BUILDER_PATH, &size);
+        METAGRAPH_TEST_ASSERT(size == expected_size);
+        METAGRAPH_TEST_ASSERT(memcmp(data, expected, size) == 0);
+        free(data);
+    }
+    free(expected);
+
+    const metagraph_bundle_options_t open_options = {
+        .flags = METAGRAPH_BUNDLE_OPEN_VERIFY};
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(metagraph_bundle_create_from_file(
+        TEST_BUILDER_PATH, &open_options, &bundle));
+    METAGRAPH_TEST_OK(metagraph_bundle_verify_integrity(bundle, NULL));
+    size_t count = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_node_count(bundle, &count));
+    METAGRAPH_TEST_ASSERT(count == TEST_BUILDER_NODES);
+    METAGRAPH_TEST_OK(metagraph_bundle_edge_count(bundle, &count));
+    METAGRAPH_TEST_ASSERT(count == TEST_BUILDER_EDGES);
+    metagraph_node_index_t index = METAGRAPH_INVALID_INDEX;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_find_node(bundle, test_builder_id(1234), &index));
+    METAGRAPH_TEST_ASSERT(index == 1234);
+    metagraph_node_metadata_t node = {0};
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, index, &node));
+    METAGRAPH_TEST_ASSERT(node.name && strcmp(node.name, "assets/1234.bin") == 0);
+    const uint8_t *bytes = node.data;
+    for (size_t i = 0; i < node.data_size; i++) {
+        METAGRAPH_TEST_ASSERT(bytes[i] == (1234U & 0xFFU));
+    }
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    free(names);
+    free(payloads);
+    (void)remove(TEST_BUILDER_GRAPH_PATH);
+    (void)remove(TEST_BUILDER_PATH);
+}
+
+static void test_builder_errors(void) {
+    const metagraph_bundle_builder_config_t bad_config = {
+        .write = {.integrity_chunk_size = 3000}};
+    metagraph_bundle_builder_t *builder = NULL;
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_builder_create(&bad_config, &builder),
+                          METAGRAPH_ERROR_INVALID_SIZE);
+    METAGRAPH_TEST_ASSERT(builder == NULL);
+
+    METAGRAPH_TEST_OK(metagraph_bundle_builder_create(NULL, &builder));
+    const metagraph_node_metadata_t node = {.id = test_builder_id(1)};
+    METAGRAPH_TEST_OK(metagraph_bundle_builder_add_node(builder, &node, NULL));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_builder_add_node(builder, &node, NULL),
+                          METAGRAPH_ERROR_NODE_EXISTS);
+
+    const metagraph_id_t members[] = {test_builder_id(1), test_builder_id(2)};
+    metagraph_edge_metadata_t edge = {.id = test_builder_id(50),
+                                      .node_count = 2,
+                                      .nodes = members};
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_builder_add_edge(builder, &edge, NULL),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+    const metagraph_node_metadata_t second = {.id = test_builder_id(2)};
+    METAGRAPH_TEST_OK(metagraph_bundle_builder_add_node(builder, &second, NULL));
+    metagraph_edge_index_t edge_index = METAGRAPH_INVALID_INDEX;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_builder_add_edge(builder, &edge, &edge_index));
+    METAGRAPH_TEST_ASSERT(edge_index == 0);
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_builder_add_edge(builder, &edge, NULL),
+                          METAGRAPH_ERROR_EDGE_EXISTS);
+    edge.id = test_builder_id(51);
+    edge.node_count = 1;
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_builder_add_edge(builder, &edge, NULL),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+
+    METAGRAPH_TEST_OK(metagraph_bundle_builder_finish(builder, TEST_BUILDER_PATH));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_builder_add_node(builder, &node, NULL),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_builder_finish(builder, TEST_BUILDER_PATH),
+        METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_OK(metagraph_bundle_builder_destroy(builder));
+
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUILDER_PATH, NULL, &bundle));
+    METAGRAPH_TEST_OK(metagraph_bundle_verify_integrity(bundle, NULL));
+    size_t count = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_edge_count(bundle, &count));
+    METAGRAPH_TEST_ASSERT(count == 1);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    // An empty builder still produces a valid bundle.
+    METAGRAPH_TEST_OK(metagraph_bundle_builder_create(NULL, &builder));
+    METAGRAPH_TEST_OK(metagraph_bundle_builder_finish(builder, TEST_BUILDER_PATH));
+    METAGRAPH_TEST_OK(metagraph_bundle_builder_destroy(builder));
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUILDER_PATH, NULL, &bundle));
+    METAGRAPH_TEST_OK(metagraph_bundle_node_count(bundle, &count));
+    METAGRAPH_TEST_ASSERT(count == 0);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    (void)remove(TEST_BUILDER_PATH);
+}
+
+int main(void) {
+    test_builder_matches_write_graph(&test_builder_options);
+    test_builder_matches_write_graph(&test_builder_packed_options);
+    test_builder_errors();
+    return 0;
+}
@@ -0,0 +1,1325 @@
+/*
+ * MetaGraph bundle writer and memory-mapped reader tests
+ */
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/mmap.h"
+#include "metagraph/result.h"
+#include "metagraph/version.h"
+
+#include "test_utils.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_BUNDLE_PATH "bundle_test.mgb"
+
+static metagraph_id_t test_bundle_make_id(uint64_t value) {
+    return (metagraph_id_t){.high = value * 0x100000001B3ULL, .low = value};
+}
+
+// material(0) <- {texture(1), shader(2)}, mesh(3) <- {material(0)}
+static metagraph_graph_t *test_bundle_make_graph(void) {
+    static char texture[] = "texture-bytes";
+    static char shader[] = "shader-source";
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+
+    const char *names[] = {"materials/base.mat", "textures/diffuse.png",
+                           "shaders/lit.glsl", NULL};
+    for (uint64_t i = 0; i < 4; i++) {
+        metagraph_node_metadata_t node = {.id = test_bundle_make_id(i),
+                                          .name = names[i],
+                                          .type = (uint32_t)i,
+                                          .hash = 0x1000U + i};
+        if (i == 1) {
+            node.data = texture;
+            node.data_size = sizeof(texture);
+        } else if (i == 2) {
+            node.data = shader;
+            node.data_size = sizeof(shader);
+        }
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+
+    const metagraph_id_t first_nodes[] = {test_bundle_make_id(0),
+                                          test_bundle_make_id(1),
+                                          test_bundle_make_id(2)};
+    metagraph_edge_metadata_t first = {.id = test_bundle_make_id(100),
+                                       .type = 1,
+                                       .weight = 2.5F,
+                                       .node_count = 3,
+                                       .nodes = first_nodes};
+    METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &first, NULL));
+
+    const metagraph_id_t second_nodes[] = {test_bundle_make_id(3),
+                                           test_bundle_make_id(0)};
+    metagraph_edge_metadata_t second = {.id = test_bundle_make_id(101),
+                                        .node_count = 2,
+                                        .nodes = second_nodes};
+    METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &second, NULL));
+    return graph;
+}
+
+static void test_bundle_write_sample(void) {
+    metagraph_graph_t *graph = test_bundle_make_graph();
+    const metagraph_bundle_write_options_t options = {
+        .creation_time = 1700000000U,
+        .bundle_id = 77,
+        .creator = "bundle_test",
+        .description = "four assets",
+    };
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, &options));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+// Reads the sample bundle into an 8-byte aligned heap buffer
+static uint8_t *test_bundle_read_file(size_t *out_size) {
+    FILE *file = fopen(TEST_BUNDLE_PATH, "rb");
+    METAGRAPH_TEST_ASSERT(file != NULL);
+    METAGRAPH_TEST_ASSERT(fseek(file, 0, SEEK_END) == 0);
+    long size = ftell(file);
+    METAGRAPH_TEST_ASSERT(size > 0);
+    METAGRAPH_TEST_ASSERT(fseek(file, 0, SEEK_SET) == 0);
+    uint8_t *data = malloc((size_t)size);
+    METAGRAPH_TEST_ASSERT(data != NULL);
+    METAGRAPH_TEST_ASSERT(fread(data, 1, (size_t)size, file) == (size_t)size);
+    (void)fclose(file);
+    *out_size = (size_t)size;
+    return data;
+}
+
+static void test_bundle_round_trip(void) {
+    test_bundle_write_sample();
+
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, NULL, &bundle));
+
+    const metagraph_bundle_header_t *header =
+        metagraph_bundle_get_header(bundle);
+    METAGRAPH_TEST_ASSERT(header->bundle_id == 77);
+    METAGRAPH_TEST_ASSERT(header->creation_time == 1700000000U);
+
+    size_t count = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_node_count(bundle, &count));
+    METAGRAPH_TEST_ASSERT(count == 4);
+    METAGRAPH_TEST_OK(metagraph_bundle_edge_count(bundle, &count));
+    METAGRAPH_TEST_ASSERT(count == 2);
+
+    metagraph_node_index_t index = METAGRAPH_INVALID_INDEX;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_find_node(bundle, test_bundle_make_id(2), &index));
+    METAGRAPH_TEST_ASSERT(index == 2);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_find_node(bundle, test_bundle_make_id(9), &index),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+
+    metagraph_node_metadata_t node = {0};
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, 1, &node));
+    METAGRAPH_TEST_ASSERT(strcmp(node.name, "textures/diffuse.png") == 0);
+    METAGRAPH_TEST_ASSERT(node.data_size == sizeof("texture-bytes"));
+    METAGRAPH_TEST_ASSERT(memcmp(node.data, "texture-bytes", node.data_size) ==
+                          0);
+    METAGRAPH_TEST_ASSERT((uintptr_t)node.data % 16U == 0);
+    METAGRAPH_TEST_ASSERT(node.type == 1 && node.hash == 0x1001U);
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, 3, &node));
+    METAGRAPH_TEST_ASSERT(node.name == NULL && node.data == NULL);
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_get_node(bundle, 4, &node),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+
+    metagraph_edge_metadata_t edge = {0};
+    METAGRAPH_TEST_OK(metagraph_bundle_get_edge(bundle, 0, &edge));
+    METAGRAPH_TEST_ASSERT(edge.type == 1 && edge.node_count == 3);
+    METAGRAPH_TEST_ASSERT(metagraph_id_equal(edge.id, test_bundle_make_id(100)));
+
+    const metagraph_node_index_t *members = NULL;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_edge_nodes(bundle, 0, &members,
+                                                      &count));
+    METAGRAPH_TEST_ASSERT(count == 3 && members[0] == 0 && members[1] == 1 &&
+                          members[2] == 2);
+
+    metagraph_bundle_metadata_t metadata;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_metadata(bundle, &metadata));
+    METAGRAPH_TEST_ASSERT(strcmp(metadata.creator, "bundle_test") == 0);
+    METAGRAPH_TEST_ASSERT(strcmp(metadata.description, "four assets") == 0);
+
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+}
+
+static void test_bundle_zero_copy_adjacency(void) {
+    metagraph_bundle_t *bundle = NULL;
+    const metagraph_bundle_options_t options = {
+        .flags = METAGRAPH_BUNDLE_OPEN_POPULATE};
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, &options, &bundle));
+
+    const metagraph_memory_map_t *map = metagraph_bundle_get_map(bundle);
+    const metagraph_edge_index_t *edges = NULL;
+    size_t count = 0;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_get_outgoing_edges(bundle, 0, &edges, &count));
+    METAGRAPH_TEST_ASSERT(count == 1 && edges[0] == 0);
+    METAGRAPH_TEST_OK(metagraph_validate_pointer(map, edges, sizeof(*edges)));
+
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_get_incoming_edges(bundle, 0, &edges, &count));
+    METAGRAPH_TEST_ASSERT(count == 1 && edges[0] == 1);
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_get_incoming_edges(bundle, 2, &edges, &count));
+    METAGRAPH_TEST_ASSERT(count == 1 && edges[0] == 0);
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_get_outgoing_edges(bundle, 1, &edges, &count));
+    METAGRAPH_TEST_ASSERT(count == 0);
+
+    const metagraph_node_index_t nodes[] = {2, METAGRAPH_INVALID_INDEX, 0};
+    const metagraph_edge_index_t *lists[3];
+    size_t counts[3];
+    METAGRAPH_TEST_OK(metagraph_bundle_get_incoming_edges_batch(
+        bundle, nodes, 3, lists, counts));
+    METAGRAPH_TEST_ASSERT(counts[0] == 1 && lists[0][0] == 0);
+    METAGRAPH_TEST_ASSERT(counts[1] == 0 && lists[1] == NULL);
+    METAGRAPH_TEST_ASSERT(counts[2] == 1 && lists[2][0] == 1);
+    METAGRAPH_TEST_OK(metagraph_bundle_get_outgoing_edges_batch(
+        bundle, nodes, 3, lists, counts));
+    METAGRAPH_TEST_ASSERT(counts[0] == 0 && counts[1] == 0);
+    METAGRAPH_TEST_ASSERT(counts[2] == 1 && lists[2][0] == 0);
+    const metagraph_node_index_t out_of_range[] = {0, 4};
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_get_outgoing_edges_batch(
+                              bundle, out_of_range, 2, lists, counts),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+}
+
+static void test_bundle_rejects_corruption(void) {
+    size_t size = 0;
+    uint8_t *data = test_bundle_read_file(&size);
+    metagraph_bundle_t *bundle = NULL;
+
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    // Header byte flip is caught by the header checksum
+    data[offsetof(metagraph_bundle_header_t, bundle_id)] ^= 0xFFU;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle),
+        METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    data[offsetof(metagraph_bundle_header_t, bundle_id)] ^= 0xFFU;
+
+    // Truncation
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_create_from_memory(data, size - 1U, NULL, &bundle),
+        METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_create_from_memory(data, 16, NULL, &bundle),
+        METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+
+    // Bad magic
+    data[0] = 'X';
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle),
+        METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    data[0] = 'M';
+
+    // Future format version
+    metagraph_bundle_header_t header;
+    memcpy(&header, data, sizeof(header));
+    header.format_version++;
+    memcpy(data, &header, sizeof(header));
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle),
+        METAGRAPH_ERROR_BUNDLE_VERSION_MISMATCH);
+
+    free(data);
+}
+
+// Which EDGES array entry test_bundle_lazy_section_corruption() breaks.
+typedef enum {
+    TEST_BUNDLE_BREAK_ROWS,
+    TEST_BUNDLE_BREAK_MEMBERS,
+    TEST_BUNDLE_BREAK_OUT_EDGES,
+    TEST_BUNDLE_BREAK_IN_EDGES,
+} test_bundle_break_t;
+
+static void test_bundle_lazy_section_corruption(test_bundle_break_t target) {
+    size_t size = 0;
+    uint8_t *data = test_bundle_read_file(&size);
+    metagraph_bundle_header_t header;
+    memcpy(&header, data, sizeof(header));
+
+    // Break one EDGES array entry; the header stays valid so open succeeds
+    // and the damage surfaces on first access to the section.
+    metagraph_section_header_t sections[8];
+    METAGRAPH_TEST_ASSERT(header.section_count <= 8);
+    memcpy(sections, data + header.section_table_offset,
+           header.section_count * sizeof(sections[0]));
+    for (uint32_t i = 0; i < header.section_count; i++) {
+        if (sections[i].type == METAGRAPH_SECTION_EDGES) {
+            metagraph_bundle_edges_header_t edges;
+            memcpy(&edges, data + sections[i].offset, sizeof(edges));
+            const uint64_t offsets[] = {
+                [TEST_BUNDLE_BREAK_ROWS] = edges.out_rows_offset + 4U,
+                [TEST_BUNDLE_BREAK_MEMBERS] = edges.members_offset,
+                [TEST_BUNDLE_BREAK_OUT_EDGES] = edges.out_edges_offset,
+                [TEST_BUNDLE_BREAK_IN_EDGES] = edges.in_edges_offset,
+            };
+            const uint32_t bogus = 1000;
+            memcpy(data + sections[i].offset + offsets[target], &bogus,
+                   sizeof(bogus));
+        }
+    }
+
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    metagraph_node_metadata_t node = {0};
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, 0, &node));
+    size_t count = 0;
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_edge_count(bundle, &count),
+                          METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    const metagraph_edge_index_t *edges = NULL;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_get_outgoing_edges(bundle, 0, &edges, &count),
+        METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    free(data);
+}
+
+// An INDEX whose probes could never end must be refused: one with no
+// EMPTY control byte, or whose mirrored trailing group disagrees.
+static void test_bundle_index_corruption(bool break_mirror) {
+    size_t size = 0;
+    uint8_t *data = test_bundle_read_file(&size);
+    metagraph_bundle_header_t header;
+    memcpy(&header, data, sizeof(header));
+    for (uint32_t i = 0; i < header.section_count; i++) {
+        metagraph_section_header_t section;
+        uint8_t *entry = data + header.section_table_offset +
+                         i * sizeof(section);
+        memcpy(&section, entry, sizeof(section));
+        if (section.type == METAGRAPH_SECTION_LOOKUP) {
+            // Retype LOOKUP as unknown so lookups fall back to INDEX.
+            section.type = 0xFFFFU;
+            memcpy(entry, &section, sizeof(section));
+        } else if (section.type == METAGRAPH_SECTION_INDEX) {
+            metagraph_bundle_index_header_t index;
+            memcpy(&index, data + section.offset, sizeof(index));
+            uint8_t *ctrl = data + section.offset + index.ctrl_offset;
+            if (break_mirror) {
+                ctrl[index.capacity] ^= 0x01U;
+            } else {
+                memset(ctrl, 0x11, index.capacity + 16U);
+            }
+        }
+    }
+
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    metagraph_node_index_t found = 0;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_find_node(bundle, test_bundle_make_id(99), &found),
+        METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    const metagraph_id_t ids[] = {test_bundle_make_id(0),
+                                  test_bundle_make_id(99)};
+    metagraph_node_index_t indices[2];
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_find_nodes(bundle, ids, 2, indices, NULL),
+        METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    free(data);
+}
+
+static metagraph_section_header_t
+test_bundle_find_section(const uint8_t *data, uint32_t type) {
+    metagraph_bundle_header_t header;
+    memcpy(&header, data, sizeof(header));
+    metagraph_section_header_t section = {0};
+    for (uint32_t i = 0; i < header.section_count; i++) {
+        memcpy(&section, data + header.section_table_offset +
+                             i * sizeof(section),
+               sizeof(section));
+        if (section.type == type) {
+            return section;
+        }
+    }
+    METAGRAPH_TEST_ASSERT(false);
+    return section;
+}
+
+static void test_bundle_integrity_round_trip(void) {
+    test_bundle_write_sample();
+    const metagraph_bundle_options_t options = {
+        .flags = METAGRAPH_BUNDLE_OPEN_VERIFY};
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, &options, &bundle));
+
+    size_t count = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_node_count(bundle, &count));
+    METAGRAPH_TEST_OK(metagraph_bundle_edge_count(bundle, &count));
+    metagraph_node_metadata_t node = {0};
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, 1, &node));
+    metagraph_bundle_metadata_t metadata;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_metadata(bundle, &metadata));
+
+    const metagraph_bundle_header_t *header =
+        metagraph_bundle_get_header(bundle);
+    metagraph_blake3_hash_t pinned;
+    memcpy(pinned.bytes, header->integrity_hash, sizeof(pinned.bytes));
+    METAGRAPH_TEST_OK(metagraph_bundle_verify_integrity(bundle, NULL));
+    METAGRAPH_TEST_OK(metagraph_bundle_verify_integrity(bundle, &pinned));
+    pinned.bytes[0] ^= 1U;
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_verify_integrity(bundle, &pinned),
+                          METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+
+    // Section checksums are the low bits of each section's BLAKE3 hash.
+    const void *store = NULL;
+    size_t store_size = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_section(
+        bundle, METAGRAPH_SECTION_STORE, &store, &store_size));
+    metagraph_blake3_hash_t store_hash;
+    METAGRAPH_TEST_OK(metagraph_blake3_hash(store, store_size, &store_hash));
+    const metagraph_section_header_t *sections =
+        (const metagraph_section_header_t *)(const void *)((const uint8_t *)
+                                                               header +
+                                                           header->section_table_offset);
+    for (uint32_t i = 0; i < header->section_count; i++) {
+        if (sections[i].type == METAGRAPH_SECTION_STORE) {
+            uint64_t low = 0;
+            memcpy(&low, store_hash.bytes, sizeof(low));
+            METAGRAPH_TEST_ASSERT(sections[i].checksum == low);
+        }
+    }
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_verify_range(
+                              bundle, METAGRAPH_SECTION_STORE, store_size, 1),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+}
+
+#define TEST_BUNDLE_PAYLOAD_SIZE 3000U
+
+// Payloads larger than a 1 KiB Merkle leaf, so each node owns its leaves
+static void test_bundle_write_large_payloads(void) {
+    static uint8_t payloads[3][TEST_BUNDLE_PAYLOAD_SIZE];
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint64_t i = 0; i < 3; i++) {
+        memset(payloads[i], (int)('a' + i), sizeof(payloads[i]));
+        metagraph_node_metadata_t node = {.id = test_bundle_make_id(i),
+                                          .data = payloads[i],
+                                          .data_size = sizeof(payloads[i])};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    const metagraph_bundle_write_options_t options = {
+        .integrity_chunk_size = METAGRAPH_BLAKE3_CHUNK_LEN};
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, &options));
+
+    const metagraph_bundle_write_options_t bad_options = {
+        .integrity_chunk_size = 3000};
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, &bad_options),
+        METAGRAPH_ERROR_INVALID_SIZE);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static void test_bundle_integrity_detects_payload_corruption(void) {
+    test_bundle_write_large_payloads();
+    size_t size = 0;
+    uint8_t *data = test_bundle_read_file(&size);
+    const metagraph_section_header_t store =
+        test_bundle_find_section(data, METAGRAPH_SECTION_STORE);
+
+    // Flip a byte inside the last node's payload only.
+    data[store.offset + store.size - 10U] ^= 0x55U;
+
+    const metagraph_bundle_options_t verify = {
+        .flags = METAGRAPH_BUNDLE_OPEN_VERIFY};
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, &verify, &bundle));
+    metagraph_node_metadata_t node = {0};
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, 0, &node));
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, 1, &node));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_get_node(bundle, 2, &node),
+                          METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    METAGRAPH_TEST_OK(metagraph_bundle_verify_range(
+        bundle, METAGRAPH_SECTION_STORE, 0, TEST_BUNDLE_PAYLOAD_SIZE));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_verify_integrity(bundle, NULL),
+                          METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    // Without the flag reads are not hashed.
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, 2, &node));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_verify_range(
+                              bundle, METAGRAPH_SECTION_STORE,
+                              store.size - 10U, 1),
+                          METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    free(data);
+}
+
+static void test_bundle_integrity_detects_forgery(void) {
+    test_bundle_write_sample();
+    size_t size = 0;
+    uint8_t *data = test_bundle_read_file(&size);
+    const metagraph_bundle_options_t verify = {
+        .flags = METAGRAPH_BUNDLE_OPEN_VERIFY};
+    metagraph_bundle_t *bundle = NULL;
+
+    // A tampered NODES section fails when it is hydrated.
+    const metagraph_section_header_t nodes =
+        test_bundle_find_section(data, METAGRAPH_SECTION_NODES);
+    data[nodes.offset + offsetof(metagraph_bundle_node_record_t, type)] ^= 1U;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, &verify, &bundle));
+    size_t count = 0;
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_node_count(bundle, &count),
+                          METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_node_count(bundle, &count),
+                          METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    data[nodes.offset + offsetof(metagraph_bundle_node_record_t, type)] ^= 1U;
+
+    // Rewriting a leaf breaks the hash binding the INTEGRITY section.
+    const metagraph_section_header_t integrity =
+        test_bundle_find_section(data, METAGRAPH_SECTION_INTEGRITY);
+    data[integrity.offset + integrity.size - 1U] ^= 1U;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_create_from_memory(data, size, &verify, &bundle),
+        METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_verify_integrity(bundle, NULL),
+                          METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    data[integrity.offset + integrity.size - 1U] ^= 1U;
+
+    // Bundles without integrity data cannot be opened for verification.
+    metagraph_bundle_header_t header;
+    memcpy(&header, data, sizeof(header));
+    memset(header.integrity_hash, 0, sizeof(header.integrity_hash));
+    header.header_checksum = 0;
+    uint64_t checksum = 0xCBF29CE484222325ULL;
+    const uint8_t *bytes = (const uint8_t *)&header;
+    for (size_t i = 0; i < sizeof(header); i++) {
+        checksum = (checksum ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    header.header_checksum = checksum;
+    memcpy(data, &header, sizeof(header));
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_create_from_memory(data, size, &verify, &bundle),
+        METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_verify_integrity(bundle, NULL),
+                          METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    free(data);
+}
+
+// Names double as asset paths: lookups normalize, duplicates resolve to
+// the first node, and bundles without a LOOKUP section fall back to INDEX.
+// IDs 1..nodes map to indices 0..nodes-1; mix in unknown IDs.
+static void test_bundle_check_find_nodes(const metagraph_bundle_t *bundle,
+                                         uint64_t nodes) {
+    enum { TEST_BATCH = 250 };
+    metagraph_id_t ids[TEST_BATCH];
+    metagraph_node_index_t indices[TEST_BATCH];
+    for (uint64_t base = 0; base < nodes; base += TEST_BATCH / 2U) {
+        size_t expected = 0;
+        for (uint64_t i = 0; i < TEST_BATCH; i++) {
+            const uint64_t node = (base + i * 7U) % (nodes * 2U);
+            ids[i] = test_bundle_make_id(node + 1U);
+            expected += node < nodes;
+        }
+        size_t found = 0;
+        METAGRAPH_TEST_OK(metagraph_bundle_find_nodes(bundle, ids, TEST_BATCH,
+                                                      indices, &found));
+        METAGRAPH_TEST_ASSERT(found == expected);
+        for (uint64_t i = 0; i < TEST_BATCH; i++) {
+            const uint64_t node = (base + i * 7U) % (nodes * 2U);
+            const metagraph_node_index_t want =
+                node < nodes ? (uint32_t)node : METAGRAPH_INVALID_INDEX;
+            METAGRAPH_TEST_ASSERT(indices[i] == want);
+        }
+    }
+}
+
+static void test_bundle_path_lookup(void) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    static const char *const special[] = {
+        "assets//shared/./a.png", "assets/shared/a.png", "../outside.bin",
+        "/abs/root.txt", "textures/"};
+    enum { TEST_PATH_NODES = 600 };
+    char name[64];
+    for (uint64_t i = 0; i < TEST_PATH_NODES; i++) {
+        metagraph_node_metadata_t node = {.id = test_bundle_make_id(i + 1U)};
+        if (i < sizeof(special) / sizeof(special[0])) {
+            node.name = special[i];
+        } else if (i % 7U != 0) {
+            (void)snprintf(name, sizeof(name), "assets/level%u/mesh%u.bin",
+                           (unsigned)(i % 13U), (unsigned)i);
+            node.name = name;
+        }
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, NULL));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, NULL, &bundle));
+    metagraph_node_index_t index = METAGRAPH_INVALID_INDEX;
+    for (uint64_t i = 0; i < TEST_PATH_NODES; i++) {
+        METAGRAPH_TEST_OK(metagraph_bundle_find_node(
+            bundle, test_bundle_make_id(i + 1U), &index));
+        METAGRAPH_TEST_ASSERT(index == i);
+        if (i >= sizeof(special) / sizeof(special[0]) && i % 7U != 0) {
+            (void)snprintf(name, sizeof(name), "./assets/level%u//mesh%u.bin",
+                           (unsigned)(i % 13U), (unsigned)i);
+            METAGRAPH_TEST_OK(
+                metagraph_bundle_find_node_by_path(bundle, name, &index));
+            METAGRAPH_TEST_ASSERT(index == i);
+        }
+    }
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_find_node(
+                              bundle, test_bundle_make_id(9999), &index),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+    test_bundle_check_find_nodes(bundle, TEST_PATH_NODES);
+
+    METAGRAPH_TEST_OK(metagraph_bundle_find_node_by_path(
+        bundle, "assets/shared/a.png", &index));
+    METAGRAPH_TEST_ASSERT(index == 0);
+    METAGRAPH_TEST_OK(metagraph_bundle_find_node_by_path(
+        bundle, "assets/x/../shared/a.png/", &index));
+    METAGRAPH_TEST_ASSERT(index == 0);
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_find_node_by_path(bundle, "../outside.bin", &index));
+    METAGRAPH_TEST_ASSERT(index == 2);
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_find_node_by_path(bundle, "//abs/root.txt", &index));
+    METAGRAPH_TEST_ASSERT(index == 3);
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_find_node_by_path(bundle, "textures", &index));
+    METAGRAPH_TEST_ASSERT(index == 4);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_find_node_by_path(bundle, "abs/root.txt", &index),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_find_node_by_path(bundle, "assets/missing", &index),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    // Hide the LOOKUP section from the reader.
+    size_t size = 0;
+    uint8_t *data = test_bundle_read_file(&size);
+    metagraph_bundle_header_t header;
+    memcpy(&header, data, sizeof(header));
+    for (uint32_t i = 0; i < header.section_count; i++) {
+        uint8_t *entry = data + header.section_table_offset +
+                         i * sizeof(metagraph_section_header_t);
+        metagraph_section_header_t section;
+        memcpy(&section, entry, sizeof(section));
+        if (section.type == METAGRAPH_SECTION_LOOKUP) {
+            section.type = 0x7F;
+            memcpy(entry, &section, sizeof(section));
+        }
+    }
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_find_node(bundle, test_bundle_make_id(42), &index));
+    METAGRAPH_TEST_ASSERT(index == 41);
+    test_bundle_check_find_nodes(bundle, TEST_PATH_NODES);
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_find_node_by_path(
+                              bundle, "assets/shared/a.png", &index),
+                          METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    free(data);
+}
+
+#define TEST_BUNDLE_PACKED_NODES 24U
+#define TEST_BUNDLE_PACKED_BLOCK 4096U
+
+// Text-like payloads that span several 4 KiB blocks, plus one large enough to
+// be inflated on the worker pool
+static void test_bundle_packed_payload(uint64_t node, uint8_t *out,
+                                       size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        out[i] = (uint8_t)('a' + ((i / 7U) + node) % 23U);
+    }
+    if (size > 0) {
+        out[size / 2U] = (uint8_t)node;
+    }
+}
+
+static size_t test_bundle_packed_size(uint64_t node) {
+    return node == 5U ? 16U * TEST_BUNDLE_PACKED_BLOCK : 700U + node * 1100U;
+}
+
+static void test_bundle_write_packed(void) {
+    uint8_t *payloads[TEST_BUNDLE_PACKED_NODES];
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint64_t i = 0; i < TEST_BUNDLE_PACKED_NODES; i++) {
+        const size_t size = test_bundle_packed_size(i);
+        uint8_t *payload = malloc(size);
+        METAGRAPH_TEST_ASSERT(payload != NULL);
+        test_bundle_packed_payload(i, payload, size);
+        payloads[i] = payload;
+        char name[32];
+        (void)snprintf(name, sizeof(name), "packed/%02u.bin", (unsigned)i);
+        metagraph_node_metadata_t node = {.id = test_bundle_make_id(i),
+                                          .name = name,
+                                          .data = payload,
+                                          .data_size = size};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    const metagraph_bundle_write_options_t options = {
+        .integrity_chunk_size = METAGRAPH_BLAKE3_CHUNK_LEN,
+        .compression = METAGRAPH_COMPRESSION_LZ,
+        .compression_block_size = TEST_BUNDLE_PACKED_BLOCK};
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, &options));
+
+    metagraph_bundle_write_options_t bad_options = options;
+    bad_options.compression = 7U;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, &bad_options),
+        METAGRAPH_ERROR_INVALID_ARGUMENT);
+    bad_options = options;
+    bad_options.compression_block_size = 1000U;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, &bad_options),
+        METAGRAPH_ERROR_INVALID_SIZE);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+    for (uint64_t i = 0; i < TEST_BUNDLE_PACKED_NODES; i++) {
+        free(payloads[i]);
+    }
+}
+
+static void test_bundle_check_packed_nodes(metagraph_bundle_t *bundle) {
+    uint8_t *expected = malloc(16U * TEST_BUNDLE_PACKED_BLOCK);
+    METAGRAPH_TEST_ASSERT(expected != NULL);
+    for (uint64_t i = 0; i < TEST_BUNDLE_PACKED_NODES; i++) {
+        metagraph_node_metadata_t node = {0};
+        METAGRAPH_TEST_OK(
+            metagraph_bundle_get_node(bundle, (uint32_t)i, &node));
+        const size_t size = test_bundle_packed_size(i);
+        test_bundle_packed_payload(i, expected, size);
+        METAGRAPH_TEST_ASSERT(node.data_size == size);
+        METAGRAPH_TEST_ASSERT(memcmp(node.data, expected, size) == 0);
+        METAGRAPH_TEST_ASSERT(((uintptr_t)node.data % 16U) == 0);
+        char name[32];
+        (void)snprintf(name, sizeof(name), "packed/%02u.bin", (unsigned)i);
+        METAGRAPH_TEST_ASSERT(strcmp(node.name, name) == 0);
+    }
+    free(expected);
+}
+
+static void test_bundle_compressed_store(void) {
+    METAGRAPH_TEST_ASSERT(metagraph_feature_available("compression_v2") == 1);
+    test_bundle_write_packed();
+
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, NULL, &bundle));
+    const metagraph_bundle_header_t *header =
+        metagraph_bundle_get_header(bundle);
+    METAGRAPH_TEST_ASSERT((header->flags & METAGRAPH_BUNDLE_FLAG_COMPRESSED) !=
+                          0);
+    metagraph_bundle_metadata_t metadata;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_metadata(bundle, &metadata));
+    METAGRAPH_TEST_ASSERT(metadata.compression_type ==
+                          METAGRAPH_COMPRESSION_LZ);
+    const void *store = NULL;
+    size_t store_size = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_section(
+        bundle, METAGRAPH_SECTION_STORE, &store, &store_size));
+    size_t raw_size = 0;
+    for (uint64_t i = 0; i < TEST_BUNDLE_PACKED_NODES; i++) {
+        raw_size += test_bundle_packed_size(i);
+    }
+    METAGRAPH_TEST_ASSERT(store_size < raw_size / 2U);
+
+    // Prefetching a few nodes, then all of them, is idempotent.
+    const metagraph_node_index_t wanted[] = {7, 5, 7, 2};
+    METAGRAPH_TEST_OK(metagraph_bundle_prefetch_nodes(bundle, wanted, 4, 4));
+    const metagraph_node_index_t unknown = TEST_BUNDLE_PACKED_NODES;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_prefetch_nodes(bundle, &unknown, 1, 1),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+    test_bundle_check_packed_nodes(bundle);
+    METAGRAPH_TEST_OK(metagraph_bundle_prefetch_nodes(bundle, NULL, 0, 4));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    // Verified opens hash the packed blocks before decoding them.
+    const metagraph_bundle_options_t verify = {
+        .flags = METAGRAPH_BUNDLE_OPEN_VERIFY};
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, &verify, &bundle));
+    METAGRAPH_TEST_OK(metagraph_bundle_prefetch_nodes(bundle, NULL, 0, 4));
+    test_bundle_check_packed_nodes(bundle);
+    METAGRAPH_TEST_OK(metagraph_bundle_verify_integrity(bundle, NULL));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+}
+
+static void test_bundle_compressed_corruption(void) {
+    test_bundle_write_packed();
+    size_t size = 0;
+    uint8_t *data = test_bundle_read_file(&size);
+    const metagraph_section_header_t store =
+        test_bundle_find_section(data, METAGRAPH_SECTION_STORE);
+    METAGRAPH_TEST_ASSERT((store.flags & METAGRAPH_SECTION_FLAG_COMPRESSED) !=
+                          0);
+    metagraph_bundle_compression_header_t packed;
+    memcpy(&packed, data + store.offset, sizeof(packed));
+    METAGRAPH_TEST_ASSERT(packed.codec == METAGRAPH_COMPRESSION_LZ);
+    METAGRAPH_TEST_ASSERT(packed.block_log2 == 12U);
+    METAGRAPH_TEST_ASSERT(packed.block_count ==
+                          (packed.raw_size + TEST_BUNDLE_PACKED_BLOCK - 1U) /
+                              TEST_BUNDLE_PACKED_BLOCK);
+    uint64_t seek[2];
+    memcpy(seek, data + store.offset + packed.seek_offset, sizeof(seek));
+    METAGRAPH_TEST_ASSERT(seek[1] - seek[0] < TEST_BUNDLE_PACKED_BLOCK);
+
+    // A block of runaway literal lengths cannot decode.
+    memset(data + store.offset + seek[0], 0xFF, seek[1] - seek[0]);
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    metagraph_node_metadata_t node = {0};
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_get_node(bundle, 0, &node),
+                          METAGRAPH_ERROR_COMPRESSION_FAILED);
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_get_node(bundle, 0, &node),
+                          METAGRAPH_ERROR_COMPRESSION_FAILED);
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, 9, &node));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    // With VERIFY the same damage is a checksum mismatch.
+    const metagraph_bundle_options_t verify = {
+        .flags = METAGRAPH_BUNDLE_OPEN_VERIFY};
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, &verify, &bundle));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_get_node(bundle, 0, &node),
+                          METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    // An unknown codec fails when the STORE is first hydrated.
+    packed.codec = 9U;
+    memcpy(data + store.offset, &packed, sizeof(packed));
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_get_node(bundle, 9, &node),
+                          METAGRAPH_ERROR_COMPRESSION_FAILED);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    free(data);
+}
+
+#define TEST_BUNDLE_TARGET_PATH "bundle_test_target.mgb"
+#define TEST_BUNDLE_DELTA_PATH "bundle_test_delta.mgb"
+#define TEST_BUNDLE_CHAIN_PATH "bundle_test_chain.mgb"
+
+// The sample with a new texture payload. Restructuring also renames the
+// shader, appends a mesh and links it to the first mesh.
+static void test_bundle_write_revision(const char *path, bool restructure,
+                                       const char *texture) {
+    static char shader[] = "shader-source";
+    static char cube[] = "cube-vertices";
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+
+    const char *names[] = {"materials/base.mat", "textures/diffuse.png",
+                           restructure ? "shaders/unlit.glsl"
+                                       : "shaders/lit.glsl",
+                           NULL, "meshes/cube.mesh"};
+    const uint64_t node_count = restructure ? 5U : 4U;
+    for (uint64_t i = 0; i < node_count; i++) {
+        metagraph_node_metadata_t node = {.id = test_bundle_make_id(i),
+                                          .name = names[i],
+                                          .type = (uint32_t)i,
+                                          .hash = 0x1000U + i};
+        if (i == 1) {
+            node.data = (void *)(uintptr_t)texture;
+            node.data_size = strlen(texture) + 1U;
+        } else if (i == 2) {
+            node.data = shader;
+            node.data_size = sizeof(shader);
+        } else if (i == 4) {
+            node.data = cube;
+            node.data_size = sizeof(cube);
+        }
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+
+    const metagraph_id_t first_nodes[] = {test_bundle_make_id(0),
+                                          test_bundle_make_id(1),
+                                          test_bundle_make_id(2)};
+    metagraph_edge_metadata_t first = {.id = test_bundle_make_id(100),
+                                       .type = 1,
+                                       .weight = 2.5F,
+                                       .node_count = 3,
+                                       .nodes = first_nodes};
+    METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &first, NULL));
+    const metagraph_id_t second_nodes[] = {test_bundle_make_id(3),
+                                           test_bundle_make_id(0)};
+    metagraph_edge_metadata_t second = {.id = test_bundle_make_id(101),
+                                        .node_count = 2,
+                                        .nodes = second_nodes};
+    METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &second, NULL));
+    if (restructure) {
+        const metagraph_id_t third_nodes[] = {test_bundle_make_id(4),
+                                              test_bundle_make_id(3)};
+        metagraph_edge_metadata_t third = {.id = test_bundle_make_id(102),
+                                           .node_count = 2,
+                                           .nodes = third_nodes};
+        METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &third, NULL));
+    }
+
+    const metagraph_bundle_write_options_t options = {
+        .creation_time = 1700000100U,
+        .bundle_id = 78,
+        .creator = "bundle_test",
+        .description = "revised assets",
+    };
+    METAGRAPH_TEST_OK(metagraph_bundle_write_graph(graph, path, &options));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+// Every node, lookup and adjacency list of actual matches expected.
+static void test_bundle_check_same(const metagraph_bundle_t *actual,
+                                   const metagraph_bundle_t *expected) {
+    size_t count = 0;
+    size_t expected_count = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_node_count(actual, &count));
+    METAGRAPH_TEST_OK(metagraph_bundle_node_count(expected, &expected_count));
+    METAGRAPH_TEST_ASSERT(count == expected_count);
+    METAGRAPH_TEST_OK(metagraph_bundle_edge_count(actual, &count));
+    METAGRAPH_TEST_OK(metagraph_bundle_edge_count(expected, &expected_count));
+    METAGRAPH_TEST_ASSERT(count == expected_count);
+    METAGRAPH_TEST_OK(metagraph_bundle_node_count(actual, &count));
+
+    for (uint32_t i = 0; i < count; i++) {
+        metagraph_node_metadata_t node = {0};
+        metagraph_node_metadata_t want = {0};
+        METAGRAPH_TEST_OK(metagraph_bundle_get_node(actual, i, &node));
+        METAGRAPH_TEST_OK(metagraph_bundle_get_node(expected, i, &want));
+        METAGRAPH_TEST_ASSERT(node.id.high == want.id.high &&
+                              node.id.low == want.id.low);
+        METAGRAPH_TEST_ASSERT(node.type == want.type);
+        METAGRAPH_TEST_ASSERT(node.hash == want.hash);
+        METAGRAPH_TEST_ASSERT(node.data_size == want.data_size);
+        METAGRAPH_TEST_ASSERT(
+            want.data_size == 0 ||
+            memcmp(node.data, want.data, want.data_size) == 0);
+        METAGRAPH_TEST_ASSERT((node.name == NULL) == (want.name == NULL));
+
+        metagraph_node_index_t index = UINT32_MAX;
+        METAGRAPH_TEST_OK(metagraph_bundle_find_node(actual, want.id, &index));
+        METAGRAPH_TEST_ASSERT(index == i);
+        if (want.name) {
+            METAGRAPH_TEST_ASSERT(strcmp(node.name, want.name) == 0);
+            METAGRAPH_TEST_OK(
+                metagraph_bundle_find_node_by_path(actual, want.name, &index));
+            METAGRAPH_TEST_ASSERT(index == i);
+        }
+
+        const metagraph_edge_index_t *edges = NULL;
+        const metagraph_edge_index_t *want_edges = NULL;
+        size_t edge_count = 0;
+        size_t want_count = 0;
+        METAGRAPH_TEST_OK(metagraph_bundle_get_outgoing_edges(actual, i, &edges,
+                                                              &edge_count));
+        METAGRAPH_TEST_OK(metagraph_bundle_get_outgoing_edges(
+            expected, i, &want_edges, &want_count));
+        METAGRAPH_TEST_ASSERT(edge_count == want_count);
+        METAGRAPH_TEST_ASSERT(
+            memcmp(edges, want_edges, want_count * sizeof(*edges)) == 0);
+        METAGRAPH_TEST_OK(metagraph_bundle_get_incoming_edges(actual, i, &edges,
+                                                              &edge_count));
+        METAGRAPH_TEST_OK(metagraph_bundle_get_incoming_edges(
+            expected, i, &want_edges, &want_count));
+        METAGRAPH_TEST_ASSERT(edge_count == want_count);
+        METAGRAPH_TEST_ASSERT(
+            memcmp(edges, want_edges, want_count * sizeof(*edges)) == 0);
+    }
+}
+
+static metagraph_bundle_delta_header_t
+test_bundle_delta_header(const metagraph_bundle_t *delta) {
+    const void *data = NULL;
+    size_t size = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_section(
+        delta, METAGRAPH_SECTION_DELTA, &data, &size));
+    metagraph_bundle_delta_header_t header;
+    METAGRAPH_TEST_ASSERT(size >= sizeof(header));
+    memcpy(&header, data, sizeof(header));
+    return header;
+}
+
+static void test_bundle_delta_round_trip(void) {
+    METAGRAPH_TEST_ASSERT(metagraph_feature_available("delta_patches") == 1);
+    test_bundle_write_sample();
+    test_bundle_write_revision(TEST_BUNDLE_TARGET_PATH, true,
+                               "texture-bytes-v2");
+
+    metagraph_bundle_t *base = NULL;
+    metagraph_bundle_t *target = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, NULL, &base));
+    METAGRAPH_TEST_OK(metagraph_bundle_create_from_file(TEST_BUNDLE_TARGET_PATH,
+                                                        NULL, &target));
+    METAGRAPH_TEST_OK(metagraph_bundle_write_delta(
+        base, target, TEST_BUNDLE_DELTA_PATH, NULL));
+
+    metagraph_bundle_t *delta = NULL;
+    METAGRAPH_TEST_OK(metagraph_bundle_create_from_file(TEST_BUNDLE_DELTA_PATH,
+                                                        NULL, &delta));
+    const metagraph_bundle_header_t *header =
+        metagraph_bundle_get_header(delta);
+    METAGRAPH_TEST_ASSERT((header->flags & METAGRAPH_BUNDLE_FLAG_DELTA) != 0);
+    METAGRAPH_TEST_ASSERT(header->delta_base_id == 77U);
+    metagraph_bundle_metadata_t metadata;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_metadata(delta, &metadata));
+    METAGRAPH_TEST_ASSERT(strcmp(metadata.description, "revised assets") == 0);
+
+    // Edges changed, so the tables are the target's; only the new texture,
+    // the new name and the appended mesh are stored.
+    const metagraph_bundle_delta_header_t patches =
+        test_bundle_delta_header(delta);
+    METAGRAPH_TEST_ASSERT(patches.inherited_sections == 0);
+    METAGRAPH_TEST_ASSERT(patches.base_node_count == 4U);
+    METAGRAPH_TEST_ASSERT(patches.node_count == 5U);
+    METAGRAPH_TEST_ASSERT(patches.patch_count == 3U);
+    const void *store = NULL;
+    size_t store_size = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_section(
+        delta, METAGRAPH_SECTION_STORE, &store, &store_size));
+    METAGRAPH_TEST_ASSERT(store_size < 128U);
+
+    size_t count = 0;
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_node_count(delta, &count),
+                          METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_apply_delta(delta, target),
+                          METAGRAPH_ERROR_BUNDLE_VERSION_MISMATCH);
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_apply_delta(base, delta),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+
+    // The delta owns the base it is applied to.
+    const metagraph_bundle_options_t verify = {
+        .flags = METAGRAPH_BUNDLE_OPEN_VERIFY};
+    metagraph_bundle_t *owned = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, &verify, &owned));
+    METAGRAPH_TEST_OK(metagraph_bundle_apply_delta(delta, owned));
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_apply_delta(delta, base),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+    test_bundle_check_same(delta, target);
+    METAGRAPH_TEST_OK(metagraph_bundle_verify_integrity(delta, NULL));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(delta));
+
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(base));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(target));
+}
+
+static void test_bundle_delta_inherits_sections(void) {
+    test_bundle_write_sample();
+    test_bundle_write_revision(TEST_BUNDLE_TARGET_PATH, false, "texture-v2");
+
+    metagraph_bundle_t *base = NULL;
+    metagraph_bundle_t *target = NULL;
+    metagraph_bundle_t *delta = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, NULL, &base));
+    METAGRAPH_TEST_OK(metagraph_bundle_create_from_file(TEST_BUNDLE_TARGET_PATH,
+                                                        NULL, &target));
+    METAGRAPH_TEST_OK(metagraph_bundle_write_delta(
+        base, target, TEST_BUNDLE_DELTA_PATH, NULL));
+    METAGRAPH_TEST_OK(metagraph_bundle_create_from_file(TEST_BUNDLE_DELTA_PATH,
+                                                        NULL, &delta));
+    const metagraph_bundle_delta_header_t patches =
+        test_bundle_delta_header(delta);
+    METAGRAPH_TEST_ASSERT(patches.inherited_sections ==
+                          ((1U << METAGRAPH_SECTION_INDEX) |
+                           (1U << METAGRAPH_SECTION_EDGES) |
+                           (1U << METAGRAPH_SECTION_LOOKUP)));
+    METAGRAPH_TEST_ASSERT(patches.patch_count == 1U);
+    METAGRAPH_TEST_ASSERT(metagraph_bundle_get_header(delta)->section_count ==
+                          4U);
+    METAGRAPH_TEST_OK(metagraph_bundle_apply_delta(delta, base));
+    test_bundle_check_same(delta, target);
+
+    // A compressed delta on top of the patched bundle forms a chain.
+    test_bundle_write_revision(TEST_BUNDLE_TARGET_PATH, true, "texture-v3");
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(target));
+    METAGRAPH_TEST_OK(metagraph_bundle_create_from_file(TEST_BUNDLE_TARGET_PATH,
+                                                        NULL, &target));
+    const metagraph_bundle_write_options_t packed = {
+        .compression = METAGRAPH_COMPRESSION_LZ};
+    METAGRAPH_TEST_OK(metagraph_bundle_write_delta(
+        delta, target, TEST_BUNDLE_CHAIN_PATH, &packed));
+    metagraph_bundle_t *chain = NULL;
+    METAGRAPH_TEST_OK(metagraph_bundle_create_from_file(TEST_BUNDLE_CHAIN_PATH,
+                                                        NULL, &chain));
+    METAGRAPH_TEST_OK(metagraph_bundle_apply_delta(chain, delta));
+    METAGRAPH_TEST_OK(metagraph_bundle_prefetch_nodes(chain, NULL, 0, 2));
+    test_bundle_check_same(chain, target);
+    METAGRAPH_TEST_OK(metagraph_bundle_verify_integrity(chain, NULL));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(chain));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(target));
+}
+
+static void test_bundle_prefetch_sections(void) {
+    test_bundle_write_sample();
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, NULL, &bundle));
+    const metagraph_memory_map_t *map = metagraph_bundle_get_map(bundle);
+
+    // Whichever backend the kernel allows; one page per read and a shallow
+    // queue so slots are refilled
+    const metagraph_read_ahead_options_t small = {.queue_depth = 2,
+                                                  .chunk_size = 1};
+    metagraph_read_ahead_stats_t stats;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_prefetch_sections(bundle, NULL, 0, &small, &stats));
+    METAGRAPH_TEST_ASSERT(stats.backend != METAGRAPH_READ_AHEAD_NONE);
+    METAGRAPH_TEST_ASSERT(stats.bytes_read > 0U);
+    METAGRAPH_TEST_ASSERT(stats.bytes_read <= map->file_size);
+    METAGRAPH_TEST_ASSERT(stats.reads >= stats.bytes_read / 4096U);
+    const uint64_t all_bytes = stats.bytes_read;
+
+    // The pread team reads the same pages
+    const metagraph_read_ahead_options_t threaded = {
+        .flags = METAGRAPH_READ_AHEAD_NO_URING,
+        .chunk_size = 4096,
+        .thread_count = 3,
+    };
+    METAGRAPH_TEST_OK(metagraph_bundle_prefetch_sections(bundle, NULL, 0,
+                                                         &threaded, &stats));
+    METAGRAPH_TEST_ASSERT(stats.backend == METAGRAPH_READ_AHEAD_PREAD);
+    METAGRAPH_TEST_ASSERT(stats.bytes_read == all_bytes);
+
+    const metagraph_section_type_t store = METAGRAPH_SECTION_STORE;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_prefetch_sections(bundle, &store, 1, NULL, &stats));
+    METAGRAPH_TEST_ASSERT(stats.bytes_read > 0U &&
+                          stats.bytes_read < all_bytes);
+    const metagraph_section_type_t unknown = METAGRAPH_SECTION_TYPE_COUNT;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_prefetch_sections(bundle, &unknown, 1, NULL, NULL),
+        METAGRAPH_ERROR_INVALID_ARGUMENT);
+
+    // Reads stay inside the mapping
+    const metagraph_map_range_t outside = {map->mapped_size, 1};
+    METAGRAPH_TEST_EXPECT(
+        metagraph_mmap_read_ahead(map, &outside, 1, NULL, NULL),
+        METAGRAPH_ERROR_INVALID_SIZE);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    // A bundle in memory has nothing to read
+    size_t size = 0;
+    uint8_t *data = test_bundle_read_file(&size);
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_memory(data, size, NULL, &bundle));
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_prefetch_sections(bundle, NULL, 0, NULL, &stats));
+    METAGRAPH_TEST_ASSERT(stats.backend == METAGRAPH_READ_AHEAD_NONE);
+    METAGRAPH_TEST_ASSERT(stats.bytes_read == 0U);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    free(data);
+}
+
+#define TEST_BUNDLE_GRID 48U
+
+// A grid whose cells each depend on their right and lower neighbours,
+// added in a scrambled order so insertion order has no locality.
+static metagraph_graph_t *test_bundle_make_grid(uint32_t *payloads) {
+    const uint32_t cells = TEST_BUNDLE_GRID * TEST_BUNDLE_GRID;
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint32_t i = 0; i < cells; i++) {
+        // 1031 is coprime with the cell count, so this visits every cell.
+        const uint32_t cell = (i * 1031U) % cells;
+        payloads[cell] = cell * 3U + 1U;
+        const metagraph_node_metadata_t node = {
+            .id = test_bundle_make_id(1000U + cell),
+            .data = &payloads[cell],
+            .data_size = sizeof(payloads[cell]),
+        };
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    for (uint32_t i = 0; i < cells; i++) {
+        const uint32_t cell = (i * 613U) % cells;
+        const uint32_t row = cell / TEST_BUNDLE_GRID;
+        const uint32_t column = cell % TEST_BUNDLE_GRID;
+        metagraph_id_t members[3] = {test_bundle_make_id(1000U + cell)};
+        size_t count = 1;
+        if (column + 1U < TEST_BUNDLE_GRID) {
+            members[count++] = test_bundle_make_id(1000U + cell + 1U);
+        }
+        if (row + 1U < TEST_BUNDLE_GRID) {
+            members[count++] =
+                test_bundle_make_id(1000U + cell + TEST_BUNDLE_GRID);
+        }
+        if (count < 2) {
+            continue;
+        }
+        const metagraph_edge_metadata_t edge = {
+            .id = test_bundle_make_id(cell + 1U),
+            .weight = 1.0F,
+            .node_count = count,
+            .nodes = members,
+        };
+        METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edge, NULL));
+    }
+    return graph;
+}
+
+// The reordered bundle holds the same nodes and edges, looked up by ID.
+static void test_bundle_check_reordered(const metagraph_graph_t *graph) {
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_BUNDLE_PATH, NULL, &bundle));
+    for (uint32_t cell = 0; cell < TEST_BUNDLE_GRID * TEST_BUNDLE_GRID;
+         cell++) {
+        metagraph_node_index_t node = 0;
+        metagraph_node_metadata_t metadata;
+        METAGRAPH_TEST_OK(metagraph_bundle_find_node(
+            bundle, test_bundle_make_id(1000U + cell), &node));
+        METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, node, &metadata));
+        uint32_t payload = 0;
+        memcpy(&payload, metadata.data, sizeof(payload));
+        METAGRAPH_TEST_ASSERT(payload == cell * 3U + 1U);
+    }
+    size_t edge_count = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_edge_count(bundle, &edge_count));
+    METAGRAPH_TEST_ASSERT(edge_count == metagraph_graph_edge_count(graph));
+    metagraph_node_index_t previous_source = 0;
+    for (uint32_t i = 0; i < edge_count; i++) {
+        metagraph_edge_metadata_t edge;
+        const metagraph_node_index_t *members = NULL;
+        size_t count = 0;
+        METAGRAPH_TEST_OK(metagraph_bundle_get_edge(bundle, i, &edge));
+        METAGRAPH_TEST_OK(
+            metagraph_bundle_get_edge_nodes(bundle, i, &members, &count));
+        // Edges follow their sources' new order.
+        METAGRAPH_TEST_ASSERT(members[0] >= previous_source);
+        previous_source = members[0];
+
+        metagraph_edge_index_t original = 0;
+        const metagraph_node_index_t *graph_members = NULL;
+        size_t graph_count = 0;
+        METAGRAPH_TEST_OK(metagraph_graph_find_edge(graph, edge.id, &original));
+        METAGRAPH_TEST_OK(metagraph_graph_get_edge_nodes(
+            graph, original, &graph_members, &graph_count));
+        METAGRAPH_TEST_ASSERT(count == graph_count);
+        for (size_t m = 0; m < count; m++) {
+            metagraph_node_metadata_t written;
+            metagraph_node_metadata_t expected;
+            METAGRAPH_TEST_OK(
+                metagraph_bundle_get_node(bundle, members[m], &written));
+            METAGRAPH_TEST_OK(
+                metagraph_graph_get_node(graph, graph_members[m], &expected));
+            METAGRAPH_TEST_ASSERT(metagraph_id_equal(written.id, expected.id));
+        }
+    }
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+}
+
+static void test_bundle_reorder_nodes(void) {
+    uint32_t *payloads =
+        malloc(TEST_BUNDLE_GRID * TEST_BUNDLE_GRID * sizeof(*payloads));
+    METAGRAPH_TEST_ASSERT(payloads != NULL);
+    metagraph_graph_t *graph = test_bundle_make_grid(payloads);
+
+    const metagraph_reorder_t methods[] = {
+        METAGRAPH_REORDER_BFS, METAGRAPH_REORDER_RCM, METAGRAPH_REORDER_GORDER};
+    for (size_t i = 0; i < 3; i++) {
+        metagraph_reorder_report_t report;
+        const metagraph_bundle_write_options_t options = {
+            .reorder = methods[i],
+            .reorder_report = &report,
+        };
+        METAGRAPH_TEST_OK(
+            metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, &options));
+        METAGRAPH_TEST_ASSERT(report.after.average_edge_span * 4.0 <
+                              report.before.average_edge_span);
+        METAGRAPH_TEST_ASSERT(report.after.page_touches <
+                              report.before.page_touches);
+        METAGRAPH_TEST_ASSERT(report.after.max_edge_span <=
+                              report.before.max_edge_span);
+        test_bundle_check_reordered(graph);
+    }
+
+    // Without a method the report describes graph order on both sides.
+    metagraph_reorder_report_t report;
+    const metagraph_bundle_write_options_t plain = {.reorder_report = &report};
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, &plain));
+    METAGRAPH_TEST_ASSERT(report.before.max_edge_span ==
+                          report.after.max_edge_span);
+    METAGRAPH_TEST_ASSERT(report.before.max_edge_span > 0);
+
+    const metagraph_bundle_write_options_t unknown = {.reorder = 99};
+    METAGRAPH_TEST_EXPECT(
+        metagraph_bundle_write_graph(graph, TEST_BUNDLE_PATH, &unknown),
+        METAGRAPH_ERROR_INVALID_ARGUMENT);
+    const metagraph_bundle_builder_config_t config = {
+        .write = {.reorder = METAGRAPH_REORDER_RCM}};
+    metagraph_bundle_builder_t *builder = NULL;
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_builder_create(&config, &builder),
+                          METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+    METAGRAPH_TEST_ASSERT(builder == NULL);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+    free(payloads);
+}
+
+static void test_bundle_missing_file(void) {
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_EXPECT(metagraph_bundle_create_from_file(
+                              "does-not-exist.mgb", NULL, &bundle),
+                          METAGRAPH_ERROR_FILE_NOT_FOUND);
+    METAGRAPH_TEST_ASSERT(bundle == NULL);
+}
+
+int main(void) {
+    test_bundle_round_trip();
+    test_bundle_zero_copy_adjacency();
+    test_bundle_rejects_corruption();
+    test_bundle_lazy_section_corruption(TEST_BUNDLE_BREAK_ROWS);
+    test_bundle_lazy_section_corruption(TEST_BUNDLE_BREAK_MEMBERS);
+    test_bundle_lazy_section_corruption(TEST_BUNDLE_BREAK_OUT_EDGES);
+    test_bundle_lazy_section_corruption(TEST_BUNDLE_BREAK_IN_EDGES);
+    test_bundle_index_corruption(false);
+    test_bundle_index_corruption(true);
+    test_bundle_integrity_round_trip();
+    test_bundle_integrity_detects_payload_corruption();
+    test_bundle_integrity_detects_forgery();
+    test_bundle_path_lookup();
+    test_bundle_compressed_store();
+    test_bundle_compressed_corruption();
+    test_bundle_delta_round_trip();
+    test_bundle_delta_inherits_sections();
+    test_bundle_prefetch_sections();
+    test_bundle_reorder_nodes();
+    test_bundle_missing_file();
+    (void)remove(TEST_BUNDLE_PATH);
+    (void)remove(TEST_BUNDLE_TARGET_PATH);
+    (void)remove(TEST_BUNDLE_DELTA_PATH);
+    (void)remove(TEST_BUNDLE_CHAIN_PATH);
+    return 0;
+}
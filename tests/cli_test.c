@@ -0,0 +1,205 @@
+/*
+ * mg-cli end-to-end tests: run the built tool against a small bundle
+ *
+ * The path to the mg-cli executable is the first argument.
+ */
+
+#define _POSIX_C_SOURCE 200809L // popen
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#else
+#include <sys/wait.h>
+#endif
+
+#define TEST_CLI_PATH "cli_test.mgb"
+#define TEST_CLI_CORRUPT_PATH "cli_test_corrupt.mgb"
+#define TEST_CLI_OUTPUT 16384U
+
+static const char *test_cli_tool;
+
+static metagraph_id_t test_cli_id(uint64_t value) {
+    return (metagraph_id_t){.high = 0x434C49ULL, .low = value};
+}
+
+// material(0) <- {texture(1), shader(2)}, mesh(3) <- {material(0)}
+static void test_cli_write_bundle(void) {
+    static char texture[] = "texture-bytes";
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    const char *names[] = {"materials/base.mat", "textures/diffuse.png",
+                           "shaders/lit.glsl", "meshes/crate.mesh"};
+    for (uint64_t i = 0; i < 4; i++) {
+        metagraph_node_metadata_t node = {.id = test_cli_id(i),
+                                          .name = names[i],
+                                          .type = (uint32_t)i};
+        if (i == 1) {
+            node.data = texture;
+            node.data_size = sizeof(texture);
+        }
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    const metagraph_id_t material[] = {test_cli_id(0), test_cli_id(1),
+                                       test_cli_id(2)};
+    const metagraph_id_t mesh[] = {test_cli_id(3), test_cli_id(0)};
+    const metagraph_edge_metadata_t edges[] = {
+        {.id = test_cli_id(100), .node_count = 3, .nodes = material},
+        {.id = test_cli_id(101), .node_count = 2, .nodes = mesh},
+    };
+    for (size_t i = 0; i < 2U; i++) {
+        METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edges[i], NULL));
+    }
+    METAGRAPH_TEST_OK(metagraph_bundle_write_graph(graph, TEST_CLI_PATH, NULL));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+// Run mg-cli with arguments, capturing stdout and stderr; returns the
+// exit status.
+static int test_cli_run(const char *arguments, char *output) {
+    char command[1024];
+    METAGRAPH_TEST_ASSERT(snprintf(command, sizeof(command),
+                                   "\"%s\" %s 2>&1", test_cli_tool,
+                                   arguments) < (int)sizeof(command));
+    FILE *pipe = popen(command, "r");
+    METAGRAPH_TEST_ASSERT(pipe != NULL);
+    const size_t length = fread(output, 1, TEST_CLI_OUTPUT - 1U, pipe);
+    output[length] = '\0';
+    const int status = pclose(pipe);
+#if defined(_WIN32)
+    return status;
+#else
+    METAGRAPH_TEST_ASSERT(WIFEXITED(status));
+    return WEXITSTATUS(status);
+#endif
+}
+
+// Run a command that must exit with status and print every line in
+// expected (NULL-terminated).
+static void test_cli_expect(const char *arguments, int status,
+                            const char *const *expected) {
+    static char output[TEST_CLI_OUTPUT];
+    const int actual = test_cli_run(arguments, output);
+    if (actual != status) {
+        (void)fprintf(stderr, "mg-cli %s exited %d, expected %d:\n%s\n",
+                      arguments, actual, status, output);
+        METAGRAPH_TEST_ASSERT(actual == status);
+    }
+    for (size_t i = 0; expected[i]; i++) {
+        if (!strstr(output, expected[i])) {
+            (void)fprintf(stderr, "mg-cli %s printed no \"%s\":\n%s\n",
+                          arguments, expected[i], output);
+            METAGRAPH_TEST_ASSERT(false);
+        }
+    }
+}
+
+static void test_cli_stat_and_ls(void) {
+    test_cli_expect("stat " TEST_CLI_PATH, 0,
+                    (const char *const[]){"Nodes:        4",
+                                          "Edges:        2", "NODES",
+                                          "EDGES", NULL});
+    test_cli_expect("ls " TEST_CLI_PATH, 0,
+                    (const char *const[]){"materials/base.mat",
+                                          "textures/diffuse.png",
+                                          "shaders/lit.glsl",
+                                          "meshes/crate.mesh", NULL});
+
+    // Filters: only the shader has type 2.
+    static char output[TEST_CLI_OUTPUT];
+    METAGRAPH_TEST_ASSERT(test_cli_run("ls --type 2 " TEST_CLI_PATH,
+                                       output) == 0);
+    METAGRAPH_TEST_ASSERT(strstr(output, "shaders/lit.glsl") != NULL);
+    METAGRAPH_TEST_ASSERT(strstr(output, "materials/base.mat") == NULL);
+    METAGRAPH_TEST_ASSERT(test_cli_run("ls --limit 1 " TEST_CLI_PATH,
+                                       output) == 0);
+    METAGRAPH_TEST_ASSERT(strchr(output, '\n') == output + strlen(output) - 1U);
+}
+
+static void test_cli_deps(void) {
+    test_cli_expect("deps " TEST_CLI_PATH " materials/base.mat", 0,
+                    (const char *const[]){"textures/diffuse.png",
+                                          "shaders/lit.glsl",
+                                          "2 dependencies", NULL});
+    test_cli_expect("deps --transitive " TEST_CLI_PATH " meshes/crate.mesh", 0,
+                    (const char *const[]){"  1   ", "  2   ",
+                                          "3 dependencies", NULL});
+    test_cli_expect("deps --reverse " TEST_CLI_PATH " textures/diffuse.png", 0,
+                    (const char *const[]){"materials/base.mat",
+                                          "1 dependents", NULL});
+    test_cli_expect("deps " TEST_CLI_PATH " missing/asset", 1,
+                    (const char *const[]){"mg-cli: deps:", NULL});
+}
+
+static void test_cli_verify(void) {
+    test_cli_expect("verify " TEST_CLI_PATH, 0,
+                    (const char *const[]){"NODES", " ok", "OK: ", NULL});
+
+    // Flip one byte inside the EDGES section of a copy.
+    FILE *file = fopen(TEST_CLI_PATH, "rb");
+    METAGRAPH_TEST_ASSERT(file != NULL);
+    static uint8_t data[1U << 16U];
+    const size_t size = fread(data, 1, sizeof(data), file);
+    (void)fclose(file);
+    METAGRAPH_TEST_ASSERT(size > sizeof(metagraph_bundle_header_t) &&
+                          size < sizeof(data));
+    metagraph_bundle_header_t header;
+    memcpy(&header, data, sizeof(header));
+    bool flipped = false;
+    for (uint32_t i = 0; i < header.section_count; i++) {
+        metagraph_section_header_t section;
+        memcpy(&section,
+               data + header.section_table_offset + i * sizeof(section),
+               sizeof(section));
+        if (section.type == METAGRAPH_SECTION_EDGES) {
+            data[section.offset + section.size / 2U] ^= 0x5AU;
+            flipped = true;
+        }
+    }
+    METAGRAPH_TEST_ASSERT(flipped);
+    file = fopen(TEST_CLI_CORRUPT_PATH, "wb");
+    METAGRAPH_TEST_ASSERT(file != NULL);
+    METAGRAPH_TEST_ASSERT(fwrite(data, 1, size, file) == size);
+    METAGRAPH_TEST_ASSERT(fclose(file) == 0);
+    test_cli_expect("verify " TEST_CLI_CORRUPT_PATH, 1,
+                    (const char *const[]){"CORRUPT", "FAILED: ", NULL});
+}
+
+static void test_cli_bench_and_usage(void) {
+    test_cli_expect("bench --lookups 64 --iterations 2 " TEST_CLI_PATH, 0,
+                    (const char *const[]){"Bundle " TEST_CLI_PATH ": 4 nodes",
+                                          "open", "find_node", "get_node",
+                                          "outgoing_edges", NULL});
+    test_cli_expect("version", 0, (const char *const[]){"mg-cli ", NULL});
+    test_cli_expect("stat", 2, (const char *const[]){"Usage:", NULL});
+    test_cli_expect("bench --lookups 0 " TEST_CLI_PATH, 2,
+                    (const char *const[]){"positive integer", NULL});
+    test_cli_expect("frobnicate " TEST_CLI_PATH, 2,
+                    (const char *const[]){"Usage:", NULL});
+}
+
+int main(int argc, char *argv[]) {
+    METAGRAPH_TEST_ASSERT(argc == 2);
+    test_cli_tool = argv[1];
+    test_cli_write_bundle();
+    test_cli_stat_and_ls();
+    test_cli_deps();
+    test_cli_verify();
+    test_cli_bench_and_usage();
+    (void)remove(TEST_CLI_PATH);
+    (void)remove(TEST_CLI_CORRUPT_PATH);
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * MetaGraph concurrent hash table and node store tests
+ */
+
+#include "metagraph/concurrent.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#define TEST_CONCURRENT_STABLE 256U
+#define TEST_CONCURRENT_CHURN 512U
+#define TEST_CONCURRENT_READERS 8
+#define TEST_CONCURRENT_ROUNDS 20
+
+static metagraph_id_t test_concurrent_id(uint64_t value) {
+    return (metagraph_id_t){.high = 0xC0FFEEULL, .low = value};
+}
+
+static void test_concurrent_name(uint64_t value, char *buffer, size_t size) {
+    (void)snprintf(buffer, size, "node-%llu", (unsigned long long)value);
+}
+
+static void test_hashtable_basics(void) {
+    metagraph_concurrent_hashtable_t *table = NULL;
+    METAGRAPH_TEST_OK(metagraph_concurrent_hashtable_create(4, &table));
+
+    static int values[4096];
+    for (uint64_t i = 0; i < 4096; i++) {
+        METAGRAPH_TEST_OK(metagraph_concurrent_hashtable_insert(
+            table, test_concurrent_id(i), &values[i]));
+    }
+    METAGRAPH_TEST_ASSERT(metagraph_concurrent_hashtable_count(table) == 4096);
+    METAGRAPH_TEST_EXPECT(metagraph_concurrent_hashtable_insert(
+                              table, test_concurrent_id(7), NULL),
+                          METAGRAPH_ERROR_NODE_EXISTS);
+
+    void *value = NULL;
+    for (uint64_t i = 0; i < 4096; i++) {
+        METAGRAPH_TEST_OK(metagraph_concurrent_hashtable_lookup(
+            table, test_concurrent_id(i), &value));
+        METAGRAPH_TEST_ASSERT(value == &values[i]);
+    }
+    METAGRAPH_TEST_EXPECT(metagraph_concurrent_hashtable_lookup(
+                              table, test_concurrent_id(5000), &value),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+
+    // Remove/re-insert churn fills the table with tombstones and forces
+    // same-size rebuilds.
+    for (int round = 0; round < 8; round++) {
+        for (uint64_t i = 0; i < 4096; i += 2) {
+            METAGRAPH_TEST_OK(metagraph_concurrent_hashtable_remove(
+                table, test_concurrent_id(i)));
+        }
+        METAGRAPH_TEST_ASSERT(metagraph_concurrent_hashtable_count(table) ==
+                              2048);
+        for (uint64_t i = 0; i < 4096; i += 2) {
+            METAGRAPH_TEST_OK(metagraph_concurrent_hashtable_insert(
+                table, test_concurrent_id(i), &values[i]));
+        }
+    }
+    METAGRAPH_TEST_EXPECT(
+        metagraph_concurrent_hashtable_remove(table, test_concurrent_id(9999)),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+    for (uint64_t i = 0; i < 4096; i++) {
+        METAGRAPH_TEST_OK(metagraph_concurrent_hashtable_lookup(
+            table, test_concurrent_id(i), &value));
+        METAGRAPH_TEST_ASSERT(value == &values[i]);
+    }
+    METAGRAPH_TEST_OK(metagraph_concurrent_hashtable_destroy(table));
+}
+
+static void test_graph_basics(void) {
+    const metagraph_graph_config_t config = {.max_nodes = 3};
+    metagraph_concurrent_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_create(&config, &graph));
+
+    char name[32];
+    for (uint64_t i = 0; i < 3; i++) {
+        test_concurrent_name(i, name, sizeof(name));
+        const metagraph_node_metadata_t node = {
+            .id = test_concurrent_id(i), .name = name, .type = 7, .hash = i};
+        METAGRAPH_TEST_OK(metagraph_concurrent_graph_add_node(graph, &node));
+    }
+    const metagraph_node_metadata_t extra = {.id = test_concurrent_id(3)};
+    METAGRAPH_TEST_EXPECT(metagraph_concurrent_graph_add_node(graph, &extra),
+                          METAGRAPH_ERROR_MAX_NODES_EXCEEDED);
+    const metagraph_node_metadata_t duplicate = {.id = test_concurrent_id(1)};
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_remove_node(
+        graph, test_concurrent_id(2)));
+    METAGRAPH_TEST_EXPECT(metagraph_concurrent_graph_add_node(graph, &duplicate),
+                          METAGRAPH_ERROR_NODE_EXISTS);
+    METAGRAPH_TEST_ASSERT(metagraph_concurrent_graph_node_count(graph) == 2);
+
+    // The name is copied, not borrowed.
+    (void)strcpy(name, "overwritten");
+    metagraph_node_metadata_t found;
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_find_node(
+        graph, test_concurrent_id(1), &found));
+    METAGRAPH_TEST_ASSERT(strcmp(found.name, "node-1") == 0);
+    METAGRAPH_TEST_ASSERT(found.type == 7 && found.hash == 1);
+    METAGRAPH_TEST_EXPECT(metagraph_concurrent_graph_find_node(
+                              graph, test_concurrent_id(2), &found),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+
+    metagraph_id_t ids[2];
+    size_t count = 0;
+    METAGRAPH_TEST_OK(
+        metagraph_concurrent_graph_enumerate_nodes(graph, NULL, 0, &count));
+    METAGRAPH_TEST_ASSERT(count == 2);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_concurrent_graph_enumerate_nodes(graph, ids, 1, &count),
+        METAGRAPH_ERROR_BUFFER_TOO_SMALL);
+    METAGRAPH_TEST_ASSERT(count == 2);
+    METAGRAPH_TEST_OK(
+        metagraph_concurrent_graph_enumerate_nodes(graph, ids, 2, &count));
+    METAGRAPH_TEST_ASSERT(ids[0].low + ids[1].low == 1);
+
+    // A removed node's name stays readable until the read section ends.
+    const uint64_t version = metagraph_concurrent_graph_version(graph);
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_validate(graph, version));
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_read_begin(graph));
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_find_node(
+        graph, test_concurrent_id(0), &found));
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_remove_node(
+        graph, test_concurrent_id(0)));
+    METAGRAPH_TEST_ASSERT(strcmp(found.name, "node-0") == 0);
+    metagraph_concurrent_graph_read_end(graph);
+    METAGRAPH_TEST_EXPECT(metagraph_concurrent_graph_validate(graph, version),
+                          METAGRAPH_ERROR_CONCURRENT_MODIFICATION);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_concurrent_graph_remove_node(graph, test_concurrent_id(0)),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_destroy(graph));
+}
+
+#if !defined(_WIN32)
+typedef struct {
+    metagraph_concurrent_graph_t *graph;
+    atomic_bool done;
+} test_concurrent_shared_t;
+
+static void test_concurrent_check_name(const metagraph_node_metadata_t *node,
+                                       uint64_t value) {
+    char expected[32];
+    test_concurrent_name(value, expected, sizeof(expected));
+    METAGRAPH_TEST_ASSERT(node->name && strcmp(node->name, expected) == 0);
+    METAGRAPH_TEST_ASSERT(node->hash == value);
+}
+
+static void *test_concurrent_reader(void *arg) {
+    test_concurrent_shared_t *shared = arg;
+    const metagraph_concurrent_graph_t *graph = shared->graph;
+    uint64_t next = 0;
+    size_t consistent_reads = 0;
+    while (!atomic_load(&shared->done) || consistent_reads == 0) {
+        const uint64_t version = metagraph_concurrent_graph_version(graph);
+        METAGRAPH_TEST_OK(metagraph_concurrent_graph_read_begin(graph));
+        metagraph_node_metadata_t node;
+        for (uint64_t i = 0; i < 64; i++, next++) {
+            const uint64_t stable = next % TEST_CONCURRENT_STABLE;
+            METAGRAPH_TEST_OK(metagraph_concurrent_graph_find_node(
+                graph, test_concurrent_id(stable), &node));
+            test_concurrent_check_name(&node, stable);
+
+            const uint64_t churn =
+                TEST_CONCURRENT_STABLE + next % TEST_CONCURRENT_CHURN;
+            const metagraph_result_t result = metagraph_concurrent_graph_find_node(
+                graph, test_concurrent_id(churn), &node);
+            METAGRAPH_TEST_ASSERT(result == METAGRAPH_SUCCESS ||
+                                  result == METAGRAPH_ERROR_NODE_NOT_FOUND);
+            if (result == METAGRAPH_SUCCESS) {
+                test_concurrent_check_name(&node, churn);
+            }
+        }
+        size_t count = 0;
+        METAGRAPH_TEST_OK(
+            metagraph_concurrent_graph_enumerate_nodes(graph, NULL, 0, &count));
+        METAGRAPH_TEST_ASSERT(count >= TEST_CONCURRENT_STABLE);
+        metagraph_concurrent_graph_read_end(graph);
+        if (metagraph_concurrent_graph_validate(graph, version) ==
+            METAGRAPH_SUCCESS) {
+            consistent_reads++;
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_add(metagraph_concurrent_graph_t *graph,
+                                uint64_t value) {
+    char name[32];
+    test_concurrent_name(value, name, sizeof(name));
+    const metagraph_node_metadata_t node = {
+        .id = test_concurrent_id(value), .name = name, .hash = value};
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_add_node(graph, &node));
+}
+
+// One writer adds and removes nodes (growing and rebuilding the table)
+// while readers look up stable and churning nodes.
+static void test_concurrent_readers_and_writer(void) {
+    const metagraph_graph_config_t config = {.initial_node_capacity = 8};
+    test_concurrent_shared_t shared = {0};
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_create(&config, &shared.graph));
+    for (uint64_t i = 0; i < TEST_CONCURRENT_STABLE; i++) {
+        test_concurrent_add(shared.graph, i);
+    }
+    atomic_init(&shared.done, false);
+
+    pthread_t readers[TEST_CONCURRENT_READERS];
+    for (int i = 0; i < TEST_CONCURRENT_READERS; i++) {
+        METAGRAPH_TEST_ASSERT(pthread_create(&readers[i], NULL,
+                                             test_concurrent_reader,
+                                             &shared) == 0);
+    }
+    for (int round = 0; round < TEST_CONCURRENT_ROUNDS; round++) {
+        for (uint64_t i = 0; i < TEST_CONCURRENT_CHURN; i++) {
+            test_concurrent_add(shared.graph, TEST_CONCURRENT_STABLE + i);
+        }
+        for (uint64_t i = 0; i < TEST_CONCURRENT_CHURN; i++) {
+            METAGRAPH_TEST_OK(metagraph_concurrent_graph_remove_node(
+                shared.graph, test_concurrent_id(TEST_CONCURRENT_STABLE + i)));
+        }
+    }
+    atomic_store(&shared.done, true);
+    for (int i = 0; i < TEST_CONCURRENT_READERS; i++) {
+        METAGRAPH_TEST_ASSERT(pthread_join(readers[i], NULL) == 0);
+    }
+    METAGRAPH_TEST_ASSERT(metagraph_concurrent_graph_node_count(shared.graph) ==
+                          TEST_CONCURRENT_STABLE);
+    METAGRAPH_TEST_OK(metagraph_concurrent_graph_destroy(shared.graph));
+}
+#endif
+
+int main(void) {
+    test_hashtable_basics();
+    test_graph_basics();
+#if !defined(_WIN32)
+    test_concurrent_readers_and_writer();
+#endif
+    return 0;
+}
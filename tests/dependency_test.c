@@ -0,0 +1,332 @@
+/*
+ * MetaGraph incremental dependency resolution tests
+ */
+
+#include "metagraph/dependency.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_DEPENDENCY_NODES 3000U
+#define TEST_DEPENDENCY_MAX_DEPS 4U
+#define TEST_DEPENDENCY_UPDATES 4000U
+
+static metagraph_id_t test_dependency_id(uint64_t value) {
+    return (metagraph_id_t){.high = 0xDE9ULL, .low = value};
+}
+
+// Reference copy of the dependency relation the context should hold.
+typedef struct {
+    uint32_t deps[TEST_DEPENDENCY_NODES][TEST_DEPENDENCY_MAX_DEPS];
+    uint32_t count[TEST_DEPENDENCY_NODES];
+} test_dependency_model_t;
+
+static uint64_t test_dependency_state = 0x243F6A8885A308D3ULL;
+
+static uint32_t test_dependency_random(uint32_t bound) {
+    test_dependency_state =
+        test_dependency_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)((test_dependency_state >> 33U) % bound);
+}
+
+static void test_dependency_check_order(const metagraph_dependency_context_t *context,
+                                        const test_dependency_model_t *model) {
+    const metagraph_node_index_t *order = NULL;
+    size_t count = 0;
+    METAGRAPH_TEST_OK(metagraph_dependency_get_order(context, &order, &count));
+    METAGRAPH_TEST_ASSERT(count == TEST_DEPENDENCY_NODES);
+    static uint32_t position[TEST_DEPENDENCY_NODES];
+    memset(position, 0xFF, sizeof(position));
+    for (uint32_t slot = 0; slot < count; slot++) {
+        METAGRAPH_TEST_ASSERT(position[order[slot]] == UINT32_MAX);
+        position[order[slot]] = slot;
+    }
+    for (uint32_t node = 0; node < TEST_DEPENDENCY_NODES; node++) {
+        for (uint32_t i = 0; i < model->count[node]; i++) {
+            METAGRAPH_TEST_ASSERT(position[model->deps[node][i]] <
+                                  position[node]);
+        }
+    }
+}
+
+// Brute-force downstream closure of `seeds` in the reference model.
+static size_t test_dependency_closure(const test_dependency_model_t *model,
+                                      const uint32_t *seeds, size_t seed_count,
+                                      bool *affected) {
+    memset(affected, 0, TEST_DEPENDENCY_NODES * sizeof(*affected));
+    for (size_t i = 0; i < seed_count; i++) {
+        affected[seeds[i]] = true;
+    }
+    size_t total = 0;
+    for (bool grew = true; grew;) {
+        grew = false;
+        total = 0;
+        for (uint32_t node = 0; node < TEST_DEPENDENCY_NODES; node++) {
+            for (uint32_t i = 0; !affected[node] && i < model->count[node]; i++) {
+                if (affected[model->deps[node][i]]) {
+                    affected[node] = true;
+                    grew = true;
+                }
+            }
+            total += affected[node];
+        }
+    }
+    return total;
+}
+
+typedef struct {
+    const test_dependency_model_t *model;
+    _Atomic(bool) loaded[TEST_DEPENDENCY_NODES];
+    uint32_t failing; ///< Node whose load fails (UINT32_MAX = none)
+} test_dependency_loader_t;
+
+static metagraph_result_t
+test_dependency_load_asset(void *user_data, metagraph_node_index_t node,
+                           metagraph_id_t asset_id) {
+    test_dependency_loader_t *loader = user_data;
+    METAGRAPH_TEST_ASSERT(
+        metagraph_id_equal(asset_id, test_dependency_id(node)));
+    for (uint32_t i = 0; i < loader->model->count[node]; i++) {
+        METAGRAPH_TEST_ASSERT(
+            atomic_load(&loader->loaded[loader->model->deps[node][i]]));
+    }
+    if (node == loader->failing) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Asset %u failed to load", node);
+    }
+    METAGRAPH_TEST_ASSERT(!atomic_exchange(&loader->loaded[node], true));
+    return METAGRAPH_OK();
+}
+
+// Load every asset through the scheduler, listed dependents-first so the
+// list order is of no help, then again with one asset failing.
+static void
+test_dependency_scheduled_load(const metagraph_dependency_context_t *context,
+                               const test_dependency_model_t *model,
+                               bool *affected) {
+    const metagraph_node_index_t *order = NULL;
+    size_t count = 0;
+    METAGRAPH_TEST_OK(metagraph_dependency_get_order(context, &order, &count));
+    static metagraph_node_index_t nodes[TEST_DEPENDENCY_NODES];
+    static metagraph_id_t ids[TEST_DEPENDENCY_NODES];
+    for (size_t i = 0; i < count; i++) {
+        nodes[i] = order[count - 1U - i];
+        ids[i] = test_dependency_id(nodes[i]);
+    }
+    const metagraph_resolution_result_t assets = {
+        .load_order = ids, .nodes = nodes, .load_order_count = count};
+
+    static test_dependency_loader_t loader;
+    loader.model = model;
+    loader.failing = UINT32_MAX;
+    for (size_t i = 0; i < count; i++) {
+        atomic_init(&loader.loaded[i], false);
+    }
+    metagraph_task_graph_stats_t stats;
+    METAGRAPH_TEST_OK(metagraph_dependency_load(
+        context, &assets, test_dependency_load_asset, &loader, NULL, &stats));
+    METAGRAPH_TEST_ASSERT(stats.completed == count && stats.failed == 0 &&
+                          stats.skipped == 0);
+
+    // Everything downstream of the failing asset is skipped.
+    loader.failing = order[count / 2U];
+    for (size_t i = 0; i < count; i++) {
+        atomic_store(&loader.loaded[i], false);
+    }
+    const size_t blocked =
+        test_dependency_closure(model, &loader.failing, 1, affected);
+    metagraph_scheduler_t *scheduler = NULL;
+    METAGRAPH_TEST_OK(metagraph_scheduler_create(3, &scheduler));
+    METAGRAPH_TEST_EXPECT(
+        metagraph_dependency_load(context, &assets, test_dependency_load_asset,
+                                  &loader, scheduler, &stats),
+        METAGRAPH_ERROR_IO_FAILURE);
+    METAGRAPH_TEST_OK(metagraph_scheduler_destroy(scheduler));
+    METAGRAPH_TEST_ASSERT(stats.failed == 1 && stats.skipped == blocked - 1U &&
+                          stats.completed == count - blocked);
+    for (size_t i = 0; i < count; i++) {
+        METAGRAPH_TEST_ASSERT(atomic_load(&loader.loaded[i]) != affected[i]);
+    }
+
+    const metagraph_resolution_result_t twice = {
+        .load_order = ids, .nodes = nodes, .load_order_count = 2};
+    ids[1] = ids[0];
+    nodes[1] = nodes[0];
+    METAGRAPH_TEST_EXPECT(
+        metagraph_dependency_load(context, &twice, test_dependency_load_asset,
+                                  &loader, NULL, NULL),
+        METAGRAPH_ERROR_INVALID_ARGUMENT);
+}
+
+static void test_dependency_small(void) {
+    const char *const names[] = {"app", "mesh", "texture", "shader"};
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint64_t i = 0; i < 4; i++) {
+        const metagraph_node_metadata_t node = {.id = test_dependency_id(i),
+                                                .name = names[i]};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    // app -> {mesh, shader}, mesh -> texture
+    const metagraph_id_t app_edge[] = {test_dependency_id(0),
+                                       test_dependency_id(1),
+                                       test_dependency_id(3)};
+    const metagraph_id_t mesh_edge[] = {test_dependency_id(1),
+                                        test_dependency_id(2)};
+    const metagraph_edge_metadata_t edges[] = {
+        {.id = test_dependency_id(10), .node_count = 3, .nodes = app_edge},
+        {.id = test_dependency_id(11), .node_count = 2, .nodes = mesh_edge},
+    };
+    for (size_t i = 0; i < 2; i++) {
+        METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edges[i], NULL));
+    }
+
+    const metagraph_dependency_config_t config = {.graph = graph};
+    metagraph_dependency_context_t *context = NULL;
+    METAGRAPH_TEST_OK(metagraph_dependency_context_create(&config, &context));
+
+    // Editing the texture re-resolves texture, mesh and app, not shader.
+    metagraph_resolution_result_t result;
+    const metagraph_id_t texture = test_dependency_id(2);
+    METAGRAPH_TEST_OK(
+        metagraph_dependency_resolve_incremental(context, &texture, 1, &result));
+    METAGRAPH_TEST_ASSERT(result.load_order_count == 3);
+    METAGRAPH_TEST_ASSERT(result.nodes[0] == 2 && result.nodes[1] == 1 &&
+                          result.nodes[2] == 0);
+    METAGRAPH_TEST_ASSERT(metagraph_id_equal(result.load_order[2],
+                                             test_dependency_id(0)));
+    METAGRAPH_TEST_OK(metagraph_resolution_result_destroy(&result));
+
+    // shader -> texture -> mesh -> shader would be a cycle.
+    const metagraph_id_t shader = test_dependency_id(3);
+    const metagraph_id_t mesh = test_dependency_id(1);
+    METAGRAPH_TEST_OK(
+        metagraph_dependency_update_asset(context, shader, &texture, 1));
+    metagraph_clear_error_context();
+    METAGRAPH_TEST_EXPECT(
+        metagraph_dependency_update_asset(context, texture, &shader, 1),
+        METAGRAPH_ERROR_DEPENDENCY_CYCLE);
+    metagraph_error_context_t error;
+    METAGRAPH_TEST_OK(metagraph_get_error_context(&error));
+#if !defined(METAGRAPH_ERROR_NO_STRINGS)
+    METAGRAPH_TEST_ASSERT(
+        strstr(error.message, "texture -> shader -> texture") != NULL);
+#endif
+    METAGRAPH_TEST_EXPECT(
+        metagraph_dependency_update_asset(context, mesh, &mesh, 1),
+        METAGRAPH_ERROR_DEPENDENCY_CYCLE);
+    const metagraph_id_t missing = test_dependency_id(99);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_dependency_update_asset(context, mesh, &missing, 1),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+
+    // Only the successful update is pending: shader and app.
+    METAGRAPH_TEST_OK(
+        metagraph_dependency_resolve_incremental(context, NULL, 0, &result));
+    METAGRAPH_TEST_ASSERT(result.load_order_count == 2);
+    METAGRAPH_TEST_ASSERT(result.nodes[0] == 3 && result.nodes[1] == 0);
+    METAGRAPH_TEST_OK(metagraph_resolution_result_destroy(&result));
+    METAGRAPH_TEST_OK(
+        metagraph_dependency_resolve_incremental(context, NULL, 0, &result));
+    METAGRAPH_TEST_ASSERT(result.load_order_count == 0);
+    METAGRAPH_TEST_OK(metagraph_resolution_result_destroy(&result));
+
+    METAGRAPH_TEST_OK(metagraph_dependency_context_destroy(context));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+// Random dependency rewrites, including ones that would close cycles,
+// checked against a reference model after every step.
+static void test_dependency_random_updates(void) {
+    static test_dependency_model_t model;
+    memset(&model, 0, sizeof(model));
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint64_t i = 0; i < TEST_DEPENDENCY_NODES; i++) {
+        const metagraph_node_metadata_t node = {.id = test_dependency_id(i)};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    // Start acyclic: dependencies only on lower-numbered nodes.
+    for (uint32_t node = 1; node < TEST_DEPENDENCY_NODES; node++) {
+        metagraph_id_t members[1 + TEST_DEPENDENCY_MAX_DEPS];
+        members[0] = test_dependency_id(node);
+        model.count[node] = 1U + test_dependency_random(TEST_DEPENDENCY_MAX_DEPS);
+        for (uint32_t i = 0; i < model.count[node]; i++) {
+            model.deps[node][i] = test_dependency_random(node);
+            members[i + 1] = test_dependency_id(model.deps[node][i]);
+        }
+        const metagraph_edge_metadata_t edge = {
+            .id = test_dependency_id(TEST_DEPENDENCY_NODES + node),
+            .node_count = 1U + model.count[node],
+            .nodes = members};
+        METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edge, NULL));
+    }
+
+    const metagraph_dependency_config_t config = {
+        .graph = graph, .parallel = {.thread_count = 4, .work_unit_size = 128}};
+    metagraph_dependency_context_t *context = NULL;
+    METAGRAPH_TEST_OK(metagraph_dependency_context_create(&config, &context));
+    test_dependency_check_order(context, &model);
+
+    static bool affected[TEST_DEPENDENCY_NODES];
+    uint32_t pending[TEST_DEPENDENCY_UPDATES];
+    size_t pending_count = 0;
+    size_t cycles = 0;
+    for (uint32_t step = 0; step < TEST_DEPENDENCY_UPDATES; step++) {
+        const uint32_t asset = test_dependency_random(TEST_DEPENDENCY_NODES);
+        const uint32_t count = test_dependency_random(TEST_DEPENDENCY_MAX_DEPS + 1);
+        uint32_t deps[TEST_DEPENDENCY_MAX_DEPS];
+        metagraph_id_t ids[TEST_DEPENDENCY_MAX_DEPS];
+        for (uint32_t i = 0; i < count; i++) {
+            deps[i] = test_dependency_random(TEST_DEPENDENCY_NODES);
+            ids[i] = test_dependency_id(deps[i]);
+        }
+        const metagraph_result_t result = metagraph_dependency_update_asset(
+            context, test_dependency_id(asset), ids, count);
+        if (result == METAGRAPH_ERROR_DEPENDENCY_CYCLE) {
+            cycles++;
+        } else {
+            METAGRAPH_TEST_OK(result);
+            model.count[asset] = count;
+            memcpy(model.deps[asset], deps, count * sizeof(deps[0]));
+            pending[pending_count++] = asset;
+        }
+        if (step % 97 == 0) {
+            test_dependency_check_order(context, &model);
+        }
+        if (step % 500 == 499) {
+            const uint32_t edited = test_dependency_random(TEST_DEPENDENCY_NODES);
+            pending[pending_count++] = edited;
+            const size_t expected =
+                test_dependency_closure(&model, pending, pending_count, affected);
+            metagraph_resolution_result_t resolution;
+            const metagraph_id_t edited_id = test_dependency_id(edited);
+            METAGRAPH_TEST_OK(metagraph_dependency_resolve_incremental(
+                context, &edited_id, 1, &resolution));
+            METAGRAPH_TEST_ASSERT(resolution.load_order_count == expected);
+            for (size_t i = 0; i < resolution.load_order_count; i++) {
+                METAGRAPH_TEST_ASSERT(affected[resolution.nodes[i]]);
+            }
+            METAGRAPH_TEST_OK(metagraph_resolution_result_destroy(&resolution));
+            pending_count = 0;
+        }
+    }
+    test_dependency_check_order(context, &model);
+    METAGRAPH_TEST_ASSERT(cycles > 0);
+    test_dependency_scheduled_load(context, &model, affected);
+    METAGRAPH_TEST_OK(metagraph_dependency_context_destroy(context));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+int main(void) {
+    test_dependency_small();
+    test_dependency_random_updates();
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * MetaGraph error context tests
+ */
+
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(METAGRAPH_ERROR_NO_STRINGS)
+
+static const char *test_error_message(metagraph_result_t expected_code) {
+    static metagraph_error_context_t context;
+    METAGRAPH_TEST_OK(metagraph_get_error_context(&context));
+    METAGRAPH_TEST_ASSERT(context.code == expected_code);
+    return context.message;
+}
+
+// The deferred renderer must agree with snprintf for every conversion the
+// library's messages use.
+static void test_error_matches_snprintf(void) {
+    const char *name = "assets/mesh.bin";
+    const int value = -42;
+    const unsigned long long id = 0xDEADBEEFCAFEULL;
+    const size_t size = 4096;
+    const double ratio = 0.125;
+    const long double precise = 2.5L;
+    const void *address = &value;
+    // Room for the widest possible output (a %f of DBL_MAX alone takes
+    // over 300 bytes), so -Wformat-truncation has nothing to flag.
+    char expected[512];
+
+    (void)snprintf(expected, sizeof(expected),
+                   "%s %d %u %016llx %zu %5.2f %-8s| %c %% %p", name, value,
+                   7U, id, size, ratio, "pad", 'x', address);
+    METAGRAPH_TEST_EXPECT(
+        METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                      "%s %d %u %016llx %zu %5.2f %-8s| %c %% %p", name, value,
+                      7U, id, size, ratio, "pad", 'x', address),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+    METAGRAPH_TEST_ASSERT(
+        strcmp(test_error_message(METAGRAPH_ERROR_NODE_NOT_FOUND), expected) ==
+        0);
+
+    (void)snprintf(expected, sizeof(expected),
+                   "%hhd %hu %ld %jd %td %Lg [%.*s] [%*d] [%-*d] %#x %+i %e",
+                   (signed char)-3, (unsigned short)65535U, -9L,
+                   (intmax_t)INT64_MIN, (ptrdiff_t)-5, precise, 4, name, 6, 12,
+                   -6, 12, 255U, 3, 1.5e10);
+    METAGRAPH_TEST_EXPECT(
+        METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_SIZE,
+                      "%hhd %hu %ld %jd %td %Lg [%.*s] [%*d] [%-*d] %#x %+i %e",
+                      (signed char)-3, (unsigned short)65535U, -9L,
+                      (intmax_t)INT64_MIN, (ptrdiff_t)-5, precise, 4, name, 6,
+                      12, -6, 12, 255U, 3, 1.5e10),
+        METAGRAPH_ERROR_INVALID_SIZE);
+    METAGRAPH_TEST_ASSERT(
+        strcmp(test_error_message(METAGRAPH_ERROR_INVALID_SIZE), expected) == 0);
+
+    METAGRAPH_TEST_EXPECT(METAGRAPH_ERR_CODE(METAGRAPH_ERROR_EDGE_EXISTS),
+                          METAGRAPH_ERROR_EDGE_EXISTS);
+    METAGRAPH_TEST_ASSERT(
+        strcmp(test_error_message(METAGRAPH_ERROR_EDGE_EXISTS),
+               metagraph_result_to_string(METAGRAPH_ERROR_EDGE_EXISTS)) == 0);
+}
+
+// Rendering happens long after the caller's buffers are gone.
+static void test_error_copies_strings(void) {
+    char name[32] = "first";
+    (void)METAGRAPH_ERR(METAGRAPH_ERROR_NODE_EXISTS, "Node %s exists", name);
+    memcpy(name, "other", sizeof("other"));
+    METAGRAPH_TEST_ASSERT(strcmp(test_error_message(METAGRAPH_ERROR_NODE_EXISTS),
+                                 "Node first exists") == 0);
+    // Reading the context again returns the same message.
+    METAGRAPH_TEST_ASSERT(strcmp(test_error_message(METAGRAPH_ERROR_NODE_EXISTS),
+                                 "Node first exists") == 0);
+}
+
+static void test_error_truncation(void) {
+    char long_text[400];
+    memset(long_text, 'a', sizeof(long_text) - 1U);
+    long_text[sizeof(long_text) - 1U] = '\0';
+
+    // Too long to capture: formatted on the spot.
+    (void)METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE, "path %s", long_text);
+    const char *message = test_error_message(METAGRAPH_ERROR_IO_FAILURE);
+    METAGRAPH_TEST_ASSERT(strlen(message) == 255U);
+    METAGRAPH_TEST_ASSERT(strncmp(message, "path aaa", 8) == 0);
+    METAGRAPH_TEST_ASSERT(strcmp(message + 252, "...") == 0);
+
+    // Captured, but the rendered text overflows the message buffer.
+    (void)METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE, "%200d|%200d", 1, 2);
+    message = test_error_message(METAGRAPH_ERROR_IO_FAILURE);
+    METAGRAPH_TEST_ASSERT(strlen(message) == 255U);
+    METAGRAPH_TEST_ASSERT(message[199] == '1' && message[200] == '|');
+    METAGRAPH_TEST_ASSERT(strcmp(message + 252, "...") == 0);
+
+    // More arguments than the deferred path holds also format eagerly.
+    (void)METAGRAPH_ERR(METAGRAPH_ERROR_INTERNAL_STATE,
+                        "%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d", 1, 2, 3, 4,
+                        5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8);
+    METAGRAPH_TEST_ASSERT(
+        strcmp(test_error_message(METAGRAPH_ERROR_INTERNAL_STATE),
+               "123456789012345678") == 0);
+}
+
+#endif
+
+static void test_error_location_and_clear(void) {
+    const int line = __LINE__ + 1;
+    (void)METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY, "Allocation of %zu",
+                        (size_t)64);
+    metagraph_error_context_t context;
+    METAGRAPH_TEST_OK(metagraph_get_error_context(&context));
+    METAGRAPH_TEST_ASSERT(context.code == METAGRAPH_ERROR_OUT_OF_MEMORY);
+    METAGRAPH_TEST_ASSERT(context.line == line);
+    METAGRAPH_TEST_ASSERT(strstr(context.file, "error_test.c") != NULL);
+#if defined(METAGRAPH_ERROR_NO_STRINGS)
+    METAGRAPH_TEST_ASSERT(strcmp(context.message, "Out of memory") == 0);
+#else
+    METAGRAPH_TEST_ASSERT(strcmp(context.message, "Allocation of 64") == 0);
+#endif
+
+    metagraph_clear_error_context();
+    METAGRAPH_TEST_OK(metagraph_get_error_context(&context));
+    METAGRAPH_TEST_ASSERT(context.code == METAGRAPH_SUCCESS);
+    METAGRAPH_TEST_ASSERT(context.message[0] == '\0');
+    METAGRAPH_TEST_EXPECT(metagraph_get_error_context(NULL),
+                          METAGRAPH_ERROR_NULL_POINTER);
+}
+
+int main(void) {
+#if !defined(METAGRAPH_ERROR_NO_STRINGS)
+    test_error_matches_snprintf();
+    test_error_copies_strings();
+    test_error_truncation();
+#endif
+    test_error_location_and_clear();
+    return 0;
+}
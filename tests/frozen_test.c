@@ -0,0 +1,342 @@
+/*
+ * MetaGraph frozen CSR snapshot tests
+ */
+
+#include "metagraph/bundle.h"
+#include "metagraph/frozen.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+#include "metagraph/traversal.h"
+
+#include "test_utils.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_FROZEN_PATH "frozen_test.mgb"
+// Enough nodes that some deltas need three bytes.
+#define TEST_FROZEN_NODES 70000U
+#define TEST_FROZEN_HUB_TARGETS 301U
+
+static metagraph_id_t test_frozen_id(uint32_t node) {
+    return (metagraph_id_t){.high = 0x46524F5A454EULL, .low = node + 1U};
+}
+
+static void test_frozen_add_edge(metagraph_graph_t *graph, uint64_t id,
+                                 const uint32_t *nodes, size_t count) {
+    metagraph_id_t members[TEST_FROZEN_HUB_TARGETS + 1U];
+    for (size_t i = 0; i < count; i++) {
+        members[i] = test_frozen_id(nodes[i]);
+    }
+    const metagraph_edge_metadata_t edge = {
+        .id = {.high = 2, .low = id},
+        .weight = 1.0F,
+        .node_count = count,
+        .nodes = members,
+    };
+    METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edge, NULL));
+}
+
+// Each node depends on its successor and a far node; node 0 is a hub with
+// one wide hyperedge, and a few edges repeat targets.
+static metagraph_graph_t *test_frozen_graph(void) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint32_t i = 0; i < TEST_FROZEN_NODES; i++) {
+        const metagraph_node_metadata_t node = {.id = test_frozen_id(i)};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    uint64_t edge_id = 1;
+    for (uint32_t i = 1; i + 1U < TEST_FROZEN_NODES; i++) {
+        const uint32_t far = (uint32_t)(((uint64_t)i * 7919U) %
+                                        TEST_FROZEN_NODES);
+        const uint32_t nodes[3] = {i, i + 1U, far};
+        test_frozen_add_edge(graph, edge_id++, nodes, far == i ? 2U : 3U);
+        if (i % 1000U == 0) {
+            const uint32_t repeat[2] = {i, i + 1U};
+            test_frozen_add_edge(graph, edge_id++, repeat, 2);
+        }
+    }
+    uint32_t hub[TEST_FROZEN_HUB_TARGETS + 1U] = {0};
+    uint32_t state = 99U;
+    for (uint32_t i = 1; i <= TEST_FROZEN_HUB_TARGETS; i++) {
+        state = state * 1103515245U + 12345U;
+        hub[i] = 1U + (state >> 8U) % (TEST_FROZEN_NODES - 1U);
+    }
+    test_frozen_add_edge(graph, edge_id++, hub, TEST_FROZEN_HUB_TARGETS + 1U);
+    return graph;
+}
+
+static int test_frozen_compare(const void *lhs, const void *rhs) {
+    const uint32_t a = *(const uint32_t *)lhs;
+    const uint32_t b = *(const uint32_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+// Distinct targets of node's outgoing edges, via the mutable graph.
+static size_t test_frozen_expected(const metagraph_graph_t *graph,
+                                   metagraph_node_index_t node,
+                                   uint32_t *out) {
+    metagraph_edge_index_t edges[16];
+    size_t edge_count = 0;
+    METAGRAPH_TEST_OK(metagraph_graph_get_outgoing_edges(graph, node, edges,
+                                                         16, &edge_count));
+    size_t count = 0;
+    for (size_t i = 0; i < edge_count; i++) {
+        const metagraph_node_index_t *members = NULL;
+        size_t member_count = 0;
+        METAGRAPH_TEST_OK(metagraph_graph_get_edge_nodes(graph, edges[i],
+                                                         &members,
+                                                         &member_count));
+        memcpy(out + count, members + 1, (member_count - 1U) * sizeof(*out));
+        count += member_count - 1U;
+    }
+    qsort(out, count, sizeof(*out), test_frozen_compare);
+    size_t unique = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (unique == 0 || out[i] != out[unique - 1U]) {
+            out[unique++] = out[i];
+        }
+    }
+    return unique;
+}
+
+static void test_frozen_matches(const metagraph_graph_t *graph,
+                                const metagraph_frozen_graph_t *frozen) {
+    uint32_t expected[TEST_FROZEN_HUB_TARGETS + 16U];
+    uint32_t actual[TEST_FROZEN_HUB_TARGETS + 16U];
+    for (uint32_t node = 0; node < TEST_FROZEN_NODES; node++) {
+        const size_t count = test_frozen_expected(graph, node, expected);
+        size_t actual_count = 0;
+        METAGRAPH_TEST_OK(metagraph_frozen_graph_neighbors(
+            frozen, node, actual, TEST_FROZEN_HUB_TARGETS + 16U,
+            &actual_count));
+        METAGRAPH_TEST_ASSERT(actual_count == count);
+        METAGRAPH_TEST_ASSERT(
+            memcmp(actual, expected, count * sizeof(*actual)) == 0);
+
+        const metagraph_edge_index_t *edges = NULL;
+        size_t edge_count = 0;
+        metagraph_edge_index_t graph_edges[16];
+        size_t graph_count = 0;
+        METAGRAPH_TEST_OK(metagraph_frozen_graph_incoming_edges(
+            frozen, node, &edges, &edge_count));
+        METAGRAPH_TEST_OK(metagraph_graph_get_incoming_edges(
+            graph, node, graph_edges, 16, &graph_count));
+        METAGRAPH_TEST_ASSERT(edge_count == graph_count);
+        METAGRAPH_TEST_ASSERT(
+            memcmp(edges, graph_edges, edge_count * sizeof(*edges)) == 0);
+    }
+}
+
+static void test_frozen_bfs(const metagraph_graph_t *graph,
+                            const metagraph_frozen_graph_t *frozen) {
+    uint32_t *distance = malloc(TEST_FROZEN_NODES * sizeof(*distance));
+    metagraph_bfs_node_info_t *info =
+        malloc(TEST_FROZEN_NODES * sizeof(*info));
+    METAGRAPH_TEST_ASSERT(distance != NULL && info != NULL);
+    const uint32_t starts[] = {0, 17, TEST_FROZEN_NODES - 1U};
+    const uint32_t depths[] = {0, 3};
+    for (size_t s = 0; s < 3; s++) {
+        for (size_t d = 0; d < 2; d++) {
+            const metagraph_traversal_context_t context = {
+                .graph = graph, .max_depth = depths[d]};
+            METAGRAPH_TEST_OK(metagraph_traverse_bfs(&context, starts[s], NULL,
+                                                     NULL, NULL, info));
+            size_t reached = 0;
+            METAGRAPH_TEST_OK(metagraph_frozen_traverse_bfs(
+                frozen, starts[s], depths[d], distance, &reached));
+            size_t expected_reached = 0;
+            for (uint32_t i = 0; i < TEST_FROZEN_NODES; i++) {
+                METAGRAPH_TEST_ASSERT(distance[i] == info[i].distance);
+                expected_reached += info[i].distance != UINT32_MAX;
+            }
+            METAGRAPH_TEST_ASSERT(reached == expected_reached);
+        }
+    }
+    METAGRAPH_TEST_EXPECT(metagraph_frozen_traverse_bfs(
+                              frozen, TEST_FROZEN_NODES, 0, distance, NULL),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+    free(info);
+    free(distance);
+}
+
+static void test_frozen_from_graph(void) {
+    metagraph_graph_t *graph = test_frozen_graph();
+    metagraph_frozen_graph_t *frozen = NULL;
+    METAGRAPH_TEST_OK(metagraph_frozen_graph_create(graph, &frozen));
+    test_frozen_matches(graph, frozen);
+    test_frozen_bfs(graph, frozen);
+
+    // Count-only queries and short buffers
+    size_t count = 0;
+    METAGRAPH_TEST_OK(
+        metagraph_frozen_graph_neighbors(frozen, 0, NULL, 0, &count));
+    METAGRAPH_TEST_ASSERT(count > 200);
+    metagraph_node_index_t small[4];
+    METAGRAPH_TEST_EXPECT(
+        metagraph_frozen_graph_neighbors(frozen, 0, small, 4, &count),
+        METAGRAPH_ERROR_BUFFER_TOO_SMALL);
+    METAGRAPH_TEST_ASSERT(count > 4);
+    METAGRAPH_TEST_EXPECT(metagraph_frozen_graph_neighbors(
+                              frozen, TEST_FROZEN_NODES, small, 4, &count),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+
+    const metagraph_edge_index_t *edges = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_frozen_graph_outgoing_edges(frozen, 0, &edges, &count));
+    METAGRAPH_TEST_ASSERT(count == 1);
+    const metagraph_node_index_t *members = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_frozen_graph_edge_nodes(frozen, edges[0], &members, &count));
+    METAGRAPH_TEST_ASSERT(count == TEST_FROZEN_HUB_TARGETS + 1U);
+    METAGRAPH_TEST_ASSERT(members[0] == 0);
+    METAGRAPH_TEST_EXPECT(metagraph_frozen_graph_edge_nodes(
+                              frozen, UINT32_MAX - 1U, &members, &count),
+                          METAGRAPH_ERROR_EDGE_NOT_FOUND);
+
+    // The snapshot is far smaller than the linked form it came from.
+    metagraph_frozen_stats_t stats;
+    metagraph_graph_stats_t graph_stats;
+    METAGRAPH_TEST_OK(metagraph_frozen_graph_get_stats(frozen, &stats));
+    METAGRAPH_TEST_OK(metagraph_graph_get_stats(graph, &graph_stats));
+    METAGRAPH_TEST_ASSERT(stats.node_count == TEST_FROZEN_NODES);
+    METAGRAPH_TEST_ASSERT(stats.edge_count == graph_stats.edge_count);
+    METAGRAPH_TEST_ASSERT(stats.max_degree >= 200);
+    METAGRAPH_TEST_ASSERT(stats.packed_bytes <
+                          stats.neighbor_count * sizeof(uint32_t));
+    METAGRAPH_TEST_ASSERT(stats.memory_bytes * 2U < graph_stats.memory_bytes);
+
+    // A snapshot does not depend on the graph staying alive.
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+    METAGRAPH_TEST_OK(
+        metagraph_frozen_graph_neighbors(frozen, 1, small, 4, &count));
+    METAGRAPH_TEST_ASSERT(count == 2 && small[0] == 2 && small[1] == 7919);
+    metagraph_frozen_graph_destroy(frozen);
+    metagraph_frozen_graph_destroy(NULL);
+}
+
+static void test_frozen_from_bundle(void) {
+    metagraph_graph_t *graph = test_frozen_graph();
+    METAGRAPH_TEST_OK(metagraph_bundle_write_graph(graph, TEST_FROZEN_PATH,
+                                                   NULL));
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_FROZEN_PATH, NULL, &bundle));
+    metagraph_frozen_graph_t *frozen = NULL;
+    METAGRAPH_TEST_OK(metagraph_frozen_graph_from_bundle(bundle, &frozen));
+    test_frozen_matches(graph, frozen);
+    test_frozen_bfs(graph, frozen);
+
+    // Incidence is read from the mapped section, not copied.
+    const metagraph_edge_index_t *edges = NULL;
+    const metagraph_edge_index_t *bundle_edges = NULL;
+    size_t count = 0;
+    METAGRAPH_TEST_OK(
+        metagraph_frozen_graph_outgoing_edges(frozen, 5, &edges, &count));
+    METAGRAPH_TEST_OK(metagraph_bundle_get_outgoing_edges(bundle, 5,
+                                                          &bundle_edges,
+                                                          &count));
+    METAGRAPH_TEST_ASSERT(edges == bundle_edges);
+
+    metagraph_frozen_graph_t *copied = NULL;
+    METAGRAPH_TEST_OK(metagraph_frozen_graph_create(graph, &copied));
+    metagraph_frozen_stats_t stats;
+    metagraph_frozen_stats_t copied_stats;
+    METAGRAPH_TEST_OK(metagraph_frozen_graph_get_stats(frozen, &stats));
+    METAGRAPH_TEST_OK(metagraph_frozen_graph_get_stats(copied, &copied_stats));
+    METAGRAPH_TEST_ASSERT(stats.packed_bytes == copied_stats.packed_bytes);
+    METAGRAPH_TEST_ASSERT(stats.memory_bytes < copied_stats.memory_bytes);
+
+    metagraph_frozen_graph_destroy(copied);
+    metagraph_frozen_graph_destroy(frozen);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+// Which out-list damage test_frozen_rejects_bad_out_list() plants.
+typedef enum {
+    TEST_FROZEN_FOREIGN_EDGE,
+    TEST_FROZEN_REPEATED_EDGE,
+} test_frozen_damage_t;
+
+// In-range but inconsistent out lists must be refused, not packed: a
+// repeated wide edge would gather more targets than there are members.
+static void test_frozen_rejects_bad_out_list(test_frozen_damage_t damage) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint32_t i = 0; i < 5U; i++) {
+        const metagraph_node_metadata_t node = {.id = test_frozen_id(i)};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    test_frozen_add_edge(graph, 1, (const uint32_t[]){0, 1, 2, 3}, 4);
+    test_frozen_add_edge(graph, 2, (const uint32_t[]){0, 4}, 2);
+    test_frozen_add_edge(graph, 3, (const uint32_t[]){1, 2}, 2);
+    METAGRAPH_TEST_OK(metagraph_bundle_write_graph(graph, TEST_FROZEN_PATH,
+                                                   NULL));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+
+    FILE *file = fopen(TEST_FROZEN_PATH, "rb");
+    METAGRAPH_TEST_ASSERT(file != NULL);
+    METAGRAPH_TEST_ASSERT(fseek(file, 0, SEEK_END) == 0);
+    const long size = ftell(file);
+    METAGRAPH_TEST_ASSERT(size > 0 && fseek(file, 0, SEEK_SET) == 0);
+    uint8_t *data = malloc((size_t)size);
+    METAGRAPH_TEST_ASSERT(data != NULL);
+    METAGRAPH_TEST_ASSERT(fread(data, 1, (size_t)size, file) == (size_t)size);
+    (void)fclose(file);
+
+    metagraph_bundle_header_t header;
+    memcpy(&header, data, sizeof(header));
+    for (uint32_t i = 0; i < header.section_count; i++) {
+        metagraph_section_header_t section;
+        memcpy(&section,
+               data + header.section_table_offset + i * sizeof(section),
+               sizeof(section));
+        if (section.type != METAGRAPH_SECTION_EDGES) {
+            continue;
+        }
+        metagraph_bundle_edges_header_t edges;
+        memcpy(&edges, data + section.offset, sizeof(edges));
+        uint32_t rows[6];
+        memcpy(rows, data + section.offset + edges.out_rows_offset,
+               sizeof(rows));
+        // Nodes may be reordered on write: find the two-edge source and
+        // a one-edge source by their row lengths.
+        uint32_t wide = UINT32_MAX;
+        uint32_t single = UINT32_MAX;
+        for (uint32_t node = 0; node < 5U; node++) {
+            if (rows[node + 1U] - rows[node] == 2U) {
+                wide = rows[node];
+            } else if (rows[node + 1U] - rows[node] == 1U) {
+                single = rows[node];
+            }
+        }
+        METAGRAPH_TEST_ASSERT(wide != UINT32_MAX && single != UINT32_MAX);
+        uint8_t *out_edges = data + section.offset + edges.out_edges_offset;
+        const uint32_t to = damage == TEST_FROZEN_FOREIGN_EDGE ? single
+                                                              : wide + 1U;
+        memcpy(out_edges + to * sizeof(uint32_t),
+               out_edges + wide * sizeof(uint32_t), sizeof(uint32_t));
+    }
+
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(metagraph_bundle_create_from_memory(data, (size_t)size,
+                                                          NULL, &bundle));
+    metagraph_frozen_graph_t *frozen = NULL;
+    METAGRAPH_TEST_EXPECT(metagraph_frozen_graph_from_bundle(bundle, &frozen),
+                          METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    free(data);
+}
+
+int main(void) {
+    test_frozen_from_graph();
+    test_frozen_from_bundle();
+    test_frozen_rejects_bad_out_list(TEST_FROZEN_FOREIGN_EDGE);
+    test_frozen_rejects_bad_out_list(TEST_FROZEN_REPEATED_EDGE);
+    (void)remove(TEST_FROZEN_PATH);
+    return 0;
+}
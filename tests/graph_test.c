@@ -0,0 +1,263 @@
+/*
+ * MetaGraph core data model tests
+ */
+
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static metagraph_id_t test_graph_make_id(uint64_t value) {
+    return (metagraph_id_t){.high = value * 0x100000001B3ULL, .low = value};
+}
+
+static void test_graph_create_empty(void) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    METAGRAPH_TEST_ASSERT(graph != NULL);
+    METAGRAPH_TEST_ASSERT(metagraph_graph_node_count(graph) == 0);
+    METAGRAPH_TEST_ASSERT(metagraph_graph_edge_count(graph) == 0);
+
+    metagraph_node_index_t index = 0;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_graph_find_node(graph, test_graph_make_id(1), &index),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static void test_graph_add_node_and_lookup(void) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+
+    static char payload[] = "texture-bytes";
+    metagraph_node_metadata_t metadata = {
+        .id = test_graph_make_id(42),
+        .name = "textures/diffuse.png",
+        .type = 7,
+        .data_size = sizeof(payload),
+        .data = payload,
+        .hash = 0xABCDU,
+    };
+    metagraph_node_index_t index = METAGRAPH_INVALID_INDEX;
+    METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &metadata, &index));
+    METAGRAPH_TEST_ASSERT(index == 0);
+
+    METAGRAPH_TEST_EXPECT(metagraph_graph_add_node(graph, &metadata, NULL),
+                          METAGRAPH_ERROR_NODE_EXISTS);
+
+    metagraph_node_index_t found = METAGRAPH_INVALID_INDEX;
+    METAGRAPH_TEST_OK(metagraph_graph_find_node(graph, metadata.id, &found));
+    METAGRAPH_TEST_ASSERT(found == index);
+
+    metagraph_node_metadata_t read = {0};
+    METAGRAPH_TEST_OK(metagraph_graph_get_node(graph, found, &read));
+    METAGRAPH_TEST_ASSERT(metagraph_id_equal(read.id, metadata.id));
+    METAGRAPH_TEST_ASSERT(strcmp(read.name, metadata.name) == 0);
+    METAGRAPH_TEST_ASSERT(read.name != metadata.name);
+    METAGRAPH_TEST_ASSERT(read.type == 7);
+    METAGRAPH_TEST_ASSERT(read.data == payload);
+    METAGRAPH_TEST_ASSERT(read.hash == 0xABCDU);
+
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static void test_graph_many_nodes_survive_rehash(void) {
+    metagraph_graph_config_t config = {.initial_node_capacity = 4};
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(&config, &graph));
+
+    const uint32_t count = 100000;
+    for (uint32_t i = 0; i < count; i++) {
+        metagraph_node_metadata_t metadata = {.id = test_graph_make_id(i)};
+        metagraph_node_index_t index = 0;
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &metadata, &index));
+        METAGRAPH_TEST_ASSERT(index == i);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        metagraph_node_index_t index = 0;
+        METAGRAPH_TEST_OK(
+            metagraph_graph_find_node(graph, test_graph_make_id(i), &index));
+        METAGRAPH_TEST_ASSERT(index == i);
+    }
+    metagraph_node_index_t index = 0;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_graph_find_node(graph, test_graph_make_id(count), &index),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+
+    // One batch, every third ID unknown, and a tail that is not a whole
+    // prefetch group.
+    const uint32_t batch = 1000U + 5U;
+    metagraph_id_t *ids = malloc(batch * sizeof(*ids));
+    metagraph_node_index_t *indices = malloc(batch * sizeof(*indices));
+    METAGRAPH_TEST_ASSERT(ids != NULL && indices != NULL);
+    for (uint32_t i = 0; i < batch; i++) {
+        ids[i] = test_graph_make_id(i % 3U == 2U ? count + i : i * 97U);
+    }
+    size_t found = 0;
+    METAGRAPH_TEST_OK(
+        metagraph_graph_find_nodes(graph, ids, batch, indices, &found));
+    METAGRAPH_TEST_ASSERT(found == batch - batch / 3U);
+    for (uint32_t i = 0; i < batch; i++) {
+        METAGRAPH_TEST_ASSERT(indices[i] == (i % 3U == 2U
+                                                 ? METAGRAPH_INVALID_INDEX
+                                                 : i * 97U));
+    }
+    METAGRAPH_TEST_OK(metagraph_graph_find_nodes(graph, ids, 0, indices, NULL));
+    METAGRAPH_TEST_EXPECT(
+        metagraph_graph_find_nodes(graph, NULL, batch, indices, NULL),
+        METAGRAPH_ERROR_NULL_POINTER);
+    free(ids);
+    free(indices);
+
+    metagraph_graph_stats_t stats = {0};
+    METAGRAPH_TEST_OK(metagraph_graph_get_stats(graph, &stats));
+    METAGRAPH_TEST_ASSERT(stats.node_count == count);
+    METAGRAPH_TEST_ASSERT(stats.index_capacity >= count);
+    METAGRAPH_TEST_ASSERT(stats.memory_bytes > 0);
+
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static void test_graph_max_nodes_exceeded(void) {
+    metagraph_graph_config_t config = {.max_nodes = 2};
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(&config, &graph));
+
+    for (uint64_t i = 0; i < 2; i++) {
+        metagraph_node_metadata_t metadata = {.id = test_graph_make_id(i)};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &metadata, NULL));
+    }
+    metagraph_node_metadata_t extra = {.id = test_graph_make_id(2)};
+    METAGRAPH_TEST_EXPECT(metagraph_graph_add_node(graph, &extra, NULL),
+                          METAGRAPH_ERROR_MAX_NODES_EXCEEDED);
+
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static void test_graph_hyperedges_and_incidence(void) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+
+    for (uint64_t i = 0; i < 4; i++) {
+        metagraph_node_metadata_t metadata = {.id = test_graph_make_id(i)};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &metadata, NULL));
+    }
+
+    // material(0) depends on texture(1) and shader(2)
+    const metagraph_id_t first_nodes[] = {test_graph_make_id(0),
+                                          test_graph_make_id(1),
+                                          test_graph_make_id(2)};
+    metagraph_edge_metadata_t first = {.id = test_graph_make_id(100),
+                                       .type = 1,
+                                       .weight = 1.5F,
+                                       .node_count = 3,
+                                       .nodes = first_nodes};
+    metagraph_edge_index_t first_index = METAGRAPH_INVALID_INDEX;
+    METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &first, &first_index));
+
+    // mesh(3) depends on material(0)
+    const metagraph_id_t second_nodes[] = {test_graph_make_id(3),
+                                           test_graph_make_id(0)};
+    metagraph_edge_metadata_t second = {.id = test_graph_make_id(101),
+                                        .node_count = 2,
+                                        .nodes = second_nodes};
+    metagraph_edge_index_t second_index = METAGRAPH_INVALID_INDEX;
+    METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &second, &second_index));
+
+    METAGRAPH_TEST_EXPECT(metagraph_graph_add_edge(graph, &second, NULL),
+                          METAGRAPH_ERROR_EDGE_EXISTS);
+
+    const metagraph_id_t dangling_nodes[] = {test_graph_make_id(0),
+                                             test_graph_make_id(99)};
+    metagraph_edge_metadata_t dangling = {.id = test_graph_make_id(102),
+                                          .node_count = 2,
+                                          .nodes = dangling_nodes};
+    METAGRAPH_TEST_EXPECT(metagraph_graph_add_edge(graph, &dangling, NULL),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+    METAGRAPH_TEST_ASSERT(metagraph_graph_edge_count(graph) == 2);
+
+    metagraph_edge_index_t edges[4];
+    size_t count = 0;
+    METAGRAPH_TEST_OK(
+        metagraph_graph_get_outgoing_edges(graph, 0, edges, 4, &count));
+    METAGRAPH_TEST_ASSERT(count == 1 && edges[0] == first_index);
+    METAGRAPH_TEST_OK(
+        metagraph_graph_get_incoming_edges(graph, 0, edges, 4, &count));
+    METAGRAPH_TEST_ASSERT(count == 1 && edges[0] == second_index);
+    METAGRAPH_TEST_OK(
+        metagraph_graph_get_incoming_edges(graph, 2, edges, 4, &count));
+    METAGRAPH_TEST_ASSERT(count == 1 && edges[0] == first_index);
+    METAGRAPH_TEST_OK(
+        metagraph_graph_get_outgoing_edges(graph, 1, NULL, 0, &count));
+    METAGRAPH_TEST_ASSERT(count == 0);
+
+    const metagraph_node_index_t *members = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_graph_get_edge_nodes(graph, first_index, &members, &count));
+    METAGRAPH_TEST_ASSERT(count == 3);
+    METAGRAPH_TEST_ASSERT(members[0] == 0 && members[1] == 1 &&
+                          members[2] == 2);
+
+    metagraph_edge_metadata_t read = {0};
+    METAGRAPH_TEST_OK(metagraph_graph_get_edge(graph, first_index, &read));
+    METAGRAPH_TEST_ASSERT(read.type == 1 && read.node_count == 3);
+
+    metagraph_edge_index_t found = METAGRAPH_INVALID_INDEX;
+    METAGRAPH_TEST_OK(metagraph_graph_find_edge(graph, second.id, &found));
+    METAGRAPH_TEST_ASSERT(found == second_index);
+
+    const metagraph_id_t edge_ids[] = {test_graph_make_id(101),
+                                       test_graph_make_id(0),
+                                       test_graph_make_id(100)};
+    metagraph_edge_index_t edge_indices[3];
+    size_t found_count = 0;
+    METAGRAPH_TEST_OK(metagraph_graph_find_edges(graph, edge_ids, 3,
+                                                 edge_indices, &found_count));
+    METAGRAPH_TEST_ASSERT(found_count == 2);
+    METAGRAPH_TEST_ASSERT(edge_indices[0] == second_index &&
+                          edge_indices[1] == METAGRAPH_INVALID_INDEX &&
+                          edge_indices[2] == first_index);
+
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static void test_graph_outgoing_edges_buffer_too_small(void) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint64_t i = 0; i < 4; i++) {
+        metagraph_node_metadata_t metadata = {.id = test_graph_make_id(i)};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &metadata, NULL));
+    }
+    for (uint64_t i = 1; i < 4; i++) {
+        const metagraph_id_t nodes[] = {test_graph_make_id(0),
+                                        test_graph_make_id(i)};
+        metagraph_edge_metadata_t edge = {.id = test_graph_make_id(100 + i),
+                                          .node_count = 2,
+                                          .nodes = nodes};
+        METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edge, NULL));
+    }
+
+    metagraph_edge_index_t edges[2];
+    size_t count = 0;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_graph_get_outgoing_edges(graph, 0, edges, 2, &count),
+        METAGRAPH_ERROR_BUFFER_TOO_SMALL);
+    METAGRAPH_TEST_ASSERT(count == 3);
+    METAGRAPH_TEST_ASSERT(edges[0] == 0 && edges[1] == 1);
+
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+int main(void) {
+    test_graph_create_empty();
+    test_graph_add_node_and_lookup();
+    test_graph_many_nodes_survive_rehash();
+    test_graph_max_nodes_exceeded();
+    test_graph_hyperedges_and_incidence();
+    test_graph_outgoing_edges_buffer_too_small();
+    return 0;
+}
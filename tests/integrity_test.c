@@ -0,0 +1,239 @@
+/*
+ * MetaGraph BLAKE3 and Merkle tree tests
+ */
+
+#include "metagraph/integrity.h"
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_INTEGRITY_LARGE_SIZE (5U * 1024U * 1024U + 123U)
+
+typedef struct {
+    size_t length;
+    const char *hex;
+} test_blake3_vector_t;
+
+// BLAKE3 of bytes i % 251, from the reference implementation
+static const test_blake3_vector_t test_blake3_vectors[] = {
+    {0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+    {1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+    {1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"},
+    {1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+    {1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+    {2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a"},
+    {2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"},
+    {3072, "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2"},
+    {4096, "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969"},
+    {8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+    {16384,
+     "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4"},
+    {31744,
+     "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47"},
+    {102400,
+     "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"},
+    {300000,
+     "6cc9dce05d4cff8c5bef5c5a24681e42b13f03e34a0bc5e66f65a91d48c944fa"},
+    {TEST_INTEGRITY_LARGE_SIZE,
+     "a0dc8c48f59eb0ec7cda7bb828c5edc2bde44bb5c57cb58c25e209961cfc9948"},
+};
+
+#define TEST_BLAKE3_VECTOR_COUNT                                               \
+    (sizeof(test_blake3_vectors) / sizeof(test_blake3_vectors[0]))
+
+static uint8_t *test_integrity_input(size_t size) {
+    uint8_t *data = malloc(size ? size : 1U);
+    METAGRAPH_TEST_ASSERT(data != NULL);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)(i % 251U);
+    }
+    return data;
+}
+
+static void test_integrity_expect_hex(const metagraph_blake3_hash_t *hash,
+                                      const char *expected) {
+    char hex[METAGRAPH_BLAKE3_HEX_SIZE];
+    METAGRAPH_TEST_OK(metagraph_blake3_hash_to_string(hash, hex, sizeof(hex)));
+    METAGRAPH_TEST_ASSERT(strcmp(hex, expected) == 0);
+}
+
+static void test_blake3_vectors_all_kernels(uint8_t *input) {
+    const metagraph_blake3_implementation_t kernels[] = {
+        METAGRAPH_BLAKE3_PORTABLE,
+        METAGRAPH_BLAKE3_SSE41,
+        METAGRAPH_BLAKE3_AVX2,
+        METAGRAPH_BLAKE3_AVX512,
+    };
+    const metagraph_blake3_implementation_t original =
+        metagraph_blake3_get_implementation();
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!metagraph_blake3_implementation_available(kernels[k])) {
+            METAGRAPH_TEST_EXPECT(
+                metagraph_blake3_set_implementation(kernels[k]),
+                METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+            continue;
+        }
+        METAGRAPH_TEST_OK(metagraph_blake3_set_implementation(kernels[k]));
+        METAGRAPH_TEST_ASSERT(metagraph_blake3_get_implementation() ==
+                              kernels[k]);
+        for (size_t v = 0; v < TEST_BLAKE3_VECTOR_COUNT; v++) {
+            metagraph_blake3_hash_t hash;
+            METAGRAPH_TEST_OK(metagraph_blake3_hash_parallel(
+                input, test_blake3_vectors[v].length, 1, &hash));
+            test_integrity_expect_hex(&hash, test_blake3_vectors[v].hex);
+        }
+    }
+    METAGRAPH_TEST_OK(metagraph_blake3_set_implementation(original));
+
+    metagraph_blake3_hash_t abc;
+    METAGRAPH_TEST_OK(metagraph_blake3_hash("abc", 3, &abc));
+    test_integrity_expect_hex(
+        &abc, "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85");
+
+    char small[8];
+    METAGRAPH_TEST_EXPECT(
+        metagraph_blake3_hash_to_string(&abc, small, sizeof(small)),
+        METAGRAPH_ERROR_BUFFER_TOO_SMALL);
+}
+
+static void test_blake3_parallel_and_verify(uint8_t *input) {
+    const test_blake3_vector_t *large =
+        &test_blake3_vectors[TEST_BLAKE3_VECTOR_COUNT - 1U];
+    const uint32_t thread_counts[] = {0, 2, 3, 8};
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]);
+         i++) {
+        metagraph_blake3_hash_t hash;
+        METAGRAPH_TEST_OK(metagraph_blake3_hash_parallel(
+            input, large->length, thread_counts[i], &hash));
+        test_integrity_expect_hex(&hash, large->hex);
+    }
+
+    metagraph_blake3_hash_t hash;
+    METAGRAPH_TEST_OK(metagraph_blake3_hash(input, large->length, &hash));
+    test_integrity_expect_hex(&hash, large->hex);
+    METAGRAPH_TEST_OK(metagraph_blake3_verify(input, large->length, &hash));
+
+    input[large->length / 2U] ^= 1U;
+    METAGRAPH_TEST_EXPECT(metagraph_blake3_verify(input, large->length, &hash),
+                          METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    input[large->length / 2U] ^= 1U;
+}
+
+static void test_blake3_streaming(const uint8_t *input) {
+    // Odd split sizes cross block, chunk and subtree boundaries.
+    const size_t splits[] = {1, 63, 64, 65, 1000, 1024, 3000, 8192, 70000};
+    for (size_t v = 0; v < TEST_BLAKE3_VECTOR_COUNT; v++) {
+        const size_t length = test_blake3_vectors[v].length;
+        for (size_t s = 0; s < sizeof(splits) / sizeof(splits[0]); s++) {
+            if (splits[s] < 64U && length > 102400U) {
+                continue; // covered by the smaller vectors
+            }
+            metagraph_blake3_context_t *context = NULL;
+            METAGRAPH_TEST_OK(metagraph_blake3_context_create(&context));
+            size_t offset = 0;
+            size_t step = splits[s];
+            while (offset < length) {
+                size_t take = length - offset < step ? length - offset : step;
+                METAGRAPH_TEST_OK(
+                    metagraph_blake3_update(context, input + offset, take));
+                offset += take;
+                step = step * 3U + 1U; // vary the stride
+            }
+            metagraph_blake3_hash_t hash;
+            METAGRAPH_TEST_OK(metagraph_blake3_finalize(context, &hash));
+            test_integrity_expect_hex(&hash, test_blake3_vectors[v].hex);
+            // finalize leaves the context usable
+            METAGRAPH_TEST_OK(metagraph_blake3_finalize(context, &hash));
+            test_integrity_expect_hex(&hash, test_blake3_vectors[v].hex);
+            METAGRAPH_TEST_OK(metagraph_blake3_context_destroy(context));
+        }
+    }
+}
+
+static void test_merkle_tree(uint8_t *input) {
+    const size_t sizes[] = {0, 1000, 4096, 5000, 102400, 300000};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        metagraph_merkle_tree_t *tree = NULL;
+        METAGRAPH_TEST_OK(
+            metagraph_merkle_tree_create(input, sizes[s], 4096, &tree));
+        METAGRAPH_TEST_ASSERT(tree->chunk_size == 4096U);
+
+        metagraph_blake3_hash_t expected;
+        METAGRAPH_TEST_OK(metagraph_blake3_hash(input, sizes[s], &expected));
+        METAGRAPH_TEST_ASSERT(memcmp(tree->root_hash.bytes, expected.bytes,
+                                     sizeof(expected.bytes)) == 0);
+
+        const size_t leaves = tree->levels[0].count;
+        for (size_t i = 0; i < leaves; i++) {
+            const size_t offset = i * 4096U;
+            const size_t length =
+                sizes[s] - offset < 4096U ? sizes[s] - offset : 4096U;
+            METAGRAPH_TEST_OK(metagraph_merkle_tree_verify_chunk(
+                tree, i, input + offset, length));
+
+            metagraph_merkle_proof_t proof;
+            METAGRAPH_TEST_OK(metagraph_merkle_tree_get_proof(tree, i, &proof));
+            METAGRAPH_TEST_OK(metagraph_merkle_verify_proof(
+                input + offset, length, &proof, &tree->root_hash));
+            if (length > 0) {
+                input[offset] ^= 0x80U;
+                METAGRAPH_TEST_EXPECT(
+                    metagraph_merkle_verify_proof(input + offset, length,
+                                                  &proof, &tree->root_hash),
+                    METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+                input[offset] ^= 0x80U;
+            }
+        }
+        METAGRAPH_TEST_EXPECT(
+            metagraph_merkle_tree_verify_chunk(tree, leaves, input, 0),
+            METAGRAPH_ERROR_INVALID_ARGUMENT);
+        METAGRAPH_TEST_OK(metagraph_merkle_tree_destroy(tree));
+    }
+}
+
+static void test_merkle_tamper_detection(uint8_t *input) {
+    const size_t size = 300000;
+    metagraph_merkle_tree_t *tree = NULL;
+    METAGRAPH_TEST_OK(metagraph_merkle_tree_create(input, size, 0, &tree));
+    METAGRAPH_TEST_ASSERT(tree->chunk_size ==
+                          METAGRAPH_MERKLE_DEFAULT_CHUNK_SIZE);
+    METAGRAPH_TEST_OK(metagraph_merkle_tree_verify_range(tree, input, 0, size));
+
+    // Only the chunks overlapping the range are checked.
+    input[200000] ^= 1U;
+    METAGRAPH_TEST_OK(metagraph_merkle_tree_verify_range(tree, input, 0,
+                                                         131072));
+    METAGRAPH_TEST_EXPECT(
+        metagraph_merkle_tree_verify_range(tree, input, 196608, 10),
+        METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_merkle_tree_verify_chunk(tree, 3, input + 196608, 65536),
+        METAGRAPH_ERROR_CHECKSUM_MISMATCH);
+    input[200000] ^= 1U;
+
+    METAGRAPH_TEST_EXPECT(
+        metagraph_merkle_tree_verify_range(tree, input, size, 1),
+        METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_OK(metagraph_merkle_tree_destroy(tree));
+
+    metagraph_merkle_tree_t *bad = NULL;
+    METAGRAPH_TEST_EXPECT(metagraph_merkle_tree_create(input, size, 3000, &bad),
+                          METAGRAPH_ERROR_INVALID_SIZE);
+    METAGRAPH_TEST_EXPECT(metagraph_merkle_tree_create(input, size, 512, &bad),
+                          METAGRAPH_ERROR_INVALID_SIZE);
+}
+
+int main(void) {
+    uint8_t *input = test_integrity_input(TEST_INTEGRITY_LARGE_SIZE);
+    test_blake3_vectors_all_kernels(input);
+    test_blake3_parallel_and_verify(input);
+    test_blake3_streaming(input);
+    test_merkle_tree(input);
+    test_merkle_tamper_detection(input);
+    free(input);
+    return 0;
+}
@@ -0,0 +1,393 @@
+/*
+ * MetaGraph arena, object pool and thread-local pool tests
+ */
+
+#include "metagraph/memory.h"
+#include "metagraph/numa.h"
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#define TEST_MEMORY_THREADS 4
+#define TEST_MEMORY_ROUNDS 2000
+
+static metagraph_memory_pool_t *test_memory_arena(size_t block_size,
+                                                  size_t max_size,
+                                                  bool allow_growth) {
+    const metagraph_pool_config_t config = {
+        .type = METAGRAPH_POOL_TYPE_ARENA,
+        .initial_size = block_size,
+        .max_size = max_size,
+        .allow_growth = allow_growth,
+    };
+    metagraph_memory_pool_t *arena = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_create(&config, &arena));
+    return arena;
+}
+
+static void test_arena_alignment_and_growth(void) {
+    metagraph_memory_pool_t *arena = test_memory_arena(256, 0, true);
+
+    void *first = NULL;
+    void *second = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 3, &first));
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 8, &second));
+    METAGRAPH_TEST_ASSERT((uintptr_t)first % 16U == 0);
+    METAGRAPH_TEST_ASSERT((uintptr_t)second % 16U == 0);
+    METAGRAPH_TEST_ASSERT(second != first);
+
+    void *wide = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_memory_pool_aligned_alloc(arena, 64, 128, &wide));
+    METAGRAPH_TEST_ASSERT((uintptr_t)wide % 128U == 0);
+
+    // Larger than a block: the arena reserves a dedicated one.
+    void *big = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 4096, &big));
+    memset(big, 0xAB, 4096);
+
+    metagraph_pool_stats_t stats;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_get_stats(arena, &stats));
+    METAGRAPH_TEST_ASSERT(stats.allocation_count == 4);
+    METAGRAPH_TEST_ASSERT(stats.growth_count >= 1);
+    METAGRAPH_TEST_ASSERT(stats.total_size >= 256 + 4096);
+    METAGRAPH_TEST_ASSERT(stats.allocated_size >= 3 + 8 + 64 + 4096);
+
+    METAGRAPH_TEST_EXPECT(
+        metagraph_memory_pool_aligned_alloc(arena, 8, 24, &first),
+        METAGRAPH_ERROR_INVALID_ALIGNMENT_VALUE);
+    METAGRAPH_TEST_EXPECT(metagraph_memory_pool_alloc(arena, 0, &first),
+                          METAGRAPH_ERROR_INVALID_SIZE);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_destroy(arena));
+}
+
+static void test_arena_checkpoint_restore(void) {
+    metagraph_memory_pool_t *arena = test_memory_arena(128, 0, true);
+
+    void *kept = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 32, &kept));
+    metagraph_arena_checkpoint_t checkpoint;
+    METAGRAPH_TEST_OK(metagraph_arena_checkpoint(arena, &checkpoint));
+
+    // Spill across several blocks, then roll back.
+    void *after = NULL;
+    for (int i = 0; i < 16; i++) {
+        void *ptr = NULL;
+        METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 48, &ptr));
+        if (i == 0) {
+            after = ptr;
+        }
+    }
+    metagraph_pool_stats_t before_restore;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_get_stats(arena, &before_restore));
+    METAGRAPH_TEST_OK(metagraph_arena_restore(arena, &checkpoint));
+
+    void *again = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 48, &again));
+    METAGRAPH_TEST_ASSERT(again == after);
+
+    // Replaying the same pattern reuses the retained blocks.
+    METAGRAPH_TEST_OK(metagraph_arena_restore(arena, &checkpoint));
+    for (int i = 0; i < 16; i++) {
+        void *ptr = NULL;
+        METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 48, &ptr));
+    }
+    metagraph_pool_stats_t after_replay;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_get_stats(arena, &after_replay));
+    METAGRAPH_TEST_ASSERT(after_replay.total_size == before_restore.total_size);
+    METAGRAPH_TEST_ASSERT(after_replay.allocated_size ==
+                          before_restore.allocated_size);
+
+    METAGRAPH_TEST_OK(metagraph_arena_reset(arena));
+    void *reset = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 32, &reset));
+    METAGRAPH_TEST_ASSERT(reset == kept);
+
+    // Freeing the most recent allocation hands its space back.
+    void *top = NULL;
+    void *reused = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 16, &top));
+    METAGRAPH_TEST_OK(metagraph_memory_pool_free(arena, top));
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 16, &reused));
+    METAGRAPH_TEST_ASSERT(reused == top);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_destroy(arena));
+}
+
+static void test_arena_exhaustion_and_fragmentation(void) {
+    metagraph_memory_pool_t *fixed = test_memory_arena(256, 0, false);
+    void *ptr = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(fixed, 200, &ptr));
+    METAGRAPH_TEST_EXPECT(metagraph_memory_pool_alloc(fixed, 100, &ptr),
+                          METAGRAPH_ERROR_POOL_EXHAUSTED);
+    METAGRAPH_TEST_ASSERT(ptr == NULL);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_destroy(fixed));
+
+    // Two half-used blocks hold enough bytes in total, but not in one run.
+    metagraph_memory_pool_t *capped = test_memory_arena(256, 512, true);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(capped, 160, &ptr));
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(capped, 160, &ptr));
+    METAGRAPH_TEST_OK(metagraph_arena_reset(capped));
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(capped, 160, &ptr));
+    METAGRAPH_TEST_EXPECT(metagraph_memory_pool_alloc(capped, 300, &ptr),
+                          METAGRAPH_ERROR_FRAGMENTATION);
+    METAGRAPH_TEST_EXPECT(metagraph_memory_pool_alloc(capped, 600, &ptr),
+                          METAGRAPH_ERROR_POOL_EXHAUSTED);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_destroy(capped));
+}
+
+static void test_object_pool(void) {
+    const metagraph_pool_config_t config = {
+        .type = METAGRAPH_POOL_TYPE_OBJECT,
+        .initial_size = 4 * 48,
+        .max_size = 8 * 48,
+        .alignment = 16,
+        .object_size = 40,
+        .allow_growth = true,
+    };
+    metagraph_memory_pool_t *pool = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_create(&config, &pool));
+
+    void *objects[8] = {0};
+    for (int i = 0; i < 8; i++) {
+        METAGRAPH_TEST_OK(metagraph_object_pool_acquire(pool, &objects[i]));
+        METAGRAPH_TEST_ASSERT((uintptr_t)objects[i] % 16U == 0);
+        memset(objects[i], i, 40);
+    }
+    void *overflow = NULL;
+    METAGRAPH_TEST_EXPECT(metagraph_object_pool_acquire(pool, &overflow),
+                          METAGRAPH_ERROR_POOL_EXHAUSTED);
+    METAGRAPH_TEST_EXPECT(metagraph_memory_pool_alloc(pool, 41, &overflow),
+                          METAGRAPH_ERROR_INVALID_SIZE);
+
+    METAGRAPH_TEST_OK(metagraph_object_pool_release(pool, objects[3]));
+    void *recycled = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(pool, 24, &recycled));
+    METAGRAPH_TEST_ASSERT(recycled == objects[3]);
+
+    metagraph_pool_stats_t stats;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_get_stats(pool, &stats));
+    METAGRAPH_TEST_ASSERT(stats.allocation_count == 9);
+    METAGRAPH_TEST_ASSERT(stats.deallocation_count == 1);
+    METAGRAPH_TEST_ASSERT(stats.growth_count == 1);
+    METAGRAPH_TEST_ASSERT(stats.allocated_size == stats.total_size);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_reset_stats(pool));
+    METAGRAPH_TEST_OK(metagraph_memory_pool_get_stats(pool, &stats));
+    METAGRAPH_TEST_ASSERT(stats.allocation_count == 0);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_destroy(pool));
+
+    const metagraph_pool_config_t missing_size = {
+        .type = METAGRAPH_POOL_TYPE_OBJECT,
+    };
+    METAGRAPH_TEST_EXPECT(metagraph_memory_pool_create(&missing_size, &pool),
+                          METAGRAPH_ERROR_INVALID_SIZE);
+}
+
+typedef struct {
+    uint32_t binds;
+    uint32_t last_node;
+    size_t bound_bytes;
+} test_numa_record_t;
+
+static const uint32_t test_numa_cpu_nodes[4] = {0, 0, 1, 1};
+
+static metagraph_result_t test_numa_topology(void *context,
+                                             metagraph_numa_topology_t *out) {
+    (void)context;
+    *out = (metagraph_numa_topology_t){
+        .node_count = 2,
+        .cpu_count = 4,
+        .cpu_nodes = test_numa_cpu_nodes,
+    };
+    return METAGRAPH_OK();
+}
+
+static uint32_t test_numa_current(void *context) {
+    (void)context;
+    return 1;
+}
+
+static metagraph_result_t test_numa_bind(void *context, void *address,
+                                         size_t size, uint32_t node) {
+    test_numa_record_t *record = context;
+    METAGRAPH_TEST_ASSERT((uintptr_t)address % 4096U == 0);
+    METAGRAPH_TEST_ASSERT(size > 0 && size % 4096U == 0);
+    record->binds++;
+    record->last_node = node;
+    record->bound_bytes += size;
+    return METAGRAPH_OK();
+}
+
+static void test_numa_pool_binding(void) {
+    test_numa_record_t record = {0};
+    const metagraph_numa_source_t source = {
+        .get_topology = test_numa_topology,
+        .current_node = test_numa_current,
+        .bind = test_numa_bind,
+        .context = &record,
+    };
+    METAGRAPH_TEST_OK(metagraph_numa_set_source(&source));
+
+    metagraph_numa_topology_t topology;
+    METAGRAPH_TEST_OK(metagraph_get_numa_topology(&topology));
+    METAGRAPH_TEST_ASSERT(topology.node_count == 2);
+    METAGRAPH_TEST_ASSERT(topology.cpu_nodes[3] == 1);
+    METAGRAPH_TEST_ASSERT(metagraph_numa_current_node() == 1);
+
+    // Binding covers the existing block; growth binds each new one.
+    metagraph_memory_pool_t *arena = test_memory_arena(64 * 1024, 0, true);
+    uint32_t node = 0;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_get_numa_node(arena, &node));
+    METAGRAPH_TEST_ASSERT(node == METAGRAPH_NUMA_NODE_ANY);
+    METAGRAPH_TEST_EXPECT(metagraph_memory_pool_bind_numa(arena, 2),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_ASSERT(record.binds == 0);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_bind_numa(arena, 1));
+    METAGRAPH_TEST_OK(metagraph_memory_pool_get_numa_node(arena, &node));
+    METAGRAPH_TEST_ASSERT(node == 1);
+    METAGRAPH_TEST_ASSERT(record.binds == 1 && record.last_node == 1);
+    METAGRAPH_TEST_ASSERT(record.bound_bytes >= 56 * 1024);
+
+    void *big = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 128 * 1024, &big));
+    METAGRAPH_TEST_ASSERT(record.binds == 2);
+
+    // Dropping the preference leaves later blocks unbound.
+    METAGRAPH_TEST_OK(
+        metagraph_memory_pool_bind_numa(arena, METAGRAPH_NUMA_NODE_ANY));
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 128 * 1024, &big));
+    METAGRAPH_TEST_ASSERT(record.binds == 2);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_destroy(arena));
+
+    const metagraph_pool_config_t config = {
+        .type = METAGRAPH_POOL_TYPE_OBJECT,
+        .initial_size = 32 * 1024,
+        .object_size = 256,
+        .allow_growth = true,
+    };
+    metagraph_memory_pool_t *objects = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_create(&config, &objects));
+    record = (test_numa_record_t){0};
+    METAGRAPH_TEST_OK(metagraph_memory_pool_bind_numa(objects, 0));
+    METAGRAPH_TEST_ASSERT(record.binds == 1 && record.last_node == 0);
+    void *slot = NULL;
+    for (int i = 0; i <= 32 * 1024 / 256; i++) {
+        METAGRAPH_TEST_OK(metagraph_object_pool_acquire(objects, &slot));
+    }
+    METAGRAPH_TEST_ASSERT(record.binds == 2);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_destroy(objects));
+
+    const metagraph_numa_source_t incomplete = {
+        .get_topology = test_numa_topology,
+    };
+    METAGRAPH_TEST_EXPECT(metagraph_numa_set_source(&incomplete),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+
+    // The system source always reports at least one node, and binding to
+    // it is accepted even on single-node machines.
+    METAGRAPH_TEST_OK(metagraph_numa_set_source(NULL));
+    METAGRAPH_TEST_OK(metagraph_get_numa_topology(&topology));
+    METAGRAPH_TEST_ASSERT(topology.node_count >= 1);
+    METAGRAPH_TEST_ASSERT(topology.cpu_count >= 1);
+    METAGRAPH_TEST_ASSERT(metagraph_numa_current_node() < topology.node_count);
+    arena = test_memory_arena(64 * 1024, 0, true);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_bind_numa(arena, 0));
+    METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(arena, 128 * 1024, &big));
+    memset(big, 0x5A, 128 * 1024);
+    METAGRAPH_TEST_OK(metagraph_memory_pool_destroy(arena));
+}
+
+static void test_thread_local_pool_basics(void) {
+    metagraph_thread_local_pool_t *pool = NULL;
+    METAGRAPH_TEST_OK(metagraph_thread_local_pool_create(NULL, &pool));
+
+    void *small = NULL;
+    void *medium = NULL;
+    void *large = NULL;
+    METAGRAPH_TEST_OK(metagraph_thread_local_alloc(pool, 1, &small));
+    METAGRAPH_TEST_OK(metagraph_thread_local_alloc(pool, 700, &medium));
+    METAGRAPH_TEST_OK(metagraph_thread_local_alloc(
+        pool, METAGRAPH_THREAD_LOCAL_MAX_SMALL_SIZE * 3U, &large));
+    METAGRAPH_TEST_ASSERT((uintptr_t)small % 16U == 0);
+    METAGRAPH_TEST_ASSERT((uintptr_t)medium % 16U == 0);
+    memset(medium, 0x5A, 700);
+    memset(large, 0xA5, METAGRAPH_THREAD_LOCAL_MAX_SMALL_SIZE * 3U);
+
+    // A freed slot comes straight back from the magazine.
+    METAGRAPH_TEST_OK(metagraph_thread_local_free(pool, medium));
+    void *again = NULL;
+    METAGRAPH_TEST_OK(metagraph_thread_local_alloc(pool, 600, &again));
+    METAGRAPH_TEST_ASSERT(again == medium);
+
+    METAGRAPH_TEST_OK(metagraph_thread_local_free(pool, small));
+    METAGRAPH_TEST_OK(metagraph_thread_local_free(pool, again));
+    METAGRAPH_TEST_OK(metagraph_thread_local_free(pool, large));
+    METAGRAPH_TEST_OK(metagraph_thread_local_free(pool, NULL));
+    METAGRAPH_TEST_OK(metagraph_thread_local_pool_flush(pool));
+    METAGRAPH_TEST_OK(metagraph_thread_local_pool_destroy(pool));
+
+    const metagraph_pool_config_t capped = {.max_size = 64U * 1024U};
+    METAGRAPH_TEST_OK(metagraph_thread_local_pool_create(&capped, &pool));
+    METAGRAPH_TEST_OK(metagraph_thread_local_alloc(pool, 32, &small));
+    METAGRAPH_TEST_EXPECT(metagraph_thread_local_alloc(pool, 64, &medium),
+                          METAGRAPH_ERROR_POOL_EXHAUSTED);
+    METAGRAPH_TEST_OK(metagraph_thread_local_pool_destroy(pool));
+}
+
+#if !defined(_WIN32)
+static void *test_thread_local_worker(void *arg) {
+    metagraph_thread_local_pool_t *pool = arg;
+    void *live[64] = {0};
+    for (int round = 0; round < TEST_MEMORY_ROUNDS; round++) {
+        const int slot = round % 64;
+        if (live[slot]) {
+            const unsigned char *bytes = live[slot];
+            METAGRAPH_TEST_ASSERT(bytes[0] == (unsigned char)slot);
+            METAGRAPH_TEST_OK(metagraph_thread_local_free(pool, live[slot]));
+        }
+        const size_t size = 16U + (size_t)(round % 13) * 40U;
+        METAGRAPH_TEST_OK(
+            metagraph_thread_local_alloc(pool, size, &live[slot]));
+        memset(live[slot], slot, size);
+    }
+    for (int slot = 0; slot < 64; slot++) {
+        METAGRAPH_TEST_OK(metagraph_thread_local_free(pool, live[slot]));
+    }
+    METAGRAPH_TEST_OK(metagraph_thread_local_pool_flush(pool));
+    return NULL;
+}
+
+static void test_thread_local_pool_concurrent(void) {
+    metagraph_thread_local_pool_t *pool = NULL;
+    METAGRAPH_TEST_OK(metagraph_thread_local_pool_create(NULL, &pool));
+    pthread_t threads[TEST_MEMORY_THREADS];
+    for (int i = 0; i < TEST_MEMORY_THREADS; i++) {
+        METAGRAPH_TEST_ASSERT(pthread_create(&threads[i], NULL,
+                                             test_thread_local_worker,
+                                             pool) == 0);
+    }
+    for (int i = 0; i < TEST_MEMORY_THREADS; i++) {
+        METAGRAPH_TEST_ASSERT(pthread_join(threads[i], NULL) == 0);
+    }
+    METAGRAPH_TEST_OK(metagraph_thread_local_pool_destroy(pool));
+}
+#endif
+
+int main(void) {
+    test_arena_alignment_and_growth();
+    test_arena_checkpoint_restore();
+    test_arena_exhaustion_and_fragmentation();
+    test_object_pool();
+    test_numa_pool_binding();
+    test_thread_local_pool_basics();
+#if !defined(_WIN32)
+    test_thread_local_pool_concurrent();
+#endif
+    return 0;
+}
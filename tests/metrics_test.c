@@ -0,0 +1,251 @@
+/*
+ * MetaGraph runtime metrics tests
+ */
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/memory.h"
+#include "metagraph/metrics.h"
+#include "metagraph/result.h"
+#include "metagraph/traversal.h"
+
+#include "test_utils.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#define TEST_METRICS_PATH "metrics_test.mgb"
+#define TEST_METRICS_NODES 64U
+#define TEST_METRICS_THREADS 4
+#define TEST_METRICS_LOOKUPS 1000U
+
+static metagraph_id_t test_metrics_id(uint64_t value) {
+    return (metagraph_id_t){.high = 0x5EEDULL, .low = value};
+}
+
+// A chain 0 -> 1 -> ... -> TEST_METRICS_NODES - 1.
+static metagraph_graph_t *test_metrics_chain(void) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint64_t i = 0; i < TEST_METRICS_NODES; i++) {
+        const metagraph_node_metadata_t node = {.id = test_metrics_id(i)};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    for (uint64_t i = 0; i + 1U < TEST_METRICS_NODES; i++) {
+        metagraph_id_t members[2] = {test_metrics_id(i),
+                                     test_metrics_id(i + 1U)};
+        const metagraph_edge_metadata_t edge = {
+            .id = test_metrics_id(1000U + i),
+            .weight = 1.0F,
+            .node_count = 2,
+            .nodes = members,
+        };
+        METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edge, NULL));
+    }
+    return graph;
+}
+
+static uint64_t test_metrics_delta(const metagraph_metrics_snapshot_t *before,
+                                   const metagraph_metrics_snapshot_t *after,
+                                   metagraph_counter_t counter) {
+    return after->counters[counter] - before->counters[counter];
+}
+
+static void test_metrics_events(void) {
+    metagraph_metrics_snapshot_t *before = malloc(sizeof(*before));
+    metagraph_metrics_snapshot_t *after = malloc(sizeof(*after));
+    METAGRAPH_TEST_ASSERT(before && after);
+    metagraph_graph_t *graph = test_metrics_chain();
+    METAGRAPH_TEST_OK(metagraph_metrics_snapshot(before));
+
+    metagraph_node_index_t index = 0;
+    for (uint64_t i = 0; i < TEST_METRICS_NODES; i++) {
+        METAGRAPH_TEST_OK(
+            metagraph_graph_find_node(graph, test_metrics_id(i), &index));
+    }
+    METAGRAPH_TEST_EXPECT(
+        metagraph_graph_find_node(graph, test_metrics_id(999U), &index),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+
+    const metagraph_traversal_context_t context = {.graph = graph};
+    METAGRAPH_TEST_OK(metagraph_traverse_dfs(&context, 0,
+                                             METAGRAPH_DFS_PREORDER, NULL,
+                                             NULL));
+    METAGRAPH_TEST_OK(
+        metagraph_traverse_bfs(&context, 0, NULL, NULL, NULL, NULL));
+
+    const metagraph_pool_config_t config = {
+        .type = METAGRAPH_POOL_TYPE_ARENA,
+        .initial_size = 4096,
+        .allow_growth = true,
+    };
+    metagraph_memory_pool_t *pool = NULL;
+    METAGRAPH_TEST_OK(metagraph_memory_pool_create(&config, &pool));
+    for (int i = 0; i < 10; i++) {
+        void *ptr = NULL;
+        METAGRAPH_TEST_OK(metagraph_memory_pool_alloc(pool, 32, &ptr));
+    }
+    METAGRAPH_TEST_OK(metagraph_memory_pool_destroy(pool));
+
+    METAGRAPH_TEST_OK(metagraph_metrics_snapshot(after));
+    METAGRAPH_TEST_ASSERT(
+        test_metrics_delta(before, after, METAGRAPH_COUNTER_LOOKUPS) ==
+        TEST_METRICS_NODES + 1U);
+    METAGRAPH_TEST_ASSERT(
+        test_metrics_delta(before, after, METAGRAPH_COUNTER_TRAVERSAL_STEPS) ==
+        2U * TEST_METRICS_NODES);
+    METAGRAPH_TEST_ASSERT(
+        test_metrics_delta(before, after, METAGRAPH_COUNTER_POOL_ALLOCS) ==
+        10U);
+    METAGRAPH_TEST_ASSERT(
+        test_metrics_delta(before, after, METAGRAPH_COUNTER_ERRORS) == 1U);
+    METAGRAPH_TEST_ASSERT(
+        metagraph_metrics_error_count(after, METAGRAPH_ERROR_NODE_NOT_FOUND) -
+            metagraph_metrics_error_count(before,
+                                          METAGRAPH_ERROR_NODE_NOT_FOUND) ==
+        1U);
+    METAGRAPH_TEST_ASSERT(
+        metagraph_metrics_error_count(after, METAGRAPH_ERROR_EDGE_NOT_FOUND) ==
+        metagraph_metrics_error_count(before, METAGRAPH_ERROR_EDGE_NOT_FOUND));
+    const metagraph_histogram_snapshot_t *traversals =
+        &after->histograms[METAGRAPH_HISTOGRAM_TRAVERSAL];
+    METAGRAPH_TEST_ASSERT(
+        traversals->count -
+            before->histograms[METAGRAPH_HISTOGRAM_TRAVERSAL].count ==
+        2U);
+
+    // Bundle lookups are timed one in 64; hydrations always.
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_write_graph(graph, TEST_METRICS_PATH, NULL));
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_METRICS_PATH, NULL, &bundle));
+    METAGRAPH_TEST_OK(metagraph_metrics_snapshot(before));
+    for (uint32_t i = 0; i < 128U; i++) {
+        METAGRAPH_TEST_OK(metagraph_bundle_find_node(
+            bundle, test_metrics_id(i % TEST_METRICS_NODES), &index));
+    }
+    METAGRAPH_TEST_OK(metagraph_metrics_snapshot(after));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+    (void)remove(TEST_METRICS_PATH);
+    METAGRAPH_TEST_ASSERT(
+        test_metrics_delta(before, after, METAGRAPH_COUNTER_LOOKUPS) == 128U);
+    METAGRAPH_TEST_ASSERT(
+        after->histograms[METAGRAPH_HISTOGRAM_LOOKUP].count -
+            before->histograms[METAGRAPH_HISTOGRAM_LOOKUP].count ==
+        2U);
+    METAGRAPH_TEST_ASSERT(
+        test_metrics_delta(before, after, METAGRAPH_COUNTER_HYDRATIONS) >= 1U);
+    METAGRAPH_TEST_ASSERT(
+        after->histograms[METAGRAPH_HISTOGRAM_HYDRATION].count -
+            before->histograms[METAGRAPH_HISTOGRAM_HYDRATION].count ==
+        test_metrics_delta(before, after, METAGRAPH_COUNTER_HYDRATIONS));
+
+    METAGRAPH_TEST_EXPECT(metagraph_metrics_snapshot(NULL),
+                          METAGRAPH_ERROR_NULL_POINTER);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+    free(before);
+    free(after);
+}
+
+static void test_metrics_histogram_math(void) {
+    // Every bucket starts where the previous one ends, 1/16 apart at most.
+    for (uint32_t b = 1; b < METAGRAPH_METRICS_BUCKETS; b++) {
+        const uint64_t lower = metagraph_metrics_bucket_lower_bound(b);
+        const uint64_t previous = metagraph_metrics_bucket_lower_bound(b - 1U);
+        METAGRAPH_TEST_ASSERT(lower > previous);
+        METAGRAPH_TEST_ASSERT(b < 32U || (lower - previous) * 16U <= lower);
+    }
+    METAGRAPH_TEST_ASSERT(metagraph_metrics_bucket_lower_bound(31) == 31U);
+    METAGRAPH_TEST_ASSERT(metagraph_metrics_bucket_lower_bound(32) == 32U);
+    METAGRAPH_TEST_ASSERT(metagraph_metrics_bucket_lower_bound(48) == 64U);
+
+    metagraph_histogram_snapshot_t *histogram = calloc(1, sizeof(*histogram));
+    METAGRAPH_TEST_ASSERT(histogram != NULL);
+    METAGRAPH_TEST_ASSERT(metagraph_metrics_quantile(histogram, 0.5) == 0U);
+    histogram->buckets[10] = 90;
+    histogram->buckets[48] = 9;
+    histogram->buckets[100] = 1;
+    histogram->count = 100;
+    METAGRAPH_TEST_ASSERT(metagraph_metrics_quantile(histogram, 0.0) == 10U);
+    METAGRAPH_TEST_ASSERT(metagraph_metrics_quantile(histogram, 0.5) == 10U);
+    METAGRAPH_TEST_ASSERT(metagraph_metrics_quantile(histogram, 0.95) == 64U);
+    METAGRAPH_TEST_ASSERT(metagraph_metrics_quantile(histogram, 1.0) ==
+                          metagraph_metrics_bucket_lower_bound(100));
+    free(histogram);
+
+    METAGRAPH_TEST_ASSERT(
+        strcmp(metagraph_metrics_counter_name(METAGRAPH_COUNTER_LOOKUPS),
+               "lookups") == 0);
+    METAGRAPH_TEST_ASSERT(
+        strcmp(metagraph_metrics_histogram_name(METAGRAPH_HISTOGRAM_TRAVERSAL),
+               "traversal_ns") == 0);
+}
+
+#if !defined(_WIN32)
+static void *test_metrics_worker(void *arg) {
+    const metagraph_graph_t *graph = arg;
+    metagraph_node_index_t index = 0;
+    for (uint32_t i = 0; i < TEST_METRICS_LOOKUPS; i++) {
+        METAGRAPH_TEST_OK(metagraph_graph_find_node(
+            graph, test_metrics_id(i % TEST_METRICS_NODES), &index));
+    }
+    return NULL;
+}
+
+static void test_metrics_run_workers(const metagraph_graph_t *graph) {
+    pthread_t workers[TEST_METRICS_THREADS];
+    for (int i = 0; i < TEST_METRICS_THREADS; i++) {
+        METAGRAPH_TEST_ASSERT(pthread_create(&workers[i], NULL,
+                                             test_metrics_worker,
+                                             (void *)(uintptr_t)graph) == 0);
+    }
+    for (int i = 0; i < TEST_METRICS_THREADS; i++) {
+        METAGRAPH_TEST_ASSERT(pthread_join(workers[i], NULL) == 0);
+    }
+}
+
+// Counts of exited threads survive, and their shards are reused: shards
+// only grow to the peak number of threads running at once.
+static void test_metrics_threads(void) {
+    metagraph_metrics_snapshot_t *before = malloc(sizeof(*before));
+    metagraph_metrics_snapshot_t *after = malloc(sizeof(*after));
+    METAGRAPH_TEST_ASSERT(before && after);
+    metagraph_graph_t *graph = test_metrics_chain();
+
+    METAGRAPH_TEST_OK(metagraph_metrics_snapshot(before));
+    test_metrics_run_workers(graph);
+    METAGRAPH_TEST_OK(metagraph_metrics_snapshot(after));
+    METAGRAPH_TEST_ASSERT(
+        test_metrics_delta(before, after, METAGRAPH_COUNTER_LOOKUPS) ==
+        (uint64_t)TEST_METRICS_THREADS * TEST_METRICS_LOOKUPS);
+
+    test_metrics_run_workers(graph);
+    METAGRAPH_TEST_OK(metagraph_metrics_snapshot(after));
+    METAGRAPH_TEST_ASSERT(
+        test_metrics_delta(before, after, METAGRAPH_COUNTER_LOOKUPS) ==
+        2U * TEST_METRICS_THREADS * TEST_METRICS_LOOKUPS);
+    // Without reuse the second batch would need shards of its own.
+    METAGRAPH_TEST_ASSERT(after->shard_count <=
+                          before->shard_count + TEST_METRICS_THREADS);
+
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+    free(before);
+    free(after);
+}
+#endif
+
+int main(void) {
+    test_metrics_events();
+    test_metrics_histogram_math();
+#if !defined(_WIN32)
+    test_metrics_threads();
+#endif
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * MetaGraph path normalization tests
+ */
+
+#include "metagraph/path.h"
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static void test_path_expect(const char *path, const char *expected) {
+    char normalized[METAGRAPH_PATH_MAX + 1U];
+    size_t length = 0;
+    METAGRAPH_TEST_OK(metagraph_path_normalize(path, normalized,
+                                               sizeof(normalized), &length));
+    if (strcmp(normalized, expected) != 0 || length != strlen(expected)) {
+        (void)fprintf(stderr, "normalize(\"%s\") = \"%s\", expected \"%s\"\n",
+                      path, normalized, expected);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void test_path_normalize_table(void) {
+    static const struct {
+        const char *path;
+        const char *expected;
+    } cases[] = {
+        {"textures/wood.png", "textures/wood.png"},
+        {"/assets/textures/wood.png", "/assets/textures/wood.png"},
+        {"assets//textures///wood.png", "assets/textures/wood.png"},
+        {"./assets/./textures/wood.png", "assets/textures/wood.png"},
+        {"assets/models/../textures/wood.png", "assets/textures/wood.png"},
+        {"assets/textures/", "assets/textures"},
+        {"/", "/"},
+        {"//", "/"},
+        {"/./", "/"},
+        {".", "."},
+        {"./", "."},
+        {"a/..", "."},
+        {"/a/..", "/"},
+        {"a/b/../../c", "c"},
+        {"assets/.hidden/file", "assets/.hidden/file"},
+        {"assets/..data/file", "assets/..data/file"},
+        {"file.tar.gz", "file.tar.gz"},
+        {"a/.../b", "a/.../b"},
+        // Long enough for the vectorized scan to see the pattern mid-chunk
+        // and across a chunk boundary.
+        {"assets/characters/hero/meshes/./body.mesh",
+         "assets/characters/hero/meshes/body.mesh"},
+        {"assets/character/", "assets/character"},
+        {"0123456789abcde//x", "0123456789abcde/x"},
+        {"0123456789abcde/./x", "0123456789abcde/x"},
+        {"0123456789abcdef0123456789abcdef/file",
+         "0123456789abcdef0123456789abcdef/file"},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        test_path_expect(cases[i].path, cases[i].expected);
+    }
+}
+
+static void test_path_normalize_errors(void) {
+    char normalized[16];
+    METAGRAPH_TEST_EXPECT(
+        metagraph_path_normalize("", normalized, sizeof(normalized), NULL),
+        METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_path_normalize("..", normalized, sizeof(normalized), NULL),
+        METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_EXPECT(metagraph_path_normalize("/a/../..", normalized,
+                                                   sizeof(normalized), NULL),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_EXPECT(metagraph_path_normalize("a/b/../../../c", normalized,
+                                                   sizeof(normalized), NULL),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_path_normalize(NULL, normalized, sizeof(normalized), NULL),
+        METAGRAPH_ERROR_NULL_POINTER);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_path_normalize("a", NULL, sizeof(normalized), NULL),
+        METAGRAPH_ERROR_NULL_POINTER);
+
+    // The normalized form must fit, not the input.
+    METAGRAPH_TEST_OK(metagraph_path_normalize("a/b/c/../../d", normalized, 4,
+                                               NULL));
+    METAGRAPH_TEST_ASSERT(strcmp(normalized, "a/d") == 0);
+    METAGRAPH_TEST_EXPECT(metagraph_path_normalize("a/d", normalized, 3, NULL),
+                          METAGRAPH_ERROR_BUFFER_TOO_SMALL);
+
+    static char long_path[METAGRAPH_PATH_MAX + 2U];
+    memset(long_path, 'a', METAGRAPH_PATH_MAX + 1U);
+    static char out[METAGRAPH_PATH_MAX + 2U];
+    METAGRAPH_TEST_EXPECT(
+        metagraph_path_normalize(long_path, out, sizeof(out), NULL),
+        METAGRAPH_ERROR_INVALID_SIZE);
+    long_path[METAGRAPH_PATH_MAX] = '\0';
+    METAGRAPH_TEST_OK(metagraph_path_normalize(long_path, out, sizeof(out),
+                                               NULL));
+}
+
+int main(void) {
+    test_path_normalize_table();
+    test_path_normalize_errors();
+    return 0;
+}
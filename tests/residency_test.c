@@ -0,0 +1,219 @@
+/*
+ * MetaGraph bundle residency policy tests
+ */
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/mmap.h"
+#include "metagraph/residency.h"
+#include "metagraph/result.h"
+
+#include "test_utils.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_RESIDENCY_PATH "residency_test.mgb"
+#define TEST_RESIDENCY_NODES 1536U
+#define TEST_RESIDENCY_PAYLOAD 4096U
+
+static metagraph_id_t test_residency_id(uint32_t node) {
+    return (metagraph_id_t){.high = 0x5245534944454E54ULL, .low = node + 1U};
+}
+
+// 6 MiB of payloads, so the STORE spans several 2 MiB ranges, and a chain
+// of edges so the EDGES section has adjacency to walk.
+static void test_residency_write(void) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    // Payloads are borrowed until the bundle is written.
+    unsigned char *payloads =
+        malloc((size_t)TEST_RESIDENCY_NODES * TEST_RESIDENCY_PAYLOAD);
+    METAGRAPH_TEST_ASSERT(payloads != NULL);
+    for (uint32_t i = 0; i < TEST_RESIDENCY_NODES; i++) {
+        unsigned char *payload = payloads + (size_t)i * TEST_RESIDENCY_PAYLOAD;
+        memset(payload, (int)(i & 0xFFU), TEST_RESIDENCY_PAYLOAD);
+        const metagraph_node_metadata_t node = {
+            .id = test_residency_id(i),
+            .data = payload,
+            .data_size = TEST_RESIDENCY_PAYLOAD,
+        };
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    for (uint32_t i = 0; i + 1U < TEST_RESIDENCY_NODES; i++) {
+        const metagraph_id_t members[2] = {test_residency_id(i),
+                                           test_residency_id(i + 1U)};
+        const metagraph_edge_metadata_t edge = {
+            .id = {.high = 1, .low = i + 1U},
+            .weight = 1.0F,
+            .node_count = 2,
+            .nodes = members,
+        };
+        METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edge, NULL));
+    }
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_write_graph(graph, TEST_RESIDENCY_PATH, NULL));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+    free(payloads);
+}
+
+static void test_residency_read(const metagraph_bundle_t *bundle,
+                                uint32_t node) {
+    metagraph_node_metadata_t metadata;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, node, &metadata));
+    METAGRAPH_TEST_ASSERT(((const unsigned char *)metadata.data)[0] ==
+                          (node & 0xFFU));
+}
+
+static void test_residency_mmap_query(void) {
+    metagraph_memory_map_t *map = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_mmap_create_from_file(TEST_RESIDENCY_PATH, NULL, &map));
+    size_t resident = 0;
+    size_t pages = 0;
+    METAGRAPH_TEST_OK(metagraph_mmap_residency(map, 0, map->mapped_size,
+                                               &resident, &pages));
+    METAGRAPH_TEST_ASSERT(pages >= map->mapped_size / 4096U);
+    METAGRAPH_TEST_ASSERT(resident <= pages);
+
+    // Touching a page makes it resident.
+    volatile const unsigned char *bytes = map->base_address;
+    (void)bytes[8192];
+    METAGRAPH_TEST_OK(metagraph_mmap_residency(map, 8192, 1, &resident,
+                                               &pages));
+    METAGRAPH_TEST_ASSERT(pages == 1 && resident == 1);
+    METAGRAPH_TEST_EXPECT(metagraph_mmap_residency(map, map->mapped_size, 1,
+                                                   &resident, &pages),
+                          METAGRAPH_ERROR_INVALID_SIZE);
+
+    const metagraph_result_t result =
+        metagraph_mmap_advise(map, 0, map->mapped_size, METAGRAPH_ADVICE_COLD);
+    METAGRAPH_TEST_ASSERT(result == METAGRAPH_SUCCESS ||
+                          result == METAGRAPH_ERROR_PLATFORM_NOT_SUPPORTED);
+    METAGRAPH_TEST_OK(metagraph_mmap_destroy(map));
+}
+
+static void test_residency_access_patterns(void) {
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_RESIDENCY_PATH, NULL, &bundle));
+    const metagraph_residency_policy_t policy = {
+        .flags = METAGRAPH_RESIDENCY_HUGE_PAGES,
+        .hot_accesses = 256,
+    };
+    metagraph_residency_t *residency = NULL;
+    METAGRAPH_TEST_OK(metagraph_residency_create(bundle, &policy, &residency));
+    metagraph_residency_t *second = NULL;
+    METAGRAPH_TEST_EXPECT(metagraph_residency_create(bundle, NULL, &second),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+
+    // A scan in index order reads NODES sequentially.
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < TEST_RESIDENCY_NODES; i++) {
+            test_residency_read(bundle, i);
+        }
+    }
+    metagraph_residency_report_t report;
+    METAGRAPH_TEST_OK(metagraph_residency_tune(residency, &report));
+    const metagraph_residency_section_report_t *nodes =
+        &report.sections[METAGRAPH_SECTION_NODES];
+    METAGRAPH_TEST_ASSERT(nodes->present);
+    METAGRAPH_TEST_ASSERT(nodes->accesses >= TEST_RESIDENCY_NODES);
+    METAGRAPH_TEST_ASSERT(nodes->sequential * 2U >= nodes->accesses);
+    METAGRAPH_TEST_ASSERT(nodes->total_pages > 0);
+    METAGRAPH_TEST_ASSERT(nodes->resident_pages <= nodes->total_pages);
+    METAGRAPH_TEST_ASSERT(nodes->advice == METAGRAPH_ADVICE_SEQUENTIAL);
+    METAGRAPH_TEST_ASSERT(report.store_ranges >= 3);
+
+    // Hash probes and scattered reads are random.
+    uint32_t state = 12345U;
+    for (uint32_t i = 0; i < 4U * TEST_RESIDENCY_NODES; i++) {
+        state = state * 1103515245U + 12345U;
+        const uint32_t node = (state >> 8U) % TEST_RESIDENCY_NODES;
+        metagraph_node_index_t found = 0;
+        METAGRAPH_TEST_OK(metagraph_bundle_find_node(
+            bundle, test_residency_id(node), &found));
+        METAGRAPH_TEST_ASSERT(found == node);
+        test_residency_read(bundle, found);
+        const metagraph_edge_index_t *edges = NULL;
+        size_t edge_count = 0;
+        METAGRAPH_TEST_OK(metagraph_bundle_get_outgoing_edges(
+            bundle, found, &edges, &edge_count));
+    }
+    METAGRAPH_TEST_OK(metagraph_residency_tune(residency, &report));
+    METAGRAPH_TEST_ASSERT(report.sections[METAGRAPH_SECTION_NODES].advice ==
+                              METAGRAPH_ADVICE_RANDOM ||
+                          report.sections[METAGRAPH_SECTION_NODES].advice ==
+                              METAGRAPH_ADVICE_WILLNEED);
+    const metagraph_section_type_t probed[] = {METAGRAPH_SECTION_LOOKUP,
+                                               METAGRAPH_SECTION_EDGES};
+    for (size_t i = 0; i < 2; i++) {
+        const metagraph_residency_section_report_t *section =
+            &report.sections[probed[i]];
+        METAGRAPH_TEST_ASSERT(section->present);
+        METAGRAPH_TEST_ASSERT(section->accesses >= 256);
+        METAGRAPH_TEST_ASSERT(section->advice == METAGRAPH_ADVICE_RANDOM ||
+                              section->advice == METAGRAPH_ADVICE_WILLNEED);
+    }
+
+    // An idle interval keeps the advice in force.
+    METAGRAPH_TEST_OK(metagraph_residency_tune(residency, &report));
+    METAGRAPH_TEST_ASSERT(report.sections[METAGRAPH_SECTION_NODES].accesses ==
+                          0);
+    METAGRAPH_TEST_ASSERT(report.sections[METAGRAPH_SECTION_NODES].advice !=
+                          METAGRAPH_ADVICE_NORMAL);
+
+    metagraph_residency_destroy(residency);
+    METAGRAPH_TEST_OK(metagraph_residency_create(bundle, NULL, &residency));
+    metagraph_residency_destroy(residency);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+}
+
+static void test_residency_cold_store_ranges(void) {
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_create_from_file(TEST_RESIDENCY_PATH, NULL, &bundle));
+    const metagraph_residency_policy_t policy = {
+        .flags = METAGRAPH_RESIDENCY_PAGEOUT,
+        .cold_intervals = 1,
+        .pageout_intervals = 1,
+    };
+    metagraph_residency_t *residency = NULL;
+    METAGRAPH_TEST_OK(metagraph_residency_create(bundle, &policy, &residency));
+
+    // Only the first nodes' payloads, in the first STORE range, stay in use.
+    metagraph_residency_report_t report;
+    uint64_t cold_seen = 0;
+    for (uint32_t interval = 0; interval < 4; interval++) {
+        for (uint32_t i = 0; i < 64; i++) {
+            test_residency_read(bundle, i);
+        }
+        METAGRAPH_TEST_OK(metagraph_residency_tune(residency, &report));
+        if (report.cold_ranges > cold_seen) {
+            cold_seen = report.cold_ranges;
+        }
+    }
+    METAGRAPH_TEST_ASSERT(report.store_ranges >= 3);
+    METAGRAPH_TEST_ASSERT(cold_seen == report.store_ranges - 1U);
+    METAGRAPH_TEST_ASSERT(report.paged_out_ranges == report.store_ranges - 1U);
+    METAGRAPH_TEST_ASSERT(report.cold_ranges == 0);
+
+    // Reading a range again warms it back up.
+    test_residency_read(bundle, TEST_RESIDENCY_NODES - 1U);
+    METAGRAPH_TEST_OK(metagraph_residency_tune(residency, &report));
+    METAGRAPH_TEST_ASSERT(report.paged_out_ranges ==
+                          report.store_ranges - 2U);
+    metagraph_residency_destroy(residency);
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+}
+
+int main(void) {
+    test_residency_write();
+    test_residency_mmap_query();
+    test_residency_access_patterns();
+    test_residency_cold_store_ranges();
+    (void)remove(TEST_RESIDENCY_PATH);
+    return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * MetaGraph scheduler and task graph tests
+ */
+
+#include "metagraph/integrity.h"
+#include "metagraph/result.h"
+#include "metagraph/scheduler.h"
+
+#include "test_utils.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_SCHEDULER_TASKS 2000U
+#define TEST_SCHEDULER_MAX_DEPS 3U
+#define TEST_SCHEDULER_HASHES 8U
+#define TEST_SCHEDULER_HASH_SIZE (3U * 1024U * 1024U)
+
+static uint64_t test_scheduler_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t test_scheduler_random(uint32_t bound) {
+    test_scheduler_state =
+        test_scheduler_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)((test_scheduler_state >> 33U) % bound);
+}
+
+typedef struct {
+    uint32_t deps[TEST_SCHEDULER_TASKS][TEST_SCHEDULER_MAX_DEPS];
+    uint32_t count[TEST_SCHEDULER_TASKS];
+    _Atomic(bool) done[TEST_SCHEDULER_TASKS];
+    uint32_t failing; ///< Task that fails (UINT32_MAX = none)
+} test_scheduler_dag_t;
+
+typedef struct {
+    test_scheduler_dag_t *dag;
+    uint32_t id;
+} test_scheduler_task_t;
+
+static metagraph_result_t test_scheduler_dag_task(void *context) {
+    const test_scheduler_task_t *task = context;
+    test_scheduler_dag_t *dag = task->dag;
+    for (uint32_t i = 0; i < dag->count[task->id]; i++) {
+        METAGRAPH_TEST_ASSERT(atomic_load(&dag->done[dag->deps[task->id][i]]));
+    }
+    if (task->id == dag->failing) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE, "Task %u failed",
+                             task->id);
+    }
+    METAGRAPH_TEST_ASSERT(!atomic_exchange(&dag->done[task->id], true));
+    return METAGRAPH_OK();
+}
+
+// Random DAG whose edges point from later tasks to earlier ones, added in
+// reverse so that ID order is no help to the scheduler.
+static void test_scheduler_random_dag(metagraph_scheduler_t *scheduler) {
+    static test_scheduler_dag_t dag;
+    static test_scheduler_task_t contexts[TEST_SCHEDULER_TASKS];
+    memset(&dag, 0, sizeof(dag));
+    dag.failing = UINT32_MAX;
+    metagraph_task_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_task_graph_create(&graph));
+    for (uint32_t i = 0; i < TEST_SCHEDULER_TASKS; i++) {
+        const uint32_t id = TEST_SCHEDULER_TASKS - 1U - i;
+        contexts[i] = (test_scheduler_task_t){.dag = &dag, .id = id};
+        metagraph_task_id_t task_id = 0;
+        METAGRAPH_TEST_OK(metagraph_task_graph_add_task(
+            graph, test_scheduler_dag_task, &contexts[i], &task_id));
+        METAGRAPH_TEST_ASSERT(task_id == i);
+        atomic_init(&dag.done[id], false);
+        dag.count[id] = id ? test_scheduler_random(TEST_SCHEDULER_MAX_DEPS + 1U)
+                           : 0;
+        for (uint32_t d = 0; d < dag.count[id]; d++) {
+            dag.deps[id][d] = test_scheduler_random(id);
+        }
+    }
+    for (uint32_t id = 0; id < TEST_SCHEDULER_TASKS; id++) {
+        for (uint32_t d = 0; d < dag.count[id]; d++) {
+            METAGRAPH_TEST_OK(metagraph_task_graph_add_dependency(
+                graph, TEST_SCHEDULER_TASKS - 1U - id,
+                TEST_SCHEDULER_TASKS - 1U - dag.deps[id][d]));
+        }
+    }
+
+    metagraph_task_graph_stats_t stats;
+    METAGRAPH_TEST_OK(metagraph_task_graph_run(graph, scheduler, &stats));
+    METAGRAPH_TEST_ASSERT(stats.completed == TEST_SCHEDULER_TASKS &&
+                          stats.failed == 0 && stats.skipped == 0);
+
+    // A graph can be run again; a failure skips exactly its dependents.
+    dag.failing = 0;
+    for (uint32_t id = 0; id < TEST_SCHEDULER_TASKS; id++) {
+        atomic_store(&dag.done[id], false);
+    }
+    metagraph_clear_error_context();
+    METAGRAPH_TEST_EXPECT(metagraph_task_graph_run(graph, scheduler, &stats),
+                          METAGRAPH_ERROR_IO_FAILURE);
+    metagraph_error_context_t error;
+    METAGRAPH_TEST_OK(metagraph_get_error_context(&error));
+#if !defined(METAGRAPH_ERROR_NO_STRINGS)
+    METAGRAPH_TEST_ASSERT(strstr(error.message, "Task 0 failed") != NULL);
+#endif
+    size_t blocked = 1;
+    static bool reached[TEST_SCHEDULER_TASKS];
+    memset(reached, 0, sizeof(reached));
+    reached[0] = true;
+    for (uint32_t id = 1; id < TEST_SCHEDULER_TASKS; id++) {
+        for (uint32_t d = 0; !reached[id] && d < dag.count[id]; d++) {
+            reached[id] = reached[dag.deps[id][d]];
+        }
+        blocked += reached[id];
+        METAGRAPH_TEST_ASSERT(atomic_load(&dag.done[id]) != reached[id]);
+    }
+    METAGRAPH_TEST_ASSERT(stats.failed == 1 && stats.skipped == blocked - 1U &&
+                          stats.completed == TEST_SCHEDULER_TASKS - blocked);
+    METAGRAPH_TEST_OK(metagraph_task_graph_destroy(graph));
+}
+
+static metagraph_result_t test_scheduler_count_task(void *context) {
+    atomic_fetch_add((_Atomic(uint32_t) *)context, 1U);
+    return METAGRAPH_OK();
+}
+
+static void test_scheduler_graph_errors(void) {
+    _Atomic(uint32_t) runs = 0;
+    metagraph_task_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_task_graph_create(&graph));
+    METAGRAPH_TEST_OK(metagraph_task_graph_run(graph, NULL, NULL));
+    metagraph_task_id_t ids[3];
+    for (size_t i = 0; i < 3; i++) {
+        METAGRAPH_TEST_OK(metagraph_task_graph_add_task(
+            graph, test_scheduler_count_task, &runs, &ids[i]));
+    }
+    METAGRAPH_TEST_EXPECT(metagraph_task_graph_add_dependency(graph, ids[0],
+                                                              ids[0]),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_EXPECT(metagraph_task_graph_add_dependency(graph, ids[0], 3),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+    METAGRAPH_TEST_EXPECT(
+        metagraph_task_graph_add_task(graph, NULL, &runs, NULL),
+        METAGRAPH_ERROR_NULL_POINTER);
+
+    // 0 -> 1 -> 2 -> 0: refused before anything runs.
+    METAGRAPH_TEST_OK(
+        metagraph_task_graph_add_dependency(graph, ids[1], ids[0]));
+    METAGRAPH_TEST_OK(
+        metagraph_task_graph_add_dependency(graph, ids[2], ids[1]));
+    METAGRAPH_TEST_OK(metagraph_task_graph_run(graph, NULL, NULL));
+    METAGRAPH_TEST_ASSERT(atomic_load(&runs) == 3U);
+    METAGRAPH_TEST_OK(
+        metagraph_task_graph_add_dependency(graph, ids[0], ids[2]));
+    metagraph_task_graph_stats_t stats;
+    METAGRAPH_TEST_EXPECT(metagraph_task_graph_run(graph, NULL, &stats),
+                          METAGRAPH_ERROR_DEPENDENCY_CYCLE);
+    METAGRAPH_TEST_ASSERT(atomic_load(&runs) == 3U);
+    METAGRAPH_TEST_ASSERT(stats.completed == 0);
+    METAGRAPH_TEST_OK(metagraph_task_graph_destroy(graph));
+}
+
+typedef struct {
+    const uint8_t *data;
+    metagraph_blake3_hash_t hash;
+} test_scheduler_hash_task_t;
+
+static metagraph_result_t test_scheduler_hash_task(void *context) {
+    test_scheduler_hash_task_t *task = context;
+    return metagraph_blake3_hash_parallel(task->data, TEST_SCHEDULER_HASH_SIZE,
+                                          8, &task->hash);
+}
+
+// Tasks that fork work of their own on the shared scheduler while every
+// worker is busy must still finish.
+static void test_scheduler_nested(void) {
+    uint8_t *data = malloc(TEST_SCHEDULER_HASH_SIZE);
+    METAGRAPH_TEST_ASSERT(data != NULL);
+    for (size_t i = 0; i < TEST_SCHEDULER_HASH_SIZE; i++) {
+        data[i] = (uint8_t)(i * 31U + (i >> 12U));
+    }
+    metagraph_blake3_hash_t expected;
+    METAGRAPH_TEST_OK(
+        metagraph_blake3_hash(data, TEST_SCHEDULER_HASH_SIZE, &expected));
+
+    test_scheduler_hash_task_t tasks[TEST_SCHEDULER_HASHES];
+    metagraph_task_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_task_graph_create(&graph));
+    for (size_t i = 0; i < TEST_SCHEDULER_HASHES; i++) {
+        tasks[i].data = data;
+        METAGRAPH_TEST_OK(metagraph_task_graph_add_task(
+            graph, test_scheduler_hash_task, &tasks[i], NULL));
+    }
+    METAGRAPH_TEST_OK(metagraph_task_graph_run(graph, NULL, NULL));
+    for (size_t i = 0; i < TEST_SCHEDULER_HASHES; i++) {
+        METAGRAPH_TEST_ASSERT(memcmp(tasks[i].hash.bytes, expected.bytes,
+                                     sizeof(expected.bytes)) == 0);
+    }
+    METAGRAPH_TEST_OK(metagraph_task_graph_destroy(graph));
+    free(data);
+}
+
+int main(void) {
+    // A private scheduler can come and go before the shared one exists.
+    metagraph_scheduler_t *early = NULL;
+    METAGRAPH_TEST_OK(metagraph_scheduler_create(1, &early));
+    METAGRAPH_TEST_OK(metagraph_scheduler_destroy(early));
+
+    metagraph_scheduler_t *shared = NULL;
+    metagraph_scheduler_t *again = NULL;
+    METAGRAPH_TEST_OK(metagraph_scheduler_get_shared(&shared));
+    METAGRAPH_TEST_OK(metagraph_scheduler_get_shared(&again));
+    METAGRAPH_TEST_ASSERT(shared == again);
+    METAGRAPH_TEST_ASSERT(metagraph_scheduler_thread_count(shared) >= 1U);
+    METAGRAPH_TEST_EXPECT(metagraph_scheduler_destroy(shared),
+                          METAGRAPH_ERROR_INVALID_ARGUMENT);
+
+    metagraph_scheduler_t *scheduler = NULL;
+    METAGRAPH_TEST_OK(metagraph_scheduler_create(4, &scheduler));
+    METAGRAPH_TEST_ASSERT(metagraph_scheduler_thread_count(scheduler) == 4U);
+    test_scheduler_random_dag(scheduler);
+    METAGRAPH_TEST_OK(metagraph_scheduler_destroy(scheduler));
+
+    test_scheduler_random_dag(NULL);
+    test_scheduler_graph_errors();
+    test_scheduler_nested();
+    return 0;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file test_utils.h
+ * @brief Minimal assertion helpers shared by the unit tests
+ */
+
+#ifndef TESTS_TEST_UTILS_H
+#define TESTS_TEST_UTILS_H
+
+#include "metagraph/result.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Abort the test binary if a condition does not hold
+ */
+#define METAGRAPH_TEST_ASSERT(condition)                                       \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            (void)fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__,  \
+                          __LINE__, #condition);                               \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+    } while (0)
+
+/**
+ * @brief Abort the test binary if an expression does not return the
+ *        expected result code
+ */
+#define METAGRAPH_TEST_EXPECT(expr, expected)                                  \
+    do {                                                                       \
+        metagraph_result_t _test_result = (expr);                              \
+        if (_test_result != (expected)) {                                      \
+            (void)fprintf(stderr, "%s:%d: %s returned %s (%d), expected %s\n", \
+                          __FILE__, __LINE__, #expr,                           \
+                          metagraph_result_to_string(_test_result),            \
+                          (int)_test_result,                                   \
+                          metagraph_result_to_string(expected));               \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+    } while (0)
+
+/**
+ * @brief Shorthand for expecting METAGRAPH_SUCCESS
+ */
+#define METAGRAPH_TEST_OK(expr) METAGRAPH_TEST_EXPECT((expr), METAGRAPH_SUCCESS)
+
+#endif // TESTS_TEST_UTILS_H
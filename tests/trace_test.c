@@ -0,0 +1,155 @@
+/*
+ * MetaGraph span recorder tests
+ */
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+#include "metagraph/trace.h"
+#include "metagraph/traversal.h"
+
+#include "test_utils.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_TRACE_BUNDLE "trace_test.mgb"
+#define TEST_TRACE_JSON "trace_test.json"
+#define TEST_TRACE_NODES 32U
+
+static metagraph_id_t test_trace_id(uint64_t value) {
+    return (metagraph_id_t){.high = 0x7ACEULL, .low = value};
+}
+
+static metagraph_graph_t *test_trace_chain(void) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint64_t i = 0; i < TEST_TRACE_NODES; i++) {
+        const metagraph_node_metadata_t node = {.id = test_trace_id(i)};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    for (uint64_t i = 0; i + 1U < TEST_TRACE_NODES; i++) {
+        metagraph_id_t members[2] = {test_trace_id(i), test_trace_id(i + 1U)};
+        const metagraph_edge_metadata_t edge = {
+            .id = test_trace_id(100U + i),
+            .weight = 1.0F,
+            .node_count = 2,
+            .nodes = members,
+        };
+        METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edge, NULL));
+    }
+    return graph;
+}
+
+// Open, load, verify and traverse: one span of each kind at least.
+static void test_trace_workload(const metagraph_graph_t *graph) {
+    const metagraph_bundle_options_t options = {
+        .flags = METAGRAPH_BUNDLE_OPEN_VERIFY};
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(metagraph_bundle_create_from_file(TEST_TRACE_BUNDLE,
+                                                        &options, &bundle));
+    metagraph_node_index_t index = 0;
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_find_node(bundle, test_trace_id(3), &index));
+    METAGRAPH_TEST_OK(metagraph_bundle_verify_integrity(bundle, NULL));
+    METAGRAPH_TEST_OK(metagraph_bundle_destroy(bundle));
+
+    const metagraph_traversal_context_t context = {.graph = graph};
+    METAGRAPH_TEST_OK(metagraph_traverse_dfs(&context, 0,
+                                             METAGRAPH_DFS_PREORDER, NULL,
+                                             NULL));
+    METAGRAPH_TEST_OK(
+        metagraph_traverse_bfs(&context, 0, NULL, NULL, NULL, NULL));
+}
+
+static char *test_trace_read(const char *path) {
+    FILE *file = fopen(path, "rb");
+    METAGRAPH_TEST_ASSERT(file != NULL);
+    METAGRAPH_TEST_ASSERT(fseek(file, 0, SEEK_END) == 0);
+    const long size = ftell(file);
+    METAGRAPH_TEST_ASSERT(size > 0);
+    METAGRAPH_TEST_ASSERT(fseek(file, 0, SEEK_SET) == 0);
+    char *text = malloc((size_t)size + 1U);
+    METAGRAPH_TEST_ASSERT(text != NULL);
+    METAGRAPH_TEST_ASSERT(fread(text, 1, (size_t)size, file) == (size_t)size);
+    text[size] = '\0';
+    (void)fclose(file);
+    return text;
+}
+
+static void test_trace_recording(const metagraph_graph_t *graph) {
+    metagraph_trace_stats_t stats;
+    METAGRAPH_TEST_EXPECT(metagraph_trace_start(0),
+                          METAGRAPH_ERROR_INVALID_SIZE);
+    METAGRAPH_TEST_OK(metagraph_trace_start(256));
+    test_trace_workload(graph);
+    METAGRAPH_TEST_OK(metagraph_trace_stop());
+    METAGRAPH_TEST_OK(metagraph_trace_get_stats(&stats));
+    METAGRAPH_TEST_ASSERT(!stats.recording);
+    METAGRAPH_TEST_ASSERT(stats.capacity == 256U);
+    METAGRAPH_TEST_ASSERT(stats.dropped == 0);
+    METAGRAPH_TEST_ASSERT(stats.recorded >= 6U);
+
+    // Work after stop is not recorded.
+    test_trace_workload(graph);
+    metagraph_trace_stats_t after;
+    METAGRAPH_TEST_OK(metagraph_trace_get_stats(&after));
+    METAGRAPH_TEST_ASSERT(after.recorded == stats.recorded);
+
+    METAGRAPH_TEST_OK(metagraph_trace_write_chrome(TEST_TRACE_JSON));
+    char *json = test_trace_read(TEST_TRACE_JSON);
+    METAGRAPH_TEST_ASSERT(strncmp(json, "{\"displayTimeUnit\"", 18) == 0);
+    const char *const names[] = {"\"bundle_open\"", "\"section_load\"",
+                                 "\"verify\"",      "\"verify_bundle\"",
+                                 "\"traverse_dfs\"", "\"traverse_bfs\""};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        METAGRAPH_TEST_ASSERT(strstr(json, names[i]) != NULL);
+    }
+    METAGRAPH_TEST_ASSERT(strstr(json, "\"ph\":\"X\"") != NULL);
+    METAGRAPH_TEST_ASSERT(strstr(json, "\"dropped_spans\":0}") != NULL);
+    free(json);
+
+    // A small buffer keeps the first spans and counts the rest.
+    METAGRAPH_TEST_OK(metagraph_trace_start(2));
+    test_trace_workload(graph);
+    METAGRAPH_TEST_OK(metagraph_trace_get_stats(&stats));
+    METAGRAPH_TEST_ASSERT(stats.recording);
+    METAGRAPH_TEST_ASSERT(stats.recorded == 2U);
+    METAGRAPH_TEST_ASSERT(stats.dropped >= 4U);
+    METAGRAPH_TEST_OK(metagraph_trace_discard());
+    METAGRAPH_TEST_OK(metagraph_trace_get_stats(&stats));
+    METAGRAPH_TEST_ASSERT(stats.capacity == 0 && stats.recorded == 0);
+    (void)remove(TEST_TRACE_JSON);
+}
+
+static void test_trace_unavailable(void) {
+    metagraph_trace_stats_t stats;
+    METAGRAPH_TEST_EXPECT(metagraph_trace_start(16),
+                          METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+    METAGRAPH_TEST_EXPECT(metagraph_trace_stop(),
+                          METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+    METAGRAPH_TEST_EXPECT(metagraph_trace_get_stats(&stats),
+                          METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+    METAGRAPH_TEST_EXPECT(metagraph_trace_write_chrome(TEST_TRACE_JSON),
+                          METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+    METAGRAPH_TEST_EXPECT(metagraph_trace_discard(),
+                          METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE);
+}
+
+int main(void) {
+    metagraph_graph_t *graph = test_trace_chain();
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_write_graph(graph, TEST_TRACE_BUNDLE, NULL));
+    if (metagraph_trace_available()) {
+        test_trace_recording(graph);
+    } else {
+        test_trace_unavailable();
+        // The hooks are compiled out; the instrumented paths still work.
+        test_trace_workload(graph);
+    }
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+    (void)remove(TEST_TRACE_BUNDLE);
+    return 0;
+}
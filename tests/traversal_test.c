@@ -0,0 +1,623 @@
+/*
+ * MetaGraph traversal engine tests
+ */
+
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+#include "metagraph/traversal.h"
+
+#include "test_utils.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_TRAVERSAL_WIDE_NODES 50000U
+#define TEST_TRAVERSAL_WIDE_FANOUT 6U
+#define TEST_TRAVERSAL_DAG_NODES 20000U
+
+static metagraph_id_t test_traversal_id(uint64_t value) {
+    return (metagraph_id_t){.high = 0x7EA7ULL, .low = value};
+}
+
+static metagraph_graph_t *test_traversal_graph(size_t nodes,
+                                               const char *const *names) {
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (size_t i = 0; i < nodes; i++) {
+        const metagraph_node_metadata_t node = {
+            .id = test_traversal_id(i), .name = names ? names[i] : NULL};
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    return graph;
+}
+
+// Edge from `source` to each of `targets`.
+static void test_traversal_edge(metagraph_graph_t *graph, uint64_t id,
+                                uint64_t source, const uint64_t *targets,
+                                size_t target_count) {
+    metagraph_id_t members[8];
+    members[0] = test_traversal_id(source);
+    for (size_t i = 0; i < target_count; i++) {
+        members[i + 1] = test_traversal_id(targets[i]);
+    }
+    const metagraph_edge_metadata_t edge = {.id = test_traversal_id(id),
+                                            .node_count = target_count + 1,
+                                            .nodes = members};
+    METAGRAPH_TEST_OK(metagraph_graph_add_edge(graph, &edge, NULL));
+}
+
+// ============================================================================
+// DFS
+// ============================================================================
+
+typedef struct {
+    metagraph_node_index_t order[16];
+    uint32_t depths[16];
+    size_t count;
+} test_traversal_trace_t;
+
+static metagraph_visit_result_t
+test_traversal_record(const metagraph_graph_t *graph,
+                      metagraph_node_index_t node, uint32_t depth,
+                      void *user_data) {
+    (void)graph;
+    test_traversal_trace_t *trace = user_data;
+    trace->depths[trace->count] = depth;
+    trace->order[trace->count++] = node;
+    return METAGRAPH_VISIT_CONTINUE;
+}
+
+static metagraph_visit_result_t
+test_traversal_skip_node_2(const metagraph_graph_t *graph,
+                           metagraph_node_index_t node, uint32_t depth,
+                           void *user_data) {
+    test_traversal_record(graph, node, depth, user_data);
+    return node == 2 ? METAGRAPH_VISIT_SKIP : METAGRAPH_VISIT_CONTINUE;
+}
+
+// 0 -> {1, 2}, 1 -> 3, 2 -> 3, 3 -> 4
+static metagraph_graph_t *test_traversal_diamond(void) {
+    metagraph_graph_t *graph = test_traversal_graph(5, NULL);
+    test_traversal_edge(graph, 100, 0, (const uint64_t[]){1, 2}, 2);
+    test_traversal_edge(graph, 101, 1, (const uint64_t[]){3}, 1);
+    test_traversal_edge(graph, 102, 2, (const uint64_t[]){3}, 1);
+    test_traversal_edge(graph, 103, 3, (const uint64_t[]){4}, 1);
+    return graph;
+}
+
+static void test_dfs_orders(void) {
+    metagraph_graph_t *graph = test_traversal_diamond();
+    test_traversal_trace_t trace = {0};
+    metagraph_traversal_context_t context = {.graph = graph,
+                                             .user_data = &trace};
+
+    METAGRAPH_TEST_OK(metagraph_traverse_dfs(
+        &context, 0, METAGRAPH_DFS_PREORDER, test_traversal_record, NULL));
+    const metagraph_node_index_t preorder[] = {0, 1, 3, 4, 2};
+    const uint32_t predepth[] = {0, 1, 2, 3, 1};
+    METAGRAPH_TEST_ASSERT(trace.count == 5);
+    METAGRAPH_TEST_ASSERT(memcmp(trace.order, preorder, sizeof(preorder)) == 0);
+    METAGRAPH_TEST_ASSERT(memcmp(trace.depths, predepth, sizeof(predepth)) == 0);
+
+    trace.count = 0;
+    METAGRAPH_TEST_OK(metagraph_traverse_dfs(
+        &context, 0, METAGRAPH_DFS_POSTORDER, test_traversal_record, NULL));
+    const metagraph_node_index_t postorder[] = {4, 3, 1, 2, 0};
+    METAGRAPH_TEST_ASSERT(trace.count == 5);
+    METAGRAPH_TEST_ASSERT(memcmp(trace.order, postorder, sizeof(postorder)) ==
+                          0);
+
+    trace.count = 0;
+    METAGRAPH_TEST_OK(metagraph_traverse_dfs(&context, 0, METAGRAPH_DFS_BOTH,
+                                             test_traversal_record, NULL));
+    METAGRAPH_TEST_ASSERT(trace.count == 10);
+
+    // max_depth stops descent below depth 1.
+    trace.count = 0;
+    context.max_depth = 1;
+    METAGRAPH_TEST_OK(metagraph_traverse_dfs(
+        &context, 0, METAGRAPH_DFS_PREORDER, test_traversal_record, NULL));
+    METAGRAPH_TEST_ASSERT(trace.count == 3);
+
+    METAGRAPH_TEST_EXPECT(metagraph_traverse_dfs(&context, 9,
+                                                 METAGRAPH_DFS_PREORDER, NULL,
+                                                 NULL),
+                          METAGRAPH_ERROR_NODE_NOT_FOUND);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+// ============================================================================
+// BFS
+// ============================================================================
+
+static void test_bfs_small(void) {
+    metagraph_graph_t *graph = test_traversal_diamond();
+    test_traversal_trace_t trace = {0};
+    metagraph_traversal_context_t context = {.graph = graph,
+                                             .user_data = &trace};
+    metagraph_bfs_node_info_t info[5];
+
+    METAGRAPH_TEST_OK(metagraph_traverse_bfs(
+        &context, 0, NULL, test_traversal_record, NULL, info));
+    const uint32_t distances[] = {0, 1, 1, 2, 3};
+    for (size_t i = 0; i < 5; i++) {
+        METAGRAPH_TEST_ASSERT(info[i].distance == distances[i]);
+    }
+    METAGRAPH_TEST_ASSERT(info[0].parent == METAGRAPH_INVALID_INDEX);
+    METAGRAPH_TEST_ASSERT(info[3].parent == 1 || info[3].parent == 2);
+    METAGRAPH_TEST_ASSERT(info[4].parent == 3 && info[4].parent_edge == 3);
+    METAGRAPH_TEST_ASSERT(trace.count == 5);
+    for (size_t i = 1; i < trace.count; i++) {
+        METAGRAPH_TEST_ASSERT(trace.depths[i - 1] <= trace.depths[i]);
+    }
+
+    // Skipping node 2 still reaches 3 through 1.
+    trace.count = 0;
+    METAGRAPH_TEST_OK(metagraph_traverse_bfs(
+        &context, 0, NULL, test_traversal_skip_node_2, NULL, info));
+    METAGRAPH_TEST_ASSERT(info[3].parent == 1 && info[4].distance == 3);
+
+    context.max_depth = 2;
+    METAGRAPH_TEST_OK(metagraph_traverse_bfs(&context, 0, NULL, NULL, NULL,
+                                             info));
+    METAGRAPH_TEST_ASSERT(info[3].distance == 2);
+    METAGRAPH_TEST_ASSERT(info[4].distance == UINT32_MAX);
+    METAGRAPH_TEST_ASSERT(info[4].parent == METAGRAPH_INVALID_INDEX);
+
+    // From a sink nothing else is reachable.
+    context.max_depth = 0;
+    METAGRAPH_TEST_OK(metagraph_traverse_bfs(&context, 4, NULL, NULL, NULL,
+                                             info));
+    METAGRAPH_TEST_ASSERT(info[4].distance == 0 && info[0].distance == UINT32_MAX);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+// Pseudo-random fan-out graph: large frontiers push BFS bottom-up.
+static metagraph_graph_t *test_traversal_wide(void) {
+    metagraph_graph_t *graph =
+        test_traversal_graph(TEST_TRAVERSAL_WIDE_NODES, NULL);
+    uint64_t id = TEST_TRAVERSAL_WIDE_NODES;
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (uint64_t node = 0; node < TEST_TRAVERSAL_WIDE_NODES; node++) {
+        uint64_t targets[TEST_TRAVERSAL_WIDE_FANOUT];
+        for (size_t i = 0; i < TEST_TRAVERSAL_WIDE_FANOUT; i++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            targets[i] = (state >> 33U) % TEST_TRAVERSAL_WIDE_NODES;
+        }
+        // One hyperedge and a few plain edges per node.
+        test_traversal_edge(graph, id++, node, targets, 3);
+        for (size_t i = 3; i < TEST_TRAVERSAL_WIDE_FANOUT; i++) {
+            test_traversal_edge(graph, id++, node, &targets[i], 1);
+        }
+    }
+    return graph;
+}
+
+static void test_traversal_reference_bfs(const metagraph_graph_t *graph,
+                                         uint32_t *distance) {
+    const size_t count = metagraph_graph_node_count(graph);
+    metagraph_node_index_t *queue = malloc(count * sizeof(*queue));
+    METAGRAPH_TEST_ASSERT(queue != NULL);
+    for (size_t i = 0; i < count; i++) {
+        distance[i] = UINT32_MAX;
+    }
+    size_t head = 0;
+    size_t tail = 0;
+    distance[0] = 0;
+    queue[tail++] = 0;
+    metagraph_edge_index_t edges[TEST_TRAVERSAL_WIDE_FANOUT];
+    const metagraph_node_index_t *members = NULL;
+    while (head < tail) {
+        const metagraph_node_index_t node = queue[head++];
+        size_t edge_count = 0;
+        METAGRAPH_TEST_OK(metagraph_graph_get_outgoing_edges(
+            graph, node, edges, TEST_TRAVERSAL_WIDE_FANOUT, &edge_count));
+        for (size_t e = 0; e < edge_count; e++) {
+            size_t member_count = 0;
+            METAGRAPH_TEST_OK(metagraph_graph_get_edge_nodes(
+                graph, edges[e], &members, &member_count));
+            for (size_t m = 1; m < member_count; m++) {
+                const metagraph_node_index_t target = members[m];
+                if (distance[target] == UINT32_MAX) {
+                    distance[target] = distance[node] + 1U;
+                    queue[tail++] = target;
+                }
+            }
+        }
+    }
+    free(queue);
+}
+
+static metagraph_visit_result_t
+test_traversal_count(const metagraph_graph_t *graph,
+                     metagraph_node_index_t node, uint32_t depth,
+                     void *user_data) {
+    (void)graph;
+    (void)node;
+    (void)depth;
+    atomic_fetch_add((_Atomic(size_t) *)user_data, 1);
+    return METAGRAPH_VISIT_CONTINUE;
+}
+
+static void test_bfs_parallel(void) {
+    metagraph_graph_t *graph = test_traversal_wide();
+    uint32_t *expected = malloc(TEST_TRAVERSAL_WIDE_NODES * sizeof(uint32_t));
+    metagraph_bfs_node_info_t *info =
+        malloc(TEST_TRAVERSAL_WIDE_NODES * sizeof(*info));
+    METAGRAPH_TEST_ASSERT(expected != NULL && info != NULL);
+    test_traversal_reference_bfs(graph, expected);
+    size_t reached = 0;
+    for (size_t i = 0; i < TEST_TRAVERSAL_WIDE_NODES; i++) {
+        reached += expected[i] != UINT32_MAX;
+    }
+
+    const uint32_t thread_counts[] = {1, 2, 4, 8};
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]);
+         t++) {
+        _Atomic(size_t) visits = 0;
+        const metagraph_traversal_context_t context = {.graph = graph,
+                                                       .user_data = &visits};
+        const metagraph_parallel_config_t parallel = {
+            .thread_count = thread_counts[t], .work_unit_size = 512};
+        METAGRAPH_TEST_OK(metagraph_traverse_bfs(
+            &context, 0, &parallel, test_traversal_count, NULL, info));
+        METAGRAPH_TEST_ASSERT(atomic_load(&visits) == reached);
+
+        const metagraph_node_index_t *members = NULL;
+        for (size_t i = 0; i < TEST_TRAVERSAL_WIDE_NODES; i++) {
+            METAGRAPH_TEST_ASSERT(info[i].distance == expected[i]);
+            if (i == 0 || info[i].distance == UINT32_MAX) {
+                continue;
+            }
+            // The parent is one level up and its edge reaches this node.
+            const metagraph_node_index_t parent = info[i].parent;
+            METAGRAPH_TEST_ASSERT(info[parent].distance + 1U ==
+                                  info[i].distance);
+            size_t member_count = 0;
+            METAGRAPH_TEST_OK(metagraph_graph_get_edge_nodes(
+                graph, info[i].parent_edge, &members, &member_count));
+            METAGRAPH_TEST_ASSERT(members[0] == parent);
+            bool found = false;
+            for (size_t m = 1; m < member_count; m++) {
+                found = found || members[m] == i;
+            }
+            METAGRAPH_TEST_ASSERT(found);
+        }
+    }
+    free(info);
+    free(expected);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static metagraph_visit_result_t
+test_traversal_stop_at_3(const metagraph_graph_t *graph,
+                         metagraph_node_index_t node, uint32_t depth,
+                         void *user_data) {
+    (void)graph;
+    (void)node;
+    _Atomic(uint32_t) *deepest = user_data;
+    uint32_t seen = atomic_load(deepest);
+    while (seen < depth && !atomic_compare_exchange_weak(deepest, &seen, depth)) {
+    }
+    return depth == 3 ? METAGRAPH_VISIT_TERMINATE : METAGRAPH_VISIT_CONTINUE;
+}
+
+static metagraph_visit_result_t
+test_traversal_block_node_7(const metagraph_graph_t *graph,
+                            metagraph_edge_index_t edge,
+                            metagraph_node_index_t from,
+                            metagraph_node_index_t to, uint32_t depth,
+                            void *user_data) {
+    (void)graph;
+    (void)edge;
+    (void)from;
+    (void)depth;
+    (void)user_data;
+    return to == 7 ? METAGRAPH_VISIT_SKIP : METAGRAPH_VISIT_CONTINUE;
+}
+
+static void test_bfs_visitor_control(void) {
+    metagraph_graph_t *graph = test_traversal_wide();
+    _Atomic(uint32_t) deepest = 0;
+    const metagraph_traversal_context_t context = {.graph = graph,
+                                                   .user_data = &deepest};
+    const metagraph_parallel_config_t parallel = {.thread_count = 4,
+                                                  .work_unit_size = 256};
+    METAGRAPH_TEST_OK(metagraph_traverse_bfs(
+        &context, 0, &parallel, test_traversal_stop_at_3, NULL, NULL));
+    METAGRAPH_TEST_ASSERT(atomic_load(&deepest) == 3);
+
+    metagraph_bfs_node_info_t *info =
+        malloc(TEST_TRAVERSAL_WIDE_NODES * sizeof(*info));
+    METAGRAPH_TEST_ASSERT(info != NULL);
+    METAGRAPH_TEST_OK(metagraph_traverse_bfs(&context, 0, &parallel, NULL,
+                                             test_traversal_block_node_7, info));
+    METAGRAPH_TEST_ASSERT(info[7].distance == UINT32_MAX);
+    free(info);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+// ============================================================================
+// Cursors
+// ============================================================================
+
+typedef struct {
+    metagraph_node_index_t *order;
+    uint32_t *depths;
+    size_t count;
+} test_traversal_log_t;
+
+static metagraph_visit_result_t
+test_traversal_log(const metagraph_graph_t *graph, metagraph_node_index_t node,
+                   uint32_t depth, void *user_data) {
+    (void)graph;
+    test_traversal_log_t *log = user_data;
+    METAGRAPH_TEST_ASSERT(log->count < TEST_TRAVERSAL_WIDE_NODES);
+    log->depths[log->count] = depth;
+    log->order[log->count++] = node;
+    return METAGRAPH_VISIT_CONTINUE;
+}
+
+static test_traversal_log_t test_traversal_log_create(void) {
+    test_traversal_log_t log = {
+        .order = malloc(TEST_TRAVERSAL_WIDE_NODES * sizeof(*log.order)),
+        .depths = malloc(TEST_TRAVERSAL_WIDE_NODES * sizeof(*log.depths)),
+    };
+    METAGRAPH_TEST_ASSERT(log.order != NULL && log.depths != NULL);
+    return log;
+}
+
+// Step a cursor to the end, checking that no step exceeds its node budget.
+static size_t test_traversal_drain(metagraph_traversal_cursor_t *cursor,
+                                   const metagraph_traversal_budget_t *budget,
+                                   metagraph_cursor_progress_t *progress) {
+    size_t steps = 0;
+    uint64_t reached = 0;
+    for (;;) {
+        const metagraph_result_t result =
+            metagraph_traversal_cursor_step(cursor, budget, progress);
+        steps++;
+        if (budget->max_nodes) {
+            METAGRAPH_TEST_ASSERT(progress->nodes_reached - reached <=
+                                  budget->max_nodes);
+        }
+        METAGRAPH_TEST_ASSERT(progress->nodes_reached >= reached);
+        reached = progress->nodes_reached;
+        if (result == METAGRAPH_SUCCESS) {
+            METAGRAPH_TEST_ASSERT(progress->finished);
+            return steps;
+        }
+        METAGRAPH_TEST_ASSERT(result ==
+                              METAGRAPH_ERROR_TRAVERSAL_LIMIT_EXCEEDED);
+        METAGRAPH_TEST_ASSERT(!progress->finished);
+    }
+}
+
+static void test_cursor_small(void) {
+    metagraph_graph_t *graph = test_traversal_diamond();
+    test_traversal_trace_t trace = {0};
+    const metagraph_traversal_context_t context = {.graph = graph,
+                                                   .user_data = &trace};
+    metagraph_cursor_config_t config = {
+        .order = METAGRAPH_CURSOR_DFS,
+        .dfs_mode = METAGRAPH_DFS_POSTORDER,
+        .node_visitor = test_traversal_record,
+    };
+    metagraph_traversal_cursor_t *cursor = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_traversal_cursor_create(&context, &config, &cursor));
+    // Creating runs nothing; one node per step still gives the full order.
+    METAGRAPH_TEST_ASSERT(trace.count == 0);
+    const metagraph_traversal_budget_t one = {.max_nodes = 1};
+    metagraph_cursor_progress_t progress;
+    METAGRAPH_TEST_ASSERT(test_traversal_drain(cursor, &one, &progress) == 5);
+    const metagraph_node_index_t postorder[] = {4, 3, 1, 2, 0};
+    METAGRAPH_TEST_ASSERT(trace.count == 5);
+    METAGRAPH_TEST_ASSERT(memcmp(trace.order, postorder, sizeof(postorder)) ==
+                          0);
+    METAGRAPH_TEST_ASSERT(progress.nodes_reached == 5);
+    METAGRAPH_TEST_OK(metagraph_traversal_cursor_step(cursor, &one, &progress));
+    METAGRAPH_TEST_ASSERT(trace.count == 5 && progress.finished);
+    METAGRAPH_TEST_OK(metagraph_traversal_cursor_destroy(cursor));
+
+    // SKIP and TERMINATE behave as in the blocking traversals.
+    trace.count = 0;
+    config.order = METAGRAPH_CURSOR_BFS;
+    config.node_visitor = test_traversal_skip_node_2;
+    METAGRAPH_TEST_OK(
+        metagraph_traversal_cursor_create(&context, &config, &cursor));
+    METAGRAPH_TEST_OK(metagraph_traversal_cursor_step(cursor, NULL, NULL));
+    const metagraph_node_index_t level_order[] = {0, 1, 2, 3, 4};
+    const uint32_t levels[] = {0, 1, 1, 2, 3};
+    METAGRAPH_TEST_ASSERT(trace.count == 5);
+    METAGRAPH_TEST_ASSERT(memcmp(trace.order, level_order,
+                                 sizeof(level_order)) == 0);
+    METAGRAPH_TEST_ASSERT(memcmp(trace.depths, levels, sizeof(levels)) == 0);
+    METAGRAPH_TEST_OK(metagraph_traversal_cursor_destroy(cursor));
+
+    _Atomic(uint32_t) deepest = 0;
+    const metagraph_traversal_context_t stop = {.graph = graph,
+                                                .user_data = &deepest};
+    // Preorder reaches 0, 1, 3, 4 and stops there; 2 is never reached.
+    config.order = METAGRAPH_CURSOR_DFS;
+    config.dfs_mode = METAGRAPH_DFS_PREORDER;
+    config.node_visitor = test_traversal_stop_at_3;
+    METAGRAPH_TEST_OK(
+        metagraph_traversal_cursor_create(&stop, &config, &cursor));
+    METAGRAPH_TEST_ASSERT(test_traversal_drain(cursor, &one, &progress) == 4);
+    METAGRAPH_TEST_ASSERT(atomic_load(&deepest) == 3);
+    METAGRAPH_TEST_ASSERT(progress.nodes_reached == 4);
+    METAGRAPH_TEST_OK(metagraph_traversal_cursor_destroy(cursor));
+
+    config.start = 9;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_traversal_cursor_create(&context, &config, &cursor),
+        METAGRAPH_ERROR_NODE_NOT_FOUND);
+    METAGRAPH_TEST_ASSERT(cursor == NULL);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static void test_cursor_resume(void) {
+    metagraph_graph_t *graph = test_traversal_wide();
+    test_traversal_log_t expected = test_traversal_log_create();
+    test_traversal_log_t log = test_traversal_log_create();
+    const metagraph_traversal_context_t reference = {.graph = graph,
+                                                     .user_data = &expected};
+    METAGRAPH_TEST_OK(metagraph_traverse_dfs(
+        &reference, 0, METAGRAPH_DFS_PREORDER, test_traversal_log, NULL));
+
+    // Slices bounded by nodes, edges or time all replay the same order.
+    const metagraph_traversal_context_t context = {.graph = graph,
+                                                   .user_data = &log};
+    const metagraph_cursor_config_t config = {
+        .order = METAGRAPH_CURSOR_DFS,
+        .dfs_mode = METAGRAPH_DFS_PREORDER,
+        .node_visitor = test_traversal_log,
+    };
+    const metagraph_traversal_budget_t budgets[] = {
+        {.max_nodes = 7}, {.max_edges = 100}, {.max_ns = 20000}, {0}};
+    uint64_t examined = 0;
+    for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++) {
+        log.count = 0;
+        metagraph_traversal_cursor_t *cursor = NULL;
+        METAGRAPH_TEST_OK(
+            metagraph_traversal_cursor_create(&context, &config, &cursor));
+        metagraph_cursor_progress_t progress;
+        const size_t steps =
+            test_traversal_drain(cursor, &budgets[b], &progress);
+        METAGRAPH_TEST_ASSERT(log.count == expected.count);
+        METAGRAPH_TEST_ASSERT(memcmp(log.order, expected.order,
+                                     log.count * sizeof(log.order[0])) == 0);
+        METAGRAPH_TEST_ASSERT(progress.nodes_reached == expected.count);
+        // No edge target is examined twice, however the work is sliced.
+        if (b == 0) {
+            examined = progress.edges_examined;
+            METAGRAPH_TEST_ASSERT(steps >= expected.count / 7U);
+        }
+        METAGRAPH_TEST_ASSERT(progress.edges_examined == examined);
+        if (b == 1) {
+            METAGRAPH_TEST_ASSERT(steps >= examined / 100U);
+        }
+        METAGRAPH_TEST_OK(metagraph_traversal_cursor_destroy(cursor));
+    }
+
+    // BFS slices reach nodes level by level at their true distances.
+    uint32_t *distance = malloc(TEST_TRAVERSAL_WIDE_NODES * sizeof(uint32_t));
+    METAGRAPH_TEST_ASSERT(distance != NULL);
+    test_traversal_reference_bfs(graph, distance);
+    const metagraph_cursor_config_t bfs = {
+        .order = METAGRAPH_CURSOR_BFS,
+        .node_visitor = test_traversal_log,
+    };
+    log.count = 0;
+    metagraph_traversal_cursor_t *cursor = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_traversal_cursor_create(&context, &bfs, &cursor));
+    metagraph_cursor_progress_t progress;
+    const metagraph_traversal_budget_t slice = {.max_nodes = 1000};
+    METAGRAPH_TEST_ASSERT(test_traversal_drain(cursor, &slice, &progress) > 1U);
+    METAGRAPH_TEST_ASSERT(log.count == expected.count);
+    METAGRAPH_TEST_ASSERT(progress.edges_examined == examined);
+    for (size_t i = 0; i < log.count; i++) {
+        METAGRAPH_TEST_ASSERT(log.depths[i] == distance[log.order[i]]);
+        METAGRAPH_TEST_ASSERT(i == 0 || log.depths[i] >= log.depths[i - 1U]);
+    }
+    METAGRAPH_TEST_OK(metagraph_traversal_cursor_destroy(cursor));
+    free(distance);
+    free(log.order);
+    free(log.depths);
+    free(expected.order);
+    free(expected.depths);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+// ============================================================================
+// Topological ordering
+// ============================================================================
+
+static void test_topological_order(void) {
+    // Node i depends on up to three lower-numbered nodes.
+    metagraph_graph_t *graph =
+        test_traversal_graph(TEST_TRAVERSAL_DAG_NODES, NULL);
+    uint64_t id = TEST_TRAVERSAL_DAG_NODES;
+    for (uint64_t node = 1; node < TEST_TRAVERSAL_DAG_NODES; node++) {
+        const uint64_t targets[] = {node - 1U, node / 2U, (node * 7U) % node};
+        test_traversal_edge(graph, id++, node, targets, node % 3U + 1U);
+    }
+
+    metagraph_topological_result_t single;
+    metagraph_topological_result_t parallel;
+    const metagraph_parallel_config_t one = {.thread_count = 1};
+    const metagraph_parallel_config_t many = {.thread_count = 6,
+                                              .work_unit_size = 64};
+    METAGRAPH_TEST_OK(metagraph_compute_topological_order(graph, &one, &single));
+    METAGRAPH_TEST_OK(
+        metagraph_compute_topological_order(graph, &many, &parallel));
+    METAGRAPH_TEST_ASSERT(single.node_count == TEST_TRAVERSAL_DAG_NODES);
+    METAGRAPH_TEST_ASSERT(single.cycle_nodes == NULL && single.cycle_count == 0);
+    METAGRAPH_TEST_ASSERT(parallel.node_count == single.node_count);
+    METAGRAPH_TEST_ASSERT(memcmp(single.nodes, parallel.nodes,
+                                 single.node_count * sizeof(*single.nodes)) ==
+                          0);
+    // The only dependency chain runs through node - 1, so this graph has a
+    // single valid order.
+    for (size_t i = 0; i < single.node_count; i++) {
+        METAGRAPH_TEST_ASSERT(single.nodes[i] == i);
+    }
+    METAGRAPH_TEST_OK(metagraph_topological_result_destroy(&single));
+    METAGRAPH_TEST_OK(metagraph_topological_result_destroy(&parallel));
+    METAGRAPH_TEST_ASSERT(single.nodes == NULL);
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+
+    // Diamond: 4 depends on 3, which depends on 1 and 2.
+    graph = test_traversal_diamond();
+    METAGRAPH_TEST_OK(metagraph_compute_topological_order(graph, NULL, &single));
+    const metagraph_node_index_t diamond[] = {4, 3, 1, 2, 0};
+    METAGRAPH_TEST_ASSERT(single.node_count == 5);
+    METAGRAPH_TEST_ASSERT(memcmp(single.nodes, diamond, sizeof(diamond)) == 0);
+    METAGRAPH_TEST_OK(metagraph_topological_result_destroy(&single));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static void test_topological_cycle(void) {
+    const char *const names[] = {"a", "b", "c", "d", "e"};
+    metagraph_graph_t *graph = test_traversal_graph(5, names);
+    test_traversal_edge(graph, 10, 0, (const uint64_t[]){1}, 1);
+    test_traversal_edge(graph, 11, 1, (const uint64_t[]){2}, 1);
+    test_traversal_edge(graph, 12, 2, (const uint64_t[]){0}, 1);
+    test_traversal_edge(graph, 13, 3, (const uint64_t[]){0, 4}, 2);
+
+    metagraph_topological_result_t result;
+    metagraph_clear_error_context();
+    METAGRAPH_TEST_EXPECT(metagraph_compute_topological_order(graph, NULL,
+                                                              &result),
+                          METAGRAPH_ERROR_DEPENDENCY_CYCLE);
+    METAGRAPH_TEST_ASSERT(result.node_count == 1 && result.nodes[0] == 4);
+    const metagraph_node_index_t cycle[] = {0, 1, 2};
+    METAGRAPH_TEST_ASSERT(result.cycle_count == 3);
+    METAGRAPH_TEST_ASSERT(memcmp(result.cycle_nodes, cycle, sizeof(cycle)) == 0);
+
+    metagraph_error_context_t context;
+    METAGRAPH_TEST_OK(metagraph_get_error_context(&context));
+    METAGRAPH_TEST_ASSERT(context.code == METAGRAPH_ERROR_DEPENDENCY_CYCLE);
+#if !defined(METAGRAPH_ERROR_NO_STRINGS)
+    METAGRAPH_TEST_ASSERT(strstr(context.message, "a -> b -> c -> a") != NULL);
+#endif
+    METAGRAPH_TEST_OK(metagraph_topological_result_destroy(&result));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+int main(void) {
+    test_dfs_orders();
+    test_bfs_small();
+    test_bfs_parallel();
+    test_bfs_visitor_control();
+    test_cursor_small();
+    test_cursor_resume();
+    test_topological_order();
+    test_topological_cycle();
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ * MetaGraph bundle file watcher tests
+ */
+
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L // nanosleep
+#endif
+
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/result.h"
+#include "metagraph/watcher.h"
+
+#include "test_utils.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#define TEST_WATCHER_PATH "watcher_test.mgb"
+#define TEST_WATCHER_TEMP_PATH "watcher_test.mgb.new"
+#define TEST_WATCHER_READERS 4
+#define TEST_WATCHER_RELOADS 32
+#define TEST_WATCHER_MAX_NODES 8U
+
+typedef struct {
+    uint64_t calls;
+    uint64_t generation;
+    uint64_t bundle_id;
+    metagraph_result_t result;
+} test_watcher_log_t;
+
+static void test_watcher_on_reload(void *user_data,
+                                   const metagraph_bundle_t *bundle,
+                                   uint64_t generation,
+                                   metagraph_result_t result) {
+    test_watcher_log_t *log = user_data;
+    log->calls++;
+    log->generation = generation;
+    log->bundle_id = metagraph_bundle_get_header(bundle)->bundle_id;
+    log->result = result;
+}
+
+// Write a bundle of `nodes` nodes tagged with bundle_id; the writer renames
+// it over the watched path. The graph borrows each payload until it is
+// written, so the names outlive the loop.
+static void test_watcher_write(uint64_t bundle_id, uint64_t nodes) {
+    char names[TEST_WATCHER_MAX_NODES][32];
+    METAGRAPH_TEST_ASSERT(nodes <= TEST_WATCHER_MAX_NODES);
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_TEST_OK(metagraph_graph_create(NULL, &graph));
+    for (uint64_t i = 0; i < nodes; i++) {
+        (void)snprintf(names[i], sizeof(names[i]), "assets/%llu.bin",
+                       (unsigned long long)i);
+        const metagraph_node_metadata_t node = {
+            .id = {.high = bundle_id, .low = i + 1U},
+            .name = names[i],
+            .data = names[i],
+            .data_size = strlen(names[i]),
+        };
+        METAGRAPH_TEST_OK(metagraph_graph_add_node(graph, &node, NULL));
+    }
+    const metagraph_bundle_write_options_t options = {
+        .bundle_id = bundle_id,
+        .creator = "watcher_test",
+    };
+    METAGRAPH_TEST_OK(
+        metagraph_bundle_write_graph(graph, TEST_WATCHER_PATH, &options));
+    METAGRAPH_TEST_OK(metagraph_graph_destroy(graph));
+}
+
+static uint64_t test_watcher_id(const metagraph_bundle_t *bundle) {
+    return metagraph_bundle_get_header(bundle)->bundle_id;
+}
+
+static void test_watcher_manual_reload(void) {
+    test_watcher_write(1, 3);
+    test_watcher_log_t log = {0};
+    const metagraph_file_watcher_config_t config = {
+        .flags = METAGRAPH_FILE_WATCHER_MANUAL,
+        .on_reload = test_watcher_on_reload,
+        .user_data = &log,
+    };
+    metagraph_file_watcher_t *watcher = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_file_watcher_create(TEST_WATCHER_PATH, &config, &watcher));
+    METAGRAPH_TEST_ASSERT(metagraph_file_watcher_generation(watcher) == 1U);
+
+    // Nothing changed: no reload, no callback
+    METAGRAPH_TEST_OK(metagraph_file_watcher_reload(watcher, false));
+    METAGRAPH_TEST_ASSERT(log.calls == 0U);
+
+    const metagraph_bundle_t *old = NULL;
+    METAGRAPH_TEST_OK(metagraph_file_watcher_acquire(watcher, &old));
+    METAGRAPH_TEST_ASSERT(test_watcher_id(old) == 1U);
+
+    test_watcher_write(2, 5);
+    METAGRAPH_TEST_OK(metagraph_file_watcher_reload(watcher, false));
+    METAGRAPH_TEST_ASSERT(metagraph_file_watcher_generation(watcher) == 2U);
+    METAGRAPH_TEST_ASSERT(log.calls == 1U && log.generation == 2U);
+    METAGRAPH_TEST_ASSERT(log.bundle_id == 2U);
+    METAGRAPH_TEST_ASSERT(log.result == METAGRAPH_SUCCESS);
+
+    // The held version stays mapped and unchanged; a nested acquisition
+    // sees the new one.
+    const metagraph_bundle_t *fresh = NULL;
+    METAGRAPH_TEST_OK(metagraph_file_watcher_acquire(watcher, &fresh));
+    METAGRAPH_TEST_ASSERT(test_watcher_id(fresh) == 2U);
+    uint64_t count = 0;
+    METAGRAPH_TEST_OK(metagraph_bundle_node_count(fresh, &count));
+    METAGRAPH_TEST_ASSERT(count == 5U);
+    metagraph_file_watcher_release(watcher);
+    METAGRAPH_TEST_ASSERT(test_watcher_id(old) == 1U);
+    METAGRAPH_TEST_OK(metagraph_bundle_node_count(old, &count));
+    METAGRAPH_TEST_ASSERT(count == 3U);
+    metagraph_node_metadata_t view;
+    METAGRAPH_TEST_OK(metagraph_bundle_get_node(old, 2, &view));
+    METAGRAPH_TEST_ASSERT(view.id.high == 1U);
+    METAGRAPH_TEST_ASSERT(view.data_size == strlen(view.name));
+    METAGRAPH_TEST_ASSERT(memcmp(view.data, view.name, view.data_size) == 0);
+    metagraph_file_watcher_release(watcher);
+
+    // Forcing reopens an unchanged file
+    METAGRAPH_TEST_OK(metagraph_file_watcher_reload(watcher, true));
+    METAGRAPH_TEST_ASSERT(metagraph_file_watcher_generation(watcher) == 3U);
+    METAGRAPH_TEST_ASSERT(log.calls == 2U && log.bundle_id == 2U);
+    METAGRAPH_TEST_OK(metagraph_file_watcher_destroy(watcher));
+}
+
+static void test_watcher_keeps_version_on_failure(void) {
+    test_watcher_write(7, 2);
+    test_watcher_log_t log = {0};
+    const metagraph_file_watcher_config_t config = {
+        .flags = METAGRAPH_FILE_WATCHER_MANUAL | METAGRAPH_FILE_WATCHER_VERIFY,
+        .on_reload = test_watcher_on_reload,
+        .user_data = &log,
+    };
+    metagraph_file_watcher_t *watcher = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_file_watcher_create(TEST_WATCHER_PATH, &config, &watcher));
+
+    // Replace the file with garbage
+    FILE *file = fopen(TEST_WATCHER_TEMP_PATH, "wb");
+    METAGRAPH_TEST_ASSERT(file != NULL);
+    static const char garbage[512] = "not a bundle";
+    METAGRAPH_TEST_ASSERT(fwrite(garbage, 1, sizeof(garbage), file) ==
+                          sizeof(garbage));
+    METAGRAPH_TEST_ASSERT(fclose(file) == 0);
+    (void)remove(TEST_WATCHER_PATH);
+    METAGRAPH_TEST_ASSERT(
+        rename(TEST_WATCHER_TEMP_PATH, TEST_WATCHER_PATH) == 0);
+
+    METAGRAPH_TEST_EXPECT(metagraph_file_watcher_reload(watcher, false),
+                          METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    METAGRAPH_TEST_ASSERT(log.calls == 1U);
+    METAGRAPH_TEST_ASSERT(log.result == METAGRAPH_ERROR_BUNDLE_CORRUPTED);
+    METAGRAPH_TEST_ASSERT(log.generation == 1U && log.bundle_id == 7U);
+    METAGRAPH_TEST_ASSERT(metagraph_file_watcher_generation(watcher) == 1U);
+
+    // The same bad file is not retried until it changes
+    METAGRAPH_TEST_OK(metagraph_file_watcher_reload(watcher, false));
+    METAGRAPH_TEST_ASSERT(log.calls == 1U);
+
+    const metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_TEST_OK(metagraph_file_watcher_acquire(watcher, &bundle));
+    METAGRAPH_TEST_ASSERT(test_watcher_id(bundle) == 7U);
+    metagraph_file_watcher_release(watcher);
+
+    test_watcher_write(8, 2);
+    METAGRAPH_TEST_OK(metagraph_file_watcher_reload(watcher, false));
+    METAGRAPH_TEST_ASSERT(metagraph_file_watcher_generation(watcher) == 2U);
+    METAGRAPH_TEST_ASSERT(log.calls == 2U && log.bundle_id == 8U);
+    METAGRAPH_TEST_OK(metagraph_file_watcher_destroy(watcher));
+}
+
+static void test_watcher_rejects_bad_first_version(void) {
+    metagraph_file_watcher_t *watcher = NULL;
+    METAGRAPH_TEST_EXPECT(
+        metagraph_file_watcher_create("does-not-exist.mgb", NULL, &watcher),
+        METAGRAPH_ERROR_FILE_NOT_FOUND);
+    METAGRAPH_TEST_ASSERT(watcher == NULL);
+    METAGRAPH_TEST_EXPECT(metagraph_file_watcher_create(NULL, NULL, &watcher),
+                          METAGRAPH_ERROR_NULL_POINTER);
+}
+
+#if !defined(_WIN32)
+static void test_watcher_sleep_ms(long ms) {
+    const struct timespec delay = {.tv_sec = ms / 1000L,
+                                   .tv_nsec = (ms % 1000L) * 1000000L};
+    (void)nanosleep(&delay, NULL);
+}
+
+// Wait up to five seconds for the watcher thread to publish `generation`.
+static bool test_watcher_wait_for(const metagraph_file_watcher_t *watcher,
+                                  uint64_t generation) {
+    for (int i = 0; i < 1000; i++) {
+        if (metagraph_file_watcher_generation(watcher) >= generation) {
+            return true;
+        }
+        test_watcher_sleep_ms(5);
+    }
+    return false;
+}
+
+static void test_watcher_background_reload(void) {
+    test_watcher_write(10, 1);
+    const metagraph_file_watcher_config_t config = {.poll_interval_ms = 20};
+    metagraph_file_watcher_t *watcher = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_file_watcher_create(TEST_WATCHER_PATH, &config, &watcher));
+    for (uint64_t id = 11; id <= 13; id++) {
+        const uint64_t next = metagraph_file_watcher_generation(watcher) + 1U;
+        test_watcher_write(id, 2);
+        METAGRAPH_TEST_ASSERT(test_watcher_wait_for(watcher, next));
+        const metagraph_bundle_t *bundle = NULL;
+        METAGRAPH_TEST_OK(metagraph_file_watcher_acquire(watcher, &bundle));
+        METAGRAPH_TEST_ASSERT(test_watcher_id(bundle) == id);
+        metagraph_file_watcher_release(watcher);
+    }
+    METAGRAPH_TEST_OK(metagraph_file_watcher_destroy(watcher));
+}
+
+typedef struct {
+    metagraph_file_watcher_t *watcher;
+    atomic_bool *stop;
+    uint64_t reads;
+} test_watcher_reader_t;
+
+// Readers hold each version across a whole pass over its nodes while the
+// main thread keeps replacing it.
+static void *test_watcher_reader(void *arg) {
+    test_watcher_reader_t *reader = arg;
+    while (!atomic_load(reader->stop)) {
+        const metagraph_bundle_t *bundle = NULL;
+        METAGRAPH_TEST_OK(
+            metagraph_file_watcher_acquire(reader->watcher, &bundle));
+        const uint64_t id = test_watcher_id(bundle);
+        uint64_t count = 0;
+        METAGRAPH_TEST_OK(metagraph_bundle_node_count(bundle, &count));
+        METAGRAPH_TEST_ASSERT(count == id % 7U + 1U);
+        for (uint32_t i = 0; i < count; i++) {
+            metagraph_node_metadata_t view;
+            METAGRAPH_TEST_OK(metagraph_bundle_get_node(bundle, i, &view));
+            METAGRAPH_TEST_ASSERT(view.id.high == id);
+        }
+        metagraph_file_watcher_release(reader->watcher);
+        reader->reads++;
+    }
+    return NULL;
+}
+
+static void test_watcher_concurrent_readers(void) {
+    test_watcher_write(100, 100U % 7U + 1U);
+    const metagraph_file_watcher_config_t config = {
+        .flags = METAGRAPH_FILE_WATCHER_MANUAL,
+    };
+    metagraph_file_watcher_t *watcher = NULL;
+    METAGRAPH_TEST_OK(
+        metagraph_file_watcher_create(TEST_WATCHER_PATH, &config, &watcher));
+
+    atomic_bool stop = false;
+    pthread_t threads[TEST_WATCHER_READERS];
+    test_watcher_reader_t readers[TEST_WATCHER_READERS];
+    for (int i = 0; i < TEST_WATCHER_READERS; i++) {
+        readers[i] = (test_watcher_reader_t){.watcher = watcher, .stop = &stop};
+        METAGRAPH_TEST_ASSERT(pthread_create(&threads[i], NULL,
+                                             test_watcher_reader,
+                                             &readers[i]) == 0);
+    }
+    for (uint64_t id = 101; id <= 100U + TEST_WATCHER_RELOADS; id++) {
+        test_watcher_write(id, id % 7U + 1U);
+        METAGRAPH_TEST_OK(metagraph_file_watcher_reload(watcher, true));
+    }
+    atomic_store(&stop, true);
+    for (int i = 0; i < TEST_WATCHER_READERS; i++) {
+        METAGRAPH_TEST_ASSERT(pthread_join(threads[i], NULL) == 0);
+        METAGRAPH_TEST_ASSERT(readers[i].reads > 0U);
+    }
+    METAGRAPH_TEST_ASSERT(metagraph_file_watcher_generation(watcher) ==
+                          1U + TEST_WATCHER_RELOADS);
+    METAGRAPH_TEST_OK(metagraph_file_watcher_destroy(watcher));
+}
+#endif
+
+int main(void) {
+    test_watcher_manual_reload();
+    test_watcher_keeps_version_on_failure();
+    test_watcher_rejects_bad_first_version();
+#if !defined(_WIN32)
+    test_watcher_background_reload();
+    test_watcher_concurrent_readers();
+#endif
+    (void)remove(TEST_WATCHER_PATH);
+    (void)remove(TEST_WATCHER_TEMP_PATH);
+    return 0;
+}
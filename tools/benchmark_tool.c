@@ -1,9 +1,17 @@
 /*
  * MetaGraph Benchmark Tool
- * Validates performance against documented targets
+ * Measures graph and bundle performance on synthetic workloads, validates
+ * the documented targets and compares against a stored baseline
  */
 
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
 #include "metagraph/result.h"
+#include "metagraph/version.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,6 +24,24 @@
 #define METAGRAPH_TARGET_MEMORY_OVERHEAD_PCT 5      // <5%
 #define METAGRAPH_TARGET_REGRESSION_TOLERANCE_PCT 5 // <5%
 
+// Default synthetic workload
+#define METAGRAPH_BENCH_DEFAULT_NODES 1000000U
+#define METAGRAPH_BENCH_DEFAULT_EDGES_PER_NODE 4U
+#define METAGRAPH_BENCH_DEFAULT_LOOKUPS (1U << 22U)
+#define METAGRAPH_BENCH_DEFAULT_BUNDLE_MB 256U
+#define METAGRAPH_BENCH_DEFAULT_PAYLOAD_BYTES 16384U
+#define METAGRAPH_BENCH_DEFAULT_ITERATIONS 15U
+#define METAGRAPH_BENCH_DEFAULT_SEED 0x5EEDU
+#define METAGRAPH_BENCH_DEFAULT_BUNDLE_PATH "mg_benchmark.mgb"
+
+// Lookups timed together; one clock read per batch keeps timer overhead
+// out of the per-lookup figures.
+#define METAGRAPH_BENCH_LOOKUP_BATCH 64U
+
+#define METAGRAPH_BENCH_NS_PER_MS 1e6
+#define METAGRAPH_BENCH_BYTES_PER_GB 1e9
+#define METAGRAPH_BENCH_BYTES_PER_MB (1024U * 1024U)
+
 // ANSI color codes for output
 #define METAGRAPH_COLOR_GREEN "\033[0;32m"
 #define METAGRAPH_COLOR_RED "\033[0;31m"
@@ -24,12 +50,45 @@
 // Custom error codes for benchmark failures
 #define METAGRAPH_ERROR_PERFORMANCE_TARGET_FAILED 900
 
-// Placeholder for actual benchmark results
+// Workload and output configuration
+typedef struct {
+    uint64_t nodes;          // Nodes in the lookup graph
+    uint64_t edges_per_node; // Outgoing hyperedges per node
+    uint64_t lookups;        // Timed lookups per lookup benchmark
+    uint64_t bundle_mb;      // Approximate bundle payload size
+    uint64_t payload_bytes;  // Payload bytes per bundle node
+    uint64_t iterations;     // Timed bundle loads
+    uint64_t seed;           // Synthetic data seed
+    const char *bundle_path; // Scratch bundle file
+    const char *json_path;   // JSON report destination
+    const char *baseline_path; // Baseline JSON to compare against
+    int validate_only;       // Fail on missed targets, skip details
+} benchmark_config_t;
+
+// Latency distribution of one benchmark
 typedef struct {
-    double node_lookup_ns;
+    double p50;
+    double p99;
+    double p999;
+    double mean;
+} benchmark_percentiles_t;
+
+// Measured results
+typedef struct {
+    benchmark_percentiles_t node_lookup_ns;
+    benchmark_percentiles_t bundle_lookup_ns;
+    benchmark_percentiles_t node_batch_lookup_ns;   // Per ID, batched calls
+    benchmark_percentiles_t bundle_batch_lookup_ns; // Per ID, batched calls
+    benchmark_percentiles_t bundle_load_ms;
+    double graph_build_us_per_node;
+    double bundle_write_gbps;
     double bundle_loading_gbps;
     double load_time_1gb_ms;
     double memory_overhead_pct;
+    uint64_t graph_memory_bytes;
+    uint64_t bundle_bytes;
+    uint64_t payload_bytes;
+    uint64_t bundle_nodes;
 } benchmark_results_t;
 
 // Performance metric definition
@@ -40,12 +99,55 @@ typedef struct {
     double (*get_value)(const benchmark_results_t *);
 } metric_def_t;
 
+// Metric tracked against the baseline
+typedef struct {
+    const char *key; // JSON key in the "metrics" object
+    int lower_is_better;
+    double (*get_value)(const benchmark_results_t *);
+} regression_def_t;
+
 // Forward declarations
 double metagraph_get_node_lookup(const benchmark_results_t *results);
+double metagraph_get_node_lookup_p99(const benchmark_results_t *results);
+double metagraph_get_node_lookup_p999(const benchmark_results_t *results);
+double metagraph_get_bundle_lookup(const benchmark_results_t *results);
+double metagraph_get_bundle_lookup_p99(const benchmark_results_t *results);
+double metagraph_get_bundle_lookup_p999(const benchmark_results_t *results);
+double metagraph_get_node_batch_lookup(const benchmark_results_t *results);
+double metagraph_get_bundle_batch_lookup(const benchmark_results_t *results);
+double metagraph_get_bundle_load(const benchmark_results_t *results);
+double metagraph_get_bundle_load_p99(const benchmark_results_t *results);
+double metagraph_get_bundle_load_p999(const benchmark_results_t *results);
+double metagraph_get_graph_build(const benchmark_results_t *results);
+double metagraph_get_bundle_write(const benchmark_results_t *results);
 double metagraph_get_bundle_loading(const benchmark_results_t *results);
 double metagraph_get_load_time(const benchmark_results_t *results);
 double metagraph_get_memory_overhead(const benchmark_results_t *results);
-metagraph_result_t metagraph_run_benchmarks(benchmark_results_t *results);
+uint64_t metagraph_bench_now_ns(void);
+uint64_t metagraph_bench_next_random(uint64_t *state);
+metagraph_id_t metagraph_bench_node_id(uint64_t index);
+metagraph_id_t metagraph_bench_edge_id(uint64_t node, uint64_t slot);
+int metagraph_bench_compare_doubles(const void *left, const void *right);
+void metagraph_bench_percentiles(double *samples, size_t count,
+                                 benchmark_percentiles_t *out);
+metagraph_result_t
+metagraph_bench_build_graph(uint64_t node_count, uint64_t edges_per_node,
+                            const uint8_t *payload, uint64_t payload_bytes,
+                            uint64_t seed, metagraph_graph_t **out_graph);
+metagraph_result_t metagraph_bench_node_lookup(const benchmark_config_t *config,
+                                               benchmark_results_t *results);
+metagraph_result_t metagraph_bench_bundle(const benchmark_config_t *config,
+                                          benchmark_results_t *results);
+metagraph_result_t metagraph_bench_bundle_write(
+    const benchmark_config_t *config, uint8_t **out_payload,
+    benchmark_results_t *results);
+metagraph_result_t metagraph_bench_bundle_load(const benchmark_config_t *config,
+                                               benchmark_results_t *results);
+metagraph_result_t
+metagraph_bench_bundle_lookup(const benchmark_config_t *config,
+                              benchmark_results_t *results);
+metagraph_result_t metagraph_run_benchmarks(const benchmark_config_t *config,
+                                            benchmark_results_t *results);
 metagraph_result_t metagraph_check_target(const char *name, double actual,
                                           double target, int less_than,
                                           int *passed);
@@ -60,16 +162,64 @@ void metagraph_print_validation_results(int all_passed);
 metagraph_result_t
 metagraph_validate_performance(const benchmark_results_t *results,
                                int *all_passed);
-int metagraph_parse_args(int argc, char *argv[]);
+metagraph_result_t metagraph_write_json(const benchmark_config_t *config,
+                                        const benchmark_results_t *results);
+metagraph_result_t metagraph_read_baseline(const char *path, char **out_text);
+int metagraph_baseline_value(const char *text, const char *key, double *value);
+metagraph_result_t
+metagraph_compare_baseline(const benchmark_config_t *config,
+                           const benchmark_results_t *results,
+                           int *all_passed);
+int metagraph_parse_count(const char *text, uint64_t *value);
+int metagraph_parse_args(int argc, char *argv[], benchmark_config_t *config);
+void metagraph_print_usage(const char *program);
 void metagraph_print_header(void);
-metagraph_result_t metagraph_execute_benchmark_flow(int validate_only,
-                                                    int *all_passed);
-metagraph_result_t metagraph_execute_benchmarks(int validate_only);
+metagraph_result_t
+metagraph_execute_benchmark_flow(const benchmark_config_t *config,
+                                 int *all_passed);
+metagraph_result_t
+metagraph_execute_benchmarks(const benchmark_config_t *config);
 metagraph_result_t metagraph_validate_targets(int argc, char *argv[]);
 
 // Getters for metrics
 double metagraph_get_node_lookup(const benchmark_results_t *results) {
-    return results->node_lookup_ns;
+    return results->node_lookup_ns.p50;
+}
+double metagraph_get_node_lookup_p99(const benchmark_results_t *results) {
+    return results->node_lookup_ns.p99;
+}
+double metagraph_get_node_lookup_p999(const benchmark_results_t *results) {
+    return results->node_lookup_ns.p999;
+}
+double metagraph_get_bundle_lookup(const benchmark_results_t *results) {
+    return results->bundle_lookup_ns.p50;
+}
+double metagraph_get_bundle_lookup_p99(const benchmark_results_t *results) {
+    return results->bundle_lookup_ns.p99;
+}
+double metagraph_get_bundle_lookup_p999(const benchmark_results_t *results) {
+    return results->bundle_lookup_ns.p999;
+}
+double metagraph_get_node_batch_lookup(const benchmark_results_t *results) {
+    return results->node_batch_lookup_ns.p50;
+}
+double metagraph_get_bundle_batch_lookup(const benchmark_results_t *results) {
+    return results->bundle_batch_lookup_ns.p50;
+}
+double metagraph_get_bundle_load(const benchmark_results_t *results) {
+    return results->bundle_load_ms.p50;
+}
+double metagraph_get_bundle_load_p99(const benchmark_results_t *results) {
+    return results->bundle_load_ms.p99;
+}
+double metagraph_get_bundle_load_p999(const benchmark_results_t *results) {
+    return results->bundle_load_ms.p999;
+}
+double metagraph_get_graph_build(const benchmark_results_t *results) {
+    return results->graph_build_us_per_node;
+}
+double metagraph_get_bundle_write(const benchmark_results_t *results) {
+    return results->bundle_write_gbps;
 }
 double metagraph_get_bundle_loading(const benchmark_results_t *results) {
     return results->bundle_loading_gbps;
@@ -83,7 +233,7 @@ double metagraph_get_memory_overhead(const benchmark_results_t *results) {
 
 // Metric definitions table
 static const metric_def_t metrics[] = {
-    {"Node Lookup Time", METAGRAPH_TARGET_NODE_LOOKUP_NS, 1,
+    {"Node Lookup Time (p50)", METAGRAPH_TARGET_NODE_LOOKUP_NS, 1,
      metagraph_get_node_lookup},
     {"Bundle Loading Speed", METAGRAPH_TARGET_BUNDLE_LOADING_GBPS, 0,
      metagraph_get_bundle_loading},
@@ -94,17 +244,441 @@ static const metric_def_t metrics[] = {
 
 #define METAGRAPH_NUM_METRICS (sizeof(metrics) / sizeof(metrics[0]))
 
-// Simulate benchmark results (placeholder)
-metagraph_result_t metagraph_run_benchmarks(benchmark_results_t *results) {
-    METAGRAPH_CHECK_NULL(results);
+// Every value written to the JSON report. Medians and throughputs are
+// gated against the baseline; tail latencies are recorded but too noisy
+// on shared runners to gate at a few percent.
+static const struct {
+    regression_def_t def;
+    int gated;
+} report_metrics[] = {
+    {{"node_lookup_p50_ns", 1, metagraph_get_node_lookup}, 1},
+    {{"node_lookup_p99_ns", 1, metagraph_get_node_lookup_p99}, 0},
+    {{"node_lookup_p999_ns", 1, metagraph_get_node_lookup_p999}, 0},
+    {{"bundle_lookup_p50_ns", 1, metagraph_get_bundle_lookup}, 1},
+    {{"bundle_lookup_p99_ns", 1, metagraph_get_bundle_lookup_p99}, 0},
+    {{"bundle_lookup_p999_ns", 1, metagraph_get_bundle_lookup_p999}, 0},
+    {{"node_batch_lookup_p50_ns", 1, metagraph_get_node_batch_lookup}, 1},
+    {{"bundle_batch_lookup_p50_ns", 1, metagraph_get_bundle_batch_lookup}, 1},
+    {{"bundle_load_p50_ms", 1, metagraph_get_bundle_load}, 1},
+    {{"bundle_load_p99_ms", 1, metagraph_get_bundle_load_p99}, 0},
+    {{"bundle_load_p999_ms", 1, metagraph_get_bundle_load_p999}, 0},
+    {{"graph_build_us_per_node", 1, metagraph_get_graph_build}, 1},
+    {{"bundle_write_gbps", 0, metagraph_get_bundle_write}, 0},
+    {{"bundle_loading_gbps", 0, metagraph_get_bundle_loading}, 1},
+    {{"load_time_1gb_ms", 1, metagraph_get_load_time}, 0},
+    {{"memory_overhead_pct", 1, metagraph_get_memory_overhead}, 1},
+};
+
+#define METAGRAPH_NUM_REPORT_METRICS                                           \
+    (sizeof(report_metrics) / sizeof(report_metrics[0]))
+
+// Monotonic clock in nanoseconds
+uint64_t metagraph_bench_now_ns(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// splitmix64: cheap, seedable and good enough for synthetic workloads
+uint64_t metagraph_bench_next_random(uint64_t *state) {
+    uint64_t value = (*state += 0x9E3779B97F4A7C15ULL);
+    value = (value ^ (value >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27U)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31U);
+}
+
+// Asset IDs are content hashes in practice, so scatter them.
+metagraph_id_t metagraph_bench_node_id(uint64_t index) {
+    uint64_t state = index;
+    return (metagraph_id_t){.high = metagraph_bench_next_random(&state),
+                            .low = index};
+}
+
+metagraph_id_t metagraph_bench_edge_id(uint64_t node, uint64_t slot) {
+    uint64_t state = ~node;
+    return (metagraph_id_t){.high = metagraph_bench_next_random(&state),
+                            .low = (node << 8U) | slot};
+}
+
+int metagraph_bench_compare_doubles(const void *left, const void *right) {
+    const double a = *(const double *)left;
+    const double b = *(const double *)right;
+    return (a > b) - (a < b);
+}
+
+// Nearest-rank percentiles; sorts samples in place
+void metagraph_bench_percentiles(double *samples, size_t count,
+                                 benchmark_percentiles_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (count == 0) {
+        return;
+    }
+    qsort(samples, count, sizeof(*samples), metagraph_bench_compare_doubles);
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    const double ranks[] = {0.50, 0.99, 0.999};
+    double values[3];
+    for (size_t i = 0; i < 3; i++) {
+        const double position = ranks[i] * (double)count;
+        size_t rank = (size_t)position;
+        if ((double)rank < position) {
+            rank++;
+        }
+        values[i] = samples[rank ? rank - 1U : 0U];
+    }
+    out->p50 = values[0];
+    out->p99 = values[1];
+    out->p999 = values[2];
+    out->mean = sum / (double)count;
+}
+
+// Nodes share one payload buffer; the graph borrows node data, so payload
+// memory does not scale with node count.
+metagraph_result_t
+metagraph_bench_build_graph(uint64_t node_count, uint64_t edges_per_node,
+                            const uint8_t *payload, uint64_t payload_bytes,
+                            uint64_t seed, metagraph_graph_t **out_graph) {
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    const metagraph_graph_config_t graph_config = {
+        .initial_node_capacity = (size_t)node_count,
+        .initial_edge_capacity = (size_t)(node_count * edges_per_node),
+    };
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_CHECK(metagraph_graph_create(&graph_config, &graph));
+
+    char name[64];
+    for (uint64_t i = 0; i < node_count; i++) {
+        (void)snprintf(name, sizeof(name), "assets/%06llu/%llu.bin",
+                       (unsigned long long)(i / 1000U),
+                       (unsigned long long)i);
+        const metagraph_node_metadata_t node = {
+            .id = metagraph_bench_node_id(i),
+            .name = name,
+            .type = (uint32_t)(i % 16U),
+            .data_size = (size_t)payload_bytes,
+            // The graph never writes through node data.
+            .data = (void *)(uintptr_t)payload,
+            .hash = i,
+        };
+        METAGRAPH_CHECK_GOTO(metagraph_graph_add_node(graph, &node, NULL),
+                             fail);
+    }
+
+    uint64_t random_state = seed;
+    for (uint64_t i = 0; i < node_count && node_count > 1; i++) {
+        for (uint64_t slot = 0; slot < edges_per_node; slot++) {
+            uint64_t target = metagraph_bench_next_random(&random_state) %
+                              node_count;
+            if (target == i) {
+                target = (target + 1U) % node_count;
+            }
+            const metagraph_id_t members[] = {metagraph_bench_node_id(i),
+                                              metagraph_bench_node_id(target)};
+            const metagraph_edge_metadata_t edge = {
+                .id = metagraph_bench_edge_id(i, slot),
+                .type = 1,
+                .weight = 1.0F,
+                .node_count = 2,
+                .nodes = members,
+            };
+            METAGRAPH_CHECK_GOTO(metagraph_graph_add_edge(graph, &edge, NULL),
+                                 fail);
+        }
+    }
+    *out_graph = graph;
+    return METAGRAPH_OK();
+
+fail:
+    (void)metagraph_graph_destroy(graph);
+    return result;
+}
+
+// Random-order ID lookups against the in-memory graph
+metagraph_result_t metagraph_bench_node_lookup(const benchmark_config_t *config,
+                                               benchmark_results_t *results) {
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    static const uint8_t payload[1] = {0};
+    metagraph_graph_t *graph = NULL;
+
+    const uint64_t start = metagraph_bench_now_ns();
+    METAGRAPH_CHECK(metagraph_bench_build_graph(config->nodes,
+                                                config->edges_per_node, payload,
+                                                0, config->seed, &graph));
+    const uint64_t built = metagraph_bench_now_ns();
+    results->graph_build_us_per_node =
+        (double)(built - start) / 1000.0 / (double)config->nodes;
+
+    metagraph_graph_stats_t stats;
+    METAGRAPH_CHECK_GOTO(metagraph_graph_get_stats(graph, &stats), done);
+    results->graph_memory_bytes = stats.memory_bytes;
+
+    const size_t batches =
+        (size_t)(config->lookups / METAGRAPH_BENCH_LOOKUP_BATCH);
+    double *samples = calloc(batches ? batches : 1U, sizeof(*samples));
+    metagraph_id_t *keys = malloc(METAGRAPH_BENCH_LOOKUP_BATCH * sizeof(*keys));
+    if (!samples || !keys) {
+        free(samples);
+        free(keys);
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Failed to allocate lookup samples");
+        goto done;
+    }
+
+    uint64_t random_state = config->seed ^ 0xA5A5A5A5ULL;
+    uint64_t checksum = 0;
+    for (size_t batch = 0; batch < batches; batch++) {
+        for (uint32_t i = 0; i < METAGRAPH_BENCH_LOOKUP_BATCH; i++) {
+            keys[i] = metagraph_bench_node_id(
+                metagraph_bench_next_random(&random_state) % config->nodes);
+        }
+        const uint64_t batch_start = metagraph_bench_now_ns();
+        for (uint32_t i = 0; i < METAGRAPH_BENCH_LOOKUP_BATCH; i++) {
+            metagraph_node_index_t index = 0;
+            (void)metagraph_graph_find_node(graph, keys[i], &index);
+            checksum += index;
+        }
+        samples[batch] = (double)(metagraph_bench_now_ns() - batch_start) /
+                         (double)METAGRAPH_BENCH_LOOKUP_BATCH;
+    }
+    metagraph_bench_percentiles(samples, batches, &results->node_lookup_ns);
+
+    // The same workload through the batched entry point
+    metagraph_node_index_t indices[METAGRAPH_BENCH_LOOKUP_BATCH];
+    for (size_t batch = 0; batch < batches; batch++) {
+        for (uint32_t i = 0; i < METAGRAPH_BENCH_LOOKUP_BATCH; i++) {
+            keys[i] = metagraph_bench_node_id(
+                metagraph_bench_next_random(&random_state) % config->nodes);
+        }
+        const uint64_t batch_start = metagraph_bench_now_ns();
+        (void)metagraph_graph_find_nodes(graph, keys,
+                                         METAGRAPH_BENCH_LOOKUP_BATCH, indices,
+                                         NULL);
+        samples[batch] = (double)(metagraph_bench_now_ns() - batch_start) /
+                         (double)METAGRAPH_BENCH_LOOKUP_BATCH;
+        checksum += indices[0];
+    }
+    metagraph_bench_percentiles(samples, batches,
+                                &results->node_batch_lookup_ns);
+    if (checksum == UINT64_MAX) {
+        (void)printf("checksum %llu\n", (unsigned long long)checksum);
+    }
+    free(samples);
+    free(keys);
+
+done:
+    (void)metagraph_graph_destroy(graph);
+    return result;
+}
+
+// Build a payload-heavy graph and serialize it to the scratch bundle
+metagraph_result_t metagraph_bench_bundle_write(
+    const benchmark_config_t *config, uint8_t **out_payload,
+    benchmark_results_t *results) {
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    const uint64_t payload_bytes = config->payload_bytes;
+    uint64_t node_count =
+        config->bundle_mb * METAGRAPH_BENCH_BYTES_PER_MB / payload_bytes;
+    if (node_count < 2) {
+        node_count = 2;
+    }
+
+    uint8_t *payload = malloc((size_t)payload_bytes);
+    METAGRAPH_CHECK_ALLOC(payload);
+    uint64_t random_state = config->seed;
+    for (uint64_t i = 0; i < payload_bytes; i++) {
+        payload[i] = (uint8_t)metagraph_bench_next_random(&random_state);
+    }
+    *out_payload = payload;
+
+    metagraph_graph_t *graph = NULL;
+    METAGRAPH_CHECK(metagraph_bench_build_graph(node_count,
+                                                config->edges_per_node, payload,
+                                                payload_bytes, config->seed,
+                                                &graph));
+
+    const metagraph_bundle_write_options_t options = {
+        .creator = "mg_benchmarks",
+        .description = "synthetic benchmark bundle",
+    };
+    const uint64_t start = metagraph_bench_now_ns();
+    uint64_t elapsed = 0;
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_write_graph(graph, config->bundle_path, &options),
+        done);
+    elapsed = metagraph_bench_now_ns() - start;
+
+    results->bundle_nodes = node_count;
+    results->payload_bytes = node_count * payload_bytes;
+
+done:
+    (void)metagraph_graph_destroy(graph);
+    if (result == METAGRAPH_SUCCESS) {
+        metagraph_bundle_t *bundle = NULL;
+        METAGRAPH_CHECK(metagraph_bundle_create_from_file(config->bundle_path,
+                                                          NULL, &bundle));
+        results->bundle_bytes = metagraph_bundle_get_header(bundle)->total_size;
+        (void)metagraph_bundle_destroy(bundle);
+        results->bundle_write_gbps = (double)results->bundle_bytes /
+                                     (double)elapsed;
+        results->memory_overhead_pct =
+            100.0 * (double)(results->bundle_bytes - results->payload_bytes) /
+            (double)results->bundle_bytes;
+    }
+    return result;
+}
 
-    // In real implementation, these would be actual benchmark measurements
-    // For now, using placeholder values that pass targets
-    results->node_lookup_ns = 85.0;     // Simulated 85ns lookup
-    results->bundle_loading_gbps = 1.2; // Simulated 1.2GB/s
-    results->load_time_1gb_ms = 180.0;  // Simulated 180ms
-    results->memory_overhead_pct = 3.5; // Simulated 3.5%
+// Map with prefaulting and touch every section a first query needs.
+// Runs against a warm page cache: this measures the loader, not the disk.
+metagraph_result_t metagraph_bench_bundle_load(const benchmark_config_t *config,
+                                               benchmark_results_t *results) {
+    const size_t iterations = (size_t)config->iterations;
+    double *samples = calloc(iterations, sizeof(*samples));
+    METAGRAPH_CHECK_ALLOC(samples);
 
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    const metagraph_bundle_options_t options = {
+        .flags = METAGRAPH_BUNDLE_OPEN_POPULATE};
+    const metagraph_id_t probe = metagraph_bench_node_id(0);
+    for (size_t i = 0; i < iterations; i++) {
+        metagraph_bundle_t *bundle = NULL;
+        const uint64_t start = metagraph_bench_now_ns();
+        METAGRAPH_CHECK_GOTO(metagraph_bundle_create_from_file(
+                                 config->bundle_path, &options, &bundle),
+                             done);
+        size_t edge_count = 0;
+        metagraph_node_index_t index = 0;
+        metagraph_node_metadata_t node;
+        metagraph_result_t query =
+            metagraph_bundle_edge_count(bundle, &edge_count);
+        if (query == METAGRAPH_SUCCESS) {
+            query = metagraph_bundle_find_node(bundle, probe, &index);
+        }
+        if (query == METAGRAPH_SUCCESS) {
+            query = metagraph_bundle_get_node(bundle, index, &node);
+        }
+        const uint64_t elapsed = metagraph_bench_now_ns() - start;
+        (void)metagraph_bundle_destroy(bundle);
+        METAGRAPH_CHECK_GOTO(query, done);
+        samples[i] = (double)elapsed / METAGRAPH_BENCH_NS_PER_MS;
+    }
+
+    metagraph_bench_percentiles(samples, iterations, &results->bundle_load_ms);
+    const double seconds = results->bundle_load_ms.p50 / 1000.0;
+    results->bundle_loading_gbps =
+        seconds > 0.0
+            ? (double)results->bundle_bytes / METAGRAPH_BENCH_BYTES_PER_GB /
+                  seconds
+            : 0.0;
+    results->load_time_1gb_ms =
+        results->bundle_load_ms.p50 * METAGRAPH_BENCH_BYTES_PER_GB /
+        (double)results->bundle_bytes;
+
+done:
+    free(samples);
+    return result;
+}
+
+// Random-order ID lookups through the mapped INDEX section
+metagraph_result_t
+metagraph_bench_bundle_lookup(const benchmark_config_t *config,
+                              benchmark_results_t *results) {
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_CHECK(
+        metagraph_bundle_create_from_file(config->bundle_path, NULL, &bundle));
+
+    const size_t batches =
+        (size_t)(config->lookups / METAGRAPH_BENCH_LOOKUP_BATCH);
+    double *samples = calloc(batches ? batches : 1U, sizeof(*samples));
+    metagraph_id_t keys[METAGRAPH_BENCH_LOOKUP_BATCH];
+    if (!samples) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Failed to allocate lookup samples");
+        goto done;
+    }
+
+    uint64_t random_state = config->seed ^ 0x5A5A5A5AULL;
+    uint64_t checksum = 0;
+    metagraph_node_index_t index = 0;
+    // Hydrate the index outside the timed region.
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_find_node(
+                             bundle, metagraph_bench_node_id(0), &index),
+                         done);
+    for (size_t batch = 0; batch < batches; batch++) {
+        for (uint32_t i = 0; i < METAGRAPH_BENCH_LOOKUP_BATCH; i++) {
+            keys[i] = metagraph_bench_node_id(
+                metagraph_bench_next_random(&random_state) %
+                results->bundle_nodes);
+        }
+        const uint64_t batch_start = metagraph_bench_now_ns();
+        for (uint32_t i = 0; i < METAGRAPH_BENCH_LOOKUP_BATCH; i++) {
+            (void)metagraph_bundle_find_node(bundle, keys[i], &index);
+            checksum += index;
+        }
+        samples[batch] = (double)(metagraph_bench_now_ns() - batch_start) /
+                         (double)METAGRAPH_BENCH_LOOKUP_BATCH;
+    }
+    metagraph_bench_percentiles(samples, batches, &results->bundle_lookup_ns);
+
+    // The same workload through the batched entry point
+    metagraph_node_index_t indices[METAGRAPH_BENCH_LOOKUP_BATCH];
+    for (size_t batch = 0; batch < batches; batch++) {
+        for (uint32_t i = 0; i < METAGRAPH_BENCH_LOOKUP_BATCH; i++) {
+            keys[i] = metagraph_bench_node_id(
+                metagraph_bench_next_random(&random_state) %
+                results->bundle_nodes);
+        }
+        const uint64_t batch_start = metagraph_bench_now_ns();
+        (void)metagraph_bundle_find_nodes(bundle, keys,
+                                          METAGRAPH_BENCH_LOOKUP_BATCH, indices,
+                                          NULL);
+        samples[batch] = (double)(metagraph_bench_now_ns() - batch_start) /
+                         (double)METAGRAPH_BENCH_LOOKUP_BATCH;
+        checksum += indices[0];
+    }
+    metagraph_bench_percentiles(samples, batches,
+                                &results->bundle_batch_lookup_ns);
+    if (checksum == UINT64_MAX) {
+        (void)printf("checksum %llu\n", (unsigned long long)checksum);
+    }
+
+done:
+    free(samples);
+    (void)metagraph_bundle_destroy(bundle);
+    return result;
+}
+
+metagraph_result_t metagraph_bench_bundle(const benchmark_config_t *config,
+                                          benchmark_results_t *results) {
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    uint8_t *payload = NULL;
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bench_bundle_write(config, &payload, results), done);
+    METAGRAPH_CHECK_GOTO(metagraph_bench_bundle_load(config, results), done);
+    METAGRAPH_CHECK_GOTO(metagraph_bench_bundle_lookup(config, results), done);
+
+done:
+    free(payload);
+    (void)remove(config->bundle_path);
+    return result;
+}
+
+metagraph_result_t metagraph_run_benchmarks(const benchmark_config_t *config,
+                                            benchmark_results_t *results) {
+    METAGRAPH_CHECK_NULL(config);
+    METAGRAPH_CHECK_NULL(results);
+    memset(results, 0, sizeof(*results));
+
+    (void)fprintf(stderr, "Graph lookups: %llu nodes, %llu edges/node\n",
+                  (unsigned long long)config->nodes,
+                  (unsigned long long)config->edges_per_node);
+    METAGRAPH_CHECK(metagraph_bench_node_lookup(config, results));
+    (void)fprintf(stderr, "Bundle: ~%llu MiB of %llu-byte payloads\n",
+                  (unsigned long long)config->bundle_mb,
+                  (unsigned long long)config->payload_bytes);
+    METAGRAPH_CHECK(metagraph_bench_bundle(config, results));
     return METAGRAPH_OK();
 }
 
@@ -138,19 +712,32 @@ metagraph_print_detailed_results(const benchmark_results_t *results) {
     (void)printf("\nDetailed Benchmark Results:\n");
     (void)printf("---------------------------\n");
     (void)printf("Node Operations:\n");
-    (void)printf("  Lookup: %.2f ns (O(1) hash-based)\n",
-                 results->node_lookup_ns);
-    (void)printf("  Insert: N/A (not implemented)\n");
-    (void)printf("  Delete: N/A (not implemented)\n");
+    (void)printf("  Graph creation: %.3f us per node (%llu bytes resident)\n",
+                 results->graph_build_us_per_node,
+                 (unsigned long long)results->graph_memory_bytes);
+    (void)printf("  Lookup (graph):  p50 %.1f ns, p99 %.1f ns, p999 %.1f ns\n",
+                 results->node_lookup_ns.p50, results->node_lookup_ns.p99,
+                 results->node_lookup_ns.p999);
+    (void)printf("  Lookup (bundle): p50 %.1f ns, p99 %.1f ns, p999 %.1f ns\n",
+                 results->bundle_lookup_ns.p50, results->bundle_lookup_ns.p99,
+                 results->bundle_lookup_ns.p999);
+    (void)printf("  Batched (graph):  p50 %.1f ns per ID\n",
+                 results->node_batch_lookup_ns.p50);
+    (void)printf("  Batched (bundle): p50 %.1f ns per ID\n",
+                 results->bundle_batch_lookup_ns.p50);
     (void)printf("\nI/O Performance:\n");
-    (void)printf("  Bundle Loading: %.2f GB/s\n", results->bundle_loading_gbps);
-    (void)printf("  Memory Mapping: N/A (not implemented)\n");
+    (void)printf("  Bundle: %llu nodes, %llu bytes\n",
+                 (unsigned long long)results->bundle_nodes,
+                 (unsigned long long)results->bundle_bytes);
+    (void)printf("  Bundle Writing: %.2f GB/s\n", results->bundle_write_gbps);
+    (void)printf("  Bundle Loading: %.2f GB/s (warm page cache)\n",
+                 results->bundle_loading_gbps);
+    (void)printf("  Load time: p50 %.2f ms, p99 %.2f ms, p999 %.2f ms\n",
+                 results->bundle_load_ms.p50, results->bundle_load_ms.p99,
+                 results->bundle_load_ms.p999);
     (void)printf("\nMemory Usage:\n");
-    (void)printf("  Overhead: %.1f%%\n", results->memory_overhead_pct);
-    (void)printf("  Pool Efficiency: N/A (not implemented)\n");
-    (void)printf("\nConcurrency:\n");
-    (void)printf("  Thread Scaling: N/A (not implemented)\n");
-    (void)printf("  Lock Contention: N/A (not implemented)\n");
+    (void)printf("  Format overhead: %.2f%% of bundle bytes are not payload\n",
+                 results->memory_overhead_pct);
 
     return METAGRAPH_OK();
 }
@@ -197,8 +784,6 @@ void metagraph_print_validation_results(int all_passed) {
     if (all_passed) {
         (void)printf("%s✓ All performance targets met!%s\n",
                      METAGRAPH_COLOR_GREEN, METAGRAPH_COLOR_RESET);
-        (void)printf("  Regression tolerance: ±%d%%\n",
-                     METAGRAPH_TARGET_REGRESSION_TOLERANCE_PCT);
     } else {
         (void)printf("%s✗ Some performance targets not met!%s\n",
                      METAGRAPH_COLOR_RED, METAGRAPH_COLOR_RESET);
@@ -221,16 +806,273 @@ metagraph_validate_performance(const benchmark_results_t *results,
     return METAGRAPH_OK();
 }
 
-// Parse command line arguments
-int metagraph_parse_args(int argc, char *argv[]) {
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--validate-targets") == 0) {
-            return 1;
+// Write the machine-readable report
+metagraph_result_t metagraph_write_json(const benchmark_config_t *config,
+                                        const benchmark_results_t *results) {
+    FILE *out = fopen(config->json_path, "w");
+    if (!out) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Cannot write %s (errno %d)", config->json_path,
+                             errno);
+    }
+
+    (void)fprintf(out, "{\n  \"schema\": 1,\n  \"version\": \"%s\",\n",
+                  METAGRAPH_VERSION_STRING);
+    (void)fprintf(out,
+                  "  \"config\": {\"nodes\": %llu, \"edges_per_node\": %llu, "
+                  "\"lookups\": %llu, \"bundle_mb\": %llu, "
+                  "\"payload_bytes\": %llu, \"iterations\": %llu, "
+                  "\"seed\": %llu},\n",
+                  (unsigned long long)config->nodes,
+                  (unsigned long long)config->edges_per_node,
+                  (unsigned long long)config->lookups,
+                  (unsigned long long)config->bundle_mb,
+                  (unsigned long long)config->payload_bytes,
+                  (unsigned long long)config->iterations,
+                  (unsigned long long)config->seed);
+    (void)fprintf(out,
+                  "  \"bundle\": {\"nodes\": %llu, \"bytes\": %llu, "
+                  "\"payload_bytes\": %llu},\n",
+                  (unsigned long long)results->bundle_nodes,
+                  (unsigned long long)results->bundle_bytes,
+                  (unsigned long long)results->payload_bytes);
+    (void)fprintf(out, "  \"metrics\": {\n");
+    for (size_t i = 0; i < METAGRAPH_NUM_REPORT_METRICS; i++) {
+        const regression_def_t *def = &report_metrics[i].def;
+        (void)fprintf(out, "    \"%s\": %.6g%s\n", def->key,
+                      def->get_value(results),
+                      i + 1U < METAGRAPH_NUM_REPORT_METRICS ? "," : "");
+    }
+    (void)fprintf(out, "  }\n}\n");
+
+    if (fclose(out) != 0) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                             "Failed to close %s", config->json_path);
+    }
+    return METAGRAPH_OK();
+}
+
+metagraph_result_t metagraph_read_baseline(const char *path, char **out_text) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_FILE_NOT_FOUND,
+                             "Cannot open baseline %s", path);
+    }
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    char *text = NULL;
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file);
+    }
+    if (size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                               "Cannot size baseline %s", path);
+        goto done;
+    }
+    text = malloc((size_t)size + 1U);
+    if (!text) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Baseline %s too large", path);
+        goto done;
+    }
+    if (fread(text, 1, (size_t)size, file) != (size_t)size) {
+        free(text);
+        text = NULL;
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_IO_FAILURE,
+                               "Failed to read baseline %s", path);
+        goto done;
+    }
+    text[size] = '\0';
+    *out_text = text;
+
+done:
+    (void)fclose(file);
+    return result;
+}
+
+// Find "key": <number> in a report written by metagraph_write_json()
+int metagraph_baseline_value(const char *text, const char *key, double *value) {
+    const size_t key_length = strlen(key);
+    for (const char *cursor = strchr(text, '"'); cursor;
+         cursor = strchr(cursor + 1, '"')) {
+        if (strncmp(cursor + 1, key, key_length) != 0 ||
+            cursor[key_length + 1U] != '"') {
+            continue;
+        }
+        const char *colon = cursor + key_length + 2U;
+        while (*colon == ' ') {
+            colon++;
         }
+        if (*colon != ':') {
+            continue;
+        }
+        char *end = NULL;
+        *value = strtod(colon + 1, &end);
+        return end != colon + 1;
     }
     return 0;
 }
 
+// Flag metrics that moved the wrong way by more than the tolerance
+metagraph_result_t
+metagraph_compare_baseline(const benchmark_config_t *config,
+                           const benchmark_results_t *results,
+                           int *all_passed) {
+    char *text = NULL;
+    METAGRAPH_CHECK(metagraph_read_baseline(config->baseline_path, &text));
+
+    (void)printf("\nBaseline Comparison (%s, tolerance %d%%):\n",
+                 config->baseline_path,
+                 METAGRAPH_TARGET_REGRESSION_TOLERANCE_PCT);
+    (void)printf("------------------------------\n");
+    double baseline_nodes = 0.0;
+    double baseline_bundle_mb = 0.0;
+    if (!metagraph_baseline_value(text, "nodes", &baseline_nodes) ||
+        !metagraph_baseline_value(text, "bundle_mb", &baseline_bundle_mb) ||
+        baseline_nodes < (double)config->nodes ||
+        baseline_nodes > (double)config->nodes ||
+        baseline_bundle_mb < (double)config->bundle_mb ||
+        baseline_bundle_mb > (double)config->bundle_mb) {
+        (void)printf("[WARN] Baseline was recorded with a different workload\n");
+    }
+    for (size_t i = 0; i < METAGRAPH_NUM_REPORT_METRICS; i++) {
+        if (!report_metrics[i].gated) {
+            continue;
+        }
+        const regression_def_t *def = &report_metrics[i].def;
+        double baseline = 0.0;
+        if (!metagraph_baseline_value(text, def->key, &baseline) ||
+            baseline <= 0.0) {
+            (void)printf("[SKIP] %s: not in baseline\n", def->key);
+            continue;
+        }
+        const double actual = def->get_value(results);
+        const double change_pct = (actual - baseline) / baseline * 100.0;
+        const double regression_pct =
+            def->lower_is_better ? change_pct : -change_pct;
+        const int passed =
+            regression_pct <= (double)METAGRAPH_TARGET_REGRESSION_TOLERANCE_PCT;
+        (void)printf("%s[%s]%s %s: %.4g vs %.4g (%+.1f%%)\n",
+                     passed ? METAGRAPH_COLOR_GREEN : METAGRAPH_COLOR_RED,
+                     passed ? "PASS" : "REGRESSED", METAGRAPH_COLOR_RESET,
+                     def->key, actual, baseline, change_pct);
+        *all_passed &= passed;
+    }
+    free(text);
+    return METAGRAPH_OK();
+}
+
+// Parse a positive decimal count
+int metagraph_parse_count(const char *text, uint64_t *value) {
+    if (!text || *text < '0' || *text > '9') {
+        return 0;
+    }
+    char *end = NULL;
+    errno = 0;
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed == 0) {
+        return 0;
+    }
+    *value = parsed;
+    return 1;
+}
+
+void metagraph_print_usage(const char *program) {
+    (void)fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "  --validate-targets     Fail if documented targets are missed\n"
+        "  --nodes N              Nodes in the lookup graph (default %u)\n"
+        "  --edges-per-node N     Hyperedges per node (default %u)\n"
+        "  --lookups N            Timed lookups per benchmark (default %u)\n"
+        "  --bundle-mb N          Bundle payload size in MiB (default %u)\n"
+        "  --payload-bytes N      Payload bytes per bundle node (default %u)\n"
+        "  --iterations N         Timed bundle loads (default %u)\n"
+        "  --seed N               Synthetic data seed\n"
+        "  --bundle-path PATH     Scratch bundle (default %s)\n"
+        "  --json PATH            Write a JSON report\n"
+        "  --baseline PATH        Compare against a previous JSON report\n",
+        program, METAGRAPH_BENCH_DEFAULT_NODES,
+        METAGRAPH_BENCH_DEFAULT_EDGES_PER_NODE, METAGRAPH_BENCH_DEFAULT_LOOKUPS,
+        METAGRAPH_BENCH_DEFAULT_BUNDLE_MB, METAGRAPH_BENCH_DEFAULT_PAYLOAD_BYTES,
+        METAGRAPH_BENCH_DEFAULT_ITERATIONS, METAGRAPH_BENCH_DEFAULT_BUNDLE_PATH);
+}
+
+// Parse command line arguments; returns 0 on bad usage
+int metagraph_parse_args(int argc, char *argv[], benchmark_config_t *config) {
+    *config = (benchmark_config_t){
+        .nodes = METAGRAPH_BENCH_DEFAULT_NODES,
+        .edges_per_node = METAGRAPH_BENCH_DEFAULT_EDGES_PER_NODE,
+        .lookups = METAGRAPH_BENCH_DEFAULT_LOOKUPS,
+        .bundle_mb = METAGRAPH_BENCH_DEFAULT_BUNDLE_MB,
+        .payload_bytes = METAGRAPH_BENCH_DEFAULT_PAYLOAD_BYTES,
+        .iterations = METAGRAPH_BENCH_DEFAULT_ITERATIONS,
+        .seed = METAGRAPH_BENCH_DEFAULT_SEED,
+        .bundle_path = METAGRAPH_BENCH_DEFAULT_BUNDLE_PATH,
+    };
+
+    static const struct {
+        const char *flag;
+        size_t offset;
+    } counts[] = {
+        {"--nodes", offsetof(benchmark_config_t, nodes)},
+        {"--edges-per-node", offsetof(benchmark_config_t, edges_per_node)},
+        {"--lookups", offsetof(benchmark_config_t, lookups)},
+        {"--bundle-mb", offsetof(benchmark_config_t, bundle_mb)},
+        {"--payload-bytes", offsetof(benchmark_config_t, payload_bytes)},
+        {"--iterations", offsetof(benchmark_config_t, iterations)},
+        {"--seed", offsetof(benchmark_config_t, seed)},
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--validate-targets") == 0) {
+            config->validate_only = 1;
+            continue;
+        }
+        if (next && strcmp(arg, "--json") == 0) {
+            config->json_path = next;
+            i++;
+            continue;
+        }
+        if (next && strcmp(arg, "--baseline") == 0) {
+            config->baseline_path = next;
+            i++;
+            continue;
+        }
+        if (next && strcmp(arg, "--bundle-path") == 0) {
+            config->bundle_path = next;
+            i++;
+            continue;
+        }
+        int matched = 0;
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            if (strcmp(arg, counts[c].flag) != 0) {
+                continue;
+            }
+            uint64_t value = 0;
+            if (!metagraph_parse_count(next, &value)) {
+                (void)fprintf(stderr, "%s needs a positive integer\n", arg);
+                return 0;
+            }
+            memcpy((char *)config + counts[c].offset, &value, sizeof(value));
+            matched = 1;
+            i++;
+            break;
+        }
+        if (!matched) {
+            return 0;
+        }
+    }
+    if (config->nodes > METAGRAPH_GRAPH_MAX_NODES ||
+        config->edges_per_node > 255U) {
+        (void)fprintf(stderr, "Workload exceeds graph limits\n");
+        return 0;
+    }
+    return 1;
+}
+
 // Print benchmark header
 void metagraph_print_header(void) {
     (void)printf("\n");
@@ -239,19 +1081,27 @@ void metagraph_print_header(void) {
 }
 
 // Execute benchmark flow
-metagraph_result_t metagraph_execute_benchmark_flow(int validate_only,
-                                                    int *all_passed) {
+metagraph_result_t
+metagraph_execute_benchmark_flow(const benchmark_config_t *config,
+                                 int *all_passed) {
     benchmark_results_t results;
 
-    METAGRAPH_CHECK(metagraph_run_benchmarks(&results));
+    METAGRAPH_CHECK(metagraph_run_benchmarks(config, &results));
     METAGRAPH_CHECK(metagraph_validate_performance(&results, all_passed));
+    if (config->baseline_path) {
+        METAGRAPH_CHECK(
+            metagraph_compare_baseline(config, &results, all_passed));
+    }
+    if (config->json_path) {
+        METAGRAPH_CHECK(metagraph_write_json(config, &results));
+    }
 
-    if (!(*all_passed) && validate_only) {
+    if (!(*all_passed) && config->validate_only) {
         return METAGRAPH_ERR(METAGRAPH_ERROR_PERFORMANCE_TARGET_FAILED,
                              "Performance targets not met");
     }
 
-    if (!validate_only) {
+    if (!config->validate_only) {
         METAGRAPH_CHECK(metagraph_print_detailed_results(&results));
     }
 
@@ -259,10 +1109,11 @@ metagraph_result_t metagraph_execute_benchmark_flow(int validate_only,
 }
 
 // Main benchmark execution
-metagraph_result_t metagraph_execute_benchmarks(int validate_only) {
+metagraph_result_t
+metagraph_execute_benchmarks(const benchmark_config_t *config) {
     int all_passed = 0;
     metagraph_result_t result =
-        metagraph_execute_benchmark_flow(validate_only, &all_passed);
+        metagraph_execute_benchmark_flow(config, &all_passed);
 
     if (metagraph_result_is_error(result)) {
         return result;
@@ -275,11 +1126,16 @@ metagraph_result_t metagraph_execute_benchmarks(int validate_only) {
 
 // Validate all performance targets
 metagraph_result_t metagraph_validate_targets(int argc, char *argv[]) {
-    int validate_only = metagraph_parse_args(argc, argv);
+    benchmark_config_t config;
+    if (!metagraph_parse_args(argc, argv, &config)) {
+        metagraph_print_usage(argv[0]);
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "Invalid arguments");
+    }
 
     metagraph_print_header();
 
-    metagraph_result_t result = metagraph_execute_benchmarks(validate_only);
+    metagraph_result_t result = metagraph_execute_benchmarks(&config);
 
     (void)printf("\n");
     return result;
@@ -287,5 +1143,5 @@ metagraph_result_t metagraph_validate_targets(int argc, char *argv[]) {
 
 int main(int argc, char *argv[]) {
     metagraph_result_t result = metagraph_validate_targets(argc, argv);
-    return (int)metagraph_result_is_success(result) ? 0 : 1;
+    return metagraph_result_is_success(result) ? 0 : 1;
 }
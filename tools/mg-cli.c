@@ -1,33 +1,935 @@
 /**
  * @file mg-cli.c
- * @brief MetaGraph command-line interface placeholder
+ * @brief MetaGraph bundle inspection, query and verification tool
+ *
+ * Every command maps the bundle and answers from the mapped sections:
+ * `stat` reads only the header, section table and metadata, `ls` and
+ * `deps` touch the node records and adjacency rows they print, and
+ * `verify` hashes the sections against their Merkle trees on all CPUs.
+ * Nothing is loaded into a graph, so inspecting a multi-gigabyte bundle
+ * costs a few page faults rather than a full read. `delta` writes a delta
+ * bundle between two bundles, and `--base` applies one before any other
+ * command reads it.
  */
 
+#include "metagraph/bundle.h"
+#include "metagraph/graph.h"
+#include "metagraph/integrity.h"
+#include "metagraph/result.h"
+#include "metagraph/version.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#define METAGRAPH_CLI_DEFAULT_LOOKUPS (1U << 20U)
+#define METAGRAPH_CLI_DEFAULT_ITERATIONS 15U
+#define METAGRAPH_CLI_DEFAULT_SEED 0x5EEDU
+
+// Lookups timed together; one clock read per batch keeps timer overhead
+// out of the per-lookup figures.
+#define METAGRAPH_CLI_BATCH 64U
+
+#define METAGRAPH_CLI_NS_PER_MS 1e6
+#define METAGRAPH_CLI_BYTES_PER_GB 1e9
+
+// Characters in a printed asset ID, excluding the terminator
+#define METAGRAPH_CLI_ID_CHARS 32U
+
+typedef struct {
+    const char *bundle_path;
+    const char *node;      // deps: node ID, #index or name
+    const char *hash;      // verify: trusted integrity hash in hex
+    const char *base;      // bundle a delta bundle applies to
+    const char *output;    // delta: output path
+    uint64_t limit;        // ls: nodes to print (0 = all)
+    uint64_t type;         // ls: type filter
+    bool has_type;         // ls: type filter set
+    bool reverse;          // deps: list dependents instead
+    bool transitive;       // deps: follow dependencies recursively
+    uint64_t depth;        // deps: transitive depth limit (0 = none)
+    uint64_t lookups;      // bench: timed lookups
+    uint64_t iterations;   // bench: timed opens
+    uint64_t seed;         // bench: lookup order seed
+} metagraph_cli_options_t;
+
+typedef metagraph_result_t (*metagraph_cli_command_fn)(
+    const metagraph_cli_options_t *options);
+
+static const char *const metagraph_cli_section_names[] = {
+    [METAGRAPH_SECTION_NODES] = "NODES",
+    [METAGRAPH_SECTION_EDGES] = "EDGES",
+    [METAGRAPH_SECTION_STORE] = "STORE",
+    [METAGRAPH_SECTION_INDEX] = "INDEX",
+    [METAGRAPH_SECTION_METADATA] = "METADATA",
+    [METAGRAPH_SECTION_INTEGRITY] = "INTEGRITY",
+    [METAGRAPH_SECTION_LOOKUP] = "LOOKUP",
+    [METAGRAPH_SECTION_DELTA] = "DELTA",
+};
+
+// ============================================================================
+// Helpers
+// ============================================================================
 
-// Function with local buffer to trigger stack protection
-static void metagraph_process_input(const char *input) {
-    char buffer[64]; // Stack buffer that should trigger protection
-    if (input) {
-        strncpy(buffer, input, sizeof(buffer) - 1);
-        buffer[sizeof(buffer) - 1] = '\0';
-        (void)printf("Processing: %s\n", buffer);
+static uint64_t metagraph_cli_now_ns(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// splitmix64, as in the benchmark tool
+static uint64_t metagraph_cli_next_random(uint64_t *state) {
+    uint64_t value = (*state += 0x9E3779B97F4A7C15ULL);
+    value = (value ^ (value >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27U)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31U);
+}
+
+static const char *metagraph_cli_section_name(uint32_t type) {
+    if (type < METAGRAPH_SECTION_TYPE_COUNT &&
+        metagraph_cli_section_names[type]) {
+        return metagraph_cli_section_names[type];
     }
+    return "UNKNOWN";
 }
 
-int main(int argc, char *argv[]) {
-    (void)printf("MetaGraph CLI - placeholder implementation\n");
+// Print the error context of a failed call
+static void metagraph_cli_report(const char *what, metagraph_result_t result) {
+    (void)fflush(stdout);
+    metagraph_error_context_t context;
+    if (metagraph_result_is_success(metagraph_get_error_context(&context)) &&
+        context.code == result && context.message[0] != '\0') {
+        (void)fprintf(stderr, "mg-cli: %s: %s\n", what, context.message);
+        return;
+    }
+    (void)fprintf(stderr, "mg-cli: %s: %s\n", what,
+                  metagraph_result_to_string(result));
+}
 
-    // Use argc/argv to ensure they're not optimized away
-    if (argc > 1) {
-        metagraph_process_input(argv[1]);
+static int metagraph_cli_parse_number(const char *text, uint64_t *value) {
+    if (!text || *text < '0' || *text > '9') {
+        return 0;
+    }
+    char *end = NULL;
+    errno = 0;
+    unsigned long long parsed = strtoull(text, &end, 0);
+    if (errno != 0 || *end != '\0') {
+        return 0;
     }
+    *value = parsed;
+    return 1;
+}
+
+// Value of a hex digit, or 16 for anything else
+static unsigned metagraph_cli_hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return (unsigned)(c - '0');
+    }
+    if (c >= 'a' && c <= 'f') {
+        return (unsigned)(c - 'a') + 10U;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return (unsigned)(c - 'A') + 10U;
+    }
+    return 16U;
+}
+
+// Decode exactly size bytes of hex; returns 0 on malformed input
+static int metagraph_cli_parse_hex(const char *text, size_t length,
+                                   uint8_t *out, size_t size) {
+    if (length != size * 2U) {
+        return 0;
+    }
+    for (size_t i = 0; i < size; i++) {
+        const unsigned high = metagraph_cli_hex_digit(text[2U * i]);
+        const unsigned low = metagraph_cli_hex_digit(text[2U * i + 1U]);
+        if (high > 15U || low > 15U) {
+            return 0;
+        }
+        out[i] = (uint8_t)(high << 4U | low);
+    }
+    return 1;
+}
+
+// IDs print as 32 hex digits, high half first; "high:low" is also accepted
+static int metagraph_cli_parse_id(const char *text, metagraph_id_t *out_id) {
+    uint8_t bytes[16];
+    const char *colon = strchr(text, ':');
+    if (colon) {
+        const size_t high_length = (size_t)(colon - text);
+        const size_t low_length = strlen(colon + 1);
+        if (high_length == 0 || high_length > 16U || low_length == 0 ||
+            low_length > 16U) {
+            return 0;
+        }
+        char padded[METAGRAPH_CLI_ID_CHARS + 1U];
+        memset(padded, '0', METAGRAPH_CLI_ID_CHARS);
+        padded[METAGRAPH_CLI_ID_CHARS] = '\0';
+        memcpy(padded + 16U - high_length, text, high_length);
+        memcpy(padded + METAGRAPH_CLI_ID_CHARS - low_length, colon + 1,
+               low_length);
+        if (!metagraph_cli_parse_hex(padded, METAGRAPH_CLI_ID_CHARS, bytes,
+                                     sizeof(bytes))) {
+            return 0;
+        }
+    } else if (!metagraph_cli_parse_hex(text, strlen(text), bytes,
+                                        sizeof(bytes))) {
+        return 0;
+    }
+    uint64_t high = 0;
+    uint64_t low = 0;
+    for (size_t i = 0; i < 8U; i++) {
+        high = high << 8U | bytes[i];
+        low = low << 8U | bytes[8U + i];
+    }
+    *out_id = (metagraph_id_t){.high = high, .low = low};
+    return 1;
+}
 
-    // Create another stack buffer
-    char local_buffer[128];
-    snprintf(local_buffer, sizeof(local_buffer), "Version: %s", "0.1.0");
-    (void)printf("%s\n", local_buffer);
+static void metagraph_cli_print_node(const metagraph_bundle_t *bundle,
+                                     metagraph_node_index_t node,
+                                     const char *prefix) {
+    metagraph_node_metadata_t metadata;
+    if (!metagraph_result_is_success(
+            metagraph_bundle_get_node(bundle, node, &metadata))) {
+        (void)printf("%s#%u <unreadable>\n", prefix, (unsigned)node);
+        return;
+    }
+    (void)printf("%s%016llx%016llx  #%-8u type %-6u %12zu  %s\n", prefix,
+                 (unsigned long long)metadata.id.high,
+                 (unsigned long long)metadata.id.low, (unsigned)node,
+                 (unsigned)metadata.type, metadata.data_size,
+                 metadata.name ? metadata.name : "-");
+}
 
-    return 0;
+// Open the bundle and, with --base, apply it as a delta to the base
+static metagraph_result_t
+metagraph_cli_open(const metagraph_cli_options_t *options,
+                   const metagraph_bundle_options_t *open_options,
+                   metagraph_bundle_t **out_bundle) {
+    metagraph_bundle_t *bundle = NULL;
+    metagraph_bundle_t *base = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_create_from_file(options->bundle_path,
+                                                      open_options, &bundle));
+    if (options->base) {
+        metagraph_result_t result = metagraph_bundle_create_from_file(
+            options->base, open_options, &base);
+        if (metagraph_result_is_success(result)) {
+            result = metagraph_bundle_apply_delta(bundle, base);
+        }
+        if (metagraph_result_is_error(result)) {
+            (void)metagraph_bundle_destroy(base);
+            (void)metagraph_bundle_destroy(bundle);
+            return result;
+        }
+    }
+    *out_bundle = bundle;
+    return METAGRAPH_OK();
+}
+
+// Resolve a node given as an ID, as #index or by name (normalized as a
+// path when the bundle indexes names)
+static metagraph_result_t
+metagraph_cli_resolve_node(const metagraph_bundle_t *bundle, const char *text,
+                           metagraph_node_index_t *out_node) {
+    size_t node_count = 0;
+    METAGRAPH_CHECK(metagraph_bundle_node_count(bundle, &node_count));
+    if (text[0] == '#') {
+        uint64_t index = 0;
+        if (!metagraph_cli_parse_number(text + 1, &index) ||
+            index >= node_count) {
+            return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                                 "No node at index %s", text + 1);
+        }
+        *out_node = (metagraph_node_index_t)index;
+        return METAGRAPH_OK();
+    }
+    metagraph_id_t id;
+    if (metagraph_cli_parse_id(text, &id)) {
+        return metagraph_bundle_find_node(bundle, id, out_node);
+    }
+    const metagraph_result_t by_path =
+        metagraph_bundle_find_node_by_path(bundle, text, out_node);
+    if (by_path != METAGRAPH_ERROR_FEATURE_NOT_AVAILABLE) {
+        return by_path;
+    }
+    // Older bundles do not index names; scan the mapped node records.
+    for (size_t i = 0; i < node_count; i++) {
+        metagraph_node_metadata_t metadata;
+        METAGRAPH_CHECK(metagraph_bundle_get_node(
+            bundle, (metagraph_node_index_t)i, &metadata));
+        if (metadata.name && strcmp(metadata.name, text) == 0) {
+            *out_node = (metagraph_node_index_t)i;
+            return METAGRAPH_OK();
+        }
+    }
+    return METAGRAPH_ERR(METAGRAPH_ERROR_NODE_NOT_FOUND,
+                         "No node with ID or name '%s'", text);
+}
+
+// ============================================================================
+// stat
+// ============================================================================
+
+static metagraph_result_t
+metagraph_cli_stat(const metagraph_cli_options_t *options) {
+    const uint64_t start = metagraph_cli_now_ns();
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_CHECK(metagraph_cli_open(options, NULL, &bundle));
+    const uint64_t opened = metagraph_cli_now_ns();
+
+    const metagraph_bundle_header_t *header = metagraph_bundle_get_header(bundle);
+    const metagraph_memory_map_t *map = metagraph_bundle_get_map(bundle);
+    // The table was validated when the bundle was opened.
+    const metagraph_section_header_t *sections =
+        (const metagraph_section_header_t *)(const void *)(
+            (const uint8_t *)map->base_address + header->section_table_offset);
+
+    uint64_t node_count = 0;
+    uint64_t edge_count = 0;
+    for (uint32_t i = 0; i < header->section_count; i++) {
+        if (sections[i].type == METAGRAPH_SECTION_NODES) {
+            node_count = sections[i].item_count;
+        } else if (sections[i].type == METAGRAPH_SECTION_EDGES) {
+            edge_count = sections[i].item_count;
+        }
+    }
+
+    metagraph_blake3_hash_t integrity;
+    memcpy(integrity.bytes, header->integrity_hash, sizeof(integrity.bytes));
+    static const uint8_t zero_hash[METAGRAPH_BLAKE3_OUT_LEN] = {0};
+    char integrity_hex[METAGRAPH_BLAKE3_HEX_SIZE];
+    if (memcmp(integrity.bytes, zero_hash, sizeof(zero_hash)) == 0) {
+        memcpy(integrity_hex, "not recorded", sizeof("not recorded"));
+    } else {
+        (void)metagraph_blake3_hash_to_string(&integrity, integrity_hex,
+                                              sizeof(integrity_hex));
+    }
+
+    (void)printf("Bundle:       %s\n", options->bundle_path);
+    (void)printf("Size:         %llu bytes\n",
+                 (unsigned long long)header->total_size);
+    (void)printf("Format:       version %u, written by API %u.%u\n",
+                 (unsigned)header->format_version,
+                 (unsigned)(header->api_version >> 16U),
+                 (unsigned)(header->api_version & 0xFFFFU));
+    (void)printf("Bundle ID:    %llu\n", (unsigned long long)header->bundle_id);
+    (void)printf("Created:      %llu\n",
+                 (unsigned long long)header->creation_time);
+    (void)printf("Flags:        0x%08x\n", (unsigned)header->flags);
+    (void)printf("Integrity:    %s\n", integrity_hex);
+    if (header->flags & METAGRAPH_BUNDLE_FLAG_DELTA) {
+        (void)printf("Delta of:     bundle %u%s\n",
+                     (unsigned)header->delta_base_id,
+                     options->base ? " (applied)" : "");
+    }
+    (void)printf("Nodes:        %llu\n", (unsigned long long)node_count);
+    (void)printf("Edges:        %llu\n", (unsigned long long)edge_count);
+
+    metagraph_bundle_metadata_t metadata;
+    if (metagraph_result_is_success(
+            metagraph_bundle_get_metadata(bundle, &metadata))) {
+        (void)printf("Creator:      %s\n", metadata.creator);
+        (void)printf("Description:  %s\n", metadata.description);
+        (void)printf("Platform:     %u\n", (unsigned)metadata.target_platform);
+        (void)printf("Compression:  %s\n",
+                     metadata.compression_type == METAGRAPH_COMPRESSION_LZ
+                         ? "lz (block-compressed STORE)"
+                         : "none");
+    }
+
+    (void)printf("\n  %-10s %14s %14s %10s  %s\n", "SECTION", "OFFSET", "SIZE",
+                 "ITEMS", "CHECKSUM");
+    for (uint32_t i = 0; i < header->section_count; i++) {
+        (void)printf("  %-10s %14llu %14llu %10u  %016llx\n",
+                     metagraph_cli_section_name(sections[i].type),
+                     (unsigned long long)sections[i].offset,
+                     (unsigned long long)sections[i].size,
+                     (unsigned)sections[i].item_count,
+                     (unsigned long long)sections[i].checksum);
+    }
+    (void)printf("\nOpened in %.3f ms\n",
+                 (double)(opened - start) / METAGRAPH_CLI_NS_PER_MS);
+    return metagraph_bundle_destroy(bundle);
+}
+
+// ============================================================================
+// ls
+// ============================================================================
+
+static metagraph_result_t
+metagraph_cli_ls(const metagraph_cli_options_t *options) {
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_CHECK(metagraph_cli_open(options, NULL, &bundle));
+
+    size_t node_count = 0;
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_node_count(bundle, &node_count),
+                         cleanup);
+    uint64_t printed = 0;
+    for (size_t i = 0; i < node_count; i++) {
+        if (options->limit && printed == options->limit) {
+            break;
+        }
+        metagraph_node_metadata_t metadata;
+        METAGRAPH_CHECK_GOTO(metagraph_bundle_get_node(
+                                 bundle, (metagraph_node_index_t)i, &metadata),
+                             cleanup);
+        if (options->has_type && metadata.type != options->type) {
+            continue;
+        }
+        metagraph_cli_print_node(bundle, (metagraph_node_index_t)i, "");
+        printed++;
+    }
+
+cleanup:
+    (void)metagraph_bundle_destroy(bundle);
+    return result;
+}
+
+// ============================================================================
+// deps
+// ============================================================================
+
+// Append the nodes one hop from node to queue, skipping visited ones
+static metagraph_result_t
+metagraph_cli_expand(const metagraph_bundle_t *bundle,
+                     metagraph_node_index_t node, bool reverse,
+                     uint64_t *visited, metagraph_node_index_t *queue,
+                     size_t *queue_tail) {
+    const metagraph_edge_index_t *edges = NULL;
+    size_t edge_count = 0;
+    if (reverse) {
+        METAGRAPH_CHECK(metagraph_bundle_get_incoming_edges(bundle, node, &edges,
+                                                            &edge_count));
+    } else {
+        METAGRAPH_CHECK(metagraph_bundle_get_outgoing_edges(bundle, node, &edges,
+                                                            &edge_count));
+    }
+    for (size_t e = 0; e < edge_count; e++) {
+        const metagraph_node_index_t *members = NULL;
+        size_t member_count = 0;
+        METAGRAPH_CHECK(metagraph_bundle_get_edge_nodes(bundle, edges[e],
+                                                        &members, &member_count));
+        // Members are source first; dependents are sources, dependencies
+        // are targets.
+        const size_t first = reverse ? 0U : 1U;
+        const size_t last = reverse ? 1U : member_count;
+        for (size_t m = first; m < last && m < member_count; m++) {
+            const metagraph_node_index_t next = members[m];
+            const uint64_t bit = 1ULL << (next % 64U);
+            if (visited[next / 64U] & bit) {
+                continue;
+            }
+            visited[next / 64U] |= bit;
+            queue[(*queue_tail)++] = next;
+        }
+    }
+    return METAGRAPH_OK();
+}
+
+static metagraph_result_t
+metagraph_cli_deps(const metagraph_cli_options_t *options) {
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_bundle_t *bundle = NULL;
+    uint64_t *visited = NULL;
+    metagraph_node_index_t *queue = NULL;
+    METAGRAPH_CHECK(metagraph_cli_open(options, NULL, &bundle));
+
+    metagraph_node_index_t start = 0;
+    size_t node_count = 0;
+    METAGRAPH_CHECK_GOTO(
+        metagraph_cli_resolve_node(bundle, options->node, &start), cleanup);
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_node_count(bundle, &node_count),
+                         cleanup);
+    metagraph_cli_print_node(bundle, start, "");
+
+    // One visited bit per node; the queue holds each node at most once.
+    visited = calloc((node_count + 63U) / 64U, sizeof(*visited));
+    queue = malloc(node_count * sizeof(*queue));
+    if (!visited || !queue) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Traversal state for %zu nodes", node_count);
+        goto cleanup;
+    }
+    visited[start / 64U] |= 1ULL << (start % 64U);
+
+    size_t head = 0;
+    size_t tail = 0;
+    METAGRAPH_CHECK_GOTO(metagraph_cli_expand(bundle, start, options->reverse,
+                                              visited, queue, &tail),
+                         cleanup);
+    uint64_t depth = 1;
+    while (head < tail) {
+        const size_t level_end = tail;
+        char prefix[32];
+        (void)snprintf(prefix, sizeof(prefix), "  %-3llu ",
+                       (unsigned long long)depth);
+        for (; head < level_end; head++) {
+            metagraph_cli_print_node(bundle, queue[head], prefix);
+            if (options->transitive &&
+                (options->depth == 0 || depth < options->depth)) {
+                METAGRAPH_CHECK_GOTO(
+                    metagraph_cli_expand(bundle, queue[head], options->reverse,
+                                         visited, queue, &tail),
+                    cleanup);
+            }
+        }
+        depth++;
+    }
+    (void)printf("%zu %s\n", tail,
+                 options->reverse ? "dependents" : "dependencies");
+
+cleanup:
+    free(queue);
+    free(visited);
+    (void)metagraph_bundle_destroy(bundle);
+    return result;
+}
+
+// ============================================================================
+// verify
+// ============================================================================
+
+static metagraph_result_t
+metagraph_cli_verify(const metagraph_cli_options_t *options) {
+    metagraph_blake3_hash_t expected;
+    if (options->hash &&
+        !metagraph_cli_parse_hex(options->hash, strlen(options->hash),
+                                 expected.bytes, sizeof(expected.bytes))) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "--hash needs %u hex digits",
+                             2U * METAGRAPH_BLAKE3_OUT_LEN);
+    }
+
+    metagraph_bundle_t *bundle = NULL;
+    METAGRAPH_CHECK(metagraph_cli_open(options, NULL, &bundle));
+    const metagraph_bundle_header_t *header = metagraph_bundle_get_header(bundle);
+
+    // Every section's leaves are hashed on all CPUs.
+    const uint64_t start = metagraph_cli_now_ns();
+    const metagraph_result_t result = metagraph_bundle_verify_integrity(
+        bundle, options->hash ? &expected : NULL);
+    const uint64_t finished = metagraph_cli_now_ns();
+    // Missing integrity data or a pinned hash that differs: there is no
+    // per-section report to give.
+    if (result != METAGRAPH_SUCCESS &&
+        (result != METAGRAPH_ERROR_CHECKSUM_MISMATCH ||
+         (options->hash && memcmp(expected.bytes, header->integrity_hash,
+                                  sizeof(expected.bytes)) != 0))) {
+        (void)metagraph_bundle_destroy(bundle);
+        return result;
+    }
+
+    // Leaves already verified are not hashed again, so this is free when
+    // the whole bundle passed and only rehashes what is left otherwise.
+    const metagraph_memory_map_t *map = metagraph_bundle_get_map(bundle);
+    const metagraph_section_header_t *sections =
+        (const metagraph_section_header_t *)(const void *)(
+            (const uint8_t *)map->base_address + header->section_table_offset);
+    uint64_t hashed_bytes = 0;
+    for (uint32_t i = 0; i < header->section_count; i++) {
+        if (sections[i].type == METAGRAPH_SECTION_INTEGRITY) {
+            continue;
+        }
+        const metagraph_result_t section_result = metagraph_bundle_verify_range(
+            bundle, (metagraph_section_type_t)sections[i].type, 0,
+            sections[i].size);
+        (void)printf("  %-10s %14llu bytes  %s\n",
+                     metagraph_cli_section_name(sections[i].type),
+                     (unsigned long long)sections[i].size,
+                     metagraph_result_is_success(section_result) ? "ok"
+                                                                 : "CORRUPT");
+        hashed_bytes += sections[i].size;
+    }
+
+    const double seconds =
+        (double)(finished - start) / (METAGRAPH_CLI_NS_PER_MS * 1000.0);
+    (void)printf("%s: %llu bytes in %.3f ms (%.2f GB/s)\n",
+                 metagraph_result_is_success(result) ? "OK" : "FAILED",
+                 (unsigned long long)hashed_bytes, seconds * 1000.0,
+                 seconds > 0.0 ? (double)hashed_bytes / seconds /
+                                     METAGRAPH_CLI_BYTES_PER_GB
+                               : 0.0);
+    (void)metagraph_bundle_destroy(bundle);
+    return result;
+}
+
+// ============================================================================
+// bench
+// ============================================================================
+
+static int metagraph_cli_compare_doubles(const void *left, const void *right) {
+    const double a = *(const double *)left;
+    const double b = *(const double *)right;
+    return (a > b) - (a < b);
+}
+
+// Sorts samples and prints nearest-rank p50/p99 and the mean
+static void metagraph_cli_print_latency(const char *name, double *samples,
+                                        size_t count, const char *unit) {
+    if (count == 0) {
+        return;
+    }
+    qsort(samples, count, sizeof(*samples), metagraph_cli_compare_doubles);
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    const size_t p50 = (count - 1U) / 2U;
+    const size_t p99 = (count * 99U + 99U) / 100U - 1U;
+    (void)printf("  %-20s p50 %10.3f %s  p99 %10.3f %s  mean %10.3f %s\n", name,
+                 samples[p50], unit, samples[p99], unit,
+                 sum / (double)count, unit);
+}
+
+// Time batches of lookups against the mapped index and records
+static metagraph_result_t
+metagraph_cli_bench_queries(const metagraph_bundle_t *bundle,
+                            const metagraph_cli_options_t *options,
+                            size_t node_count) {
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    const size_t batches = (size_t)((options->lookups + METAGRAPH_CLI_BATCH -
+                                     1U) / METAGRAPH_CLI_BATCH);
+    const size_t lookups = batches * METAGRAPH_CLI_BATCH;
+    metagraph_id_t *ids = malloc(lookups * sizeof(*ids));
+    metagraph_node_index_t *found = malloc(lookups * sizeof(*found));
+    double *samples[3] = {malloc(batches * sizeof(double)),
+                          malloc(batches * sizeof(double)),
+                          malloc(batches * sizeof(double))};
+    if (!ids || !found || !samples[0] || !samples[1] || !samples[2]) {
+        result = METAGRAPH_ERR(METAGRAPH_ERROR_OUT_OF_MEMORY,
+                               "Benchmark state for %zu lookups", lookups);
+        goto cleanup;
+    }
+
+    uint64_t random_state = options->seed;
+    for (size_t i = 0; i < lookups; i++) {
+        const metagraph_node_index_t node = (metagraph_node_index_t)(
+            metagraph_cli_next_random(&random_state) % node_count);
+        metagraph_node_metadata_t metadata;
+        METAGRAPH_CHECK_GOTO(metagraph_bundle_get_node(bundle, node, &metadata),
+                             cleanup);
+        ids[i] = metadata.id;
+    }
+
+    uint64_t checksum = 0;
+    for (size_t b = 0; b < batches; b++) {
+        const size_t first = b * METAGRAPH_CLI_BATCH;
+        const uint64_t t0 = metagraph_cli_now_ns();
+        for (size_t i = first; i < first + METAGRAPH_CLI_BATCH; i++) {
+            METAGRAPH_CHECK_GOTO(
+                metagraph_bundle_find_node(bundle, ids[i], &found[i]), cleanup);
+        }
+        const uint64_t t1 = metagraph_cli_now_ns();
+        for (size_t i = first; i < first + METAGRAPH_CLI_BATCH; i++) {
+            metagraph_node_metadata_t metadata;
+            METAGRAPH_CHECK_GOTO(
+                metagraph_bundle_get_node(bundle, found[i], &metadata), cleanup);
+            checksum += metadata.data_size;
+        }
+        const uint64_t t2 = metagraph_cli_now_ns();
+        for (size_t i = first; i < first + METAGRAPH_CLI_BATCH; i++) {
+            const metagraph_edge_index_t *edges = NULL;
+            size_t edge_count = 0;
+            METAGRAPH_CHECK_GOTO(metagraph_bundle_get_outgoing_edges(
+                                     bundle, found[i], &edges, &edge_count),
+                                 cleanup);
+            checksum += edge_count;
+        }
+        const uint64_t t3 = metagraph_cli_now_ns();
+        samples[0][b] = (double)(t1 - t0) / METAGRAPH_CLI_BATCH;
+        samples[1][b] = (double)(t2 - t1) / METAGRAPH_CLI_BATCH;
+        samples[2][b] = (double)(t3 - t2) / METAGRAPH_CLI_BATCH;
+    }
+
+    metagraph_cli_print_latency("find_node", samples[0], batches, "ns");
+    metagraph_cli_print_latency("get_node", samples[1], batches, "ns");
+    metagraph_cli_print_latency("outgoing_edges", samples[2], batches, "ns");
+    (void)printf("  (%zu lookups, checksum %llu)\n", lookups,
+                 (unsigned long long)checksum);
+
+cleanup:
+    free(samples[2]);
+    free(samples[1]);
+    free(samples[0]);
+    free(found);
+    free(ids);
+    return result;
+}
+
+static metagraph_result_t
+metagraph_cli_bench(const metagraph_cli_options_t *options) {
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    const size_t iterations = (size_t)options->iterations;
+    double *open_ms = malloc(iterations * sizeof(double));
+    METAGRAPH_CHECK_ALLOC(open_ms);
+
+    // Open to first lookup: map, validate the header and table, hydrate
+    // the index and node records.
+    metagraph_bundle_t *bundle = NULL;
+    size_t node_count = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        const uint64_t start = metagraph_cli_now_ns();
+        METAGRAPH_CHECK_GOTO(metagraph_cli_open(options, NULL, &bundle),
+                             cleanup);
+        metagraph_node_index_t ignored = 0;
+        METAGRAPH_CHECK_GOTO(metagraph_bundle_node_count(bundle, &node_count),
+                             cleanup);
+        (void)metagraph_bundle_find_node(bundle, (metagraph_id_t){0}, &ignored);
+        open_ms[i] =
+            (double)(metagraph_cli_now_ns() - start) / METAGRAPH_CLI_NS_PER_MS;
+        if (i + 1U < iterations) {
+            (void)metagraph_bundle_destroy(bundle);
+            bundle = NULL;
+        }
+    }
+
+    (void)printf("Bundle %s: %zu nodes\n", options->bundle_path, node_count);
+    metagraph_cli_print_latency("open", open_ms, iterations, "ms");
+    if (node_count > 0) {
+        METAGRAPH_CHECK_GOTO(
+            metagraph_cli_bench_queries(bundle, options, node_count), cleanup);
+    }
+
+cleanup:
+    (void)metagraph_bundle_destroy(bundle);
+    free(open_ms);
+    return result;
+}
+
+// ============================================================================
+// delta
+// ============================================================================
+
+static metagraph_result_t
+metagraph_cli_delta(const metagraph_cli_options_t *options) {
+    if (!options->base || !options->output) {
+        return METAGRAPH_ERR(METAGRAPH_ERROR_INVALID_ARGUMENT,
+                             "delta needs --base and --output");
+    }
+    metagraph_result_t result = METAGRAPH_SUCCESS;
+    metagraph_bundle_t *base = NULL;
+    metagraph_bundle_t *target = NULL;
+    metagraph_bundle_t *delta = NULL;
+    METAGRAPH_CHECK(metagraph_bundle_create_from_file(options->base, NULL,
+                                                      &base));
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_create_from_file(options->bundle_path,
+                                                           NULL, &target),
+                         cleanup);
+    const uint64_t start = metagraph_cli_now_ns();
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_write_delta(base, target, options->output, NULL),
+        cleanup);
+    const uint64_t written = metagraph_cli_now_ns();
+
+    METAGRAPH_CHECK_GOTO(
+        metagraph_bundle_create_from_file(options->output, NULL, &delta),
+        cleanup);
+    const void *data = NULL;
+    size_t size = 0;
+    METAGRAPH_CHECK_GOTO(metagraph_bundle_get_section(
+                             delta, METAGRAPH_SECTION_DELTA, &data, &size),
+                         cleanup);
+    metagraph_bundle_delta_header_t header;
+    memcpy(&header, data, sizeof(header));
+    (void)printf("Delta:        %s\n", options->output);
+    (void)printf("Size:         %llu of %llu bytes\n",
+                 (unsigned long long)metagraph_bundle_get_header(delta)
+                     ->total_size,
+                 (unsigned long long)metagraph_bundle_get_header(target)
+                     ->total_size);
+    (void)printf("Nodes:        %llu -> %llu, %llu records patched\n",
+                 (unsigned long long)header.base_node_count,
+                 (unsigned long long)header.node_count,
+                 (unsigned long long)header.patch_count);
+    (void)printf("Inherited:   ");
+    for (uint32_t type = 0; type < METAGRAPH_SECTION_TYPE_COUNT; type++) {
+        if (header.inherited_sections & (1U << type)) {
+            (void)printf(" %s", metagraph_cli_section_name(type));
+        }
+    }
+    (void)printf("%s\n", header.inherited_sections ? "" : " none");
+    (void)printf("\nWritten in %.3f ms\n",
+                 (double)(written - start) / METAGRAPH_CLI_NS_PER_MS);
+
+cleanup:
+    (void)metagraph_bundle_destroy(delta);
+    (void)metagraph_bundle_destroy(target);
+    (void)metagraph_bundle_destroy(base);
+    return result;
+}
+
+// ============================================================================
+// Command line
+// ============================================================================
+
+static void metagraph_cli_print_usage(const char *program) {
+    (void)fprintf(
+        stderr,
+        "Usage: %s <command> [options] <bundle>\n"
+        "\n"
+        "Commands:\n"
+        "  stat <bundle>             Header, sections and metadata\n"
+        "  ls <bundle>               List nodes\n"
+        "      --type N              Only nodes of asset type N\n"
+        "      --limit N             Stop after N nodes\n"
+        "  deps <bundle> <node>      Direct dependencies of a node\n"
+        "      --reverse             List dependents instead\n"
+        "      --transitive          Follow dependencies recursively\n"
+        "      --depth N             Transitive depth limit\n"
+        "  verify <bundle>           Check every section's Merkle tree\n"
+        "      --hash HEX            Pin the bundle's integrity hash\n"
+        "  bench <bundle>            Time opening and mapped queries\n"
+        "      --lookups N           Timed lookups (default %u)\n"
+        "      --iterations N        Timed opens (default %u)\n"
+        "      --seed N              Lookup order seed\n"
+        "  delta <bundle>            Write a delta from --base to the bundle\n"
+        "      --output PATH         Delta bundle to write\n"
+        "  version                   Print the library version\n"
+        "\n"
+        "Reading commands take --base PATH to apply the bundle as a delta.\n"
+        "A <node> is a 32-digit hex ID, HIGH:LOW in hex, #INDEX or a name.\n",
+        program, METAGRAPH_CLI_DEFAULT_LOOKUPS,
+        METAGRAPH_CLI_DEFAULT_ITERATIONS);
+}
+
+// Parse the arguments after the command name; returns 0 on bad usage
+static int metagraph_cli_parse_args(int argc, char *argv[], bool wants_node,
+                                    metagraph_cli_options_t *options) {
+    *options = (metagraph_cli_options_t){
+        .lookups = METAGRAPH_CLI_DEFAULT_LOOKUPS,
+        .iterations = METAGRAPH_CLI_DEFAULT_ITERATIONS,
+        .seed = METAGRAPH_CLI_DEFAULT_SEED,
+    };
+
+    static const struct {
+        const char *flag;
+        size_t offset;
+        bool positive;
+    } numbers[] = {
+        {"--limit", offsetof(metagraph_cli_options_t, limit), true},
+        {"--type", offsetof(metagraph_cli_options_t, type), false},
+        {"--depth", offsetof(metagraph_cli_options_t, depth), true},
+        {"--lookups", offsetof(metagraph_cli_options_t, lookups), true},
+        {"--iterations", offsetof(metagraph_cli_options_t, iterations), true},
+        {"--seed", offsetof(metagraph_cli_options_t, seed), false},
+    };
+
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--reverse") == 0) {
+            options->reverse = true;
+            continue;
+        }
+        if (strcmp(arg, "--transitive") == 0) {
+            options->transitive = true;
+            continue;
+        }
+        if (next && strcmp(arg, "--hash") == 0) {
+            options->hash = next;
+            i++;
+            continue;
+        }
+        if (next && strcmp(arg, "--base") == 0) {
+            options->base = next;
+            i++;
+            continue;
+        }
+        if (next && strcmp(arg, "--output") == 0) {
+            options->output = next;
+            i++;
+            continue;
+        }
+        if (strncmp(arg, "--", 2) != 0) {
+            if (!options->bundle_path) {
+                options->bundle_path = arg;
+            } else if (wants_node && !options->node) {
+                options->node = arg;
+            } else {
+                return 0;
+            }
+            continue;
+        }
+        int matched = 0;
+        for (size_t n = 0; n < sizeof(numbers) / sizeof(numbers[0]); n++) {
+            if (strcmp(arg, numbers[n].flag) != 0) {
+                continue;
+            }
+            uint64_t value = 0;
+            if (!metagraph_cli_parse_number(next, &value) ||
+                (numbers[n].positive && value == 0)) {
+                (void)fprintf(stderr, "mg-cli: %s needs a %s\n", arg,
+                              numbers[n].positive ? "positive integer"
+                                                  : "number");
+                return 0;
+            }
+            memcpy((char *)options + numbers[n].offset, &value, sizeof(value));
+            if (numbers[n].offset == offsetof(metagraph_cli_options_t, type)) {
+                options->has_type = true;
+            }
+            matched = 1;
+            i++;
+            break;
+        }
+        if (!matched) {
+            (void)fprintf(stderr, "mg-cli: unknown option %s\n", arg);
+            return 0;
+        }
+    }
+    if (options->depth) {
+        options->transitive = true;
+    }
+    return options->bundle_path && (!wants_node || options->node);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct {
+        const char *name;
+        metagraph_cli_command_fn run;
+        bool wants_node;
+    } commands[] = {
+        {"stat", metagraph_cli_stat, false},
+        {"ls", metagraph_cli_ls, false},
+        {"deps", metagraph_cli_deps, true},
+        {"verify", metagraph_cli_verify, false},
+        {"bench", metagraph_cli_bench, false},
+        {"delta", metagraph_cli_delta, false},
+    };
+
+    if (argc < 2) {
+        metagraph_cli_print_usage(argv[0]);
+        return 2;
+    }
+    if (strcmp(argv[1], "version") == 0 || strcmp(argv[1], "--version") == 0) {
+        (void)printf("mg-cli %s (bundle format %d)\n",
+                     metagraph_version_string(),
+                     metagraph_bundle_format_version());
+        return 0;
+    }
+    for (size_t c = 0; c < sizeof(commands) / sizeof(commands[0]); c++) {
+        if (strcmp(argv[1], commands[c].name) != 0) {
+            continue;
+        }
+        metagraph_cli_options_t options;
+        if (!metagraph_cli_parse_args(argc - 2, argv + 2, commands[c].wants_node,
+                                      &options)) {
+            metagraph_cli_print_usage(argv[0]);
+            return 2;
+        }
+        const metagraph_result_t result = commands[c].run(&options);
+        if (!metagraph_result_is_success(result)) {
+            metagraph_cli_report(commands[c].name, result);
+            return 1;
+        }
+        return 0;
+    }
+    metagraph_cli_print_usage(argv[0]);
+    return 2;
 }